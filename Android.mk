@@ -13,10 +13,15 @@ LOCAL_MODULE := libdobby
 LOCAL_SRC_FILES := vendor/Dobby/$(TARGET_ARCH_ABI)/libdobby.a
 include $(PREBUILT_STATIC_LIBRARY)
 
+# ABIs offsets.cpp has a table for. On the others the plugin would only exit at startup, so they
+# build netbench and loadgen and no plugin
+PLUGIN_ABIS := armeabi-v7a
+
+ifneq ($(filter $(TARGET_ARCH_ABI),$(PLUGIN_ABIS)),)
 include $(CLEAR_VARS)
 
 LOCAL_STATIC_LIBRARIES := libdobby eastl
-LOCAL_LDLIBS := -llog -lEGL -lGLESv1_CM -lGLESv2 -lGLESv3
+LOCAL_LDLIBS := -llog -lz -lEGL -lGLESv1_CM -lGLESv2 -lGLESv3
 LOCAL_CPPFLAGS := -Wno-error=format-security
 LOCAL_CPPFLAGS += -std=c++17 -O3 -fvisibility=hidden
 LOCAL_MODULE := plugin
@@ -30,12 +35,126 @@ FILE_LIST += $(wildcard $(LOCAL_PATH)/plugin/*.cpp)
 FILE_LIST += $(wildcard $(LOCAL_PATH)/plugin/pools/*.cpp)
 FILE_LIST += $(wildcard $(LOCAL_PATH)/vendor/imgui/*.cpp)
 FILE_LIST += $(wildcard $(LOCAL_PATH)/vendor/imgui/backend/*.cpp)
+# Substrate patches ARM/Thumb and x86, And64InlineHook A64; hook.cpp picks whichever was built
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+FILE_LIST += $(wildcard $(LOCAL_PATH)/vendor/And64InlineHook/*.cpp)
+else
 FILE_LIST += $(wildcard $(LOCAL_PATH)/vendor/Substrate/*.cpp)
 FILE_LIST += $(wildcard $(LOCAL_PATH)/vendor/Substrate/*.c)
-FILE_LIST += $(wildcard $(LOCAL_PATH)/vendor/And64InlineHook/*.cpp)
+endif
 FILE_LIST += $(wildcard $(LOCAL_PATH)/vendor/RakNet/*.cpp)
 FILE_LIST += $(wildcard $(LOCAL_PATH)/vendor/RakNet/SAMP/*.cpp)
 
 LOCAL_SRC_FILES := $(FILE_LIST:$(LOCAL_PATH)/%=%)
 
+# Heap allocations counted per frame, region and packet id: ndk-build ALLOC_TRACKER=1
+# See plugin/alloctracker.h; the wrappers see only what is linked into this library.
+ifeq ($(ALLOC_TRACKER),1)
+LOCAL_CPPFLAGS += -DALLOC_TRACKER
+LOCAL_LDFLAGS += -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc
+endif
+
 include $(BUILD_SHARED_LIBRARY)
+endif
+
+# Translation layer benchmarks as a standalone executable: ndk-build NETBENCH=1
+# See tools/netbench/netbench.cpp for running it, and for the host build.
+ifeq ($(NETBENCH),1)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := netbench
+LOCAL_C_INCLUDES := $(LOCAL_PATH)
+LOCAL_STATIC_LIBRARIES := libdobby
+LOCAL_LDLIBS := -llog -lEGL -lGLESv3
+LOCAL_CPPFLAGS := -std=c++17 -O3 -DNETBENCH_GL
+
+NETBENCH_FILES := $(wildcard $(LOCAL_PATH)/tools/netbench/*.cpp)
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/common.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/translator.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/syncdecode.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/uisync.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/rpcarena.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/worldsnapshot.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/netcapture.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/chatbuffer.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/textdrawbuffer.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/lz4.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/deltasync.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/capabilities.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/sendclass.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/debounce.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/joinhandshake.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/tracering.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/stallwatchdog.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/arena.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/pools/vehiclequeue.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/pools/vehiclepool.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/pools/objectqueue.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/pools/playerqueue.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/pools/playernames.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/pools/playerstate.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/game/math/simd.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/scheduler.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/workers.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/threadpolicy.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/config.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/featureflags.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/offsets.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/sigscan.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/rpccompress.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/plugin/systrace.cpp
+NETBENCH_FILES += $(LOCAL_PATH)/gui/dialogbox.cpp
+NETBENCH_FILES += $(wildcard $(LOCAL_PATH)/vendor/RakNet/*.cpp)
+NETBENCH_FILES += $(wildcard $(LOCAL_PATH)/vendor/RakNet/SAMP/*.cpp)
+# overlay/* cases
+NETBENCH_FILES += $(wildcard $(LOCAL_PATH)/vendor/imgui/*.cpp)
+NETBENCH_FILES += $(wildcard $(LOCAL_PATH)/vendor/imgui/backend/*.cpp)
+# hook/* cases, device only
+NETBENCH_FILES += $(LOCAL_PATH)/hook.cpp
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+NETBENCH_FILES += $(wildcard $(LOCAL_PATH)/vendor/And64InlineHook/*.cpp)
+else
+NETBENCH_FILES += $(wildcard $(LOCAL_PATH)/vendor/Substrate/*.cpp)
+NETBENCH_FILES += $(wildcard $(LOCAL_PATH)/vendor/Substrate/*.c)
+endif
+
+LOCAL_SRC_FILES := $(NETBENCH_FILES:$(LOCAL_PATH)/%=%)
+
+include $(BUILD_EXECUTABLE)
+endif
+
+# Synthetic multi-client load for our own server: ndk-build LOADGEN=1
+# See tools/loadgen/loadgen.cpp for running it, and for the host build.
+ifeq ($(LOADGEN),1)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := loadgen
+LOCAL_C_INCLUDES := $(LOCAL_PATH)
+LOCAL_LDLIBS := -llog -ldl
+LOCAL_CPPFLAGS := -std=c++17 -O2
+
+LOADGEN_FILES := $(LOCAL_PATH)/tools/loadgen/loadgen.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/plugin/joinhandshake.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/plugin/tracering.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/plugin/translator.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/plugin/sendclass.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/plugin/arena.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/plugin/netcapture.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/plugin/rpcarena.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/plugin/rpccompress.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/plugin/capabilities.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/plugin/lz4.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/plugin/systrace.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/config.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/featureflags.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/threadpolicy.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/workers.cpp
+LOADGEN_FILES += $(LOCAL_PATH)/scheduler.cpp
+LOADGEN_FILES += $(wildcard $(LOCAL_PATH)/vendor/RakNet/*.cpp)
+LOADGEN_FILES += $(wildcard $(LOCAL_PATH)/vendor/RakNet/SAMP/*.cpp)
+
+LOCAL_SRC_FILES := $(LOADGEN_FILES:$(LOCAL_PATH)/%=%)
+
+include $(BUILD_EXECUTABLE)
+endif
@@ -1,3 +1,3 @@
 APP_STL := c++_static
-APP_ABI := armeabi-v7a
+APP_ABI := armeabi-v7a arm64-v8a x86 x86_64
 APP_PLATFORM := android-21
@@ -1,18 +1,81 @@
 #include "app.h"
 #include "plugin.h"
 
+#include "bindings.h"
+#include "config.h"
+#include "hook.h"
+#include "scheduler.h"
+#include "xorstr.h"
+#include "game/BRNotification.h"
+#include "game/chat.h"
 #include "game/rw/rw.h"
 #include "gui/gui.h"
+#include "gui/overlaysettings.h"
+#include "plugin/alloctracker.h"
+#include "plugin/audiocache.h"
+#include "plugin/chatbuffer.h"
+#include "plugin/earlyconnect.h"
+#include "plugin/httpfetch.h"
+#include "plugin/logocache.h"
+#include "plugin/netcapture.h"
+#include "plugin/netstats.h"
+#include "plugin/capabilities.h"
+#include "plugin/common.h"
+#include "plugin/startuptimeline.h"
+#include "plugin/stallwatchdog.h"
+#include "plugin/standby.h"
+#include "plugin/syncqueue.h"
+#include "plugin/systrace.h"
+#include "plugin/serverquery.h"
+#include "plugin/telemetry.h"
+#include "plugin/thermal.h"
+#include "plugin/textdrawbuffer.h"
+#include "plugin/tracering.h"
+#include "plugin/translator.h"
+#include "plugin/worldsnapshot.h"
+
+#include <android/log.h>
+
+extern RakClientInterface* pRakClient;
 
 void CApp::Initialise(eAppInit init_type)
 {
 	if(init_type == eAppInit::APP_INIT_OFFSETS)
 	{
-		COffset::Initialise();
+		CConfig::Load();
+		CSystrace::Initialise();
+		// before hack_thread installs anything, so a bypassed hook never runs its replacement
+		for(const std::string& name : CConfig::Get().hooksBypassed)
+		{
+			eHookTarget target = CHook::FromName(name.c_str());
+			if(target == HOOK_TARGET_COUNT || !CHook::CanBypass(target)) {
+				__android_log_print(ANDROID_LOG_INFO, xorstr("Hook"), xorstr("%s can't be bypassed"), name.c_str());
+				continue;
+			}
+			CHook::SetBypassed(target, true);
+		}
 	}
 	if(init_type == eAppInit::APP_INIT_RW)
 	{
+		const CConfig::stSettings& config = CConfig::Get();
+		if(config.traceRecords && !config.dataDir.empty()) {
+			char path[512], previousPath[512];
+			snprintf(path, sizeof(path), xorstr("%s/trace.bin"), config.dataDir.c_str());
+			snprintf(previousPath, sizeof(previousPath), xorstr("%s/trace-prev.bin"), config.dataDir.c_str());
+			CTraceRing::Open(path, previousPath, config.traceRecords);
+		}
+		CStallWatchdog::Start(config.stallWatchdogMs);
 		rw::Initialise();
+		bindings::Initialise();
+		CPacketTranslator::Initialise();
+		InitialiseRPCFixups(pRakClient);
+		CSyncQueue::Initialise(pRakClient);
+		CWorldSnapshot::Initialise(pRakClient);
+		CCapabilities::Initialise(pRakClient);
+		CStandby::Initialise(pRakClient);
+		CThermal::Initialise();
+		CAudioCache::Initialise();
+		COverlaySettings::Load();
 	}
 	if(init_type == eAppInit::APP_INIT_GUI)
 	{
@@ -30,9 +93,28 @@ void CApp::Render2dStuff()
 	CGUI::Render2dStuff();
 }
 
-void CApp::Process()
+void CApp::Process(JNIEnv* env)
 {
-	
+	CStartupTimeline::Mark(STARTUP_FIRST_TICK);
+	ALLOC_SCOPE(ALLOC_TICK);
+	CChat::Flush();
+	CChatBuffer::Flush();
+	CTextDrawBuffer::Flush();
+	{
+		ALLOC_SCOPE(ALLOC_NOTIFICATION);
+		BrNotificationUpdate(env);
+	}
+	CNetStats::Process();
+	CNetCapture::Process();
+	CTelemetry::Process();
+	CServerQuery::Process();
+	CThermal::Process();
+	CEarlyConnect::Process();
+	CStandby::Process();
+	CHttpFetch::Initialise(env);
+	CLogoCache::Process();
+	CAudioCache::Process();
+	CFrameScheduler::Run();
 }
 
 bool CApp::OnTouchEvent(int action, int pointer, int x, int y)
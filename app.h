@@ -1,5 +1,7 @@
 #pragma once
 
+#include <jni.h>
+
 enum eAppInit
 {
 	APP_INIT_OFFSETS,
@@ -13,7 +15,8 @@ public:
 	static void Initialise(eAppInit init_type);
 	static void Render();
 	static void Render2dStuff();
-	static void Process();
+	// once per game tick, from JNILib_step
+	static void Process(JNIEnv* env);
 	static bool OnTouchEvent(int action, int pointer, int x, int y);
 	
 };
@@ -0,0 +1,41 @@
+#include "bindings.h"
+#include "plugin.h"
+
+stGameBindings g_Game;
+
+template<typename T>
+static void Bind(T& target, uint32_t offsetHash)
+{
+	target = reinterpret_cast<T>(CGameAPI::GetBase(offsetHash));
+}
+
+// for what not every build has: null instead of the module base when the offset is missing
+template<typename T>
+static void BindOptional(T& target, uint32_t offsetHash)
+{
+	target = COffset::Get(offsetHash) ? reinterpret_cast<T>(CGameAPI::GetBase(offsetHash)) : nullptr;
+}
+
+namespace bindings
+{
+	void Initialise()
+	{
+		Bind(g_Game.StoreAimSyncData, OFFSET("CRemotePlayer::StoreAimSyncData"));
+		Bind(g_Game.StoreSyncData, OFFSET("CRemotePlayer::StoreSyncData"));
+		Bind(g_Game.StoreInCarSyncData, OFFSET("CRemotePlayer::StoreInCarSyncData"));
+		Bind(g_Game.StorePassengerSyncData, OFFSET("CRemotePlayer::StorePassengerSyncData"));
+		Bind(g_Game.StoreBulletSyncData, OFFSET("CRemotePlayer::StoreBulletSyncData"));
+
+		Bind(g_Game.Packet_ConnectionLost, OFFSET("CNetGame::Packet_ConnectionLost"));
+		Bind(g_Game.CNetVehiclePool__New, OFFSET("CNetVehiclePool::New"));
+
+		Bind(g_Game.AddDebugMessage, OFFSET("CChat::AddDebugMessage"));
+
+		Bind(g_Game.m_pRakClient, OFFSET("CNetGame::m_pRakClient"));
+		Bind(g_Game.m_iGameState, OFFSET("CNetGame::m_iGameState"));
+		Bind(g_Game.m_pPlayerPool, OFFSET("CNetGame::m_pPlayerPool"));
+		Bind(g_Game.m_pVehiclePool, OFFSET("CNetGame::m_pVehiclePool"));
+
+		BindOptional(g_Game.m_pViewMatrix, OFFSET("TheCamera::m_mViewMatrix"));
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+class CMatrix;
+class CRemotePlayer;
+class CPlayerPool;
+struct _BROnFootSyncData;
+struct BRInCarSyncData;
+
+// Game functions and globals resolved once at APP_INIT_RW, so hot paths call
+// through a typed pointer instead of looking the offset up each time.
+struct stGameBindings
+{
+	// CRemotePlayer
+	void (*StoreAimSyncData)(CRemotePlayer*, uint8_t*, uint32_t);
+	void (*StoreSyncData)(CRemotePlayer*, _BROnFootSyncData*, uint32_t);
+	void (*StoreInCarSyncData)(CRemotePlayer*, BRInCarSyncData*, uint32_t);
+	void (*StorePassengerSyncData)(CRemotePlayer*, uint8_t*, uint32_t);
+	void (*StoreBulletSyncData)(CRemotePlayer*, uint8_t*, uint32_t);
+
+	// CNetGame / pools
+	void (*Packet_ConnectionLost)();
+	void (*CNetVehiclePool__New)(uintptr_t, void*);
+
+	// CChat
+	void (*AddDebugMessage)(char*);
+
+	// CNetGame globals
+	uintptr_t* m_pRakClient;
+	int* m_iGameState;
+	CPlayerPool** m_pPlayerPool;
+	uintptr_t* m_pVehiclePool;
+
+	// CCamera, null when the build has no offset for it
+	CMatrix* m_pViewMatrix;
+};
+
+extern stGameBindings g_Game;
+
+namespace bindings
+{
+	void Initialise();
+}
@@ -0,0 +1,436 @@
+#include "config.h"
+
+#include <android/log.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "featureflags.h"
+#include "readiness.h"
+#include "workers.h"
+#include "xorstr.h"
+#include "vendor/RakNet/MTUSize.h"
+#include "vendor/nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+CConfig::stSettings CConfig::m_settings;
+std::atomic<bool> CConfig::m_bLoaded(false);
+
+void CConfig::Load()
+{
+	CWorkers::Submit(LoadFile);
+}
+
+const CConfig::stSettings& CConfig::Get()
+{
+	readiness::WaitUntil([] { return m_bLoaded.load(std::memory_order_acquire); });
+	return m_settings;
+}
+
+void CConfig::SetDefaults(stSettings* settings)
+{
+	settings->endpoints.clear();
+	settings->endpoints.push_back({ (const char*)xorstr("93.127.130.91"), 7777 });
+	settings->connectAttempts = 6;
+	settings->connectRetryMs = 1000;
+	settings->timeoutMs = 0;
+	settings->reconnectBaseMs = 2000;
+	settings->reconnectMaxMs = 60000;
+	settings->resumeWindowMs = 30000;
+	settings->joinTimeoutMs = 15000;
+	settings->capture = false;
+	settings->traceRecords = 16384;
+	settings->stallWatchdogMs = 200;
+	settings->profileHz = 500;
+	settings->socketReceiveBuffer = 256 * 1024;
+	settings->socketSendBuffer = 16 * 1024;
+	settings->mtu = DEFAULT_MTU_SIZE;
+	settings->compressAbove = 512;
+	settings->deltaSync = true;
+	settings->thermalMode = true;
+	settings->overlayCacheHz = 0;
+	settings->overlaySettings = true;
+	settings->logoCache = true;
+	settings->audioCacheKb = 2048;
+	settings->audioPrefetch.clear();
+	settings->adaptiveSyncRate = true;
+	settings->warmStandby = true;
+	settings->syncKeepaliveMs = { 500, 500, 500, 500 };
+	settings->rpcBudgetUs = 4000;
+	settings->syncInterest = { 150, 250 };
+	settings->syncJitter = { 2, 100 };
+	settings->sendClasses.priority[SEND_CLASS_GAME] = HIGH_PRIORITY;
+	settings->sendClasses.priority[SEND_CLASS_SYNC] = HIGH_PRIORITY;
+	settings->sendClasses.priority[SEND_CLASS_COMBAT] = HIGH_PRIORITY;
+	settings->sendClasses.priority[SEND_CLASS_CHAT] = LOW_PRIORITY;
+	settings->sendClasses.priority[SEND_CLASS_UI] = MEDIUM_PRIORITY;
+	settings->sendClasses.priority[SEND_CLASS_CONTROL] = HIGH_PRIORITY;
+	// sync and combat are sequenced, not ordered, so they can share with the join sequence
+	settings->sendClasses.channel[SEND_CLASS_CONTROL] = 0;
+	settings->sendClasses.channel[SEND_CLASS_SYNC] = 0;
+	settings->sendClasses.channel[SEND_CLASS_COMBAT] = 0;
+	settings->sendClasses.channel[SEND_CLASS_GAME] = 1;
+	settings->sendClasses.channel[SEND_CLASS_CHAT] = 2;
+	settings->sendClasses.channel[SEND_CLASS_UI] = 3;
+	settings->sendClasses.rpcClasses.clear();
+	settings->sendClasses.shares[0] = 70;
+	settings->sendClasses.shares[1] = 20;
+	settings->sendClasses.shares[2] = 10;
+	settings->linkEmulation = {};
+	settings->telemetry = { std::string(), 0, 60000 };
+	settings->serverQuery = { 60000, 1000, 100, 50 };
+	settings->debounce.rpcMs = 250;
+	settings->debounce.uiMs = 250;
+	settings->debounce.rpcs.clear();
+	settings->features = CFeatures::DEFAULT_MASK;
+	settings->hooksBypassed.clear();
+	for(int role = 0; role < THREAD_ROLE_COUNT; role++) {
+		settings->threads[role] = CThreadPolicy::GetDefault((eThreadRole)role);
+	}
+}
+
+static bool ReadFile(const char* path, std::string* out)
+{
+	FILE* file = fopen(path, "rb");
+	if(!file) {
+		return false;
+	}
+	char buffer[1024];
+	size_t read;
+	while((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		out->append(buffer, read);
+	}
+	fclose(file);
+	return true;
+}
+
+static bool GetPackageName(char* out, size_t size)
+{
+	// the process is named after its package, which also names the external files dir
+	FILE* file = fopen(xorstr("/proc/self/cmdline"), "rb");
+	if(!file) {
+		return false;
+	}
+	size_t read = fread(out, 1, size - 1, file);
+	fclose(file);
+	out[read] = '\0';
+	return out[0] != '\0';
+}
+
+template<typename T>
+static void ReadUnsigned(const json& object, const char* key, T* out, uint32_t min, uint32_t max)
+{
+	auto it = object.find(key);
+	if(it == object.end() || !it->is_number_unsigned()) {
+		return;
+	}
+	uint64_t value = it->get<uint64_t>();
+	if(value >= min && value <= max) {
+		*out = (T)value;
+	}
+}
+
+static const char* const g_sendClassNames[SEND_CLASS_COUNT] = { "game", "sync", "combat", "chat", "ui", "control" };
+
+// "high", "medium" or "low"
+static void ReadPriority(const json& value, uint8_t* out)
+{
+	static const char* const priorityNames[] = { "high", "medium", "low" };
+	for(int priority = 0; priority < 3; priority++)
+	{
+		if(value.is_string() && value == priorityNames[priority]) {
+			*out = (uint8_t)(HIGH_PRIORITY + priority);
+		}
+	}
+}
+
+static void ReadLinkConditions(const json& object, const char* key, LinkConditions* out)
+{
+	auto it = object.find(key);
+	if(it == object.end() || !it->is_object()) {
+		return;
+	}
+	ReadUnsigned(*it, (const char*)xorstr("lossPerMille"), &out->lossPerMille, 0, 1000);
+	ReadUnsigned(*it, (const char*)xorstr("latencyMs"), &out->latencyMS, 0, 10000);
+	ReadUnsigned(*it, (const char*)xorstr("jitterMs"), &out->jitterMS, 0, 10000);
+	ReadUnsigned(*it, (const char*)xorstr("reorderPerMille"), &out->reorderPerMille, 0, 1000);
+	ReadUnsigned(*it, (const char*)xorstr("bytesPerSecond"), &out->bytesPerSecond, 0, 100 * 1024 * 1024);
+	ReadUnsigned(*it, (const char*)xorstr("burstBytes"), &out->burstBytes, 0, 16 * 1024 * 1024);
+	ReadUnsigned(*it, (const char*)xorstr("queueBytes"), &out->queueBytes, 0, 16 * 1024 * 1024);
+	auto jitter = it->find((const char*)xorstr("jitter"));
+	if(jitter != it->end() && jitter->is_string()) {
+		static const char* const distributionNames[LINK_JITTER_DISTRIBUTION_COUNT] = { "uniform", "normal", "pareto" };
+		for(int i = 0; i < LINK_JITTER_DISTRIBUTION_COUNT; i++) {
+			if(*jitter == distributionNames[i]) {
+				out->jitterDistribution = (LinkJitterDistribution)i;
+			}
+		}
+	}
+}
+
+bool CConfig::Parse(const std::string& text, stSettings* settings)
+{
+	json root = json::parse(text, nullptr, false);
+	if(root.is_discarded() || !root.is_object()) {
+		return false;
+	}
+
+	auto endpoints = root.find((const char*)xorstr("endpoints"));
+	if(endpoints != root.end() && endpoints->is_array())
+	{
+		std::vector<stEndpoint> parsed;
+		for(const json& entry : *endpoints)
+		{
+			if(!entry.is_object()) continue;
+			auto host = entry.find((const char*)xorstr("host"));
+			auto port = entry.find((const char*)xorstr("port"));
+			if(host == entry.end() || !host->is_string() || host->get_ref<const std::string&>().empty()) continue;
+			if(port == entry.end() || !port->is_number_unsigned()) continue;
+			uint64_t value = port->get<uint64_t>();
+			if(value == 0 || value > 0xFFFF) continue;
+			parsed.push_back({ host->get<std::string>(), (uint16_t)value });
+		}
+		// an empty list would leave nothing to connect to
+		if(!parsed.empty()) {
+			settings->endpoints.swap(parsed);
+		}
+	}
+
+	ReadUnsigned(root, (const char*)xorstr("connectAttempts"), &settings->connectAttempts, 1, 255);
+	ReadUnsigned(root, (const char*)xorstr("connectRetryMs"), &settings->connectRetryMs, 100, 60000);
+	ReadUnsigned(root, (const char*)xorstr("timeoutMs"), &settings->timeoutMs, 0, 600000);
+	ReadUnsigned(root, (const char*)xorstr("reconnectBaseMs"), &settings->reconnectBaseMs, 100, 600000);
+	ReadUnsigned(root, (const char*)xorstr("reconnectMaxMs"), &settings->reconnectMaxMs, 100, 3600000);
+	ReadUnsigned(root, (const char*)xorstr("resumeWindowMs"), &settings->resumeWindowMs, 0, 600000);
+	ReadUnsigned(root, (const char*)xorstr("joinTimeoutMs"), &settings->joinTimeoutMs, 0, 600000);
+	ReadUnsigned(root, (const char*)xorstr("socketReceiveBuffer"), &settings->socketReceiveBuffer, 0, 16 * 1024 * 1024);
+	ReadUnsigned(root, (const char*)xorstr("socketSendBuffer"), &settings->socketSendBuffer, 0, 16 * 1024 * 1024);
+	ReadUnsigned(root, (const char*)xorstr("mtu"), &settings->mtu, 576, MAXIMUM_MTU_SIZE);
+	ReadUnsigned(root, (const char*)xorstr("compressAbove"), &settings->compressAbove, 0, 65535);
+	ReadUnsigned(root, (const char*)xorstr("rpcBudgetUs"), &settings->rpcBudgetUs, 0, 1000000);
+	ReadUnsigned(root, (const char*)xorstr("traceRecords"), &settings->traceRecords, 0, 1024 * 1024);
+	ReadUnsigned(root, (const char*)xorstr("stallWatchdogMs"), &settings->stallWatchdogMs, 0, 60000);
+	ReadUnsigned(root, (const char*)xorstr("profileHz"), &settings->profileHz, 10, 4000);
+	ReadUnsigned(root, (const char*)xorstr("overlayCacheHz"), &settings->overlayCacheHz, 0, 60);
+	ReadUnsigned(root, (const char*)xorstr("audioCacheKb"), &settings->audioCacheKb, 0, 16384);
+	auto capture = root.find((const char*)xorstr("capture"));
+	if(capture != root.end() && capture->is_boolean()) {
+		settings->capture = capture->get<bool>();
+	}
+	auto deltaSync = root.find((const char*)xorstr("deltaSync"));
+	if(deltaSync != root.end() && deltaSync->is_boolean()) {
+		settings->deltaSync = deltaSync->get<bool>();
+	}
+	auto thermalMode = root.find((const char*)xorstr("thermalMode"));
+	if(thermalMode != root.end() && thermalMode->is_boolean()) {
+		settings->thermalMode = thermalMode->get<bool>();
+	}
+	auto overlaySettings = root.find((const char*)xorstr("overlaySettings"));
+	if(overlaySettings != root.end() && overlaySettings->is_boolean()) {
+		settings->overlaySettings = overlaySettings->get<bool>();
+	}
+	auto logoCache = root.find((const char*)xorstr("logoCache"));
+	if(logoCache != root.end() && logoCache->is_boolean()) {
+		settings->logoCache = logoCache->get<bool>();
+	}
+	auto audioPrefetch = root.find((const char*)xorstr("audioPrefetch"));
+	if(audioPrefetch != root.end() && audioPrefetch->is_array())
+	{
+		for(const json& entry : *audioPrefetch)
+		{
+			if(!entry.is_string() || entry.get_ref<const std::string&>().empty()) continue;
+			settings->audioPrefetch.push_back(entry.get<std::string>());
+		}
+	}
+	auto adaptiveSyncRate = root.find((const char*)xorstr("adaptiveSyncRate"));
+	if(adaptiveSyncRate != root.end() && adaptiveSyncRate->is_boolean()) {
+		settings->adaptiveSyncRate = adaptiveSyncRate->get<bool>();
+	}
+	auto warmStandby = root.find((const char*)xorstr("warmStandby"));
+	if(warmStandby != root.end() && warmStandby->is_boolean()) {
+		settings->warmStandby = warmStandby->get<bool>();
+	}
+	auto features = root.find((const char*)xorstr("features"));
+	if(features != root.end() && features->is_object())
+	{
+		for(auto it = features->begin(); it != features->end(); ++it)
+		{
+			eFeature feature = CFeatures::FromName(it.key().c_str());
+			if(feature == FEATURE_COUNT || !it->is_boolean()) continue;
+			if(it->get<bool>()) {
+				settings->features |= 1u << feature;
+			} else {
+				settings->features &= ~(1u << feature);
+			}
+		}
+	}
+	auto hooksBypassed = root.find((const char*)xorstr("hooksBypassed"));
+	if(hooksBypassed != root.end() && hooksBypassed->is_array())
+	{
+		for(const json& entry : *hooksBypassed)
+		{
+			if(!entry.is_string()) continue;
+			settings->hooksBypassed.push_back(entry.get<std::string>());
+		}
+	}
+	auto keepalive = root.find((const char*)xorstr("syncKeepaliveMs"));
+	if(keepalive != root.end() && keepalive->is_object())
+	{
+		ReadUnsigned(*keepalive, (const char*)xorstr("onFoot"), &settings->syncKeepaliveMs.onFoot, 0, 10000);
+		ReadUnsigned(*keepalive, (const char*)xorstr("inCar"), &settings->syncKeepaliveMs.inCar, 0, 10000);
+		ReadUnsigned(*keepalive, (const char*)xorstr("passenger"), &settings->syncKeepaliveMs.passenger, 0, 10000);
+		ReadUnsigned(*keepalive, (const char*)xorstr("aim"), &settings->syncKeepaliveMs.aim, 0, 10000);
+	}
+	auto interest = root.find((const char*)xorstr("syncInterest"));
+	if(interest != root.end() && interest->is_object())
+	{
+		ReadUnsigned(*interest, (const char*)xorstr("nearRadius"), &settings->syncInterest.nearRadius, 0, 6000);
+		ReadUnsigned(*interest, (const char*)xorstr("farIntervalMs"), &settings->syncInterest.farIntervalMs, 0, 10000);
+	}
+	auto jitter = root.find((const char*)xorstr("syncJitter"));
+	if(jitter != root.end() && jitter->is_object())
+	{
+		ReadUnsigned(*jitter, (const char*)xorstr("depth"), &settings->syncJitter.depth, 0, 2);
+		ReadUnsigned(*jitter, (const char*)xorstr("maxDelayMs"), &settings->syncJitter.maxDelayMs, 0, 500);
+	}
+	auto classes = root.find((const char*)xorstr("sendClasses"));
+	if(classes != root.end() && classes->is_object())
+	{
+		for(int i = 0; i < SEND_CLASS_COUNT; i++)
+		{
+			auto entry = classes->find(g_sendClassNames[i]);
+			if(entry == classes->end()) continue;
+			// "low", or {"priority": "low", "channel": 2}
+			if(entry->is_object())
+			{
+				ReadUnsigned(*entry, (const char*)xorstr("channel"), &settings->sendClasses.channel[i], 0, 31);
+				auto priority = entry->find((const char*)xorstr("priority"));
+				if(priority != entry->end()) {
+					ReadPriority(*priority, &settings->sendClasses.priority[i]);
+				}
+			}
+			else ReadPriority(*entry, &settings->sendClasses.priority[i]);
+		}
+	}
+	auto rpcClasses = root.find((const char*)xorstr("rpcClasses"));
+	if(rpcClasses != root.end() && rpcClasses->is_object())
+	{
+		for(auto it = rpcClasses->begin(); it != rpcClasses->end(); ++it)
+		{
+			char* end;
+			unsigned long rpcId = strtoul(it.key().c_str(), &end, 10);
+			if(*end || it.key().empty() || rpcId > 255 || !it->is_string()) continue;
+			for(int i = 0; i < SEND_CLASS_COUNT; i++)
+			{
+				if(*it == g_sendClassNames[i]) {
+					settings->sendClasses.rpcClasses.push_back({ (uint8_t)rpcId, (uint8_t)i });
+				}
+			}
+		}
+	}
+	auto shares = root.find((const char*)xorstr("sendShares"));
+	if(shares != root.end() && shares->is_object())
+	{
+		ReadUnsigned(*shares, (const char*)xorstr("high"), &settings->sendClasses.shares[0], 0, 255);
+		ReadUnsigned(*shares, (const char*)xorstr("medium"), &settings->sendClasses.shares[1], 0, 255);
+		ReadUnsigned(*shares, (const char*)xorstr("low"), &settings->sendClasses.shares[2], 0, 255);
+	}
+	auto telemetry = root.find((const char*)xorstr("telemetry"));
+	if(telemetry != root.end() && telemetry->is_object())
+	{
+		auto host = telemetry->find((const char*)xorstr("host"));
+		if(host != telemetry->end() && host->is_string()) {
+			settings->telemetry.host = host->get<std::string>();
+		}
+		ReadUnsigned(*telemetry, (const char*)xorstr("port"), &settings->telemetry.port, 1, 0xFFFF);
+		ReadUnsigned(*telemetry, (const char*)xorstr("intervalMs"), &settings->telemetry.intervalMs, 10000, 3600000);
+	}
+	auto query = root.find((const char*)xorstr("serverQuery"));
+	if(query != root.end() && query->is_object())
+	{
+		ReadUnsigned(*query, (const char*)xorstr("intervalMs"), &settings->serverQuery.intervalMs, 0, 3600000);
+		ReadUnsigned(*query, (const char*)xorstr("timeoutMs"), &settings->serverQuery.timeoutMs, 100, 10000);
+		ReadUnsigned(*query, (const char*)xorstr("loadMs"), &settings->serverQuery.loadMs, 0, 10000);
+		ReadUnsigned(*query, (const char*)xorstr("slackMs"), &settings->serverQuery.slackMs, 0, 10000);
+	}
+	auto debounce = root.find((const char*)xorstr("debounceMs"));
+	if(debounce != root.end() && debounce->is_object())
+	{
+		ReadUnsigned(*debounce, (const char*)xorstr("rpc"), &settings->debounce.rpcMs, 0, 60000);
+		ReadUnsigned(*debounce, (const char*)xorstr("ui"), &settings->debounce.uiMs, 0, 60000);
+		for(auto it = debounce->begin(); it != debounce->end(); ++it)
+		{
+			char* end;
+			unsigned long rpcId = strtoul(it.key().c_str(), &end, 10);
+			if(*end || it.key().empty() || rpcId > 255 || !it->is_number_unsigned() || it->get<uint64_t>() > 60000) continue;
+			settings->debounce.rpcs.push_back({ (uint8_t)rpcId, (uint16_t)it->get<uint32_t>() });
+		}
+	}
+	auto link = root.find((const char*)xorstr("linkEmulation"));
+	if(link != root.end() && link->is_object())
+	{
+		ReadLinkConditions(*link, (const char*)xorstr("up"), &settings->linkEmulation.up);
+		ReadLinkConditions(*link, (const char*)xorstr("down"), &settings->linkEmulation.down);
+	}
+	auto threads = root.find((const char*)xorstr("threads"));
+	if(threads != root.end() && threads->is_object())
+	{
+		static const char* const roleNames[THREAD_ROLE_COUNT] = { "network", "workers" };
+		for(int role = 0; role < THREAD_ROLE_COUNT; role++)
+		{
+			auto entry = threads->find(roleNames[role]);
+			if(entry == threads->end() || !entry->is_object()) continue;
+			auto nice = entry->find((const char*)xorstr("nice"));
+			if(nice != entry->end() && nice->is_number_integer()) {
+				int64_t value = nice->get<int64_t>();
+				if(value >= -20 && value <= 19) {
+					settings->threads[role].nice = (int8_t)value;
+				}
+			}
+			auto cores = entry->find((const char*)xorstr("cores"));
+			if(cores != entry->end() && cores->is_string()) {
+				settings->threads[role].cores = CThreadPolicy::CoresFromName(cores->get_ref<const std::string&>().c_str());
+			}
+		}
+	}
+	if(settings->reconnectMaxMs < settings->reconnectBaseMs) {
+		settings->reconnectMaxMs = settings->reconnectBaseMs;
+	}
+	return true;
+}
+
+void CConfig::LoadFile()
+{
+	SetDefaults(&m_settings);
+
+	char package[256];
+	char path[512];
+	std::string text;
+	if(!GetPackageName(package, sizeof(package))) {
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Config"), xorstr("package name unknown, using defaults"));
+	}
+	else
+	{
+		snprintf(path, sizeof(path), xorstr("/storage/emulated/0/Android/data/%s/files"), package);
+		m_settings.dataDir = path;
+		snprintf(path, sizeof(path), xorstr("/data/data/%s/cache"), package);
+		m_settings.cacheDir = path;
+		snprintf(path, sizeof(path), xorstr("%s/brsamp.json"), m_settings.dataDir.c_str());
+		if(!ReadFile(path, &text)) {
+			__android_log_print(ANDROID_LOG_INFO, xorstr("Config"), xorstr("%s not found, using defaults"), path);
+		}
+		else if(!Parse(text, &m_settings)) {
+			SetDefaults(&m_settings);
+			__android_log_print(ANDROID_LOG_INFO, xorstr("Config"), xorstr("%s is not valid JSON, using defaults"), path);
+		}
+		else {
+			__android_log_print(ANDROID_LOG_INFO, xorstr("Config"), xorstr("loaded %s: %u endpoint(s)"), path, (unsigned)m_settings.endpoints.size());
+		}
+	}
+
+	CFeatures::SetMask(m_settings.features);
+	for(int role = 0; role < THREAD_ROLE_COUNT; role++) {
+		CThreadPolicy::Set((eThreadRole)role, m_settings.threads[role]);
+	}
+	m_bLoaded.store(true, std::memory_order_release);
+}
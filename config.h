@@ -0,0 +1,218 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "threadpolicy.h"
+#include "plugin/sendclass.h"
+#include "vendor/RakNet/LinkEmulator.h"
+
+// Plugin settings from brsamp.json in the game's external files dir, e.g.
+// {"endpoints": [{"host": "1.2.3.4", "port": 7777}], "connectAttempts": 6,
+//  "connectRetryMs": 1000, "timeoutMs": 10000, "reconnectBaseMs": 2000, "reconnectMaxMs": 60000,
+//  "resumeWindowMs": 30000, "joinTimeoutMs": 15000, "capture": false, "socketReceiveBuffer": 262144,
+//  "socketSendBuffer": 16384, "mtu": 1400, "compressAbove": 512, "traceRecords": 16384,
+//  "stallWatchdogMs": 200, "profileHz": 500,
+//  "thermalMode": true, "overlayCacheHz": 0, "overlaySettings": true, "deltaSync": true,
+//  "adaptiveSyncRate": true, "warmStandby": true, "logoCache": true, "audioCacheKb": 2048,
+//  "audioPrefetch": ["https://example.org/jingle.mp3"],
+//  "rpcBudgetUs": 4000, "syncKeepaliveMs": {"onFoot": 500, "inCar": 500},
+//  "syncInterest": {"nearRadius": 150, "farIntervalMs": 250}, "syncJitter": {"depth": 2, "maxDelayMs": 100},
+//  "sendClasses": {"sync": "high", "combat": "high", "game": {"priority": "high", "channel": 1},
+//   "chat": {"priority": "low", "channel": 2}, "ui": "medium", "control": "high"},
+//  "rpcClasses": {"101": "chat", "50": "game"},
+//  "sendShares": {"high": 70, "medium": 20, "low": 10},
+//  "telemetry": {"host": "stats.example.org", "port": 7790, "intervalMs": 60000},
+//  "serverQuery": {"intervalMs": 60000, "timeoutMs": 1000, "loadMs": 100, "slackMs": 50},
+//  "debounceMs": {"rpc": 250, "ui": 250, "83": 500},
+//  "linkEmulation": {"up": {"lossPerMille": 20, "latencyMs": 40, "jitterMs": 30, "jitter": "pareto",
+//   "reorderPerMille": 0, "bytesPerSecond": 32768, "burstBytes": 8192, "queueBytes": 65536}, "down": {}},
+//  "features": {"debugLog": false}, "hooksBypassed": ["Packet_Turnlights"],
+//  "threads": {"network": {"nice": -4, "cores": "big"}, "workers": {"nice": 5}}}
+// Anything missing or malformed keeps its compiled-in default.
+class CConfig
+{
+public:
+	struct stEndpoint
+	{
+		std::string host;
+		uint16_t port;
+	};
+
+	// how long a repeat of the last sync sent is held back, 0 sends every one
+	struct stSyncKeepalive
+	{
+		uint32_t onFoot;
+		uint32_t inCar;
+		uint32_t passenger;
+		uint32_t aim;
+	};
+
+	// players past nearRadius (metres, 0 treats everyone as near) get a sync through once per
+	// farIntervalMs and no aim or bullet syncs, see CSyncInterest
+	struct stSyncInterest
+	{
+		uint32_t nearRadius;
+		uint32_t farIntervalMs;
+	};
+
+	// remote player syncs wait for their turn in CSyncJitter, at most depth of them (0 hands
+	// them on as they come) and no longer than maxDelayMs
+	struct stSyncJitter
+	{
+		uint32_t depth;
+		uint32_t maxDelayMs;
+	};
+
+	// what LinkEmulator does to each direction of the server link, all off by default; for
+	// measuring how reliability, reconnects and sync settings hold up on a bad mobile link
+	struct stLinkEmulation
+	{
+		LinkConditions up;
+		LinkConditions down;
+	};
+
+	// an RPC moved to another class than CSendClass gives it, by SA-MP RPC id
+	struct stRpcClass
+	{
+		uint8_t rpcId;
+		uint8_t sendClass;
+	};
+
+	// the PacketPriority and ordering channel (0-31) each eSendClass goes out at, and the
+	// weight HIGH, MEDIUM and LOW each get of the link when they all have something to send;
+	// a 0 weight sends strictly by priority. See CSendClass
+	struct stSendClasses
+	{
+		uint8_t priority[SEND_CLASS_COUNT];
+		uint8_t channel[SEND_CLASS_COUNT];
+		uint8_t shares[3];
+		std::vector<stRpcClass> rpcClasses;
+	};
+
+	// where CTelemetry reports go, nowhere while host is empty
+	struct stTelemetry
+	{
+		std::string host;
+		uint16_t port;
+		uint32_t intervalMs;
+	};
+
+	// an RPC given a debounce window other than stDebounce::rpcMs, by SA-MP RPC id; 0 never drops it
+	struct stRpcDebounce
+	{
+		uint8_t rpcId;
+		uint16_t windowMs;
+	};
+
+	// how long an identical UI action is dropped for after the last one went out: rpcMs for the
+	// dialog response and textdraw click RPCs, uiMs for BR_ID_USER_INTERFACE_SYNC. See CDebounce
+	struct stDebounce
+	{
+		uint32_t rpcMs;
+		uint32_t uiMs;
+		std::vector<stRpcDebounce> rpcs;
+	};
+
+	// how CServerQuery probes the endpoints (every intervalMs while not connected, 0 never)
+	// and ranks them: ping plus loadMs at a full server, racing those within slackMs of the best
+	struct stServerQuery
+	{
+		uint32_t intervalMs;
+		uint32_t timeoutMs;
+		uint32_t loadMs;
+		uint32_t slackMs;
+	};
+
+	struct stSettings
+	{
+		std::vector<stEndpoint> endpoints;
+		// open connection requests per endpoint, and the gap between them
+		uint8_t connectAttempts;
+		uint32_t connectRetryMs;
+		// silence before the server counts as lost, 0 keeps RakNet's default
+		uint32_t timeoutMs;
+		// backoff after a failed connect doubles from base up to max, see CReconnect
+		uint32_t reconnectBaseMs;
+		uint32_t reconnectMaxMs;
+		// how long after a lost connection the world is kept for a resume, 0 disables it
+		uint32_t resumeWindowMs;
+		// how long the server may leave a join or spawn request unanswered, 0 waits forever;
+		// see CJoinHandshake
+		uint32_t joinTimeoutMs;
+		// record traffic into the external files dir, see CNetCapture
+		bool capture;
+		// events kept in trace.bin in the external files dir, 0 for none; see CTraceRing
+		uint32_t traceRecords;
+		// a hook the game thread has been in for this long gets a backtrace in the trace ring,
+		// 0 disables it; see CStallWatchdog
+		uint32_t stallWatchdogMs;
+		// SIGPROF rate while FEATURE_PROFILER samples, per second of CPU time; see CSampleProfiler
+		uint32_t profileHz;
+		// back the plugin's own work off while the device throttles, see CThermal
+		bool thermalMode;
+		// overlay frames built per second while nothing is touched, 0 builds one every swap;
+		// see COverlayCache
+		uint32_t overlayCacheHz;
+		// overlay window positions kept in imgui.ini, read and written by workers; see COverlaySettings
+		bool overlaySettings;
+		// server logos kept on disk and fetched after the join, see CLogoCache
+		bool logoCache;
+		// audio stream clips up to this size kept on disk, 0 keeps none; and URLs fetched ahead
+		// of their first play. See CAudioCache
+		uint32_t audioCacheKb;
+		std::vector<std::string> audioPrefetch;
+		// kernel buffers asked for on the socket, 0 keeps the system default; the "Link" stats
+		// show what was granted and how many datagrams the kernel still dropped
+		uint32_t socketReceiveBuffer;
+		uint32_t socketSendBuffer;
+		// largest datagram to start a connection with, lowered on paths that can't take it
+		uint32_t mtu;
+		// RPC payloads from this size on go LZ4 compressed if the server agrees, 0 never offers it
+		uint32_t compressAbove;
+		// offer delta-encoded sync, see CDeltaSync
+		bool deltaSync;
+		// let the server bound our sync rate and the link decide within it, see CSyncRate
+		bool adaptiveSyncRate;
+		// let the server have us connect to the next server ahead of a switch, see CStandby
+		bool warmStandby;
+		// an idle player's syncs go out at this rate only, see CPacketTranslator::IsRepeat
+		stSyncKeepalive syncKeepaliveMs;
+		// RPC handler time per ProcessNetwork before the rest waits a frame, 0 runs them all
+		uint32_t rpcBudgetUs;
+		stSyncInterest syncInterest;
+		stSyncJitter syncJitter;
+		stSendClasses sendClasses;
+		stLinkEmulation linkEmulation;
+		stTelemetry telemetry;
+		stServerQuery serverQuery;
+		stDebounce debounce;
+
+		// CFeatures bits, applied once loaded
+		uint32_t features;
+		// hooks that hand every call straight to the original from the start, by CHook::GetName
+		std::vector<std::string> hooksBypassed;
+		// nice and cores per thread role, applied once loaded
+		CThreadPolicy::stPolicy threads[THREAD_ROLE_COUNT];
+
+		// the external files dir itself, empty when it couldn't be worked out
+		std::string dataDir;
+		// the app's internal cache dir, for what can be rebuilt any time; empty likewise
+		std::string cacheDir;
+	};
+
+	// Reads and parses the file on a CWorkers thread; call once at startup
+	static void Load();
+	// Blocks until Load has finished, which is long done by the time anyone connects
+	static const stSettings& Get();
+
+private:
+	static void LoadFile();
+	static void SetDefaults(stSettings* settings);
+	static bool Parse(const std::string& text, stSettings* settings);
+
+	static stSettings m_settings;
+	static std::atomic<bool> m_bLoaded;
+};
@@ -1,11 +1,28 @@
 #include "entry.h"
 #include "xorstr.h"
+#include "config.h"
+#include "plugin/alloctracker.h"
+#include "plugin/framearena.h"
+#include "plugin/frameprofiler.h"
+#include "plugin/startuptimeline.h"
+#include "plugin/stallwatchdog.h"
+#include "plugin/standby.h"
+#include "plugin/systrace.h"
+#include "plugin/thermal.h"
 
 extern "C"
 jint JNI_OnLoad(JavaVM* vm, void* reserved)
 {
+	CStartupTimeline::Mark(STARTUP_ONLOAD);
     // Делаем все, что обычно делается в JNI_Onload
 	CApp::Initialise(eAppInit::APP_INIT_OFFSETS);
+	CStartupTimeline::Mark(STARTUP_CONFIG);
+
+	// the app's class loader is only guaranteed here; ShowBrNotification retries otherwise
+	JNIEnv* env = NULL;
+	if(vm->GetEnv((void**)&env, JNI_VERSION_1_6) == JNI_OK) {
+		BrNotificationResolveJni(env);
+	}
 	
 	pthread_t ptid;
     pthread_create(&ptid, NULL, hack_thread, NULL);
@@ -13,10 +30,20 @@ jint JNI_OnLoad(JavaVM* vm, void* reserved)
     return JNI_VERSION_1_6;
 }
 
+extern RakClientInterface* pRakClient;
+
 void (*orig_JNILib_step)(JNIEnv* env, jclass cls);
 void hook_JNILib_step(JNIEnv* env, jclass cls)
 {
+	HOOK_SCOPE(HOOK_JNILIB_STEP);
+	// everything the frame sends leaves in one update cycle, packed into as few datagrams as fit.
+	// The batch is closed on the client it was opened on; a standby swaps in only after that.
+	RakClientInterface* client = pRakClient;
+	client->BeginSendBatch();
 	orig_JNILib_step(env, cls);
+	CApp::Process(env);
+	client->EndSendBatch();
+	CStandby::OnFrameEnd();
 }
 
 bool inject_eglSwapBuffers()
@@ -24,95 +51,189 @@ bool inject_eglSwapBuffers()
 	// Hook eglSwapBuffers
     uintptr_t addr = (uintptr_t)dlsym(RTLD_NEXT, xorstr("eglSwapBuffers"));
 	if(addr) {
-    	DobbyHook((void *)addr, (void *)hook_eglSwapBuffers, (void **)&orig_eglSwapBuffers);
-    	return true;
+    	return CHook::Install(HOOK_EGL_SWAP_BUFFERS, addr, &hook_eglSwapBuffers, &orig_eglSwapBuffers);
 	}
 	return false;
 }
 
 void (*CNetGame__Packet_Turnlights)(Packet *pkt);
 void CNetGame__Packet_Turnlights__hook(Packet *pkt) {
-  CChat::AddDebugMessage(xorstr("CNetGame__Packet_Turnlights__hook"));
+  HOOK_SCOPE(HOOK_PACKET_TURNLIGHTS);
+  if(CHook::IsBypassed(HOOK_PACKET_TURNLIGHTS)) {
+    CNetGame__Packet_Turnlights(pkt);
+    return;
+  }
+  CHAT_DEBUG(xorstr("CNetGame__Packet_Turnlights__hook"));
   CNetGame__Packet_Turnlights(pkt);
 }
 
 void* hack_thread(void* args)
 {
-	while(!CGameAPI::GetBase()) {}
-	while(*(int *)(CGameAPI::GetBase(xorstr("RwInitialised"))) == 0) {}
+	readiness::WaitUntil([] { return CGameAPI::GetBase() != 0; });
+	if(!COffset::IsSelected()) {
+		// nothing to hook in a build we have no offsets for
+		pthread_exit(nullptr);
+	}
+	CStartupTimeline::Mark(STARTUP_OFFSETS);
+	volatile int* pRwInitialised = (volatile int *)(CGameAPI::GetBase(OFFSET("RwInitialised")));
+	// RegisterAsRemoteProcedureCall has to be hooked before the game registers its RPCs
+	readiness::WaitUntil([pRwInitialised] { return *pRwInitialised != 0; }, 1000);
+	CStartupTimeline::Mark(STARTUP_RW_READY);
 	
-	MSHookFunction((void *)(CGameAPI::GetBase(xorstr("RakClient::RegisterAsRemoteProcedureCall"))), (void *)&hook_RakClient__RegisterAsRemoteProcedureCall, (void **)&orig_RakClient__RegisterAsRemoteProcedureCall);
+	CHook::Install(HOOK_REGISTER_RPC, CGameAPI::GetBase(OFFSET("RakClient::RegisterAsRemoteProcedureCall")), &hook_RakClient__RegisterAsRemoteProcedureCall, &orig_RakClient__RegisterAsRemoteProcedureCall);
 	CApp::Initialise(eAppInit::APP_INIT_RW);
+	CStartupTimeline::Mark(STARTUP_APP_RW);
 	
 	//if(inject_eglSwapBuffers())
 	{
-		MSHookFunction((void *)(CGameAPI::GetBase(xorstr("JNILib_step"))), (void *)&hook_JNILib_step, (void **)&orig_JNILib_step);
-		//MSHookFunction((void *)(CGameAPI::GetBase(xorstr("TouchEvent"))), (void *)&hook_TouchEvent, (void **)&orig_TouchEvent);
-		MSHookFunction((void *)(CGameAPI::GetBase(xorstr("CNetGame::ProcessNetwork"))), (void *)&hook_CNetGame__ProcessNetwork, (void **)&orig_CNetGame__ProcessNetwork);
-		// MSHookFunction((void *)(CGameAPI::GetBase(xorstr("CNetTextDrawPool::SetServerLogo"))), (void *)&hook_CNetTextDrawPool__SetServerLogo, (void **)&orig_CNetTextDrawPool__SetServerLogo);
-		uintptr_t ng_pRakClient = *(uintptr_t *)(CGameAPI::GetBase(xorstr("CNetGame::m_pRakClient")));
-		while(!ng_pRakClient) {
-			ng_pRakClient = *(uintptr_t *)(CGameAPI::GetBase(xorstr("CNetGame::m_pRakClient")));
-		}
-		MSHookFunction((void *)( *(uintptr_t *)(*(uintptr_t *)ng_pRakClient + 8) ), (void *)&hook_RakClient__Connect, (void **)&orig_RakClient__Connect);
-		MSHookFunction((void *)( *(uintptr_t *)(*(uintptr_t *)ng_pRakClient + 32) ), (void *)&hook_RakClient__Send, (void **)&orig_RakClient__Send);
-		MSHookFunction((void *)( *(uintptr_t *)(*(uintptr_t *)ng_pRakClient + 108) ), (void *)&hook_RakClient__RPC, (void **)&orig_RakClient__RPC);
-
-		MSHookFunction((void*)CGameAPI::GetBase(xorstr("CNetGame::Packet_Turnlights")), (void*)&CNetGame__Packet_Turnlights__hook, (void**)&CNetGame__Packet_Turnlights);
-		
+		// the game's own code in one batch, the RakClient slots in another once it exists
+		CHookBatch code;
+		code.Install(HOOK_JNILIB_STEP, CGameAPI::GetBase(OFFSET("JNILib_step")), &hook_JNILib_step, &orig_JNILib_step);
+		//MSHookFunction((void *)(CGameAPI::GetBase(OFFSET("TouchEvent"))), (void *)&hook_TouchEvent, (void **)&orig_TouchEvent);
+		code.Install(HOOK_PROCESS_NETWORK, CGameAPI::GetBase(OFFSET("CNetGame::ProcessNetwork")), &hook_CNetGame__ProcessNetwork, &orig_CNetGame__ProcessNetwork);
+		code.Install(HOOK_SET_SERVER_LOGO, CGameAPI::GetBase(OFFSET("CNetTextDrawPool::SetServerLogo")), &hook_CNetTextDrawPool__SetServerLogo, &orig_CNetTextDrawPool__SetServerLogo);
+		code.Install(HOOK_PACKET_TURNLIGHTS, CGameAPI::GetBase(OFFSET("CNetGame::Packet_Turnlights")), &CNetGame__Packet_Turnlights__hook, &CNetGame__Packet_Turnlights);
+		code.Commit();
+
+		volatile uintptr_t* pRakClientSlot = g_Game.m_pRakClient;
+		readiness::WaitUntil([pRakClientSlot] { return *pRakClientSlot != 0; });
+		uintptr_t ng_pRakClient = *pRakClientSlot;
+		uintptr_t* vtable = *(uintptr_t **)ng_pRakClient;
+		// slots are counted in pointers, so the same indices hold on arm64
+		CHookBatch slots;
+		slots.InstallSlot(HOOK_RAKCLIENT_CONNECT, (uintptr_t)(vtable + 2), &hook_RakClient__Connect, &orig_RakClient__Connect);
+		slots.InstallSlot(HOOK_RAKCLIENT_SEND, (uintptr_t)(vtable + 8), &hook_RakClient__Send, &orig_RakClient__Send);
+		slots.InstallSlot(HOOK_RAKCLIENT_RPC, (uintptr_t)(vtable + 27), &hook_RakClient__RPC, &orig_RakClient__RPC);
+		slots.Commit();
 	}
+	CStartupTimeline::Mark(STARTUP_HOOKS);
 	
 	pthread_exit(nullptr);
     return nullptr;
 }
 
 static bool setup = false;
-static bool m_bNeedClearMousePos = false;
+// the last frame was built with something on screen
+static bool active = false;
 
-EGLBoolean hook_eglSwapBuffers(EGLDisplay dpy, EGLSurface surface)
+// The context and the GL backend come on the first frame the overlay has something to draw,
+// on the atlas CGUI::PrepareFonts loads in the background; false while that is still going
+static bool SetupOverlay()
+{
+	ImFontAtlas* atlas = CGUI::PrepareFonts();
+	if(!atlas) {
+		return false;
+	}
+	// Setup Dear ImGui context
+	IMGUI_CHECKVERSION();
+
+	ImGui::CreateContext(atlas);
+	ImGuiIO& io = ImGui::GetIO();
+	// never touches the disk from here, see COverlaySettings
+	COverlaySettings::Attach(io);
+
+	io.DisplaySize = ImVec2((float)RsGlobal->width, (float)RsGlobal->height);
+	
+	// Setup Platform/Renderer backends, the font texture is uploaded by the first NewFrame
+	ImGui_ImplOpenGL3_Init(xorstr("#version 300 es"));
+	// we are always called from the swap hook, with whatever the game left bound
+	ImGui_ImplOpenGL3_SetStateTracking(true);
+	// the linked shader program from the last run, so the first frame doesn't compile it
+	const CConfig::stSettings& config = CConfig::Get();
+	if(!config.cacheDir.empty()) {
+		char path[512];
+		snprintf(path, sizeof(path), xorstr("%s/imgui-program.bin"), config.cacheDir.c_str());
+		ImGui_ImplOpenGL3_SetProgramCache(path);
+	}
+	
+	// We load the default font with increased size to improve readability on many devices with "high" DPI.
+	ImGui::StyleColorsDark();
+	// Arbitrary scale-up
+	ImGui::GetStyle().ScaleAllSizes(2.f);
+	CApp::Initialise(eAppInit::APP_INIT_GUI);
+	CStartupTimeline::Mark(STARTUP_GUI);
+	
+	setup = true;
+	return true;
+}
+
+static void RenderOverlay()
 {
-	if(!setup) {
-		// Setup Dear ImGui context
-    	IMGUI_CHECKVERSION();
-    
-    	ImGui::CreateContext();
-    	ImGuiIO& io = ImGui::GetIO();
-
-		io.DisplaySize = ImVec2((float)RsGlobal->width, (float)RsGlobal->height);
-		
-		// Setup Platform/Renderer backends
-    	ImGui_ImplOpenGL3_Init(xorstr("#version 300 es"));
-    	
-    	// We load the default font with increased size to improve readability on many devices with "high" DPI.
-    	ImGui::StyleColorsDark();
-		// Arbitrary scale-up
-    	ImGui::GetStyle().ScaleAllSizes(2.f);
-        CApp::Initialise(eAppInit::APP_INIT_GUI);
-    	
-		setup = true;
+	// nothing to draw costs this check and no more; the frame after the last thing went
+	// away is still built, so the windows see their features off and the hit regions empty
+	bool wanted = CGUI::IsWanted();
+	if(!wanted && !active) {
+		return;
+	}
+	PROFILE_SCOPE(PROFILE_OVERLAY);
+	ALLOC_SCOPE(ALLOC_OVERLAY);
+	if(!setup && !SetupOverlay()) {
+		return;
+	}
+	// the game's viewport at swap time isn't always the screen; the backend puts back whatever is
+	// bound here, so the game finds the full screen after the overlay on every path below
+	glViewport(0, 0, RsGlobal->width, RsGlobal->height);
+
+    // a hot device gets the last frame's draw lists again, which skips building them;
+    // with the cache on, the last frame is already a texture
+    static uint32_t swapsSinceBuild = 0;
+    bool cached = COverlayCache::IsEnabled();
+    // the draw lists from before the overlay went idle are stale
+    bool build = wanted != active || (++swapsSinceBuild >= CThermal::GetOverlayDivider()
+        && (!cached || COverlayCache::WantsBuild(CTouchQueue::HasPending())));
+    if(!build && ImGui::GetDrawData()) {
+        if(cached) {
+            COverlayCache::Composite();
+        } else {
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+        return;
     }
+    swapsSinceBuild = 0;
+    active = wanted;
 
-    ImGuiIO &io = ImGui::GetIO();
+    CGUI::UpdateDisplay(ImGui::GetIO());
+    // touches that came in since the last frame, in order
+    CTouchQueue::Drain(ImGui::GetIO());
 
     // Start the Dear ImGui frame
     ImGui_ImplOpenGL3_NewFrame();
     ImGui::NewFrame();
 
+    // world labels first, they go under every window
+    CApp::Render2dStuff();
     // Render ImGui windows here.
     CApp::Render();
 
     // Rendering
     ImGui::EndFrame();
     ImGui::Render();
-    glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-    if (m_bNeedClearMousePos) {
-        io.MousePos = ImVec2(-1, -1);
-        m_bNeedClearMousePos = false;
+    COverlaySettings::Process(ImGui::GetIO());
+    CGUI::PublishHitRegions();
+    sdffont::EndFrame(ImGui::GetIO().Fonts, ImGui_ImplOpenGL3_UpdateFontsTexture, ImGui_ImplOpenGL3_UpdateFontsTextureBlocks);
+    if(cached) {
+        COverlayCache::Update(ImGui::GetDrawData());
+        COverlayCache::Composite();
+    } else {
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
     }
+}
 
-    return orig_eglSwapBuffers(dpy, surface);
+EGLBoolean hook_eglSwapBuffers(EGLDisplay dpy, EGLSurface surface)
+{
+	HOOK_SCOPE(HOOK_EGL_SWAP_BUFFERS);
+	STALL_SCOPE(STALL_SWAP_BUFFERS);
+	if(CHook::IsBypassed(HOOK_EGL_SWAP_BUFFERS)) {
+		return orig_eglSwapBuffers(dpy, surface);
+	}
+	SYSTRACE_SCOPE(xorstr_cached("brsamp:eglSwapBuffers"));
+	CFrameArena::Overlay().Reset();
+	CFrameProfiler::EndFrame();
+	CAllocTracker::EndFrame();
+	RenderOverlay();
+	EGLBoolean swapped = orig_eglSwapBuffers(dpy, surface);
+	CStartupTimeline::Mark(STARTUP_FIRST_FRAME);
+	return swapped;
 }
 
 void DrawMenu()
@@ -122,22 +243,12 @@ void DrawMenu()
 
 void hook_TouchEvent(JNIEnv* env, jclass cls, int action, int pointerId, int x1, int y1, int x2, int y2, int x3, int y3)
 {
-	ImGuiIO& io = ImGui::GetIO();
-	
-	if(action == 0) // down
-	{
-		io.MouseDown[pointerId] = true;
-		io.MousePos = ImVec2((pointerId == 0 ? x1 : (pointerId == 1 ? x2 : x3)), (pointerId == 0 ? y1 : (pointerId == 1 ? y2 : y3)));
-	}
-	if(action == 2) {
-		io.MousePos = ImVec2((pointerId == 0 ? x1 : (pointerId == 1 ? x2 : x3)), (pointerId == 0 ? y1 : (pointerId == 1 ? y2 : y3)));
-	}
-	if(action == 1) {
-		io.MouseDown[pointerId] = false;
-		m_bNeedClearMousePos = true;
-	}
-	
-	if(!CApp::OnTouchEvent(action, pointerId, (pointerId == 0 ? x1 : (pointerId == 1 ? x2 : x3)), (pointerId == 0 ? y1 : (pointerId == 1 ? y2 : y3)))) {
+	int x = (pointerId == 0 ? x1 : (pointerId == 1 ? x2 : x3));
+	int y = (pointerId == 0 ? y1 : (pointerId == 1 ? y2 : y3));
+	// ImGui belongs to the GL thread, the event is handed over
+	CTouchQueue::Push(action, pointerId, x, y);
+
+	if(!CApp::OnTouchEvent(action, pointerId, x, y)) {
 		orig_TouchEvent(env, cls, action, pointerId, x1, y1, x2, y2, x3, y3);
 	}
 }
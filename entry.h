@@ -19,9 +19,17 @@
 
 #include "game/rw/rw.h"
 #include "game/hooks.h"
+#include "game/BRNotification.h"
+
+#include "gui/overlaycache.h"
+#include "gui/overlaysettings.h"
+#include "gui/sdffont.h"
+#include "gui/touchqueue.h"
 
 #include "app.h"
+#include "hook.h"
 #include "plugin.h"
+#include "readiness.h"
 
 void* hack_thread(void* args);
 bool inject_eglSwapBuffers();
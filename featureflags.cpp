@@ -0,0 +1,44 @@
+#include "featureflags.h"
+
+#include <string.h>
+
+static const char* const g_featureNames[FEATURE_COUNT] = {
+	"debugLog",
+	"uiSyncLog",
+	"sendHints",
+	"panel",
+	"worldLabels",
+	"nativeDialogs",
+	"playerList",
+	"earlySpawn",
+	"earlyConnect",
+	"hooks",
+	"profiler",
+	"coords"
+};
+
+std::atomic<uint32_t> CFeatures::m_mask(CFeatures::DEFAULT_MASK);
+
+void CFeatures::Set(eFeature feature, bool enabled)
+{
+	if(enabled) {
+		m_mask.fetch_or(1u << feature, std::memory_order_relaxed);
+	} else {
+		m_mask.fetch_and(~(1u << feature), std::memory_order_relaxed);
+	}
+}
+
+eFeature CFeatures::FromName(const char* name)
+{
+	for(int i = 0; i < FEATURE_COUNT; i++) {
+		if(!strcmp(name, g_featureNames[i])) {
+			return (eFeature)i;
+		}
+	}
+	return FEATURE_COUNT;
+}
+
+const char* CFeatures::GetName(eFeature feature)
+{
+	return g_featureNames[feature];
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+enum eFeature
+{
+	FEATURE_DEBUG_LOG,		// CHAT_DEBUG messages in the game chat
+	FEATURE_UI_SYNC_LOG,	// every UI sync payload echoed into the chat
+	FEATURE_SEND_HINTS,		// supersede/immediate send flags from the translators, applied on connect
+	FEATURE_PANEL,			// the overlay that toggles all of these
+	FEATURE_WORLD_LABELS,	// remote player names and ids over their peds, drawn by the overlay
+	FEATURE_NATIVE_DIALOGS,	// SA-MP message boxes and lists drawn by the overlay instead of the game
+	FEATURE_PLAYER_LIST,	// every connected player with score and ping, in an overlay window
+	FEATURE_EARLY_SPAWN,	// RequestSpawn right after InitGame instead of after ScrSetSpawnInfo, see CJoinHandshake
+	FEATURE_EARLY_CONNECT,	// connect and authenticate while the game loads, see CEarlyConnect
+	FEATURE_HOOKS,			// every hook with its calls and cost, and bypass toggles; times calls while shown
+	FEATURE_PROFILER,		// samples where the plugin and the game spend CPU while shown, see CSampleProfiler
+	FEATURE_COORDS,			// the local ped's heading and position at the bottom of the screen
+	FEATURE_COUNT
+};
+
+// Runtime switches for debug output and paths still being tried out. Defaults are compiled
+// in, brsamp.json overrides them ("features": {"debugLog": true}) and the panel drawn by
+// CGUI flips them live. A check is one relaxed load and a bit test, so gated logging
+// costs nothing past that branch while it is off; put the check before any formatting.
+class CFeatures
+{
+public:
+	static constexpr uint32_t DEFAULT_MASK = 1u << FEATURE_SEND_HINTS | 1u << FEATURE_COORDS;
+
+	static inline bool IsEnabled(eFeature feature)
+	{
+		return (m_mask.load(std::memory_order_relaxed) >> feature) & 1;
+	}
+	static void Set(eFeature feature, bool enabled);
+	static uint32_t GetMask() { return m_mask.load(std::memory_order_relaxed); }
+	static void SetMask(uint32_t mask) { m_mask.store(mask, std::memory_order_relaxed); }
+
+	// the name brsamp.json uses, FEATURE_COUNT for an unknown one
+	static eFeature FromName(const char* name);
+	static const char* GetName(eFeature feature);
+
+private:
+	static std::atomic<uint32_t> m_mask;
+};
@@ -1,56 +1,143 @@
 #include "BRNotification.h"
+#include "plugin/uisync.h"
 
-std::vector<s_BrNotification> BrNotificationPool;
+#include <mutex>
+#include <string.h>
+
+// Pushed from the network thread, drained from the JNI thread. When full the oldest entry is dropped.
+static constexpr int NOTIFICATION_QUEUE_SIZE = 16;
+static s_BrNotification g_notificationQueue[NOTIFICATION_QUEUE_SIZE];
+static int g_notificationHead = 0;
+static int g_notificationCount = 0;
+static std::mutex g_notificationMutex;
 
 void BrNotificationUpdate(JNIEnv* env)
 {
-    if(!BrNotificationPool.empty()) {
-        s_BrNotification next_notification = BrNotificationPool.front();
-        ShowBrNotification(env, next_notification.type, next_notification.message.c_str(), next_notification.duration);
-        BrNotificationPool.erase(BrNotificationPool.begin());
+    s_BrNotification next;
+    {
+        std::lock_guard<std::mutex> lock(g_notificationMutex);
+        if(g_notificationCount == 0) {
+            return;
+        }
+        next = std::move(g_notificationQueue[g_notificationHead]);
+        g_notificationHead = (g_notificationHead + 1) % NOTIFICATION_QUEUE_SIZE;
+        g_notificationCount--;
     }
+    ShowBrNotification(env, next.type, next.message.c_str(), next.duration);
 }
 
-void ShowBrNotification(JNIEnv* env, eBrNotificationType type, std::string msg, int duration, std::string text2)
+// Classes and method IDs used to show notifications, resolved once.
+// FindClass only sees the app's classes from JNI_OnLoad or a Java thread, so it is retried on first use as well.
+static struct
 {
-    string jsonString = "{ \"t\":" + to_string(type) + ", \"i\":\"" + msg + "\", \"d\":" + to_string(duration) + ", \"s\":1, \"b\":1, \"k\":\"" + text2 + "\" }";
-    const char* jsonChars = jsonString.c_str();
-
-    jclass guiManagerClass = env->FindClass("com/blackhub/bronline/game/GUIManager");
-    if (guiManagerClass != NULL) {
-        jmethodID getInstanceMethod = env->GetStaticMethodID(guiManagerClass, "getInstance", "()Lcom/blackhub/bronline/game/GUIManager;");
-        if (getInstanceMethod != NULL) {
-            jobject guiManagerInstance = env->CallStaticObjectMethod(guiManagerClass, getInstanceMethod);
-            
-            jclass jsonObjectClass = env->FindClass("org/json/JSONObject");
-            if (jsonObjectClass != NULL) {
-                jmethodID jsonConstructor = env->GetMethodID(jsonObjectClass, "<init>", "(Ljava/lang/String;)V");
-                if (jsonConstructor != NULL) {
-                    jstring jsonStr = env->NewStringUTF(jsonChars);
-                    jobject jsonObject = env->NewObject(jsonObjectClass, jsonConstructor, jsonStr);
-                    
-                    jmethodID handleNotifMethod = env->GetMethodID(guiManagerClass, "handleNotificationScreen", "(ILorg/json/JSONObject;)V");
-                    if (handleNotifMethod != NULL) {
-                        env->CallVoidMethod(guiManagerInstance, handleNotifMethod, 1, jsonObject);
-                    }
-                    
-                    env->DeleteLocalRef(jsonStr);
-                    env->DeleteLocalRef(jsonObject);
-                }
-            }
-            
-            env->DeleteLocalRef(guiManagerInstance);
-        }
+    bool resolved;
+    jclass guiManagerClass;
+    jmethodID getInstance;
+    jmethodID handleNotification;
+    jclass jsonObjectClass;
+    jmethodID jsonConstructor;
+} g_jni;
+
+static jclass FindGlobalClass(JNIEnv* env, const char* name)
+{
+    jclass local = env->FindClass(name);
+    if(local == NULL) {
+        env->ExceptionClear();
+        return NULL;
+    }
+    jclass global = (jclass)env->NewGlobalRef(local);
+    env->DeleteLocalRef(local);
+    return global;
+}
+
+bool BrNotificationResolveJni(JNIEnv* env)
+{
+    if(g_jni.resolved) {
+        return true;
+    }
+
+    if(g_jni.guiManagerClass == NULL) {
+        g_jni.guiManagerClass = FindGlobalClass(env, "com/blackhub/bronline/game/GUIManager");
+    }
+    if(g_jni.jsonObjectClass == NULL) {
+        g_jni.jsonObjectClass = FindGlobalClass(env, "org/json/JSONObject");
+    }
+    if(g_jni.guiManagerClass == NULL || g_jni.jsonObjectClass == NULL) {
+        return false;
+    }
+
+    g_jni.getInstance = env->GetStaticMethodID(g_jni.guiManagerClass, "getInstance", "()Lcom/blackhub/bronline/game/GUIManager;");
+    g_jni.handleNotification = env->GetMethodID(g_jni.guiManagerClass, "handleNotificationScreen", "(ILorg/json/JSONObject;)V");
+    g_jni.jsonConstructor = env->GetMethodID(g_jni.jsonObjectClass, "<init>", "(Ljava/lang/String;)V");
+    if(g_jni.getInstance == NULL || g_jni.handleNotification == NULL || g_jni.jsonConstructor == NULL) {
+        env->ExceptionClear();
+        return false;
+    }
+
+    g_jni.resolved = true;
+    return true;
+}
+
+void ShowBrNotification(JNIEnv* env, eBrNotificationType type, const char* msg, int duration, const char* text2)
+{
+    if(!BrNotificationResolveJni(env)) {
+        return;
     }
-    
-    env->DeleteLocalRef(guiManagerClass);
+
+    char json[1024];
+    CJsonWriter writer(json, sizeof(json));
+    writer.Int("t", type);
+    writer.String("i", msg);
+    writer.Int("d", duration);
+    writer.Int("s", 1);
+    writer.Int("b", 1);
+    writer.String("k", text2);
+    if(!writer.End()) {
+        return;
+    }
+
+    jobject guiManagerInstance = env->CallStaticObjectMethod(g_jni.guiManagerClass, g_jni.getInstance);
+    if(guiManagerInstance == NULL) {
+        return;
+    }
+
+    jstring jsonStr = env->NewStringUTF(json);
+    jobject jsonObject = env->NewObject(g_jni.jsonObjectClass, g_jni.jsonConstructor, jsonStr);
+    if(jsonObject != NULL) {
+        env->CallVoidMethod(guiManagerInstance, g_jni.handleNotification, 1, jsonObject);
+        env->DeleteLocalRef(jsonObject);
+    } else {
+        env->ExceptionClear();
+    }
+
+    env->DeleteLocalRef(jsonStr);
+    env->DeleteLocalRef(guiManagerInstance);
 }
 
-void BrNotification(eBrNotificationType type, std::string msg, int duration)
+void BrNotification(eBrNotificationType type, const char* msg, int duration)
 {
-    s_BrNotification notif;
+    // capacity() is the fixed size, the overflow allocator is disabled
+    size_t len = strnlen(msg, BR_NOTIFICATION_MESSAGE_MAX - 1);
+    std::lock_guard<std::mutex> lock(g_notificationMutex);
+
+    // the same notification still waiting to be shown: keep one, with the longer duration
+    for(int i = 0; i < g_notificationCount; i++) {
+        s_BrNotification& pending = g_notificationQueue[(g_notificationHead + i) % NOTIFICATION_QUEUE_SIZE];
+        if(pending.type == type && pending.message.size() == len && !memcmp(pending.message.data(), msg, len)) {
+            if(duration > pending.duration) {
+                pending.duration = duration;
+            }
+            return;
+        }
+    }
+
+    if(g_notificationCount == NOTIFICATION_QUEUE_SIZE) {
+        g_notificationHead = (g_notificationHead + 1) % NOTIFICATION_QUEUE_SIZE;
+        g_notificationCount--;
+    }
+    s_BrNotification& notif = g_notificationQueue[(g_notificationHead + g_notificationCount) % NOTIFICATION_QUEUE_SIZE];
     notif.type = type;
-    notif.message = msg;
+    notif.message.assign(msg, len);
     notif.duration = duration;
-    BrNotificationPool.push_back(notif);
+    g_notificationCount++;
 }
\ No newline at end of file
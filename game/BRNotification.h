@@ -1,11 +1,9 @@
 #ifndef NOTIFICATION_BLACKRUSSIA
 #define NOTIFICATION_BLACKRUSSIA
 
-#include <vector>
-#include <string>
 #include <jni.h>
 
-using namespace std;
+#include "vendor/EASTL/fixed_string.h"
 
 enum eBrNotificationType
 {
@@ -18,15 +16,25 @@ enum eBrNotificationType
 	TYPE_NEW_GUI_INTERACTIVE = 6
 };
 
+// longer messages are cut, queued notifications never allocate
+constexpr int BR_NOTIFICATION_MESSAGE_MAX = 256;
+
 struct s_BrNotification
 {
 	eBrNotificationType type;
-	string message;
+	eastl::fixed_string<char, BR_NOTIFICATION_MESSAGE_MAX, false> message;
 	int duration;
+
+	s_BrNotification() : type(TYPE_MONEY_RED), duration(0) {}
+	s_BrNotification(s_BrNotification&&) = default;
+	s_BrNotification& operator=(s_BrNotification&&) = default;
+	s_BrNotification(const s_BrNotification&) = delete;
+	s_BrNotification& operator=(const s_BrNotification&) = delete;
 };
 
+bool BrNotificationResolveJni(JNIEnv* env);
 void BrNotificationUpdate(JNIEnv* env);
-void ShowBrNotification(JNIEnv* env, eBrNotificationType type, std::string msg, int duration, std::string text2 = "");
-void BrNotification(eBrNotificationType type, std::string msg, int duration);
+void ShowBrNotification(JNIEnv* env, eBrNotificationType type, const char* msg, int duration, const char* text2 = "");
+void BrNotification(eBrNotificationType type, const char* msg, int duration);
 
 #endif
@@ -5,17 +5,17 @@
 
 CMatrix* GetBoneMatrix(CPlayerPed* ped, int bone)
 {
-	return ((CMatrix*(*)(uintptr_t, int))CGameAPI::GetBase(xorstr("GetBoneMatrix")))(((uintptr_t)ped), bone);
+	return ((CMatrix*(*)(uintptr_t, int))CGameAPI::GetBase(OFFSET("GetBoneMatrix")))(((uintptr_t)ped), bone);
 }
 
 float CPlayerPed::GetWeaponRadiusOnScreen()
 {
-	return ((float(*)(CPlayerPed*))CGameAPI::GetBase(xorstr("CPlayerPed::GetWeaponRadiusOnScreen")))(this);
+	return ((float(*)(CPlayerPed*))CGameAPI::GetBase(OFFSET("CPlayerPed::GetWeaponRadiusOnScreen")))(this);
 }
 
 void CPlayerPed::TransformToNode(CVector* vec, int node)
 {
-	((void(*)(CPlayerPed*, CVector*, int))CGameAPI::GetBase(xorstr("CPed::TransformToNode")))(this, vec, node);
+	((void(*)(CPlayerPed*, CVector*, int))CGameAPI::GetBase(OFFSET("CPed::TransformToNode")))(this, vec, node);
 }
 
 uint8_t CPlayerPed::GetCurrentWeaponID()
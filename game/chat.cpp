@@ -3,13 +3,78 @@
 
 #include "plugin.h"
 
-void CChat::AddDebugMessage(const char* msg, ...) {
-    char buffer[1024]; // буфер для форматированного сообщения
-    va_list args;
-    
-    va_start(args, msg);
-    vsnprintf(buffer, sizeof(buffer), msg, args);
-    va_end(args);
-    
-    reinterpret_cast<void(*)(char*)>(CGameAPI::GetBase(xorstr("CChat::AddDebugMessage")))(buffer);
+#include <atomic>
+
+// must stay a power of two
+static constexpr uint32_t QUEUE_SIZE = 64;
+static constexpr uint32_t MESSAGE_SIZE = 256;
+// messages handed to the game per Flush, the rest wait for the next frame
+static constexpr uint32_t FLUSH_LIMIT = 16;
+
+// Bounded multi-producer queue after D. Vyukov. A slot is stored relative to its
+// index, so zero-initialised memory is already an empty queue: for ticket t the
+// slot is free while state == t - index and holds a message once it is t - index + 1.
+struct stChatSlot
+{
+	std::atomic<uint32_t> state;
+	char text[MESSAGE_SIZE];
+};
+
+static stChatSlot g_chatSlots[QUEUE_SIZE];
+static std::atomic<uint32_t> g_chatEnqueuePos(0);
+static uint32_t g_chatDequeuePos = 0;
+static std::atomic<uint32_t> g_chatDropped(0);
+
+void CChat::AddDebugMessage(const char* msg, ...)
+{
+	uint32_t ticket = g_chatEnqueuePos.load(std::memory_order_relaxed);
+	stChatSlot* slot;
+	for(;;) {
+		uint32_t index = ticket & (QUEUE_SIZE - 1);
+		slot = &g_chatSlots[index];
+		int32_t diff = (int32_t)(slot->state.load(std::memory_order_acquire) - (ticket - index));
+		if(diff == 0) {
+			if(g_chatEnqueuePos.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		} else if(diff < 0) {
+			// full until the next Flush
+			g_chatDropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		} else {
+			ticket = g_chatEnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	va_list args;
+	va_start(args, msg);
+	vsnprintf(slot->text, sizeof(slot->text), msg, args);
+	va_end(args);
+
+	slot->state.store(ticket - (ticket & (QUEUE_SIZE - 1)) + 1, std::memory_order_release);
+}
+
+void CChat::Flush()
+{
+	if(!g_Game.AddDebugMessage) {
+		return;
+	}
+	for(uint32_t n = 0; n < FLUSH_LIMIT; n++) {
+		uint32_t ticket = g_chatDequeuePos;
+		uint32_t index = ticket & (QUEUE_SIZE - 1);
+		stChatSlot& slot = g_chatSlots[index];
+		if(slot.state.load(std::memory_order_acquire) != ticket - index + 1) {
+			break;
+		}
+		g_Game.AddDebugMessage(slot.text);
+		slot.state.store(ticket + QUEUE_SIZE - index, std::memory_order_release);
+		g_chatDequeuePos = ticket + 1;
+	}
+
+	uint32_t dropped = g_chatDropped.exchange(0, std::memory_order_relaxed);
+	if(dropped) {
+		char buffer[64];
+		snprintf(buffer, sizeof(buffer), xorstr("(%u debug messages dropped)"), dropped);
+		g_Game.AddDebugMessage(buffer);
+	}
 }
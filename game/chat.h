@@ -1,9 +1,38 @@
 #pragma once
 
 #include <cstdarg>
+#include <cstdio>
 
+#include "featureflags.h"
+
+// Messages below CHAT_LOG_LEVEL are compiled out of the CHAT_DEBUG/CHAT_INFO macros.
+// CHAT_DEBUG is also off at runtime unless FEATURE_DEBUG_LOG is set, checked before the
+// arguments are evaluated.
+#define CHAT_LEVEL_DEBUG 0
+#define CHAT_LEVEL_INFO 1
+#define CHAT_LEVEL_NONE 2
+
+#ifndef CHAT_LOG_LEVEL
+#define CHAT_LOG_LEVEL CHAT_LEVEL_DEBUG
+#endif
+
+#if CHAT_LOG_LEVEL <= CHAT_LEVEL_DEBUG
+#define CHAT_DEBUG(...) (CFeatures::IsEnabled(FEATURE_DEBUG_LOG) ? CChat::AddDebugMessage(__VA_ARGS__) : (void)0)
+#else
+#define CHAT_DEBUG(...) ((void)0)
+#endif
+
+#if CHAT_LOG_LEVEL <= CHAT_LEVEL_INFO
+#define CHAT_INFO(...) CChat::AddDebugMessage(__VA_ARGS__)
+#else
+#define CHAT_INFO(...) ((void)0)
+#endif
+
+// AddDebugMessage can be called from any thread: the text is formatted into a
+// lock-free ring and handed to the game chat by Flush, once per frame on the game thread.
 class CChat
 {
 public:
 	static void AddDebugMessage(const char* msg, ...);
+	static void Flush();
 };
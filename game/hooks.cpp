@@ -1,52 +1,217 @@
 #include "hooks.h"
+#include "config.h"
+#include "featureflags.h"
+#include "hook.h"
+#include "plugin/translator.h"
+#include "plugin/capabilities.h"
+#include "plugin/debounce.h"
+#include "plugin/deltasync.h"
+#include "plugin/earlyconnect.h"
+#include "plugin/framearena.h"
+#include "plugin/joinhandshake.h"
+#include "plugin/logocache.h"
+#include "plugin/netcapture.h"
+#include "plugin/netstats.h"
+#include "plugin/reconnect.h"
+#include "plugin/resolver.h"
+#include "plugin/sendclass.h"
+#include "plugin/stallwatchdog.h"
+#include "plugin/standby.h"
+#include "plugin/syncqueue.h"
+#include "plugin/syncrate.h"
+#include "plugin/systrace.h"
+#include "plugin/tracering.h"
+#include "plugin/uisync.h"
+#include "plugin/worldsnapshot.h"
+#include "vendor/RakNet/LinkEmulator.h"
+#include "vendor/RakNet/SocketLayer.h"
+#include "scheduler.h"
 #include "xorstr.h"
 
-extern bool g_bInitGameProcess;
+#include <array>
+
+// FEATURE_UI_SYNC_LOG echoes every UI sync payload into the chat
+#define UI_SYNC_LOG(...) (CFeatures::IsEnabled(FEATURE_UI_SYNC_LOG) ? CChat::AddDebugMessage(__VA_ARGS__) : (void)0)
 
 RakClientInterface* pRakClient = RakNetworkFactory::GetRakClientInterface();
+// what the game registered, for a client other than the one it was registered on
+static void (*g_gameRpcs[256])(RPCParameters* rpcParams);
 
 void (*orig_CNetTextDrawPool__SetServerLogo)(uintptr_t thiz, std::string url);
 void hook_CNetTextDrawPool__SetServerLogo(uintptr_t thiz, std::string url)
 {
-	//RegisterRPCs(pRakClient);
-    orig_CNetTextDrawPool__SetServerLogo(thiz, url);
+	HOOK_SCOPE(HOOK_SET_SERVER_LOGO);
+	if(CHook::IsBypassed(HOOK_SET_SERVER_LOGO)) {
+		orig_CNetTextDrawPool__SetServerLogo(thiz, url);
+		return;
+	}
+	// the game downloaded it on every join; a cached copy goes in as a file:// URL
+	CLogoCache::Request(url, [thiz](const std::string& shown) {
+		orig_CNetTextDrawPool__SetServerLogo(thiz, shown);
+	});
 }
 
 void (*orig_CNetGame__ProcessNetwork)();
 void hook_CNetGame__ProcessNetwork()
 {
+	HOOK_SCOPE(HOOK_PROCESS_NETWORK);
+	STALL_SCOPE(STALL_PROCESS_NETWORK);
+	SYSTRACE_SCOPE(xorstr_cached("brsamp:ProcessNetwork"));
     // Receive zamena packets
     CNetGame::ProcessNetwork();
 }
 
+void PrepareConnect(RakClientInterface* client)
+{
+	for(int brId = 0; brId < 256 && CFeatures::IsEnabled(FEATURE_SEND_HINTS); brId++) {
+		const stPacketTranslator* translator = CPacketTranslator::Find((uint8_t)brId);
+		if(!translator) {
+			continue;
+		}
+		if(translator->supersede) {
+			client->SetSequencedSupersede(translator->outId, true);
+		}
+		if(translator->immediate) {
+			client->SetImmediateSend(translator->outId, true);
+		}
+	}
+	if(CFeatures::IsEnabled(FEATURE_SEND_HINTS)) {
+		// a delta stands on an acknowledged baseline, not on the delta before it
+		client->SetSequencedSupersede(ID_PLAYER_SYNC_DELTA, true);
+		client->SetSequencedSupersede(ID_VEHICLE_SYNC_DELTA, true);
+	}
+	CSendClass::Apply(client);
+	CDebounce::Apply();
+	const CConfig::stSettings& config = CConfig::Get();
+	if(config.capture && !config.dataDir.empty() && !CNetCapture::IsActive()) {
+		char path[512];
+		snprintf(path, sizeof(path), xorstr("%s/capture-%lld.brnc"), config.dataDir.c_str(), (long long)time(nullptr));
+		CNetCapture::Start(path);
+	}
+	client->SetConnectAttempts(config.connectAttempts, config.connectRetryMs);
+	SocketLayer::SetBufferSizes(config.socketReceiveBuffer, config.socketSendBuffer);
+	LinkEmulator::Set(config.linkEmulation.up, config.linkEmulation.down);
+	client->SetMTUSize(config.mtu);
+	CPacketTranslator::SetKeepalive(BR_ID_PLAYER_SYNC, config.syncKeepaliveMs.onFoot);
+	CPacketTranslator::SetKeepalive(BR_ID_VEHICLE_SYNC, config.syncKeepaliveMs.inCar);
+	CPacketTranslator::SetKeepalive(BR_ID_PASSENGER_SYNC, config.syncKeepaliveMs.passenger);
+	CPacketTranslator::SetKeepalive(BR_ID_AIM_SYNC, config.syncKeepaliveMs.aim);
+}
+
+void RegisterRPCs(RakClientInterface* client)
+{
+	for(int sampRpcId = 0; sampRpcId < 256; sampRpcId++) {
+		if(g_gameRpcs[sampRpcId]) {
+			client->RegisterAsRemoteProcedureCall(sampRpcId, g_gameRpcs[sampRpcId]);
+		}
+	}
+	InitialiseRPCFixups(client);
+	// not CSyncQueue: it has one producer, whichever client is pRakClient, see CStandby::OnFrameEnd
+	CWorldSnapshot::Initialise(client);
+	CCapabilities::Initialise(client);
+	CStandby::Initialise(client);
+}
+
+bool ConnectEndpoints(bool* waiting)
+{
+	// Every frontend that isn't backing off is asked at once and the first to answer gets the session
+	std::vector<const char*> hosts;
+	std::vector<unsigned short> ports;
+	CReconnect::SelectEndpoints(&hosts, &ports);
+
+	// names are raced once they resolve, RakNet would look them up right here on the game thread
+	std::vector<std::array<char, 16>> addresses(hosts.size());
+	std::vector<const char*> ready;
+	std::vector<unsigned short> readyPorts;
+	for(size_t i = 0; i < hosts.size(); i++) {
+		if(CResolver::Lookup(hosts[i], addresses[i].data())) {
+			ready.push_back(addresses[i].data());
+			readyPorts.push_back(ports[i]);
+		}
+	}
+	*waiting = ready.empty();
+	if(ready.empty()) {
+		return false;
+	}
+	return pRakClient->ConnectFastest(ready.data(), readyPorts.data(), (unsigned)readyPorts.size(), 0, 5);
+}
+
 bool (*orig_RakClient__Connect)(uintptr_t thiz, const char* host, uint16_t serverPort, uint16_t clientPort, unsigned int depreciated, int threadSleepTimer);
 bool hook_RakClient__Connect(uintptr_t thiz, const char* host, uint16_t serverPort, uint16_t clientPort, unsigned int depreciated, int threadSleepTimer)
 {
-    return pRakClient->Connect(xorstr("93.127.130.91"), 7777, 0, 0, 5);
-}
+	HOOK_SCOPE(HOOK_RAKCLIENT_CONNECT);
+	// the session opened while the game loaded is handed over instead
+	if(CEarlyConnect::Claim()) {
+		return true;
+	}
+	// as is the one opened to the server we are being moved to
+	if(CStandby::Claim()) {
+		return true;
+	}
+	// retries and backoffs count towards the join they belong to
+	if(!CJoinHandshake::IsJoining()) {
+		CJoinHandshake::OnConnect();
+	}
+	PrepareConnect(pRakClient);
 
-// 93.127.130.91 7777
+	bool waiting;
+	bool connecting = ConnectEndpoints(&waiting);
+	if(waiting)
+	{
+		// parked like a backoff: WAIT_CONNECT brings the game back here once the lookups are in
+		CFrameScheduler::Post([] { CNetGame::SetGameState(GAMESTATE_DISCONNECTED); });
+		CResolver::OnIdle([](bool ok) {
+			if(!ok) {
+				CReconnect::OnAttemptFailed();
+			}
+			else if(CNetGame::GetGameState() == GAMESTATE_DISCONNECTED) {
+				CNetGame::SetGameState(GAMESTATE_WAIT_CONNECT);
+			}
+		});
+		return true;
+	}
+	return connecting;
+}
 
 void (*orig_RakClient__RegisterAsRemoteProcedureCall)(uintptr_t thiz, BRRpcIds id, void (*functionPointer)(RPCParameters* rpcParams));
 void hook_RakClient__RegisterAsRemoteProcedureCall(uintptr_t thiz, BRRpcIds id, void (*functionPointer)(RPCParameters* rpcParams))
 {
+	HOOK_SCOPE(HOOK_REGISTER_RPC);
 	int sampRpcId = ConvertBRIDToSampID(id);
 	if(sampRpcId != -1) {
-		pRakClient->RegisterAsRemoteProcedureCall(&sampRpcId, functionPointer);
+		if(sampRpcId < 256) {
+			g_gameRpcs[sampRpcId] = functionPointer;
+		}
+		pRakClient->RegisterAsRemoteProcedureCall(sampRpcId, functionPointer);
 	}
 }
 
 bool (*orig_RakClient__RPC)( uintptr_t thiz, BRRpcIds uniqueID, RakNet::BitStream *bitStream, PacketPriority priority, BRPacketReliability reliability, char orderingChannel, bool shiftTimestamp, NetworkID networkID, RakNet::BitStream *replyFromTarget );
 bool hook_RakClient__RPC( uintptr_t thiz, BRRpcIds uniqueID, RakNet::BitStream *bitStream, PacketPriority priority, BRPacketReliability reliability, char orderingChannel, bool shiftTimestamp, NetworkID networkID, RakNet::BitStream *replyFromTarget )
 {
+	HOOK_SCOPE(HOOK_RAKCLIENT_RPC);
+	SYSTRACE_SCOPE(xorstr_cached("brsamp:RakClient::RPC"));
+	CNetStats::Scope stats(NETSTAT_OUT_RPC, (uint8_t)uniqueID, bitStream ? bitStream->GetNumberOfBytesUsed() : 0);
+	if(bitStream) {
+		CNetCapture::Record(CAPTURE_RPC | CAPTURE_OUT, uniqueID, bitStream->GetData(), bitStream->GetNumberOfBitsUsed());
+	}
 	int sampRpcId = ConvertBRIDToSampID(uniqueID);
 	if(sampRpcId != -1) {
-		if(sampRpcId == RPC_RequestClass && g_bInitGameProcess) {
+		// the same tap again, the server has it already
+		if(CDebounce::IsRepeatRpc(sampRpcId, bitStream ? bitStream->GetData() : nullptr, bitStream ? bitStream->GetNumberOfBitsUsed() : 0)) {
+			return true;
+		}
+		if(sampRpcId == RPC_RequestClass && CJoinHandshake::IsInInitGame()) {
 			return false;
 		}
-		return pRakClient->RPC(&sampRpcId, bitStream, priority, ConvertBRToSampReliability(reliability), orderingChannel, shiftTimestamp, networkID, replyFromTarget);
+		if(sampRpcId == RPC_Spawn) {
+			CJoinHandshake::OnSpawned();
+		}
+		eSendClass sendClass = CSendClass::ForRpc(sampRpcId);
+		return pRakClient->RPC(sampRpcId, bitStream, CSendClass::GetPriority(sendClass), ConvertBRToSampReliability(reliability),
+			CSendClass::GetOrderingChannel(sendClass), shiftTimestamp, networkID, replyFromTarget);
 	} else {
-		// CChat::AddDebugMessage(xorstr("Unknown RPC: %i"), uniqueID);
+		CTraceRing::Trace(TRACE_UNKNOWN_RPC, uniqueID);
 	}
 	return false;
 }
@@ -54,143 +219,66 @@ bool hook_RakClient__RPC( uintptr_t thiz, BRRpcIds uniqueID, RakNet::BitStream *
 bool (*orig_RakClient__Send)( uintptr_t thiz, RakNet::BitStream* bitStream, PacketPriority priority, BRPacketReliability reliability, char orderingChannel );
 bool hook_RakClient__Send( uintptr_t thiz, RakNet::BitStream* bitStream, PacketPriority priority, BRPacketReliability reliability, char orderingChannel )
 {
-	RakNet::BitStream bsCopy(bitStream->GetData(), bitStream->GetNumberOfBytesUsed() + 1, false);
-	uint8_t pktId;
-	bsCopy.Read(pktId);
-	if(pktId == BR_ID_USER_INTERFACE_SYNC) {
-		uint16_t guiId;
-		uint32_t jsonLen;
-		bsCopy.Read(guiId);
-		bsCopy.Read(jsonLen);
-		if(jsonLen > 0) {
-			bsCopy.Read(CGUI::buffGUI, jsonLen);
-			CGUI::buffGUI[jsonLen] = 0;
-			static char* buffGUI;
-			if(!buffGUI) { buffGUI = new char[4096]; }
-			cp1251_to_utf8(buffGUI, CGUI::buffGUI);
-			if(guiId == 10) {
-				if(nlohmann::json::accept(buffGUI)) {
-					nlohmann::json jsonObj = nlohmann::json::parse(buffGUI);
-					uint8_t btn = jsonObj["r"];
-					int16_t listInput = jsonObj["l"];
-					std::string input = jsonObj["i"];
-					uint8_t inputLen = input.length();
-					RakNet::BitStream bsSend;
-					bsSend.WriteBits((unsigned char *)&CNetGame::m_nLastSAMPDialogID, 16);
-					bsSend.WriteBits((unsigned char *)&btn, 8);
-					bsSend.WriteBits((unsigned char *)&listInput, 16);
-					bsSend.WriteBits((unsigned char *)&inputLen, 8);
-					bsSend.Write(input.c_str(), inputLen);
-					 CChat::AddDebugMessage("Dialog ID: %i | BTN: %i | list: %i | input: %s", CNetGame::m_nLastSAMPDialogID, btn, listInput, input.c_str());
-					bool result = pRakClient->RPC(&RPC_DialogResponse, &bsSend, HIGH_PRIORITY, RELIABLE_ORDERED, 0, false, UNASSIGNED_NETWORK_ID, NULL);
-					if(result) {
-						 CChat::AddDebugMessage("Response sended!");
-					} else {
-						 CChat::AddDebugMessage("Fuck.. its not sended ..");
-					}
-				}
-			}
-			 CChat::AddDebugMessage("{ffff00}Sended JSON{ffffff}(id: %i): \"%s\"", guiId, CGUI::buffGUI);
-		}
+	// where NETSTAT_OUT_WIRE starts: the game has the packet built
+	uint64_t originNs = CNetStats::Now();
+	HOOK_SCOPE(HOOK_RAKCLIENT_SEND);
+	SYSTRACE_SCOPE(xorstr_cached("brsamp:RakClient::Send"));
+	if(bitStream->GetNumberOfBytesUsed() == 0) {
+		return false;
+	}
+	uint8_t pktId = bitStream->GetData()[0];
+	CNetStats::Scope stats(NETSTAT_OUT_PACKET, pktId, bitStream->GetNumberOfBytesUsed());
+	CNetCapture::Record(CAPTURE_PACKET | CAPTURE_OUT, pktId, bitStream->GetData(), bitStream->GetNumberOfBitsUsed());
+	const stPacketTranslator* translator = CPacketTranslator::Find(pktId);
+	if(translator && !CSyncRate::Admit(pktId)) {
+		// over the rate the link takes right now; the next tick carries newer state anyway
+		return true;
 	}
-	if(pktId == BR_ID_AIM_SYNC) {
-		uint8_t pktAimSync = ID_AIM_SYNC;
-	    uint8_t aimSyncBuffer[31] = {0};
-		bsCopy.ReadBits(aimSyncBuffer, 31 * 8);
-		RakNet::BitStream bsSend;
-	    bsSend.WriteBits(&pktAimSync, 8);
-	    bsSend.WriteBits(aimSyncBuffer, 31 * 8);
-	    return pRakClient->Send(&bsSend, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0);
-	}
-	if(pktId == BR_ID_BULLET_SYNC) {
-		uint8_t pktBltSync = ID_BULLET_SYNC;
-	    uint8_t bltSyncBuffer[40] = {0};
-		bsCopy.ReadBits(bltSyncBuffer, 40 * 8);
-		RakNet::BitStream bsSend;
-	    bsSend.WriteBits(&pktBltSync, 8);
-	    bsSend.WriteBits(bltSyncBuffer, 40 * 8);
-	    return pRakClient->Send(&bsSend, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0);
-	}
-	if(pktId == BR_ID_PLAYER_SYNC) {
-		uint8_t pktPlayerSync = ID_PLAYER_SYNC;
-	    BROnFootSyncData data;
-	    bsCopy.ReadBits((unsigned char *)&data.lrAnalogLeftStick, 16);
-		bsCopy.ReadBits((unsigned char *)&data.udAnalogLeftStick, 16);
-		bsCopy.ReadBits((unsigned char *)&data.wKeys, 16);
-		bsCopy.ReadBits((unsigned char *)&data.vecPos, 96);
-		bsCopy.ReadBits((unsigned char *)&data.quatw, 32);
-		bsCopy.ReadBits((unsigned char *)&data.quatx, 32);
-		bsCopy.ReadBits((unsigned char *)&data.quaty, 32);
-		bsCopy.ReadBits((unsigned char *)&data.quatz, 32);
-		bsCopy.ReadBits((unsigned char *)&data.health, 16);
-		bsCopy.ReadBits((unsigned char *)&data.armour, 16);
-		bsCopy.ReadBits((unsigned char *)&data.byteCurrentWeapon, 8);
-		bsCopy.ReadBits((unsigned char *)&data.byteSpecialAction, 8);
-		bsCopy.ReadBits((unsigned char *)&data.vecMoveSpeed, 96);
-		bsCopy.ReadBits((unsigned char *)&data.vecSurfOffsets, 96);
-		bsCopy.ReadBits((unsigned char *)&data.wSurfInfo, 16);
-		bsCopy.ReadBits((unsigned char *)&data.dwAnimation, 32);
-	    RakNet::BitStream bsSend;
-	    bsSend.WriteBits(&pktPlayerSync, 8);
-	    ConvertBROnFootSyncToSampSync(&bsSend, data);
-	    return pRakClient->Send(&bsSend, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0);
-	}
-	if(pktId == BR_ID_VEHICLE_SYNC) {
-		uint8_t pktVehicleSync = ID_VEHICLE_SYNC;
-	    BRInCarSyncData data;
-	    bsCopy.ReadBits((unsigned char *)&data.VehicleID, 16);
-		int vehPool = *(int *)(CGameAPI::GetBase(xorstr("CNetGame::m_pVehiclePool")));
-		int veh = *(int *)(vehPool + 4 * data.VehicleID);
-		if(veh) {
-			*(uint8_t *)(veh + 0x1C0) = 4;
-			*(uint8_t *)(veh + 0x1C4) = 8;
+	if(translator) {
+		// the game builds the stream for this one send, so an opaque payload can go out of it as is
+		uint8_t* out = bitStream->GetData();
+		uint32_t outLen = CPacketTranslator::TranslateInPlace(translator, out, bitStream->GetNumberOfBytesUsed());
+		if(!outLen) {
+			out = CPacketTranslator::GetScratch();
+			outLen = CPacketTranslator::Translate(translator, bitStream->GetData(), bitStream->GetNumberOfBytesUsed(), out);
+		}
+		if(CPacketTranslator::IsRepeat(pktId, out, outLen)) {
+			// the server has this state already and hears from us again at the keepalive
+			return true;
 		}
-		bsCopy.ReadBits((unsigned char *)&data.lrAnalogLeftStick, 16);
-		bsCopy.ReadBits((unsigned char *)&data.udAnalogLeftStick, 16);
-		bsCopy.ReadBits((unsigned char *)&data.wKeys, 16);
-		bsCopy.ReadBits((unsigned char *)&data.quatw, 32);
-		bsCopy.ReadBits((unsigned char *)&data.quatx, 32);
-		bsCopy.ReadBits((unsigned char *)&data.quaty, 32);
-		bsCopy.ReadBits((unsigned char *)&data.quatz, 32);
-		bsCopy.ReadBits((unsigned char *)&data.vecPos.x, 32);
-		bsCopy.ReadBits((unsigned char *)&data.vecPos.y, 32);
-		bsCopy.ReadBits((unsigned char *)&data.vecPos.z, 32);
-		bsCopy.ReadBits((unsigned char *)&data.vecMoveSpeed.x, 32);
-		bsCopy.ReadBits((unsigned char *)&data.vecMoveSpeed.y, 32);
-		bsCopy.ReadBits((unsigned char *)&data.vecMoveSpeed.z, 32);
-		bsCopy.ReadBits((unsigned char *)&data.fCarHealth, 32);
-		bsCopy.ReadBits((unsigned char *)&data.playerHealth, 16);
-		bsCopy.ReadBits((unsigned char *)&data.playerArmour, 16);
-		bsCopy.ReadBits((unsigned char *)&data.byteCurrentWeapon, 8);
-		bsCopy.ReadBits((unsigned char *)&data.byteSirenOn, 8);
-		bsCopy.ReadBits((unsigned char *)&data.byteLandingGearState, 8);
-		bsCopy.ReadBits((unsigned char *)&data.TrailerID, 16);
-	    RakNet::BitStream bsSend;
-	    bsSend.WriteBits(&pktVehicleSync, 8);
-	    ConvertBRInCarSyncToSampSync(&bsSend, data);
-	    return pRakClient->Send(&bsSend, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0);
-	}
-	if(pktId == BR_ID_PASSENGER_SYNC) {
-		uint8_t pktPassengerSync = ID_PASSENGER_SYNC;
-		BRPassengerSyncData data;
-		bsCopy.ReadBits((unsigned char *)&data.VehicleID, 16);
-		uint8_t tempByte;
-		bsCopy.ReadBits((unsigned char *)&tempByte, 7);
-		data.byteSeatFlags = tempByte;
-		bsCopy.ReadBits((unsigned char *)&tempByte, 1);
-		data.byteDriveBy = tempByte;
-		bsCopy.ReadBits((unsigned char *)&data.byteCurrentWeapon, 8);
-		bsCopy.ReadBits((unsigned char *)&data.playerHealth, 16);
-		bsCopy.ReadBits((unsigned char *)&data.playerArmour, 16);
-		bsCopy.ReadBits((unsigned char *)&data.lrAnalog, 16);
-		bsCopy.ReadBits((unsigned char *)&data.udAnalog, 16);
-		bsCopy.ReadBits((unsigned char *)&data.wKeys, 16);
-		bsCopy.ReadBits((unsigned char *)&data.vecPos, 96);
-		RakNet::BitStream bsSend;
-	    bsSend.WriteBits(&pktPassengerSync, 8);
-	    ConvertBRPassengerSyncToSampSync(&bsSend, data);
-	    return pRakClient->Send(&bsSend, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0);
+		const uint8_t* packet = CDeltaSync::Encode(out, &outLen);
+		return pRakClient->Send((const char *)packet, outLen, CSendClass::GetPriority(translator->sendClass), translator->reliability,
+			CSendClass::GetOrderingChannel(translator->sendClass), originNs);
+	}
+	if(pktId != BR_ID_USER_INTERFACE_SYNC) {
+		// nothing SA-MP would understand, dropped as it always was
+		return false;
+	}
+	if(CDebounce::IsRepeatUi(bitStream->GetData(), bitStream->GetNumberOfBytesUsed())) {
+		return false;
 	}
 	
+	RakNet::BitStream bsCopy(bitStream->GetData(), bitStream->GetNumberOfBytesUsed(), false);
+	bsCopy.IgnoreBits(8);
+	uint16_t guiId;
+	uint32_t jsonLen;
+	bsCopy.Read(guiId);
+	bsCopy.Read(jsonLen);
+	CFrameArena::Scope scratch(CFrameArena::Network());
+	char* json = jsonLen > 0 && jsonLen < 4096 ? (char*)CFrameArena::Network().Alloc(jsonLen + 1) : nullptr;
+	if(json && bsCopy.Read(json, jsonLen)) {
+		json[jsonLen] = 0;
+		stDialogResponse response;
+		if(guiId == 10 && ParseDialogResponse(json, jsonLen, &response)) {
+			UI_SYNC_LOG("Dialog ID: %i | BTN: %i | list: %i | input: %s", CNetGame::m_nLastSAMPDialogID, response.button, response.listItem, response.input);
+			bool result = CNetGame::SendDialogResponse(response.button, response.listItem, response.input, response.inputLen);
+			if(result) {
+				UI_SYNC_LOG("Response sended!");
+			} else {
+				UI_SYNC_LOG("Fuck.. its not sended ..");
+			}
+		}
+		UI_SYNC_LOG("{ffff00}Sended JSON{ffffff}(id: %i): \"%s\"", guiId, json);
+	}
 	return false;
 }
\ No newline at end of file
@@ -26,6 +26,14 @@ void hook_CNetTextDrawPool__SetServerLogo(uintptr_t thiz, std::string url);
 extern void (*orig_CNetGame__ProcessNetwork)();
 void hook_CNetGame__ProcessNetwork();
 
+// Settings every connect applies to the client before racing the endpoints
+void PrepareConnect(RakClientInterface* client);
+// Everything the game and the plugin registered on pRakClient, for another client to take its place
+void RegisterRPCs(RakClientInterface* client);
+// Races every due endpoint whose name has resolved. Nothing is sent while all of them are
+// still being looked up, *waiting says so and the caller picks when to try again.
+bool ConnectEndpoints(bool* waiting);
+
 // zamena
 extern bool (*orig_RakClient__Connect)(uintptr_t thiz, const char* host, uint16_t serverPort, uint16_t clientPort, unsigned int depreciated, int threadSleepTimer);
 bool hook_RakClient__Connect(uintptr_t thiz, const char* host, uint16_t serverPort, uint16_t clientPort, unsigned int depreciated, int threadSleepTimer);
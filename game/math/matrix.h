@@ -25,9 +25,17 @@ public:
 	void* m_attachment;
 	bool m_hasRwMatrix;
 	
-	CVector GetPosition();
-	CVector GetFront();
-	CVector GetRight();
-	CVector GetUp();
-	
+	CVector GetPosition() const { return CVector(px, py, pz); }
+	CVector GetFront() const { return CVector(fx, fy, fz); }
+	CVector GetRight() const { return CVector(rx, ry, rz); }
+	CVector GetUp() const { return CVector(ux, uy, uz); }
+
+	// rotation and translation of v, the way the game transforms points
+	CVector TransformPoint(const CVector& v) const
+	{
+		return CVector(rx * v.x + fx * v.y + ux * v.z + px,
+			ry * v.x + fy * v.y + uy * v.z + py,
+			rz * v.x + fz * v.y + uz * v.z + pz);
+	}
+
 };
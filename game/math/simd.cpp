@@ -0,0 +1,92 @@
+#include "simd.h"
+
+namespace math
+{
+	void TransformPoints(const CMatrix& m, const float* x, const float* y, const float* z, int count,
+		float* outX, float* outY, float* outZ)
+	{
+		int i = 0;
+#ifdef MATH_NEON
+		for(; i + 4 <= count; i += 4)
+		{
+			float32x4_t tx, ty, tz;
+			Transform4(m, vld1q_f32(x + i), vld1q_f32(y + i), vld1q_f32(z + i), tx, ty, tz);
+			vst1q_f32(outX + i, tx);
+			vst1q_f32(outY + i, ty);
+			vst1q_f32(outZ + i, tz);
+		}
+#elif defined(MATH_SSE)
+		for(; i + 4 <= count; i += 4)
+		{
+			__m128 tx, ty, tz;
+			Transform4(m, _mm_loadu_ps(x + i), _mm_loadu_ps(y + i), _mm_loadu_ps(z + i), tx, ty, tz);
+			_mm_storeu_ps(outX + i, tx);
+			_mm_storeu_ps(outY + i, ty);
+			_mm_storeu_ps(outZ + i, tz);
+		}
+#endif
+		for(; i < count; i++)
+		{
+			CVector v = m.TransformPoint(CVector(x[i], y[i], z[i]));
+			outX[i] = v.x;
+			outY[i] = v.y;
+			outZ[i] = v.z;
+		}
+	}
+
+	void TransformPoints(const CMatrix& m, const CVector* in, int count, CVector* out)
+	{
+		int i = 0;
+#ifdef MATH_NEON
+		for(; i + 4 <= count; i += 4)
+		{
+			// deinterleaves four packed vectors into x, y and z lanes, and back on store
+			float32x4x3_t v = vld3q_f32(&in[i].x);
+			float32x4x3_t t;
+			Transform4(m, v.val[0], v.val[1], v.val[2], t.val[0], t.val[1], t.val[2]);
+			vst3q_f32(&out[i].x, t);
+		}
+#elif defined(MATH_SSE)
+		for(; i + 4 <= count; i += 4)
+		{
+			__m128 x, y, z, tx, ty, tz;
+			Load3(in + i, x, y, z);
+			Transform4(m, x, y, z, tx, ty, tz);
+			Store3(out + i, tx, ty, tz);
+		}
+#endif
+		for(; i < count; i++) {
+			out[i] = m.TransformPoint(in[i]);
+		}
+	}
+
+	void DistancesSquared(const CVector& origin, const CVector* in, int count, float* out)
+	{
+		int i = 0;
+#ifdef MATH_NEON
+		float32x4_t ox = vdupq_n_f32(origin.x), oy = vdupq_n_f32(origin.y), oz = vdupq_n_f32(origin.z);
+		for(; i + 4 <= count; i += 4)
+		{
+			float32x4x3_t v = vld3q_f32(&in[i].x);
+			float32x4_t dx = vsubq_f32(v.val[0], ox);
+			float32x4_t dy = vsubq_f32(v.val[1], oy);
+			float32x4_t dz = vsubq_f32(v.val[2], oz);
+			vst1q_f32(out + i, vmlaq_f32(vmlaq_f32(vmulq_f32(dx, dx), dy, dy), dz, dz));
+		}
+#elif defined(MATH_SSE)
+		__m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+		for(; i + 4 <= count; i += 4)
+		{
+			__m128 x, y, z;
+			Load3(in + i, x, y, z);
+			__m128 dx = _mm_sub_ps(x, ox);
+			__m128 dy = _mm_sub_ps(y, oy);
+			__m128 dz = _mm_sub_ps(z, oz);
+			_mm_storeu_ps(out + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+		}
+#endif
+		for(; i < count; i++) {
+			out[i] = (in[i] - origin).lengthSquared();
+		}
+	}
+}
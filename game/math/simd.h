@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <string.h>
+
+#include "matrix.h"
+#include "vector.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define MATH_NEON 1
+#elif defined(__SSE2__)
+// every x86 Android ABI has SSE2 (x86_64 up to SSE4.2), so the emulator builds get lanes too
+#include <emmintrin.h>
+#define MATH_SSE 1
+#endif
+
+// Register-sized vector and matrix for geometry done in bulk. CMatrix4 has the same 16
+// float layout as the top of CMatrix (right, front, up, pos, each with a pad lane), so
+// converting is a copy and TransformPoint matches CMatrix::TransformPoint. The element
+// types are aligned for vld1q and _mm_load_ps; CMatrix usually isn't, which is why
+// FromMatrix copies.
+struct alignas(16) CVector4
+{
+	float x, y, z, w;
+
+	CVector4() : x(0), y(0), z(0), w(0) {}
+	CVector4(float fx, float fy, float fz, float fw) : x(fx), y(fy), z(fz), w(fw) {}
+	// w 1 for a point, 0 for a direction
+	CVector4(const CVector& v, float fw) : x(v.x), y(v.y), z(v.z), w(fw) {}
+
+	CVector ToVector() const { return CVector(x, y, z); }
+
+#ifdef MATH_NEON
+	float32x4_t Load() const { return vld1q_f32(&x); }
+	void Store(float32x4_t v) { vst1q_f32(&x, v); }
+#elif defined(MATH_SSE)
+	__m128 Load() const { return _mm_load_ps(&x); }
+	void Store(__m128 v) { _mm_store_ps(&x, v); }
+#endif
+};
+
+struct alignas(16) CMatrix4
+{
+	CVector4 right;
+	CVector4 front;
+	CVector4 up;
+	CVector4 pos;
+
+	static CMatrix4 FromMatrix(const CMatrix& matrix)
+	{
+		CMatrix4 out;
+		memcpy(&out, &matrix, sizeof(out));
+		return out;
+	}
+	// leaves the attachment fields alone
+	void ToMatrix(CMatrix& matrix) const { memcpy(&matrix, this, sizeof(*this)); }
+
+	CVector4 Transform(const CVector4& v) const
+	{
+		CVector4 out;
+#ifdef MATH_NEON
+		float32x4_t r = vmulq_n_f32(right.Load(), v.x);
+		r = vmlaq_n_f32(r, front.Load(), v.y);
+		r = vmlaq_n_f32(r, up.Load(), v.z);
+		out.Store(vmlaq_n_f32(r, pos.Load(), v.w));
+#elif defined(MATH_SSE)
+		__m128 r = _mm_mul_ps(right.Load(), _mm_set1_ps(v.x));
+		r = _mm_add_ps(r, _mm_mul_ps(front.Load(), _mm_set1_ps(v.y)));
+		r = _mm_add_ps(r, _mm_mul_ps(up.Load(), _mm_set1_ps(v.z)));
+		out.Store(_mm_add_ps(r, _mm_mul_ps(pos.Load(), _mm_set1_ps(v.w))));
+#else
+		out.x = right.x * v.x + front.x * v.y + up.x * v.z + pos.x * v.w;
+		out.y = right.y * v.x + front.y * v.y + up.y * v.z + pos.y * v.w;
+		out.z = right.z * v.x + front.z * v.y + up.z * v.z + pos.z * v.w;
+		out.w = right.w * v.x + front.w * v.y + up.w * v.z + pos.w * v.w;
+#endif
+		return out;
+	}
+	CVector TransformPoint(const CVector& v) const { return Transform(CVector4(v, 1.f)).ToVector(); }
+
+	// this applied after other
+	CMatrix4 operator*(const CMatrix4& other) const
+	{
+		CMatrix4 out;
+		out.right = Transform(other.right);
+		out.front = Transform(other.front);
+		out.up = Transform(other.up);
+		out.pos = Transform(other.pos);
+		return out;
+	}
+};
+
+namespace math
+{
+#ifdef MATH_NEON
+	// four points held as x, y and z lanes, through the rotation and translation of m
+	static inline void Transform4(const CMatrix& m, float32x4_t x, float32x4_t y, float32x4_t z,
+		float32x4_t& outX, float32x4_t& outY, float32x4_t& outZ)
+	{
+		outX = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m.px), x, m.rx), y, m.fx), z, m.ux);
+		outY = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m.py), x, m.ry), y, m.fy), z, m.uy);
+		outZ = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m.pz), x, m.rz), y, m.fz), z, m.uz);
+	}
+#elif defined(MATH_SSE)
+	static inline __m128 MulAdd(__m128 sum, __m128 v, float scale)
+	{
+		return _mm_add_ps(sum, _mm_mul_ps(v, _mm_set1_ps(scale)));
+	}
+
+	static inline void Transform4(const CMatrix& m, __m128 x, __m128 y, __m128 z, __m128& outX, __m128& outY, __m128& outZ)
+	{
+		outX = MulAdd(MulAdd(MulAdd(_mm_set1_ps(m.px), x, m.rx), y, m.fx), z, m.ux);
+		outY = MulAdd(MulAdd(MulAdd(_mm_set1_ps(m.py), x, m.ry), y, m.fy), z, m.uy);
+		outZ = MulAdd(MulAdd(MulAdd(_mm_set1_ps(m.pz), x, m.rz), y, m.fz), z, m.uz);
+	}
+
+	// SSE has no vld3q; four packed vectors go in and out lane by lane
+	static inline void Load3(const CVector* in, __m128& x, __m128& y, __m128& z)
+	{
+		x = _mm_setr_ps(in[0].x, in[1].x, in[2].x, in[3].x);
+		y = _mm_setr_ps(in[0].y, in[1].y, in[2].y, in[3].y);
+		z = _mm_setr_ps(in[0].z, in[1].z, in[2].z, in[3].z);
+	}
+
+	static inline void Store3(CVector* out, __m128 x, __m128 y, __m128 z)
+	{
+		alignas(16) float lanes[3][4];
+		_mm_store_ps(lanes[0], x);
+		_mm_store_ps(lanes[1], y);
+		_mm_store_ps(lanes[2], z);
+		for(int i = 0; i < 4; i++) {
+			out[i] = CVector(lanes[0][i], lanes[1][i], lanes[2][i]);
+		}
+	}
+#endif
+
+	// Batches, four at a time with NEON or SSE. In and out may be the same arrays.
+	// points as separate x, y, z arrays
+	void TransformPoints(const CMatrix& m, const float* x, const float* y, const float* z, int count,
+		float* outX, float* outY, float* outZ);
+	// packed CVector arrays, as the game and the sync structs keep them
+	void TransformPoints(const CMatrix& m, const CVector* in, int count, CVector* out);
+	// squared 3D distance from origin to each point, for culling against a squared radius
+	void DistancesSquared(const CVector& origin, const CVector* in, int count, float* out);
+}
@@ -9,71 +9,71 @@ public:
     float y;
     float z;
 public:
-    CVector() { x = y = z = 0; }
-    CVector(float fx, float fy, float fz) {
-        x = fx; y = fy; z = fz;
-    }
-    CVector operator=(CVector vec) {
-        x = vec.x; y = vec.y; z = vec.z;
-        return CVector(x, y, z);
-    }
-    CVector operator+(CVector vec) const {
+    CVector() : x(0), y(0), z(0) {}
+    CVector(float fx, float fy, float fz) : x(fx), y(fy), z(fz) {}
+    // trivially copyable, so arrays of these can be memcpy'd and loaded with vld3q
+    CVector(const CVector&) = default;
+    CVector& operator=(const CVector&) = default;
+    CVector operator+(const CVector& vec) const {
         return CVector(x + vec.x, y + vec.y, z + vec.z);
     }
     CVector operator+(float val) const {
         return CVector(x + val, y + val, z + val);
     }
-    CVector operator-(CVector vec) const {
+    CVector operator-(const CVector& vec) const {
         return CVector(x - vec.x, y - vec.y, z - vec.z);
     }
     CVector operator-(float val) const {
         return CVector(x - val, y - val, z - val);
     }
-    CVector operator*(CVector vec) const {
+    CVector operator*(const CVector& vec) const {
         return CVector(x * vec.x, y * vec.y, z * vec.z);
     }
     CVector operator*(float val) const {
         return CVector(x * val, y * val, z * val);
     }
-    CVector operator/(CVector vec) const {
+    CVector operator/(const CVector& vec) const {
         return CVector(x / vec.x, y / vec.y, z / vec.z);
     }
     CVector operator/(float val) const {
         return CVector(x / val, y / val, z / val);
     }
-    CVector operator+=(CVector vec) {
+    CVector& operator+=(const CVector& vec) {
         x += vec.x; y += vec.y; z += vec.z;
-        return CVector(x, y, z);
+        return *this;
     }
-    CVector operator+=(float val) {
+    CVector& operator+=(float val) {
         x += val; y += val; z += val;
-        return CVector(x, y, z);
+        return *this;
     }
-    CVector operator-=(CVector vec) {
+    CVector& operator-=(const CVector& vec) {
         x -= vec.x; y -= vec.y; z -= vec.z;
-        return CVector(x, y, z);
+        return *this;
     }
-    CVector operator-=(float val) {
+    CVector& operator-=(float val) {
         x -= val; y -= val; z -= val;
-        return CVector(x, y, z);
+        return *this;
     }
-    CVector operator*=(CVector vec) {
+    CVector& operator*=(const CVector& vec) {
         x *= vec.x; y *= vec.y; z *= vec.z;
-        return CVector(x, y, z);
+        return *this;
     }
-    CVector operator*=(float val) {
+    CVector& operator*=(float val) {
         x *= val; y *= val; z *= val;
-        return CVector(x, y, z);
+        return *this;
     }
-    CVector operator/=(CVector vec) {
+    CVector& operator/=(const CVector& vec) {
         x /= vec.x; y /= vec.y; z /= vec.z;
-        return CVector(x, y, z);
+        return *this;
     }
-    CVector operator/=(float val) {
+    CVector& operator/=(float val) {
         x /= val; y /= val; z /= val;
-        return CVector(x, y, z);
+        return *this;
     }
-    const float length() const {
+    float length() const {
         return sqrtf(x * x + y * y + z * z);
     }
+    float lengthSquared() const {
+        return x * x + y * y + z * z;
+    }
 };
@@ -9,6 +9,6 @@ namespace rw
 {
 	void Initialise()
 	{
-		RsGlobal = (RsGlobalType*)(CGameAPI::GetBase(xorstr("RsGlobal")));
+		RsGlobal = (RsGlobalType*)(CGameAPI::GetBase(OFFSET("RsGlobal")));
 	}
 }
@@ -0,0 +1,248 @@
+#include "dialog.h"
+#include "gui.h"
+#include "xorstr.h"
+
+#include <string.h>
+
+#include "plugin.h"
+#include "scheduler.h"
+#include "plugin/framearena.h"
+#include "plugin/netgame.h"
+
+std::unique_ptr<CNativeDialog::stDialog> CNativeDialog::m_pCurrent;
+int CNativeDialog::m_nSelected = 0;
+bool CNativeDialog::m_bAnswered = false;
+
+// {RRGGBB} switches colour, the way SA-MP dialogs and chat do it
+static void TextWithColors(const char* begin, const char* end)
+{
+	ImU32 color = ImGui::GetColorU32(ImGuiCol_Text);
+	bool first = true;
+	const char* segment = begin;
+	auto flush = [&](const char* to) {
+		if(to == segment) {
+			return;
+		}
+		if(!first) {
+			ImGui::SameLine(0.f, 0.f);
+		}
+		ImGui::PushStyleColor(ImGuiCol_Text, color);
+		ImGui::TextUnformatted(segment, to);
+		ImGui::PopStyleColor();
+		first = false;
+	};
+	for(const char* p = begin; p < end; p++)
+	{
+		if(*p != '{' || end - p < 8 || p[7] != '}') {
+			continue;
+		}
+		char hex[7];
+		memcpy(hex, p + 1, 6);
+		hex[6] = 0;
+		char* parsed;
+		unsigned long rgb = strtoul(hex, &parsed, 16);
+		if(parsed != hex + 6) {
+			continue;
+		}
+		flush(p);
+		color = IM_COL32((rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF, 255);
+		segment = p + 8;
+		p += 7;
+	}
+	flush(end);
+	if(first) {
+		// keep the line's height even when it was only colour codes
+		ImGui::NewLine();
+	}
+}
+
+// lines with colour tags are drawn in segments, which ImGui cannot wrap as one
+static bool Wraps(const char* begin, const char* end)
+{
+	return !memchr(begin, '{', end - begin);
+}
+
+static const char* FindTab(const char* begin, const char* end)
+{
+	const char* tab = (const char*)memchr(begin, '\t', end - begin);
+	return tab ? tab : end;
+}
+
+void CNativeDialog::DrawRow(const stDialog& dialog, int row)
+{
+	const char* text = dialog.info.c_str();
+	const char* begin = text + dialog.rowStart[row];
+	const char* end = text + dialog.rowEnd[row];
+	for(int column = 0; column < dialog.columns; column++)
+	{
+		ImGui::TableSetColumnIndex(column);
+		const char* cell = column + 1 < dialog.columns ? FindTab(begin, end) : end;
+		TextWithColors(begin, cell);
+		begin = cell < end ? cell + 1 : end;
+	}
+}
+
+void CNativeDialog::DrawList(const stDialog& dialog)
+{
+	// the header row of TABLIST_HEADERS is not an item
+	int first = dialog.style == STYLE_TABLIST_HEADERS ? 1 : 0;
+	int items = (int)dialog.rowStart.size() - first;
+	ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp;
+	float height = -ImGui::GetFrameHeightWithSpacing() - ImGui::GetStyle().ItemSpacing.y;
+	if(!ImGui::BeginTable(xorstr("##rows"), dialog.columns, flags, ImVec2(0.f, height))) {
+		return;
+	}
+	ImGui::TableSetupScrollFreeze(0, first);
+	if(first)
+	{
+		ImGui::TableNextRow(ImGuiTableRowFlags_Headers);
+		DrawRow(dialog, 0);
+	}
+
+	CGUI::DrawRows(items, [&](int item) {
+		ImGui::TableNextRow();
+		ImGui::TableSetColumnIndex(0);
+		ImGui::PushID(item);
+		ImVec2 cursor = ImGui::GetCursorPos();
+		if(ImGui::Selectable(xorstr("##item"), m_nSelected == item,
+			ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowOverlap | ImGuiSelectableFlags_AllowDoubleClick)) {
+			m_nSelected = item;
+			if(ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+				// the dialog stays alive until Draw is done, the rest of the rows still draw
+				Respond(1);
+			}
+		}
+		ImGui::SetCursorPos(cursor);
+		DrawRow(dialog, item + first);
+		ImGui::PopID();
+	});
+	ImGui::EndTable();
+}
+
+void CNativeDialog::DrawText(stDialog& dialog)
+{
+	const char* text = dialog.info.c_str();
+	int rows = (int)dialog.rowStart.size();
+	float width = ImGui::GetContentRegionAvail().x;
+	if(dialog.heightsWidth != width)
+	{
+		// once per dialog and width, then scrolling only touches the lines in view
+		float spacing = ImGui::GetStyle().ItemSpacing.y;
+		dialog.heights.Clear();
+		for(int row = 0; row < rows; row++)
+		{
+			const char* begin = text + dialog.rowStart[row];
+			const char* end = text + dialog.rowEnd[row];
+			float height = Wraps(begin, end) ? ImGui::CalcTextSize(begin, end, false, width).y : ImGui::GetTextLineHeight();
+			dialog.heights.Add(height + spacing);
+		}
+		dialog.heightsWidth = width;
+	}
+
+	ImGui::PushTextWrapPos(0.f);
+	CGUI::DrawRows(dialog.heights, [&](int row) {
+		const char* begin = text + dialog.rowStart[row];
+		const char* end = text + dialog.rowEnd[row];
+		if(Wraps(begin, end)) {
+			ImGui::TextUnformatted(begin, end);
+		} else {
+			TextWithColors(begin, end);
+		}
+	});
+	ImGui::PopTextWrapPos();
+}
+
+void CNativeDialog::Respond(int button)
+{
+	const stDialog& dialog = *m_pCurrent;
+	bool list = dialog.style == STYLE_LIST || dialog.style == STYLE_TABLIST || dialog.style == STYLE_TABLIST_HEADERS;
+	int32_t listItem = list ? m_nSelected : -1;
+
+	// a list answers with the first column of the row, in the server's encoding
+	std::string input;
+	if(list)
+	{
+		int row = m_nSelected + (dialog.style == STYLE_TABLIST_HEADERS ? 1 : 0);
+		if(row < (int)dialog.rowStart.size()) {
+			const char* begin = dialog.info.c_str() + dialog.rowStart[row];
+			const char* end = FindTab(begin, dialog.info.c_str() + dialog.rowEnd[row]);
+			char cp1251[256];
+			uint32_t len = utf8_to_cp1251(cp1251, sizeof(cp1251), begin, (uint32_t)(end - begin));
+			input.assign(cp1251, len);
+		}
+	}
+
+	// sent from the game thread, like every other RPC
+	CFrameScheduler::Post([button, listItem, input] {
+		CNetGame::SendDialogResponse(button, listItem, input.data(), (uint8_t)input.size());
+	});
+	// Draw drops the dialog once it is done with it
+	m_bAnswered = true;
+}
+
+bool CNativeDialog::IsActive()
+{
+	if(m_pCurrent) {
+		return true;
+	}
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_pPending != nullptr;
+}
+
+void CNativeDialog::Draw()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if(m_pPending) {
+			m_pCurrent = std::move(m_pPending);
+			m_nSelected = 0;
+		} else if(m_bHidePending) {
+			m_pCurrent.reset();
+		}
+		m_bHidePending = false;
+	}
+	if(!m_pCurrent) {
+		return;
+	}
+
+	stDialog& dialog = *m_pCurrent;
+	m_bAnswered = false;
+	ImGuiIO& io = ImGui::GetIO();
+	ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x * 0.5f, io.DisplaySize.y * 0.5f), ImGuiCond_Always, ImVec2(0.5f, 0.5f));
+	ImGui::SetNextWindowSize(ImVec2(io.DisplaySize.x * 0.6f, io.DisplaySize.y * 0.7f), ImGuiCond_Always);
+	// the id stays put while the title changes, so a new dialog reuses the window
+	const char* title = CFrameArena::Overlay().Format(xorstr_cached("%s###nativedialog"), dialog.title.c_str());
+	if(ImGui::Begin(title ? title : xorstr_cached("###nativedialog"), nullptr, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoSavedSettings))
+	{
+		if(dialog.style == STYLE_MSGBOX)
+		{
+			float height = -ImGui::GetFrameHeightWithSpacing() - ImGui::GetStyle().ItemSpacing.y;
+			ImGui::BeginChild(xorstr("##text"), ImVec2(0.f, height));
+			DrawText(dialog);
+			ImGui::EndChild();
+		}
+		else
+		{
+			DrawList(dialog);
+		}
+
+		if(!m_bAnswered)
+		{
+			ImGui::Separator();
+			float width = ImGui::GetContentRegionAvail().x;
+			float buttonWidth = dialog.button2.empty() ? width : (width - ImGui::GetStyle().ItemSpacing.x) * 0.5f;
+			if(CGUI::Button(dialog.button1.c_str(), ImVec2(buttonWidth, 0.f))) {
+				Respond(1);
+			} else if(!dialog.button2.empty()) {
+				ImGui::SameLine();
+				if(CGUI::Button(dialog.button2.c_str(), ImVec2(buttonWidth, 0.f))) {
+					Respond(0);
+				}
+			}
+		}
+	}
+	ImGui::End();
+	if(m_bAnswered) {
+		m_pCurrent.reset();
+	}
+}
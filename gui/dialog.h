@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gui.h"
+
+// SA-MP dialogs drawn by the overlay instead of the game's Java UI, with FEATURE_NATIVE_DIALOGS
+// on. The RPC_ScrDialogBox payload is parsed on the game thread and handed to the GL thread;
+// lists and long texts only lay out the rows on screen (CGUI::DrawRows), and the answer goes out as
+// RPC_DialogResponse without the JSON round trip. Input and password dialogs need the soft
+// keyboard, which only the game's UI can raise, so those still go to the game.
+class CNativeDialog
+{
+public:
+	enum eStyle
+	{
+		STYLE_MSGBOX = 0,
+		STYLE_INPUT = 1,
+		STYLE_LIST = 2,
+		STYLE_PASSWORD = 3,
+		STYLE_TABLIST = 4,
+		STYLE_TABLIST_HEADERS = 5,
+	};
+
+	// game thread, from FixBrokenRPC; true when the dialog is ours and the game must not see it.
+	// In dialogbox.cpp, apart from the drawing, so netbench runs it without ImGui
+	static bool OnDialogBox(const unsigned char* data, uint32_t size);
+	// GL thread, inside the ImGui frame
+	static void Draw();
+	// GL thread; a dialog is up or waiting for the next Draw
+	static bool IsActive();
+
+private:
+	struct stDialog
+	{
+		int16_t id;
+		uint8_t style;
+		// UTF-8
+		std::string title;
+		std::string button1;
+		std::string button2;
+		std::string info;
+		// [begin, end) of every line of info
+		std::vector<uint32_t> rowStart;
+		std::vector<uint32_t> rowEnd;
+		int columns;
+		// message box lines wrap, measured at heightsWidth
+		CGUI::stRowIndex heights;
+		float heightsWidth;
+	};
+
+	static void Respond(int button);
+	static void DrawRow(const stDialog& dialog, int row);
+	static void DrawList(const stDialog& dialog);
+	static void DrawText(stDialog& dialog);
+
+	static std::mutex m_mutex;
+	// the next dialog, or a hide when hidePending; swapped in by Draw
+	static std::unique_ptr<stDialog> m_pPending;
+	static bool m_bHidePending;
+
+	// GL thread only
+	static std::unique_ptr<stDialog> m_pCurrent;
+	static int m_nSelected;
+	// set by Respond, the dialog is dropped at the end of Draw
+	static bool m_bAnswered;
+};
@@ -0,0 +1,92 @@
+#include "dialog.h"
+
+#include <string.h>
+
+#include "featureflags.h"
+#include "plugin.h"
+#include "vendor/RakNet/BitStream.h"
+#include "vendor/RakNet/StringCompressor.h"
+
+std::mutex CNativeDialog::m_mutex;
+std::unique_ptr<CNativeDialog::stDialog> CNativeDialog::m_pPending;
+bool CNativeDialog::m_bHidePending = false;
+
+// what SA-MP allows for the info text
+static constexpr int MAX_INFO = 4096;
+// SA-MP tablists have at most four columns
+static constexpr int MAX_COLUMNS = 4;
+
+static bool ReadString8(RakNet::BitStream* bs, std::string* out)
+{
+	uint8_t len;
+	char text[256];
+	if(!bs->Read(len) || !bs->Read(text, len)) {
+		return false;
+	}
+	char utf8[256 * 3 + 1];
+	uint32_t written = cp1251_to_utf8(utf8, sizeof(utf8), text, len);
+	out->assign(utf8, written);
+	return true;
+}
+
+bool CNativeDialog::OnDialogBox(const unsigned char* data, uint32_t size)
+{
+	if(!CFeatures::IsEnabled(FEATURE_NATIVE_DIALOGS)) {
+		return false;
+	}
+
+	RakNet::BitStream bs((unsigned char*)data, size, false);
+	int16_t id;
+	uint8_t style;
+	if(!bs.Read(id) || !bs.Read(style)) {
+		return false;
+	}
+	if(id < 0 || style == STYLE_INPUT || style == STYLE_PASSWORD || style > STYLE_TABLIST_HEADERS) {
+		// a hide, or a dialog the game draws: either way ours goes away, and the game
+		// still gets the RPC
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pPending.reset();
+		m_bHidePending = true;
+		return false;
+	}
+
+	std::unique_ptr<stDialog> dialog(new stDialog());
+	dialog->id = id;
+	dialog->heightsWidth = -1.f;
+	dialog->style = style;
+	static char info[MAX_INFO];
+	if(!ReadString8(&bs, &dialog->title) || !ReadString8(&bs, &dialog->button1) || !ReadString8(&bs, &dialog->button2)
+	|| !stringCompressor->DecodeString(info, MAX_INFO, &bs)) {
+		return false;
+	}
+	std::vector<char> utf8(strlen(info) * 3 + 1);
+	dialog->info.assign(utf8.data(), cp1251_to_utf8(utf8.data(), (uint32_t)utf8.size(), info));
+
+	// one row per line, lists and message boxes alike
+	dialog->columns = 1;
+	const char* text = dialog->info.c_str();
+	uint32_t start = 0, len = (uint32_t)dialog->info.size();
+	int tabs = 0;
+	for(uint32_t i = 0; i <= len; i++)
+	{
+		if(i == len || text[i] == '\n') {
+			dialog->rowStart.push_back(start);
+			dialog->rowEnd.push_back(i);
+			if(tabs + 1 > dialog->columns) {
+				dialog->columns = tabs + 1 > MAX_COLUMNS ? MAX_COLUMNS : tabs + 1;
+			}
+			start = i + 1;
+			tabs = 0;
+		} else if(text[i] == '\t') {
+			tabs++;
+		}
+	}
+	if(style == STYLE_LIST) {
+		dialog->columns = 1;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_pPending = std::move(dialog);
+	m_bHidePending = false;
+	return true;
+}
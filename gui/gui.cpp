@@ -1,25 +1,44 @@
 #include "gui.h"
+#include "textcache.h"
+#include "sdffont.h"
 #include "xorstr.h"
+#include "workers.h"
+
+#include <algorithm>
+#include <climits>
+#include <android/log.h>
+#include <GLES3/gl3.h>
 
 #include "game/rw/rw.h"
 
-#include "fonts/Lilita.h"
+#include "fonts/SdfAtlas.h"
 #include "fonts/BoxIcons.h"
-#include "fonts/LozungCaps.h"
 
-ImFont* CGUI::m_pDefaultFont;
-ImFont* CGUI::m_pTitleFont;
-ImFont* CGUI::m_pTitleLinkFont;
-ImFont* CGUI::m_pButtonsFont;
+#include "vendor/imgui/backend/imgui_impl_opengl3.h"
+
+CGUI::stFont CGUI::m_fonts[FONT_COUNT] = {
+	{ nullptr, 20.f, 0.f },		// FONT_DEFAULT
+	{ nullptr, 26.f, 0.f },		// FONT_TITLE
+	{ nullptr, 25.f, 0.f },		// FONT_TITLE_LINK
+	{ nullptr, 22.5f, 0.f },	// FONT_BUTTONS
+	{ nullptr, 20.f, 0.f },		// FONT_ICONS
+};
+int CGUI::m_nFontScreenHeight = 0;
+bool CGUI::m_bFontsRequested = false;
+bool CGUI::m_bSdfFonts = false;
+std::atomic<ImFontAtlas*> CGUI::m_pFontAtlas(nullptr);
 
-ImFont* CGUI::m_pDefaultIconsFont;
+ImGuiStyle CGUI::m_baseStyle;
+int CGUI::m_nBaseStyleHeight = 1;
+int CGUI::m_nDisplayWidth = 0;
+int CGUI::m_nDisplayHeight = 0;
 
-float CGUI::m_fDefaultFontSize;
-float CGUI::m_fTitleFontSize;
-float CGUI::m_fTitleLinkFontSize;
-float CGUI::m_fButtonsFontSize;
+CGUI::stButtonTheme CGUI::m_litTheme;
+CGUI::stButtonTheme CGUI::m_flatThemes[ImGuiCol_COUNT];
 
 ImWchar ranges[] = { 0xe900, 0xEF61, 0 };
+// atlas rows reserved for icons, about 80 at the bake size on the 512 texel wide atlas
+static const int ICON_ATLAS_ROWS = 256;
 
 
 const char* CGUI::m_szVersionText = "Black Russia Client by github.com/kuzia15";
@@ -28,27 +47,63 @@ ImU32 CGUI::m_uVersionColor = IM_COL32(255, 255, 255, 255);
 ImU32 CGUI::m_uVersionShadowColor = IM_COL32(0, 0, 0, 180);
 float CGUI::m_fVersionFontScale = 1.0f;
 
-char* CGUI::buffGUI = new char[4096];
+std::atomic<uint64_t> CGUI::m_hitRegions[CGUI::MAX_HIT_REGIONS];
+std::atomic<int> CGUI::m_nHitRegions(0);
 
-void CGUI::Initialise()
+void CGUI::LoadFonts(ImFontAtlas* atlas)
 {
-	ImGuiIO& io = ImGui::GetIO();
-	
-	m_fDefaultFontSize = (RsGlobal->maximumHeight / 640.f) * 20.f;
-	m_fTitleFontSize = (RsGlobal->maximumHeight / 640.f) * 26.f;
-	m_fTitleLinkFontSize = (RsGlobal->maximumHeight / 640.f) * 25.f;
-	m_fButtonsFontSize = (RsGlobal->maximumHeight / 640.f) * 22.5f;
+	// the icon offset below is for the startup size
+	UpdateFontSizes();
 	
-	m_pDefaultFont = io.Fonts->AddFontFromMemoryTTF(Font::Lilita, sizeof(Font::Lilita), m_fDefaultFontSize, NULL, io.Fonts->GetGlyphRangesCyrillic());
-	
-	m_pTitleFont = io.Fonts->AddFontFromMemoryTTF(Font::LozungCaps, sizeof(Font::LozungCaps), m_fTitleFontSize, NULL, io.Fonts->GetGlyphRangesCyrillic());
-	m_pTitleLinkFont = io.Fonts->AddFontFromMemoryTTF(Font::Lilita, sizeof(Font::Lilita), m_fTitleLinkFontSize, NULL, io.Fonts->GetGlyphRangesCyrillic());
-	m_pButtonsFont = io.Fonts->AddFontFromMemoryTTF(Font::Lilita, sizeof(Font::Lilita), m_fButtonsFontSize, NULL, io.Fonts->GetGlyphRangesCyrillic());
-	
-	ImFontConfig config;
-	config.MergeMode = true;
-	config.GlyphOffset = ImVec2(0, 4);
-	m_pDefaultIconsFont = io.Fonts->AddFontFromMemoryTTF(Font::BoxIcons, sizeof(Font::BoxIcons), m_fDefaultFontSize, &config, ranges);
+	// Lilita and LozungCaps come prebaked as distance fields (tools/fontbake); every Lilita size
+	// shares one font and PushFont picks the scale
+	ImFont* fonts[2];
+	ImFont* defaultFont;
+	ImFont* titleFont;
+	if(sdffont::Load(atlas, Font::SdfAtlas, sizeof(Font::SdfAtlas), fonts, IM_ARRAYSIZE(fonts), ICON_ATLAS_ROWS) == IM_ARRAYSIZE(fonts)) {
+		defaultFont = fonts[0];
+		titleFont = fonts[1];
+		m_bSdfFonts = true;
+		// icons are only rasterised once something draws them; the offset is for the startup
+		// size, a resolution change leaves it a pixel or so off
+		sdffont::AddLazyFont(defaultFont, Font::BoxIcons, sizeof(Font::BoxIcons), Font::BoxIconsSize, ranges, ImVec2(0, 4.f * defaultFont->FontSize / GetFontSize(FONT_DEFAULT)));
+	} else {
+		__android_log_print(ANDROID_LOG_ERROR, xorstr("GUI"), xorstr("Prebaked font atlas is unusable, rebuild it with tools/fontbake"));
+		atlas->Clear();
+		defaultFont = atlas->AddFontDefault();
+		titleFont = defaultFont;
+	}
+	m_fonts[FONT_DEFAULT].font = defaultFont;
+	m_fonts[FONT_TITLE].font = titleFont;
+	m_fonts[FONT_TITLE_LINK].font = defaultFont;
+	m_fonts[FONT_BUTTONS].font = defaultFont;
+	m_fonts[FONT_ICONS].font = defaultFont;
+}
+
+ImFontAtlas* CGUI::PrepareFonts()
+{
+	if(!m_bFontsRequested) {
+		m_bFontsRequested = true;
+		CWorkers::Submit([] {
+			// ImGui's allocator only touches the context, and there is none yet
+			ImFontAtlas* atlas = IM_NEW(ImFontAtlas)();
+			LoadFonts(atlas);
+			m_pFontAtlas.store(atlas, std::memory_order_release);
+		});
+	}
+	return m_pFontAtlas.load(std::memory_order_acquire);
+}
+
+void CGUI::Initialise()
+{
+	if(m_bSdfFonts) {
+		ImGui_ImplOpenGL3_SetSdfFontAtlas(true);
+		int blocksSize;
+		if(const void* blocks = sdffont::GetCompressedTexture(&blocksSize)) {
+			ImGui_ImplOpenGL3_SetCompressedFontsTexture(GL_COMPRESSED_R11_EAC, blocks, blocksSize);
+		}
+	}
+	UpdateFontSizes();
 	
 	ImGuiStyle& style = ImGui::GetStyle();
 
@@ -98,44 +153,257 @@ void CGUI::Initialise()
     style.Colors[ImGuiCol_PlotHistogram] = ImVec4(0.00, 0.69, 0.33, 1.00);
     style.Colors[ImGuiCol_PlotHistogramHovered] = ImVec4(0.00, 0.80, 0.38, 1.00);
     style.Colors[ImGuiCol_TextSelectedBg] = ImVec4(0.00, 0.69, 0.33, 0.72);
+
+	UpdateButtonThemes();
+	// every later size change rescales from this
+	m_baseStyle = style;
+	m_nBaseStyleHeight = RsGlobal->height > 0 ? RsGlobal->height : 1;
+	m_nDisplayWidth = RsGlobal->width;
+	m_nDisplayHeight = RsGlobal->height;
 }
 
+void CGUI::UpdateDisplay(ImGuiIO& io)
+{
+	if(RsGlobal->width == m_nDisplayWidth && RsGlobal->height == m_nDisplayHeight
+	&& RsGlobal->maximumHeight == m_nFontScreenHeight) {
+		return;
+	}
+	io.DisplaySize = ImVec2((float)RsGlobal->width, (float)RsGlobal->height);
+	if(m_nDisplayHeight > 0 && RsGlobal->height > 0 && RsGlobal->height != m_nDisplayHeight)
+	{
+		// from the startup style each time, so repeated rotations don't compound rounding
+		float scale = (float)RsGlobal->height / m_nBaseStyleHeight;
+		ImGui::GetStyle() = m_baseStyle;
+		ImGui::GetStyle().ScaleAllSizes(scale);
+	}
+	m_nDisplayWidth = RsGlobal->width;
+	m_nDisplayHeight = RsGlobal->height;
+	UpdateFontSizes();
+}
+
+#include "featureflags.h"
+#include "bindings.h"
+#include "worldlabels.h"
+#include "dialog.h"
+#include "hook.h"
 #include "plugin/netgame.h"
+#include "plugin/pools/playernames.h"
+#include "plugin/alloctracker.h"
+#include "plugin/frameprofiler.h"
+#include "plugin/netstats.h"
+#include "plugin/sampleprofiler.h"
+#include "plugin/startuptimeline.h"
 
 void CGUI::DrawMenu()
 {
 	// Отрисовка версии
-    ImDrawList* drawList = ImGui::GetBackgroundDrawList();
-    ImFont* font = m_pDefaultFont; // Используем основной шрифт
-    
-    if (font) {
-        // Рассчитываем размер текста
-        float fontSize = font->FontSize * m_fVersionFontScale;
-        ImVec2 textSize = font->CalcTextSizeA(fontSize, FLT_MAX, 0.0f, m_szVersionText);
-        
-        // Тень (3 варианта смещения для лучшей читаемости)
-        const ImVec2 shadowOffsets[] = {{1,1}, {-1,1}, {0,-1}};
-        for (const auto& offset : shadowOffsets) {
-            drawList->AddText(
-                font,
-                fontSize,
-                ImVec2(m_vVersionPos.x + offset.x, m_vVersionPos.y + offset.y),
-                m_uVersionShadowColor,
-                m_szVersionText);
-        }
-        
-        // Основной текст
-        drawList->AddText(
-            font,
-            fontSize,
-            m_vVersionPos,
-            m_uVersionColor,
-            m_szVersionText);
-    }
+	static CCachedText versionText;
+	// Тень (3 варианта смещения для лучшей читаемости)
+	static const ImVec2 shadowOffsets[] = {{1,1}, {-1,1}, {0,-1}};
+	ImFont* font = GetFont(FONT_DEFAULT); // Используем основной шрифт
+	if (font) {
+		versionText.Draw(ImGui::GetBackgroundDrawList(), font, GetFontSize(FONT_DEFAULT) * m_fVersionFontScale,
+			m_vVersionPos, m_uVersionColor, m_uVersionShadowColor, shadowOffsets, IM_ARRAYSIZE(shadowOffsets), m_szVersionText);
+	}
 }
 
-void CGUI::Render() {
+static void DrawFeaturePanel()
+{
+	if(!CFeatures::IsEnabled(FEATURE_PANEL)) {
+		return;
+	}
+
+	bool open = true;
+	ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
+	if(ImGui::Begin(xorstr("Features"), &open, ImGuiWindowFlags_AlwaysAutoResize))
+	{
+		for(int i = 0; i < FEATURE_COUNT; i++)
+		{
+			if(i == FEATURE_PANEL) {
+				continue;
+			}
+			bool enabled = CFeatures::IsEnabled((eFeature)i);
+			if(ImGui::Checkbox(CFeatures::GetName((eFeature)i), &enabled)) {
+				CFeatures::Set((eFeature)i, enabled);
+			}
+		}
+		CStartupTimeline::Draw();
+	}
+	ImGui::End();
+	if(!open) {
+		CFeatures::Set(FEATURE_PANEL, false);
+	}
+}
+
+static void DrawPlayerRow(uint16_t id, const char* name, int score, uint32_t ping)
+{
+	ImGui::TableNextRow();
+	ImGui::TableNextColumn();
+	ImGui::Text(xorstr_cached("%u"), id);
+	ImGui::TableNextColumn();
+	ImGui::TextUnformatted(name);
+	ImGui::TableNextColumn();
+	ImGui::Text(xorstr_cached("%d"), score);
+	ImGui::TableNextColumn();
+	ImGui::Text(xorstr_cached("%u"), ping);
+}
+
+static void DrawPlayerList()
+{
+	if(!CFeatures::IsEnabled(FEATURE_PLAYER_LIST)) {
+		return;
+	}
 	CPlayerPool* pool = CNetGame::GetPlayerPool();
+	CLocalPlayer* local = pool ? pool->GetLocalPlayer() : nullptr;
+	if(!local) {
+		return;
+	}
+
+	bool open = true;
+	ImGuiIO& io = ImGui::GetIO();
+	ImGui::SetNextWindowSize(ImVec2(io.DisplaySize.x * 0.4f, io.DisplaySize.y * 0.6f), ImGuiCond_FirstUseEver);
+	if(ImGui::Begin(xorstr("Players"), &open))
+	{
+		static char search[CPlayerNames::NAME_BYTES];
+		ImGui::SetNextItemWidth(-FLT_MIN);
+		ImGui::InputTextWithHint(xorstr("##search"), xorstr("search"), search, sizeof(search));
+		const uint16_t* ids = CPlayerPool::GetActiveIds();
+		int count = CPlayerPool::GetActiveCount();
+		if(search[0]) {
+			static uint16_t matches[MAX_PLAYERS];
+			count = (int)CPlayerNames::FindPrefix(search, matches, MAX_PLAYERS);
+			ids = matches;
+		}
+		ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp;
+		if(ImGui::BeginTable(xorstr("##players"), 4, flags))
+		{
+			ImGui::TableSetupScrollFreeze(0, 2);
+			ImGui::TableSetupColumn(xorstr("id"));
+			ImGui::TableSetupColumn(xorstr("name"), ImGuiTableColumnFlags_WidthStretch, 4.f);
+			ImGui::TableSetupColumn(xorstr("score"));
+			ImGui::TableSetupColumn(xorstr("ping"));
+			ImGui::TableHeadersRow();
+			// ourselves on top, under the header
+			DrawPlayerRow(local->GetLocalPlayerID(), (const char*)local->GetLocalPlayerName(), pool->m_iLocalPlayerScore, pool->m_dwLocalPlayerPing);
+			CGUI::DrawRows(count, [&](int i) {
+				uint16_t id = ids[i];
+				CRemotePlayer* player = pool->GetAt(id);
+				if(!player) {
+					// keeps the clipper's row count right
+					DrawPlayerRow(id, "", 0, 0);
+					return;
+				}
+				DrawPlayerRow(id, CPlayerNames::Get(id), pool->m_iPlayerScores[id], pool->m_dwPlayerPings[id]);
+			});
+			ImGui::EndTable();
+		}
+	}
+	ImGui::End();
+	if(!open) {
+		CFeatures::Set(FEATURE_PLAYER_LIST, false);
+	}
+}
+
+static void DrawHookList()
+{
+	bool shown = CFeatures::IsEnabled(FEATURE_HOOKS);
+	// a clock read per hooked call only while someone looks at the numbers
+	if(CHook::IsTiming() != shown) {
+		CHook::SetTiming(shown);
+	}
+	if(!shown) {
+		return;
+	}
+
+	bool open = true;
+	ImGui::SetNextWindowSize(ImVec2(720, 480), ImGuiCond_FirstUseEver);
+	if(ImGui::Begin(xorstr("Hooks"), &open))
+	{
+		ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp;
+		if(ImGui::BeginTable(xorstr("##hooks"), 5, flags))
+		{
+			ImGui::TableSetupColumn(xorstr("hook"), ImGuiTableColumnFlags_WidthStretch, 3.f);
+			ImGui::TableSetupColumn(xorstr("calls"));
+			ImGui::TableSetupColumn(xorstr("us/call"));
+			ImGui::TableSetupColumn(xorstr("total ms"));
+			ImGui::TableSetupColumn(xorstr("on"));
+			ImGui::TableHeadersRow();
+			for(int i = 0; i < HOOK_TARGET_COUNT; i++)
+			{
+				eHookTarget target = (eHookTarget)i;
+				const stHookRecord& record = CHook::GetRecord(target);
+				uint32_t calls = record.calls.load(std::memory_order_relaxed);
+				uint64_t ns = record.ns.load(std::memory_order_relaxed);
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(CHook::GetName(target));
+				if(ImGui::IsItemHovered()) {
+					ImGui::SetTooltip(xorstr_cached("%s at %p, original %p"), record.installed ? "installed" : "not installed", record.address, record.orig);
+				}
+				ImGui::TableNextColumn();
+				ImGui::Text(xorstr_cached("%u"), calls);
+				ImGui::TableNextColumn();
+				ImGui::Text(xorstr_cached("%.2f"), calls ? ns / 1000.0 / calls : 0.0);
+				ImGui::TableNextColumn();
+				ImGui::Text(xorstr_cached("%.1f"), ns / 1000000.0);
+				ImGui::TableNextColumn();
+				// the overlay is drawn from the swap hook, so that one only goes off from brsamp.json
+				bool fixed = !CHook::CanBypass(target) || target == HOOK_EGL_SWAP_BUFFERS;
+				bool enabled = !CHook::IsBypassed(target);
+				ImGui::PushID(i);
+				ImGui::BeginDisabled(fixed);
+				if(ImGui::Checkbox(xorstr_cached("##on"), &enabled)) {
+					CHook::SetBypassed(target, !enabled);
+				}
+				ImGui::EndDisabled();
+				ImGui::PopID();
+			}
+			ImGui::EndTable();
+		}
+		// time only counts from when the window opened; reset after a toggle to compare
+		if(ImGui::Button(xorstr("Reset counters"))) {
+			CHook::ResetCounters();
+		}
+	}
+	ImGui::End();
+	if(!open) {
+		CFeatures::Set(FEATURE_HOOKS, false);
+	}
+}
+
+bool CGUI::IsWanted()
+{
+	// the windows drawn whenever their feature is on
+	static constexpr uint32_t windowFeatures = 1u << FEATURE_PANEL | 1u << FEATURE_WORLD_LABELS
+		| 1u << FEATURE_PLAYER_LIST | 1u << FEATURE_HOOKS | 1u << FEATURE_PROFILER;
+	if(CFeatures::GetMask() & windowFeatures) {
+		return true;
+	}
+	if(CNetStats::m_bShowOverlay || CFrameProfiler::IsOverlayShown() || CAllocTracker::IsOverlayShown()) {
+		return true;
+	}
+	if(CFeatures::IsEnabled(FEATURE_NATIVE_DIALOGS) && CNativeDialog::IsActive()) {
+		return true;
+	}
+	if(!CFeatures::IsEnabled(FEATURE_COORDS)) {
+		return false;
+	}
+	CPlayerPool* pool = CNetGame::GetPlayerPool();
+	CLocalPlayer* player = pool ? pool->GetLocalPlayer() : nullptr;
+	return player && player->GetPlayerPed();
+}
+
+void CGUI::Render() {
+	CNetStats::DrawOverlay();
+	CFrameProfiler::DrawOverlay();
+	CAllocTracker::DrawOverlay();
+	CSampleProfiler::DrawOverlay();
+	DrawFeaturePanel();
+	DrawPlayerList();
+	DrawHookList();
+	CNativeDialog::Draw();
+
+	CPlayerPool* pool = CFeatures::IsEnabled(FEATURE_COORDS) ? CNetGame::GetPlayerPool() : nullptr;
 	if(pool) {
 		CLocalPlayer* player = pool->GetLocalPlayer();
 		if(player) {
@@ -147,21 +415,24 @@ void CGUI::Render() {
 					angle += 360;
 				}
 				angle = fmod(angle, 360.f);
-				char buff[64] = {0};
-				sprintf(buff, xorstr("(%.2f) %.2f, %.2f, %.2f"), angle, pos.x, pos.y, pos.z);
+
+				// only reformat when the printed (2 decimal) values change
+				static CCachedText coordsText;
+				static char buff[64] = {0};
+				static long lastKey[4] = {LONG_MIN, 0, 0, 0};
+				static float lastWidth = 0.f;
+				long key[4] = { lroundf(angle * 100.f), lroundf(pos.x * 100.f), lroundf(pos.y * 100.f), lroundf(pos.z * 100.f) };
+				if(memcmp(key, lastKey, sizeof(key))) {
+					sprintf(buff, xorstr_cached("(%.2f) %.2f, %.2f, %.2f"), angle, pos.x, pos.y, pos.z);
+					memcpy(lastKey, key, sizeof(key));
+					lastWidth = ImGui::CalcTextSize(buff).x;
+				}
 				ImVec2 screen_pos;
-				screen_pos.x = (RsGlobal->width - ImGui::CalcTextSize(buff).x) / 2.f;
+				screen_pos.x = (RsGlobal->width - lastWidth) / 2.f;
 				screen_pos.y = RsGlobal->height - ImGui::GetFontSize();
 				screen_pos.y -= 2.f;
-				ImGui::GetBackgroundDrawList()->AddText(ImVec2(screen_pos.x - 2.f, screen_pos.y), IM_COL32(0, 0, 0, 255), buff);
-				ImGui::GetBackgroundDrawList()->AddText(ImVec2(screen_pos.x + 2.f, screen_pos.y), IM_COL32(0, 0, 0, 255), buff);
-				ImGui::GetBackgroundDrawList()->AddText(ImVec2(screen_pos.x, screen_pos.y - 2.f), IM_COL32(0, 0, 0, 255), buff);
-				ImGui::GetBackgroundDrawList()->AddText(ImVec2(screen_pos.x, screen_pos.y + 2.f), IM_COL32(0, 0, 0, 255), buff);
-				ImGui::GetBackgroundDrawList()->AddText(ImVec2(screen_pos.x - 2.f, screen_pos.y - 2.f), IM_COL32(0, 0, 0, 255), buff);
-				ImGui::GetBackgroundDrawList()->AddText(ImVec2(screen_pos.x - 2.f, screen_pos.y + 2.f), IM_COL32(0, 0, 0, 255), buff);
-				ImGui::GetBackgroundDrawList()->AddText(ImVec2(screen_pos.x + 2.f, screen_pos.y - 2.f), IM_COL32(0, 0, 0, 255), buff);
-				ImGui::GetBackgroundDrawList()->AddText(ImVec2(screen_pos.x + 2.f, screen_pos.y + 2.f), IM_COL32(0, 0, 0, 255), buff);
-				ImGui::GetBackgroundDrawList()->AddText(ImVec2(screen_pos.x, screen_pos.y), IM_COL32(255, 255, 255, 255), buff);
+				coordsText.DrawOutlined(ImGui::GetBackgroundDrawList(), ImGui::GetFont(), ImGui::GetFontSize(), screen_pos,
+					IM_COL32(255, 255, 255, 255), IM_COL32(0, 0, 0, 255), 2.f, buff);
 			}
 		}
 	}
@@ -169,108 +440,211 @@ void CGUI::Render() {
 
 void CGUI::Render2dStuff()
 {
-	
-}
+	if(!g_Game.m_pViewMatrix) {
+		CWorldLabels::Clear();
+		return;
+	}
 
-bool CGUI::OnTouchEvent(int action, int pointer, int x, int y)
-{
-	ImGuiContext* context = ImGui::GetCurrentContext();
-	if(context) {
-		bool touchOnWindow = false;
-		for(int i = 0; i < context->Windows.size(); i++)
+	if(CFeatures::IsEnabled(FEATURE_WORLD_LABELS))
+	{
+		CPlayerPool* pool = CNetGame::GetPlayerPool();
+		if(pool)
 		{
-			ImGuiWindow* window = context->Windows[i];
-			if(window->Active)
+			const uint16_t* ids = CPlayerPool::GetActiveIds();
+			for(uint16_t i = 0; i < CPlayerPool::GetActiveCount(); i++)
 			{
-				if(x > window->Pos.x && y > window->Pos.y
-				&& x < (window->Pos.x + window->Size.x) && y < (window->Pos.y + window->Size.y))
-				{
-					touchOnWindow = true;
+				CRemotePlayer* player = pool->GetAt(ids[i]);
+				CPlayerPed* ped = player ? (CPlayerPed*)player->m_pPlayerPed : nullptr;
+				if(!ped) {
+					continue;
+				}
+				char label[CWorldLabels::MAX_TEXT];
+				snprintf(label, sizeof(label), xorstr_cached("%s (%u)"), CPlayerNames::Get(ids[i]), ids[i]);
+				// a little over the head, where the game's own nametag sits
+				CVector pos = ped->m_matrix.GetPosition();
+				pos.z += 1.2f;
+				if(!CWorldLabels::Add(pos, IM_COL32(255, 255, 255, 255), label)) {
 					break;
 				}
 			}
 		}
-		if(touchOnWindow) {
+	}
+
+	CWorldLabels::Render(ImGui::GetBackgroundDrawList(), GetFont(FONT_DEFAULT), GetFontSize(FONT_DEFAULT),
+		*g_Game.m_pViewMatrix, (float)RsGlobal->width, (float)RsGlobal->height);
+}
+
+static inline uint64_t PackRegion(int x0, int y0, int x1, int y1)
+{
+	return (uint64_t)(uint16_t)x0 | (uint64_t)(uint16_t)y0 << 16 | (uint64_t)(uint16_t)x1 << 32 | (uint64_t)(uint16_t)y1 << 48;
+}
+
+static inline int Clamp16(float v)
+{
+	return v < -32768.f ? -32768 : (v > 32767.f ? 32767 : (int)v);
+}
+
+void CGUI::PublishHitRegions()
+{
+	ImGuiContext* context = ImGui::GetCurrentContext();
+	if(!context) {
+		return;
+	}
+	int count = 0;
+	int ux0 = INT_MAX, uy0 = INT_MAX, ux1 = INT_MIN, uy1 = INT_MIN;
+	for(int i = 0; i < context->Windows.size(); i++)
+	{
+		ImGuiWindow* window = context->Windows[i];
+		// children sit inside their parent, hidden windows were not drawn
+		if(!window->Active || window->Hidden || (window->Flags & ImGuiWindowFlags_ChildWindow)) {
+			continue;
+		}
+		int x0 = Clamp16(window->Pos.x), y0 = Clamp16(window->Pos.y);
+		int x1 = Clamp16(window->Pos.x + window->Size.x), y1 = Clamp16(window->Pos.y + window->Size.y);
+		if(count < MAX_HIT_REGIONS - 1) {
+			m_hitRegions[count++].store(PackRegion(x0, y0, x1, y1), std::memory_order_relaxed);
+			continue;
+		}
+		// more windows than slots: the last one covers the rest, too much beats too little
+		ux0 = std::min(ux0, x0); uy0 = std::min(uy0, y0);
+		ux1 = std::max(ux1, x1); uy1 = std::max(uy1, y1);
+	}
+	if(ux0 != INT_MAX) {
+		m_hitRegions[count++].store(PackRegion(ux0, uy0, ux1, uy1), std::memory_order_relaxed);
+	}
+	m_nHitRegions.store(count, std::memory_order_release);
+}
+
+// Runs on the UI thread while the render thread may be publishing. Every region is one
+// atomic word, so the worst a race can do is mix windows from two adjacent frames.
+bool CGUI::OnTouchEvent(int action, int pointer, int x, int y)
+{
+	int count = m_nHitRegions.load(std::memory_order_acquire);
+	for(int i = 0; i < count; i++)
+	{
+		uint64_t region = m_hitRegions[i].load(std::memory_order_relaxed);
+		if(x > (int16_t)region && y > (int16_t)(region >> 16)
+		&& x < (int16_t)(region >> 32) && y < (int16_t)(region >> 48)) {
 			return true;
 		}
 	}
 	return false;
 }
 
-void CGUI::PushFont(const char* font_name)
+// Lilita sizes share one ImFont, so every push remembers the scale it replaced
+static ImVector<float> g_fontScaleStack;
+
+static void PushScaledFont(ImFont* font, float size)
 {
-	if(font_name == NULL || !strcasecmp(font_name, xorstr("default"))) {
-		ImGui::PushFont(m_pDefaultFont);
-	}
-	if(!strcasecmp(font_name, xorstr("main_title"))) {
-		ImGui::PushFont(m_pTitleFont);
+	g_fontScaleStack.push_back(font->Scale);
+	font->Scale = size / font->FontSize;
+	ImGui::PushFont(font);
+}
+
+void CGUI::UpdateFontSizes()
+{
+	m_nFontScreenHeight = RsGlobal->maximumHeight;
+	for(stFont& font : m_fonts) {
+		font.size = (m_nFontScreenHeight / 640.f) * font.designSize;
 	}
-	if(!strcasecmp(font_name, xorstr("title_link"))) {
-		ImGui::PushFont(m_pTitleLinkFont);
+	// the scale a font is left with is what draws outside any PushFont
+	if(m_fonts[FONT_TITLE].font) {
+		m_fonts[FONT_TITLE].font->Scale = m_fonts[FONT_TITLE].size / m_fonts[FONT_TITLE].font->FontSize;
 	}
-	if(!strcasecmp(font_name, xorstr("buttons"))) {
-		ImGui::PushFont(m_pButtonsFont);
+	if(m_fonts[FONT_DEFAULT].font) {
+		m_fonts[FONT_DEFAULT].font->Scale = m_fonts[FONT_DEFAULT].size / m_fonts[FONT_DEFAULT].font->FontSize;
 	}
-	if(!strcasecmp(font_name, xorstr("icons"))) {
-		PushIcons();
+}
+
+eFont CGUI::FindFont(const char* font_name)
+{
+	static const struct { const char* name; eFont font; } names[] = {
+		{ xorstr_cached("main_title"), FONT_TITLE },
+		{ xorstr_cached("title"), FONT_TITLE },
+		{ xorstr_cached("title_link"), FONT_TITLE_LINK },
+		{ xorstr_cached("buttons"), FONT_BUTTONS },
+		{ xorstr_cached("icons"), FONT_ICONS },
+	};
+	if(font_name) {
+		for(const auto& entry : names) {
+			if(!strcasecmp(font_name, entry.name)) {
+				return entry.font;
+			}
+		}
 	}
+	return FONT_DEFAULT;
 }
 
-void CGUI::PushIcons()
+void CGUI::PushFont(eFont font)
 {
-	ImGui::PushFont(m_pDefaultIconsFont);
+	PushScaledFont(m_fonts[font].font, m_fonts[font].size);
 }
 
 void CGUI::PopFont()
 {
+	if(!g_fontScaleStack.empty()) {
+		ImGui::GetFont()->Scale = g_fontScaleStack.back();
+		g_fontScaleStack.pop_back();
+	}
 	ImGui::PopFont();
 }
 
-ImFont* CGUI::GetFont(const char* font_name)
+void CGUI::UpdateButtonThemes()
 {
-	if(font_name == NULL || !strcasecmp(font_name, xorstr("default"))) {
-		return m_pDefaultFont;
+	const ImGuiStyle& style = ImGui::GetStyle();
+	for(int col = 0; col < ImGuiCol_COUNT; col++) {
+		ImU32 flat = ImGui::GetColorU32((ImGuiCol)col);
+		m_flatThemes[col] = { flat, flat, flat, ImGui::GetColorU32(ImGuiCol_Text) };
 	}
-	if(!strcasecmp(font_name, xorstr("title"))) {
-		return m_pTitleFont;
+	m_litTheme.bg = ImGui::GetColorU32(ImGuiCol_Button);
+	m_litTheme.hovered = ImGui::GetColorU32(ImGuiCol_ButtonHovered);
+	m_litTheme.active = ImGui::GetColorU32(ImGuiCol_ButtonActive);
+	m_litTheme.text = ImGui::ColorConvertFloat4ToU32(ImVec4(0.f, 0.f, 0.f, style.Alpha));
+}
+
+// ImGui::ButtonEx with the colours taken from theme instead of the style stack
+bool CGUI::ThemedButton(const char* label, ImVec2 size_arg, const stButtonTheme& theme)
+{
+	ImGuiWindow* window = ImGui::GetCurrentWindow();
+	if(window->SkipItems) {
+		return false;
 	}
+	const ImGuiStyle& style = ImGui::GetStyle();
+	const char* labelEnd = ImGui::FindRenderedTextEnd(label);
+	sdffont::RequestGlyphs(ImGui::GetFont(), label, labelEnd);
+
+	const ImGuiID id = window->GetID(label);
+	const ImVec2 labelSize = ImGui::CalcTextSize(label, labelEnd, false);
+	ImVec2 pos = window->DC.CursorPos;
+	ImVec2 size = ImGui::CalcItemSize(size_arg, labelSize.x + style.FramePadding.x * 2.0f, labelSize.y + style.FramePadding.y * 2.0f);
+	const ImRect bb(pos, pos + size);
+	ImGui::ItemSize(size, style.FramePadding.y);
+	if(!ImGui::ItemAdd(bb, id)) {
+		return false;
+	}
+
+	bool hovered, held;
+	bool pressed = ImGui::ButtonBehavior(bb, id, &hovered, &held);
+	ImGui::RenderNavCursor(bb, id);
+	ImGui::RenderFrame(bb.Min, bb.Max, (held && hovered) ? theme.active : (hovered ? theme.hovered : theme.bg), true, style.FrameRounding);
+
+	ImVec2 textMin = bb.Min + style.FramePadding;
+	ImVec2 textMax = bb.Max - style.FramePadding;
+	ImVec2 textPos(
+		ImMax(textMin.x, textMin.x + (textMax.x - textMin.x - labelSize.x) * style.ButtonTextAlign.x),
+		ImMax(textMin.y, textMin.y + (textMax.y - textMin.y - labelSize.y) * style.ButtonTextAlign.y));
+	ImVec4 clip(bb.Min.x, bb.Min.y, bb.Max.x, bb.Max.y);
+	window->DrawList->AddText(ImGui::GetFont(), ImGui::GetFontSize(), textPos, theme.text, label, labelEnd, 0.f, &clip);
+	return pressed;
 }
 
 bool CGUI::Button(const char* label, ImVec2 size, bool* p_toggle, bool lighting, ImGuiCol_ col)
 {
-	ImGuiStyle& style = ImGui::GetStyle();
-	bool result = false;
-	if(p_toggle == NULL) {
-		if(lighting) {
-			ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0,0,0,1.f));
-			result = ImGui::Button(label, size);
-			ImGui::PopStyleColor();
-		} else {
-			ImGui::PushStyleColor(ImGuiCol_Button, style.Colors[col]);
-			ImGui::PushStyleColor(ImGuiCol_ButtonHovered, style.Colors[col]);
-			ImGui::PushStyleColor(ImGuiCol_ButtonActive, style.Colors[col]);
-			result = ImGui::Button(label, size);
-			ImGui::PopStyleColor();
-			ImGui::PopStyleColor();
-			ImGui::PopStyleColor();
-		}
-	} else {
-		if(*p_toggle) {
-			ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0,0,0,1.f));
-			result = ImGui::Button(label, size);
-			ImGui::PopStyleColor();
-		} else {
-			ImGui::PushStyleColor(ImGuiCol_Button, style.Colors[col]);
-			ImGui::PushStyleColor(ImGuiCol_ButtonHovered, style.Colors[col]);
-			ImGui::PushStyleColor(ImGuiCol_ButtonActive, style.Colors[col]);
-			result = ImGui::Button(label, size);
-			ImGui::PopStyleColor();
-			ImGui::PopStyleColor();
-			ImGui::PopStyleColor();
-		}
-		if(result) {
-			*p_toggle =! *p_toggle;
-		}
+	// a toggle is lit while on, a plain button when asked to be
+	bool lit = p_toggle ? *p_toggle : lighting;
+	bool result = ThemedButton(label, size, lit ? m_litTheme : m_flatThemes[col]);
+	if(result && p_toggle) {
+		*p_toggle = !*p_toggle;
 	}
 	return result;
 }
@@ -286,3 +660,14 @@ void CGUI::CheckSpace()
 }
 
 
+
+int CGUI::stRowIndex::Find(float y) const
+{
+	int count = Count();
+	if(!count || y <= 0.f) {
+		return 0;
+	}
+	// the last top at or above y
+	int row = (int)(std::upper_bound(top.begin(), top.begin() + count, y) - top.begin()) - 1;
+	return row < count ? row : count - 1;
+}
@@ -1,44 +1,158 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
 #include "vendor/imgui/imgui.h"
 #include "vendor/imgui/imgui_internal.h"
 
+enum eFont
+{
+	FONT_DEFAULT,
+	FONT_TITLE,
+	FONT_TITLE_LINK,
+	FONT_BUTTONS,
+	FONT_ICONS,
+	FONT_COUNT
+};
+
 class CGUI
 {
 public:
+	// GL thread, once the context exists on the atlas LoadFonts filled
 	static void Initialise();
+	// GL thread; starts loading the fonts on the worker pool the first time, and returns
+	// the atlas once they are in it. The atlas is made outside any ImGui context, which
+	// is created on it afterwards.
+	static ImFontAtlas* PrepareFonts();
+	// GL thread; anything to draw this frame: a window or feature the overlay draws is
+	// on, or a dialog is up. Until it first is, no ImGui context exists at all.
+	static bool IsWanted();
 	static void Render();
+	// every frame before ImGui::NewFrame: follows surface size changes (rotation,
+	// split screen, foldables) with the display size, style and font sizes
+	static void UpdateDisplay(ImGuiIO& io);
 	static void Render2dStuff();
 	static bool OnTouchEvent(int action, int pointer, int x, int y);
+	// after ImGui::Render, so OnTouchEvent never has to look at the ImGui context
+	static void PublishHitRegions();
 	
-	static ImFont* GetFont(const char* font_name = NULL);
+	static ImFont* GetFont(eFont font = FONT_DEFAULT) { return m_fonts[font].font; }
+	static float GetFontSize(eFont font = FONT_DEFAULT) { return m_fonts[font].size; }
+	// for names that come from outside, e.g. "main_title"; unknown ones are FONT_DEFAULT
+	static eFont FindFont(const char* font_name);
 	
-	static void PushIcons();
-	static void PushFont(const char* font_name);
+	static void PushIcons() { PushFont(FONT_ICONS); }
+	static void PushFont(eFont font);
 	static void PopFont();
 
 	static void DrawMenu();
 	
+	// Colours for a button in every state, resolved once from the style
+	struct stButtonTheme
+	{
+		ImU32 bg;
+		ImU32 hovered;
+		ImU32 active;
+		ImU32 text;
+	};
+	// lit: the style's button colours with black text; otherwise col in every state
 	static bool Button(const char* label, ImVec2 size = ImVec2(0, 0), bool* p_toggle = NULL, bool lighting = false, ImGuiCol_ col = ImGuiCol_FrameBg);
+	// draws with the theme directly, nothing goes through the style stack
+	static bool ThemedButton(const char* label, ImVec2 size, const stButtonTheme& theme);
+	// after the style colours change
+	static void UpdateButtonThemes();
 	static void CheckSpace();
-	
-	static char* buffGUI;
+
+	// Tops of list rows that differ in height, so a scroll offset finds its row by binary
+	// search. Rebuild it when the rows or the width they were measured at change.
+	struct stRowIndex
+	{
+		std::vector<float> top;	// one per row, plus the total height
+
+		void Clear() { top.assign(1, 0.f); }
+		void Add(float height) { top.push_back(Total() + height); }
+		int Count() const { return top.empty() ? 0 : (int)top.size() - 1; }
+		float Total() const { return top.empty() ? 0.f : top.back(); }
+		// the row that covers y, clamped to [0, Count())
+		int Find(float y) const;
+	};
+	// drawRow(i) for the rows in view of the current window only; the rest are skipped
+	// space, so the cost follows the window height and not the row count
+	template<typename F>
+	static void DrawRows(int count, F drawRow);
+	template<typename F>
+	static void DrawRows(const stRowIndex& index, F drawRow);
 private:
-	static ImFont* m_pDefaultFont;
-	static ImFont* m_pTitleFont;
-	static ImFont* m_pTitleLinkFont;
-	static ImFont* m_pButtonsFont;
-	
-	static ImFont* m_pDefaultIconsFont;
-	
-	static float m_fDefaultFontSize;
-	static float m_fTitleFontSize;
-	static float m_fTitleLinkFontSize;
-	static float m_fButtonsFontSize;
+	struct stFont
+	{
+		ImFont* font;
+		float designSize;	// at a 640 pixel high screen
+		float size;
+	};
+	// sizes follow the screen height, redone when it changes
+	static void UpdateFontSizes();
+	// worker thread, no ImGui context
+	static void LoadFonts(ImFontAtlas* atlas);
+
+	static stFont m_fonts[FONT_COUNT];
+	static int m_nFontScreenHeight;
+	static bool m_bFontsRequested;
+	static bool m_bSdfFonts;
+	static std::atomic<ImFontAtlas*> m_pFontAtlas;
+
+	// the style as Initialise left it, and the screen height it was made for
+	static ImGuiStyle m_baseStyle;
+	static int m_nBaseStyleHeight;
+	static int m_nDisplayWidth;
+	static int m_nDisplayHeight;
+
+	static stButtonTheme m_litTheme;
+	static stButtonTheme m_flatThemes[ImGuiCol_COUNT];
 
 	static const char* m_szVersionText;
 	static ImVec2 m_vVersionPos;
 	static ImU32 m_uVersionColor;
 	static ImU32 m_uVersionShadowColor;
 	static float m_fVersionFontScale;
+
+	// top level windows drawn last frame, as packed int16 x0, y0, x1, y1
+	static constexpr int MAX_HIT_REGIONS = 32;
+	static std::atomic<uint64_t> m_hitRegions[MAX_HIT_REGIONS];
+	static std::atomic<int> m_nHitRegions;
 };
+
+template<typename F>
+void CGUI::DrawRows(int count, F drawRow)
+{
+	ImGuiListClipper clipper;
+	clipper.Begin(count);
+	while(clipper.Step())
+	{
+		for(int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+			drawRow(i);
+		}
+	}
+}
+
+template<typename F>
+void CGUI::DrawRows(const stRowIndex& index, F drawRow)
+{
+	int count = index.Count();
+	if(!count) {
+		return;
+	}
+	float base = ImGui::GetCursorPosY();
+	float scroll = ImGui::GetScrollY();
+	int first = index.Find(scroll - base);
+	int last = index.Find(scroll - base + ImGui::GetWindowHeight());
+	for(int i = first; i <= last; i++)
+	{
+		ImGui::SetCursorPosY(base + index.top[i]);
+		drawRow(i);
+	}
+	// the rows below still count towards the scroll range
+	ImGui::SetCursorPosY(base + index.Total());
+	ImGui::Dummy(ImVec2(0.f, 0.f));
+}
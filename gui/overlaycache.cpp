@@ -0,0 +1,181 @@
+#include "overlaycache.h"
+#include "config.h"
+
+#include <GLES3/gl3.h>
+#include <android/log.h>
+#include <string.h>
+
+#include "vendor/imgui/backend/imgui_impl_opengl3.h"
+#include "vendor/RakNet/GetTime.h"
+#include "xorstr.h"
+
+unsigned int COverlayCache::m_framebuffer = 0;
+unsigned int COverlayCache::m_texture = 0;
+int COverlayCache::m_width = 0;
+int COverlayCache::m_height = 0;
+uint64_t COverlayCache::m_hash = 0;
+uint32_t COverlayCache::m_lastBuild = 0;
+bool COverlayCache::m_interacting = false;
+ImDrawList* COverlayCache::m_pQuad = nullptr;
+ImDrawData COverlayCache::m_quadData;
+
+static inline uint64_t Mix(uint64_t hash, uint64_t value)
+{
+	hash ^= value;
+	hash *= 0x9E3779B97F4A7C15ull;
+	return hash ^ (hash >> 29);
+}
+
+static uint64_t MixBytes(uint64_t hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	for(; size >= sizeof(uint64_t); bytes += sizeof(uint64_t), size -= sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, bytes, sizeof(word));
+		hash = Mix(hash, word);
+	}
+	uint64_t tail = 0;
+	memcpy(&tail, bytes, size);
+	return Mix(hash, tail ^ size);
+}
+
+bool COverlayCache::IsEnabled()
+{
+	return CConfig::Get().overlayCacheHz != 0;
+}
+
+bool COverlayCache::WantsBuild(bool touchPending)
+{
+	bool build = !m_texture || touchPending || m_interacting || ImGui::IsAnyMouseDown() || ImGui::IsAnyItemActive()
+		|| RakNet::GetTime() - m_lastBuild >= 1000 / CConfig::Get().overlayCacheHz;
+	if(build) {
+		m_interacting = touchPending;
+	}
+	return build;
+}
+
+uint64_t COverlayCache::Hash(const ImDrawData* drawData)
+{
+	uint64_t hash = Mix(0, drawData->CmdListsCount);
+	for(int i = 0; i < drawData->CmdListsCount; i++)
+	{
+		const ImDrawList* list = drawData->CmdLists[i];
+		hash = MixBytes(hash, list->VtxBuffer.Data, list->VtxBuffer.Size * sizeof(ImDrawVert));
+		hash = MixBytes(hash, list->IdxBuffer.Data, list->IdxBuffer.Size * sizeof(ImDrawIdx));
+		for(const ImDrawCmd& cmd : list->CmdBuffer) {
+			hash = MixBytes(hash, &cmd.ClipRect, sizeof(cmd.ClipRect));
+			hash = Mix(hash, (uint64_t)cmd.TextureId);
+			hash = Mix(hash, ((uint64_t)cmd.IdxOffset << 32) | cmd.ElemCount);
+			hash = Mix(hash, (uint64_t)(uintptr_t)cmd.UserCallback);
+			// SDF outline parameters live in the list's callback storage
+			if(cmd.UserCallback && cmd.UserCallbackDataSize > 0) {
+				hash = MixBytes(hash, cmd.UserCallbackData, cmd.UserCallbackDataSize);
+			}
+		}
+	}
+	return hash;
+}
+
+bool COverlayCache::Resize(int width, int height)
+{
+	if(m_texture && width == m_width && height == m_height) {
+		return true;
+	}
+	if(!m_texture) {
+		glGenTextures(1, &m_texture);
+		glGenFramebuffers(1, &m_framebuffer);
+	}
+	GLint previousTexture, previousFramebuffer;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	// drawn 1:1 onto the screen
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture, 0);
+	bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+	glBindTexture(GL_TEXTURE_2D, previousTexture);
+	if(!complete) {
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Overlay"), xorstr("no %dx%d offscreen target, drawing directly"), width, height);
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteTextures(1, &m_texture);
+		m_framebuffer = m_texture = 0;
+		return false;
+	}
+	m_width = width;
+	m_height = height;
+	m_hash = 0;
+
+	// one quad over the whole screen; texture rows run bottom up
+	if(!m_pQuad) {
+		m_pQuad = IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData());
+	}
+	ImVec2 size = ImGui::GetIO().DisplaySize;
+	m_pQuad->_ResetForNewFrame();
+	m_pQuad->PushTextureID((ImTextureID)m_texture);
+	m_pQuad->PushClipRect(ImVec2(0.f, 0.f), size);
+	m_pQuad->AddCallback(PremultipliedBlend, nullptr);
+	m_pQuad->AddImage((ImTextureID)m_texture, ImVec2(0.f, 0.f), size, ImVec2(0.f, 1.f), ImVec2(1.f, 0.f));
+	m_pQuad->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+	m_quadData.Clear();
+	m_quadData.Valid = true;
+	m_quadData.DisplaySize = size;
+	m_quadData.FramebufferScale = ImGui::GetIO().DisplayFramebufferScale;
+	m_quadData.AddDrawList(m_pQuad);
+	return true;
+}
+
+void COverlayCache::Update(ImDrawData* drawData)
+{
+	m_lastBuild = RakNet::GetTime();
+	int width = (int)(drawData->DisplaySize.x * drawData->FramebufferScale.x);
+	int height = (int)(drawData->DisplaySize.y * drawData->FramebufferScale.y);
+	if(width <= 0 || height <= 0 || !Resize(width, height)) {
+		return;
+	}
+	uint64_t hash = Hash(drawData);
+	if(hash == m_hash) {
+		return;
+	}
+	m_hash = hash;
+
+	// only on a change, so the glGets here don't cost a sync every swap
+	GLint previousFramebuffer;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	if(scissor) {
+		glDisable(GL_SCISSOR_TEST);
+	}
+	// glClearBufferfv leaves the game's clear colour alone
+	static const GLfloat transparent[4] = { 0.f, 0.f, 0.f, 0.f };
+	glClearBufferfv(GL_COLOR, 0, transparent);
+	if(scissor) {
+		glEnable(GL_SCISSOR_TEST);
+	}
+	ImGui_ImplOpenGL3_RenderDrawData(drawData);
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+}
+
+void COverlayCache::Composite()
+{
+	if(!m_texture) {
+		// never got an offscreen target
+		if(ImGui::GetDrawData()) {
+			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+		}
+		return;
+	}
+	ImGui_ImplOpenGL3_RenderDrawData(&m_quadData);
+}
+
+void COverlayCache::PremultipliedBlend(const ImDrawList* drawList, const ImDrawCmd* cmd)
+{
+	// the backend blends alpha with ONE, ONE_MINUS_SRC_ALPHA, so the texture holds premultiplied colour
+	glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+}
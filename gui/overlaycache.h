@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+#include "vendor/imgui/imgui.h"
+
+// The overlay kept in an offscreen texture. Most of what it shows (the version line, the
+// coordinate readout, collapsed windows) stays the same for seconds, yet building the ImGui
+// frame and drawing its geometry cost the same every swap. With "overlayCacheHz" set, the
+// frame is built at most that often, or on every swap while a touch is being handled, and
+// drawn into the texture only when its geometry differs from what the texture holds. Every
+// swap then costs one textured quad. World labels move with the camera at the capped rate.
+class COverlayCache
+{
+public:
+	static bool IsEnabled();
+	// true when this swap should build a new ImGui frame
+	static bool WantsBuild(bool touchPending);
+	// after ImGui::Render; redraws the texture when the frame changed
+	static void Update(ImDrawData* drawData);
+	// the texture over whatever is bound, through the ImGui backend and its state handling
+	static void Composite();
+
+private:
+	static bool Resize(int width, int height);
+	static uint64_t Hash(const ImDrawData* drawData);
+	static void PremultipliedBlend(const ImDrawList* drawList, const ImDrawCmd* cmd);
+
+	static unsigned int m_framebuffer;
+	static unsigned int m_texture;
+	static int m_width;
+	static int m_height;
+	static uint64_t m_hash;
+	static uint32_t m_lastBuild;
+	// the last frame handled touches; ImGui trickles a tap over two frames
+	static bool m_interacting;
+	static ImDrawList* m_pQuad;
+	static ImDrawData m_quadData;
+};
@@ -0,0 +1,67 @@
+#include "overlaysettings.h"
+#include "config.h"
+#include "workers.h"
+#include "xorstr.h"
+#include "plugin/diskcache.h"
+
+#include <android/log.h>
+
+std::string COverlaySettings::m_path;
+std::string COverlaySettings::m_text;
+std::atomic<bool> COverlaySettings::m_read(false);
+bool COverlaySettings::m_applied = false;
+std::atomic<bool> COverlaySettings::m_writing(false);
+
+void COverlaySettings::Load()
+{
+	const CConfig::stSettings& config = CConfig::Get();
+	if(!config.overlaySettings || config.dataDir.empty()) {
+		return;
+	}
+	m_path = config.dataDir + (const char*)xorstr("/imgui.ini");
+	CWorkers::Submit([] {
+		// a missing file is a first run
+		CDiskCache::Read(m_path, &m_text);
+		m_read.store(true, std::memory_order_release);
+	});
+}
+
+void COverlaySettings::Attach(ImGuiIO& io)
+{
+	io.IniFilename = nullptr;
+	Process(io);
+}
+
+void COverlaySettings::Process(ImGuiIO& io)
+{
+	if(m_path.empty()) {
+		io.WantSaveIniSettings = false;
+		return;
+	}
+	if(!m_applied)
+	{
+		if(!m_read.load(std::memory_order_acquire)) {
+			// nothing gets saved over the file before it has been loaded
+			return;
+		}
+		// windows made before this keep where they are; anything opened later is placed
+		ImGui::LoadIniSettingsFromMemory(m_text.data(), m_text.size());
+		std::string().swap(m_text);
+		m_applied = true;
+		io.WantSaveIniSettings = false;
+	}
+	// the last write still going stays pending, ImGui keeps asking
+	if(!io.WantSaveIniSettings || m_writing.load(std::memory_order_acquire)) {
+		return;
+	}
+	size_t size = 0;
+	const char* text = ImGui::SaveIniSettingsToMemory(&size);
+	io.WantSaveIniSettings = false;
+	m_writing.store(true, std::memory_order_relaxed);
+	CWorkers::Submit([copy = std::string(text, size)] {
+		if(!CDiskCache::Write(m_path, copy)) {
+			__android_log_print(ANDROID_LOG_INFO, xorstr("GUI"), xorstr("couldn't write %s"), m_path.c_str());
+		}
+		m_writing.store(false, std::memory_order_release);
+	});
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "vendor/imgui/imgui.h"
+
+// Where the overlay's windows were left, kept in imgui.ini. Left to itself ImGui reads that
+// file with fopen on the first frame and rewrites it from the render thread whenever its save
+// timer runs out, which on slow storage shows up as a frame spike. io.IniFilename is cleared
+// instead. With "overlaySettings" on, a worker reads the file at startup and the text goes to
+// ImGui as soon as it is in; a change is serialised to memory on the render thread and a
+// worker writes it out. With it off nothing is read or written.
+class COverlaySettings
+{
+public:
+	// at startup, long before the first frame
+	static void Load();
+	// right after ImGui::CreateContext
+	static void Attach(ImGuiIO& io);
+	// after ImGui::Render on every frame that was built
+	static void Process(ImGuiIO& io);
+
+private:
+	static std::string m_path;
+	// filled by the reading worker, handed to ImGui once m_read is set
+	static std::string m_text;
+	static std::atomic<bool> m_read;
+	static bool m_applied;
+	static std::atomic<bool> m_writing;
+};
@@ -0,0 +1,705 @@
+#include "sdffont.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <zlib.h>
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#define STBTT_STATIC
+#include "vendor/imgui/imstb_truetype.h"
+
+#include "vendor/imgui/imgui_internal.h"
+
+namespace sdffont
+{
+	struct stFont
+	{
+		ImFont* font;
+		float ascent;			// BASE_SIZE pixels, rounded the way ImGui lays out its glyphs
+		std::vector<bool> used;	// codepoints already queued
+	};
+
+	struct stPendingGlyph
+	{
+		int rectId;
+		unsigned char* pixels;	// stbtt SDF bitmap, NULL for blank glyphs
+		int width, height;
+	};
+
+	// Blob layout: stBlobHeader, then zlib(pixels, per font stBlobFont + its stBlobGlyphs).
+	// The pixels go first so the inflated buffer can be handed to the atlas as is. They are
+	// alpha8, or for TEX_EAC_R11 4x4 blocks over the height rounded up to whole blocks.
+	constexpr uint32_t BLOB_MAGIC = 0x46534452; // "RDSF"
+	constexpr uint16_t BLOB_VERSION = 2;
+
+	struct stBlobHeader
+	{
+		uint32_t magic;
+		uint16_t version;
+		uint16_t fontCount;
+		uint16_t texWidth;
+		uint16_t texHeight;
+		uint16_t texFormat;
+		uint16_t reserved;
+		float whiteU, whiteV;
+		uint32_t rawSize;
+		uint32_t compressedSize;
+	};
+
+	struct stBlobFont
+	{
+		float fontSize;
+		float ascent, descent;
+		uint32_t glyphCount;
+	};
+
+	struct stBlobGlyph
+	{
+		uint32_t codepoint;
+		float advanceX;
+		float x0, y0, x1, y1;
+		float u0, v0, u1, v1;
+	};
+
+	static_assert(sizeof(stBlobHeader) == 32 && sizeof(stBlobFont) == 16 && sizeof(stBlobGlyph) == 40, "blob layout");
+
+	struct stLazySource
+	{
+		ImFont* font;
+		// the TTF stays zlib compressed and is only inflated while glyphs are rasterised
+		const unsigned char* packed;
+		unsigned int packedSize;
+		unsigned int ttfSize;
+		std::vector<unsigned char> ttf;
+		int idleFrames;
+		stbtt_fontinfo info;
+		float scale;
+		ImVec2 offset;				// added to stbtt's glyph box, ascent included
+		const ImWchar* ranges;
+		std::vector<bool> tried;	// codepoints already looked at, found or not
+	};
+
+	// a lazy glyph waiting for EndFrame to hand it to the GPU
+	struct stUpload
+	{
+		int x, y;
+		int width, height;
+		unsigned char* pixels;	// stbtt SDF bitmap
+	};
+
+	// an inflated TTF is dropped after this many frames without new glyphs
+	constexpr int LAZY_IDLE_FRAMES = 120;
+
+	// free space for lazily added glyphs: rows [y, bottom) below the baked atlas, which start at top
+	struct stLazyArea
+	{
+		int x, y;
+		int rowHeight;
+		int top, bottom;
+	};
+
+	static std::vector<stFont> g_fonts;
+	static std::vector<stLazySource> g_lazy;
+	static stLazyArea g_lazyArea;
+	static std::vector<stUpload> g_uploads;
+	static std::vector<stPendingGlyph> g_pending;
+	// an EAC atlas: its blocks until the texture exists, and the lazy rows as alpha8, since a
+	// lazy glyph shares its edge blocks with its neighbours and the whole block is re-encoded
+	static unsigned char* g_blocks;
+	static int g_blocksSize;
+	static std::vector<unsigned char> g_lazyPixels;
+
+	// ETC2 alpha modifier tables, shared by EAC; [3] is the lowest entry and [7] the highest
+	static const int8_t g_eacModifiers[16][8] = {
+		{ -3, -6, -9, -15, 2, 5, 8, 14 }, { -3, -7, -10, -13, 2, 6, 9, 12 },
+		{ -2, -5, -8, -13, 1, 4, 7, 12 }, { -2, -4, -6, -13, 1, 3, 5, 12 },
+		{ -3, -6, -8, -12, 2, 5, 7, 11 }, { -3, -7, -9, -11, 2, 6, 8, 10 },
+		{ -4, -7, -8, -11, 3, 6, 7, 10 }, { -3, -5, -8, -11, 2, 4, 7, 10 },
+		{ -2, -6, -8, -10, 1, 5, 7, 9 }, { -2, -5, -8, -10, 1, 4, 7, 9 },
+		{ -2, -4, -8, -10, 1, 3, 7, 9 }, { -2, -5, -7, -10, 1, 4, 6, 9 },
+		{ -3, -4, -7, -10, 2, 3, 6, 9 }, { -1, -2, -3, -10, 0, 1, 2, 9 },
+		{ -4, -6, -8, -9, 3, 5, 7, 8 }, { -3, -5, -7, -9, 2, 4, 6, 8 },
+	};
+
+	// One 4x4 block of alpha8 as GL_COMPRESSED_R11_EAC. Every table is tried with the multiplier
+	// and base the block's range suggests, and their neighbours; that is close enough to a full
+	// search for distance fields, and quick enough for lazy glyphs.
+	static void EncodeEacBlock(const unsigned char* alpha, int stride, unsigned char* out)
+	{
+		// 11 bit targets, column by column like the block's indices
+		int target[16];
+		int lo = 2047, hi = 0;
+		for(int x = 0; x < 4; x++) {
+			for(int y = 0; y < 4; y++) {
+				int v = (alpha[y * stride + x] * 2047 + 127) / 255;
+				target[x * 4 + y] = v;
+				lo = v < lo ? v : lo;
+				hi = v > hi ? v : hi;
+			}
+		}
+		uint64_t best = 0;
+		int bestError = INT32_MAX;
+		for(int t = 0; t < 16; t++) {
+			const int8_t* mod = g_eacModifiers[t];
+			int span = (mod[7] - mod[3]) * 8;
+			int guess = (hi - lo + span / 2) / span;
+			for(int m = guess - 1; m <= guess + 1; m++) {
+				if(m < 0 || m > 15) {
+					continue;
+				}
+				// multiplier 0 steps by one 11 bit unit instead of eight
+				int step = m ? m * 8 : 1;
+				int centre = (lo + hi) / 2 - 4 - (mod[7] + mod[3]) * step / 2;
+				for(int b = centre / 8 - 1; b <= centre / 8 + 1; b++) {
+					if(b < 0 || b > 255) {
+						continue;
+					}
+					int values[8];
+					for(int k = 0; k < 8; k++) {
+						int v = b * 8 + 4 + mod[k] * step;
+						values[k] = v < 0 ? 0 : (v > 2047 ? 2047 : v);
+					}
+					int error = 0;
+					uint64_t indices = 0;
+					for(int i = 0; i < 16 && error < bestError; i++) {
+						int bestK = 0, bestD = INT32_MAX;
+						for(int k = 0; k < 8; k++) {
+							int d = (values[k] - target[i]) * (values[k] - target[i]);
+							if(d < bestD) {
+								bestD = d;
+								bestK = k;
+							}
+						}
+						error += bestD;
+						indices = indices << 3 | bestK;
+					}
+					if(error < bestError) {
+						bestError = error;
+						best = (uint64_t)b << 56 | (uint64_t)m << 52 | (uint64_t)t << 48 | indices;
+					}
+				}
+			}
+		}
+		// big endian, base first
+		for(int i = 0; i < 8; i++) {
+			out[i] = (unsigned char)(best >> (56 - i * 8));
+		}
+	}
+
+	// width and height are multiples of 4; blocks go out row by row
+	static void EncodeEac(const unsigned char* alpha, int stride, int width, int height, unsigned char* out)
+	{
+		for(int y = 0; y < height; y += 4) {
+			for(int x = 0; x < width; x += 4) {
+				EncodeEacBlock(alpha + y * stride + x, stride, out);
+				out += 8;
+			}
+		}
+	}
+
+	static stFont* Find(const ImFont* font)
+	{
+		for(stFont& f : g_fonts) {
+			if(f.font == font) {
+				return &f;
+			}
+		}
+		return nullptr;
+	}
+}
+
+ImFont* sdffont::AddFont(ImFontAtlas* atlas, const unsigned char* ttf, int ttfSize, const ImWchar* ranges,
+	ImFont* mergeInto, const ImVec2& glyphOffset)
+{
+	stbtt_fontinfo info;
+	if(!stbtt_InitFont(&info, ttf, stbtt_GetFontOffsetForIndex(ttf, 0))) {
+		return nullptr;
+	}
+	float scale = stbtt_ScaleForPixelHeight(&info, BASE_SIZE);
+
+	stFont* dst = mergeInto ? Find(mergeInto) : nullptr;
+	if(mergeInto && !dst) {
+		return nullptr;
+	}
+	if(!dst) {
+		// The atlas only rasterizes the space for this font, which gives ImGui the
+		// metrics; every visible glyph comes in as a custom rect.
+		static const ImWchar spaceRange[] = { 0x20, 0x20, 0 };
+		ImFontConfig cfg;
+		cfg.FontDataOwnedByAtlas = false;
+		ImFont* font = atlas->AddFontFromMemoryTTF((void*)ttf, ttfSize, BASE_SIZE, &cfg, spaceRange);
+		if(!font) {
+			return nullptr;
+		}
+		int ascent, descent, lineGap;
+		stbtt_GetFontVMetrics(&info, &ascent, &descent, &lineGap);
+		stFont entry;
+		entry.font = font;
+		entry.ascent = floorf(ceilf(ascent * scale) + 0.5f);
+		entry.used.assign(0x10000, false);
+		entry.used[0x20] = true;
+		g_fonts.push_back(entry);
+		dst = &g_fonts.back();
+	}
+
+	for(const ImWchar* r = ranges; r[0] && r[1]; r += 2) {
+		for(unsigned int cp = r[0]; cp <= r[1]; cp++) {
+			if(dst->used[cp]) {
+				continue;
+			}
+			int glyph = stbtt_FindGlyphIndex(&info, cp);
+			if(glyph == 0) {
+				continue;
+			}
+			dst->used[cp] = true;
+
+			int advance, lsb;
+			stbtt_GetGlyphHMetrics(&info, glyph, &advance, &lsb);
+			stPendingGlyph pending;
+			int xoff = 0, yoff = 0;
+			pending.pixels = stbtt_GetGlyphSDF(&info, scale, glyph, PADDING, ON_EDGE, PIXEL_DIST_SCALE,
+				&pending.width, &pending.height, &xoff, &yoff);
+			if(!pending.pixels) {
+				pending.width = pending.height = 1;
+			}
+			pending.rectId = atlas->AddCustomRectFontGlyph(dst->font, (ImWchar)cp, pending.width, pending.height,
+				advance * scale, ImVec2(xoff + glyphOffset.x, dst->ascent + yoff + glyphOffset.y));
+			g_pending.push_back(pending);
+		}
+	}
+	return dst->font;
+}
+
+bool sdffont::Build(ImFontAtlas* atlas)
+{
+	// baked lines and cursors are coverage, not distances, and would be misread by the shader
+	atlas->Flags |= ImFontAtlasFlags_NoBakedLines | ImFontAtlasFlags_NoMouseCursors;
+	if(!atlas->Build()) {
+		return false;
+	}
+
+	unsigned char* tex;
+	int texWidth, texHeight;
+	atlas->GetTexDataAsAlpha8(&tex, &texWidth, &texHeight);
+	for(stPendingGlyph& pending : g_pending) {
+		const ImFontAtlasCustomRect* rect = atlas->GetCustomRectByIndex(pending.rectId);
+		for(int y = 0; y < pending.height; y++) {
+			unsigned char* row = tex + (rect->Y + y) * texWidth + rect->X;
+			if(pending.pixels) {
+				memcpy(row, pending.pixels + y * pending.width, pending.width);
+			} else {
+				memset(row, 0, pending.width);
+			}
+		}
+		if(pending.pixels) {
+			stbtt_FreeSDF(pending.pixels, nullptr);
+		}
+	}
+	g_pending.clear();
+	for(stFont& f : g_fonts) {
+		std::vector<bool>().swap(f.used);
+	}
+	return true;
+}
+
+bool sdffont::Save(ImFontAtlas* atlas, std::vector<unsigned char>* out, eTexFormat format)
+{
+	unsigned char* tex;
+	int texWidth, texHeight;
+	atlas->GetTexDataAsAlpha8(&tex, &texWidth, &texHeight);
+	if(!tex || texWidth > 0xFFFF || texHeight > 0xFFFF || (format == TEX_EAC_R11 && texWidth % 4)) {
+		return false;
+	}
+
+	std::vector<unsigned char> raw;
+	if(format == TEX_EAC_R11) {
+		int rows = (texHeight + 3) & ~3;
+		std::vector<unsigned char> padded(tex, tex + texWidth * texHeight);
+		padded.resize(texWidth * rows, 0);
+		// 8 bytes per 16 texels
+		raw.resize(texWidth * rows / 2);
+		EncodeEac(padded.data(), texWidth, texWidth, rows, raw.data());
+	} else {
+		raw.assign(tex, tex + texWidth * texHeight);
+	}
+	for(const stFont& f : g_fonts) {
+		stBlobFont font;
+		font.fontSize = f.font->FontSize;
+		font.ascent = f.font->Ascent;
+		font.descent = f.font->Descent;
+		font.glyphCount = f.font->Glyphs.Size;
+		raw.insert(raw.end(), (unsigned char*)&font, (unsigned char*)(&font + 1));
+		for(const ImFontGlyph& g : f.font->Glyphs) {
+			stBlobGlyph glyph = { g.Codepoint, g.AdvanceX, g.X0, g.Y0, g.X1, g.Y1, g.U0, g.V0, g.U1, g.V1 };
+			raw.insert(raw.end(), (unsigned char*)&glyph, (unsigned char*)(&glyph + 1));
+		}
+	}
+
+	uLongf compressedSize = compressBound(raw.size());
+	out->resize(sizeof(stBlobHeader) + compressedSize);
+	if(compress2(out->data() + sizeof(stBlobHeader), &compressedSize, raw.data(), raw.size(), Z_BEST_COMPRESSION) != Z_OK) {
+		return false;
+	}
+	out->resize(sizeof(stBlobHeader) + compressedSize);
+
+	stBlobHeader header;
+	header.magic = BLOB_MAGIC;
+	header.version = BLOB_VERSION;
+	header.fontCount = (uint16_t)g_fonts.size();
+	header.texWidth = (uint16_t)texWidth;
+	header.texHeight = (uint16_t)texHeight;
+	header.texFormat = (uint16_t)format;
+	header.reserved = 0;
+	header.whiteU = atlas->TexUvWhitePixel.x;
+	header.whiteV = atlas->TexUvWhitePixel.y;
+	header.rawSize = raw.size();
+	header.compressedSize = compressedSize;
+	memcpy(out->data(), &header, sizeof(header));
+	return true;
+}
+
+int sdffont::Load(ImFontAtlas* atlas, const unsigned char* blob, unsigned int size, ImFont** fonts, int maxFonts, int extraRows)
+{
+	stBlobHeader header;
+	if(size < sizeof(header)) {
+		return 0;
+	}
+	memcpy(&header, blob, sizeof(header));
+	bool eac = header.texFormat == TEX_EAC_R11;
+	// EAC rows only come in whole blocks, so both parts are rounded up to them
+	int bakedRows = eac ? (header.texHeight + 3) & ~3 : header.texHeight;
+	extraRows = eac ? (extraRows + 3) & ~3 : extraRows;
+	uint32_t rowSize = eac ? header.texWidth / 2 : header.texWidth;
+	uint32_t pixelsSize = rowSize * bakedRows;
+	uint32_t extraSize = rowSize * extraRows;
+	if(header.magic != BLOB_MAGIC || header.version != BLOB_VERSION || header.fontCount > maxFonts
+		|| header.texFormat > TEX_EAC_R11 || (eac && header.texWidth % 4)
+		|| header.compressedSize > size - sizeof(header) || header.rawSize < pixelsSize) {
+		return 0;
+	}
+
+	unsigned char* raw = (unsigned char*)IM_ALLOC(header.rawSize + extraSize);
+	uLongf rawSize = header.rawSize;
+	if(uncompress(raw, &rawSize, blob + sizeof(header), header.compressedSize) != Z_OK || rawSize != header.rawSize) {
+		IM_FREE(raw);
+		return 0;
+	}
+	// the extra rows go right below the baked pixels, the metrics move behind them
+	const unsigned char* metrics = raw + pixelsSize + extraSize;
+	uint32_t metricsSize = rawSize - pixelsSize;
+	memmove(raw + pixelsSize + extraSize, raw + pixelsSize, metricsSize);
+	// zeroed EAC blocks decode to 1/2047, as good as empty
+	memset(raw + pixelsSize, 0, extraSize);
+
+	// validate the metrics before the atlas is touched
+	uint32_t offset = 0;
+	for(int i = 0; i < header.fontCount; i++) {
+		stBlobFont font;
+		if(metricsSize - offset < sizeof(font)) {
+			IM_FREE(raw);
+			return 0;
+		}
+		memcpy(&font, metrics + offset, sizeof(font));
+		offset += sizeof(font);
+		if((metricsSize - offset) / sizeof(stBlobGlyph) < font.glyphCount) {
+			IM_FREE(raw);
+			return 0;
+		}
+		offset += font.glyphCount * sizeof(stBlobGlyph);
+	}
+
+	int texHeight = bakedRows + extraRows;
+	// baked v coordinates are relative to the blob's texture height
+	float vScale = (float)header.texHeight / texHeight;
+
+	atlas->Clear();
+	atlas->Flags |= ImFontAtlasFlags_NoBakedLines | ImFontAtlasFlags_NoMouseCursors;
+	atlas->TexWidth = header.texWidth;
+	atlas->TexHeight = texHeight;
+	atlas->TexUvScale = ImVec2(1.f / header.texWidth, 1.f / texHeight);
+	atlas->TexUvWhitePixel = ImVec2(header.whiteU, header.whiteV * vScale);
+	// the metrics after the pixels stay in the buffer until the atlas (or EndFrame) frees it
+	IM_FREE(g_blocks);
+	g_blocks = nullptr;
+	g_blocksSize = 0;
+	if(eac) {
+		g_blocks = raw;
+		g_blocksSize = pixelsSize + extraSize;
+		g_lazyPixels.assign(header.texWidth * extraRows, 0);
+	} else {
+		atlas->TexPixelsAlpha8 = raw;
+		std::vector<unsigned char>().swap(g_lazyPixels);
+	}
+
+	// fonts still expect a config to point at (ellipsis lookup, debug names), so give each an empty one
+	for(int i = 0; i < header.fontCount; i++) {
+		ImFontConfig cfg;
+		cfg.FontDataOwnedByAtlas = false;
+		atlas->ConfigData.push_back(cfg);
+	}
+
+	g_fonts.clear();
+	g_lazy.clear();
+	for(const stUpload& glyph : g_uploads) {
+		stbtt_FreeSDF(glyph.pixels, nullptr);
+	}
+	g_uploads.clear();
+	g_lazyArea.top = g_lazyArea.y = bakedRows;
+	g_lazyArea.bottom = texHeight;
+	g_lazyArea.x = 0;
+	g_lazyArea.rowHeight = 0;
+	offset = 0;
+	for(int i = 0; i < header.fontCount; i++) {
+		stBlobFont src;
+		memcpy(&src, metrics + offset, sizeof(src));
+		offset += sizeof(src);
+
+		ImFont* font = IM_NEW(ImFont);
+		ImFontConfig* cfg = &atlas->ConfigData[i];
+		cfg->SizePixels = src.fontSize;
+		cfg->DstFont = font;
+		font->ConfigData = cfg;
+		font->ConfigDataCount = 1;
+		font->ContainerAtlas = atlas;
+		font->FontSize = src.fontSize;
+		font->Ascent = src.ascent;
+		font->Descent = src.descent;
+		for(uint32_t g = 0; g < src.glyphCount; g++) {
+			stBlobGlyph glyph;
+			memcpy(&glyph, metrics + offset, sizeof(glyph));
+			offset += sizeof(glyph);
+			font->AddGlyph(nullptr, (ImWchar)glyph.codepoint, glyph.x0, glyph.y0, glyph.x1, glyph.y1,
+				glyph.u0, glyph.v0 * vScale, glyph.u1, glyph.v1 * vScale, glyph.advanceX);
+		}
+		font->BuildLookupTable();
+		atlas->Fonts.push_back(font);
+
+		stFont entry;
+		entry.font = font;
+		entry.ascent = src.ascent;
+		g_fonts.push_back(entry);
+		fonts[i] = font;
+	}
+	atlas->TexReady = true;
+	return header.fontCount;
+}
+
+static bool Inflate(sdffont::stLazySource& source)
+{
+	source.idleFrames = 0;
+	if(!source.ttf.empty()) {
+		return true;
+	}
+	source.ttf.resize(source.ttfSize);
+	uLongf ttfSize = source.ttfSize;
+	if(uncompress(source.ttf.data(), &ttfSize, source.packed, source.packedSize) != Z_OK || ttfSize != source.ttfSize
+		|| !stbtt_InitFont(&source.info, source.ttf.data(), stbtt_GetFontOffsetForIndex(source.ttf.data(), 0))) {
+		std::vector<unsigned char>().swap(source.ttf);
+		return false;
+	}
+	return true;
+}
+
+static void Deflate(sdffont::stLazySource& source)
+{
+	// swap, clear() would keep the capacity
+	std::vector<unsigned char>().swap(source.ttf);
+}
+
+bool sdffont::AddLazyFont(ImFont* mergeInto, const unsigned char* packed, unsigned int packedSize, unsigned int ttfSize,
+	const ImWchar* ranges, const ImVec2& glyphOffset)
+{
+	stFont* dst = Find(mergeInto);
+	if(!dst) {
+		return false;
+	}
+	stLazySource source;
+	source.packed = packed;
+	source.packedSize = packedSize;
+	source.ttfSize = ttfSize;
+	if(!Inflate(source)) {
+		return false;
+	}
+	source.font = mergeInto;
+	source.scale = stbtt_ScaleForPixelHeight(&source.info, BASE_SIZE);
+	source.offset = ImVec2(glyphOffset.x, dst->ascent + glyphOffset.y);
+	source.ranges = ranges;
+	source.tried.assign(0x10000, false);
+	// nothing is drawn with it yet
+	Deflate(source);
+	g_lazy.push_back(std::move(source));
+	return true;
+}
+
+// Rasterises one codepoint into the reserved rows and registers it with the font.
+// Returns false once the area is full.
+static bool AddLazyGlyph(sdffont::stLazySource& source, unsigned int cp)
+{
+	using namespace sdffont;
+	ImFontAtlas* atlas = source.font->ContainerAtlas;
+	int glyph = stbtt_FindGlyphIndex(&source.info, cp);
+	if(glyph == 0) {
+		return true;
+	}
+
+	int width = 0, height = 0, xoff = 0, yoff = 0;
+	unsigned char* pixels = stbtt_GetGlyphSDF(&source.info, source.scale, glyph, PADDING, ON_EDGE, PIXEL_DIST_SCALE,
+		&width, &height, &xoff, &yoff);
+	int advance, lsb;
+	stbtt_GetGlyphHMetrics(&source.info, glyph, &advance, &lsb);
+	if(!pixels) {
+		source.font->AddGlyph(nullptr, (ImWchar)cp, 0, 0, 0, 0, 0, 0, 0, 0, advance * source.scale);
+		return true;
+	}
+
+	// shelf packing, one glyph height per row
+	const int gap = atlas->TexGlyphPadding;
+	if(g_lazyArea.x + width > atlas->TexWidth) {
+		g_lazyArea.x = 0;
+		g_lazyArea.y += g_lazyArea.rowHeight + gap;
+		g_lazyArea.rowHeight = 0;
+	}
+	if(g_lazyArea.y + height > g_lazyArea.bottom) {
+		stbtt_FreeSDF(pixels, nullptr);
+		return false;
+	}
+	int x = g_lazyArea.x, y = g_lazyArea.y;
+	g_lazyArea.x += width + gap;
+	if(height > g_lazyArea.rowHeight) {
+		g_lazyArea.rowHeight = height;
+	}
+
+	// the atlas' CPU pixels are gone by now, the bitmap goes straight to the texture
+	stUpload upload;
+	upload.x = x;
+	upload.y = y;
+	upload.width = width;
+	upload.height = height;
+	upload.pixels = pixels;
+	g_uploads.push_back(upload);
+
+	float x0 = xoff + source.offset.x, y0 = yoff + source.offset.y;
+	source.font->AddGlyph(nullptr, (ImWchar)cp, x0, y0, x0 + width, y0 + height,
+		x * atlas->TexUvScale.x, y * atlas->TexUvScale.y,
+		(x + width) * atlas->TexUvScale.x, (y + height) * atlas->TexUvScale.y, advance * source.scale);
+	return true;
+}
+
+void sdffont::RequestGlyphs(const ImFont* font, const char* text, const char* textEnd)
+{
+	if(g_lazy.empty()) {
+		return;
+	}
+	if(!textEnd) {
+		textEnd = text + strlen(text);
+	}
+	for(stLazySource& source : g_lazy) {
+		if(source.font != font) {
+			continue;
+		}
+		bool added = false;
+		for(const char* s = text; s < textEnd;) {
+			// everything the icon fonts cover is outside ASCII
+			if((unsigned char)*s < 0x80) {
+				s++;
+				continue;
+			}
+			unsigned int cp;
+			s += ImTextCharFromUtf8(&cp, s, textEnd);
+			if(cp >= 0x10000 || source.tried[cp]) {
+				continue;
+			}
+			bool inRange = false;
+			for(const ImWchar* r = source.ranges; r[0] && r[1]; r += 2) {
+				if(cp >= r[0] && cp <= r[1]) {
+					inRange = true;
+					break;
+				}
+			}
+			if(!inRange) {
+				continue;
+			}
+			source.tried[cp] = true;
+			if(source.font->FindGlyphNoFallback((ImWchar)cp)) {
+				continue;
+			}
+			if(!Inflate(source)) {
+				break;
+			}
+			if(!AddLazyGlyph(source, cp)) {
+				IM_ASSERT(0 && "lazy glyph area is full");
+				break;
+			}
+			added = true;
+		}
+		if(added) {
+			source.font->BuildLookupTable();
+		}
+	}
+}
+
+const void* sdffont::GetCompressedTexture(int* size)
+{
+	*size = g_blocksSize;
+	return g_blocks;
+}
+
+// Copies a lazy glyph into the alpha8 rows and re-encodes every block it touches
+static void UploadBlocks(ImFontAtlas* atlas, const sdffont::stUpload& glyph, sdffont::UploadBlocksFn uploadBlocks)
+{
+	using namespace sdffont;
+	int stride = atlas->TexWidth;
+	unsigned char* area = g_lazyPixels.data() - g_lazyArea.top * stride;
+	for(int y = 0; y < glyph.height; y++) {
+		memcpy(area + (glyph.y + y) * stride + glyph.x, glyph.pixels + y * glyph.width, glyph.width);
+	}
+	int x0 = glyph.x & ~3, y0 = glyph.y & ~3;
+	int x1 = (glyph.x + glyph.width + 3) & ~3, y1 = (glyph.y + glyph.height + 3) & ~3;
+	static std::vector<unsigned char> blocks;
+	blocks.resize((x1 - x0) * (y1 - y0) / 2);
+	EncodeEac(area + y0 * stride + x0, stride, x1 - x0, y1 - y0, blocks.data());
+	uploadBlocks(x0, y0, x1 - x0, y1 - y0, blocks.data(), (int)blocks.size());
+}
+
+void sdffont::EndFrame(ImFontAtlas* atlas, UploadFn upload, UploadBlocksFn uploadBlocks)
+{
+	for(const stUpload& glyph : g_uploads) {
+		if(g_lazyPixels.empty()) {
+			upload(glyph.x, glyph.y, glyph.width, glyph.height, glyph.pixels);
+		} else {
+			UploadBlocks(atlas, glyph, uploadBlocks);
+		}
+		stbtt_FreeSDF(glyph.pixels, nullptr);
+	}
+	g_uploads.clear();
+
+	// the texture has its copy, lazy glyphs never read the CPU one
+	if(atlas->TexID && (atlas->TexPixelsAlpha8 || atlas->TexPixelsRGBA32)) {
+		atlas->ClearTexData();
+	}
+	if(atlas->TexID && g_blocks) {
+		IM_FREE(g_blocks);
+		g_blocks = nullptr;
+		g_blocksSize = 0;
+	}
+	for(stLazySource& source : g_lazy) {
+		if(!source.ttf.empty() && ++source.idleFrames > LAZY_IDLE_FRAMES) {
+			Deflate(source);
+		}
+	}
+}
+
+bool sdffont::IsSdf(const ImFont* font)
+{
+	return Find(font) != nullptr;
+}
+
+float sdffont::OutlineWidth(float pixels, float fontSize)
+{
+	float width = pixels * (BASE_SIZE / fontSize) * PIXEL_DIST_SCALE / 255.f;
+	// the field only extends PADDING pixels past the glyph edge
+	float limit = (float)ON_EDGE / 255.f - 0.02f;
+	return width < limit ? width : limit;
+}
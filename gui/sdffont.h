@@ -0,0 +1,58 @@
+#pragma once
+
+#include "vendor/imgui/imgui.h"
+
+#include <vector>
+
+// Fonts whose glyphs are stored in the atlas as signed distance fields, baked once
+// at BASE_SIZE and drawn at any size (font->Scale) by the backend's SDF shader.
+namespace sdffont
+{
+	constexpr float BASE_SIZE = 32.f;
+	constexpr int PADDING = 4;
+	constexpr unsigned char ON_EDGE = 128;
+	constexpr float PIXEL_DIST_SCALE = (float)ON_EDGE / PADDING;
+
+	// how Save stores the atlas texture
+	enum eTexFormat
+	{
+		TEX_ALPHA8,
+		// GL_COMPRESSED_R11_EAC, a GLES3 baseline format at half a byte per texel
+		TEX_EAC_R11,
+	};
+
+	// Queues a font for the next Build. With mergeInto the glyphs are added to that
+	// SDF font instead; glyphOffset is in BASE_SIZE pixels.
+	ImFont* AddFont(ImFontAtlas* atlas, const unsigned char* ttf, int ttfSize, const ImWchar* ranges,
+		ImFont* mergeInto = nullptr, const ImVec2& glyphOffset = ImVec2(0, 0));
+	// Builds the atlas and writes the queued distance fields into it
+	bool Build(ImFontAtlas* atlas);
+	bool IsSdf(const ImFont* font);
+	// Serialises every SDF font (in AddFont order) and the atlas texture into one zlib blob
+	bool Save(ImFontAtlas* atlas, std::vector<unsigned char>* out, eTexFormat format = TEX_ALPHA8);
+	// Replaces the atlas contents with a blob written by Save. Returns the number of fonts
+	// stored in fonts[], 0 if the blob is unusable. extraRows of empty texture are reserved
+	// below the baked glyphs for AddLazyFont.
+	int Load(ImFontAtlas* atlas, const unsigned char* blob, unsigned int size, ImFont** fonts, int maxFonts, int extraRows = 0);
+	// After Load of a TEX_EAC_R11 blob the atlas has no CPU pixels; the texture is made from these
+	// blocks instead, which EndFrame frees once it exists. nullptr for alpha8 atlases.
+	const void* GetCompressedTexture(int* size);
+	// Merges ranges of a zlib-packed TTF (tools/fontbake --pack) into a loaded SDF font without
+	// baking them. A glyph is rasterised into the reserved rows the first time RequestGlyphs
+	// sees it; the TTF is inflated for that and dropped again once no new glyphs come in for a
+	// while. packed must outlive the atlas.
+	bool AddLazyFont(ImFont* mergeInto, const unsigned char* packed, unsigned int packedSize, unsigned int ttfSize,
+		const ImWchar* ranges, const ImVec2& glyphOffset = ImVec2(0, 0));
+	// Call with text before it is drawn with font so any lazy glyphs in it exist
+	void RequestGlyphs(const ImFont* font, const char* text, const char* textEnd = nullptr);
+	// alpha8 pixels for the font texture rectangle x, y, w, h, rows w bytes apart
+	typedef void (*UploadFn)(int x, int y, int w, int h, const unsigned char* alpha);
+	// the same for an EAC atlas: x, y, w, h are multiples of 4 and blocks holds size bytes
+	typedef void (*UploadBlocksFn)(int x, int y, int w, int h, const void* blocks, int size);
+	// Once per frame, after ImGui::Render and before the draw data is rendered: hands the
+	// glyphs rasterised this frame to upload (or uploadBlocks), then frees the atlas' CPU
+	// pixels once the texture exists and any TTF that has been idle for a while.
+	void EndFrame(ImFontAtlas* atlas, UploadFn upload, UploadBlocksFn uploadBlocks);
+	// Outline thickness in screen pixels, in the shader's distance units for text drawn at fontSize
+	float OutlineWidth(float pixels, float fontSize);
+}
@@ -0,0 +1,100 @@
+#include "textcache.h"
+#include "sdffont.h"
+
+#include "vendor/imgui/backend/imgui_impl_opengl3.h"
+
+#include <string.h>
+
+const ImVec2 CCachedText::OUTLINE_OFFSETS[8] = {
+	{-2.f, 0.f}, {2.f, 0.f}, {0.f, -2.f}, {0.f, 2.f},
+	{-2.f, -2.f}, {-2.f, 2.f}, {2.f, -2.f}, {2.f, 2.f}
+};
+
+bool CCachedText::IsValid(ImFont* font, float fontSize, const ImVec2& pos, ImU32 color, ImU32 outlineColor,
+	const ImVec2* offsets, int numOffsets, const char* text) const
+{
+	return m_pFont == font && m_fFontSize == fontSize
+		&& m_vPos.x == pos.x && m_vPos.y == pos.y
+		&& m_uColor == color && m_uOutlineColor == outlineColor
+		&& m_pOffsets == offsets && m_nOffsets == numOffsets
+		&& !strcmp(m_szText, text);
+}
+
+void CCachedText::Rebuild(ImDrawList* drawList)
+{
+	static ImDrawList* scratch = nullptr;
+	if(!scratch) {
+		scratch = IM_NEW(ImDrawList)(drawList->_Data);
+	}
+	scratch->_ResetForNewFrame();
+	scratch->Flags = drawList->Flags;
+	scratch->PushTextureID(m_pFont->ContainerAtlas->TexID);
+	scratch->PushClipRectFullScreen();
+
+	for(int i = 0; i < m_nOffsets; i++) {
+		scratch->AddText(m_pFont, m_fFontSize, ImVec2(m_vPos.x + m_pOffsets[i].x, m_vPos.y + m_pOffsets[i].y), m_uOutlineColor, m_szText);
+	}
+	scratch->AddText(m_pFont, m_fFontSize, m_vPos, m_uColor, m_szText);
+
+	m_vertices.resize(scratch->VtxBuffer.Size);
+	memcpy(m_vertices.Data, scratch->VtxBuffer.Data, scratch->VtxBuffer.Size * sizeof(ImDrawVert));
+	m_indices.resize(scratch->IdxBuffer.Size);
+	memcpy(m_indices.Data, scratch->IdxBuffer.Data, scratch->IdxBuffer.Size * sizeof(ImDrawIdx));
+}
+
+void CCachedText::Draw(ImDrawList* drawList, ImFont* font, float fontSize, const ImVec2& pos,
+	ImU32 color, ImU32 outlineColor, const ImVec2* offsets, int numOffsets, const char* text)
+{
+	// the batch is only valid with the font atlas bound, otherwise draw it the slow way
+	if(drawList->_TextureIdStack.Size == 0 || drawList->_TextureIdStack.back() != font->ContainerAtlas->TexID
+		|| strlen(text) >= sizeof(m_szText)) {
+		for(int i = 0; i < numOffsets; i++) {
+			drawList->AddText(font, fontSize, ImVec2(pos.x + offsets[i].x, pos.y + offsets[i].y), outlineColor, text);
+		}
+		drawList->AddText(font, fontSize, pos, color, text);
+		return;
+	}
+
+	if(!IsValid(font, fontSize, pos, color, outlineColor, offsets, numOffsets, text)) {
+		strncpy(m_szText, text, sizeof(m_szText) - 1);
+		m_szText[sizeof(m_szText) - 1] = 0;
+		m_pFont = font;
+		m_fFontSize = fontSize;
+		m_vPos = pos;
+		m_uColor = color;
+		m_uOutlineColor = outlineColor;
+		m_pOffsets = offsets;
+		m_nOffsets = numOffsets;
+		sdffont::RequestGlyphs(font, m_szText);
+		Rebuild(drawList);
+	}
+
+	if(m_indices.Size == 0) {
+		return;
+	}
+	drawList->PrimReserve(m_indices.Size, m_vertices.Size);
+	ImDrawIdx base = (ImDrawIdx)drawList->_VtxCurrentIdx;
+	memcpy(drawList->_VtxWritePtr, m_vertices.Data, m_vertices.Size * sizeof(ImDrawVert));
+	for(int i = 0; i < m_indices.Size; i++) {
+		drawList->_IdxWritePtr[i] = (ImDrawIdx)(base + m_indices.Data[i]);
+	}
+	drawList->_VtxWritePtr += m_vertices.Size;
+	drawList->_IdxWritePtr += m_indices.Size;
+	drawList->_VtxCurrentIdx += m_vertices.Size;
+}
+
+void CCachedText::DrawOutlined(ImDrawList* drawList, ImFont* font, float fontSize, const ImVec2& pos,
+	ImU32 color, ImU32 outlineColor, float thickness, const char* text)
+{
+	if(!sdffont::IsSdf(font)) {
+		Draw(drawList, font, fontSize, pos, color, outlineColor, OUTLINE_OFFSETS, IM_ARRAYSIZE(OUTLINE_OFFSETS), text);
+		return;
+	}
+
+	ImGui_ImplOpenGL3_SdfOutline outline;
+	outline.Width = sdffont::OutlineWidth(thickness, fontSize);
+	outline.Color = ImGui::ColorConvertU32ToFloat4(outlineColor);
+	drawList->AddCallback(ImGui_ImplOpenGL3_SdfOutlineCallback, &outline, sizeof(outline));
+	Draw(drawList, font, fontSize, pos, color, outlineColor, nullptr, 0, text);
+	drawList->AddCallback(ImGui_ImplOpenGL3_SdfOutlineCallback, nullptr);
+}
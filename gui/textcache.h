@@ -0,0 +1,37 @@
+#pragma once
+
+#include "vendor/imgui/imgui.h"
+
+// One line of text drawn with a set of offset copies behind it (outline/shadow).
+// The glyph geometry for all passes is laid out once and replayed as a single
+// vertex batch until the text, font, position or colours change.
+class CCachedText
+{
+public:
+	CCachedText() : m_pFont(nullptr), m_fFontSize(0.f), m_uColor(0), m_uOutlineColor(0),
+		m_pOffsets(nullptr), m_nOffsets(0) { m_szText[0] = 0; }
+
+	void Draw(ImDrawList* drawList, ImFont* font, float fontSize, const ImVec2& pos,
+		ImU32 color, ImU32 outlineColor, const ImVec2* offsets, int numOffsets, const char* text);
+	// Outline of the given thickness: one shader pass for SDF fonts, OUTLINE_OFFSETS copies otherwise
+	void DrawOutlined(ImDrawList* drawList, ImFont* font, float fontSize, const ImVec2& pos,
+		ImU32 color, ImU32 outlineColor, float thickness, const char* text);
+
+	static const ImVec2 OUTLINE_OFFSETS[8];
+private:
+	bool IsValid(ImFont* font, float fontSize, const ImVec2& pos, ImU32 color, ImU32 outlineColor,
+		const ImVec2* offsets, int numOffsets, const char* text) const;
+	void Rebuild(ImDrawList* drawList);
+
+	char m_szText[128];
+	ImFont* m_pFont;
+	float m_fFontSize;
+	ImVec2 m_vPos;
+	ImU32 m_uColor;
+	ImU32 m_uOutlineColor;
+	const ImVec2* m_pOffsets;
+	int m_nOffsets;
+
+	ImVector<ImDrawVert> m_vertices;
+	ImVector<ImDrawIdx> m_indices;
+};
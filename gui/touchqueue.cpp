@@ -0,0 +1,54 @@
+#include "touchqueue.h"
+
+#include <cfloat>
+
+CTouchQueue::stEvent CTouchQueue::m_events[CTouchQueue::CAPACITY];
+std::atomic<uint32_t> CTouchQueue::m_head(0);
+std::atomic<uint32_t> CTouchQueue::m_tail(0);
+std::atomic<bool> CTouchQueue::m_bOverflow(false);
+
+void CTouchQueue::Push(int action, int pointer, int x, int y)
+{
+	if(pointer < 0 || pointer >= ImGuiMouseButton_COUNT) {
+		return;
+	}
+	uint32_t head = m_head.load(std::memory_order_relaxed);
+	if(head - m_tail.load(std::memory_order_acquire) == CAPACITY) {
+		// nothing is rendering; a lost up would leave a button stuck, so say so
+		m_bOverflow.store(true, std::memory_order_release);
+		return;
+	}
+	stEvent& event = m_events[head & (CAPACITY - 1)];
+	event.x = (int16_t)x;
+	event.y = (int16_t)y;
+	event.action = (uint8_t)action;
+	event.pointer = (uint8_t)pointer;
+	m_head.store(head + 1, std::memory_order_release);
+}
+
+void CTouchQueue::Drain(ImGuiIO& io)
+{
+	uint32_t tail = m_tail.load(std::memory_order_relaxed);
+	uint32_t head = m_head.load(std::memory_order_acquire);
+	for(; tail != head; tail++)
+	{
+		const stEvent& event = m_events[tail & (CAPACITY - 1)];
+		io.AddMouseSourceEvent(ImGuiMouseSource_TouchScreen);
+		io.AddMousePosEvent((float)event.x, (float)event.y);
+		if(event.action == TOUCH_DOWN) {
+			io.AddMouseButtonEvent(event.pointer, true);
+		} else if(event.action == TOUCH_UP) {
+			io.AddMouseButtonEvent(event.pointer, false);
+			// a finger that lifted isn't hovering anything
+			io.AddMousePosEvent(-FLT_MAX, -FLT_MAX);
+		}
+	}
+	m_tail.store(tail, std::memory_order_release);
+
+	if(m_bOverflow.exchange(false, std::memory_order_acquire)) {
+		for(int button = 0; button < ImGuiMouseButton_COUNT; button++) {
+			io.AddMouseButtonEvent(button, false);
+		}
+		io.AddMousePosEvent(-FLT_MAX, -FLT_MAX);
+	}
+}
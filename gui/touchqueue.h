@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "vendor/imgui/imgui.h"
+
+// Touch events from the Java UI thread to the overlay on the GL thread. One producer and
+// one consumer, so the ring needs no locks. Drain feeds everything queued into ImGui's own
+// event queue at the start of a frame, so a tap that goes down and up between two frames
+// still registers (ImGui trickles it over both).
+class CTouchQueue
+{
+public:
+	enum eAction
+	{
+		TOUCH_DOWN = 0,
+		TOUCH_UP = 1,
+		TOUCH_MOVE = 2,
+	};
+
+	// UI thread
+	static void Push(int action, int pointer, int x, int y);
+	// GL thread, before ImGui::NewFrame
+	static void Drain(ImGuiIO& io);
+	// GL thread; events the UI thread queued since the last drain
+	static bool HasPending() { return m_head.load(std::memory_order_acquire) != m_tail.load(std::memory_order_relaxed); }
+
+private:
+	struct stEvent
+	{
+		int16_t x, y;
+		uint8_t action;
+		uint8_t pointer;
+	};
+
+	// must stay a power of two
+	static constexpr uint32_t CAPACITY = 256;
+	static stEvent m_events[CAPACITY];
+	static std::atomic<uint32_t> m_head;
+	static std::atomic<uint32_t> m_tail;
+	// set when an event had to be dropped; every button is released on the next drain
+	static std::atomic<bool> m_bOverflow;
+};
@@ -0,0 +1,145 @@
+#include "worldlabels.h"
+
+#include <cfloat>
+#include <string.h>
+
+#include "game/math/simd.h"
+
+float CWorldLabels::m_x[CAPACITY];
+float CWorldLabels::m_y[CAPACITY];
+float CWorldLabels::m_z[CAPACITY];
+ImU32 CWorldLabels::m_colors[CAPACITY];
+char CWorldLabels::m_text[CAPACITY][MAX_TEXT];
+int CWorldLabels::m_nLabels = 0;
+
+float CWorldLabels::m_screenX[CAPACITY];
+float CWorldLabels::m_screenY[CAPACITY];
+uint8_t CWorldLabels::m_visible[CAPACITY];
+
+// same near plane as CSprite::CalcScreenCoors, the far one is about where nametags stop
+static constexpr float NEAR_DEPTH = 1.f;
+static constexpr float FAR_DEPTH = 150.f;
+// in screens, so a label centred just off the edge still shows its inner half
+static constexpr float EDGE_MARGIN = 0.1f;
+
+bool CWorldLabels::Add(const CVector& pos, ImU32 color, const char* text)
+{
+	if(m_nLabels >= MAX_LABELS) {
+		return false;
+	}
+	int i = m_nLabels++;
+	m_x[i] = pos.x;
+	m_y[i] = pos.y;
+	m_z[i] = pos.z;
+	m_colors[i] = color;
+	strncpy(m_text[i], text, MAX_TEXT - 1);
+	m_text[i][MAX_TEXT - 1] = 0;
+	return true;
+}
+
+#ifdef MATH_NEON
+static void Project(const float* px, const float* py, const float* pz, int count, const CMatrix& view,
+	float width, float height, float* outX, float* outY, uint8_t* outVisible)
+{
+	const float32x4_t nearDepth = vdupq_n_f32(NEAR_DEPTH);
+	const float32x4_t farDepth = vdupq_n_f32(FAR_DEPTH);
+	const float32x4_t minX = vdupq_n_f32(-EDGE_MARGIN * width), maxX = vdupq_n_f32((1.f + EDGE_MARGIN) * width);
+	const float32x4_t minY = vdupq_n_f32(-EDGE_MARGIN * height), maxY = vdupq_n_f32((1.f + EDGE_MARGIN) * height);
+
+	for(int i = 0; i < count; i += 4)
+	{
+		float32x4_t vx, vy, vz;
+		math::Transform4(view, vld1q_f32(px + i), vld1q_f32(py + i), vld1q_f32(pz + i), vx, vy, vz);
+
+		// estimate plus two Newton steps is well under a pixel on any screen
+		float32x4_t recip = vrecpeq_f32(vz);
+		recip = vmulq_f32(vrecpsq_f32(vz, recip), recip);
+		recip = vmulq_f32(vrecpsq_f32(vz, recip), recip);
+		float32x4_t sx = vmulq_n_f32(vmulq_f32(vx, recip), width);
+		float32x4_t sy = vmulq_n_f32(vmulq_f32(vy, recip), height);
+
+		uint32x4_t visible = vandq_u32(vcgtq_f32(vz, nearDepth), vcltq_f32(vz, farDepth));
+		visible = vandq_u32(visible, vandq_u32(vcgeq_f32(sx, minX), vcleq_f32(sx, maxX)));
+		visible = vandq_u32(visible, vandq_u32(vcgeq_f32(sy, minY), vcleq_f32(sy, maxY)));
+
+		vst1q_f32(outX + i, sx);
+		vst1q_f32(outY + i, sy);
+		uint16x4_t narrow = vmovn_u32(visible);
+		vst1_lane_u32((uint32_t*)(outVisible + i), vreinterpret_u32_u8(vmovn_u16(vcombine_u16(narrow, narrow))), 0);
+	}
+}
+#elif defined(MATH_SSE)
+static void Project(const float* px, const float* py, const float* pz, int count, const CMatrix& view,
+	float width, float height, float* outX, float* outY, uint8_t* outVisible)
+{
+	const __m128 nearDepth = _mm_set1_ps(NEAR_DEPTH);
+	const __m128 farDepth = _mm_set1_ps(FAR_DEPTH);
+	const __m128 minX = _mm_set1_ps(-EDGE_MARGIN * width), maxX = _mm_set1_ps((1.f + EDGE_MARGIN) * width);
+	const __m128 minY = _mm_set1_ps(-EDGE_MARGIN * height), maxY = _mm_set1_ps((1.f + EDGE_MARGIN) * height);
+
+	for(int i = 0; i < count; i += 4)
+	{
+		__m128 vx, vy, vz;
+		math::Transform4(view, _mm_loadu_ps(px + i), _mm_loadu_ps(py + i), _mm_loadu_ps(pz + i), vx, vy, vz);
+
+		__m128 sx = _mm_mul_ps(_mm_div_ps(vx, vz), _mm_set1_ps(width));
+		__m128 sy = _mm_mul_ps(_mm_div_ps(vy, vz), _mm_set1_ps(height));
+
+		__m128 visible = _mm_and_ps(_mm_cmpgt_ps(vz, nearDepth), _mm_cmplt_ps(vz, farDepth));
+		visible = _mm_and_ps(visible, _mm_and_ps(_mm_cmpge_ps(sx, minX), _mm_cmple_ps(sx, maxX)));
+		visible = _mm_and_ps(visible, _mm_and_ps(_mm_cmpge_ps(sy, minY), _mm_cmple_ps(sy, maxY)));
+
+		_mm_storeu_ps(outX + i, sx);
+		_mm_storeu_ps(outY + i, sy);
+		int mask = _mm_movemask_ps(visible);
+		for(int lane = 0; lane < 4; lane++) {
+			outVisible[i + lane] = (mask >> lane) & 1;
+		}
+	}
+}
+#else
+static void Project(const float* px, const float* py, const float* pz, int count, const CMatrix& view,
+	float width, float height, float* outX, float* outY, uint8_t* outVisible)
+{
+	for(int i = 0; i < count; i++)
+	{
+		CVector v = view.TransformPoint(CVector(px[i], py[i], pz[i]));
+		if(v.z <= NEAR_DEPTH || v.z >= FAR_DEPTH) {
+			outVisible[i] = 0;
+			continue;
+		}
+		float sx = v.x / v.z * width;
+		float sy = v.y / v.z * height;
+		outX[i] = sx;
+		outY[i] = sy;
+		outVisible[i] = sx >= -EDGE_MARGIN * width && sx <= (1.f + EDGE_MARGIN) * width
+			&& sy >= -EDGE_MARGIN * height && sy <= (1.f + EDGE_MARGIN) * height;
+	}
+}
+#endif
+
+void CWorldLabels::Render(ImDrawList* drawList, ImFont* font, float fontSize, const CMatrix& view,
+	float screenWidth, float screenHeight)
+{
+	int count = m_nLabels;
+	m_nLabels = 0;
+	if(!count || !font) {
+		return;
+	}
+
+	Project(m_x, m_y, m_z, count, view, screenWidth, screenHeight, m_screenX, m_screenY, m_visible);
+
+	// no clip rect or texture changes in between, so this all stays one ImDrawCmd
+	for(int i = 0; i < count; i++)
+	{
+		if(!m_visible[i]) {
+			continue;
+		}
+		const char* text = m_text[i];
+		ImVec2 size = font->CalcTextSizeA(fontSize, FLT_MAX, 0.f, text);
+		ImVec2 pos(m_screenX[i] - size.x * 0.5f, m_screenY[i] - size.y);
+		ImU32 shadow = m_colors[i] & IM_COL32_A_MASK;
+		drawList->AddText(font, fontSize, ImVec2(pos.x + 1.f, pos.y + 1.f), shadow, text);
+		drawList->AddText(font, fontSize, pos, m_colors[i], text);
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+#include "vendor/imgui/imgui.h"
+
+#include "game/math/matrix.h"
+
+// Text anchored to world positions, collected during the frame and drawn together from
+// CGUI::Render2dStuff. Positions are kept as separate x/y/z arrays so they go through the
+// camera matrix four at a time; whatever is behind the camera, off screen or too far away
+// is dropped before any text is laid out. Every label lands in the one draw list with the
+// one font, so ImGui merges the lot into a single draw command. GL thread only.
+class CWorldLabels
+{
+public:
+	static constexpr int MAX_LABELS = 1024;
+	static constexpr int MAX_TEXT = 32;
+
+	// false once the batch is full; text longer than MAX_TEXT - 1 is cut
+	static bool Add(const CVector& pos, ImU32 color, const char* text);
+	// view is the game's camera matrix: after the divide by depth, x and y run 0..1 across
+	// the screen (what CSprite::CalcScreenCoors does). Empties the batch.
+	static void Render(ImDrawList* drawList, ImFont* font, float fontSize, const CMatrix& view,
+		float screenWidth, float screenHeight);
+	static void Clear() { m_nLabels = 0; }
+
+	static int GetCount() { return m_nLabels; }
+private:
+	// rounded up so the last group of four never reads past the end
+	static constexpr int CAPACITY = (MAX_LABELS + 3) & ~3;
+
+	static float m_x[CAPACITY];
+	static float m_y[CAPACITY];
+	static float m_z[CAPACITY];
+	static ImU32 m_colors[CAPACITY];
+	static char m_text[CAPACITY][MAX_TEXT];
+	static int m_nLabels;
+
+	// projected screen position, valid where m_visible is set
+	static float m_screenX[CAPACITY];
+	static float m_screenY[CAPACITY];
+	static uint8_t m_visible[CAPACITY];
+};
@@ -0,0 +1,278 @@
+#include "hook.h"
+
+#include <algorithm>
+#include <android/log.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "xorstr.h"
+#include "vendor/Dobby/include/dobby.h"
+#include "vendor/Substrate/CydiaSubstrate.h"
+#include "vendor/And64InlineHook/And64InlineHook.hpp"
+
+// Substrate unless measured otherwise. eglSwapBuffers lives in libEGL, where Dobby has
+// always been the one used; the RakClient virtuals are only ever called through the vtable.
+static const eHookBackend g_backends[HOOK_TARGET_COUNT] = {
+	eHookBackend::DOBBY,		// HOOK_EGL_SWAP_BUFFERS
+	eHookBackend::SUBSTRATE,	// HOOK_JNILIB_STEP
+	eHookBackend::SUBSTRATE,	// HOOK_PROCESS_NETWORK
+	eHookBackend::SUBSTRATE,	// HOOK_REGISTER_RPC
+	eHookBackend::VTABLE,		// HOOK_RAKCLIENT_CONNECT
+	eHookBackend::VTABLE,		// HOOK_RAKCLIENT_SEND
+	eHookBackend::VTABLE,		// HOOK_RAKCLIENT_RPC
+	eHookBackend::SUBSTRATE,	// HOOK_PACKET_TURNLIGHTS
+	eHookBackend::SUBSTRATE,	// HOOK_SET_SERVER_LOGO
+};
+
+static const char* const g_hookNames[HOOK_TARGET_COUNT] = {
+	"eglSwapBuffers",
+	"JNILib_step",
+	"ProcessNetwork",
+	"RegisterAsRemoteProcedureCall",
+	"RakClient::Connect",
+	"RakClient::Send",
+	"RakClient::RPC",
+	"Packet_Turnlights",
+	"SetServerLogo",
+};
+
+// the overlay and its frame work, a debug echo, and the logo cache; everything else
+// is the translation layer itself
+static const bool g_bypassable[HOOK_TARGET_COUNT] = {
+	true,	// HOOK_EGL_SWAP_BUFFERS
+	false,	// HOOK_JNILIB_STEP
+	false,	// HOOK_PROCESS_NETWORK
+	false,	// HOOK_REGISTER_RPC
+	false,	// HOOK_RAKCLIENT_CONNECT
+	false,	// HOOK_RAKCLIENT_SEND
+	false,	// HOOK_RAKCLIENT_RPC
+	true,	// HOOK_PACKET_TURNLIGHTS
+	true,	// HOOK_SET_SERVER_LOGO
+};
+
+stHookRecord CHook::m_records[HOOK_TARGET_COUNT];
+std::atomic<bool> CHook::m_timing(false);
+
+const char* CHook::GetName(eHookTarget target)
+{
+	return g_hookNames[target];
+}
+
+eHookTarget CHook::FromName(const char* name)
+{
+	for(int i = 0; i < HOOK_TARGET_COUNT; i++) {
+		if(!strcmp(name, g_hookNames[i])) {
+			return (eHookTarget)i;
+		}
+	}
+	return HOOK_TARGET_COUNT;
+}
+
+bool CHook::CanBypass(eHookTarget target)
+{
+	return g_bypassable[target];
+}
+
+void CHook::SetBypassed(eHookTarget target, bool bypassed)
+{
+	if(CanBypass(target)) {
+		m_records[target].bypassed.store(bypassed, std::memory_order_relaxed);
+	}
+}
+
+void CHook::ResetCounters()
+{
+	for(stHookRecord& record : m_records) {
+		record.calls.store(0, std::memory_order_relaxed);
+		record.ns.store(0, std::memory_order_relaxed);
+	}
+}
+
+void CHook::Record(eHookTarget target, void* address, void** orig)
+{
+	stHookRecord& record = m_records[target];
+	record.address = address;
+	record.orig = orig ? *orig : nullptr;
+	record.installed = true;
+}
+
+eHookBackend CHook::BackendFor(eHookTarget target)
+{
+#if defined(__aarch64__)
+	if(g_backends[target] == eHookBackend::SUBSTRATE) {
+		return eHookBackend::AND64;
+	}
+#endif
+	return g_backends[target];
+}
+
+bool CHook::Install(eHookTarget target, void* address, void* replace, void** orig)
+{
+	if(Install(BackendFor(target), address, replace, orig)) {
+		Record(target, address, orig);
+		return true;
+	}
+	__android_log_print(ANDROID_LOG_INFO, xorstr("Hook"), xorstr("failed to hook target %d at %p"), (int)target, address);
+	return false;
+}
+
+bool CHook::Install(eHookBackend backend, void* address, void* replace, void** orig)
+{
+	if(!address) {
+		return false;
+	}
+	switch(backend)
+	{
+		case eHookBackend::VTABLE:
+			// there is no slot to patch here, fall back to the code
+			return Install(eHookBackend::SUBSTRATE, address, replace, orig);
+		case eHookBackend::DOBBY:
+			return DobbyHook(address, replace, orig) == 0;
+		case eHookBackend::SUBSTRATE:
+#if !defined(__aarch64__)
+			if(orig) {
+				*orig = nullptr;
+			}
+			MSHookFunction(address, replace, orig);
+			return !orig || *orig;
+#else
+			return false;
+#endif
+		case eHookBackend::AND64:
+#if defined(__aarch64__)
+			if(orig) {
+				*orig = nullptr;
+			}
+			A64HookFunction(address, replace, orig);
+			return !orig || *orig;
+#else
+			return false;
+#endif
+	}
+	return false;
+}
+
+bool CHook::InstallSlot(eHookTarget target, uintptr_t* slot, void* replace, void** orig)
+{
+	bool vtable = BackendFor(target) == eHookBackend::VTABLE;
+	void* address = vtable ? (void*)slot : (void*)*slot;
+	bool installed = vtable ? PatchSlot(slot, replace, orig) : Install(BackendFor(target), address, replace, orig);
+	if(!installed) {
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Hook"), xorstr("failed to hook slot %d at %p"), (int)target, slot);
+		return false;
+	}
+	Record(target, address, orig);
+	return true;
+}
+
+bool CHook::PatchSlot(uintptr_t* slot, void* replace, void** orig, bool protect)
+{
+	long pageSize = sysconf(_SC_PAGESIZE);
+	uintptr_t page = (uintptr_t)slot & ~(uintptr_t)(pageSize - 1);
+	// vtables sit in .data.rel.ro, read-only once the loader is done with relocations
+	if(protect && mprotect((void*)page, pageSize, PROT_READ | PROT_WRITE) != 0) {
+		return false;
+	}
+	if(orig) {
+		*orig = (void*)*slot;
+	}
+	// an aligned word store, so a call racing the patch sees one pointer or the other
+	__atomic_store_n(slot, (uintptr_t)replace, __ATOMIC_RELEASE);
+	if(protect) {
+		mprotect((void*)page, pageSize, PROT_READ);
+	}
+	return true;
+}
+
+// the most an inline backend rewrites at a hook's entry; And64InlineHook opens 40 bytes
+static constexpr size_t PATCH_SPAN = 64;
+
+static void SetMemoryPrepared(bool prepared)
+{
+#if defined(__aarch64__)
+	A64SetMemoryPrepared(prepared);
+#else
+	MSSetMemoryPrepared(prepared);
+#endif
+}
+
+void CHookBatch::Install(eHookTarget target, void* address, void* replace, void** orig)
+{
+	m_pending.push_back({ target, address, nullptr, replace, orig });
+}
+
+void CHookBatch::InstallSlot(eHookTarget target, uintptr_t* slot, void* replace, void** orig)
+{
+	if(CHook::BackendFor(target) != eHookBackend::VTABLE) {
+		Install(target, (void*)*slot, replace, orig);
+		return;
+	}
+	m_pending.push_back({ target, nullptr, slot, replace, orig });
+}
+
+void CHookBatch::AddRun(std::vector<stPageRun>& runs, uintptr_t address, size_t size, bool code)
+{
+	uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+	uintptr_t start = address & ~(pageSize - 1);
+	uintptr_t end = (address + size + pageSize - 1) & ~(pageSize - 1);
+	for(stPageRun& run : runs) {
+		if(run.code == code && start <= run.end && end >= run.start) {
+			run.start = std::min(run.start, start);
+			run.end = std::max(run.end, end);
+			return;
+		}
+	}
+	runs.push_back({ start, end, code });
+}
+
+bool CHookBatch::Commit()
+{
+	std::vector<stPageRun> runs;
+	for(const stPending& pending : m_pending) {
+		if(pending.slot) {
+			AddRun(runs, (uintptr_t)pending.slot, sizeof(uintptr_t), false);
+		} else if(pending.address && CHook::BackendFor(pending.target) != eHookBackend::DOBBY) {
+			// Thumb targets carry bit 0
+			AddRun(runs, (uintptr_t)pending.address & ~(uintptr_t)1, PATCH_SPAN, true);
+		}
+	}
+
+	size_t opened = 0;
+	for(; opened < runs.size(); opened++) {
+		const stPageRun& run = runs[opened];
+		int prot = run.code ? PROT_READ | PROT_WRITE | PROT_EXEC : PROT_READ | PROT_WRITE;
+		if(mprotect((void*)run.start, run.end - run.start, prot) != 0) {
+			break;
+		}
+	}
+	bool prepared = opened == runs.size();
+	if(!prepared) {
+		// the backends protect page by page again, as if there were no batch
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Hook"), xorstr("batch could not open %p, installing one by one"), (void*)runs[opened].start);
+		runs.resize(opened);
+	}
+
+	bool ok = true;
+	SetMemoryPrepared(prepared);
+	for(const stPending& pending : m_pending) {
+		if(pending.address || !pending.slot) {
+			ok &= CHook::Install(pending.target, pending.address, pending.replace, pending.orig);
+		} else if(!CHook::PatchSlot(pending.slot, pending.replace, pending.orig, !prepared)) {
+			__android_log_print(ANDROID_LOG_INFO, xorstr("Hook"), xorstr("failed to hook slot %d at %p"), (int)pending.target, pending.slot);
+			ok = false;
+		} else {
+			CHook::Record(pending.target, pending.slot, pending.orig);
+		}
+	}
+	SetMemoryPrepared(false);
+
+	for(const stPageRun& run : runs) {
+		if(run.code && prepared) {
+			__builtin___clear_cache((char*)run.start, (char*)run.end);
+		}
+		mprotect((void*)run.start, run.end - run.start, run.code ? PROT_READ | PROT_EXEC : PROT_READ);
+	}
+	m_pending.clear();
+	return ok;
+}
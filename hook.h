@@ -0,0 +1,178 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <time.h>
+#include <vector>
+
+enum class eHookBackend
+{
+	SUBSTRATE,
+	DOBBY,
+	// arm64 only, where it takes Substrate's place
+	AND64,
+	// rewrites a vtable slot instead of the code, only for targets installed with InstallSlot
+	VTABLE,
+};
+
+// Everything the plugin hooks, so the backend can be chosen per target
+enum eHookTarget
+{
+	HOOK_EGL_SWAP_BUFFERS,
+	HOOK_JNILIB_STEP,
+	HOOK_PROCESS_NETWORK,
+	HOOK_REGISTER_RPC,
+	HOOK_RAKCLIENT_CONNECT,
+	HOOK_RAKCLIENT_SEND,
+	HOOK_RAKCLIENT_RPC,
+	HOOK_PACKET_TURNLIGHTS,
+	HOOK_SET_SERVER_LOGO,
+	HOOK_TARGET_COUNT
+};
+
+// What the registry keeps per target. Calls are counted always, one relaxed add; time spent
+// in the replacement, the original included, only while timing is on.
+struct stHookRecord
+{
+	void* address = nullptr;	// the patched code, or the vtable slot
+	void* orig = nullptr;
+	bool installed = false;
+	std::atomic<bool> bypassed{false};
+	std::atomic<uint32_t> calls{0};
+	std::atomic<uint64_t> ns{0};
+};
+
+// One entry point for the inline hooking backends. Both patch the target's entry with a
+// jump to the replacement; what a hooked call costs on top of that is the trampoline
+// back into the original, which depends on how each backend relocates that particular
+// prologue. `netbench hook/` measures the backends on a device, and the table in
+// hook.cpp records the pick per target. Substrate patches ARM/Thumb and x86 but not
+// A64, And64InlineHook only A64, so on arm64-v8a every SUBSTRATE pick goes to AND64.
+class CHook
+{
+public:
+	static bool Install(eHookTarget target, void* address, void* replace, void** orig);
+	static bool Install(eHookBackend backend, void* address, void* replace, void** orig);
+	// for virtuals: swaps the slot under VTABLE, otherwise inline-hooks what it points to.
+	// A slot only catches calls made through the vtable, which for the game's RakClient
+	// is every call, and costs no trampoline on the way back.
+	static bool InstallSlot(eHookTarget target, uintptr_t* slot, void* replace, void** orig);
+	static eHookBackend BackendFor(eHookTarget target);
+
+	// The registry: every Install records its target here, so hooks can be measured and
+	// the optional ones switched off live for an A/B without a rebuild. A bypassed hook is
+	// still installed; its replacement checks IsBypassed first and hands the call straight
+	// to the original. Only targets the client works without can be bypassed.
+	static const stHookRecord& GetRecord(eHookTarget target) { return m_records[target]; }
+	// as brsamp.json's "hooksBypassed" names it; HOOK_TARGET_COUNT for an unknown one
+	static const char* GetName(eHookTarget target);
+	static eHookTarget FromName(const char* name);
+	static bool CanBypass(eHookTarget target);
+	static inline bool IsBypassed(eHookTarget target) { return m_records[target].bypassed.load(std::memory_order_relaxed); }
+	static void SetBypassed(eHookTarget target, bool bypassed);
+	static inline bool IsTiming() { return m_timing.load(std::memory_order_relaxed); }
+	static void SetTiming(bool timing) { m_timing.store(timing, std::memory_order_relaxed); }
+	static void ResetCounters();
+
+	template<typename Fn>
+	static inline bool Install(eHookTarget target, uintptr_t address, Fn* replace, Fn** orig)
+	{
+		return Install(target, (void*)address, (void*)replace, (void**)orig);
+	}
+	template<typename Fn>
+	static inline bool InstallSlot(eHookTarget target, uintptr_t slot, Fn* replace, Fn** orig)
+	{
+		return InstallSlot(target, (uintptr_t*)slot, (void*)replace, (void**)orig);
+	}
+
+private:
+	friend class CHookBatch;
+	friend class CHookScope;
+	// protect is false when the caller has already made the slot's page writable
+	static bool PatchSlot(uintptr_t* slot, void* replace, void** orig, bool protect = true);
+	static void Record(eHookTarget target, void* address, void** orig);
+
+	static stHookRecord m_records[HOOK_TARGET_COUNT];
+	static std::atomic<bool> m_timing;
+};
+
+// Counts a call into a hook replacement, and times it while CHook::IsTiming; put first in
+// the replacement. Nested hooks (ProcessNetwork and the RakClient hooks run inside
+// JNILib_step) are counted in both.
+class CHookScope
+{
+public:
+	explicit CHookScope(eHookTarget target) : m_target(target), m_start(CHook::IsTiming() ? Now() : 0)
+	{
+		CHook::m_records[target].calls.fetch_add(1, std::memory_order_relaxed);
+	}
+	~CHookScope()
+	{
+		if(m_start) {
+			CHook::m_records[m_target].ns.fetch_add(Now() - m_start, std::memory_order_relaxed);
+		}
+	}
+	CHookScope(const CHookScope&) = delete;
+	CHookScope& operator=(const CHookScope&) = delete;
+
+private:
+	static inline uint64_t Now()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+	}
+
+	eHookTarget m_target;
+	uint64_t m_start;
+};
+
+#define HOOK_SCOPE_CONCAT2(a, b) a##b
+#define HOOK_SCOPE_CONCAT(a, b) HOOK_SCOPE_CONCAT2(a, b)
+#define HOOK_SCOPE(target) CHookScope HOOK_SCOPE_CONCAT(hookScope, __LINE__)(target)
+
+// Hooks queued here go in together on Commit. Every page they patch changes protection
+// once, Substrate and And64InlineHook are told to leave protection and the icache alone,
+// and each patched run of pages is flushed once at the end, so startup pays a handful of
+// mprotect calls instead of two per hook and the hooks land back to back. Dobby manages
+// its own pages and installs one at a time as usual.
+class CHookBatch
+{
+public:
+	void Install(eHookTarget target, void* address, void* replace, void** orig);
+	void InstallSlot(eHookTarget target, uintptr_t* slot, void* replace, void** orig);
+	// false if any hook failed, each one is logged like CHook does
+	bool Commit();
+
+	template<typename Fn>
+	inline void Install(eHookTarget target, uintptr_t address, Fn* replace, Fn** orig)
+	{
+		Install(target, (void*)address, (void*)replace, (void**)orig);
+	}
+	template<typename Fn>
+	inline void InstallSlot(eHookTarget target, uintptr_t slot, Fn* replace, Fn** orig)
+	{
+		InstallSlot(target, (uintptr_t*)slot, (void*)replace, (void**)orig);
+	}
+
+private:
+	struct stPending
+	{
+		eHookTarget target;
+		void* address;		// inline target, null for a vtable slot
+		uintptr_t* slot;
+		void* replace;
+		void** orig;
+	};
+	struct stPageRun
+	{
+		uintptr_t start;
+		uintptr_t end;
+		bool code;
+	};
+
+	static void AddRun(std::vector<stPageRun>& runs, uintptr_t address, size_t size, bool code);
+
+	std::vector<stPending> m_pending;
+};
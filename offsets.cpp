@@ -1,74 +1,267 @@
 #include "offsets.h"
+
+#include <android/log.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "config.h"
+#include "sigscan.h"
 #include "xorstr.h"
 
-std::vector<COffset::stOffset> COffset::m_offsets;
+std::atomic<const COffset::Table*> COffset::m_pTable(nullptr);
 
-void COffset::Initialise()
+// Functions that can be found again in a build without a table of its own. Patterns are
+// taken from the default build; an offset is the match plus adjust (1 for a Thumb entry).
+// Data offsets can't be scanned for and always come from the default table.
+struct stSignature
 {
-	// 32 bit
-	Add(xorstr("RwInitialised"), 0x4849729, eArchType::ARM);
-	Add(xorstr("RsGlobal"), 0x4E4723C, eArchType::ARM);
-	Add(xorstr("JNILib_step"), 0x3E4911, eArchType::ARM);
-	Add(xorstr("TouchEvent"), 0x3E4B19, eArchType::ARM);
-	Add(xorstr("CNetGame::ProcessNetwork"), 0x2EB941, eArchType::ARM);
-	Add(xorstr("CNetGame::Packet_ConnectionLost"), 0x2EC701, eArchType::ARM);
-	
-	Add(xorstr("CNetGame::m_pRakClient"), 0x486F30C, eArchType::ARM);
-	uintptr_t ng_pRakClient = Get(xorstr("CNetGame::m_pRakClient"));
-	Add(xorstr("CNetGame::m_iGameState"), ng_pRakClient + 4, eArchType::ARM);
-	Add(xorstr("CNetGame::m_pPlayerPool"), ng_pRakClient + 8, eArchType::ARM);
-	Add(xorstr("CNetGame::m_pVehiclePool"), ng_pRakClient + 12, eArchType::ARM);
-	Add(xorstr("CNetGame::m_pPickupPool"), ng_pRakClient + 16, eArchType::ARM);
-	Add(xorstr("CNetGame::m_pTextLabelPool"), ng_pRakClient + 20, eArchType::ARM);
-	Add(xorstr("CNetGame::m_pTextDrawPool"), ng_pRakClient + 24, eArchType::ARM);
-	Add(xorstr("CNetGame::m_pGangZonePool"), ng_pRakClient + 28, eArchType::ARM);
-	Add(xorstr("CNetGame::m_pActorPool"), ng_pRakClient + 32, eArchType::ARM);
-	Add(xorstr("CNetGame::m_pObjectPool"), ng_pRakClient + 36, eArchType::ARM);
-	Add(xorstr("CNetGame::m_pChatBubblePool"), ng_pRakClient + 40, eArchType::ARM);
-	Add(xorstr("CNetGame::m_pWayPointPool"), ng_pRakClient + 44, eArchType::ARM);
-	// Add(xorstr("CNetGame::m_fNameTagsDrawDistance"), 0x4858CDC, eArchType::ARM);
-	// Add(xorstr("CNetGame::m_byteWorldTime"), 0x4869F02, eArchType::ARM);
-	Add(xorstr("CNetTextDrawPool::SetServerLogo"), 0x3452ED, eArchType::ARM);
-	Add(xorstr("CNetVehiclePool::New"), 0x346AC1, eArchType::ARM);
-	
-	Add(xorstr("CRemotePlayer::StoreAimSyncData"), 0x33F015, eArchType::ARM);
-	Add(xorstr("CRemotePlayer::StoreSyncData"), 0x33F0F5, eArchType::ARM);
-	Add(xorstr("CRemotePlayer::StoreInCarSyncData"), 0x340691, eArchType::ARM);
-	Add(xorstr("CRemotePlayer::StorePassengerSyncData"), 0x340B8D, eArchType::ARM);
-	Add(xorstr("CRemotePlayer::StoreBulletSyncData"), 0x3408A5, eArchType::ARM);
-	
-	Add(xorstr("RakClient::RegisterAsRemoteProcedureCall"), 0x451FED, eArchType::ARM);
-	Add(xorstr("CChat::AddDebugMessage"), 0x38B1B1, eArchType::ARM);
+	uint32_t hash;
+	const char* pattern;
+	int32_t adjust;
+};
+
+// CNetGame keeps its RakClient and pools side by side, one game pointer apart.
+// m_iGameState sits in the second slot, padded to a pointer on arm64.
+#define NG_FIELD(base, slot) ((base) + (slot) * NG_SLOT)
+
+#if defined(__arm__)
+static constexpr uintptr_t NG_SLOT = 4;
+static constexpr uintptr_t NG_RAKCLIENT = 0x486F30C;
+
+static constexpr COffset::stOffset g_arm[] = {
+	{ OFFSET("RwInitialised"), 0x4849729 },
+	{ OFFSET("RsGlobal"), 0x4E4723C },
+	{ OFFSET("JNILib_step"), 0x3E4911 },
+	{ OFFSET("TouchEvent"), 0x3E4B19 },
+	{ OFFSET("CNetGame::ProcessNetwork"), 0x2EB941 },
+	{ OFFSET("CNetGame::Packet_ConnectionLost"), 0x2EC701 },
+
+	{ OFFSET("CNetGame::m_pRakClient"), NG_FIELD(NG_RAKCLIENT, 0) },
+	{ OFFSET("CNetGame::m_iGameState"), NG_FIELD(NG_RAKCLIENT, 1) },
+	{ OFFSET("CNetGame::m_pPlayerPool"), NG_FIELD(NG_RAKCLIENT, 2) },
+	{ OFFSET("CNetGame::m_pVehiclePool"), NG_FIELD(NG_RAKCLIENT, 3) },
+	{ OFFSET("CNetGame::m_pPickupPool"), NG_FIELD(NG_RAKCLIENT, 4) },
+	{ OFFSET("CNetGame::m_pTextLabelPool"), NG_FIELD(NG_RAKCLIENT, 5) },
+	{ OFFSET("CNetGame::m_pTextDrawPool"), NG_FIELD(NG_RAKCLIENT, 6) },
+	{ OFFSET("CNetGame::m_pGangZonePool"), NG_FIELD(NG_RAKCLIENT, 7) },
+	{ OFFSET("CNetGame::m_pActorPool"), NG_FIELD(NG_RAKCLIENT, 8) },
+	{ OFFSET("CNetGame::m_pObjectPool"), NG_FIELD(NG_RAKCLIENT, 9) },
+	{ OFFSET("CNetGame::m_pChatBubblePool"), NG_FIELD(NG_RAKCLIENT, 10) },
+	{ OFFSET("CNetGame::m_pWayPointPool"), NG_FIELD(NG_RAKCLIENT, 11) },
+	// { OFFSET("CNetGame::m_fNameTagsDrawDistance"), 0x4858CDC },
+	// { OFFSET("CNetGame::m_byteWorldTime"), 0x4869F02 },
+	{ OFFSET("CNetTextDrawPool::SetServerLogo"), 0x3452ED },
+	{ OFFSET("CNetVehiclePool::New"), 0x346AC1 },
+
+	{ OFFSET("CRemotePlayer::StoreAimSyncData"), 0x33F015 },
+	{ OFFSET("CRemotePlayer::StoreSyncData"), 0x33F0F5 },
+	{ OFFSET("CRemotePlayer::StoreInCarSyncData"), 0x340691 },
+	{ OFFSET("CRemotePlayer::StorePassengerSyncData"), 0x340B8D },
+	{ OFFSET("CRemotePlayer::StoreBulletSyncData"), 0x3408A5 },
+
+	{ OFFSET("RakClient::RegisterAsRemoteProcedureCall"), 0x451FED },
+	{ OFFSET("CChat::AddDebugMessage"), 0x38B1B1 },
+	// not located in this build yet; CWorldLabels stays idle without it
+	// { OFFSET("TheCamera::m_mViewMatrix"), 0x0 },
+};
+static_assert(COffset::AreKeysDistinct(g_arm), "two offset names hash alike, rename one");
+static constexpr COffset::Table g_armTable = COffset::BuildTable(g_arm);
+
+// The build these were taken from predates build-id bookkeeping, so it is the default:
+// any build without a table of its own starts from it. Give the next build's table its
+// id (logged by Select) and put it above this one.
+static const COffset::stBuild g_builds[] = {
+	{ {}, 0, &g_armTable },
+};
+
+static const stSignature g_signatures[] = {
+	// { OFFSET("CNetGame::ProcessNetwork"), "F0 B5 03 AF ?? ?? ...", 1 },
+	{ 0, nullptr, 0 }
+};
+#elif defined(__aarch64__)
+// The 64-bit client is a separate libblackrussia-client.so with its own addresses, none
+// of which have been mapped yet. Its tables go here the same way as the armeabi-v7a ones,
+// with NG_FIELD for the CNetGame members and an adjust of 0 for signatures (A64 has no
+// Thumb bit), and the ABI goes into PLUGIN_ABIS in Android.mk. Until then only the tools are
+// built for it.
+static constexpr uintptr_t NG_SLOT = 8;
+
+static const COffset::stBuild g_builds[] = {
+	{ {}, 0, nullptr },
+};
+
+static const stSignature g_signatures[] = {
+	{ 0, nullptr, 0 }
+};
+#else
+// x86 and x86_64, for emulators that ship the client's x86 libraries; one that only has the
+// ARM client translates it, and loads the ARM plugin with it. No x86 client has been mapped,
+// so as on arm64 only the tools are built. Signatures take an adjust of 0.
+static constexpr uintptr_t NG_SLOT = sizeof(void*);
+
+static const COffset::stBuild g_builds[] = {
+	{ {}, 0, nullptr },
+};
+
+static const stSignature g_signatures[] = {
+	{ 0, nullptr, 0 }
+};
+#endif
+
+COffset::Table COffset::m_resolved;
+
+static constexpr uint32_t CACHE_MAGIC = 0x464F5242; // "BROF"
+
+struct stCacheEntry
+{
+	uint32_t hash;
+	uint32_t addr;
+};
+
+// a cache written against other signatures is stale even for the same build
+static uint32_t SignaturesHash()
+{
+	uint32_t hash = 0x811C9DC5;
+	for(const stSignature* sig = g_signatures; sig->pattern; sig++)
+	{
+		hash = (hash ^ sig->hash) * 0x01000193;
+		for(const char* c = sig->pattern; *c; c++) {
+			hash = (hash ^ (uint8_t)*c) * 0x01000193;
+		}
+		hash = (hash ^ (uint32_t)sig->adjust) * 0x01000193;
+	}
+	return hash;
 }
 
-void COffset::Add(const char* name, uintptr_t addr, eArchType arch)
+bool COffset::Select(const stModule& module)
 {
-	stOffset nOffset;
-	nOffset.name = name;
-	nOffset.addr = addr;
-	nOffset.arch = arch;
-	m_offsets.push_back(nOffset);
+	char hex[BUILD_ID_MAX * 2 + 1] = {0};
+	for(uint32_t i = 0; i < module.buildIdLen && i < BUILD_ID_MAX; i++) {
+		snprintf(hex + i * 2, 3, xorstr("%02x"), module.buildId[i]);
+	}
+
+	const Table* fallback = nullptr;
+	for(const stBuild& build : g_builds)
+	{
+		if(!build.table) {
+			continue;
+		}
+		if(!build.buildIdLen) {
+			fallback = build.table;
+			continue;
+		}
+		if(build.buildIdLen == module.buildIdLen && !memcmp(build.buildId, module.buildId, module.buildIdLen)) {
+			m_pTable.store(build.table, std::memory_order_release);
+			__android_log_print(ANDROID_LOG_INFO, xorstr("Offsets"), xorstr("build %s: matching table"), hex);
+			return true;
+		}
+	}
+	if(fallback)
+	{
+		if(Resolve(module, *fallback, hex)) {
+			m_pTable.store(&m_resolved, std::memory_order_release);
+		} else {
+			m_pTable.store(fallback, std::memory_order_release);
+			__android_log_print(ANDROID_LOG_INFO, xorstr("Offsets"), xorstr("build %s: default table"), hex);
+		}
+		return true;
+	}
+	__android_log_print(ANDROID_LOG_INFO, xorstr("Offsets"), xorstr("build %s is not supported"), hex);
+	return false;
 }
 
-uintptr_t COffset::Get(const char* name)
+bool COffset::Resolve(const stModule& module, const Table& fallback, const char* buildIdHex)
 {
-	uintptr_t result = 0;
-	for(int i = 0; i < m_offsets.size(); i++)
+	if(!g_signatures[0].pattern || !module.text) {
+		return false;
+	}
+	m_resolved = fallback;
+
+	char path[512] = {0};
+	const CConfig::stSettings& config = CConfig::Get();
+	if(buildIdHex[0] && !config.dataDir.empty()) {
+		snprintf(path, sizeof(path), xorstr("%s/offsets-%s.bin"), config.dataDir.c_str(), buildIdHex);
+		if(LoadCache(path, &m_resolved)) {
+			__android_log_print(ANDROID_LOG_INFO, xorstr("Offsets"), xorstr("build %s: cached scan from %s"), buildIdHex, path);
+			return true;
+		}
+	}
+
+	uint32_t found = 0, total = 0;
+	for(const stSignature* sig = g_signatures; sig->pattern; sig++)
 	{
-#ifdef __aarch64__
-		if(m_offsets[i].arch == eArchType::ARM64)
-		{
-#endif
-#ifdef __arm__
-		if(m_offsets[i].arch == eArchType::ARM)
-		{
-#endif
-		if(!strcasecmp(name, m_offsets[i].name.c_str()))
-		{
-			result = m_offsets[i].addr;
-			break;
+		total++;
+		CSigScan::stPattern pattern;
+		if(!CSigScan::Parse(sig->pattern, &pattern)) {
+			continue;
+		}
+		const uint8_t* match = CSigScan::Find(module.text, module.textSize, pattern);
+		if(match) {
+			Set(&m_resolved, sig->hash, (uintptr_t)match - module.base + sig->adjust);
+			found++;
+		}
+	}
+	__android_log_print(ANDROID_LOG_INFO, xorstr("Offsets"), xorstr("build %s: %u of %u signatures found"), buildIdHex, found, total);
+	if(path[0]) {
+		SaveCache(path, m_resolved);
+	}
+	return true;
+}
+
+void COffset::Set(Table* table, uint32_t hash, uintptr_t addr)
+{
+	uint32_t index = hash & (MAX_OFFSETS - 1);
+	for(uint32_t i = 0; i < MAX_OFFSETS; i++)
+	{
+		stOffset& slot = (*table)[index];
+		if(slot.hash == 0 || slot.hash == hash) {
+			slot.hash = hash;
+			slot.addr = addr;
+			return;
 		}
+		index = (index + 1) & (MAX_OFFSETS - 1);
+	}
+}
+
+bool COffset::LoadCache(const char* path, Table* table)
+{
+	FILE* file = fopen(path, "rb");
+	if(!file) {
+		return false;
+	}
+	uint32_t header[3];
+	bool ok = fread(header, sizeof(header), 1, file) == 1
+		&& header[0] == CACHE_MAGIC && header[1] == SignaturesHash() && header[2] <= MAX_OFFSETS;
+	stCacheEntry entries[MAX_OFFSETS];
+	ok = ok && fread(entries, sizeof(stCacheEntry), header[2], file) == header[2];
+	fclose(file);
+	if(!ok) {
+		return false;
+	}
+	for(uint32_t i = 0; i < header[2]; i++) {
+		Set(table, entries[i].hash, entries[i].addr);
+	}
+	return true;
+}
+
+void COffset::SaveCache(const char* path, const Table& table)
+{
+	stCacheEntry entries[MAX_OFFSETS];
+	uint32_t count = 0;
+	for(const stOffset& slot : table) {
+		if(slot.hash) {
+			entries[count++] = { slot.hash, (uint32_t)slot.addr };
 		}
 	}
-	return result;
+	FILE* file = fopen(path, "wb");
+	if(!file) {
+		return;
+	}
+	uint32_t header[3] = { CACHE_MAGIC, SignaturesHash(), count };
+	bool ok = fwrite(header, sizeof(header), 1, file) == 1
+		&& fwrite(entries, sizeof(stCacheEntry), count, file) == count;
+	// no half-written cache left behind
+	if(fclose(file) != 0 || !ok) {
+		remove(path);
+	}
 }
@@ -1,27 +1,139 @@
 #pragma once
 
-#include <vector>
-#include <string>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 
-enum eArchType
-{
-	ARM,
-	ARM64
-};
+// Offsets are keyed by a case-insensitive FNV-1a hash of their name.
+// OFFSET("Name") folds the hash at compile time, so the name never reaches the binary
+// and a lookup is a single probe into a fixed table.
+#define OFFSET(name) (std::integral_constant<uint32_t, COffset::Hash(name)>::value)
 
+// Each supported game build has its own table, keyed by the ELF build-id of
+// libblackrussia-client.so and laid out as a probe table at compile time, per arch.
+// Select picks one when the library is first found, so nothing is built at startup
+// and a new build is one more table in offsets.cpp.
+//
+// A build with no table of its own starts from the default one, with every function
+// that has a signature re-located by scanning the library's code. What the scan finds
+// is cached in the external files dir under the build-id, so each build is scanned once.
 class COffset
 {
 public:
-	static void Initialise();
-	static void Add(const char* name, uintptr_t addr, eArchType arch);
-	static uintptr_t Get(const char* name);
-	
+	static constexpr uint32_t BUILD_ID_MAX = 20;
+
 	struct stOffset
 	{
-		std::string name;
+		uint32_t hash;
 		uintptr_t addr;
-		eArchType arch;
 	};
+
+	// must stay a power of two
+	static constexpr uint32_t MAX_OFFSETS = 128;
+	typedef std::array<stOffset, MAX_OFFSETS> Table;
+
+	struct stBuild
+	{
+		// an empty id matches any build, for when the library has none
+		uint8_t buildId[BUILD_ID_MAX];
+		uint32_t buildIdLen;
+		const Table* table;
+	};
+
+	struct stModule
+	{
+		uintptr_t base;
+		uint8_t buildId[BUILD_ID_MAX];
+		uint32_t buildIdLen;
+		// the executable segment, what signatures are looked for in
+		const uint8_t* text;
+		size_t textSize;
+	};
+
+	// false if no table fits the build; lookups then come back 0
+	static bool Select(const stModule& module);
+	static bool IsSelected() { return m_pTable.load(std::memory_order_acquire) != nullptr; }
+	static inline uintptr_t Get(uint32_t hash)
+	{
+		const Table* table = m_pTable.load(std::memory_order_acquire);
+		if(!table) {
+			return 0;
+		}
+		uint32_t index = hash & (MAX_OFFSETS - 1);
+		for(uint32_t i = 0; i < MAX_OFFSETS; i++)
+		{
+			const stOffset& slot = (*table)[index];
+			if(slot.hash == hash) {
+				return slot.addr;
+			}
+			if(slot.hash == 0) {
+				break;
+			}
+			index = (index + 1) & (MAX_OFFSETS - 1);
+		}
+		return 0;
+	}
+	static uintptr_t Get(const char* name) { return Get(Hash(name)); }
+
+	static constexpr uint32_t Hash(const char* name)
+	{
+		uint32_t hash = 0x811C9DC5;
+		for(; *name; name++)
+		{
+			char c = *name;
+			if(c >= 'A' && c <= 'Z') {
+				c += 'a' - 'A';
+			}
+			hash = (hash ^ (uint8_t)c) * 0x01000193;
+		}
+		return hash;
+	}
+
+	// two names folding to one hash would silently share a slot, and 0 marks an empty one;
+	// every table is static_asserted against both
+	template<size_t N>
+	static constexpr bool AreKeysDistinct(const stOffset (&entries)[N])
+	{
+		for(size_t a = 0; a < N; a++)
+		{
+			if(entries[a].hash == 0) {
+				return false;
+			}
+			for(size_t b = a + 1; b < N; b++) {
+				if(entries[a].hash == entries[b].hash) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// lays entries out the way Get probes, at compile time
+	template<size_t N>
+	static constexpr Table BuildTable(const stOffset (&entries)[N])
+	{
+		static_assert(N < MAX_OFFSETS, "offset table is full");
+		Table table{};
+		for(size_t e = 0; e < N; e++)
+		{
+			uint32_t index = entries[e].hash & (MAX_OFFSETS - 1);
+			while(table[index].hash != 0 && table[index].hash != entries[e].hash) {
+				index = (index + 1) & (MAX_OFFSETS - 1);
+			}
+			table[index] = entries[e];
+		}
+		return table;
+	}
+
 private:
-	static std::vector<stOffset> m_offsets;
+	static bool Resolve(const stModule& module, const Table& fallback, const char* buildIdHex);
+	static bool LoadCache(const char* path, Table* table);
+	static void SaveCache(const char* path, const Table& table);
+	static void Set(Table* table, uint32_t hash, uintptr_t addr);
+
+	static std::atomic<const Table*> m_pTable;
+	// the table Resolve builds for a build without one of its own
+	static Table m_resolved;
 };
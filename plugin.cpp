@@ -1,116 +1,304 @@
 #include "plugin.h"
 #include "xorstr.h"
 
-uintptr_t CGameAPI::m_address = 0;
-
-int callback(struct dl_phdr_info *info, size_t size, void *data) {
-    for (size_t j = 0; j < info->dlpi_phnum; ++j) {
-        const char *name = info->dlpi_name;
-        if (strstr(name, xorstr("libblackrussia-client.so"))) {
-            CGameAPI::m_address = info->dlpi_addr;
-            return 1;  // Остановить итерацию
-        }
-    }
-    return 0;  // Продолжить итерацию
+#include <elf.h>
+#include <mutex>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+std::atomic<uintptr_t> CGameAPI::m_address(0);
+
+struct stModuleQuery
+{
+	const char* name;
+	uintptr_t address;
+	COffset::stModule module;
+};
+
+// NT_GNU_BUILD_ID from the module's PT_NOTE segments, which stay mapped, and where its
+// code is
+static void ReadModule(const struct dl_phdr_info* info, COffset::stModule* module)
+{
+	module->base = info->dlpi_addr;
+	for(int i = 0; i < info->dlpi_phnum; i++)
+	{
+		const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+		if(phdr.p_type == PT_LOAD && (phdr.p_flags & PF_X) && !module->text) {
+			module->text = (const uint8_t*)(info->dlpi_addr + phdr.p_vaddr);
+			module->textSize = phdr.p_filesz;
+		}
+		if(phdr.p_type != PT_NOTE || module->buildIdLen) {
+			continue;
+		}
+		const uint8_t* note = (const uint8_t*)(info->dlpi_addr + phdr.p_vaddr);
+		const uint8_t* end = note + phdr.p_memsz;
+		while(note + sizeof(ElfW(Nhdr)) <= end)
+		{
+			const ElfW(Nhdr)* header = (const ElfW(Nhdr)*)note;
+			const uint8_t* name = note + sizeof(ElfW(Nhdr));
+			const uint8_t* desc = name + ((header->n_namesz + 3) & ~3u);
+			if(desc + header->n_descsz > end) {
+				break;
+			}
+			if(header->n_type == NT_GNU_BUILD_ID && header->n_namesz == 4 && !memcmp(name, "GNU", 4)) {
+				module->buildIdLen = header->n_descsz < COffset::BUILD_ID_MAX ? header->n_descsz : COffset::BUILD_ID_MAX;
+				memcpy(module->buildId, desc, module->buildIdLen);
+				break;
+			}
+			note = desc + ((header->n_descsz + 3) & ~3u);
+		}
+	}
+}
+
+static int FindModuleCallback(struct dl_phdr_info *info, size_t size, void *data)
+{
+	stModuleQuery* query = (stModuleQuery *)data;
+	if(info->dlpi_name && strstr(info->dlpi_name, query->name)) {
+		query->address = info->dlpi_addr;
+		ReadModule(info, &query->module);
+		return 1;  // Остановить итерацию
+	}
+	return 0;  // Продолжить итерацию
+}
+
+uintptr_t CGameAPI::ResolveBase()
+{
+	stModuleQuery query;
+	query.name = xorstr("libblackrussia-client.so");
+	query.address = 0;
+	query.module = {};
+	dl_iterate_phdr(FindModuleCallback, &query);
+	if(query.address) {
+		// offsets first, anyone who sees the base can look them up
+		static std::once_flag selected;
+		std::call_once(selected, [&query] { COffset::Select(query.module); });
+		// the library never moves once loaded, so the first hit is published for good
+		m_address.store(query.address, std::memory_order_release);
+	}
+	return query.address;
 }
 
 uintptr_t CGameAPI::GetBase(const char* offsetName)
 {
-	if(!CGameAPI::m_address) {
-		dl_iterate_phdr(callback, nullptr);
+	uintptr_t base = m_address.load(std::memory_order_acquire);
+	if(!base) {
+		base = ResolveBase();
 	}
-	if(CGameAPI::m_address) {
+	if(base) {
 		if(offsetName == NULL) {
-			return CGameAPI::m_address;
+			return base;
 		} else {
-			return CGameAPI::m_address + COffset::Get(offsetName);
+			return base + COffset::Get(offsetName);
 		}
 	}
 	return 0;
 }
 
-const char* jbyteArrayToCharArray(JNIEnv* env, jbyteArray byteArray) {
-    if (byteArray == nullptr) {
-        return nullptr;
-    }
-
-    // Получаем длину массива
-    jsize length = env->GetArrayLength(byteArray);
-    if (length == 0) {
-        // Если массив пустой, возвращаем пустую строку
-        return "";
-    }
-
-    // Получаем указатель на элементы массива
-    jbyte* byteElements = env->GetByteArrayElements(byteArray, nullptr);
-    if (byteElements == nullptr) {
-        return nullptr; // Не удалось получить элементы массива
-    }
-
-    // Выделяем память под строку с дополнительным символом '\0'
-    char* result = new char[length + 1];
-    // Копируем массив байтов в строку
-    memcpy(result, byteElements, length);
-    // Добавляем завершающий нулевой символ
-    result[length] = '\0';
-
-    // Освобождаем массив байтов; флаг JNI_ABORT означает, что изменения не нужно копировать обратно в Java-массив
-    env->ReleaseByteArrayElements(byteArray, byteElements, JNI_ABORT);
-
-    return result;
+uintptr_t CGameAPI::GetBase(uint32_t offsetHash)
+{
+	uintptr_t base = GetBase();
+	if(base) {
+		return base + COffset::Get(offsetHash);
+	}
+	return 0;
+}
+
+// past this a critical section beats the region copy's bounds checks and per-call setup;
+// either way the bytes are copied once, into out
+static constexpr jsize CRITICAL_COPY_MIN = 4096;
+
+uint32_t jbyteArrayToCharArray(JNIEnv* env, jbyteArray byteArray, char* out, uint32_t outSize)
+{
+	if(outSize == 0) {
+		return 0;
+	}
+	out[0] = '\0';
+	if(byteArray == nullptr) {
+		return 0;
+	}
+	jsize length = env->GetArrayLength(byteArray);
+	if((uint32_t)length > outSize - 1) {
+		length = (jsize)(outSize - 1);
+	}
+	if(length >= CRITICAL_COPY_MIN) {
+		// no JNI calls and no blocking until it is released
+		void* bytes = env->GetPrimitiveArrayCritical(byteArray, nullptr);
+		if(bytes == nullptr) {
+			return 0;
+		}
+		memcpy(out, bytes, length);
+		env->ReleasePrimitiveArrayCritical(byteArray, bytes, JNI_ABORT);
+	} else if(length > 0) {
+		env->GetByteArrayRegion(byteArray, 0, length, (jbyte*)out);
+	}
+	out[length] = '\0';
+	return (uint32_t)length;
+}
+
+// UTF-8 bytes of cp1251 0x80..0xFF packed little endian, 0 where cp1251 has no character
+static const uint32_t g_cp1251ToUtf8[128] =
+{
+	// 80
+	0x82D0,     0x83D0,     0x9A80E2,   0x93D1,     0x9E80E2,   0xA680E2,   0xA080E2,   0xA180E2,
+	0xAC82E2,   0xB080E2,   0x89D0,     0xB980E2,   0x8AD0,     0x8CD0,     0x8BD0,     0x8FD0,
+	// 90
+	0x92D1,     0x9880E2,   0x9980E2,   0x9C80E2,   0x9D80E2,   0xA280E2,   0x9380E2,   0x9480E2,
+	0,          0xA284E2,   0x99D1,     0xBA80E2,   0x9AD1,     0x9CD1,     0x9BD1,     0x9FD1,
+	// A0
+	0xA0C2,     0x8ED0,     0x9ED1,     0x88D0,     0xA4C2,     0x90D2,     0xA6C2,     0xA7C2,
+	0x81D0,     0xA9C2,     0x84D0,     0xABC2,     0xACC2,     0xADC2,     0xAEC2,     0x87D0,
+	// B0
+	0xB0C2,     0xB1C2,     0x86D0,     0x96D1,     0x91D2,     0xB5C2,     0xB6C2,     0xB7C2,
+	0x91D1,     0x9684E2,   0x94D1,     0xBBC2,     0x98D1,     0x85D0,     0x95D1,     0x97D1,
+	// C0
+	0x90D0,     0x91D0,     0x92D0,     0x93D0,     0x94D0,     0x95D0,     0x96D0,     0x97D0,
+	0x98D0,     0x99D0,     0x9AD0,     0x9BD0,     0x9CD0,     0x9DD0,     0x9ED0,     0x9FD0,
+	// D0
+	0xA0D0,     0xA1D0,     0xA2D0,     0xA3D0,     0xA4D0,     0xA5D0,     0xA6D0,     0xA7D0,
+	0xA8D0,     0xA9D0,     0xAAD0,     0xABD0,     0xACD0,     0xADD0,     0xAED0,     0xAFD0,
+	// E0
+	0xB0D0,     0xB1D0,     0xB2D0,     0xB3D0,     0xB4D0,     0xB5D0,     0xB6D0,     0xB7D0,
+	0xB8D0,     0xB9D0,     0xBAD0,     0xBBD0,     0xBCD0,     0xBDD0,     0xBED0,     0xBFD0,
+	// F0
+	0x80D1,     0x81D1,     0x82D1,     0x83D1,     0x84D1,     0x85D1,     0x86D1,     0x87D1,
+	0x88D1,     0x89D1,     0x8AD1,     0x8BD1,     0x8CD1,     0x8DD1,     0x8ED1,     0x8FD1
+};
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+static inline bool IsAscii16(uint8x16_t v)
+{
+	uint8x8_t folded = vorr_u8(vget_low_u8(v), vget_high_u8(v));
+	return (vget_lane_u64(vreinterpret_u64_u8(folded), 0) & 0x8080808080808080ull) == 0;
+}
+#endif
+
+// Copies the ASCII run at src, 16 bytes at a time, while both sides have room for 16
+static inline void CopyAscii16(const uint8_t*& src, const uint8_t* end, char*& dst, const char* dstEnd)
+{
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	while(end - src >= 16 && dstEnd - dst >= 16) {
+		uint8x16_t v = vld1q_u8(src);
+		if(!IsAscii16(v)) {
+			break;
+		}
+		vst1q_u8((uint8_t*)dst, v);
+		src += 16;
+		dst += 16;
+	}
+#elif defined(__SSE2__)
+	while(end - src >= 16 && dstEnd - dst >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*)src);
+		// the top bit of every byte
+		if(_mm_movemask_epi8(v)) {
+			break;
+		}
+		_mm_storeu_si128((__m128i*)dst, v);
+		src += 16;
+		dst += 16;
+	}
+#endif
+}
+
+uint32_t cp1251_to_utf8(char* out, uint32_t outSize, const char* in, uint32_t len)
+{
+	if(outSize == 0) {
+		return 0;
+	}
+	const uint8_t* src = (const uint8_t*)in;
+	const uint8_t* end = src + (len ? strnlen(in, len) : strlen(in));
+	char* dst = out;
+	char* dstEnd = out + outSize - 1;
+
+	while(src < end)
+	{
+		// plain ASCII runs go through 16 bytes at a time
+		CopyAscii16(src, end, dst, dstEnd);
+		if(src >= end) {
+			break;
+		}
+		uint8_t c = *src;
+		if(c < 0x80) {
+			if(dst >= dstEnd) {
+				break;
+			}
+			*dst++ = (char)c;
+			src++;
+			continue;
+		}
+		uint32_t v = g_cp1251ToUtf8[c & 0x7F];
+		src++;
+		if(!v) {
+			continue;
+		}
+		uint32_t n = (v >> 16) ? 3 : 2;
+		if(dstEnd - dst < (int)n) {
+			break;
+		}
+		*dst++ = (char)v;
+		*dst++ = (char)(v >> 8);
+		if(n == 3) {
+			*dst++ = (char)(v >> 16);
+		}
+	}
+
+	*dst = 0;
+	return dst - out;
 }
 
-void cp1251_to_utf8(char *out, const char *in, unsigned int len)
+uint32_t utf8_to_cp1251(char* out, uint32_t outSize, const char* in, uint32_t len)
 {
-    static const int table[128] = 
-    {                    
-        // 80
-        0x82D0,     0x83D0,     0x9A80E2,   0x93D1,     0x9E80E2,   0xA680E2,   0xA080E2,   0xA180E2,
-        0xAC82E2,   0xB080E2,   0x89D0,     0xB980E2,   0x8AD0,     0x8CD0,     0x8BD0,     0x8FD0,
-        // 90
-        0x92D1,     0x9880E2,   0x9980E2,   0x9C80E2,   0x9D80E2,   0xA280E2,   0x9380E2,   0x9480E2,
-        0,          0xA284E2,   0x99D1,     0xBA80E2,   0x9AD1,     0x9CD1,     0x9BD1,     0x9FD1,
-        // A0
-        0xA0C2,     0x8ED0,     0x9ED1,     0x88D0,     0xA4C2,     0x90D2,     0xA6C2,     0xA7C2,              
-        0x81D0,     0xA9C2,     0x84D0,     0xABC2,     0xACC2,     0xADC2,     0xAEC2,     0x87D0,
-        // B0
-        0xB0C2,     0xB1C2,     0x86D0,     0x96D1,     0x91D2,     0xB5C2,     0xB6C2,     0xB7C2,              
-        0x91D1,     0x9684E2,   0x94D1,     0xBBC2,     0x98D1,     0x85D0,     0x95D1,     0x97D1,
-        // C0
-        0x90D0,     0x91D0,     0x92D0,     0x93D0,     0x94D0,     0x95D0,     0x96D0,     0x97D0,
-        0x98D0,     0x99D0,     0x9AD0,     0x9BD0,     0x9CD0,     0x9DD0,     0x9ED0,     0x9FD0,
-        // D0
-        0xA0D0,     0xA1D0,     0xA2D0,     0xA3D0,     0xA4D0,     0xA5D0,     0xA6D0,     0xA7D0,
-        0xA8D0,     0xA9D0,     0xAAD0,     0xABD0,     0xACD0,     0xADD0,     0xAED0,     0xAFD0,
-        // E0
-        0xB0D0,     0xB1D0,     0xB2D0,     0xB3D0,     0xB4D0,     0xB5D0,     0xB6D0,     0xB7D0,
-        0xB8D0,     0xB9D0,     0xBAD0,     0xBBD0,     0xBCD0,     0xBDD0,     0xBED0,     0xBFD0,
-        // F0
-        0x80D1,     0x81D1,     0x82D1,     0x83D1,     0x84D1,     0x85D1,     0x86D1,     0x87D1,
-        0x88D1,     0x89D1,     0x8AD1,     0x8BD1,     0x8CD1,     0x8DD1,     0x8ED1,     0x8FD1
-    };
-
-    int count = 0;
-
-    while (*in)
-    {
-        if(len && (count >= len)) break;
-
-        if (*in & 0x80)
-        {
-            int v = table[(int)(0x7f & *in++)];
-            if (!v)
-                continue;   
-            *out++ = (char)v;
-            *out++ = (char)(v >> 8);
-            if (v >>= 16)
-                *out++ = (char)v;
-        }
-        else // ASCII
-            *out++ = *in++;
-
-        count++;
-    }
-
-    *out = 0;
+	if(outSize == 0) {
+		return 0;
+	}
+	const uint8_t* src = (const uint8_t*)in;
+	const uint8_t* end = src + (len ? strnlen(in, len) : strlen(in));
+	char* dst = out;
+	char* dstEnd = out + outSize - 1;
+
+	while(src < end && dst < dstEnd)
+	{
+		CopyAscii16(src, end, dst, dstEnd);
+		if(src >= end || dst >= dstEnd) {
+			break;
+		}
+		uint8_t c = *src;
+		if(c < 0x80) {
+			*dst++ = (char)c;
+			src++;
+			continue;
+		}
+		uint32_t n = (c >= 0xE0) ? 3 : (c >= 0xC0 ? 2 : 1);
+		if(n == 1 || end - src < (int)n) {
+			// stray continuation byte or a cut sequence
+			*dst++ = '?';
+			src++;
+			continue;
+		}
+		uint32_t packed = src[0] | (src[1] << 8) | (n == 3 ? (src[2] << 16) : 0);
+		src += n;
+
+		char mapped = '?';
+		if(n == 2 && (c == 0xD0 || c == 0xD1)) {
+			// U+0410..U+044F, the bulk of any Russian text, is a straight offset
+			uint32_t cp = ((c & 0x1F) << 6) | (packed >> 8 & 0x3F);
+			if(cp >= 0x410 && cp <= 0x44F) {
+				*dst++ = (char)(cp - 0x410 + 0xC0);
+				continue;
+			}
+		}
+		for(uint32_t i = 0; i < 128; i++) {
+			if(g_cp1251ToUtf8[i] == packed) {
+				mapped = (char)(0x80 + i);
+				break;
+			}
+		}
+		*dst++ = mapped;
+	}
+
+	*dst = 0;
+	return dst - out;
 }
@@ -1,18 +1,29 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <link.h>
 #include <string.h>
 #include <jni.h>
 
 #include "offsets.h"
+#include "bindings.h"
 
 class CGameAPI
 {
 public:
 	static uintptr_t GetBase(const char* offsetName = NULL);
-	static uintptr_t m_address;
+	static uintptr_t GetBase(uint32_t offsetHash);
+	static std::atomic<uintptr_t> m_address;
+private:
+	static uintptr_t ResolveBase();
 };
 
-const char* jbyteArrayToCharArray(JNIEnv* env, jbyteArray byteArray);
-void cp1251_to_utf8(char *out, const char *in, unsigned int len = 0);
+// Copies a Java byte[] into out and terminates it, cut to outSize - 1 bytes; returns the
+// length copied, 0 for a null array. Nothing is allocated: small arrays are copied with
+// GetByteArrayRegion, large ones read in place through a critical section.
+uint32_t jbyteArrayToCharArray(JNIEnv* env, jbyteArray byteArray, char* out, uint32_t outSize);
+// Both stop at len bytes or the first NUL (len == 0: NUL only), never write more than
+// outSize bytes including the terminator, and return the length written.
+uint32_t cp1251_to_utf8(char* out, uint32_t outSize, const char* in, uint32_t len = 0);
+uint32_t utf8_to_cp1251(char* out, uint32_t outSize, const char* in, uint32_t len = 0);
@@ -0,0 +1,197 @@
+#include "alloctracker.h"
+
+#ifdef ALLOC_TRACKER
+
+#include "xorstr.h"
+
+#include <cfloat>
+#include <cstdio>
+#include <pthread.h>
+
+#include "vendor/imgui/imgui.h"
+
+bool CAllocTracker::m_bShowOverlay = true;
+std::atomic<uint32_t> CAllocTracker::m_pending[ALLOC_REGION_COUNT];
+std::atomic<uint64_t> CAllocTracker::m_pendingBytes[ALLOC_REGION_COUNT];
+float CAllocTracker::m_history[ALLOC_REGION_COUNT][HISTORY];
+uint32_t CAllocTracker::m_lastBytes[ALLOC_REGION_COUNT];
+int CAllocTracker::m_head = 0;
+CAllocTracker::stTagged CAllocTracker::m_tagged[2][256];
+
+static const char* const g_regionNames[ALLOC_REGION_COUNT] = {
+	"Other",
+	"Overlay",
+	"Game tick",
+	"Notifications",
+	"ProcessNetwork",
+	"FixBrokenRPC"
+};
+
+// region in the low byte, tag in the next and id above; unset reads as ALLOC_OTHER
+static pthread_key_t g_regionKey;
+static pthread_once_t g_regionKeyOnce = PTHREAD_ONCE_INIT;
+static std::atomic<bool> g_regionKeyReady(false);
+
+static void CreateRegionKey()
+{
+	pthread_key_create(&g_regionKey, nullptr);
+	g_regionKeyReady.store(true, std::memory_order_release);
+}
+
+uintptr_t CAllocTracker::Enter(eAllocRegion region, eTag tag, uint8_t id)
+{
+	pthread_once(&g_regionKeyOnce, CreateRegionKey);
+	uintptr_t previous = (uintptr_t)pthread_getspecific(g_regionKey);
+	pthread_setspecific(g_regionKey, (void*)(uintptr_t)(region | (tag << 8) | (id << 16)));
+	if(tag != TAG_NONE) {
+		m_tagged[tag - 1][id].seen.fetch_add(1, std::memory_order_relaxed);
+	}
+	return previous;
+}
+
+void CAllocTracker::Leave(uintptr_t previous)
+{
+	pthread_setspecific(g_regionKey, (void*)previous);
+}
+
+void CAllocTracker::Count(size_t size)
+{
+	uintptr_t state = g_regionKeyReady.load(std::memory_order_acquire) ? (uintptr_t)pthread_getspecific(g_regionKey) : 0;
+	uint32_t region = state & 0xFF;
+	uint32_t tag = (state >> 8) & 0xFF;
+	m_pending[region].fetch_add(1, std::memory_order_relaxed);
+	m_pendingBytes[region].fetch_add(size, std::memory_order_relaxed);
+	if(tag != TAG_NONE) {
+		stTagged& tagged = m_tagged[tag - 1][(state >> 16) & 0xFF];
+		tagged.allocations.fetch_add(1, std::memory_order_relaxed);
+		tagged.bytes.fetch_add(size, std::memory_order_relaxed);
+	}
+}
+
+void CAllocTracker::EndFrame()
+{
+	for(int i = 0; i < ALLOC_REGION_COUNT; i++) {
+		m_history[i][m_head] = (float)m_pending[i].exchange(0, std::memory_order_relaxed);
+		m_lastBytes[i] = (uint32_t)m_pendingBytes[i].exchange(0, std::memory_order_relaxed);
+	}
+	m_head = (m_head + 1) % HISTORY;
+}
+
+static void DrawSeries(const char* name, const float* values, int head, uint32_t lastBytes)
+{
+	float total = 0.f, peak = 0.f;
+	for(int i = 0; i < CAllocTracker::HISTORY; i++) {
+		total += values[i];
+		if(values[i] > peak) {
+			peak = values[i];
+		}
+	}
+	// frames since the last one that allocated, counted back from the newest
+	int quiet = 0;
+	for(int i = 1; i <= CAllocTracker::HISTORY && values[(head - i + CAllocTracker::HISTORY) % CAllocTracker::HISTORY] == 0.f; i++) {
+		quiet = i;
+	}
+	char overlay[96];
+	snprintf(overlay, sizeof(overlay), xorstr("avg %.1f  max %.0f  last %u B  %d quiet"),
+		total / CAllocTracker::HISTORY, peak, lastBytes, quiet);
+	ImGui::TextUnformatted(name);
+	ImGui::PlotHistogram(xorstr("##series"), values, CAllocTracker::HISTORY, head, overlay,
+		0.f, FLT_MAX, ImVec2(ImGui::GetContentRegionAvail().x, 40.f));
+}
+
+void CAllocTracker::DrawOverlay()
+{
+	if(!m_bShowOverlay) {
+		return;
+	}
+
+	ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowSize(ImVec2(560, 640), ImGuiCond_FirstUseEver);
+	if(!ImGui::Begin(xorstr("Allocations"), &m_bShowOverlay)) {
+		ImGui::End();
+		return;
+	}
+
+	for(int i = 0; i < ALLOC_REGION_COUNT; i++) {
+		ImGui::PushID(i);
+		DrawSeries(g_regionNames[i], m_history[i], m_head, m_lastBytes[i]);
+		ImGui::PopID();
+	}
+
+	if(ImGui::Button(xorstr("Reset ids"))) {
+		for(auto& kind : m_tagged) {
+			for(stTagged& tagged : kind) {
+				tagged.seen.store(0, std::memory_order_relaxed);
+				tagged.allocations.store(0, std::memory_order_relaxed);
+				tagged.bytes.store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+	// only the ids that allocated at all since the last reset
+	static const char* const kindNames[2] = { "Packets", "RPCs" };
+	for(int kind = 0; kind < 2; kind++)
+	{
+		ImGui::PushID(kind);
+		if(ImGui::BeginTable(kindNames[kind], 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchSame))
+		{
+			ImGui::TableSetupColumn(kindNames[kind]);
+			ImGui::TableSetupColumn(xorstr("seen"));
+			ImGui::TableSetupColumn(xorstr("allocs"));
+			ImGui::TableSetupColumn(xorstr("per one"));
+			ImGui::TableSetupColumn(xorstr("bytes"));
+			ImGui::TableHeadersRow();
+			for(int id = 0; id < 256; id++)
+			{
+				const stTagged& tagged = m_tagged[kind][id];
+				uint32_t allocations = tagged.allocations.load(std::memory_order_relaxed);
+				if(!allocations) continue;
+				uint32_t seen = tagged.seen.load(std::memory_order_relaxed);
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::Text(xorstr_cached("%d"), id);
+				ImGui::TableNextColumn();
+				ImGui::Text(xorstr_cached("%u"), seen);
+				ImGui::TableNextColumn();
+				ImGui::Text(xorstr_cached("%u"), allocations);
+				ImGui::TableNextColumn();
+				ImGui::Text(xorstr_cached("%.2f"), seen ? (float)allocations / seen : 0.f);
+				ImGui::TableNextColumn();
+				ImGui::Text(xorstr_cached("%llu"), (unsigned long long)tagged.bytes.load(std::memory_order_relaxed));
+			}
+			ImGui::EndTable();
+		}
+		ImGui::PopID();
+	}
+	ImGui::End();
+}
+
+// --wrap points every malloc, calloc and realloc linked into the plugin here
+extern "C"
+{
+	void* __real_malloc(size_t size);
+	void* __real_calloc(size_t count, size_t size);
+	void* __real_realloc(void* pointer, size_t size);
+
+	void* __wrap_malloc(size_t size)
+	{
+		CAllocTracker::Count(size);
+		return __real_malloc(size);
+	}
+
+	void* __wrap_calloc(size_t count, size_t size)
+	{
+		CAllocTracker::Count(count * size);
+		return __real_calloc(count, size);
+	}
+
+	void* __wrap_realloc(void* pointer, size_t size)
+	{
+		// a shrink or a free through realloc is no new allocation
+		if(size) {
+			CAllocTracker::Count(size);
+		}
+		return __real_realloc(pointer, size);
+	}
+}
+
+#endif
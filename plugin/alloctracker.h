@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+enum eAllocRegion
+{
+	ALLOC_OTHER,		// outside every scope below, workers included
+	ALLOC_OVERLAY,		// our ImGui work in hook_eglSwapBuffers
+	ALLOC_TICK,			// CApp::Process
+	ALLOC_NOTIFICATION,	// BrNotificationUpdate and its JNI calls
+	ALLOC_NETWORK,		// the ProcessNetwork drain, packet handlers included
+	ALLOC_RPC_FIX,		// FixBrokenRPC
+	ALLOC_REGION_COUNT
+};
+
+// Heap allocations made by the plugin's own code, per frame and per region, and per packet
+// and RPC id within the network drain; for checking that the steady state allocates nothing.
+// Only built with ALLOC_TRACKER defined (ndk-build ALLOC_TRACKER=1), which also links the
+// plugin with --wrap for malloc, calloc and realloc. Only calls made from inside this .so
+// land in the wrappers, libc++'s operator new included, so the game's own allocations are
+// never counted. Otherwise ALLOC_SCOPE and every call below compile to nothing.
+//
+// The current region lives in a pthread key rather than a thread_local: on API 21 the NDK
+// emulates TLS, and the emulation allocates on a thread's first access.
+class CAllocTracker
+{
+public:
+	static constexpr int HISTORY = 240;
+
+#ifdef ALLOC_TRACKER
+	enum eTag
+	{
+		TAG_NONE,
+		TAG_PACKET,
+		TAG_RPC,
+	};
+
+	class Scope
+	{
+	public:
+		explicit Scope(eAllocRegion region, eTag tag = TAG_NONE, uint8_t id = 0) : m_previous(Enter(region, tag, id)) {}
+		~Scope() { Leave(m_previous); }
+	private:
+		uintptr_t m_previous;
+	};
+
+	// from the malloc wrappers
+	static void Count(size_t size);
+	// once per swap
+	static void EndFrame();
+	static void DrawOverlay();
+	static bool IsOverlayShown() { return m_bShowOverlay; }
+
+	static bool m_bShowOverlay;
+private:
+	struct stTagged
+	{
+		std::atomic<uint32_t> seen;
+		std::atomic<uint32_t> allocations;
+		std::atomic<uint64_t> bytes;
+	};
+
+	static uintptr_t Enter(eAllocRegion region, eTag tag, uint8_t id);
+	static void Leave(uintptr_t previous);
+
+	static std::atomic<uint32_t> m_pending[ALLOC_REGION_COUNT];
+	static std::atomic<uint64_t> m_pendingBytes[ALLOC_REGION_COUNT];
+	static float m_history[ALLOC_REGION_COUNT][HISTORY];
+	static uint32_t m_lastBytes[ALLOC_REGION_COUNT];
+	static int m_head;
+	// since startup, [0] packets and [1] RPCs
+	static stTagged m_tagged[2][256];
+#else
+	static inline void EndFrame() {}
+	static inline void DrawOverlay() {}
+	static inline bool IsOverlayShown() { return false; }
+#endif
+};
+
+#ifdef ALLOC_TRACKER
+#define ALLOC_CONCAT2(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT2(a, b)
+#define ALLOC_SCOPE(region) CAllocTracker::Scope ALLOC_CONCAT(allocScope, __LINE__)(region)
+#define ALLOC_PACKET_SCOPE(packetId) CAllocTracker::Scope ALLOC_CONCAT(allocScope, __LINE__)(ALLOC_NETWORK, CAllocTracker::TAG_PACKET, packetId)
+#define ALLOC_RPC_SCOPE(rpcId) CAllocTracker::Scope ALLOC_CONCAT(allocScope, __LINE__)(ALLOC_RPC_FIX, CAllocTracker::TAG_RPC, (uint8_t)(rpcId))
+#else
+#define ALLOC_SCOPE(region) ((void)0)
+#define ALLOC_PACKET_SCOPE(packetId) ((void)0)
+#define ALLOC_RPC_SCOPE(rpcId) ((void)0)
+#endif
@@ -0,0 +1,51 @@
+#include "arena.h"
+
+#include <android/log.h>
+#include <stdlib.h>
+
+#include "xorstr.h"
+
+alignas(16) unsigned char CArena::m_buffer[CArena::SIZE];
+std::atomic<size_t> CArena::m_used(0);
+
+void* CArena::Alloc(size_t size, size_t align)
+{
+	size_t used = m_used.load(std::memory_order_relaxed);
+	for(;;)
+	{
+		size_t offset = (used + align - 1) & ~(align - 1);
+		if(offset + size > SIZE) {
+			break;
+		}
+		if(m_used.compare_exchange_weak(used, offset + size, std::memory_order_relaxed)) {
+			return m_buffer + offset;
+		}
+	}
+
+	static std::atomic<bool> logged(false);
+	if(!logged.exchange(true)) {
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Arena"), xorstr("%zu bytes used up, falling back to malloc"), (size_t)SIZE);
+	}
+	void* memory = nullptr;
+	if(posix_memalign(&memory, align < sizeof(void*) ? sizeof(void*) : align, size) != 0) {
+		return nullptr;
+	}
+	return memory;
+}
+
+// EASTL's default allocator calls these and hands the memory back with delete[], which is
+// free() in libc++. Containers given CArenaAllocator, or fixed ones with overflow disabled,
+// never get here.
+void* operator new[](size_t size, const char*, int, unsigned, const char*, int)
+{
+	return malloc(size);
+}
+
+void* operator new[](size_t size, size_t alignment, size_t, const char*, int, unsigned, const char*, int)
+{
+	void* memory = nullptr;
+	if(posix_memalign(&memory, alignment < sizeof(void*) ? sizeof(void*) : alignment, size) != 0) {
+		return nullptr;
+	}
+	return memory;
+}
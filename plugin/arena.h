@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// Memory for what the plugin allocates once and keeps for the session: per-player sync
+// state, last-sent copies, buffers sized on first use. A bump pointer over one block in
+// .bss, so untouched pages cost nothing and nothing is ever given back. Reuse what was
+// allocated instead of allocating again; once the block is used up, Alloc falls back to
+// malloc (logged once) rather than failing.
+class CArena
+{
+public:
+	static constexpr size_t SIZE = 1024 * 1024;
+
+	static void* Alloc(size_t size, size_t align = alignof(std::max_align_t));
+	template<typename T>
+	static T* New()
+	{
+		return new(Alloc(sizeof(T), alignof(T))) T();
+	}
+	static size_t Used() { return m_used.load(std::memory_order_relaxed); }
+
+private:
+	alignas(16) static unsigned char m_buffer[SIZE];
+	static std::atomic<size_t> m_used;
+};
+
+// EASTL allocator over CArena, for containers that reach their size once and stay there.
+// deallocate is a no-op, so a container that keeps reallocating leaks into the arena.
+class CArenaAllocator
+{
+public:
+	CArenaAllocator(const char* = nullptr) {}
+	CArenaAllocator(const CArenaAllocator&, const char*) {}
+
+	void* allocate(size_t n, int = 0) { return CArena::Alloc(n); }
+	void* allocate(size_t n, size_t alignment, size_t, int = 0) { return CArena::Alloc(n, alignment); }
+	void deallocate(void*, size_t) {}
+
+	const char* get_name() const { return "arena"; }
+	void set_name(const char*) {}
+};
+
+inline bool operator==(const CArenaAllocator&, const CArenaAllocator&) { return true; }
+inline bool operator!=(const CArenaAllocator&, const CArenaAllocator&) { return false; }
@@ -0,0 +1,228 @@
+#include "audiocache.h"
+#include "config.h"
+#include "diskcache.h"
+#include "httpfetch.h"
+#include "joinhandshake.h"
+#include "rpcarena.h"
+#include "workers.h"
+#include "xorstr.h"
+#include "vendor/RakNet/GetTime.h"
+#include "vendor/RakNet/NetworkTypes.h"
+
+#include <android/log.h>
+#include <dirent.h>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <vector>
+
+std::unordered_map<std::string, CAudioCache::stEntry> CAudioCache::m_entries;
+std::deque<std::string> CAudioCache::m_queue;
+std::string CAudioCache::m_dir;
+bool CAudioCache::m_loaded = false;
+bool CAudioCache::m_fetching = false;
+uint32_t CAudioCache::m_lastPlay = 0;
+
+static std::string ClipPath(const std::string& dir, const std::string& hash)
+{
+	return dir + "/" + hash + (const char*)xorstr(".snd");
+}
+
+static std::string RefPath(const std::string& dir, const std::string& url)
+{
+	return dir + "/" + CDiskCache::HashName(url.data(), url.size()) + (const char*)xorstr(".url");
+}
+
+bool CAudioCache::IsEnabled()
+{
+	const CConfig::stSettings& config = CConfig::Get();
+	return config.audioCacheKb != 0 && !config.cacheDir.empty();
+}
+
+void CAudioCache::Initialise()
+{
+	if(!IsEnabled()) {
+		return;
+	}
+	m_dir = CConfig::Get().cacheDir + (const char*)xorstr("/audio");
+
+	struct stIndexed
+	{
+		std::string url;
+		std::string hash;
+		std::string etag;
+	};
+	auto index = std::make_shared<std::vector<stIndexed>>();
+	std::string dir = m_dir;
+	CWorkers::Submit([index, dir] {
+		DIR* handle = opendir(dir.c_str());
+		if(!handle) {
+			return;
+		}
+		while(dirent* entry = readdir(handle))
+		{
+			size_t length = strlen(entry->d_name);
+			if(length < 4 || strcmp(entry->d_name + length - 4, (const char*)xorstr(".url")) != 0) continue;
+			// url, hash and etag, a line each
+			std::string ref;
+			if(!CDiskCache::Read(dir + "/" + entry->d_name, &ref)) continue;
+			size_t first = ref.find('\n');
+			size_t second = first == std::string::npos ? std::string::npos : ref.find('\n', first + 1);
+			if(second == std::string::npos) continue;
+			stIndexed indexed;
+			indexed.url = ref.substr(0, first);
+			indexed.hash = ref.substr(first + 1, second - first - 1);
+			indexed.etag = ref.substr(second + 1);
+			if(CDiskCache::Exists(ClipPath(dir, indexed.hash))) {
+				index->push_back(std::move(indexed));
+			}
+		}
+		closedir(handle);
+	}, [index] {
+		for(stIndexed& indexed : *index) {
+			stEntry& entry = m_entries[indexed.url];
+			entry.hash = std::move(indexed.hash);
+			entry.etag = std::move(indexed.etag);
+		}
+		m_loaded = true;
+		for(const std::string& url : CConfig::Get().audioPrefetch) {
+			Queue(url);
+		}
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Audio"), xorstr("%u clip(s) cached, %u queued"),
+			(unsigned)index->size(), (unsigned)m_queue.size());
+	});
+}
+
+void CAudioCache::OnPlayAudioStream(RPCParameters* rpcParams)
+{
+	// url length(1), url, x, y, z, radius(4 each), use position(1)
+	uint32_t inputLen = BITS_TO_BYTES(rpcParams->numberOfBitsOfData);
+	if(!m_loaded || inputLen < 1 || 1u + rpcParams->input[0] > inputLen) {
+		return;
+	}
+	uint8_t urlLen = rpcParams->input[0];
+	std::string url((const char*)rpcParams->input + 1, urlLen);
+	m_lastPlay = RakNet::GetTime();
+	if(url.compare(0, 4, (const char*)xorstr("http")) != 0) {
+		return;
+	}
+	Queue(url);
+	const stEntry& entry = m_entries[url];
+	if(entry.hash.empty()) {
+		return;
+	}
+
+	std::string path = std::string(xorstr("file://")) + ClipPath(m_dir, entry.hash);
+	uint32_t tailLen = inputLen - 1 - urlLen;
+	if(path.size() > 0xFF) {
+		return;
+	}
+	unsigned char* rewritten = CRPCArena::Alloc(1 + path.size() + tailLen);
+	if(!rewritten) {
+		return;
+	}
+	rewritten[0] = (uint8_t)path.size();
+	memcpy(rewritten + 1, path.data(), path.size());
+	memcpy(rewritten + 1 + path.size(), rpcParams->input + 1 + urlLen, tailLen);
+	rpcParams->input = rewritten;
+	rpcParams->numberOfBitsOfData = BYTES_TO_BITS(1 + path.size() + tailLen);
+}
+
+void CAudioCache::Queue(const std::string& url)
+{
+	stEntry& entry = m_entries[url];
+	if(entry.checked || entry.queued || entry.uncacheable) {
+		return;
+	}
+	entry.queued = true;
+	m_queue.push_back(url);
+}
+
+void CAudioCache::Process()
+{
+	if(m_fetching || m_queue.empty() || !CHttpFetch::IsReady() || CJoinHandshake::IsJoining()) {
+		return;
+	}
+	if(m_lastPlay && RakNet::GetTime() - m_lastPlay < QUIET_MS) {
+		return;
+	}
+	std::string url = std::move(m_queue.front());
+	m_queue.pop_front();
+	Fetch(url);
+}
+
+void CAudioCache::Fetch(const std::string& url)
+{
+	m_fetching = true;
+	struct stFetch
+	{
+		int status = -1;
+		bool uncacheable = false;
+		std::string hash;
+		std::string etag;
+	};
+	auto result = std::make_shared<stFetch>();
+	const stEntry& entry = m_entries[url];
+	std::string dir = m_dir, oldHash = entry.hash, etag = entry.etag;
+	uint32_t maxBytes = CConfig::Get().audioCacheKb * 1024;
+	CWorkers::Submit([result, url, dir, oldHash, etag, maxBytes] {
+		stHttpResponse response;
+		if(!CHttpFetch::Get(url, oldHash.empty() ? std::string() : etag, maxBytes, &response)) {
+			return;
+		}
+		if(response.status == 200 && response.tooLarge) {
+			result->status = 200;
+			result->uncacheable = true;
+			remove(RefPath(dir, url).c_str());
+			return;
+		}
+		if(response.status != 200 || response.body.empty()) {
+			result->status = response.status;
+			return;
+		}
+		mkdir(dir.c_str(), 0700);
+		std::string hash = CDiskCache::HashName(response.body.data(), response.body.size());
+		if(!CDiskCache::Exists(ClipPath(dir, hash)) && !CDiskCache::Write(ClipPath(dir, hash), response.body)) {
+			return;
+		}
+		if(!CDiskCache::Write(RefPath(dir, url), url + "\n" + hash + "\n" + response.etag)) {
+			return;
+		}
+		result->status = 200;
+		result->hash = hash;
+		result->etag = response.etag;
+	}, [result, url, oldHash] {
+		m_fetching = false;
+		stEntry& entry = m_entries[url];
+		entry.queued = false;
+		// a failure isn't tried again before the next session either
+		entry.checked = true;
+		if(result->status != 200) {
+			if(result->status != 304) {
+				__android_log_print(ANDROID_LOG_INFO, xorstr("Audio"), xorstr("fetch failed (%d), %s"), result->status,
+					oldHash.empty() ? "leaving it to the game" : "keeping the cached clip");
+			}
+			return;
+		}
+		entry.uncacheable = result->uncacheable;
+		entry.hash = result->hash;
+		entry.etag = result->etag;
+		if(!oldHash.empty() && oldHash != entry.hash) {
+			Release(oldHash);
+		}
+	});
+}
+
+void CAudioCache::Release(const std::string& hash)
+{
+	for(const auto& pair : m_entries) {
+		if(pair.second.hash == hash) {
+			return;
+		}
+	}
+	std::string path = ClipPath(m_dir, hash);
+	CWorkers::Submit([path] {
+		remove(path.c_str());
+	});
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+struct RPCParameters;
+
+// Audio stream clips kept in the app's cache dir. RPC_PlayAudioStream hands the game a URL it
+// fetches on the spot, often while the world is still streaming in, and a server's jingles
+// come round again and again. Every URL played, and the config's "audioPrefetch" list, is
+// fetched here once the join is through and nothing has started playing for QUIET_MS, so it
+// never competes with the join or with the game's own fetch. A clip of up to "audioCacheKb"
+// goes to audio/<FNV-1a of the bytes>.snd, with audio/<FNV-1a of the URL>.url holding the URL,
+// that hash and the ETag; later plays of the URL get the file:// path instead. Anything larger,
+// and live radio (icy headers, no length), is only remembered as such for the session and left
+// to the game. Cached clips are revalidated with If-None-Match once per session.
+// Game thread only.
+class CAudioCache
+{
+public:
+	static constexpr uint32_t QUIET_MS = 10000;
+
+	// reads what is on disk on a worker; the first plays before that go out untouched
+	static void Initialise();
+	static bool IsEnabled();
+	// from FixBrokenRPC; points the RPC at the cached clip when there is one
+	static void OnPlayAudioStream(RPCParameters* rpcParams);
+	// once per game tick
+	static void Process();
+
+private:
+	struct stEntry
+	{
+		// of the clip on disk, empty when there is none
+		std::string hash;
+		std::string etag;
+		// too large to keep, or a live stream
+		bool uncacheable = false;
+		// fetched or revalidated this session
+		bool checked = false;
+		bool queued = false;
+	};
+
+	static void Queue(const std::string& url);
+	static void Fetch(const std::string& url);
+	// drops the clip once no URL points at it any more
+	static void Release(const std::string& hash);
+
+	static std::unordered_map<std::string, stEntry> m_entries;
+	static std::deque<std::string> m_queue;
+	static std::string m_dir;
+	static bool m_loaded;
+	static bool m_fetching;
+	static uint32_t m_lastPlay;
+};
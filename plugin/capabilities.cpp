@@ -0,0 +1,75 @@
+#include "capabilities.h"
+#include "config.h"
+#include "sendclass.h"
+#include "xorstr.h"
+#include "vendor/RakNet/BitStream.h"
+#include "vendor/RakNet/RakClientInterface.h"
+#include "vendor/RakNet/SAMP/SAMPRPC.h"
+
+#include <android/log.h>
+
+extern RakClientInterface* pRakClient;
+
+uint32_t CCapabilities::m_offered = 0;
+uint32_t CCapabilities::m_accepted = 0;
+uint8_t CCapabilities::m_syncMinHz = 0;
+uint8_t CCapabilities::m_syncMaxHz = 0;
+
+void CCapabilities::Initialise(RakClientInterface* client)
+{
+	client->RegisterAsRemoteProcedureCall(RPC_CapabilitiesReply, CapabilitiesReply);
+}
+
+void CCapabilities::Reset()
+{
+	m_offered = 0;
+	m_accepted = 0;
+}
+
+void CCapabilities::Offer()
+{
+	Reset();
+	const CConfig::stSettings& config = CConfig::Get();
+	uint32_t capabilities = 0;
+	if(config.compressAbove) {
+		capabilities |= CAP_LZ4;
+	}
+	if(config.deltaSync) {
+		capabilities |= CAP_DELTA_SYNC;
+	}
+	if(config.adaptiveSyncRate) {
+		capabilities |= CAP_SYNC_RATE;
+	}
+	if(config.warmStandby) {
+		capabilities |= CAP_TRANSFER;
+	}
+	if(!capabilities) {
+		return;
+	}
+
+	RakNet::BitStream bsSend;
+	bsSend.Write(capabilities);
+	bsSend.Write((uint16_t)config.compressAbove);
+	pRakClient->RPC(RPC_ClientCapabilities, &bsSend, CSendClass::GetPriority(SEND_CLASS_CONTROL), RELIABLE_ORDERED,
+		CSendClass::GetOrderingChannel(SEND_CLASS_CONTROL), false, UNASSIGNED_NETWORK_ID, NULL);
+	m_offered = capabilities;
+}
+
+void CCapabilities::CapabilitiesReply(RPCParameters* rpcParams)
+{
+	RakNet::BitStream bsData(rpcParams->input, BITS_TO_BYTES(rpcParams->numberOfBitsOfData), false);
+	uint32_t accepted = 0;
+	if(!m_offered || !bsData.Read(accepted)) {
+		return;
+	}
+	// nothing we didn't offer, and only one answer per offer
+	m_accepted = accepted & m_offered;
+	m_offered = 0;
+	if(m_accepted & CAP_SYNC_RATE) {
+		// no usable bounds, no rate control
+		if(!bsData.Read(m_syncMinHz) || !bsData.Read(m_syncMaxHz) || !m_syncMinHz || m_syncMinHz > m_syncMaxHz) {
+			m_accepted &= ~CAP_SYNC_RATE;
+		}
+	}
+	__android_log_print(ANDROID_LOG_INFO, xorstr("Capabilities"), xorstr("server accepted 0x%x"), m_accepted);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+#include "vendor/RakNet/NetworkTypes.h"
+
+class RakClientInterface;
+
+// Extensions our own server may agree to, none of which a stock SA-MP server sees. After
+// ClientJoin the client offers RPC_ClientCapabilities with what it is configured for:
+//
+//   uint32 capabilities, uint16 smallest RPC payload worth compressing
+//
+// A server that knows the handshake answers with RPC_CapabilitiesReply:
+//
+//   uint32 capabilities it accepts
+//   with CAP_SYNC_RATE: uint8 fewest, uint8 most player or vehicle syncs per second it wants
+//
+// and both sides use those until the connection goes. Servers that ignore the offer get
+// plain SA-MP. Game thread only, like every RPC handler.
+class CCapabilities
+{
+public:
+	enum eCapability : uint32_t
+	{
+		CAP_LZ4 = 1 << 0,			// see CRPCCompression
+		CAP_DELTA_SYNC = 1 << 1,	// see CDeltaSync
+		CAP_SYNC_RATE = 1 << 2,		// see CSyncRate
+		CAP_TRANSFER = 1 << 3,		// see CStandby
+	};
+
+	static void Initialise(RakClientInterface* client);
+	// right after ClientJoin went out
+	static void Offer();
+	static void Reset();
+	static bool Has(eCapability capability) { return (m_accepted & capability) != 0; }
+	// the server's bounds, valid while CAP_SYNC_RATE is accepted
+	static uint8_t GetSyncMinHz() { return m_syncMinHz; }
+	static uint8_t GetSyncMaxHz() { return m_syncMaxHz; }
+
+private:
+	static void CapabilitiesReply(RPCParameters* rpcParams);
+
+	static uint32_t m_offered;
+	static uint32_t m_accepted;
+	static uint8_t m_syncMinHz;
+	static uint8_t m_syncMaxHz;
+};
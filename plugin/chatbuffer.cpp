@@ -0,0 +1,114 @@
+#include "chatbuffer.h"
+
+#include <string.h>
+
+#include "game/chat.h"
+#include "xorstr.h"
+#include "vendor/RakNet/GetTime.h"
+#include "vendor/RakNet/SAMP/SAMPRPC.h"
+
+CChatBuffer::stEntry CChatBuffer::m_entries[CAPACITY];
+uint32_t CChatBuffer::m_head = 0;
+uint32_t CChatBuffer::m_tail = 0;
+CChatBuffer::stShown CChatBuffer::m_shown[SHOWN_HISTORY];
+uint32_t CChatBuffer::m_nShown = 0;
+RakPeerInterface* CChatBuffer::m_recipient = nullptr;
+PlayerID CChatBuffer::m_sender = UNASSIGNED_PLAYER_ID;
+uint32_t CChatBuffer::m_nDuplicates = 0;
+uint32_t CChatBuffer::m_nDropped = 0;
+
+static uint32_t HashMessage(int rpcId, const unsigned char* data, uint32_t size)
+{
+	uint32_t hash = 2166136261u ^ (uint32_t)rpcId;
+	for(uint32_t i = 0; i < size; i++) {
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+	return hash;
+}
+
+bool CChatBuffer::IsBuffered(int rpcId)
+{
+	return rpcId == RPC_ClientMessage || rpcId == RPC_Chat;
+}
+
+bool CChatBuffer::IsDuplicate(uint32_t hash, uint32_t now)
+{
+	for(uint32_t i = m_head; i != m_tail; i++) {
+		if(m_entries[i & (CAPACITY - 1)].hash == hash) {
+			return true;
+		}
+	}
+	uint32_t shown = m_nShown < SHOWN_HISTORY ? m_nShown : SHOWN_HISTORY;
+	for(uint32_t i = 0; i < shown; i++) {
+		const stShown& entry = m_shown[(m_nShown - 1 - i) & (SHOWN_HISTORY - 1)];
+		if(now - entry.timeMs > DUPLICATE_MS) {
+			// newest first, so the rest are older still
+			break;
+		}
+		if(entry.hash == hash) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CChatBuffer::Push(int rpcId, const RPCParameters* rpcParams, void (*handler)(RPCParameters*))
+{
+	uint32_t inputLen = BITS_TO_BYTES(rpcParams->numberOfBitsOfData);
+	if(inputLen > MAX_PAYLOAD) {
+		return false;
+	}
+	uint32_t hash = HashMessage(rpcId, rpcParams->input, inputLen);
+	if(IsDuplicate(hash, RakNet::GetTime())) {
+		m_nDuplicates++;
+		return true;
+	}
+	if(m_tail - m_head == CAPACITY) {
+		m_head++;
+		m_nDropped++;
+	}
+	stEntry& entry = m_entries[m_tail & (CAPACITY - 1)];
+	entry.handler = handler;
+	entry.hash = hash;
+	entry.bits = rpcParams->numberOfBitsOfData;
+	entry.size = (uint16_t)inputLen;
+	memcpy(entry.payload, rpcParams->input, inputLen);
+	m_tail++;
+
+	m_recipient = rpcParams->recipient;
+	m_sender = rpcParams->sender;
+	return true;
+}
+
+void CChatBuffer::Flush()
+{
+	uint32_t now = RakNet::GetTime();
+	for(uint32_t n = 0; n < FLUSH_LIMIT && m_head != m_tail; n++)
+	{
+		stEntry& entry = m_entries[m_head & (CAPACITY - 1)];
+		m_head++;
+
+		RPCParameters rpcParams;
+		rpcParams.input = entry.payload;
+		rpcParams.numberOfBitsOfData = entry.bits;
+		rpcParams.sender = m_sender;
+		rpcParams.recipient = m_recipient;
+		rpcParams.replyToSender = nullptr;
+		entry.handler(&rpcParams);
+
+		m_shown[m_nShown & (SHOWN_HISTORY - 1)] = { entry.hash, now };
+		m_nShown++;
+	}
+
+	if(m_nDuplicates || m_nDropped) {
+		CHAT_DEBUG(xorstr("(chat: %u repeated, %u dropped)"), m_nDuplicates, m_nDropped);
+		m_nDuplicates = 0;
+		m_nDropped = 0;
+	}
+}
+
+void CChatBuffer::Clear()
+{
+	m_head = m_tail = 0;
+	m_nShown = 0;
+}
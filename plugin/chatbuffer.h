@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+#include "vendor/RakNet/NetworkTypes.h"
+
+// RPC_ClientMessage and RPC_Chat on their way to the game's chat. Scripts can fire dozens
+// a second and every one runs the chat layout code, so they are held here and handed on
+// in arrival order from Flush, at most FLUSH_LIMIT a frame. A message identical to one
+// still waiting or shown within DUPLICATE_MS is dropped; when the backlog is full the
+// oldest go, and either is summed up in one debug line. Game thread only.
+class CChatBuffer
+{
+public:
+	// must stay a power of two
+	static constexpr uint32_t CAPACITY = 256;
+	static constexpr uint32_t MAX_PAYLOAD = 512;
+	static constexpr uint32_t FLUSH_LIMIT = 8;
+	static constexpr uint32_t DUPLICATE_MS = 1000;
+
+	static bool IsBuffered(int rpcId);
+	// false when the payload can't be held; the caller passes it on itself
+	static bool Push(int rpcId, const RPCParameters* rpcParams, void (*handler)(RPCParameters*));
+	// once per frame
+	static void Flush();
+	static void Clear();
+
+private:
+	struct stEntry
+	{
+		void (*handler)(RPCParameters*);
+		uint32_t hash;
+		uint32_t bits;
+		uint16_t size;
+		unsigned char payload[MAX_PAYLOAD];
+	};
+	struct stShown
+	{
+		uint32_t hash;
+		uint32_t timeMs;
+	};
+
+	static bool IsDuplicate(uint32_t hash, uint32_t now);
+
+	static stEntry m_entries[CAPACITY];
+	static uint32_t m_head;
+	static uint32_t m_tail;
+	// the last few handed on; must stay a power of two
+	static constexpr uint32_t SHOWN_HISTORY = 32;
+	static stShown m_shown[SHOWN_HISTORY];
+	static uint32_t m_nShown;
+	static RakPeerInterface* m_recipient;
+	static PlayerID m_sender;
+	static uint32_t m_nDuplicates;
+	static uint32_t m_nDropped;
+};
@@ -1,130 +1,230 @@
 #include "common.h"
+#include "alloctracker.h"
+#include "audiocache.h"
+#include "frameprofiler.h"
+#include "chatbuffer.h"
+#include "debounce.h"
+#include "joinhandshake.h"
 #include "netgame.h"
+#include "textdrawbuffer.h"
 #include "plugin.h"
+#include "rpcarena.h"
+#include "rpcschema.h"
+#include "stallwatchdog.h"
+#include "syncdecode.h"
+#include "syncjitter.h"
+#include "worldsnapshot.h"
+#include "pools/playergrid.h"
+#include "pools/playernames.h"
+#include "pools/playerstate.h"
+#include "pools/objectqueue.h"
+#include "pools/playerqueue.h"
+#include "pools/vehiclepool.h"
+#include "pools/vehiclequeue.h"
 #include "xorstr.h"
+#include "gui/dialog.h"
 
 extern RakClientInterface* pRakClient;
 
-bool g_bInitGameProcess = false;
+
+struct stFullHealth
+{
+	static constexpr float value = 100.f;
+};
+
+// BR's WorldPlayerAdd carries a team byte after the id and no health/armour
+using WorldPlayerAddLayout = RpcLayout<
+	RpcCopy<2>,		// playerId
+	RpcDrop<1>,		// team
+	RpcCopy<24>,	// skin, pos, heading, color
+	RpcTail<1, 4>,	// fighting style
+	RpcInsert<stFullHealth>,	// health
+	RpcInsert<stFullHealth>>;	// armour
+
+static constexpr stRpcConversion g_worldPlayerAddConversion = MakeRpcConversion<WorldPlayerAddLayout>();
+
+// BR ids are a contiguous block starting at BR_RPC_ClientJoin, so the forward map is a dense
+// array indexed by (id - BR_RPC_ClientJoin). It holds addresses of the SA-MP ids rather than
+// their values because those stay mutable globals in SAMPRPC.cpp. The few RPCs whose payload
+// differs between the protocols carry their layout, see rpcschema.h.
+struct stRPCIdPair
+{
+	BRRpcIds br;
+	int* samp;
+	const stRpcConversion* conversion = nullptr;
+};
+
+static constexpr stRPCIdPair g_rpcIdPairs[] =
+{
+	{ BR_RPC_ClientJoin,                  &RPC_ClientJoin },
+	{ BR_RPC_InitGame,                    &RPC_InitGame },
+	{ BR_RPC_ConnectionRejected,          &RPC_ConnectionRejected },
+	{ BR_RPC_ServerJoin,                  &RPC_ServerJoin },
+	{ BR_RPC_ServerQuit,                  &RPC_ServerQuit },
+	{ BR_RPC_ServerCommand,               &RPC_ServerCommand },
+	{ BR_RPC_RequestClass,                &RPC_RequestClass },
+	{ BR_RPC_RequestSpawn,                &RPC_RequestSpawn },
+	{ BR_RPC_Spawn,                       &RPC_Spawn },
+	{ BR_RPC_ScrSetSpawnInfo,             &RPC_ScrSetSpawnInfo },
+	{ BR_RPC_Chat,                        &RPC_Chat },
+	{ BR_RPC_ChatBubble,                  &RPC_ChatBubble },
+	{ BR_RPC_ClientMessage,               &RPC_ClientMessage },
+	{ BR_RPC_ShowDialog,                  &RPC_ScrDialogBox },
+	{ BR_RPC_WorldTime,                   &RPC_WorldTime },
+	{ BR_RPC_SetTimeEx,                   &RPC_SetTimeEx },
+	{ BR_RPC_Weather,                     &RPC_Weather },
+	{ BR_RPC_ScrSetInterior,              &RPC_ScrSetInterior },
+	{ BR_RPC_ScrHaveSomeMoney,            &RPC_ScrHaveSomeMoney },
+	{ BR_RPC_ScrResetMoney,               &RPC_ScrResetMoney },
+	{ BR_RPC_Pickup,                      &RPC_Pickup },
+	{ BR_RPC_DestroyPickup,               &RPC_DestroyPickup },
+	{ BR_RPC_PickedUpPickup,              &RPC_PickedUpPickup },
+	{ BR_RPC_SetInteriorId,               &RPC_SetInteriorId },
+	{ BR_RPC_ScmEvent,                    &RPC_ScmEvent },
+	{ BR_RPC_Death,                       &RPC_Death },
+	{ BR_RPC_SetCheckpoint,               &RPC_SetCheckpoint },
+	{ BR_RPC_DisableCheckpoint,           &RPC_DisableCheckpoint },
+	{ BR_RPC_SetRaceCheckpoint,           &RPC_SetRaceCheckpoint },
+	{ BR_RPC_DisableRaceCheckpoint,       &RPC_DisableRaceCheckpoint },
+	{ BR_RPC_WorldActorAdd,               &RPC_ShowActor },
+	{ BR_RPC_WorldActorRemove,            &RPC_HideActor },
+	{ BR_RPC_ScrSetActorPos,              &RPC_SetActorPos },
+	{ BR_RPC_ScrSetActorFacingAngle,      &RPC_SetActorFacingAngle },
+	{ BR_RPC_ScrSetActorHealth,           &RPC_SetActorHealth },
+	{ BR_RPC_ScrApplyActorAnimation,      &RPC_ScrApplyActorAnimation },
+	{ BR_RPC_ScrClearActorAnimations,     &RPC_ScrClearActorAnimations },
+	{ BR_RPC_ActorGiveDamage,             &RPC_GiveActorDamage },
+	{ BR_RPC_WorldPlayerDeath,            &RPC_WorldPlayerDeath },
+	{ BR_RPC_WorldPlayerAdd,              &RPC_WorldPlayerAdd, &g_worldPlayerAddConversion },
+	{ BR_RPC_WorldPlayerRemove,           &RPC_WorldPlayerRemove },
+	{ BR_RPC_ScrShowNameTag,              &RPC_ScrShowNameTag },
+	{ BR_RPC_ScrSetPlayerName,            &RPC_ScrSetPlayerName },
+	{ BR_RPC_ScrSetPlayerPos,             &RPC_ScrSetPlayerPos },
+	{ BR_RPC_ScrSetPlayerPosFindZ,        &RPC_ScrSetPlayerPosFindZ },
+	{ BR_RPC_ScrTogglePlayerControllable, &RPC_ScrTogglePlayerControllable },
+	{ BR_RPC_ScrSetPlayerHealth,          &RPC_ScrSetPlayerHealth },
+	{ BR_RPC_ScrSetPlayerArmour,          &RPC_ScrSetPlayerArmour },
+	{ BR_RPC_ScrSetFightingStyle,         &RPC_ScrSetFightingStyle },
+	{ BR_RPC_ScrGivePlayerWeapon,         &RPC_ScrGivePlayerWeapon },
+	{ BR_RPC_ScrResetPlayerWeapons,       &RPC_ScrResetPlayerWeapons },
+	{ BR_RPC_ScrSetArmedWeapon,           &RPC_SetArmedWeapon },
+	{ BR_RPC_ScrSetWeaponAmmo,            &RPC_ScrSetWeaponAmmo },
+	{ BR_RPC_ScrSetPlayerVelocity,        &RPC_ScrSetPlayerVelocity },
+	{ BR_RPC_ScrSetPlayerColor,           &RPC_ScrSetPlayerColor },
+	{ BR_RPC_ScrSetPlayerSkin,            &RPC_ScrSetPlayerSkin },
+	{ BR_RPC_ScrSetPlayerAttachedObject,  &RPC_ScrSetPlayerAttachedObject },
+	{ BR_RPC_ScrAttachObjectToPlayer,     &RPC_ScrAttachObjectToPlayer },
+	{ BR_RPC_ScrSetPlayerWantedLevel,     &RPC_ScrSetPlayerWantedLevel },
+	{ BR_RPC_ScrSetPlayerFacingAngle,     &RPC_ScrSetPlayerFacingAngle },
+	{ BR_RPC_ScrSetPlayerDrunkLevel,      &RPC_ScrSetPlayerDrunkLevel },
+	{ BR_RPC_ScrApplyAnimation,           &RPC_ScrApplyPlayerAnimation },
+	{ BR_RPC_ScrClearAnimations,          &RPC_ScrClearPlayerAnimations },
+	{ BR_RPC_ScrPutPlayerInVehicle,       &RPC_ScrPutPlayerInVehicle },
+	{ BR_RPC_ScrRemovePlayerFromVehicle,  &RPC_ScrRemovePlayerFromVehicle },
+	{ BR_RPC_ScrSetCameraBehindPlayer,    &RPC_ScrSetCameraBehindPlayer },
+	{ BR_RPC_ScrSetCameraLookAt,          &RPC_ScrSetCameraLookAt },
+	{ BR_RPC_ScrSetCameraPos,             &RPC_ScrSetCameraPos },
+	{ BR_RPC_ScrInterpolateCamera,        &RPC_ScrInterpolateCamera },
+	{ BR_RPC_EnterVehicle,                &RPC_EnterVehicle },
+	{ BR_RPC_ExitVehicle,                 &RPC_ExitVehicle },
+	{ BR_RPC_ScrSetMapIcon,               &RPC_ScrSetMapIcon },
+	{ BR_RPC_ScrDisableMapIcon,           &RPC_ScrDisableMapIcon },
+	{ BR_RPC_ScrTogglePlayerSpectating,   &RPC_ScrTogglePlayerSpectating },
+	{ BR_RPC_ScrPlayerSpectatePlayer,     &RPC_ScrPlayerSpectatePlayer },
+	{ BR_RPC_ScrPlayerSpectateVehicle,    &RPC_ScrPlayerSpectateVehicle },
+	{ BR_RPC_ScrAddGangZone,              &RPC_ScrAddGangZone },
+	{ BR_RPC_ScrFlashGangZone,            &RPC_ScrFlashGangZone },
+	{ BR_RPC_ScrStopFlashGangZone,        &RPC_ScrStopFlashGangZone },
+	{ BR_RPC_ScrRemoveGangZone,           &RPC_ScrRemoveGangZone },
+	{ BR_RPC_ScrSetSpecialAction,         &RPC_ScrSetSpecialAction },
+	{ BR_RPC_ScrAttachTrailerToVehicle,   &RPC_ScrAttachTrailerToVehicle },
+	{ BR_RPC_ScrDetachTrailerFromVehicle, &RPC_ScrDetachTrailerFromVehicle },
+	{ BR_RPC_ScrCreateObject,             &RPC_ScrCreateObject },
+	{ BR_RPC_ScrDestroyObject,            &RPC_ScrDestroyObject },
+	{ BR_RPC_ScrSetObjectRotation,        &RPC_ScrSetObjectRotation },
+	{ BR_RPC_ScrMoveObject,               &RPC_ScrMoveObject },
+	{ BR_RPC_ScrStopObject,               &RPC_ScrStopObject },
+	{ BR_RPC_WorldVehicleAdd,             &RPC_WorldVehicleAdd },
+	{ BR_RPC_WorldVehicleRemove,          &RPC_WorldVehicleRemove },
+	{ BR_RPC_VehicleDestroyed,            &RPC_VehicleDestroyed },
+	{ BR_RPC_ScrSetVehicleHealth,         &RPC_ScrSetVehicleHealth },
+	{ BR_RPC_ScrSetVehiclePos,            &RPC_ScrSetVehiclePos },
+	{ BR_RPC_ScrSetVehicleVelocity,       &RPC_ScrSetVehicleVelocity },
+	{ BR_RPC_ScrVehicleParams,            &RPC_ScrVehicleParams },
+	{ BR_RPC_SetVehicleParamsEx,          &RPC_ScrVehicleParamsEx },
+	{ BR_RPC_ScrSetVehicleZAngle,         &RPC_ScrSetVehicleZAngle },
+	{ BR_RPC_ScrLinkVehicleToInterior,    &RPC_ScrLinkVehicle },
+	{ BR_RPC_ScrDisplayGameText,          &RPC_ScrDisplayGameText },
+	{ BR_RPC_ScrSelectTextDraw,           &RPC_ScrSelectTextDraw },
+	{ BR_RPC_ClickTextDraw,               &RPC_ClickTextDraw },
+	{ BR_RPC_ScrShowTextDraw,             &RPC_ScrShowTextDraw },
+	{ BR_RPC_ScrEditTextDraw,             &RPC_ScrEditTextDraw },
+	{ BR_RPC_ScrHideTextDraw,             &RPC_ScrHideTextDraw },
+	{ BR_RPC_ScrCreateExplosion,          &RPC_ScrCreateExplosion },
+	{ BR_RPC_DialogResponse,              &RPC_DialogResponse },
+	{ BR_RPC_MapMarker,                   &RPC_MapMarker },
+	{ BR_RPC_UpdateScoresPingsIPs,        &RPC_UpdateScoresPingsIPs },
+	{ BR_RPC_PlayerGiveTakeDamage,        &RPC_PlayerGiveTakeDamage },
+	{ BR_RPC_ScrPlaySound,                &RPC_ScrPlaySound },
+	{ BR_RPC_ScrPlayAudioStream,          &RPC_PlayAudioStream },
+	{ BR_RPC_ScrStopAudioStream,          &RPC_StopAudioStream },
+	{ BR_RPC_Create3DTextLabel,           &RPC_ScrCreate3DTextLabel },
+};
+
+static constexpr int BR_RPC_FIRST = BR_RPC_ClientJoin;
+static constexpr int BR_RPC_COUNT = BR_RPC_ScrPlayRadioStream - BR_RPC_ClientJoin + 1;
+
+struct stRPCIdTable
+{
+	int* samp[BR_RPC_COUNT];
+};
+
+static constexpr stRPCIdTable BuildRPCIdTable()
+{
+	stRPCIdTable table {};
+	for(const stRPCIdPair& pair : g_rpcIdPairs) {
+		table.samp[pair.br - BR_RPC_FIRST] = pair.samp;
+	}
+	return table;
+}
+
+static constexpr stRPCIdTable g_rpcIdTable = BuildRPCIdTable();
 
 int ConvertBRIDToSampID(BRRpcIds value)
 {
-    if(value == BR_RPC_ClientJoin) { return RPC_ClientJoin; }
-    if(value == BR_RPC_InitGame) { return RPC_InitGame; }
-	if(value == BR_RPC_ConnectionRejected) { return RPC_ConnectionRejected; }
-    if(value == BR_RPC_ServerJoin) { return RPC_ServerJoin; }
-    if(value == BR_RPC_ServerQuit) { return RPC_ServerQuit; }
-    if(value == BR_RPC_ServerCommand) { return RPC_ServerCommand; }
-    if(value == BR_RPC_RequestClass) { return RPC_RequestClass; }
-    if(value == BR_RPC_RequestSpawn) { return RPC_RequestSpawn; }
-    if(value == BR_RPC_Spawn) { return RPC_Spawn; }
-    if(value == BR_RPC_ScrSetSpawnInfo) { return RPC_ScrSetSpawnInfo; }
-    if(value == BR_RPC_Chat) { return RPC_Chat; }
-    if(value == BR_RPC_ChatBubble) { return RPC_ChatBubble; }
-    if(value == BR_RPC_ClientMessage) { return RPC_ClientMessage; }
-    if(value == BR_RPC_ShowDialog) { return RPC_ScrDialogBox; }
-    if(value == BR_RPC_WorldTime) { return RPC_WorldTime; }
-    if(value == BR_RPC_SetTimeEx) { return RPC_SetTimeEx; }
-    if(value == BR_RPC_Weather) { return RPC_Weather; }
-    if(value == BR_RPC_ScrSetInterior) { return RPC_ScrSetInterior; }
-    if(value == BR_RPC_ScrHaveSomeMoney) { return RPC_ScrHaveSomeMoney; }
-    if(value == BR_RPC_ScrResetMoney) { return RPC_ScrResetMoney; }
-    if(value == BR_RPC_Pickup) { return RPC_Pickup; }
-    if(value == BR_RPC_DestroyPickup) { return RPC_DestroyPickup; }
-    if(value == BR_RPC_PickedUpPickup) { return RPC_PickedUpPickup; }
-    if(value == BR_RPC_SetInteriorId) { return RPC_SetInteriorId; }
-    if(value == BR_RPC_ScmEvent) { return RPC_ScmEvent; }
-    if(value == BR_RPC_Death) { return RPC_Death; }
-    if(value == BR_RPC_SetCheckpoint) { return RPC_SetCheckpoint; }
-    if(value == BR_RPC_DisableCheckpoint) { return RPC_DisableCheckpoint; }
-    if(value == BR_RPC_SetRaceCheckpoint) { return RPC_SetRaceCheckpoint; }
-    if(value == BR_RPC_DisableRaceCheckpoint) { return RPC_DisableRaceCheckpoint; }
-    if(value == BR_RPC_WorldActorAdd) { return RPC_ShowActor; }
-    if(value == BR_RPC_WorldActorRemove) { return RPC_HideActor; }
-    if(value == BR_RPC_ScrSetActorPos) { return RPC_SetActorPos; }
-    if(value == BR_RPC_ScrSetActorFacingAngle) { return RPC_SetActorFacingAngle; }
-    if(value == BR_RPC_ScrSetActorHealth) { return RPC_SetActorHealth; }
-    if(value == BR_RPC_ScrApplyActorAnimation) { return RPC_ScrApplyActorAnimation; }
-    if(value == BR_RPC_ScrClearActorAnimations) { return RPC_ScrClearActorAnimations; }
-    if(value == BR_RPC_ActorGiveDamage) { return RPC_GiveActorDamage; }
-    if(value == BR_RPC_WorldPlayerDeath) { return RPC_WorldPlayerDeath; }
-    if(value == BR_RPC_WorldPlayerAdd) { return RPC_WorldPlayerAdd; }
-    if(value == BR_RPC_WorldPlayerRemove) { return RPC_WorldPlayerRemove; }
-    if(value == BR_RPC_ScrShowNameTag) { return RPC_ScrShowNameTag; }
-    if(value == BR_RPC_ScrSetPlayerName) { return RPC_ScrSetPlayerName; }
-    if(value == BR_RPC_ScrSetPlayerPos) { return RPC_ScrSetPlayerPos; }
-    if(value == BR_RPC_ScrSetPlayerPosFindZ) { return RPC_ScrSetPlayerPosFindZ; }
-    if(value == BR_RPC_ScrTogglePlayerControllable) { return RPC_ScrTogglePlayerControllable; }
-    if(value == BR_RPC_ScrSetPlayerHealth) { return RPC_ScrSetPlayerHealth; }
-    if(value == BR_RPC_ScrSetPlayerArmour) { return RPC_ScrSetPlayerArmour; }
-    if(value == BR_RPC_ScrSetFightingStyle) { return RPC_ScrSetFightingStyle; }
-    if(value == BR_RPC_ScrGivePlayerWeapon) { return RPC_ScrGivePlayerWeapon; }
-    if(value == BR_RPC_ScrResetPlayerWeapons) { return RPC_ScrResetPlayerWeapons; }
-    if(value == BR_RPC_ScrSetArmedWeapon) { return RPC_SetArmedWeapon; }
-    if(value == BR_RPC_ScrSetWeaponAmmo) { return RPC_ScrSetWeaponAmmo; }
-    if(value == BR_RPC_ScrSetPlayerVelocity) { return RPC_ScrSetPlayerVelocity; }
-    if(value == BR_RPC_ScrSetPlayerColor) { return RPC_ScrSetPlayerColor; }
-    if(value == BR_RPC_ScrSetPlayerSkin) { return RPC_ScrSetPlayerSkin; }
-    if(value == BR_RPC_ScrSetPlayerAttachedObject) { return RPC_ScrSetPlayerAttachedObject; }
-    if(value == BR_RPC_ScrAttachObjectToPlayer) { return RPC_ScrAttachObjectToPlayer; }
-    if(value == BR_RPC_ScrSetPlayerWantedLevel) { return RPC_ScrSetPlayerWantedLevel; }
-    if(value == BR_RPC_ScrSetPlayerFacingAngle) { return RPC_ScrSetPlayerFacingAngle; }
-    if(value == BR_RPC_ScrSetPlayerDrunkLevel) { return RPC_ScrSetPlayerDrunkLevel; }
-    if(value == BR_RPC_ScrSetPlayerColor) { return RPC_ScrSetPlayerColor; }
-    if(value == BR_RPC_ScrApplyAnimation) { return RPC_ScrApplyPlayerAnimation; }
-    if(value == BR_RPC_ScrClearAnimations) { return RPC_ScrClearPlayerAnimations; }
-    if(value == BR_RPC_ScrPutPlayerInVehicle) { return RPC_ScrPutPlayerInVehicle; }
-    if(value == BR_RPC_ScrRemovePlayerFromVehicle) { return RPC_ScrRemovePlayerFromVehicle; }
-    if(value == BR_RPC_ScrSetCameraBehindPlayer) { return RPC_ScrSetCameraBehindPlayer; }
-    if(value == BR_RPC_ScrSetCameraLookAt) { return RPC_ScrSetCameraLookAt; }
-    if(value == BR_RPC_ScrSetCameraPos) { return RPC_ScrSetCameraPos; }
-    if(value == BR_RPC_ScrInterpolateCamera) { return RPC_ScrInterpolateCamera; }
-    if(value == BR_RPC_EnterVehicle) { return RPC_EnterVehicle; }
-    if(value == BR_RPC_ExitVehicle) { return RPC_ExitVehicle; }
-    if(value == BR_RPC_ScrSetMapIcon) { return RPC_ScrSetMapIcon; }
-    if(value == BR_RPC_ScrDisableMapIcon) { return RPC_ScrDisableMapIcon; }
-    if(value == BR_RPC_ScrTogglePlayerSpectating) { return RPC_ScrTogglePlayerSpectating; }
-    if(value == BR_RPC_ScrPlayerSpectatePlayer) { return RPC_ScrPlayerSpectatePlayer; }
-    if(value == BR_RPC_ScrPlayerSpectateVehicle) { return RPC_ScrPlayerSpectateVehicle; }
-    if(value == BR_RPC_ScrAddGangZone) { return RPC_ScrAddGangZone; }
-    if(value == BR_RPC_ScrFlashGangZone) { return RPC_ScrFlashGangZone; }
-    if(value == BR_RPC_ScrStopFlashGangZone) { return RPC_ScrStopFlashGangZone; }
-    if(value == BR_RPC_ScrRemoveGangZone) { return RPC_ScrRemoveGangZone; }
-    if(value == BR_RPC_ScrSetSpecialAction) { return RPC_ScrSetSpecialAction; }
-    if(value == BR_RPC_ScrAttachTrailerToVehicle) { return RPC_ScrAttachTrailerToVehicle; }
-    if(value == BR_RPC_ScrDetachTrailerFromVehicle) { return RPC_ScrDetachTrailerFromVehicle; }
-    if(value == BR_RPC_ScrCreateObject) { return RPC_ScrCreateObject; }
-    if(value == BR_RPC_ScrDestroyObject) { return RPC_ScrDestroyObject; }
-    if(value == BR_RPC_ScrSetObjectRotation) { return RPC_ScrSetObjectRotation; }
-    if(value == BR_RPC_ScrMoveObject) { return RPC_ScrMoveObject; }
-    if(value == BR_RPC_ScrStopObject) { return RPC_ScrStopObject; }
-    if(value == BR_RPC_WorldVehicleAdd) { return RPC_WorldVehicleAdd; }
-    if(value == BR_RPC_WorldVehicleRemove) { return RPC_WorldVehicleRemove; }
-    if(value == BR_RPC_VehicleDestroyed) { return RPC_VehicleDestroyed; }
-    if(value == BR_RPC_ScrSetVehicleHealth) { return RPC_ScrSetVehicleHealth; }
-    if(value == BR_RPC_ScrSetVehiclePos) { return RPC_ScrSetVehiclePos; }
-    if(value == BR_RPC_ScrSetVehicleVelocity) { return RPC_ScrSetVehicleVelocity; }
-    if(value == BR_RPC_ScrVehicleParams) { return RPC_ScrVehicleParams; }
-    if(value == BR_RPC_SetVehicleParamsEx) { return RPC_ScrVehicleParamsEx; }
-    if(value == BR_RPC_ScrSetVehicleZAngle) { return RPC_ScrSetVehicleZAngle; }
-    if(value == BR_RPC_ScrLinkVehicleToInterior) { return RPC_ScrLinkVehicle; }
-    if(value == BR_RPC_ScrDisplayGameText) { return RPC_ScrDisplayGameText; }
-    if(value == BR_RPC_ScrSelectTextDraw) { return RPC_ScrSelectTextDraw; }
-    if(value == BR_RPC_ClickTextDraw) { return RPC_ClickTextDraw; }
-    if(value == BR_RPC_ScrShowTextDraw) { return RPC_ScrShowTextDraw; }
-    if(value == BR_RPC_ScrEditTextDraw) { return RPC_ScrEditTextDraw; }
-    if(value == BR_RPC_ScrHideTextDraw) { return RPC_ScrHideTextDraw; }
-    if(value == BR_RPC_ScrCreateExplosion) { return RPC_ScrCreateExplosion; }
-    if(value == BR_RPC_DialogResponse) { return RPC_DialogResponse; }
-    if(value == BR_RPC_MapMarker) { return RPC_MapMarker; }
-    if(value == BR_RPC_UpdateScoresPingsIPs) { return RPC_UpdateScoresPingsIPs; }
-    if(value == BR_RPC_PlayerGiveTakeDamage) { return RPC_PlayerGiveTakeDamage; }
-    if(value == BR_RPC_ScrPlaySound) { return RPC_ScrPlaySound; }
-    if(value == BR_RPC_ScrPlayAudioStream) { return RPC_PlayAudioStream; }
-    if(value == BR_RPC_ScrStopAudioStream) { return RPC_StopAudioStream; }
-    if(value == BR_RPC_Create3DTextLabel) { return RPC_ScrCreate3DTextLabel; }
-    
-    return -1;
+	uint32_t index = (uint32_t)(value - BR_RPC_FIRST);
+	if(index >= (uint32_t)BR_RPC_COUNT || !g_rpcIdTable.samp[index]) {
+		return -1;
+	}
+	return *g_rpcIdTable.samp[index];
+}
+
+// SA-MP ids are only known at runtime, so the reverse map is filled on first use.
+// ScrSelectTextDraw and ClickTextDraw share id 83; the earlier pair (the inbound one) wins.
+int ConvertSampIDToBRID(int sampId)
+{
+	static const struct stReverseTable
+	{
+		int16_t br[256];
+
+		stReverseTable()
+		{
+			for(int16_t& id : br) {
+				id = -1;
+			}
+			for(const stRPCIdPair& pair : g_rpcIdPairs) {
+				int samp = *pair.samp;
+				if(samp >= 0 && samp < (int)(sizeof(br) / sizeof(br[0])) && br[samp] == -1) {
+					br[samp] = (int16_t)pair.br;
+				}
+			}
+		}
+	} reverse;
+
+	if(sampId < 0 || sampId >= (int)(sizeof(reverse.br) / sizeof(reverse.br[0]))) {
+		return -1;
+	}
+	return reverse.br[sampId];
 }
 
 PacketReliability ConvertBRToSampReliability(BRPacketReliability reliability)
@@ -136,188 +236,340 @@ PacketReliability ConvertBRToSampReliability(BRPacketReliability reliability)
 	if(reliability == BR_RELIABILITY_RELIABLE_SEQUENCED) { return RELIABLE_SEQUENCED; }
 }
 
-void ConvertBROnFootSyncToSampSync(RakNet::BitStream* bs, BROnFootSyncData data)
-{
-    bs->WriteBits((const unsigned char *)&data.lrAnalogLeftStick, 16);
-    bs->WriteBits((const unsigned char *)&data.udAnalogLeftStick, 16);
-    bs->WriteBits((const unsigned char *)&data.wKeys, 16);
-    bs->WriteBits((const unsigned char *)&data.vecPos, 96);
-    bs->WriteBits((const unsigned char *)&data.quatw, 32);
-    bs->WriteBits((const unsigned char *)&data.quatx, 32);
-    bs->WriteBits((const unsigned char *)&data.quaty, 32);
-    bs->WriteBits((const unsigned char *)&data.quatz, 32);
-    bs->WriteBits((const unsigned char *)&data.health, 8);
-    bs->WriteBits((const unsigned char *)&data.armour, 8);
-    bs->WriteBits((const unsigned char *)&data.byteCurrentWeapon, 8);
-    bs->WriteBits((const unsigned char *)&data.byteSpecialAction, 8);
-    bs->WriteBits((const unsigned char *)&data.vecMoveSpeed, 96);
-    bs->WriteBits((const unsigned char *)&data.vecSurfOffsets, 96);
-    bs->WriteBits((const unsigned char *)&data.wSurfInfo, 16);
-    bs->WriteBits((const unsigned char *)&data.dwAnimation, 32);
+typedef void (*RPCFixup)(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*));
+
+static void FixInitGame(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	CJoinHandshake::BeginInitGame();
+	staticFunc(rpcParams);
+	CJoinHandshake::EndInitGame();
+	CWorldSnapshot::OnInitGame();
+	CJoinHandshake::OnInitGame();
 }
 
-void ConvertBRInCarSyncToSampSync(RakNet::BitStream* bs, BRInCarSyncData data)
-{
-    bs->WriteBits((const unsigned char *)&data.VehicleID, 16);
-    bs->WriteBits((const unsigned char *)&data.lrAnalogLeftStick, 16);
-    bs->WriteBits((const unsigned char *)&data.udAnalogLeftStick, 16);
-    bs->WriteBits((const unsigned char *)&data.wKeys, 16);
-    bs->WriteBits((const unsigned char *)&data.quatw, 32);
-    bs->WriteBits((const unsigned char *)&data.quatx, 32);
-    bs->WriteBits((const unsigned char *)&data.quaty, 32);
-    bs->WriteBits((const unsigned char *)&data.quatz, 32);
-    bs->WriteBits((const unsigned char *)&data.vecPos.x, 32);
-	bs->WriteBits((const unsigned char *)&data.vecPos.y, 32);
-	bs->WriteBits((const unsigned char *)&data.vecPos.z, 32);
-    bs->WriteBits((const unsigned char *)&data.vecMoveSpeed.x, 32);
-	bs->WriteBits((const unsigned char *)&data.vecMoveSpeed.y, 32);
-	bs->WriteBits((const unsigned char *)&data.vecMoveSpeed.z, 32);
-    bs->WriteBits((const unsigned char *)&data.fCarHealth, 32);
-    bs->WriteBits((const unsigned char *)&data.playerHealth, 8);
-    bs->WriteBits((const unsigned char *)&data.playerArmour, 8);
-    bs->WriteBits((const unsigned char *)&data.byteCurrentWeapon, 8);
-    bs->WriteBits((const unsigned char *)&data.byteSirenOn, 8);
-    bs->WriteBits((const unsigned char *)&data.byteLandingGearState, 8);
-    bs->WriteBits((const unsigned char *)&data.TrailerID, 16);
-	float fTrainSpeed = 0;
-	bs->WriteBits((const unsigned char *)&fTrainSpeed, 32);
-	
+static void FixSpawnInfo(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	// asks for the spawn unless the early one already did, see CJoinHandshake
+	CJoinHandshake::OnSpawnInfo();
+	staticFunc(rpcParams);
 }
 
-void ConvertBRPassengerSyncToSampSync(RakNet::BitStream* bs, BRPassengerSyncData data)
-{
-    bs->WriteBits((const unsigned char *)&data.VehicleID, 16);
-	uint8_t combinedByte = (data.byteSeatFlags & 0x7F) | (data.byteDriveBy << 7);
-    bs->WriteBits((const unsigned char *)&combinedByte, 8);
-    bs->WriteBits((const unsigned char *)&data.byteCurrentWeapon, 8);
-    bs->WriteBits((const unsigned char *)&data.playerHealth, 8);
-    bs->WriteBits((const unsigned char *)&data.playerArmour, 8);
-    bs->WriteBits((const unsigned char *)&data.lrAnalog, 16);
-    bs->WriteBits((const unsigned char *)&data.udAnalog, 16);
-    bs->WriteBits((const unsigned char *)&data.wKeys, 16);
-	bs->WriteBits((const unsigned char *)&data.vecPos, 96);
+static void FixRequestSpawn(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	staticFunc(rpcParams);
+	// outcome(1), nonzero when the server lets us spawn
+	CJoinHandshake::OnSpawnReply(inputLen >= 1 && rpcParams->input[0] != 0);
 }
 
-bool IsRPCNeedFix(int rpcId)
+static void FixChat(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
 {
-	if(rpcId == RPC_WorldPlayerAdd) {
-		return true;
+	// shown from CChatBuffer::Flush, a few per frame
+	if(!CChatBuffer::Push(rpcId, rpcParams, staticFunc)) {
+		staticFunc(rpcParams);
 	}
-	if(rpcId == RPC_ScrDialogBox) {
-		return true;
+}
+
+static void FixScoresPings(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	// the whole server at once; decoded here straight into the pool
+	CPlayerPool* pool = CNetGame::GetPlayerPool();
+	CLocalPlayer* localPlayer = pool ? pool->GetLocalPlayer() : nullptr;
+	if(localPlayer) {
+		stScoresPingsTarget target;
+		target.scores = pool->m_iPlayerScores;
+		target.pings = pool->m_dwPlayerPings;
+		target.maxPlayers = MAX_PLAYERS;
+		target.localId = localPlayer->GetLocalPlayerID();
+		target.localScore = &pool->m_iLocalPlayerScore;
+		target.localPing = &pool->m_dwLocalPlayerPing;
+		if(DecodeScoresPings(rpcParams->input, inputLen, target)) {
+			return;
+		}
 	}
-	if(rpcId == RPC_WorldVehicleAdd) { return true; }
-	if(rpcId == RPC_ServerJoin) { return true; }
-	if(rpcId == RPC_ScrSetSpawnInfo) {
-		RakNet::BitStream bs;
-		pRakClient->RPC(&RPC_RequestSpawn, &bs, HIGH_PRIORITY, RELIABLE, 0, false, UNASSIGNED_NETWORK_ID, 0);
-		return true;
+	staticFunc(rpcParams);
+}
+
+static void FixTextDraw(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	// coalesced per frame, see CTextDrawBuffer::Flush
+	if(!CTextDrawBuffer::Push(rpcId, rpcParams, staticFunc)) {
+		staticFunc(rpcParams);
 	}
-	return false;
 }
 
-struct NewVehicleFix
+static void FixDialogBox(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
 {
-	char VehicleID[2];
-	char iVehicleType[4];
-	char pos[12];
-	char fRotation[4];
-	char color[2];
-	char health[4];
-};
+	if(inputLen >= sizeof(uint16_t)) {
+		memcpy(&CNetGame::m_nLastSAMPDialogID, rpcParams->input, sizeof(uint16_t));
+	}
+	// the same button on a new dialog is a new answer
+	CDebounce::Forget(RPC_DialogResponse);
+	CDebounce::ForgetUi();
+	if(!CNativeDialog::OnDialogBox(rpcParams->input, inputLen)) {
+		staticFunc(rpcParams);
+	}
+}
 
-void FixBrokenRPC(int rpcId, RPCParameters* rpcParams, void (*staticFunc)(RPCParameters*))
+static void FixPlayAudioStream(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	// a cached clip plays from disk, see CAudioCache
+	if(CAudioCache::IsEnabled()) {
+		CAudioCache::OnPlayAudioStream(rpcParams);
+	}
+	staticFunc(rpcParams);
+}
+
+static void FixWorldVehicleAdd(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
 {
-	RakNet::BitStream bsData(rpcParams->input, (rpcParams->numberOfBitsOfData / 8) + 1, false);
-	if(rpcId == RPC_InitGame) {
-		g_bInitGameProcess = true;
+	// spawned over the next frames, see CVehicleSpawnQueue
+	if(!CVehicleSpawnQueue::Push(rpcParams->input, inputLen)) {
+		CVehicleSpawnQueue::SpawnDirect(rpcParams->input, inputLen);
+	}
+}
+
+static void FixWorldVehicleRemove(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	if(inputLen >= sizeof(uint16_t)) {
+		uint16_t vehicleId;
+		memcpy(&vehicleId, rpcParams->input, sizeof(vehicleId));
+		// never spawned, so there is nothing for the game to remove
+		if(CVehicleSpawnQueue::Cancel(vehicleId)) {
+			return;
+		}
+		CVehiclePool::MarkInactive(vehicleId);
+	}
+	staticFunc(rpcParams);
+}
+
+static void FixVehicleRPC(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	// a vehicle still in the spawn queue is spawned first
+	CVehicleSpawnQueue::NeedsVehicle(rpcId, rpcParams->input, inputLen);
+	staticFunc(rpcParams);
+}
+
+static void FixCreateObject(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	// handed to the game over the next frames, see CObjectQueue
+	if(!CObjectQueue::Push(rpcParams, staticFunc)) {
 		staticFunc(rpcParams);
-		g_bInitGameProcess = false;
-		return;
 	}
-	if(rpcId == RPC_ScrDialogBox) {
-		 bsData.Read(CNetGame::m_nLastSAMPDialogID);
+}
+
+static void FixDestroyObject(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	if(inputLen >= sizeof(uint16_t)) {
+		uint16_t objectId;
+		memcpy(&objectId, rpcParams->input, sizeof(objectId));
+		if(CObjectQueue::Cancel(objectId)) {
+			return;
+		}
+	}
+	staticFunc(rpcParams);
+}
+
+static void FixObjectRPC(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	// an object still in the queue is created first
+	CObjectQueue::NeedsObject(rpcId, rpcParams->input, inputLen);
+	staticFunc(rpcParams);
+}
+
+static void FixWorldPlayerAdd(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	// streamed in over the next frames, see CPlayerStreamQueue
+	if(!CPlayerStreamQueue::Push(rpcParams, staticFunc)) {
+		staticFunc(rpcParams);
 	}
-	if(rpcId == RPC_WorldPlayerAdd) {
+}
+
+static void FixWorldPlayerRemove(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	if(inputLen >= sizeof(uint16_t)) {
 		uint16_t playerId;
-		uint32_t skinId, dwColor;
-		CVector vecPos;
-		float fHeading;
-		uint8_t byteFightingStyle = 4;
-		bsData.Read(playerId);
-		bsData.IgnoreBits(8);
-		bsData.Read(skinId);
-		bsData.Read(vecPos.x);
-		bsData.Read(vecPos.y);
-		bsData.Read(vecPos.z);
-		bsData.Read(fHeading);
-		bsData.Read(dwColor);
-		bsData.Read(byteFightingStyle);
-		RakNet::BitStream bsRepair;
-		bsRepair.Write(playerId);
-		bsRepair.Write(skinId);
-		bsRepair.Write(vecPos.x);
-		bsRepair.Write(vecPos.y);
-		bsRepair.Write(vecPos.z);
-		bsRepair.Write(fHeading);
-		bsRepair.Write(dwColor);
-		bsRepair.Write(byteFightingStyle);
-		float maxHAvalue = 100.f;
-		bsRepair.Write(maxHAvalue);
-		bsRepair.Write(maxHAvalue);
-		rpcParams->input = bsRepair.GetData();
-		rpcParams->numberOfBitsOfData = bsRepair.GetNumberOfBitsUsed();
-	}
-	if(rpcId == RPC_WorldVehicleAdd) {
-		uint16_t VehicleID;
-		int iVehicleType;
-        float vecPos[3], fRotation, fHealth;
-        uint16_t color;
-        
-        bsData.Read(VehicleID);
-		bsData.Read(iVehicleType);
-		bsData.Read(vecPos[0]);
-		bsData.Read(vecPos[1]);
-		bsData.Read(vecPos[2]);
-		bsData.Read(fRotation);
-		bsData.Read(color);
-		bsData.Read(fHealth);
-		
-		NewVehicleFix newVehBuff = {0};
-		
-		memcpy(&newVehBuff.VehicleID, &VehicleID, 2);
-		memcpy(&newVehBuff.iVehicleType, &iVehicleType, 4);
-		memcpy(&newVehBuff.pos, &vecPos, 12);
-		memcpy(&newVehBuff.fRotation, &fRotation, 4);
-		memcpy(&newVehBuff.color, &color, 2);
-		memcpy(&newVehBuff.health, &fHealth, 4);
-		
-        uintptr_t base = CGameAPI::GetBase(xorstr("CNetVehiclePool::New"));
-		int vehPool = *(int *)(CGameAPI::GetBase(xorstr("CNetGame::m_pVehiclePool")));
-		reinterpret_cast<void(*)(int, NewVehicleFix *)>(base)(vehPool, &newVehBuff);
-		
+		memcpy(&playerId, rpcParams->input, sizeof(playerId));
+		// never streamed in, so there is no ped to remove
+		if(CPlayerStreamQueue::Cancel(playerId)) {
+			return;
+		}
+	}
+	staticFunc(rpcParams);
+}
+
+static void FixPlayerRPC(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	// a player still in the stream queue gets its ped first
+	CPlayerStreamQueue::NeedsPlayer(rpcId, rpcParams->input, inputLen);
+	staticFunc(rpcParams);
+}
+
+static void FixServerJoin(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	staticFunc(rpcParams);
+	// playerId(2), unknown(5), nick length(1), nick
+	if(inputLen < 8) {
 		return;
 	}
-	if(rpcId == RPC_ServerJoin) {
-		staticFunc(rpcParams);
-		uint8_t nickNameLen;
-		char nickName[25];
+	uint16_t playerId;
+	memcpy(&playerId, rpcParams->input, sizeof(playerId));
+	// a join without the quit before it still takes the id over
+	CNetGame::ForgetSync(playerId);
+	uint8_t nickNameLen = rpcParams->input[7];
+	if(nickNameLen > 24) {
+		nickNameLen = 24;
+	}
+	if(nickNameLen > inputLen - 8) {
+		nickNameLen = inputLen - 8;
+	}
+	CPlayerPool::MarkActive(playerId);
+	CPlayerPool* pool = CNetGame::GetPlayerPool();
+	CRemotePlayer* remote_player = pool ? pool->GetAt(playerId) : nullptr;
+	if(remote_player) {
+		memcpy(remote_player->m_szName, rpcParams->input + 8, nickNameLen);
+		remote_player->m_szName[nickNameLen] = '\0';
+	}
+	CPlayerNames::Set(playerId, (const char*)rpcParams->input + 8, nickNameLen);
+}
+
+static void FixServerQuit(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	staticFunc(rpcParams);
+	// playerId(2), reason(1)
+	if(inputLen >= sizeof(uint16_t)) {
 		uint16_t playerId;
-		bsData.Read(playerId);
-		bsData.IgnoreBits(40);
-		bsData.Read(nickNameLen);
-		bsData.Read(nickName, nickNameLen);
-		nickName[nickNameLen] = 0;
-		std::string aNick = nickName;
-		CRemotePlayer* remote_player = CNetGame::GetPlayerPool()->GetAt(playerId);
-		if(remote_player) {
-			for(int i = 0; i < nickNameLen; i++)
-			{
-				remote_player->m_szName[i] = nickName[i];
-			}
-		}
+		memcpy(&playerId, rpcParams->input, sizeof(playerId));
+		CPlayerStreamQueue::Cancel(playerId);
+		CNetGame::ForgetSync(playerId);
+		CPlayerPool::MarkInactive(playerId);
+		CPlayerGrid::Remove(playerId);
+		CPlayerState::Remove(playerId);
+		CSyncJitter::Reset(playerId);
+		CPlayerNames::Remove(playerId);
+	}
+}
+
+static void FixSetPlayerName(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
+	staticFunc(rpcParams);
+	// playerId(2), name length(1), name, success(1)
+	if(inputLen < 3) {
+		return;
+	}
+	uint16_t playerId;
+	memcpy(&playerId, rpcParams->input, sizeof(playerId));
+	uint8_t nameLen = rpcParams->input[2];
+	if(nameLen > inputLen - 3) {
 		return;
 	}
-	
+	bool success = inputLen <= 3u + nameLen || rpcParams->input[3 + nameLen];
+	// only remote players that joined have a name, so this also leaves out the local player
+	if(success && CPlayerNames::Get(playerId)[0]) {
+		CPlayerNames::Set(playerId, (const char*)rpcParams->input + 3, nameLen);
+	}
+}
+
+// only recorded for a resume, see CWorldSnapshot
+static void FixTracked(int rpcId, RPCParameters* rpcParams, uint32_t inputLen, void (*staticFunc)(RPCParameters*))
+{
 	staticFunc(rpcParams);
 }
+
+// by SA-MP id, filled once the ids are known; a null entry goes straight to the game's handler
+static RPCFixup g_rpcFixups[256];
+// by SA-MP id, the payloads that are rewritten before their fixup
+static const stRpcConversion* g_rpcConversions[256];
+
+static void SetFixup(int rpcId, RPCFixup fixup)
+{
+	if(rpcId >= 0 && rpcId < 256) {
+		g_rpcFixups[rpcId] = fixup;
+	}
+}
+
+void InitialiseRPCFixups(RakClientInterface* client)
+{
+	// the groups first, then the RPCs with a rewrite of their own
+	for(int rpcId = 0; rpcId < 256; rpcId++)
+	{
+		RPCFixup fixup = nullptr;
+		if(CVehicleSpawnQueue::IsVehicleRPC(rpcId)) { fixup = FixVehicleRPC; }
+		else if(CObjectQueue::IsObjectRPC(rpcId)) { fixup = FixObjectRPC; }
+		else if(CPlayerStreamQueue::IsPlayerRPC(rpcId)) { fixup = FixPlayerRPC; }
+		else if(CChatBuffer::IsBuffered(rpcId)) { fixup = FixChat; }
+		else if(CTextDrawBuffer::IsBuffered(rpcId)) { fixup = FixTextDraw; }
+		else if(CWorldSnapshot::IsTracked(rpcId)) { fixup = FixTracked; }
+		g_rpcFixups[rpcId] = fixup;
+	}
+	SetFixup(RPC_InitGame, FixInitGame);
+	SetFixup(RPC_ScrSetSpawnInfo, FixSpawnInfo);
+	SetFixup(RPC_RequestSpawn, FixRequestSpawn);
+	SetFixup(RPC_UpdateScoresPingsIPs, FixScoresPings);
+	SetFixup(RPC_ScrDialogBox, FixDialogBox);
+	SetFixup(RPC_PlayAudioStream, FixPlayAudioStream);
+	SetFixup(RPC_WorldVehicleAdd, FixWorldVehicleAdd);
+	SetFixup(RPC_WorldVehicleRemove, FixWorldVehicleRemove);
+	SetFixup(RPC_ScrCreateObject, FixCreateObject);
+	SetFixup(RPC_ScrDestroyObject, FixDestroyObject);
+	SetFixup(RPC_ServerJoin, FixServerJoin);
+	SetFixup(RPC_WorldPlayerAdd, FixWorldPlayerAdd);
+	SetFixup(RPC_WorldPlayerRemove, FixWorldPlayerRemove);
+	SetFixup(RPC_ServerQuit, FixServerQuit);
+	SetFixup(RPC_ScrSetPlayerName, FixSetPlayerName);
+	for(const stRPCIdPair& pair : g_rpcIdPairs) {
+		if(pair.conversion && *pair.samp >= 0 && *pair.samp < 256) {
+			g_rpcConversions[*pair.samp] = pair.conversion;
+		}
+	}
+	if(client) {
+		for(int rpcId = 0; rpcId < 256; rpcId++) {
+			client->SetRPCFilter((unsigned char)rpcId, IsRPCNeedFix(rpcId) ? FixBrokenRPC : nullptr);
+		}
+	}
+}
+
+bool IsRPCNeedFix(int rpcId)
+{
+	return rpcId >= 0 && rpcId < 256 && (g_rpcFixups[rpcId] || g_rpcConversions[rpcId]);
+}
+
+// false when the payload is too short for its layout, and the RPC is dropped
+static bool ConvertPayload(const stRpcConversion* conversion, RPCParameters* rpcParams, uint32_t* inputLen)
+{
+	uint8_t* out = conversion->inPlace ? rpcParams->input : (uint8_t*)CRPCArena::Alloc(conversion->outSize);
+	if(!out) {
+		return false;
+	}
+	uint32_t outLen = conversion->convert(rpcParams->input, *inputLen, out);
+	if(!outLen) {
+		return false;
+	}
+	rpcParams->input = out;
+	rpcParams->numberOfBitsOfData = BYTES_TO_BITS(outLen);
+	*inputLen = outLen;
+	return true;
+}
+
+void FixBrokenRPC(int rpcId, RPCParameters* rpcParams, void (*staticFunc)(RPCParameters*))
+{
+	PROFILE_SCOPE(PROFILE_RPC_FIX);
+	STALL_SCOPE(STALL_RPC_FIXUP);
+	ALLOC_RPC_SCOPE(rpcId);
+	CRPCArena::Scope arena;
+	if(CWorldSnapshot::IsTracked(rpcId)) {
+		CWorldSnapshot::Record(rpcId, rpcParams, staticFunc);
+	}
+	if(!IsRPCNeedFix(rpcId)) {
+		staticFunc(rpcParams);
+		return;
+	}
+	uint32_t inputLen = BITS_TO_BYTES(rpcParams->numberOfBitsOfData);
+	if(g_rpcConversions[rpcId] && !ConvertPayload(g_rpcConversions[rpcId], rpcParams, &inputLen)) {
+		return;
+	}
+	RPCFixup fixup = g_rpcFixups[rpcId];
+	if(!fixup) {
+		staticFunc(rpcParams);
+		return;
+	}
+	fixup(rpcId, rpcParams, inputLen, staticFunc);
+}
@@ -6,6 +6,7 @@
 #include "vendor/RakNet/BitStream.h"
 #include "vendor/RakNet/SAMP/SAMPRPC.h"
 #include "vendor/RakNet/PacketPriority.h"
+#include "vendor/RakNet/RakClientInterface.h"
 
 #include "game/math/vector.h"
 
@@ -218,6 +219,7 @@ enum BRPacketReliability : int32_t
 };
 
 int ConvertBRIDToSampID(BRRpcIds value);
+int ConvertSampIDToBRID(int sampId);
 PacketReliability ConvertBRToSampReliability(BRPacketReliability reliability);
 
 #pragma pack(push, 1);
@@ -396,9 +398,11 @@ struct BRNewVehiclePacked
 	uint8_t bEnabledSiren;
 };
 
-void ConvertBROnFootSyncToSampSync(RakNet::BitStream*, BROnFootSyncData);
-void ConvertBRInCarSyncToSampSync(RakNet::BitStream*, BRInCarSyncData);
-void ConvertBRPassengerSyncToSampSync(RakNet::BitStream*, BRPassengerSyncData);
-
+// Fixups and payload layouts (see rpcschema.h) by SA-MP RPC id. InitialiseRPCFixups fills
+// both tables and, given a client, sets FixBrokenRPC as the RakPeer RPC filter for every id
+// that has either; the rest reach the game's handler directly.
+void InitialiseRPCFixups(RakClientInterface* client);
 bool IsRPCNeedFix(int rpcId);
+// the filter: records what CWorldSnapshot tracks, then converts the payload and runs the id's
+// fixup in a CRPCArena scope
 void FixBrokenRPC(int rpcId, RPCParameters* rpcParams, void (*staticFunc)(RPCParameters*));
@@ -0,0 +1,82 @@
+#include "debounce.h"
+#include "config.h"
+
+#include "vendor/RakNet/GetTime.h"
+#include "vendor/RakNet/SAMP/SAMPRPC.h"
+
+uint16_t CDebounce::m_windowMs[256];
+uint16_t CDebounce::m_uiWindowMs = 0;
+CDebounce::stLast CDebounce::m_lastRpc[256];
+CDebounce::stLast CDebounce::m_lastUi;
+std::atomic<uint32_t> CDebounce::m_nDropped(0);
+
+// FNV-1a; a match also needs the same length, so two different taps colliding is out of reach
+static uint64_t Hash(const uint8_t* data, uint32_t size)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for(uint32_t i = 0; i < size; i++) {
+		hash = (hash ^ data[i]) * 0x100000001b3ull;
+	}
+	return hash;
+}
+
+static void SetWindow(uint16_t* table, int sampRpcId, uint32_t windowMs)
+{
+	if(sampRpcId >= 0 && sampRpcId < 256) {
+		table[sampRpcId] = (uint16_t)windowMs;
+	}
+}
+
+void CDebounce::Apply()
+{
+	const CConfig::stDebounce& config = CConfig::Get().debounce;
+	for(int i = 0; i < 256; i++) {
+		m_windowMs[i] = 0;
+		m_lastRpc[i] = stLast();
+	}
+	SetWindow(m_windowMs, RPC_DialogResponse, config.rpcMs);
+	SetWindow(m_windowMs, RPC_ClickTextDraw, config.rpcMs);
+	for(const CConfig::stRpcDebounce& entry : config.rpcs) {
+		SetWindow(m_windowMs, entry.rpcId, entry.windowMs);
+	}
+	m_uiWindowMs = (uint16_t)config.uiMs;
+	m_lastUi = stLast();
+}
+
+bool CDebounce::IsRepeat(stLast& last, uint32_t windowMs, const uint8_t* data, uint32_t bits)
+{
+	uint64_t hash = Hash(data, (bits + 7) / 8);
+	uint32_t now = RakNet::GetTime();
+	if(last.sentAt && last.bits == bits && last.hash == hash && now - last.sentAt < windowMs) {
+		m_nDropped.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+	last.hash = hash;
+	last.bits = bits;
+	// 0 means nothing was sent yet
+	last.sentAt = now ? now : 1;
+	return false;
+}
+
+bool CDebounce::IsRepeatRpc(int sampRpcId, const uint8_t* data, uint32_t bits)
+{
+	if(sampRpcId < 0 || sampRpcId >= 256 || !m_windowMs[sampRpcId]) {
+		return false;
+	}
+	return IsRepeat(m_lastRpc[sampRpcId], m_windowMs[sampRpcId], data, bits);
+}
+
+bool CDebounce::IsRepeatUi(const uint8_t* data, uint32_t bytes)
+{
+	if(!m_uiWindowMs) {
+		return false;
+	}
+	return IsRepeat(m_lastUi, m_uiWindowMs, data, bytes * 8);
+}
+
+void CDebounce::Forget(int sampRpcId)
+{
+	if(sampRpcId >= 0 && sampRpcId < 256) {
+		m_lastRpc[sampRpcId] = stLast();
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Drops a UI action repeated within its window. A player hammering a textdraw, a dialog button
+// or a BR UI element sends the same RPC or UI sync several times a second, and every copy would
+// be translated, sent reliably and handled by the server. A repeat is the same payload as the
+// last one of its kind that went out; anything else goes out at once and becomes the new last.
+// Checked in the send hooks before anything is parsed or copied. Game thread only.
+class CDebounce
+{
+public:
+	// before connecting, with CSendClass::Apply
+	static void Apply();
+
+	// true when the RPC repeats the last one of its id, sent less than its window ago
+	static bool IsRepeatRpc(int sampRpcId, const uint8_t* data, uint32_t bits);
+	// the same for a BR_ID_USER_INTERFACE_SYNC packet
+	static bool IsRepeatUi(const uint8_t* data, uint32_t bytes);
+	// the next one of this id, or the next UI sync, goes out whatever it repeats; for when the
+	// server shows something new that the same tap answers again, like another dialog
+	static void Forget(int sampRpcId);
+	static void ForgetUi() { m_lastUi = stLast(); }
+
+	// any thread
+	static uint32_t GetDropped() { return m_nDropped.load(std::memory_order_relaxed); }
+
+private:
+	struct stLast
+	{
+		uint64_t hash;
+		uint32_t bits;
+		uint32_t sentAt;
+	};
+
+	static bool IsRepeat(stLast& last, uint32_t windowMs, const uint8_t* data, uint32_t bits);
+
+	static uint16_t m_windowMs[256];
+	static uint16_t m_uiWindowMs;
+	static stLast m_lastRpc[256];
+	static stLast m_lastUi;
+	static std::atomic<uint32_t> m_nDropped;
+};
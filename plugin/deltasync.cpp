@@ -0,0 +1,292 @@
+#include "deltasync.h"
+#include "arena.h"
+#include "capabilities.h"
+#include "pools/playerpool.h"
+#include "vendor/RakNet/BitStream.h"
+#include "vendor/RakNet/GetTime.h"
+#include "vendor/RakNet/PacketEnumerations.h"
+#include "vendor/RakNet/RakClientInterface.h"
+
+#include <string.h>
+
+extern RakClientInterface* pRakClient;
+
+// seq, baseline, length
+static constexpr uint32_t HEADER_SIZE = 2 + 2 + 1;
+static constexpr uint32_t TIMESTAMP_SIZE = sizeof(uint8_t) + sizeof(RakNetTime);
+
+CDeltaSync::stOutbound CDeltaSync::m_outbound[2];
+CDeltaSync::stInbound* CDeltaSync::m_inbound[MAX_PLAYERS];
+std::vector<uint16_t> CDeltaSync::m_unacked[2];
+uint32_t CDeltaSync::m_lastAckAt = 0;
+
+// large enough for any sync packet either way, timestamp and player id included
+static uint8_t g_packet[TIMESTAMP_SIZE + 1 + 2 + HEADER_SIZE + CDeltaSync::MaxDelta(CDeltaSync::MAX_BODY)];
+
+int CDeltaSync::KindIndex(uint8_t kind)
+{
+	if(kind == ID_PLAYER_SYNC || kind == ID_PLAYER_SYNC_DELTA) {
+		return 0;
+	}
+	if(kind == ID_VEHICLE_SYNC || kind == ID_VEHICLE_SYNC_DELTA) {
+		return 1;
+	}
+	return -1;
+}
+
+uint32_t CDeltaSync::WriteDelta(const uint8_t* body, uint32_t length, const uint8_t* base, uint32_t baseLength, uint8_t* out)
+{
+	uint32_t words = (length + 3) / 4;
+	uint32_t maskSize = (words + 7) / 8;
+	memset(out, 0, maskSize);
+	uint8_t* op = out + maskSize;
+	for(uint32_t word = 0, offset = 0; word < words; word++, offset += 4)
+	{
+		uint32_t size = length - offset < 4 ? length - offset : 4;
+		bool same;
+		if(size == 4 && offset + 4 <= baseLength) {
+			uint32_t now, then;
+			memcpy(&now, body + offset, 4);
+			memcpy(&then, base + offset, 4);
+			same = now == then;
+		}
+		else {
+			same = offset + size <= baseLength && memcmp(body + offset, base + offset, size) == 0;
+		}
+		if(same) {
+			continue;
+		}
+		out[word >> 3] |= (uint8_t)(1 << (word & 7));
+		memcpy(op, body + offset, size);
+		op += size;
+	}
+	return (uint32_t)(op - out);
+}
+
+bool CDeltaSync::ReadDelta(const uint8_t* in, uint32_t inLength, const uint8_t* base, uint32_t baseLength, uint32_t length, uint8_t* out)
+{
+	uint32_t words = (length + 3) / 4;
+	uint32_t maskSize = (words + 7) / 8;
+	if(inLength < maskSize) {
+		return false;
+	}
+	const uint8_t* ip = in + maskSize;
+	const uint8_t* iend = in + inLength;
+	for(uint32_t word = 0, offset = 0; word < words; word++, offset += 4)
+	{
+		uint32_t size = length - offset < 4 ? length - offset : 4;
+		if(in[word >> 3] & (1 << (word & 7))) {
+			if((uint32_t)(iend - ip) < size) {
+				return false;
+			}
+			memcpy(out + offset, ip, size);
+			ip += size;
+		}
+		else {
+			if(offset + size > baseLength) {
+				return false;
+			}
+			memcpy(out + offset, base + offset, size);
+		}
+	}
+	return ip == iend;
+}
+
+const uint8_t* CDeltaSync::Encode(const uint8_t* packet, uint32_t* length)
+{
+	int kind = KindIndex(packet[0]);
+	uint32_t bodyLength = *length - 1;
+	if(kind < 0 || bodyLength > MAX_BODY || !CCapabilities::Has(CCapabilities::CAP_DELTA_SYNC)) {
+		return packet;
+	}
+
+	stOutbound& outbound = m_outbound[kind];
+	uint16_t seq = outbound.seq++;
+	// the slot about to be reused can't be the baseline: that one is less than RING back
+	const stBody* base = nullptr;
+	if(outbound.hasBaseline && (uint16_t)(seq - outbound.baseline) < RING) {
+		base = &outbound.bodies[outbound.baseline % RING];
+	}
+	stBody& sent = outbound.bodies[seq % RING];
+	sent.seq = seq;
+	sent.length = (uint8_t)bodyLength;
+	memcpy(sent.bytes, packet + 1, bodyLength);
+
+	uint8_t* op = g_packet;
+	*op++ = kind == 0 ? ID_PLAYER_SYNC_DELTA : ID_VEHICLE_SYNC_DELTA;
+	uint16_t baseline = base ? base->seq : seq;
+	memcpy(op, &seq, sizeof(seq));
+	memcpy(op + 2, &baseline, sizeof(baseline));
+	op[4] = (uint8_t)bodyLength;
+	op += HEADER_SIZE;
+	if(base) {
+		op += WriteDelta(sent.bytes, bodyLength, base->bytes, base->length, op);
+	}
+	else {
+		memcpy(op, sent.bytes, bodyLength);
+		op += bodyLength;
+	}
+	*length = (uint32_t)(op - g_packet);
+	return g_packet;
+}
+
+void CDeltaSync::OnAck(const uint8_t* data, uint32_t length)
+{
+	uint32_t offset = data[0] == ID_TIMESTAMP ? TIMESTAMP_SIZE : 0;
+	if(length < offset + 1 + 1 + 2) {
+		return;
+	}
+	int kind = KindIndex(data[offset + 1]);
+	if(kind < 0) {
+		return;
+	}
+	uint16_t seq;
+	memcpy(&seq, data + offset + 2, sizeof(seq));
+
+	stOutbound& outbound = m_outbound[kind];
+	// only what is still in the ring, and never back to an older baseline
+	bool held = (uint16_t)(outbound.seq - 1 - seq) < RING && outbound.bodies[seq % RING].seq == seq;
+	if(held && (!outbound.hasBaseline || (int16_t)(seq - outbound.baseline) > 0)) {
+		outbound.baseline = seq;
+		outbound.hasBaseline = true;
+	}
+}
+
+const CDeltaSync::stBody* CDeltaSync::Find(const stInbound& player, uint16_t seq)
+{
+	uint32_t held = player.count < RING ? player.count : RING;
+	for(uint32_t i = 1; i <= held; i++) {
+		const stBody& body = player.bodies[(player.count - i) % RING];
+		if(body.seq == seq) {
+			return &body;
+		}
+	}
+	return nullptr;
+}
+
+const uint8_t* CDeltaSync::Expand(const uint8_t* data, uint32_t* length)
+{
+	uint32_t offset = data[0] == ID_TIMESTAMP ? TIMESTAMP_SIZE : 0;
+	if(*length < offset + 1 + 2 + HEADER_SIZE) {
+		return nullptr;
+	}
+	const uint8_t* ip = data + offset;
+	int kind = KindIndex(ip[0]);
+	uint16_t playerId, seq, baseline;
+	memcpy(&playerId, ip + 1, sizeof(playerId));
+	memcpy(&seq, ip + 3, sizeof(seq));
+	memcpy(&baseline, ip + 5, sizeof(baseline));
+	uint32_t bodyLength = ip[7];
+	ip += 1 + 2 + HEADER_SIZE;
+	uint32_t inLength = *length - (uint32_t)(ip - data);
+	if(kind < 0 || playerId >= MAX_PLAYERS || bodyLength > MAX_BODY) {
+		return nullptr;
+	}
+
+	stInbound*& slot = m_inbound[playerId];
+	if(!slot) {
+		slot = CArena::New<stInbound>();
+	}
+	stInbound& player = *slot;
+	bool keyframe = baseline == seq;
+	uint8_t plainId = kind == 0 ? ID_PLAYER_SYNC : ID_VEHICLE_SYNC;
+	if(keyframe || player.kind != plainId) {
+		// a keyframe starts over; whatever is left may belong to an earlier player with this id
+		if(player.kind != plainId) {
+			player.unacked = false;
+		}
+		player.kind = plainId;
+		player.count = 0;
+	}
+
+	stBody& taken = player.bodies[player.count % RING];
+	uint8_t bytes[MAX_BODY];
+	if(keyframe) {
+		if(inLength != bodyLength) {
+			return nullptr;
+		}
+		memcpy(bytes, ip, bodyLength);
+	}
+	else {
+		const stBody* base = Find(player, baseline);
+		if(!base || !ReadDelta(ip, inLength, base->bytes, base->length, bodyLength, bytes)) {
+			return nullptr;
+		}
+	}
+	taken.seq = seq;
+	taken.length = (uint8_t)bodyLength;
+	memcpy(taken.bytes, bytes, bodyLength);
+	player.count++;
+	if(!player.unacked) {
+		player.unacked = true;
+		m_unacked[kind].push_back(playerId);
+	}
+
+	// the plain packet, timestamp header and all
+	uint8_t* op = g_packet;
+	memcpy(op, data, offset);
+	op += offset;
+	*op++ = plainId;
+	memcpy(op, &playerId, sizeof(playerId));
+	op += sizeof(playerId);
+	memcpy(op, bytes, bodyLength);
+	op += bodyLength;
+	*length = (uint32_t)(op - g_packet);
+	return g_packet;
+}
+
+void CDeltaSync::SendAcks()
+{
+	uint32_t now = RakNet::GetTime();
+	if(now - m_lastAckAt < ACK_INTERVAL_MS || (m_unacked[0].empty() && m_unacked[1].empty())) {
+		return;
+	}
+	m_lastAckAt = now;
+
+	for(int kind = 0; kind < 2; kind++)
+	{
+		uint8_t plainId = kind == 0 ? ID_PLAYER_SYNC : ID_VEHICLE_SYNC;
+		uint16_t entries[255][2];
+		uint32_t count = 0;
+		for(size_t i = 0; i <= m_unacked[kind].size(); i++)
+		{
+			if(i < m_unacked[kind].size())
+			{
+				uint16_t playerId = m_unacked[kind][i];
+				stInbound& player = *m_inbound[playerId];
+				// switched kind since, its newest sync is acknowledged from the other list
+				if(player.kind != plainId || !player.unacked) {
+					continue;
+				}
+				player.unacked = false;
+				entries[count][0] = playerId;
+				entries[count][1] = player.bodies[(player.count - 1) % RING].seq;
+				count++;
+			}
+			if(count == 255 || (count && i == m_unacked[kind].size()))
+			{
+				RakNet::BitStream bsAck;
+				bsAck.Write((uint8_t)ID_SYNC_BASELINE_ACK);
+				bsAck.Write(plainId);
+				bsAck.Write((uint8_t)count);
+				bsAck.Write((const char*)entries, count * sizeof(entries[0]));
+				pRakClient->Send(&bsAck, HIGH_PRIORITY, UNRELIABLE, 0);
+				count = 0;
+			}
+		}
+		m_unacked[kind].clear();
+	}
+}
+
+void CDeltaSync::Reset()
+{
+	memset(m_outbound, 0, sizeof(m_outbound));
+	// the slots stay for the next connection
+	for(stInbound* player : m_inbound) {
+		if(player) {
+			*player = stInbound();
+		}
+	}
+	m_unacked[0].clear();
+	m_unacked[1].clear();
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "pools/playerpool.h"
+
+// On-foot and in-car sync as what changed since a baseline the other side has confirmed,
+// with CAP_DELTA_SYNC. Keys, health, weapon and special action hardly ever change between
+// two syncs, and neither do the upper bytes of a position, so a delta is usually well under
+// half of the full sync. Each side numbers its syncs and acknowledges the other's:
+//
+//   ID_PLAYER_SYNC_DELTA / ID_VEHICLE_SYNC_DELTA, after the optional timestamp header:
+//     [uint16 playerId, server to client only] uint16 seq, uint16 baseline, uint8 length,
+//     then the body whole when baseline == seq (a keyframe), or else one bit per 4-byte word
+//     of the body telling whether it differs from the baseline, followed by those words
+//   ID_SYNC_BASELINE_ACK, server to client: uint8 kind, uint16 seq
+//   ID_SYNC_BASELINE_ACK, client to server: uint8 kind, uint8 count, then per player
+//     uint16 playerId, uint16 seq of the newest sync taken
+//
+// kind is ID_PLAYER_SYNC or ID_VEHICLE_SYNC, and a body is what the plain packet carries after
+// the id (and the player id from the server), so both ends decode exactly what they would
+// without deltas. A baseline is one of the last RING syncs its receiver took; a delta against
+// one that's gone is dropped and the next ack lets the sender pick a newer one. The sender
+// keys again whenever its confirmed baseline falls out of its own ring. Game thread only.
+class CDeltaSync
+{
+public:
+	static constexpr uint32_t RING = 16;
+	static constexpr uint32_t MAX_BODY = 96;
+	static constexpr uint32_t ACK_INTERVAL_MS = 100;
+
+	// hook_RakClient__Send: the delta to send in place of a translated ID_PLAYER_SYNC or
+	// ID_VEHICLE_SYNC, with length updated; the packet itself when it's neither or deltas are off
+	static const uint8_t* Encode(const uint8_t* packet, uint32_t* length);
+	// Packet_PlayerSync / Packet_VehicleSync: the plain packet a delta stands for, with length
+	// updated, NULL when it's malformed or its baseline is gone; valid until the next call
+	static const uint8_t* Expand(const uint8_t* data, uint32_t* length);
+	// ID_SYNC_BASELINE_ACK from the server
+	static void OnAck(const uint8_t* data, uint32_t length);
+	// end of ProcessNetwork: acknowledges what came in, at most every ACK_INTERVAL_MS
+	static void SendAcks();
+	static void Reset();
+
+	// The body coding on its own. WriteDelta returns the bytes written to out, at most
+	// MaxDelta(length); ReadDelta fails when in doesn't decode against base into length bytes.
+	static constexpr uint32_t MaxDelta(uint32_t length) { return ((length + 3) / 4 + 7) / 8 + length; }
+	static uint32_t WriteDelta(const uint8_t* body, uint32_t length, const uint8_t* base, uint32_t baseLength, uint8_t* out);
+	static bool ReadDelta(const uint8_t* in, uint32_t inLength, const uint8_t* base, uint32_t baseLength, uint32_t length, uint8_t* out);
+
+private:
+	struct stBody
+	{
+		uint16_t seq;
+		uint8_t length;
+		uint8_t bytes[MAX_BODY];
+	};
+	// what we sent, by seq % RING
+	struct stOutbound
+	{
+		uint16_t seq;
+		bool hasBaseline;
+		uint16_t baseline;
+		stBody bodies[RING];
+	};
+	// what one remote player's syncs built, oldest overwritten first
+	struct stInbound
+	{
+		uint8_t kind;
+		uint32_t count;
+		bool unacked;
+		stBody bodies[RING];
+	};
+
+	static int KindIndex(uint8_t kind);
+	static const stBody* Find(const stInbound& player, uint16_t seq);
+
+	static stOutbound m_outbound[2];
+	// by player id, allocated for the players that actually sync
+	static stInbound* m_inbound[MAX_PLAYERS];
+	// players with a sync taken since the last ack, by kind
+	static std::vector<uint16_t> m_unacked[2];
+	static uint32_t m_lastAckAt;
+};
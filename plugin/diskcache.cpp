@@ -0,0 +1,55 @@
+#include "diskcache.h"
+#include "xorstr.h"
+
+#include <cstdint>
+#include <stdio.h>
+#include <sys/stat.h>
+
+std::string CDiskCache::HashName(const char* data, size_t size)
+{
+	// FNV-1a
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for(size_t i = 0; i < size; i++) {
+		hash = (hash ^ (uint8_t)data[i]) * 0x100000001B3ull;
+	}
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", (unsigned long long)hash);
+	return name;
+}
+
+bool CDiskCache::Read(const std::string& path, std::string* out)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if(!file) {
+		return false;
+	}
+	char chunk[512];
+	size_t read;
+	while((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+		out->append(chunk, read);
+	}
+	fclose(file);
+	return true;
+}
+
+bool CDiskCache::Write(const std::string& path, const std::string& data)
+{
+	std::string temp = path + (const char*)xorstr(".tmp");
+	FILE* file = fopen(temp.c_str(), "wb");
+	if(!file) {
+		return false;
+	}
+	bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+	ok = fclose(file) == 0 && ok;
+	if(!ok || rename(temp.c_str(), path.c_str()) != 0) {
+		remove(temp.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool CDiskCache::Exists(const std::string& path)
+{
+	struct stat st;
+	return stat(path.c_str(), &st) == 0 && st.st_size > 0;
+}
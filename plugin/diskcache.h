@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// File helpers for what CLogoCache and CAudioCache keep under the app's cache dir. Blocking,
+// so CWorkers only.
+class CDiskCache
+{
+public:
+	// FNV-1a as 16 hex digits, the name things are stored under
+	static std::string HashName(const char* data, size_t size);
+	static bool Read(const std::string& path, std::string* out);
+	// through a temporary, so a crash never leaves half a file under the real name
+	static bool Write(const std::string& path, const std::string& data);
+	static bool Exists(const std::string& path);
+};
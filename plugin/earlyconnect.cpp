@@ -0,0 +1,136 @@
+#include "earlyconnect.h"
+#include "featureflags.h"
+#include "joinhandshake.h"
+#include "netgame.h"
+#include "resolver.h"
+#include "xorstr.h"
+#include "game/hooks.h"
+
+#include <android/log.h>
+
+extern RakClientInterface* pRakClient;
+
+CEarlyConnect::eEarlyState CEarlyConnect::m_state = CEarlyConnect::EARLY_IDLE;
+std::vector<Packet*> CEarlyConnect::m_held;
+size_t CEarlyConnect::m_nextHeld = 0;
+
+void CEarlyConnect::Process()
+{
+	if(m_state == EARLY_IDLE) {
+		// only ever the first connect, a flag turned on later waits for the next launch
+		if(!CFeatures::IsEnabled(FEATURE_EARLY_CONNECT)) {
+			m_state = EARLY_DONE;
+			return;
+		}
+		CJoinHandshake::OnConnect();
+		PrepareConnect(pRakClient);
+		m_state = EARLY_RESOLVED;
+	}
+	if(m_state == EARLY_RESOLVED) {
+		Start();
+	}
+	if(m_state == EARLY_HOLDING) {
+		Receive();
+	}
+}
+
+void CEarlyConnect::Start()
+{
+	bool waiting;
+	bool connecting = ConnectEndpoints(&waiting);
+	if(waiting) {
+		m_state = EARLY_RESOLVING;
+		CResolver::OnIdle([](bool ok) {
+			// the game may have connected on its own meanwhile
+			if(m_state != EARLY_RESOLVING) {
+				return;
+			}
+			if(ok) {
+				m_state = EARLY_RESOLVED;
+			} else {
+				GiveUp();
+			}
+		});
+		return;
+	}
+	if(!connecting) {
+		GiveUp();
+		return;
+	}
+	m_state = EARLY_HOLDING;
+	__android_log_print(ANDROID_LOG_INFO, xorstr("EarlyConnect"), xorstr("connecting while the game loads"));
+}
+
+void CEarlyConnect::Receive()
+{
+	Packet* pkt;
+	while((pkt = pRakClient->Receive())) {
+		switch(pkt->data[0])
+		{
+			case ID_AUTH_KEY:
+				CNetGame::Packet_AuthKey(pkt, pRakClient);
+				pRakClient->DeallocatePacket(pkt);
+				break;
+			case ID_CONNECTION_ATTEMPT_FAILED:
+			case ID_NO_FREE_INCOMING_CONNECTIONS:
+			case ID_CONNECTION_BANNED:
+			case ID_INVALID_PASSWORD:
+			case ID_CONNECTION_LOST:
+			case ID_DISCONNECTION_NOTIFICATION:
+				__android_log_print(ANDROID_LOG_INFO, xorstr("EarlyConnect"), xorstr("dropped on packet %u, the game connects itself"), pkt->data[0]);
+				pRakClient->DeallocatePacket(pkt);
+				GiveUp();
+				return;
+			default:
+				m_held.push_back(pkt);
+				break;
+		}
+	}
+}
+
+void CEarlyConnect::GiveUp()
+{
+	if(m_state == EARLY_HOLDING) {
+		pRakClient->Disconnect(0, 0);
+		for(Packet* pkt : m_held) {
+			pRakClient->DeallocatePacket(pkt);
+		}
+		m_held.clear();
+	}
+	// the game's own connect starts the clock again
+	CJoinHandshake::Reset();
+	m_state = EARLY_DONE;
+}
+
+bool CEarlyConnect::Claim()
+{
+	if(m_state == EARLY_HOLDING) {
+		// whatever came in since the last tick goes first
+		Receive();
+	}
+	if(m_state == EARLY_RESOLVING || m_state == EARLY_RESOLVED) {
+		// still looking the names up, the game's connect does that itself
+		GiveUp();
+	}
+	if(m_state != EARLY_HOLDING) {
+		return false;
+	}
+	m_state = EARLY_CLAIMED;
+	__android_log_print(ANDROID_LOG_INFO, xorstr("EarlyConnect"), xorstr("handed over with %u packets held"), (unsigned)m_held.size());
+	return true;
+}
+
+Packet* CEarlyConnect::TakeHeld()
+{
+	if(m_state != EARLY_CLAIMED) {
+		return nullptr;
+	}
+	if(m_nextHeld == m_held.size()) {
+		m_held.clear();
+		m_held.shrink_to_fit();
+		m_nextHeld = 0;
+		m_state = EARLY_DONE;
+		return nullptr;
+	}
+	return m_held[m_nextHeld++];
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vendor/RakNet/NetworkTypes.h"
+
+// With FEATURE_EARLY_CONNECT the session is opened from the first game tick instead of when
+// the game reaches its connect state, so the name lookups, the connection request and the
+// ID_AUTH_KEY exchange overlap asset loading. Auth keys are answered as they come; anything
+// else received meanwhile, ID_CONNECTION_REQUEST_ACCEPTED included, is held back and handed
+// to CNetGame::ProcessNetwork once the game calls Connect, so the join starts from the same
+// packet it always did. RakNet's own thread keeps the connection alive while it is held.
+// A refusal or a lost connection before then drops the early session and leaves the game
+// to connect the usual way. Game thread only.
+class CEarlyConnect
+{
+public:
+	// once per game tick, from CApp::Process
+	static void Process();
+	// from the Connect hook: true when the early session takes the place of that connect
+	static bool Claim();
+	// packets are still being held for the game, ProcessNetwork must not receive
+	static bool IsHolding() { return m_state == EARLY_HOLDING; }
+	// the next held packet once claimed, in the order they arrived
+	static Packet* TakeHeld();
+
+private:
+	enum eEarlyState
+	{
+		EARLY_IDLE,
+		EARLY_RESOLVING,	// waiting on CResolver before anything is sent
+		EARLY_RESOLVED,
+		EARLY_HOLDING,
+		EARLY_CLAIMED,		// held packets go to ProcessNetwork
+		EARLY_DONE
+	};
+
+	static void Start();
+	static void Receive();
+	static void GiveUp();
+
+	static eEarlyState m_state;
+	static std::vector<Packet*> m_held;
+	static size_t m_nextHeld;
+};
@@ -0,0 +1,26 @@
+#include "framearena.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+CFrameArena CFrameArena::m_overlay;
+CFrameArena CFrameArena::m_network;
+
+char* CFrameArena::Format(const char* fmt, ...)
+{
+	// format straight into what is left, then keep only what was written
+	uint32_t offset = (m_used + 7) & ~7u;
+	if(offset >= SIZE) {
+		return nullptr;
+	}
+	char* out = (char*)m_buffer + offset;
+	va_list args;
+	va_start(args, fmt);
+	int len = vsnprintf(out, SIZE - offset, fmt, args);
+	va_end(args);
+	if(len < 0 || (uint32_t)len >= SIZE - offset) {
+		return nullptr;
+	}
+	m_used = offset + len + 1;
+	return out;
+}
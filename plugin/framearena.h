@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+// Scratch memory that lives until the owner's next Reset: one for the overlay, reset at the
+// top of every hook_eglSwapBuffers, and one for the game thread, reset when
+// CNetGame::ProcessNetwork starts a drain. Each may only be used from the thread that
+// resets it. Anything that outlives its call should be released with a Scope, so one busy
+// frame doesn't starve the rest of it.
+class CFrameArena
+{
+public:
+	static constexpr uint32_t SIZE = 32 * 1024;
+
+	class Scope
+	{
+	public:
+		explicit Scope(CFrameArena& arena) : m_arena(arena), m_mark(arena.m_used) {}
+		~Scope() { m_arena.m_used = m_mark; }
+	private:
+		CFrameArena& m_arena;
+		uint32_t m_mark;
+	};
+
+	void Reset() { m_used = 0; }
+	// 8-byte aligned, NULL once the arena is exhausted
+	void* Alloc(uint32_t size)
+	{
+		uint32_t offset = (m_used + 7) & ~7u;
+		if(offset + size > SIZE) {
+			return nullptr;
+		}
+		m_used = offset + size;
+		return m_buffer + offset;
+	}
+	// printf into the arena, NULL if it doesn't fit
+	char* Format(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+	static CFrameArena& Overlay() { return m_overlay; }
+	static CFrameArena& Network() { return m_network; }
+
+private:
+	alignas(8) unsigned char m_buffer[SIZE];
+	uint32_t m_used = 0;
+
+	static CFrameArena m_overlay;
+	static CFrameArena m_network;
+};
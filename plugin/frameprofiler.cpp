@@ -0,0 +1,78 @@
+#include "frameprofiler.h"
+
+#ifdef FRAME_PROFILER
+
+#include "xorstr.h"
+
+#include <cfloat>
+#include <cstdio>
+
+#include "vendor/imgui/imgui.h"
+
+bool CFrameProfiler::m_bShowOverlay = true;
+std::atomic<uint64_t> CFrameProfiler::m_pending[PROFILE_SECTION_COUNT];
+// the last row is the frame time itself
+float CFrameProfiler::m_history[PROFILE_SECTION_COUNT + 1][HISTORY];
+int CFrameProfiler::m_head = 0;
+uint64_t CFrameProfiler::m_lastSwap = 0;
+
+static const char* const g_sectionNames[PROFILE_SECTION_COUNT] = {
+	"Overlay",
+	"ProcessNetwork",
+	"FixBrokenRPC"
+};
+
+void CFrameProfiler::EndFrame()
+{
+	uint64_t now = Now();
+	m_history[PROFILE_SECTION_COUNT][m_head] = m_lastSwap ? (float)((now - m_lastSwap) / 1e6) : 0.f;
+	m_lastSwap = now;
+	for(int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+		m_history[i][m_head] = (float)(m_pending[i].exchange(0, std::memory_order_relaxed) / 1e6);
+	}
+	m_head = (m_head + 1) % HISTORY;
+}
+
+static void DrawSeries(const char* name, const float* values, int head, float scaleMax)
+{
+	float total = 0.f, peak = 0.f;
+	for(int i = 0; i < CFrameProfiler::HISTORY; i++) {
+		total += values[i];
+		if(values[i] > peak) {
+			peak = values[i];
+		}
+	}
+	char overlay[64];
+	snprintf(overlay, sizeof(overlay), xorstr("avg %.3f ms  max %.3f ms"), total / CFrameProfiler::HISTORY, peak);
+	ImGui::TextUnformatted(name);
+	// head is the oldest sample, so the graph scrolls right to left
+	ImGui::PlotLines(xorstr("##series"), values, CFrameProfiler::HISTORY, head, overlay,
+		0.f, scaleMax, ImVec2(ImGui::GetContentRegionAvail().x, 60.f));
+}
+
+void CFrameProfiler::DrawOverlay()
+{
+	if(!m_bShowOverlay) {
+		return;
+	}
+
+	ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowSize(ImVec2(560, 520), ImGuiCond_FirstUseEver);
+	if(!ImGui::Begin(xorstr("Frame profiler"), &m_bShowOverlay)) {
+		ImGui::End();
+		return;
+	}
+
+	ImGui::PushID(PROFILE_SECTION_COUNT);
+	// 33 ms keeps the 30 and 60 fps lines readable; spikes just clip
+	DrawSeries(xorstr("Frame time"), m_history[PROFILE_SECTION_COUNT], m_head, 33.f);
+	ImGui::PopID();
+	for(int i = 0; i < PROFILE_SECTION_COUNT; i++) {
+		ImGui::PushID(i);
+		DrawSeries(g_sectionNames[i], m_history[i], m_head, FLT_MAX);
+		ImGui::PopID();
+	}
+	ImGui::End();
+}
+
+#endif
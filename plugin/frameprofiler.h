@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <time.h>
+
+enum eProfileSection
+{
+	PROFILE_OVERLAY,	// our ImGui work in hook_eglSwapBuffers
+	PROFILE_NETWORK,	// the ProcessNetwork drain, RPC fixups included
+	PROFILE_RPC_FIX,	// FixBrokenRPC alone
+	PROFILE_SECTION_COUNT
+};
+
+// What the plugin costs per frame, drawn as graphs from CGUI::Render. Only built with
+// FRAME_PROFILER defined; otherwise PROFILE_SCOPE and every call below compile to nothing.
+// Sections can be timed from any thread, the swap hook closes the frame.
+class CFrameProfiler
+{
+public:
+	static constexpr int HISTORY = 240;
+
+#ifdef FRAME_PROFILER
+	class Scope
+	{
+	public:
+		explicit Scope(eProfileSection section) : m_section(section), m_start(Now()) {}
+		~Scope() { m_pending[m_section].fetch_add(Now() - m_start, std::memory_order_relaxed); }
+	private:
+		eProfileSection m_section;
+		uint64_t m_start;
+	};
+
+	static inline uint64_t Now()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+	}
+
+	// once per swap, before the overlay work is timed
+	static void EndFrame();
+	static void DrawOverlay();
+	static bool IsOverlayShown() { return m_bShowOverlay; }
+
+	static bool m_bShowOverlay;
+private:
+	static std::atomic<uint64_t> m_pending[PROFILE_SECTION_COUNT];
+	static float m_history[PROFILE_SECTION_COUNT + 1][HISTORY];
+	static int m_head;
+	static uint64_t m_lastSwap;
+#else
+	static inline void EndFrame() {}
+	static inline void DrawOverlay() {}
+	static inline bool IsOverlayShown() { return false; }
+#endif
+};
+
+#ifdef FRAME_PROFILER
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(section) CFrameProfiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(section)
+#else
+#define PROFILE_SCOPE(section) ((void)0)
+#endif
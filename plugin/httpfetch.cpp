@@ -0,0 +1,196 @@
+#include "httpfetch.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+JavaVM* CHttpFetch::m_pVM = nullptr;
+
+void CHttpFetch::Initialise(JNIEnv* env)
+{
+	if(!m_pVM) {
+		env->GetJavaVM(&m_pVM);
+	}
+}
+
+// clears a pending Java exception, true if there was one
+static bool Failed(JNIEnv* env)
+{
+	if(env->ExceptionCheck()) {
+		env->ExceptionClear();
+		return true;
+	}
+	return false;
+}
+
+static bool GetHeader(JNIEnv* env, jobject connection, jmethodID getHeaderField, const char* name, std::string* out)
+{
+	jstring value = (jstring)env->CallObjectMethod(connection, getHeaderField, env->NewStringUTF(name));
+	if(Failed(env) || !value) {
+		return false;
+	}
+	const char* chars = env->GetStringUTFChars(value, nullptr);
+	if(!chars) {
+		return false;
+	}
+	*out = chars;
+	env->ReleaseStringUTFChars(value, chars);
+	return true;
+}
+
+// The body is read through a channel straight into response->body, wrapped as a direct
+// ByteBuffer: no byte[] is filled on the Java side only to be copied out again here. A
+// known length is read into one buffer, anything else in chunks up to one byte past
+// maxBytes, which is how a longer body shows itself.
+static bool ReadBody(JNIEnv* env, jobject stream, long long contentLength, uint32_t maxBytes, stHttpResponse* response)
+{
+	jclass channelsClass = env->FindClass("java/nio/channels/Channels");
+	jclass channelClass = env->FindClass("java/nio/channels/ReadableByteChannel");
+	if(Failed(env) || !channelsClass || !channelClass) {
+		return false;
+	}
+	jmethodID newChannel = env->GetStaticMethodID(channelsClass, "newChannel", "(Ljava/io/InputStream;)Ljava/nio/channels/ReadableByteChannel;");
+	jmethodID read = env->GetMethodID(channelClass, "read", "(Ljava/nio/ByteBuffer;)I");
+	if(Failed(env) || !newChannel || !read) {
+		return false;
+	}
+	jobject channel = env->CallStaticObjectMethod(channelsClass, newChannel, stream);
+	if(Failed(env) || !channel) {
+		return false;
+	}
+
+	std::string& body = response->body;
+	size_t limit = contentLength >= 0 ? (size_t)contentLength : (size_t)maxBytes + 1;
+	size_t filled = 0, windowEnd = 0;
+	jobject window = nullptr;
+	bool ok = true;
+	while(filled < limit) {
+		if(filled == windowEnd) {
+			if(window) {
+				env->DeleteLocalRef(window);
+			}
+			windowEnd = contentLength >= 0 ? limit : std::min(limit, filled + CHttpFetch::READ_CHUNK);
+			if(windowEnd > body.capacity()) {
+				body.reserve(std::min(limit, std::max(windowEnd, body.capacity() * 2)));
+			}
+			body.resize(windowEnd);
+			window = env->NewDirectByteBuffer(&body[filled], windowEnd - filled);
+			if(Failed(env) || !window) {
+				ok = false;
+				break;
+			}
+		}
+		jint count = env->CallIntMethod(channel, read, window);
+		if(Failed(env)) {
+			ok = false;
+			break;
+		}
+		if(count < 0) {
+			break;
+		}
+		filled += count;
+	}
+	if(window) {
+		env->DeleteLocalRef(window);
+	}
+	env->DeleteLocalRef(channel);
+	body.resize(filled);
+	if(filled > maxBytes) {
+		response->tooLarge = true;
+		ok = false;
+	}
+	return ok;
+}
+
+static bool GetWith(JNIEnv* env, const std::string& url, const std::string& etag, uint32_t maxBytes, stHttpResponse* response)
+{
+	// FindClass on a native thread only sees the boot classes, which is all this needs
+	jclass urlClass = env->FindClass("java/net/URL");
+	jclass httpClass = env->FindClass("java/net/HttpURLConnection");
+	jclass streamClass = env->FindClass("java/io/InputStream");
+	if(Failed(env) || !urlClass || !httpClass || !streamClass) {
+		return false;
+	}
+	jmethodID urlInit = env->GetMethodID(urlClass, "<init>", "(Ljava/lang/String;)V");
+	jmethodID openConnection = env->GetMethodID(urlClass, "openConnection", "()Ljava/net/URLConnection;");
+	jmethodID setConnectTimeout = env->GetMethodID(httpClass, "setConnectTimeout", "(I)V");
+	jmethodID setReadTimeout = env->GetMethodID(httpClass, "setReadTimeout", "(I)V");
+	jmethodID setRequestProperty = env->GetMethodID(httpClass, "setRequestProperty", "(Ljava/lang/String;Ljava/lang/String;)V");
+	jmethodID getResponseCode = env->GetMethodID(httpClass, "getResponseCode", "()I");
+	jmethodID getHeaderField = env->GetMethodID(httpClass, "getHeaderField", "(Ljava/lang/String;)Ljava/lang/String;");
+	jmethodID getInputStream = env->GetMethodID(httpClass, "getInputStream", "()Ljava/io/InputStream;");
+	jmethodID disconnect = env->GetMethodID(httpClass, "disconnect", "()V");
+	jmethodID close = env->GetMethodID(streamClass, "close", "()V");
+	if(Failed(env) || !urlInit || !openConnection || !setConnectTimeout || !setReadTimeout || !setRequestProperty
+		|| !getResponseCode || !getHeaderField || !getInputStream || !disconnect || !close) {
+		return false;
+	}
+
+	jobject urlObject = env->NewObject(urlClass, urlInit, env->NewStringUTF(url.c_str()));
+	jobject connection = Failed(env) ? nullptr : env->CallObjectMethod(urlObject, openConnection);
+	if(Failed(env) || !connection || !env->IsInstanceOf(connection, httpClass)) {
+		return false;
+	}
+	env->CallVoidMethod(connection, setConnectTimeout, (jint)CHttpFetch::TIMEOUT_MS);
+	env->CallVoidMethod(connection, setReadTimeout, (jint)CHttpFetch::TIMEOUT_MS);
+	if(!etag.empty()) {
+		env->CallVoidMethod(connection, setRequestProperty, env->NewStringUTF("If-None-Match"), env->NewStringUTF(etag.c_str()));
+	}
+	if(!Failed(env)) {
+		jint code = env->CallIntMethod(connection, getResponseCode);
+		response->status = Failed(env) ? -1 : code;
+	}
+	if(response->status == 200)
+	{
+		GetHeader(env, connection, getHeaderField, "ETag", &response->etag);
+		std::string length, icy;
+		long long contentLength = -1;
+		if(GetHeader(env, connection, getHeaderField, "Content-Length", &length)) {
+			contentLength = std::max(strtoll(length.c_str(), nullptr, 10), -1ll);
+			response->tooLarge = contentLength > (long long)maxBytes;
+		} else {
+			// Icecast and SHOUTcast streams say who they are and never end
+			response->tooLarge = GetHeader(env, connection, getHeaderField, "icy-name", &icy)
+				|| GetHeader(env, connection, getHeaderField, "icy-metaint", &icy);
+		}
+		jobject stream = response->tooLarge ? nullptr : env->CallObjectMethod(connection, getInputStream);
+		if(!Failed(env) && stream)
+		{
+			bool ok = ReadBody(env, stream, contentLength, maxBytes, response);
+			env->CallVoidMethod(stream, close);
+			Failed(env);
+			if(!ok) {
+				response->body.clear();
+				response->status = response->tooLarge ? 200 : -1;
+			}
+		}
+	}
+	env->CallVoidMethod(connection, disconnect);
+	Failed(env);
+	return response->status != -1;
+}
+
+bool CHttpFetch::Get(const std::string& url, const std::string& etag, uint32_t maxBytes, stHttpResponse* response)
+{
+	if(!m_pVM) {
+		return false;
+	}
+	JNIEnv* env = nullptr;
+	bool attached = false;
+	if(m_pVM->GetEnv((void**)&env, JNI_VERSION_1_6) != JNI_OK) {
+		if(m_pVM->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+			return false;
+		}
+		attached = true;
+	}
+	bool ok = false;
+	if(env->PushLocalFrame(32) == 0) {
+		ok = GetWith(env, url, etag, maxBytes, response);
+		env->PopLocalFrame(nullptr);
+	}
+	Failed(env);
+	if(attached) {
+		m_pVM->DetachCurrentThread();
+	}
+	return ok;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <jni.h>
+
+#include <cstdint>
+#include <string>
+
+struct stHttpResponse
+{
+	// -1 when nothing came back
+	int status = -1;
+	std::string etag;
+	std::string body;
+	// a 200 whose body was over maxBytes, or had no end at all (a live stream); left unread
+	bool tooLarge = false;
+};
+
+// HTTP GETs through java.net.URL on a worker attached to the VM, which brings https and the
+// system's proxy settings along. Shared by CLogoCache and CAudioCache.
+class CHttpFetch
+{
+public:
+	static constexpr int TIMEOUT_MS = 10000;
+	// how far a body of unknown length grows per read
+	static constexpr size_t READ_CHUNK = 64 * 1024;
+
+	// once per game tick, until the VM is known
+	static void Initialise(JNIEnv* env);
+	static bool IsReady() { return m_pVM != nullptr; }
+	// blocking, CWorkers only. etag goes out as If-None-Match when set; false when there was
+	// no response at all
+	static bool Get(const std::string& url, const std::string& etag, uint32_t maxBytes, stHttpResponse* response);
+
+private:
+	static JavaVM* m_pVM;
+};
@@ -0,0 +1,289 @@
+#include "joinhandshake.h"
+#include "config.h"
+#include "featureflags.h"
+#include "protocol.h"
+#include "tracering.h"
+#include "xorstr.h"
+#include "vendor/RakNet/BitStream.h"
+#include "vendor/RakNet/GetTime.h"
+#include "vendor/RakNet/PacketEnumerations.h"
+#include "vendor/RakNet/RakClientInterface.h"
+#include "vendor/RakNet/SAMP/SAMPRPC.h"
+#include "vendor/RakNet/SAMP/samp_auth.h"
+
+#include <android/log.h>
+#include <string.h>
+
+extern RakClientInterface* pRakClient;
+
+static const char* const g_stageNames[JOIN_STAGE_COUNT] = {
+	"connecting",
+	"accepted",
+	"init game",
+	"spawn info",
+	"spawn reply",
+	"spawned"
+};
+
+bool CJoinHandshake::m_joining = false;
+uint32_t CJoinHandshake::m_start = 0;
+uint32_t CJoinHandshake::m_reachedMask = 0;
+uint32_t CJoinHandshake::m_reachedAt[JOIN_STAGE_COUNT];
+CJoinHandshake::eEarlySpawn CJoinHandshake::m_early = CJoinHandshake::EARLY_NONE;
+bool CJoinHandshake::m_spawnInfoCovered = false;
+bool CJoinHandshake::m_inInitGame = false;
+CJoinHandshake::eWait CJoinHandshake::m_wait = CJoinHandshake::WAIT_NONE;
+uint32_t CJoinHandshake::m_waitSince = 0;
+uint32_t CJoinHandshake::m_spawnRetries = 0;
+
+// a second unanswered RequestSpawn is left alone, the server has heard us
+static constexpr uint32_t MAX_SPAWN_RETRIES = 1;
+
+bool CJoinHandshake::Reach(eJoinStage stage)
+{
+	if(HasReached(stage)) {
+		return false;
+	}
+	m_reachedMask |= 1u << stage;
+	m_reachedAt[stage] = RakNet::GetTime() - m_start;
+	CTraceRing::Trace(TRACE_JOIN_STAGE, stage, m_reachedAt[stage]);
+	return true;
+}
+
+void CJoinHandshake::Reset()
+{
+	m_joining = false;
+	m_early = EARLY_NONE;
+	m_spawnInfoCovered = false;
+	m_inInitGame = false;
+	m_wait = WAIT_NONE;
+	m_spawnRetries = 0;
+}
+
+void CJoinHandshake::Wait(eWait wait)
+{
+	m_wait = wait;
+	m_waitSince = RakNet::GetTime();
+}
+
+bool CJoinHandshake::Process()
+{
+	uint32_t timeoutMs = CConfig::Get().joinTimeoutMs;
+	if(!m_joining || m_wait == WAIT_NONE || !timeoutMs || RakNet::GetTime() - m_waitSince < timeoutMs) {
+		return true;
+	}
+	if(m_wait == WAIT_SPAWN_REPLY)
+	{
+		if(m_spawnRetries >= MAX_SPAWN_RETRIES) {
+			m_wait = WAIT_NONE;
+			return true;
+		}
+		m_spawnRetries++;
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Join"), xorstr("no spawn reply after %u ms, asking again"), timeoutMs);
+		RequestSpawn();
+		return true;
+	}
+	eJoinStage stage = GetLatestStage();
+	CTraceRing::Trace(TRACE_JOIN_STALL, stage, RakNet::GetTime() - m_start);
+	__android_log_print(ANDROID_LOG_INFO, xorstr("Join"), xorstr("stalled at %s for %u ms, starting over"),
+		GetStageName(stage), timeoutMs);
+	m_wait = WAIT_NONE;
+	return false;
+}
+
+void CJoinHandshake::OnConnect()
+{
+	// a reconnect mid-join starts the clock over
+	Reset();
+	m_joining = true;
+	m_start = RakNet::GetTime();
+	m_reachedMask = 0;
+	Reach(JOIN_CONNECTING);
+}
+
+void CJoinHandshake::OnAccepted()
+{
+	if(m_joining) {
+		Reach(JOIN_ACCEPTED);
+		Wait(WAIT_INIT_GAME);
+	}
+}
+
+void CJoinHandshake::OnInitGame()
+{
+	if(!m_joining || !Reach(JOIN_INIT_GAME)) {
+		return;
+	}
+	m_wait = WAIT_NONE;
+	if(CFeatures::IsEnabled(FEATURE_EARLY_SPAWN)) {
+		RequestSpawn();
+		m_early = EARLY_SENT;
+	}
+}
+
+void CJoinHandshake::OnSpawnInfo()
+{
+	if(m_joining && Reach(JOIN_SPAWN_INFO) && m_early != EARLY_NONE) {
+		m_spawnInfoCovered = true;
+		return;
+	}
+	RequestSpawn();
+}
+
+void CJoinHandshake::OnSpawnReply(bool accepted)
+{
+	if(!m_joining) {
+		return;
+	}
+	if(m_wait == WAIT_SPAWN_REPLY) {
+		m_wait = WAIT_NONE;
+	}
+	if(accepted) {
+		Reach(JOIN_SPAWN_REPLY);
+	}
+	if(m_early != EARLY_SENT) {
+		return;
+	}
+	if(accepted) {
+		m_early = EARLY_ACCEPTED;
+		return;
+	}
+	// turned down, most likely for coming before the spawn info; ask the stock way
+	m_early = EARLY_NONE;
+	if(m_spawnInfoCovered) {
+		m_spawnInfoCovered = false;
+		RequestSpawn();
+	}
+}
+
+void CJoinHandshake::OnSpawned()
+{
+	if(!m_joining) {
+		return;
+	}
+	Reach(JOIN_SPAWNED);
+	m_joining = false;
+	__android_log_print(ANDROID_LOG_INFO, xorstr("Join"),
+		xorstr("spawned after %u ms: accepted %u, init game %u, spawn info %u, spawn reply %u%s"),
+		m_reachedAt[JOIN_SPAWNED], m_reachedAt[JOIN_ACCEPTED], m_reachedAt[JOIN_INIT_GAME],
+		m_reachedAt[JOIN_SPAWN_INFO], m_reachedAt[JOIN_SPAWN_REPLY],
+		m_early != EARLY_NONE ? xorstr(", spawn requested early") : "");
+	m_early = EARLY_NONE;
+	m_spawnInfoCovered = false;
+	m_wait = WAIT_NONE;
+}
+
+void CJoinHandshake::RequestSpawn()
+{
+	// no parameters, so the message is the header alone
+	RakNet::OutboundMessage bs;
+	if(pRakClient->BeginRPC(&bs, RPC_RequestSpawn, 0, 0, false)) {
+		pRakClient->Send(&bs, HIGH_PRIORITY, RELIABLE, 0);
+	}
+	if(m_joining) {
+		Wait(WAIT_SPAWN_REPLY);
+	}
+}
+
+eJoinStage CJoinHandshake::GetLatestStage()
+{
+	int stage = JOIN_STAGE_COUNT - 1;
+	while(stage > JOIN_CONNECTING && !HasReached((eJoinStage)stage)) {
+		stage--;
+	}
+	return (eJoinStage)stage;
+}
+
+const char* CJoinHandshake::GetStageName(eJoinStage stage)
+{
+	return g_stageNames[stage];
+}
+
+// Reconnects answer the same challenge again; a few recent keys skip the SHA1
+static constexpr uint32_t AUTH_KEY_CACHE_SIZE = 4;
+
+struct stAuthKeyCacheEntry
+{
+	uint8_t challengeLen;
+	char challenge[256];
+	char key[41];
+};
+
+static stAuthKeyCacheEntry g_authKeyCache[AUTH_KEY_CACHE_SIZE];
+static uint32_t g_authKeyCacheCount = 0;
+
+// most recently used first
+static const char* GetAuthKey(const char* challenge, uint8_t challengeLen)
+{
+	uint32_t index = 0;
+	for(; index < g_authKeyCacheCount; index++) {
+		const stAuthKeyCacheEntry& entry = g_authKeyCache[index];
+		if(entry.challengeLen == challengeLen && !memcmp(entry.challenge, challenge, challengeLen)) {
+			break;
+		}
+	}
+
+	stAuthKeyCacheEntry found;
+	if(index < g_authKeyCacheCount) {
+		found = g_authKeyCache[index];
+	} else {
+		found.challengeLen = challengeLen;
+		memcpy(found.challenge, challenge, challengeLen);
+		found.challenge[challengeLen] = '\0';
+		char key[260];
+		gen_auth_key(key, found.challenge);
+		memcpy(found.key, key, sizeof(found.key));
+		if(g_authKeyCacheCount < AUTH_KEY_CACHE_SIZE) {
+			g_authKeyCacheCount++;
+		}
+		index = g_authKeyCacheCount - 1;
+	}
+	memmove(&g_authKeyCache[1], &g_authKeyCache[0], index * sizeof(stAuthKeyCacheEntry));
+	g_authKeyCache[0] = found;
+	return g_authKeyCache[0].key;
+}
+
+bool CJoinHandshake::WriteAuthKey(const uint8_t* packet, uint32_t length, RakNet::BitStream* out)
+{
+	RakNet::BitStream bsAuth((unsigned char *)packet, length, false);
+
+	uint8_t byteAuthLen;
+	char szAuth[256];
+
+	bsAuth.IgnoreBits(8);
+	if(!bsAuth.Read(byteAuthLen) || !bsAuth.Read(szAuth, byteAuthLen)) {
+		return false;
+	}
+
+	const char* szAuthKey = GetAuthKey(szAuth, byteAuthLen);
+	uint8_t byteAuthKeyLen = (uint8_t)strlen(szAuthKey);
+
+	out->Write((uint8_t)ID_AUTH_KEY);
+	out->Write((uint8_t)byteAuthKeyLen);
+	out->Write(szAuthKey, byteAuthKeyLen);
+	return true;
+}
+
+void CJoinHandshake::WriteClientJoin(uint32_t challenge, const char* name, RakNet::BitStream* out)
+{
+	int iVersion = SampProtocol::NETGAME_VERSION;
+	char byteMod = 0x01;
+	unsigned int uiClientChallengeResponse = challenge ^ iVersion;
+
+	const char* sampVersion = xorstr("0.3.7");
+	const char* auth_bs = xorstr("15121F6F18550C00AC4B4F8A167D0379BB0ACA99043");
+
+	char byteAuthBSLen = (char)strlen(auth_bs);
+	char byteNameLen = (char)strlen(name);
+	char byteClientverLen = (char)strlen(sampVersion);
+
+	out->Write(iVersion);
+	out->Write(byteMod);
+	out->Write(byteNameLen);
+	out->Write(name, byteNameLen);
+	out->Write(uiClientChallengeResponse);
+	out->Write(byteAuthBSLen);
+	out->Write(auth_bs, byteAuthBSLen);
+	out->Write(byteClientverLen);
+	out->Write(sampVersion, byteClientverLen);
+}
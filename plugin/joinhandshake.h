@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+
+namespace RakNet { class BitStream; }
+
+enum eJoinStage
+{
+	JOIN_CONNECTING,	// connect issued, waiting for ID_CONNECTION_REQUEST_ACCEPTED
+	JOIN_ACCEPTED,		// ClientJoin, resume and capabilities sent in one go
+	JOIN_INIT_GAME,
+	JOIN_SPAWN_INFO,	// ScrSetSpawnInfo
+	JOIN_SPAWN_REPLY,	// the server's answer to RequestSpawn
+	JOIN_SPAWNED,		// the game sent RPC_Spawn
+	JOIN_STAGE_COUNT
+};
+
+// Follows a connect through to the first spawn and times every stage, logged under "Join"
+// once the player is in and shown by the netstats overlay. ClientJoin, the resume request
+// and the capabilities offer already leave together; the one step left waiting on a reply
+// it doesn't need is RequestSpawn, which stock SA-MP sends when ScrSetSpawnInfo lands, a
+// round trip after InitGame. With FEATURE_EARLY_SPAWN it goes out straight after InitGame
+// so it overlaps the server's spawn info, and ScrSetSpawnInfo only asks again if that
+// early request was turned down. Respawns keep the stock behaviour.
+//
+// The two waits that are on the server alone are timed against "joinTimeoutMs": ClientJoin
+// to InitGame, and RequestSpawn to its reply. A spawn request left unanswered is asked again;
+// a join InitGame never comes for makes Process report a stall, and CNetGame drops the
+// connection and lets it come back through the same lost-connection and reconnect path as any
+// other, with the clock started over. Everything after InitGame may sit on the player (login
+// dialogs, class selection) and is never timed. Game thread only.
+class CJoinHandshake
+{
+public:
+	static void OnConnect();
+	static void OnAccepted();
+	static void OnInitGame();
+	static void OnSpawnInfo();
+	static void OnSpawnReply(bool accepted);
+	static void OnSpawned();
+	static void Reset();
+	// RequestClass from the game is dropped while InitGame is handled, see hook_RakClient__RPC
+	static void BeginInitGame() { m_inInitGame = true; }
+	static void EndInitGame() { m_inInitGame = false; }
+	static bool IsInInitGame() { return m_inInitGame; }
+	// once per network drain; false when the join has stalled and should start over
+	static bool Process();
+
+	// false once the first spawn went out or the connection went away
+	static bool IsJoining() { return m_joining; }
+	static bool HasReached(eJoinStage stage) { return (m_reachedMask >> stage) & 1; }
+	// ms from the connect to the stage
+	static uint32_t GetStageMs(eJoinStage stage) { return m_reachedAt[stage]; }
+	static eJoinStage GetLatestStage();
+	static const char* GetStageName(eJoinStage stage);
+
+	// The join messages byte for byte as CNetGame sends them; tools/loadgen sends the same.
+	// At most the id and the key with its length byte
+	static constexpr uint32_t AUTH_KEY_BYTES = 1 + 1 + 255;
+	// At most the version, the mod byte, the name, the challenge response and the auth and
+	// client version strings, each string behind its length byte
+	static constexpr uint32_t CLIENT_JOIN_BYTES = 4 + 1 + (1 + 255) + 4 + (1 + 43) + (1 + 5);
+	// The answer to an ID_AUTH_KEY challenge packet, false when the packet is malformed
+	static bool WriteAuthKey(const uint8_t* packet, uint32_t length, RakNet::BitStream* out);
+	// RPC_ClientJoin for the challenge ID_CONNECTION_REQUEST_ACCEPTED carried
+	static void WriteClientJoin(uint32_t challenge, const char* name, RakNet::BitStream* out);
+
+private:
+	enum eEarlySpawn
+	{
+		EARLY_NONE,
+		EARLY_SENT,		// in flight, ScrSetSpawnInfo leaves the asking to it
+		EARLY_ACCEPTED
+	};
+
+	enum eWait
+	{
+		WAIT_NONE,
+		WAIT_INIT_GAME,		// ClientJoin is out
+		WAIT_SPAWN_REPLY,	// RequestSpawn is out
+	};
+
+	// false for a stage that was already reached
+	static bool Reach(eJoinStage stage);
+	static void RequestSpawn();
+	static void Wait(eWait wait);
+
+	static bool m_joining;
+	static uint32_t m_start;
+	static uint32_t m_reachedMask;
+	static uint32_t m_reachedAt[JOIN_STAGE_COUNT];
+	static eEarlySpawn m_early;
+	// the first ScrSetSpawnInfo was left to the early request
+	static bool m_spawnInfoCovered;
+	static bool m_inInitGame;
+	static eWait m_wait;
+	static uint32_t m_waitSince;
+	// spawn requests asked again in this join
+	static uint32_t m_spawnRetries;
+};
@@ -0,0 +1,150 @@
+#include "logocache.h"
+#include "config.h"
+#include "diskcache.h"
+#include "httpfetch.h"
+#include "joinhandshake.h"
+#include "workers.h"
+#include "xorstr.h"
+
+#include <android/log.h>
+#include <memory>
+#include <stdio.h>
+#include <sys/stat.h>
+
+CLogoCache::eState CLogoCache::m_state = CLogoCache::LOGO_IDLE;
+uint32_t CLogoCache::m_generation = 0;
+std::string CLogoCache::m_url;
+std::string CLogoCache::m_dir;
+std::string CLogoCache::m_hash;
+std::string CLogoCache::m_etag;
+bool CLogoCache::m_shown = false;
+CLogoCache::ShowFn CLogoCache::m_show;
+
+static std::string ImagePath(const std::string& dir, const std::string& hash)
+{
+	return dir + "/" + hash + (const char*)xorstr(".img");
+}
+
+static std::string RefPath(const std::string& dir, const std::string& url)
+{
+	return dir + "/" + CDiskCache::HashName(url.data(), url.size()) + (const char*)xorstr(".url");
+}
+
+void CLogoCache::Request(const std::string& url, ShowFn show)
+{
+	const CConfig::stSettings& config = CConfig::Get();
+	if(!config.logoCache || config.cacheDir.empty() || url.empty()) {
+		show(url);
+		return;
+	}
+	uint32_t generation = ++m_generation;
+	m_url = url;
+	m_show = std::move(show);
+	m_shown = false;
+	m_hash.clear();
+	m_etag.clear();
+	m_dir = config.cacheDir + (const char*)xorstr("/logos");
+	m_state = LOGO_LOOKUP;
+
+	struct stLookup
+	{
+		std::string hash;
+		std::string etag;
+		bool cached = false;
+	};
+	auto lookup = std::make_shared<stLookup>();
+	std::string dir = m_dir;
+	CWorkers::Submit([lookup, dir, url] {
+		std::string ref;
+		if(!CDiskCache::Read(RefPath(dir, url), &ref)) {
+			return;
+		}
+		size_t newline = ref.find('\n');
+		lookup->hash = ref.substr(0, newline);
+		lookup->etag = newline == std::string::npos ? std::string() : ref.substr(newline + 1);
+		lookup->cached = CDiskCache::Exists(ImagePath(dir, lookup->hash));
+	}, [lookup, generation] {
+		if(generation != m_generation) {
+			return;
+		}
+		if(lookup->cached) {
+			m_hash = lookup->hash;
+			m_etag = lookup->etag;
+			m_shown = true;
+			m_show(std::string(xorstr("file://")) + ImagePath(m_dir, m_hash));
+		}
+		m_state = LOGO_WAITING;
+	});
+}
+
+void CLogoCache::Process()
+{
+	if(m_state == LOGO_WAITING && CHttpFetch::IsReady() && !CJoinHandshake::IsJoining()) {
+		Fetch();
+	}
+}
+
+void CLogoCache::Reset()
+{
+	m_generation++;
+	m_state = LOGO_IDLE;
+	m_show = nullptr;
+}
+
+void CLogoCache::Fetch()
+{
+	m_state = LOGO_FETCHING;
+	uint32_t generation = m_generation;
+	struct stFetch
+	{
+		std::string hash;
+		bool ok = false;
+	};
+	auto result = std::make_shared<stFetch>();
+	std::string url = m_url, dir = m_dir, oldHash = m_hash, etag = m_etag;
+	CWorkers::Submit([result, url, dir, oldHash, etag] {
+		stHttpResponse response;
+		if(!CHttpFetch::Get(url, oldHash.empty() ? std::string() : etag, MAX_BYTES, &response)) {
+			return;
+		}
+		if(response.status == 304) {
+			result->hash = oldHash;
+			result->ok = !oldHash.empty();
+			return;
+		}
+		if(response.status != 200 || response.tooLarge || response.body.empty()) {
+			return;
+		}
+		mkdir(dir.c_str(), 0700);
+		std::string hash = CDiskCache::HashName(response.body.data(), response.body.size());
+		if(!CDiskCache::Exists(ImagePath(dir, hash)) && !CDiskCache::Write(ImagePath(dir, hash), response.body)) {
+			return;
+		}
+		if(!CDiskCache::Write(RefPath(dir, url), hash + "\n" + response.etag)) {
+			return;
+		}
+		// another URL may have pointed at it too; it is fetched again the next time it comes up
+		if(!oldHash.empty() && oldHash != hash) {
+			remove(ImagePath(dir, oldHash).c_str());
+		}
+		result->hash = hash;
+		result->ok = true;
+	}, [result, generation, oldHash] {
+		if(generation != m_generation) {
+			return;
+		}
+		m_state = LOGO_IDLE;
+		if(!result->ok) {
+			__android_log_print(ANDROID_LOG_INFO, xorstr("Logo"), xorstr("fetch failed, %s"), m_shown ? "keeping the cached one" : "leaving it to the game");
+			if(!m_shown) {
+				m_shown = true;
+				m_show(m_url);
+			}
+			return;
+		}
+		if(!m_shown || result->hash != oldHash) {
+			m_shown = true;
+			m_show(std::string(xorstr("file://")) + ImagePath(m_dir, result->hash));
+		}
+	});
+}
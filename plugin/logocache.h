@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Server logos kept in the app's cache dir, so a rejoin shows the logo without downloading
+// it again. Files are content addressed: logos/<FNV-1a of the image>.img holds the bytes and
+// logos/<FNV-1a of the URL>.url the image hash and ETag for that URL, so servers sharing a
+// logo share the file. A known URL is shown from disk as soon as a worker has looked it up;
+// the URL itself is fetched (or revalidated with If-None-Match) only once the join is through,
+// so it never competes with the join RPCs. An unknown URL is shown once that fetch lands, and
+// as the game would have shown it if the fetch fails. Fetches go through CHttpFetch.
+// Game thread only.
+class CLogoCache
+{
+public:
+	typedef std::function<void(const std::string& url)> ShowFn;
+
+	static constexpr uint32_t MAX_BYTES = 1024 * 1024;
+
+	// show gets a file:// URL, or url itself when there is nothing better
+	static void Request(const std::string& url, ShowFn show);
+	// once per game tick
+	static void Process();
+	// the connection went away; nothing in flight shows a logo after this
+	static void Reset();
+
+private:
+	enum eState
+	{
+		LOGO_IDLE,
+		LOGO_LOOKUP,	// a worker reads the .url file
+		LOGO_WAITING,	// for the join to finish
+		LOGO_FETCHING,
+	};
+
+	static void Fetch();
+
+	static eState m_state;
+	// bumped by Reset and by every Request, so a stale done callback can tell
+	static uint32_t m_generation;
+	static std::string m_url;
+	static std::string m_dir;
+	// what the .url file held, empty when the URL is new
+	static std::string m_hash;
+	static std::string m_etag;
+	static bool m_shown;
+	static ShowFn m_show;
+};
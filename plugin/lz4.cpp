@@ -0,0 +1,170 @@
+#include "lz4.h"
+
+#include <string.h>
+
+static constexpr uint32_t MIN_MATCH = 4;
+// the format wants the last 5 bytes as literals and no match starting in the last 12
+static constexpr uint32_t LAST_LITERALS = 5;
+static constexpr uint32_t MF_LIMIT = 12;
+static constexpr uint32_t MAX_OFFSET = 65535;
+static constexpr int HASH_BITS = 12;
+
+static inline uint32_t Read32(const uint8_t* p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline uint32_t Hash(uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static inline uint8_t* WriteLength(uint8_t* op, uint32_t length)
+{
+	for(; length >= 255; length -= 255) {
+		*op++ = 255;
+	}
+	*op++ = (uint8_t)length;
+	return op;
+}
+
+// literals, then a match of matchLength (already less MIN_MATCH) at offset unless it's the last
+static uint8_t* WriteSequence(uint8_t* op, const uint8_t* oend, const uint8_t* literals, uint32_t literalLength,
+	uint32_t offset, uint32_t matchLength, bool last)
+{
+	uint32_t worst = 1 + literalLength / 255 + 1 + literalLength + (last ? 0 : 2 + matchLength / 255 + 1);
+	if(worst > (uint32_t)(oend - op)) {
+		return nullptr;
+	}
+	uint8_t* token = op++;
+	*token = (uint8_t)((literalLength < 15 ? literalLength : 15) << 4);
+	if(literalLength >= 15) {
+		op = WriteLength(op, literalLength - 15);
+	}
+	memcpy(op, literals, literalLength);
+	op += literalLength;
+	if(last) {
+		return op;
+	}
+
+	*op++ = (uint8_t)offset;
+	*op++ = (uint8_t)(offset >> 8);
+	*token |= (uint8_t)(matchLength < 15 ? matchLength : 15);
+	if(matchLength >= 15) {
+		op = WriteLength(op, matchLength - 15);
+	}
+	return op;
+}
+
+uint32_t lz4::Compress(const uint8_t* src, uint32_t size, uint8_t* dst, uint32_t capacity)
+{
+	const uint8_t* ip = src;
+	const uint8_t* anchor = src;
+	const uint8_t* end = src + size;
+	uint8_t* op = dst;
+	const uint8_t* oend = dst + capacity;
+
+	if(size > MF_LIMIT)
+	{
+		// positions + 1, so a zeroed slot means "nothing seen"
+		uint32_t table[1 << HASH_BITS] = {};
+		const uint8_t* matchLimit = end - LAST_LITERALS;
+		const uint8_t* mfLimit = end - MF_LIMIT;
+		while(ip < mfLimit)
+		{
+			uint32_t sequence = Read32(ip);
+			uint32_t& slot = table[Hash(sequence)];
+			const uint8_t* ref = slot ? src + slot - 1 : nullptr;
+			slot = (uint32_t)(ip - src) + 1;
+			if(!ref || (uint32_t)(ip - ref) > MAX_OFFSET || Read32(ref) != sequence) {
+				// skip faster through data that doesn't compress
+				ip += 1 + ((ip - anchor) >> 6);
+				continue;
+			}
+
+			const uint8_t* matchEnd = ip + MIN_MATCH;
+			ref += MIN_MATCH;
+			while(matchEnd < matchLimit && *matchEnd == *ref) {
+				matchEnd++;
+				ref++;
+			}
+			op = WriteSequence(op, oend, anchor, (uint32_t)(ip - anchor), (uint32_t)(matchEnd - ref),
+				(uint32_t)(matchEnd - ip) - MIN_MATCH, false);
+			if(!op) {
+				return 0;
+			}
+			ip = anchor = matchEnd;
+		}
+	}
+
+	op = WriteSequence(op, oend, anchor, (uint32_t)(end - anchor), 0, 0, true);
+	return op ? (uint32_t)(op - dst) : 0;
+}
+
+static inline bool ReadLength(const uint8_t*& ip, const uint8_t* iend, uint32_t* length)
+{
+	uint8_t byte;
+	do {
+		if(ip >= iend) {
+			return false;
+		}
+		byte = *ip++;
+		*length += byte;
+	} while(byte == 255);
+	return true;
+}
+
+uint32_t lz4::Decompress(const uint8_t* src, uint32_t size, uint8_t* dst, uint32_t capacity)
+{
+	const uint8_t* ip = src;
+	const uint8_t* iend = src + size;
+	uint8_t* op = dst;
+	uint8_t* oend = dst + capacity;
+
+	while(ip < iend)
+	{
+		uint8_t token = *ip++;
+		uint32_t literalLength = token >> 4;
+		if(literalLength == 15 && !ReadLength(ip, iend, &literalLength)) {
+			return 0;
+		}
+		if(literalLength > (uint32_t)(iend - ip) || literalLength > (uint32_t)(oend - op)) {
+			return 0;
+		}
+		memcpy(op, ip, literalLength);
+		op += literalLength;
+		ip += literalLength;
+		if(ip == iend) {
+			// the last sequence has no match
+			return (uint32_t)(op - dst);
+		}
+
+		if(iend - ip < 2) {
+			return 0;
+		}
+		uint32_t offset = ip[0] | ((uint32_t)ip[1] << 8);
+		ip += 2;
+		uint32_t matchLength = token & 15;
+		if(matchLength == 15 && !ReadLength(ip, iend, &matchLength)) {
+			return 0;
+		}
+		matchLength += MIN_MATCH;
+		if(!offset || offset > (uint32_t)(op - dst) || matchLength > (uint32_t)(oend - op)) {
+			return 0;
+		}
+		const uint8_t* ref = op - offset;
+		if(offset >= matchLength) {
+			memcpy(op, ref, matchLength);
+			op += matchLength;
+		}
+		else {
+			// overlapping, a run repeats what it just wrote
+			for(uint32_t i = 0; i < matchLength; i++) {
+				*op++ = *ref++;
+			}
+		}
+	}
+	return 0;
+}
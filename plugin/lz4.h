@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+// The LZ4 block format (no frame, no checksum), which any stock LZ4 library on the server
+// side reads and writes with LZ4_compress_default / LZ4_decompress_safe. The compressor is
+// the plain greedy one with a small hash table, payloads here are at most a few dozen KB.
+namespace lz4
+{
+	// worst case compressed size of size bytes
+	constexpr uint32_t Bound(uint32_t size) { return size + size / 255 + 16; }
+
+	// compressed size, 0 when it doesn't fit in capacity
+	uint32_t Compress(const uint8_t* src, uint32_t size, uint8_t* dst, uint32_t capacity);
+	// decoded size, 0 when the block is malformed or decodes past capacity
+	uint32_t Decompress(const uint8_t* src, uint32_t size, uint8_t* dst, uint32_t capacity);
+}
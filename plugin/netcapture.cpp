@@ -0,0 +1,350 @@
+#include "netcapture.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <mutex>
+#include <thread>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "workers.h"
+#include "vendor/RakNet/NetworkTypes.h"
+
+std::atomic<bool> CNetCapture::m_bActive(false);
+FILE* CNetCapture::m_pFile = nullptr;
+uint64_t CNetCapture::m_startUs = 0;
+uint64_t CNetCapture::m_lastUs = 0;
+uint64_t CNetCapture::m_lastFlushUs = 0;
+
+// records come from the game thread and the RakNet update thread alike
+static std::mutex g_captureMutex;
+// Records only get copied into one buffer while a worker writes out the other, so no
+// thread that logs ever waits on the disk. Large enough for a few hundred syncs. Each
+// buffer is one segment, its header filled in at the front when it is handed over.
+static constexpr uint32_t BUFFER_SIZE = 64 * 1024;
+alignas(8) static uint8_t g_buffers[2][BUFFER_SIZE];
+static int g_current = 0;
+static uint32_t g_fill = sizeof(stCaptureSegment);
+static stCaptureSegment g_segment;
+// the other buffer is still with the worker
+static std::atomic<bool> g_writing(false);
+
+static constexpr uint32_t MAX_HEAD_SIZE = 1 + 10 + 5 + 5;
+// a record has to fit an empty segment with room left for the padding; nothing on the wire comes close
+static constexpr uint32_t MAX_RECORD_BITS = (BUFFER_SIZE - sizeof(stCaptureSegment) - MAX_HEAD_SIZE - 7) * 8;
+
+static uint64_t NowUs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+static uint32_t PutVarint(uint8_t* out, uint64_t value)
+{
+	uint32_t len = 0;
+	while(value >= 0x80) {
+		out[len++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	out[len++] = (uint8_t)value;
+	return len;
+}
+
+static void WaitForWrite()
+{
+	// only when a whole buffer filled up before the disk took the last one
+	while(g_writing.load(std::memory_order_acquire)) {
+		std::this_thread::yield();
+	}
+}
+
+static void ResetSegment()
+{
+	memset(&g_segment, 0, sizeof(g_segment));
+	g_fill = sizeof(stCaptureSegment);
+}
+
+// under g_captureMutex: puts the header in front of the current buffer's records and pads
+// them, returns the size to write
+static uint32_t SealSegment()
+{
+	uint8_t* data = g_buffers[g_current];
+	g_segment.magic = stCaptureSegment::MAGIC;
+	g_segment.bytes = g_fill - sizeof(stCaptureSegment);
+	memcpy(data, &g_segment, sizeof(g_segment));
+	uint32_t size = g_fill;
+	while(size % 8) {
+		data[size++] = 0;
+	}
+	return size;
+}
+
+// under g_captureMutex
+static void FlushBuffer(FILE* file)
+{
+	if(!g_segment.records) {
+		return;
+	}
+	WaitForWrite();
+	g_writing.store(true, std::memory_order_relaxed);
+	const uint8_t* data = g_buffers[g_current];
+	uint32_t size = SealSegment();
+	g_current ^= 1;
+	ResetSegment();
+	CWorkers::Submit([file, data, size] {
+		fwrite(data, 1, size, file);
+		fflush(file);
+		g_writing.store(false, std::memory_order_release);
+	});
+}
+
+bool CNetCapture::Start(const char* path)
+{
+	std::lock_guard<std::mutex> lock(g_captureMutex);
+	if(m_pFile) {
+		return true;
+	}
+	m_pFile = fopen(path, "wb");
+	if(!m_pFile) {
+		return false;
+	}
+	uint32_t header[2] = { MAGIC, VERSION };
+	fwrite(header, sizeof(header), 1, m_pFile);
+	ResetSegment();
+	m_startUs = m_lastFlushUs = NowUs();
+	m_bActive.store(true, std::memory_order_relaxed);
+	return true;
+}
+
+void CNetCapture::Stop()
+{
+	std::lock_guard<std::mutex> lock(g_captureMutex);
+	m_bActive.store(false, std::memory_order_relaxed);
+	if(m_pFile) {
+		// the tail is written here, Stop is rare enough to wait for the disk
+		WaitForWrite();
+		if(g_segment.records) {
+			fwrite(g_buffers[g_current], 1, SealSegment(), m_pFile);
+		}
+		ResetSegment();
+		fclose(m_pFile);
+		m_pFile = nullptr;
+	}
+}
+
+void CNetCapture::Process()
+{
+	if(!IsActive()) {
+		return;
+	}
+	uint64_t now = NowUs();
+	if(now - m_lastFlushUs < 1000000) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(g_captureMutex);
+	if(m_pFile) {
+		FlushBuffer(m_pFile);
+	}
+	m_lastFlushUs = now;
+}
+
+void CNetCapture::Write(uint8_t type, uint32_t id, const void* data, uint32_t bits)
+{
+	if(bits > MAX_RECORD_BITS) {
+		return;
+	}
+	uint32_t size = BITS_TO_BYTES(bits);
+
+	std::lock_guard<std::mutex> lock(g_captureMutex);
+	if(!m_pFile) {
+		return;
+	}
+	// records never straddle segments, so a segment can be read on its own
+	if(g_fill + MAX_HEAD_SIZE + size + 7 > BUFFER_SIZE) {
+		FlushBuffer(m_pFile);
+	}
+	uint64_t now = NowUs() - m_startUs;
+	if(!g_segment.records) {
+		g_segment.firstUs = m_lastUs = now;
+	}
+	uint8_t* out = g_buffers[g_current] + g_fill;
+	uint32_t len = 0;
+	out[len++] = type;
+	len += PutVarint(out + len, now - m_lastUs);
+	len += PutVarint(out + len, id);
+	len += PutVarint(out + len, bits);
+	if(size) {
+		memcpy(out + len, data, size);
+	}
+	g_fill += len + size;
+	g_segment.records++;
+	g_segment.lastUs = m_lastUs = now;
+	g_segment.Add(type, id);
+}
+
+static bool ReadVarint(const uint8_t** cursor, const uint8_t* end, uint64_t* value)
+{
+	*value = 0;
+	for(uint32_t shift = 0; shift < 64 && *cursor < end; shift += 7)
+	{
+		uint8_t ch = *(*cursor)++;
+		*value |= (uint64_t)(ch & 0x7F) << shift;
+		if(!(ch & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CNetCaptureReader::Open(const char* path)
+{
+	Close();
+	int fd = open(path, O_RDONLY);
+	if(fd < 0) {
+		return false;
+	}
+	struct stat st;
+	if(fstat(fd, &st) == 0 && st.st_size >= 8) {
+		void* map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(map != MAP_FAILED) {
+			m_pMap = (uint8_t*)map;
+			m_mapSize = (size_t)st.st_size;
+		}
+	}
+	close(fd);
+	if(!m_pMap) {
+		return false;
+	}
+	uint32_t header[2];
+	memcpy(header, m_pMap, sizeof(header));
+	if(header[0] != CNetCapture::MAGIC || header[1] != CNetCapture::VERSION) {
+		Close();
+		return false;
+	}
+
+	// a segment cut short or never sealed ends the capture
+	size_t offset = sizeof(header);
+	while(m_mapSize - offset >= sizeof(stCaptureSegment))
+	{
+		const stCaptureSegment* segment = (const stCaptureSegment*)(m_pMap + offset);
+		if(segment->magic != stCaptureSegment::MAGIC || segment->bytes > m_mapSize - offset - sizeof(stCaptureSegment)) {
+			break;
+		}
+		m_segments.push_back(segment);
+		offset += sizeof(stCaptureSegment) + ((segment->bytes + 7) & ~7u);
+		if(offset > m_mapSize) {
+			break;
+		}
+	}
+	EnterSegment(0);
+	return true;
+}
+
+void CNetCaptureReader::Close()
+{
+	if(m_pMap) {
+		munmap(m_pMap, m_mapSize);
+		m_pMap = nullptr;
+		m_mapSize = 0;
+	}
+	m_segments.clear();
+	m_segment = 0;
+	m_pCursor = m_pEnd = nullptr;
+	m_timeUs = 0;
+	m_seekUs = 0;
+	m_bFiltered = false;
+	memset(&m_wanted, 0, sizeof(m_wanted));
+}
+
+bool CNetCaptureReader::IsWanted(const stCaptureSegment* segment) const
+{
+	if(!m_bFiltered) {
+		return true;
+	}
+	for(uint32_t slot = 0; slot < 4; slot++) {
+		for(uint32_t word = 0; word < (stCaptureSegment::MAX_ID + 1) / 64; word++) {
+			if(segment->ids[slot][word] & m_wanted.ids[slot][word]) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool CNetCaptureReader::EnterSegment(size_t index)
+{
+	while(index < m_segments.size() && !IsWanted(m_segments[index])) {
+		index++;
+	}
+	m_segment = index;
+	if(index == m_segments.size()) {
+		m_pCursor = m_pEnd = nullptr;
+		return false;
+	}
+	const stCaptureSegment* segment = m_segments[index];
+	m_pCursor = (const uint8_t*)(segment + 1);
+	m_pEnd = m_pCursor + segment->bytes;
+	m_timeUs = segment->firstUs;
+	return true;
+}
+
+void CNetCaptureReader::Seek(uint64_t timeUs)
+{
+	// segments follow each other in time, so the first one still running at timeUs is found by halving
+	auto it = std::lower_bound(m_segments.begin(), m_segments.end(), timeUs,
+		[](const stCaptureSegment* segment, uint64_t time) { return segment->lastUs < time; });
+	EnterSegment(it - m_segments.begin());
+	m_seekUs = timeUs;
+}
+
+void CNetCaptureReader::Want(uint8_t type, uint32_t id)
+{
+	m_wanted.Add(type, id);
+	m_bFiltered = true;
+}
+
+void CNetCaptureReader::WantAll(uint8_t type)
+{
+	memset(m_wanted.ids[CaptureTypeSlot(type)], 0xFF, sizeof(m_wanted.ids[0]));
+	m_bFiltered = true;
+}
+
+bool CNetCaptureReader::Next(stRecord* record)
+{
+	for(;;)
+	{
+		if(m_pCursor == m_pEnd) {
+			if(m_segment >= m_segments.size() || !EnterSegment(m_segment + 1)) {
+				return false;
+			}
+			continue;
+		}
+		uint8_t type = *m_pCursor++;
+		uint64_t dt, id, bits;
+		if(!ReadVarint(&m_pCursor, m_pEnd, &dt) || !ReadVarint(&m_pCursor, m_pEnd, &id) || !ReadVarint(&m_pCursor, m_pEnd, &bits)) {
+			return false;
+		}
+		uint64_t size = BITS_TO_BYTES(bits);
+		if(size > (uint64_t)(m_pEnd - m_pCursor)) {
+			return false;
+		}
+		const uint8_t* data = m_pCursor;
+		m_pCursor += size;
+		m_timeUs += dt;
+
+		if(m_timeUs < m_seekUs || (m_bFiltered && !m_wanted.Has(type, (uint32_t)id))) {
+			continue;
+		}
+		record->type = type;
+		record->timeUs = m_timeUs;
+		record->id = (uint32_t)id;
+		record->bits = (uint32_t)bits;
+		record->data = data;
+		return true;
+	}
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <stdio.h>
+#include <vector>
+
+// Traffic log for offline tuning, replayed by tools/netbench (--replay). The file is a
+// "BRNC" magic and a uint32 version, then segments, each an stCaptureSegment header and the
+// records that went into one write buffer, padded to 8 bytes. One record per packet or RPC:
+//
+//   uint8  type      CAPTURE_* kind, | CAPTURE_OUT for traffic we send
+//   varint dtUs      since the previous record, or since firstUs for a segment's first
+//   varint id        packet id, or the RPC id (BR ids outbound, SA-MP ids inbound)
+//   varint bits      payload length in bits
+//   bytes            the payload, BITS_TO_BYTES(bits) of it
+//
+// Packets are logged whole, id byte included, as they come out of Receive or go into
+// hook_RakClient__Send. RPCs are logged before any rewrite.
+//
+// Segments go out about once a second and are never rewritten, so a capture cut short by the
+// process dying is readable up to its last whole segment. The headers alone make the index:
+// their times let a reader seek, their id masks let it pass over segments with nothing it
+// wants, and hopping from one to the next never touches a record.
+enum eCaptureType : uint8_t
+{
+	CAPTURE_PACKET = 0,
+	CAPTURE_RPC = 1,
+	CAPTURE_OUT = 0x80,
+};
+
+// index slot of a record type, for stCaptureSegment::ids
+static inline uint32_t CaptureTypeSlot(uint8_t type)
+{
+	return (type & CAPTURE_RPC) | ((type & CAPTURE_OUT) ? 2 : 0);
+}
+
+struct stCaptureSegment
+{
+	static constexpr uint32_t MAGIC = 0x4D474553; // "SEGM"
+	// BR RPC ids run past 0x1B0; anything higher shares the last bit
+	static constexpr uint32_t MAX_ID = 511;
+
+	uint32_t magic;
+	uint32_t bytes;			// of records, not counting the header or the padding
+	uint32_t records;
+	uint32_t reserved;
+	uint64_t firstUs;		// since the capture started
+	uint64_t lastUs;
+	// per CaptureTypeSlot, a bit for every id with a record in the segment
+	uint64_t ids[4][(MAX_ID + 1) / 64];
+
+	static inline uint32_t IdBit(uint32_t id) { return id < MAX_ID ? id : MAX_ID; }
+	void Add(uint8_t type, uint32_t id)
+	{
+		uint32_t bit = IdBit(id);
+		ids[CaptureTypeSlot(type)][bit / 64] |= 1ull << (bit % 64);
+	}
+	bool Has(uint8_t type, uint32_t id) const
+	{
+		uint32_t bit = IdBit(id);
+		return (ids[CaptureTypeSlot(type)][bit / 64] >> (bit % 64)) & 1;
+	}
+};
+
+class CNetCapture
+{
+public:
+	static constexpr uint32_t MAGIC = 0x434E5242; // "BRNC"
+	static constexpr uint32_t VERSION = 2;
+
+	static bool Start(const char* path);
+	static void Stop();
+	// once per frame: pushes what is buffered to disk every second, since the
+	// process usually dies without a Stop
+	static void Process();
+	static bool IsActive() { return m_bActive.load(std::memory_order_relaxed); }
+
+	// no-ops unless a capture is running, so call sites don't need to check
+	static inline void Record(uint8_t type, uint32_t id, const void* data, uint32_t bits)
+	{
+		if(IsActive()) {
+			Write(type, id, data, bits);
+		}
+	}
+
+private:
+	static void Write(uint8_t type, uint32_t id, const void* data, uint32_t bits);
+	static std::atomic<bool> m_bActive;
+	static FILE* m_pFile;
+	static uint64_t m_startUs;
+	static uint64_t m_lastUs;
+	static uint64_t m_lastFlushUs;
+};
+
+// Reader for the same format. The file is mapped rather than read, so records are handed out
+// in place and an hour-long capture costs no more to open than the segment headers it has.
+class CNetCaptureReader
+{
+public:
+	struct stRecord
+	{
+		uint8_t type;
+		uint64_t timeUs;	// since the capture started
+		uint32_t id;
+		uint32_t bits;
+		const uint8_t* data;	// into the mapping, valid until Close
+	};
+
+	CNetCaptureReader() : m_pMap(nullptr), m_mapSize(0), m_segment(0), m_pCursor(nullptr), m_pEnd(nullptr), m_timeUs(0), m_seekUs(0), m_bFiltered(false) {}
+	~CNetCaptureReader() { Close(); }
+
+	bool Open(const char* path);
+	void Close();
+	// false at the end of the file or on a damaged record
+	bool Next(stRecord* record);
+
+	// continues from the first record at or after timeUs
+	void Seek(uint64_t timeUs);
+	// after Open: once anything is wanted, Next only returns what is, and segments without
+	// any of it are skipped whole. Ids past stCaptureSegment::MAX_ID share one bit
+	void Want(uint8_t type, uint32_t id);
+	void WantAll(uint8_t type);
+
+	uint64_t GetDurationUs() const { return m_segments.empty() ? 0 : m_segments.back()->lastUs; }
+	size_t GetSegmentCount() const { return m_segments.size(); }
+
+private:
+	bool EnterSegment(size_t index);
+	bool IsWanted(const stCaptureSegment* segment) const;
+
+	uint8_t* m_pMap;
+	size_t m_mapSize;
+	std::vector<const stCaptureSegment*> m_segments;
+	size_t m_segment;			// the one m_pCursor is in, or past the end
+	const uint8_t* m_pCursor;
+	const uint8_t* m_pEnd;
+	uint64_t m_timeUs;
+	uint64_t m_seekUs;
+	bool m_bFiltered;
+	stCaptureSegment m_wanted;	// only the ids are used
+};
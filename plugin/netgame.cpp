@@ -1,99 +1,245 @@
 #include "netgame.h"
+#include "chatbuffer.h"
+#include "netstats.h"
+#include "netcapture.h"
+#include "alloctracker.h"
+#include "frameprofiler.h"
+#include "joinhandshake.h"
+#include "logocache.h"
+#include "reconnect.h"
+#include "sendclass.h"
+#include "capabilities.h"
+#include "deltasync.h"
+#include "earlyconnect.h"
+#include "framearena.h"
+#include "standby.h"
+#include "worldsnapshot.h"
+#include "syncdecode.h"
+#include "syncinterest.h"
+#include "syncjitter.h"
+#include "syncqueue.h"
+#include "syncrate.h"
+#include "uisync.h"
+#include "telemetry.h"
+#include "textdrawbuffer.h"
+#include "tracering.h"
+#include "wireschema.h"
 #include "xorstr.h"
 
 #include "plugin.h"
+#include "config.h"
 
 #include "game/BRNotification.h"
-
-#define NETGAME_VERSION 4057
+#include "game/CPlayerPed.h"
+#include "vendor/RakNet/GetTime.h"
+#include "pools/playergrid.h"
+#include "pools/playernames.h"
+#include "pools/playerstate.h"
+#include "pools/objectqueue.h"
+#include "pools/playerqueue.h"
+#include "pools/vehiclequeue.h"
+#include "pools/vehiclepool.h"
 
 extern RakClientInterface* pRakClient;
 
 uint16_t CNetGame::m_nLastSAMPDialogID;
 
+// latest decoded sync per player for the current drain, the kind says which slot is live
+static ePendingSync g_pendingKind[MAX_PLAYERS];
+static BROnFootSyncData g_pendingOnFoot[MAX_PLAYERS];
+static BRInCarSyncData g_pendingInCar[MAX_PLAYERS];
+static uint8_t g_pendingPassenger[MAX_PLAYERS][BR_PASSENGER_SYNC_SIZE];
+static stPackedNormQuat g_pendingQuat[MAX_PLAYERS];
+// set while the rotation is still packed in g_pendingQuat; CSyncQueue hands syncs over decoded
+static bool g_pendingPacked[MAX_PLAYERS];
+static uint32_t g_pendingTime[MAX_PLAYERS];
+static uint64_t g_pendingReceived[MAX_PLAYERS];
+static uint16_t g_pendingIds[MAX_PLAYERS];
+static uint16_t g_pendingCount = 0;
+
+// Aim and bullet sync are relayed to the game as opaque blobs, straight out of the packet
+constexpr uint32_t AIM_SYNC_SIZE = 31;
+constexpr uint32_t BULLET_SYNC_SIZE = 40;
+
+static uint8_t* GetOpaqueSync(Packet* pkt, uint32_t size, uint16_t* playerId)
+{
+	uint32_t offset = (uint8_t)pkt->data[0] == ID_TIMESTAMP ? sizeof(uint8_t) + sizeof(RakNetTime) : 0;
+	offset += sizeof(uint8_t);
+	if(offset + sizeof(uint16_t) + size > pkt->length) {
+		return nullptr;
+	}
+	memcpy(playerId, pkt->data + offset, sizeof(uint16_t));
+	return pkt->data + offset + sizeof(uint16_t);
+}
+
+// the bullet data starts with the hit type and the id of whatever was hit
+constexpr uint8_t BULLET_HIT_TYPE_PLAYER = 1;
+
+static void MarkPending(uint16_t playerId, ePendingSync kind, uint32_t time, uint64_t receivedNs)
+{
+	g_pendingTime[playerId] = time;
+	g_pendingReceived[playerId] = receivedNs;
+	if(g_pendingKind[playerId] == PENDING_NONE) {
+		g_pendingIds[g_pendingCount++] = playerId;
+	}
+	g_pendingKind[playerId] = kind;
+}
+
 uint8_t GetPacketID(Packet *p)
 {
 	if(p == 0) { return 255; }
 	if ((uint8_t)p->data[0] == ID_TIMESTAMP) {
-		return (uint8_t)p->data[sizeof(uint8_t) + sizeof(unsigned long)];
+		return (uint8_t)p->data[sizeof(uint8_t) + sizeof(RakNetTime)];
 	} else {
 		return (uint8_t)p->data[0];
 	}
 }
 
+// RakPeer has already shifted an ID_TIMESTAMP stamp into our clock by the peer's clock
+// differential, so it says when the server sampled the state. Anything unstamped is
+// taken as of now. The game only compares these against each other, to order syncs.
+uint32_t GetPacketTime(Packet* p)
+{
+	RakNetTime time;
+	if(p->length >= sizeof(uint8_t) + sizeof(RakNetTime) && (uint8_t)p->data[0] == ID_TIMESTAMP) {
+		memcpy(&time, p->data + sizeof(uint8_t), sizeof(time));
+	} else {
+		time = RakNet::GetTime();
+	}
+	// 0 tells the game there is no timestamp
+	return time ? (uint32_t)time : 1;
+}
+
 CPlayerPool* CNetGame::GetPlayerPool()
 {
-	return *(CPlayerPool **)(CGameAPI::GetBase(xorstr("CNetGame::m_pPlayerPool")));
+	return *g_Game.m_pPlayerPool;
+}
+
+void stNetDrain::Capture()
+{
+	gameState = CNetGame::GetGameState();
+	playerPool = CNetGame::GetPlayerPool();
+	CLocalPlayer* localPlayer = playerPool ? playerPool->GetLocalPlayer() : nullptr;
+	localPlayerId = localPlayer ? localPlayer->GetLocalPlayerID() : UNASSIGNED_PLAYER_INDEX;
+}
+
+bool stNetDrain::IsConnected()
+{
+	// InitGame may have come through the Receive that returned this packet
+	if(gameState != GAMESTATE_CONNECTED) {
+		Capture();
+	}
+	return gameState == GAMESTATE_CONNECTED;
 }
 
 void CNetGame::ProcessNetwork()
 {
+	PROFILE_SCOPE(PROFILE_NETWORK);
+	ALLOC_SCOPE(ALLOC_NETWORK);
+	CFrameArena::Network().Reset();
+	// the game is still loading as far as the early session is concerned
+	if(CEarlyConnect::IsHolding()) {
+		return;
+	}
+	if(!CJoinHandshake::Process()) {
+		RestartJoin();
+	}
+	// A join floods in thousands of RPCs at once; past the budget they wait for the next frame
+	// while connection packets still come out, and syncs only ever keep the newest per player
+	uint32_t rpcBudgetUs = CConfig::Get().rpcBudgetUs;
+	RakNetTimeNS drainStart = RakNet::GetTimeNS();
+	pRakClient->SetRPCDeadline(rpcBudgetUs ? drainStart + rpcBudgetUs : 0);
+	stNetDrain drain;
+	drain.Capture();
+	CLocalPlayer* localPlayer = drain.playerPool ? drain.playerPool->GetLocalPlayer() : nullptr;
+	CPlayerPed* localPed = localPlayer ? localPlayer->GetPlayerPed() : nullptr;
+	CVector origin;
+	if(localPed) {
+		origin = localPed->m_matrix.GetPosition();
+	}
+	CSyncInterest::Begin(localPed ? &origin : nullptr);
 	Packet* pkt = nullptr;
 	uint8_t packetIdentifier;
-	while(pkt = pRakClient->Receive())
+	uint32_t packets = 0;
+	while((pkt = CEarlyConnect::TakeHeld()) || (pkt = CStandby::TakeHeld()) || (pkt = pRakClient->Receive()))
 	{
+		packets++;
 		packetIdentifier = GetPacketID(pkt);
+		CNetCapture::Record(CAPTURE_PACKET, packetIdentifier, pkt->data, BYTES_TO_BITS(pkt->length));
+		CNetStats::Scope stats(NETSTAT_IN_PACKET, packetIdentifier, pkt->length);
+		ALLOC_PACKET_SCOPE(packetIdentifier);
+		// the packets that move the connection along, not the traffic over it
+		if(packetIdentifier == ID_AUTH_KEY || (packetIdentifier >= ID_CONNECTION_ATTEMPT_FAILED && packetIdentifier <= ID_INVALID_PASSWORD)) {
+			CTraceRing::Trace(TRACE_CONNECTION, packetIdentifier);
+		}
 		switch(packetIdentifier)
 		{
 			case ID_FAILED_INITIALIZE_ENCRIPTION:
-				CChat::AddDebugMessage(xorstr("Failed to initialize encryption."));
+				CHAT_INFO(xorstr("Failed to initialize encryption."));
 				break;
 			case ID_CONNECTION_ATTEMPT_FAILED:
-				CChat::AddDebugMessage(xorstr("Сервер не отвечает. Переподключение..."));
+				CHAT_INFO(xorstr("Сервер не отвечает. Переподключение..."));
 				BrNotification(TYPE_TEXT_GREEN, "Переподключение t.me/kuzia15", 5);
-				SetGameState(GAMESTATE_WAIT_CONNECT);
-				
+				CReconnect::OnAttemptFailed();
 				break;
 			case ID_NO_FREE_INCOMING_CONNECTIONS:
-				CChat::AddDebugMessage(xorstr("Сервер полон. Переподключение..."));
+				CHAT_INFO(xorstr("Сервер полон. Переподключение..."));
 				BrNotification(TYPE_TEXT_GREEN, "Переподключение t.me/kuzia15", 5);
-				SetGameState(GAMESTATE_WAIT_CONNECT);
 				pRakClient->Disconnect(0, 0);
+				CReconnect::OnRefused(pkt->playerId);
 				break;
 			case ID_CONNECTION_BANNED:
-				CChat::AddDebugMessage(xorstr("Вы были заблокированы на этом сервере."));
+				CHAT_INFO(xorstr("Вы были заблокированы на этом сервере."));
 				BrNotification(TYPE_TEXT_GREEN, "Banned t.me/kuzia15", 5);
 				break;
 			case ID_INVALID_PASSWORD:
-				CChat::AddDebugMessage(xorstr("Wrong server password."));
+				CHAT_INFO(xorstr("Wrong server password."));
 				pRakClient->Disconnect(0);
 				BrNotification(TYPE_TEXT_GREEN, "Wrong server pass t.me/kuzia15", 5);
 				break;
 			case ID_AUTH_KEY:
-				Packet_AuthKey(pkt);
+				Packet_AuthKey(pkt, pRakClient);
 				break;
 			case ID_CONNECTION_REQUEST_ACCEPTED:
 				Packet_ConnectionSucceeded(pkt);
+				drain.Capture();
 				break;
 			case ID_CONNECTION_LOST:
-				CChat::AddDebugMessage(xorstr("Переподключение через 15 секунд..."));
+				CHAT_INFO(xorstr("Переподключение через 15 секунд..."));
 				BrNotification(TYPE_TEXT_GREEN, "Lost Connect t.me/kuzia15", 5);
 				Packet_ConnectionLost(pkt);
+				drain.Capture();
 				break;
 			case ID_DISCONNECTION_NOTIFICATION:
-				CChat::AddDebugMessage(xorstr("Переподключение через 15 секунд..."));
+				CHAT_INFO(xorstr("Переподключение через 15 секунд..."));
 				pRakClient->Disconnect(2000, 0);
 				BrNotification(TYPE_TEXT_GREEN, "Lost Connect t.me/kuzia15", 5);
 				// Packet_DisconnectionNotification(pkt);
 				break;
 			case ID_AIM_SYNC:
-				Packet_AimSync(pkt);
+				Packet_AimSync(pkt, drain);
 				break;
 				
 			case ID_PLAYER_SYNC:
-				Packet_PlayerSync(pkt);
+			case ID_PLAYER_SYNC_DELTA:
+				Packet_PlayerSync(pkt, drain);
 				break;
 
 			case ID_VEHICLE_SYNC:
-				Packet_VehicleSync(pkt);
+			case ID_VEHICLE_SYNC_DELTA:
+				Packet_VehicleSync(pkt, drain);
+				break;
+
+			case ID_SYNC_BASELINE_ACK:
+				CDeltaSync::OnAck(pkt->data, pkt->length);
 				break;
 
 			case ID_PASSENGER_SYNC:
-				Packet_PassengerSync(pkt);
+				Packet_PassengerSync(pkt, drain);
 				break;
 			
 			case ID_BULLET_SYNC:
-				Packet_BulletSync(pkt);
+				Packet_BulletSync(pkt, drain);
 				break;
 			//case ID_TURNLIGHTS:
 				//Packet_Turnlights(pkt);
@@ -102,46 +248,257 @@ void CNetGame::ProcessNetwork()
 
 		pRakClient->DeallocatePacket(pkt);
 	}
+	// other Receive callers run everything
+	pRakClient->SetRPCDeadline(0);
+	TakeDecodedSync(drain);
+	FlushPendingSync(drain);
+	CDeltaSync::SendAcks();
+	CSyncRate::Update();
+	CVehiclePool::Process();
+	if(packets) {
+		CTraceRing::Trace(TRACE_NET_DRAIN, packets, (uint32_t)(RakNet::GetTimeNS() - drainStart));
+	}
 }
 
-int CNetGame::GetGameState()
+// On-foot and in-car rotations stay packed until the drain is over, then the whole
+// frame's worth is rebuilt in one batch and written back into the pending structs.
+static void DecodePendingQuats()
 {
-	return *(int *)(CGameAPI::GetBase(xorstr("CNetGame::m_iGameState")));
+	static uint16_t qx[MAX_PLAYERS], qy[MAX_PLAYERS], qz[MAX_PLAYERS];
+	static uint8_t signs[MAX_PLAYERS];
+	static float w[MAX_PLAYERS], x[MAX_PLAYERS], y[MAX_PLAYERS], z[MAX_PLAYERS];
+	static void* target[MAX_PLAYERS];
+
+	uint32_t count = 0;
+	for(uint16_t i = 0; i < g_pendingCount; i++) {
+		uint16_t playerId = g_pendingIds[i];
+		void* quat;
+		if(!g_pendingPacked[playerId]) {
+			continue;
+		} else if(g_pendingKind[playerId] == PENDING_ON_FOOT) {
+			quat = &g_pendingOnFoot[playerId].quatw;
+		} else if(g_pendingKind[playerId] == PENDING_IN_CAR) {
+			quat = &g_pendingInCar[playerId].quatw;
+		} else {
+			continue;
+		}
+		const stPackedNormQuat& packed = g_pendingQuat[playerId];
+		qx[count] = packed.x;
+		qy[count] = packed.y;
+		qz[count] = packed.z;
+		signs[count] = packed.signs;
+		target[count++] = quat;
+	}
+
+	DecodeNormQuats(qx, qy, qz, signs, count, w, x, y, z);
+	// quatw..quatz are consecutive, and the structs are packed
+	for(uint32_t i = 0; i < count; i++) {
+		const float quat[4] = { w[i], x[i], y[i], z[i] };
+		memcpy(target[i], quat, sizeof(quat));
+	}
 }
 
-void CNetGame::SetGameState(int state)
+// the end of NETSTAT_IN_WIRE, playout delay included when CSyncJitter held the sync back
+static void StoreSync(CRemotePlayer* remote_player, ePendingSync kind, void* data, uint32_t time, uint64_t receivedNs)
 {
-	*(int *)(CGameAPI::GetBase(xorstr("CNetGame::m_iGameState"))) = state;
+	uint8_t packetId;
+	uint32_t size;
+	switch(kind)
+	{
+		case PENDING_ON_FOOT:
+			remote_player->StoreSyncData((BROnFootSyncData*)data, time);
+			packetId = ID_PLAYER_SYNC;
+			size = sizeof(BROnFootSyncData);
+			break;
+		case PENDING_IN_CAR:
+			remote_player->StoreInCarSyncData((BRInCarSyncData*)data, time);
+			packetId = ID_VEHICLE_SYNC;
+			size = sizeof(BRInCarSyncData);
+			break;
+		case PENDING_PASSENGER:
+			remote_player->StorePassengerSyncData((uint8_t*)data, time);
+			packetId = ID_PASSENGER_SYNC;
+			size = BR_PASSENGER_SYNC_SIZE;
+			break;
+		default:
+			return;
+	}
+	if(receivedNs) {
+		CNetStats::Record(NETSTAT_IN_WIRE, packetId, size, CNetStats::Now() - receivedNs);
+	}
+}
+
+static void* GetPendingData(uint16_t playerId, ePendingSync kind, uint32_t* size)
+{
+	switch(kind)
+	{
+		case PENDING_ON_FOOT:
+			*size = sizeof(BROnFootSyncData);
+			return &g_pendingOnFoot[playerId];
+		case PENDING_IN_CAR:
+			*size = sizeof(BRInCarSyncData);
+			return &g_pendingInCar[playerId];
+		default:
+			*size = BR_PASSENGER_SYNC_SIZE;
+			return g_pendingPassenger[playerId];
+	}
+}
+
+// A second sync for the same player within one drain: with CSyncJitter on, the one about to
+// be overwritten still gets its turn, that burst is exactly what the buffer smooths out
+static void SpillPending(uint16_t playerId)
+{
+	ePendingSync kind = g_pendingKind[playerId];
+	if(kind == PENDING_NONE || !CSyncJitter::IsEnabled()) {
+		return;
+	}
+	if(kind != PENDING_PASSENGER && g_pendingPacked[playerId]) {
+		const stPackedNormQuat& packed = g_pendingQuat[playerId];
+		float quat[4];
+		DecodeNormQuats(&packed.x, &packed.y, &packed.z, &packed.signs, 1, &quat[0], &quat[1], &quat[2], &quat[3]);
+		memcpy(kind == PENDING_ON_FOOT ? (void*)&g_pendingOnFoot[playerId].quatw : (void*)&g_pendingInCar[playerId].quatw, quat, sizeof(quat));
+	}
+	uint32_t size;
+	void* data = GetPendingData(playerId, kind, &size);
+	CSyncJitter::Push(playerId, kind, data, size, g_pendingTime[playerId], RakNet::GetTime(), g_pendingReceived[playerId]);
+}
+
+void CNetGame::FlushPendingSync(const stNetDrain& drain)
+{
+	DecodePendingQuats();
+	bool buffered = CSyncJitter::IsEnabled();
+	uint32_t now = RakNet::GetTime();
+	for(uint16_t i = 0; i < g_pendingCount; i++) {
+		uint16_t playerId = g_pendingIds[i];
+		ePendingSync kind = g_pendingKind[playerId];
+		g_pendingKind[playerId] = PENDING_NONE;
+		// forgotten, or already handed over under a second entry ForgetSync left behind
+		if(kind == PENDING_NONE) {
+			continue;
+		}
+		// looked up now: a ServerQuit in the same drain may have removed the player
+		CRemotePlayer* remote_player = GetSyncTarget(drain, playerId);
+		if(!remote_player) {
+			continue;
+		}
+		// the grid and the state mirror go by the newest sync, the buffer only delays what the game shows
+		if(kind == PENDING_ON_FOOT) {
+			const BROnFootSyncData& sync = g_pendingOnFoot[playerId];
+			CPlayerGrid::Update(playerId, sync.vecPos);
+			CPlayerState::Update(playerId, sync.vecPos, (uint8_t)sync.health, (uint8_t)sync.armour, CPlayerState::NO_VEHICLE, now);
+		} else if(kind == PENDING_IN_CAR) {
+			const BRInCarSyncData& sync = g_pendingInCar[playerId];
+			CPlayerGrid::Update(playerId, sync.vecPos);
+			CPlayerState::Update(playerId, sync.vecPos, (uint8_t)sync.playerHealth, (uint8_t)sync.playerArmour, sync.VehicleID, now);
+		}
+		uint32_t size;
+		void* data = GetPendingData(playerId, kind, &size);
+		if(buffered) {
+			CSyncJitter::Push(playerId, kind, data, size, g_pendingTime[playerId], now, g_pendingReceived[playerId]);
+		} else {
+			StoreSync(remote_player, kind, data, g_pendingTime[playerId], g_pendingReceived[playerId]);
+		}
+	}
+	g_pendingCount = 0;
+
+	if(buffered) {
+		static stBufferedSync* due[MAX_PLAYERS];
+		uint16_t count = CSyncJitter::Release(now, due);
+		for(uint16_t i = 0; i < count; i++) {
+			// the player may have left, or the id been taken, while the sync waited
+			CRemotePlayer* remote_player = GetSyncTarget(drain, due[i]->playerId);
+			if(remote_player) {
+				StoreSync(remote_player, due[i]->kind, due[i]->data, due[i]->time, due[i]->receivedNs);
+			}
+		}
+	}
 }
 
-void gen_auth_key(char buf[260], char* auth_in);
-void CNetGame::Packet_AuthKey(Packet* pkt)
+void CNetGame::DropPendingSync()
 {
-	RakNet::BitStream bsAuth((unsigned char *)pkt->data, pkt->length, false);
+	for(uint16_t i = 0; i < g_pendingCount; i++) {
+		g_pendingKind[g_pendingIds[i]] = PENDING_NONE;
+	}
+	g_pendingCount = 0;
+}
 
-	uint8_t byteAuthLen;
-	char szAuth[260];
+void CNetGame::ForgetSync(uint16_t playerId)
+{
+	if(playerId >= MAX_PLAYERS) {
+		return;
+	}
+	// left in g_pendingIds, FlushPendingSync skips an entry with no kind
+	g_pendingKind[playerId] = PENDING_NONE;
+	g_pendingPacked[playerId] = false;
+	CSyncQueue::Forget(playerId);
+}
 
-	bsAuth.IgnoreBits(8);
-	bsAuth.Read(byteAuthLen);
-	bsAuth.Read(szAuth, byteAuthLen);
-	szAuth[byteAuthLen] = '\0';
+int CNetGame::GetGameState()
+{
+	return *g_Game.m_iGameState;
+}
 
-	char szAuthKey[260];
-	gen_auth_key(szAuthKey, szAuth);
+void CNetGame::SetGameState(int state)
+{
+	*g_Game.m_iGameState = state;
+}
 
-	RakNet::BitStream bsKey;
-	uint8_t byteAuthKeyLen = (uint8_t)strlen(szAuthKey);
+bool CNetGame::SendDialogResponse(int32_t button, int32_t listItem, const char* input, uint8_t inputLen)
+{
+	stDialogResponseHeader header;
+	header.dialogId = m_nLastSAMPDialogID;
+	header.button = button;
+	header.listItem = listItem;
+	header.inputLen = inputLen;
+	// written straight into the block the reliability layer keeps, at its exact length
+	uint32_t bytes = DialogResponseSchema::BYTES + inputLen;
+	RakNet::OutboundMessage bsSend;
+	if(!pRakClient->BeginRPC(&bsSend, RPC_DialogResponse, BYTES_TO_BITS(bytes), bytes, false)) {
+		return false;
+	}
+	DialogResponseSchema::Write(&bsSend, header);
+	bsSend.Write(input, inputLen);
+	return pRakClient->Send(&bsSend, CSendClass::GetPriority(SEND_CLASS_UI), RELIABLE_ORDERED, CSendClass::GetOrderingChannel(SEND_CLASS_UI));
+}
 
-	bsKey.Write((uint8_t)ID_AUTH_KEY);
-	bsKey.Write((uint8_t)byteAuthKeyLen);
-	bsKey.Write(szAuthKey, byteAuthKeyLen);
-	pRakClient->Send(&bsKey, SYSTEM_PRIORITY, RELIABLE, 0);
+void CNetGame::Packet_AuthKey(Packet* pkt, RakClientInterface* client)
+{
+	RakNet::OutboundMessage bsKey;
+	if(client->BeginSend(&bsKey, CJoinHandshake::AUTH_KEY_BYTES) && CJoinHandshake::WriteAuthKey(pkt->data, pkt->length, &bsKey)) {
+		client->Send(&bsKey, SYSTEM_PRIORITY, RELIABLE, 0);
+	}
 }
 
 void CNetGame::Packet_ConnectionLost(Packet* pkt)
 {
-	reinterpret_cast<void(*)()>(CGameAPI::GetBase(xorstr("CNetGame::Packet_ConnectionLost")))();
+	CTelemetry::Count(TELEMETRY_CONNECTION_LOST);
+	CSyncQueue::Drop();
+	DropPendingSync();
+	CSyncJitter::Clear();
+	CWorldSnapshot::OnConnectionLost();
+	CCapabilities::Reset();
+	CSyncRate::Reset();
+	CDeltaSync::Reset();
+	CPlayerGrid::Clear();
+	CPlayerState::Clear();
+	CPlayerPool::ClearActive();
+	CPlayerNames::Clear();
+	CVehicleSpawnQueue::Clear();
+	CVehiclePool::Reset();
+	CObjectQueue::Clear();
+	CPlayerStreamQueue::Clear();
+	CChatBuffer::Clear();
+	CTextDrawBuffer::Clear();
+	CLogoCache::Reset();
+	CJoinHandshake::Reset();
+	g_Game.Packet_ConnectionLost();
+}
+
+void CNetGame::RestartJoin()
+{
+	// torn down like a lost connection, so the game reconnects through the usual path
+	pRakClient->Disconnect(0, 0);
+	Packet_ConnectionLost(nullptr);
 }
 
 void CNetGame::Packet_ConnectionSucceeded(Packet* pkt)
@@ -157,286 +514,181 @@ void CNetGame::Packet_ConnectionSucceeded(Packet* pkt)
 	bsSuccAuth.Read(uiChallenge);
 
 	GetPlayerPool()->GetLocalPlayer()->SetLocalPlayerID(MyPlayerID);
+	CReconnect::OnConnected(pkt->playerId);
 
-	int iVersion = NETGAME_VERSION;
-	char byteMod = 0x01;
-	unsigned int uiClientChallengeResponse = uiChallenge ^ iVersion;
+	const CConfig::stSettings& config = CConfig::Get();
+	if(config.timeoutMs) {
+		pRakClient->SetTimeoutTime(config.timeoutMs);
+	}
 
-	const char* sampVersion = xorstr("0.3.7");
-	const char* auth_bs = xorstr("15121F6F18550C00AC4B4F8A167D0379BB0ACA99043");
-	
 	const char* localPlayerName = (const char *)(GetPlayerPool()->GetLocalPlayer()->GetLocalPlayerName());
-	
-	char byteAuthBSLen = (char)strlen(auth_bs);
-	char byteNameLen = (char)strlen(localPlayerName);
-	char byteClientverLen = (char)strlen(sampVersion);
-
-	RakNet::BitStream bsSend;
-	bsSend.Write(iVersion);
-	bsSend.Write(byteMod);
-	bsSend.Write(byteNameLen);
-	bsSend.Write(localPlayerName, byteNameLen);
-	bsSend.Write(uiClientChallengeResponse);
-	bsSend.Write(byteAuthBSLen);
-	bsSend.Write(auth_bs, byteAuthBSLen);
-	bsSend.Write(byteClientverLen);
-	bsSend.Write(sampVersion, byteClientverLen);
-	pRakClient->RPC(&RPC_ClientJoin, &bsSend, HIGH_PRIORITY, RELIABLE, 0, false, UNASSIGNED_NETWORK_ID, NULL);
+	RakNet::OutboundMessage bsSend;
+	if(pRakClient->BeginRPC(&bsSend, RPC_ClientJoin, BYTES_TO_BITS(CJoinHandshake::CLIENT_JOIN_BYTES), CJoinHandshake::CLIENT_JOIN_BYTES, false)) {
+		CJoinHandshake::WriteClientJoin(uiChallenge, localPlayerName, &bsSend);
+		// ordered, so a resume request sent next can't overtake the join
+		pRakClient->Send(&bsSend, CSendClass::GetPriority(SEND_CLASS_CONTROL), RELIABLE_ORDERED, CSendClass::GetOrderingChannel(SEND_CLASS_CONTROL));
+	}
+	CWorldSnapshot::RequestResume();
+	CCapabilities::Offer();
+	CDeltaSync::Reset();
+	CJoinHandshake::OnAccepted();
 	
 	SetGameState(GAMESTATE_AWAIT_JOIN);
 }
 
-void CNetGame::Packet_AimSync(Packet* pkt)
+CRemotePlayer* CNetGame::GetSyncTarget(const stNetDrain& drain, uint16_t playerId)
 {
-	RakNet::BitStream bsData(pkt->data, pkt->length, false);
-	
-	if(GetGameState() != GAMESTATE_CONNECTED) { return; }
-	
-	uint8_t pktId;
-	uint16_t playerId;
-	uint8_t aimSyncBuffer[31] = {0};
-	
-	bsData.ReadBits((unsigned char *)&pktId, 8);
-	bsData.ReadBits((unsigned char *)&playerId, 16);
-	bsData.ReadBits((unsigned char *)&aimSyncBuffer, 31 * 8);
-	
-	CRemotePlayer* remote_player = GetPlayerPool()->GetAt(playerId);
-	if(remote_player) {
-		remote_player->StoreAimSyncData(aimSyncBuffer, 0);
+	if(playerId >= MAX_PLAYERS || !drain.playerPool) {
+		return nullptr;
 	}
+	return drain.playerPool->m_pPlayers[playerId];
 }
 
-void CNetGame::Packet_PlayerSync(Packet* pkt)
+void CNetGame::Packet_AimSync(Packet* pkt, stNetDrain& drain)
 {
-	RakNet::BitStream bsData(pkt->data, pkt->length, false);
+	if(!drain.IsConnected()) { return; }
 	
-	if(GetGameState() != GAMESTATE_CONNECTED) { return; }
-	
-	bool accepted_sync = false;
-	
-	uint8_t pktId;
 	uint16_t playerId;
-	uint32_t timestamp;
-	
-	int16_t lrAnalog, udAnalog;
-	uint16_t wKeys;
-	CVector vecPos;
-	float tw, tx, ty, tz;
-	uint8_t byteHealthArmour, byteHealth, byteArmour;
-	CVector vecMoveSpeed;
-	float mx, my, mz;
-	uint16_t wSurfInfo;
-	CVector vecSurfOffsets;
-	uint8_t byteCurrentWeapon, byteSpecialAction;
-	
-	if(pkt->data[0] == ID_TIMESTAMP) {
-	    bsData.ReadBits((unsigned char *)&pktId, 8);
-    	bsData.ReadBits((unsigned char *)&timestamp, 32);
+	uint8_t* aimSync = GetOpaqueSync(pkt, AIM_SYNC_SIZE, &playerId);
+	if(!aimSync) {
+		return;
 	}
-	bsData.ReadBits((unsigned char *)&pktId, 8);
-	bsData.ReadBits((unsigned char *)&playerId, 16);
 	
-	int readOffset = bsData.readOffset;
-	int numberOfBitsUsed = bsData.numberOfBitsUsed;
-	if(readOffset >= numberOfBitsUsed) {
-	    return;
-	}
-	int v6 = bsData.data[readOffset >> 3];
-	char v7 = readOffset & 7;
-	int v8 = readOffset + 1;
-	bsData.readOffset = v8;
-	if( ((v6 << v7) & 0x80) != 0 )
-	{
-	    if(!bsData.ReadBits((unsigned char *)&lrAnalog, 16)) 
-	    {
-	        return;
-	    }
-	    v8 = bsData.readOffset;
-	    numberOfBitsUsed = bsData.numberOfBitsUsed;
-	}
-	if(v8 < numberOfBitsUsed)
-	{
-	    int v9 = bsData.data[v8 >> 3];
-	    bsData.readOffset = v8 + 1;
-	    if( (((v9 << (v8 & 7)) & 0x80) == 0 ||
-	            bsData.ReadBits((unsigned char *)&udAnalog, 16))
-		    && bsData.ReadBits((unsigned char *)&wKeys, 16)
-			&& bsData.Read((char *)&vecPos, 12)
-			&& bsData.ReadNormQuat<float>(tw, tx, ty, tz)
-			&& bsData.ReadBits((unsigned char *)&byteHealthArmour, 8)
-			&& bsData.ReadBits((unsigned char *)&byteCurrentWeapon, 8)
-			&& bsData.ReadBits((unsigned char *)&byteSpecialAction, 8)
-			&& bsData.ReadVector<float>(mx, my, mz))
-		{
-			readOffset = bsData.readOffset;
-			if(readOffset >= bsData.numberOfBitsUsed) {
-				return;
-			}
-			int v7_ = bsData.data[readOffset >> 3];
-			bsData.readOffset = readOffset + 1;
-			if(((v7_ << (readOffset & 7)) & 0x80) != 0)
-			{
-				if(bsData.ReadBits((unsigned char *)&wSurfInfo, 16)
-					&& bsData.ReadBits((unsigned char *)&vecSurfOffsets.x, 32)
-					&& bsData.ReadBits((unsigned char *)&vecSurfOffsets.y, 32)
-					&& bsData.ReadBits((unsigned char *)&vecSurfOffsets.z, 32))
-				{
-					
-				}
-			}
-			accepted_sync = true;
-		}
+	CRemotePlayer* remote_player = GetSyncTarget(drain, playerId);
+	if(remote_player && CSyncInterest::WantsDetail(playerId)) {
+		remote_player->StoreAimSyncData(aimSync, GetPacketTime(pkt));
 	}
+}
+
+void CNetGame::Packet_PlayerSync(Packet* pkt, stNetDrain& drain)
+{
+	if(!drain.IsConnected()) { return; }
 	
-	uint8_t byteArmTemp = 0, byteHlTemp = 0;
-	byteArmTemp = (byteHealthArmour & 0x0F);
-	byteHlTemp = (byteHealthArmour >> 4);
-	
-	if(byteArmTemp == 0xF) {
-		byteArmour = 100;
-	} else if(byteArmTemp == 0) {
-		byteArmour = 0;
-	} else {
-		byteArmour = byteArmTemp * 7;
+	uint16_t playerId;
+	CVector pos;
+	BROnFootSyncData ofSync;
+	stPackedNormQuat quat;
+	const uint8_t* data = pkt->data;
+	uint32_t length = pkt->length;
+	if(GetPacketID(pkt) == ID_PLAYER_SYNC_DELTA && !(data = CDeltaSync::Expand(data, &length))) {
+		return;
 	}
-	
-	if(byteHlTemp == 0xF) {
-		byteHealth = 100;
-	} else if(byteHlTemp == 0) {
-		byteHealth = 0;
-	} else {
-		byteHealth = byteHlTemp * 7;
+	if(!PeekBROnFootPosition(data, length, &playerId, &pos) || !GetSyncTarget(drain, playerId)
+		|| !CSyncInterest::WantsSync(playerId, pos)) {
+		return;
 	}
-	
-	BROnFootSyncData ofSync = {0};
-	ofSync.lrAnalogLeftStick = lrAnalog;
-	ofSync.udAnalogLeftStick = udAnalog;
-	ofSync.wKeys = wKeys;
-	ofSync.vecPos = vecPos;
-	ofSync.quatw = tw;
-	ofSync.quatx = tx;
-	ofSync.quaty = ty;
-	ofSync.quatz = tz;
-	ofSync.health = byteHealth;
-	ofSync.armour = byteArmour;
-	ofSync.byteCurrentWeapon = byteCurrentWeapon;
-	ofSync.byteSpecialAction = byteSpecialAction;
-	ofSync.vecMoveSpeed = vecMoveSpeed;
-	ofSync.vecSurfOffsets = vecSurfOffsets;
-	ofSync.wSurfInfo = wSurfInfo;
-	
-	CRemotePlayer* remote_player = GetPlayerPool()->GetAt(playerId);
-	if(remote_player && accepted_sync) {
-		remote_player->StoreSyncData(&ofSync, 0);
+	if(!DecodeBROnFootSync(data, length, &playerId, &ofSync, &quat)) {
+		return;
 	}
+	
+	SpillPending(playerId);
+	g_pendingOnFoot[playerId] = ofSync;
+	g_pendingQuat[playerId] = quat;
+	g_pendingPacked[playerId] = true;
+	MarkPending(playerId, PENDING_ON_FOOT, GetPacketTime(pkt), pkt->receivedNs);
 }
 
-void CNetGame::Packet_VehicleSync(Packet* pkt)
+void CNetGame::Packet_VehicleSync(Packet* pkt, stNetDrain& drain)
 {
-	RakNet::BitStream bsData(pkt->data, pkt->length, false);
+	if(!drain.IsConnected()) { return; }
 	
-	if(GetGameState() != GAMESTATE_CONNECTED) { return; }
-	
-	uint8_t pktId;
 	uint16_t playerId;
-	
-	BRInCarSyncData icsync = {0};
-	
-	bsData.ReadBits((unsigned char *)&pktId, 8);
-	bsData.ReadBits((unsigned char *)&playerId, 16);
-	
-	bsData.ReadBits((unsigned char *)&icsync.VehicleID, 16);
-	bsData.ReadBits((unsigned char *)&icsync.lrAnalogLeftStick, 16);
-	bsData.ReadBits((unsigned char *)&icsync.udAnalogLeftStick, 16);
-	bsData.ReadBits((unsigned char *)&icsync.wKeys, 16);
-	bsData.ReadNormQuat<float>(icsync.quatw, icsync.quatx, icsync.quaty, icsync.quatz);
-	bsData.ReadBits((unsigned char *)&icsync.vecPos, 96);
-	bsData.ReadVector<float>(icsync.vecMoveSpeed.x, icsync.vecMoveSpeed.y, icsync.vecMoveSpeed.z);
-	uint16_t wTempCarHealth;
-	bsData.ReadBits((unsigned char *)&wTempCarHealth, 16);
-	icsync.fCarHealth = wTempCarHealth;
-	
-	uint8_t byteHealthArmour;
-	uint8_t byteArmTemp = 0, byteHlTemp = 0;
-
-	bsData.Read(byteHealthArmour);
-	byteArmTemp = (byteHealthArmour & 0x0F);
-	byteHlTemp = (byteHealthArmour >> 4);
-
-	if(byteArmTemp == 0xF) {
-		icsync.playerArmour = 100;
-	} else if(byteArmTemp == 0) {
-		icsync.playerArmour = 0;
-	} else {
-		icsync.playerArmour = byteArmTemp * 7;
+	CVector pos;
+	BRInCarSyncData icsync;
+	stPackedNormQuat quat;
+	const uint8_t* data = pkt->data;
+	uint32_t length = pkt->length;
+	if(GetPacketID(pkt) == ID_VEHICLE_SYNC_DELTA && !(data = CDeltaSync::Expand(data, &length))) {
+		return;
 	}
-	
-	if(byteHlTemp == 0xF) {
-		icsync.playerHealth = 100;
-	} else if(byteHlTemp == 0) {
-		icsync.playerHealth = 0;
-	} else {
-		icsync.playerHealth = byteHlTemp * 7;
+	if(!PeekBRInCarPosition(data, length, &playerId, &pos) || !GetSyncTarget(drain, playerId)
+		|| !CSyncInterest::WantsSync(playerId, pos)) {
+		return;
 	}
-	
-	uint8_t byteTempWeapon;
-	bsData.Read(byteTempWeapon);
-	icsync.byteCurrentWeapon ^= (byteTempWeapon ^ icsync.byteCurrentWeapon) & 0x3F;
-	
-	bool bCheck;
-	bsData.ReadCompressed(bCheck);
-	if(bCheck) { icsync.byteSirenOn = 1; }
-	bsData.ReadCompressed(bCheck);
-	if(bCheck) { icsync.byteLandingGearState = 1; }
-	bsData.ReadCompressed(bCheck);
-	if(bCheck) { bsData.Read(icsync.TrailerID);  }
-	
-	CRemotePlayer* remote_player = GetPlayerPool()->GetAt(playerId);
-	if(remote_player) {
-		remote_player->StoreInCarSyncData(&icsync, 0);
+	if(!DecodeBRInCarSync(data, length, &playerId, &icsync, &quat)) {
+		return;
 	}
+	
+	SpillPending(playerId);
+	g_pendingInCar[playerId] = icsync;
+	g_pendingQuat[playerId] = quat;
+	g_pendingPacked[playerId] = true;
+	MarkPending(playerId, PENDING_IN_CAR, GetPacketTime(pkt), pkt->receivedNs);
 }
 
-void CNetGame::Packet_PassengerSync(Packet* pkt)
+void CNetGame::Packet_PassengerSync(Packet* pkt, stNetDrain& drain)
 {
-	RakNet::BitStream bsData(pkt->data, pkt->length, false);
+	if(!drain.IsConnected()) { return; }
 	
-	if(GetGameState() != GAMESTATE_CONNECTED) { return; }
-	
-	uint8_t pktId;
 	uint16_t playerId;
-	uint8_t passengerSync[26] = {0};
-	
-	bsData.ReadBits((unsigned char *)&pktId, 8);
-	bsData.ReadBits((unsigned char *)&playerId, 16);
-	bsData.ReadBits((unsigned char *)&passengerSync, 26 * 8);
+	uint8_t passengerSync[BR_PASSENGER_SYNC_SIZE];
+	if(!DecodeBRPassengerSync(pkt->data, pkt->length, &playerId, passengerSync) || !GetSyncTarget(drain, playerId)) {
+		return;
+	}
 	
-	CRemotePlayer* remote_player = GetPlayerPool()->GetAt(playerId);
-	if(remote_player) {
-		remote_player->StorePassengerSyncData(passengerSync, 0);
+	SpillPending(playerId);
+	memcpy(g_pendingPassenger[playerId], passengerSync, BR_PASSENGER_SYNC_SIZE);
+	MarkPending(playerId, PENDING_PASSENGER, GetPacketTime(pkt), pkt->receivedNs);
+}
+
+void CNetGame::TakeDecodedSync(stNetDrain& drain)
+{
+	stDecodedSync sync;
+	while(CSyncQueue::Take(&sync)) {
+		uint16_t playerId = sync.playerId;
+		if(!drain.IsConnected() || !GetSyncTarget(drain, playerId)) {
+			continue;
+		}
+		switch(sync.kind)
+		{
+			case PENDING_ON_FOOT: {
+				const BROnFootSyncData& ofSync = *(const BROnFootSyncData*)sync.data;
+				if(!CSyncInterest::WantsSync(playerId, ofSync.vecPos)) {
+					continue;
+				}
+				SpillPending(playerId);
+				g_pendingOnFoot[playerId] = ofSync;
+				break;
+			}
+			case PENDING_IN_CAR: {
+				const BRInCarSyncData& icsync = *(const BRInCarSyncData*)sync.data;
+				if(!CSyncInterest::WantsSync(playerId, icsync.vecPos)) {
+					continue;
+				}
+				SpillPending(playerId);
+				g_pendingInCar[playerId] = icsync;
+				break;
+			}
+			default:
+				SpillPending(playerId);
+				memcpy(g_pendingPassenger[playerId], sync.data, BR_PASSENGER_SYNC_SIZE);
+				break;
+		}
+		g_pendingPacked[playerId] = false;
+		MarkPending(playerId, sync.kind, sync.time, sync.receivedNs);
 	}
 }
 
-void CNetGame::Packet_BulletSync(Packet* pkt)
+void CNetGame::Packet_BulletSync(Packet* pkt, stNetDrain& drain)
 {
-	RakNet::BitStream bsData(pkt->data, pkt->length, false);
+	if(!drain.IsConnected()) { return; }
 	
-	if(GetGameState() != GAMESTATE_CONNECTED) { return; }
-	
-	uint8_t pktId;
 	uint16_t playerId;
-	uint8_t bulletSync[40] = {0};
-	
-	bsData.ReadBits((unsigned char *)&pktId, 8);
-	bsData.ReadBits((unsigned char *)&playerId, 16);
-	bsData.ReadBits((unsigned char *)&bulletSync, 40 * 8);
+	uint8_t* bulletSync = GetOpaqueSync(pkt, BULLET_SYNC_SIZE, &playerId);
+	if(!bulletSync) {
+		return;
+	}
 	
-	CRemotePlayer* remote_player = GetPlayerPool()->GetAt(playerId);
-	if(remote_player) {
-		CLocalPlayer* local_player = GetPlayerPool()->GetLocalPlayer();
-		if(local_player->GetLocalPlayerID() != playerId) {
-			remote_player->StoreBulletSyncData(bulletSync, 0);
-		}
+	CRemotePlayer* remote_player = GetSyncTarget(drain, playerId);
+	if(!remote_player || drain.localPlayerId == playerId) {
+		return;
+	}
+	uint16_t hitId;
+	memcpy(&hitId, bulletSync + 1, sizeof(hitId));
+	// a far shooter still has to be seen hitting us
+	bool hitUs = bulletSync[0] == BULLET_HIT_TYPE_PLAYER && hitId == drain.localPlayerId;
+	if(hitUs || CSyncInterest::WantsDetail(playerId)) {
+		remote_player->StoreBulletSyncData(bulletSync, GetPacketTime(pkt));
 	}
 }
 
@@ -452,15 +704,12 @@ void CNetGame::Packet_BulletSync(Packet* pkt)
     bs.ReadBits((unsigned char*)&vehicleId, 16);
     bs.ReadBits((unsigned char*)&lightsState, 8);
     
-    int vehPool = *(int*)(CGameAPI::GetBase(xorstr("CNetGame::m_pVehiclePool")));
-    if (!vehPool) return;
-    
-    int pVehicle = *(int*)(vehPool + 4 * vehicleId);
+    uintptr_t pVehicle = CVehiclePool::GetAt(vehicleId);
     if (!pVehicle) return;
     
     *(uint8_t*)(pVehicle + 0x1C0) = lightsState;
     
-    int localPlayerVeh = *(int*)(CGameAPI::GetBase(xorstr("FindPlayerVehicle")));
+    uintptr_t localPlayerVeh = *(uintptr_t*)(CGameAPI::GetBase(OFFSET("FindPlayerVehicle")));
     if (localPlayerVeh == pVehicle && lightsState)
     {
         uint16_t soundId = (lightsState == 3) ? 0x14 : 0x13;
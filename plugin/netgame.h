@@ -18,6 +18,23 @@
 #define GAMESTATE_NONE 			0
 #define GAMESTATE_DISCONNECTED	4
 
+uint8_t GetPacketID(Packet* p);
+// when the server sampled what the packet carries, for CRemotePlayer; from any thread
+uint32_t GetPacketTime(Packet* p);
+
+// What the sync handlers read off the game, taken once per ProcessNetwork drain rather than
+// per packet. Connection packets change it mid-drain and ProcessNetwork takes it again after
+// them; RPCs run inside Receive, so a drain that isn't connected yet rechecks the state.
+struct stNetDrain
+{
+	int gameState;
+	CPlayerPool* playerPool;
+	uint16_t localPlayerId;		// UNASSIGNED_PLAYER_INDEX without a local player
+
+	void Capture();
+	bool IsConnected();
+};
+
 class CNetGame
 {
 public:
@@ -29,15 +46,36 @@ public:
 	static void SetGameState(int state);
 	static int GetGameState();
 	
-	static void Packet_AuthKey(Packet* pkt);
+	// RPC_DialogResponse for the dialog last shown, input bytes go out as given
+	static bool SendDialogResponse(int32_t button, int32_t listItem, const char* input, uint8_t inputLen);
+
+	// answered on the client it came in on, pRakClient or a CStandby one
+	static void Packet_AuthKey(Packet* pkt, RakClientInterface* client);
 	static void Packet_ConnectionLost(Packet* pkt);
 	static void Packet_ConnectionSucceeded(Packet* pkt);
+	// the server never answered the join, see CJoinHandshake::Process, or CStandby moves us on
+	static void RestartJoin();
 	
-	static void Packet_AimSync(Packet* pkt);
-	static void Packet_PlayerSync(Packet* pkt);
-	static void Packet_VehicleSync(Packet* pkt);
-	static void Packet_PassengerSync(Packet* pkt);
-	static void Packet_BulletSync(Packet* pkt);
+	// Shared prologue of the Packet_*Sync handlers: the remote player a sync for
+	// playerId should go to, or nullptr when the id is out of range or unused.
+	static CRemotePlayer* GetSyncTarget(const stNetDrain& drain, uint16_t playerId);
+
+	static void Packet_AimSync(Packet* pkt, stNetDrain& drain);
+	static void Packet_PlayerSync(Packet* pkt, stNetDrain& drain);
+	static void Packet_VehicleSync(Packet* pkt, stNetDrain& drain);
+	static void Packet_PassengerSync(Packet* pkt, stNetDrain& drain);
+	static void Packet_BulletSync(Packet* pkt, stNetDrain& drain);
+	// what CSyncQueue decoded since the last drain, into the same pending slots
+	static void TakeDecodedSync(stNetDrain& drain);
+
+	// Player, vehicle and passenger syncs drained in one ProcessNetwork only keep the
+	// newest per player; this hands each survivor to CRemotePlayer once, through
+	// CSyncJitter when it is on, along with whatever else has become due there.
+	static void FlushPendingSync(const stNetDrain& drain);
+	static void DropPendingSync();
+	// a player id quit or joined mid-drain: whatever sync is still waiting for it belongs to
+	// the previous player, here or in CSyncQueue
+	static void ForgetSync(uint16_t playerId);
 
 	//static void Packet_Turnlights(Packet* pkt);
 	
@@ -5,10 +5,10 @@
 
 void DialogBoxRPC(RPCParameters* rpcParams)
 {
-	reinterpret_cast<void(*)(RPCParameters*)>(CGameAPI::GetBase(xorstr("RPC::DialogBox")))(rpcParams);
+	reinterpret_cast<void(*)(RPCParameters*)>(CGameAPI::GetBase(OFFSET("RPC::DialogBox")))(rpcParams);
 }
 
 void RegisterRPCs(RakClientInterface* pInterface)
 {
-	// pInterface->RegisterAsRemoteProcedureCall(&RPC_ScrDialogBox, DialogBoxRPC);
+	// pInterface->RegisterAsRemoteProcedureCall(RPC_ScrDialogBox, DialogBoxRPC);
 }
@@ -0,0 +1,376 @@
+#include "netstats.h"
+#include "debounce.h"
+#include "joinhandshake.h"
+#include "syncinterest.h"
+#include "syncjitter.h"
+#include "syncqueue.h"
+#include "syncrate.h"
+#include "thermal.h"
+#include "xorstr.h"
+
+#include <algorithm>
+#include <android/log.h>
+#include <cfloat>
+#include <cstdio>
+
+#include "vendor/imgui/imgui.h"
+#include "vendor/RakNet/LinkEmulator.h"
+#include "vendor/RakNet/RakClientInterface.h"
+#include "vendor/RakNet/RakNetStatistics.h"
+
+extern RakClientInterface* pRakClient;
+
+CNetStats::stEntry CNetStats::m_entries[NETSTAT_KIND_COUNT][256];
+uint64_t CNetStats::m_nextDump = 0;
+#ifdef NETSTATS_OVERLAY
+bool CNetStats::m_bShowOverlay = true;
+uint32_t CNetStats::m_nDumpIntervalMs = 60000;
+#else
+bool CNetStats::m_bShowOverlay = false;
+uint32_t CNetStats::m_nDumpIntervalMs = 0;
+#endif
+
+static const char* const g_kindNames[NETSTAT_KIND_COUNT] = {
+	"Outgoing packets",
+	"Incoming packets",
+	"Outgoing RPCs",
+	"Incoming RPCs",
+	"Receive queue",
+	"Send to wire",
+	"Wire to player"
+};
+
+void CNetStats::Record(eNetStatKind kind, uint8_t id, uint32_t bytes, uint64_t ns)
+{
+	stEntry& entry = m_entries[kind][id];
+	int bucket = 63 - __builtin_clzll(ns | 1);
+	if(bucket >= HISTOGRAM_BUCKETS) {
+		bucket = HISTOGRAM_BUCKETS - 1;
+	}
+	entry.count.fetch_add(1, std::memory_order_relaxed);
+	entry.bytes.fetch_add(bytes, std::memory_order_relaxed);
+	entry.totalNs.fetch_add(ns, std::memory_order_relaxed);
+	entry.histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t CNetStats::Percentile(const stEntry& entry, uint32_t permille)
+{
+	uint32_t buckets[HISTOGRAM_BUCKETS];
+	for(int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		buckets[i] = entry.histogram[i].load(std::memory_order_relaxed);
+	}
+	return Percentile(buckets, permille);
+}
+
+uint64_t CNetStats::Percentile(const uint32_t buckets[HISTOGRAM_BUCKETS], uint32_t permille)
+{
+	uint64_t total = 0;
+	for(int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		total += buckets[i];
+	}
+	if(total == 0) {
+		return 0;
+	}
+	uint64_t rank = (total * permille + 999) / 1000;
+	uint64_t seen = 0;
+	for(int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		seen += buckets[i];
+		if(seen >= rank) {
+			// middle of [2^i, 2^(i+1))
+			return (3ull << i) >> 1;
+		}
+	}
+	return (3ull << (HISTOGRAM_BUCKETS - 1)) >> 1;
+}
+
+void CNetStats::Reset()
+{
+	for(int k = 0; k < NETSTAT_KIND_COUNT; k++) {
+		for(int id = 0; id < 256; id++) {
+			stEntry& entry = m_entries[k][id];
+			entry.count.store(0, std::memory_order_relaxed);
+			entry.bytes.store(0, std::memory_order_relaxed);
+			entry.totalNs.store(0, std::memory_order_relaxed);
+			for(int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+				entry.histogram[i].store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+}
+
+static RakNetStatisticsStruct* GetLinkStats()
+{
+	if(!pRakClient || !pRakClient->IsConnected()) {
+		return nullptr;
+	}
+	return pRakClient->GetStatistics();
+}
+
+// histogram as "<2:n 2:n 4:n ..." with bucket lower bounds in ms
+static void FormatLatency(const unsigned* histogram, char* buf, size_t size)
+{
+	size_t len = snprintf(buf, size, "<2:%u", histogram[0]);
+	for(int i = 1; i < STATISTICS_LATENCY_BUCKETS && len < size; i++) {
+		len += snprintf(buf + len, size - len, " %u:%u", 1u << i, histogram[i]);
+	}
+}
+
+// ids of one kind that have samples, most expensive first
+static int CollectActive(eNetStatKind kind, const CNetStats::stEntry* entries, uint8_t out[256])
+{
+	int n = 0;
+	for(int id = 0; id < 256; id++) {
+		if(entries[id].count.load(std::memory_order_relaxed)) {
+			out[n++] = (uint8_t)id;
+		}
+	}
+	std::sort(out, out + n, [entries](uint8_t a, uint8_t b) {
+		return entries[a].totalNs.load(std::memory_order_relaxed) > entries[b].totalNs.load(std::memory_order_relaxed);
+	});
+	return n;
+}
+
+void CNetStats::Dump()
+{
+	uint8_t ids[256];
+	for(int k = 0; k < NETSTAT_KIND_COUNT; k++) {
+		int n = CollectActive((eNetStatKind)k, m_entries[k], ids);
+		if(n == 0) {
+			continue;
+		}
+		__android_log_print(ANDROID_LOG_INFO, xorstr("NetStats"), xorstr("%s:"), g_kindNames[k]);
+		for(int i = 0; i < n; i++) {
+			const stEntry& entry = m_entries[k][ids[i]];
+			__android_log_print(ANDROID_LOG_INFO, xorstr("NetStats"),
+				xorstr("  id %3u: count %u, bytes %llu, p50 %llu us, p99 %llu us, total %llu us"),
+				ids[i],
+				entry.count.load(std::memory_order_relaxed),
+				(unsigned long long)entry.bytes.load(std::memory_order_relaxed),
+				(unsigned long long)Percentile(entry, 500) / 1000,
+				(unsigned long long)Percentile(entry, 990) / 1000,
+				(unsigned long long)entry.totalNs.load(std::memory_order_relaxed) / 1000);
+		}
+	}
+	DumpLink();
+}
+
+void CNetStats::DumpLink()
+{
+	const RakNetStatisticsStruct* s = GetLinkStats();
+	if(!s) {
+		return;
+	}
+	__android_log_print(ANDROID_LOG_INFO, xorstr("NetStats"),
+		xorstr("Link: rtt %.1f ms (var %.1f), resend timeout %.1f ms, resends %u, timeouts %u, superseded %u, payloads pooled %u heap %u"),
+		s->smoothedRoundTripTime, s->roundTripTimeVariation, s->resendTimeout,
+		s->messageResends, s->resendTimeouts, s->sequencedMessagesSuperseded,
+		s->payloadsPooled, s->payloadsFromHeap);
+	__android_log_print(ANDROID_LOG_INFO, xorstr("NetStats"),
+		xorstr("  socket: receive buffer %u B, send buffer %u B, dropped by the kernel %u, failed sends %u, MTU %u"),
+		s->socketReceiveBufferBytes, s->socketSendBufferBytes, s->socketReceiveDrops, s->socketSendFailures, s->mtuSize);
+	__android_log_print(ANDROID_LOG_INFO, xorstr("NetStats"),
+		xorstr("  reassembly: %u fragments (%u B) waiting, %u messages (%u B) discarded"),
+		s->messagesWaitingForReassembly, s->splitMessageBytesWaiting, s->splitMessagesDiscarded, s->splitMessageBytesDiscarded);
+	for(int id = 0; id < 256; id++) {
+		if(!s->messagesSentPerId[id] && !s->messagesReceivedPerId[id]) {
+			continue;
+		}
+		__android_log_print(ANDROID_LOG_INFO, xorstr("NetStats"),
+			xorstr("  id %3u: sent %u (%u B), resent %u, received %u (%u B)"),
+			id, s->messagesSentPerId[id], s->messageDataBitsSentPerId[id] / 8, s->messageResendsPerId[id],
+			s->messagesReceivedPerId[id], s->messageDataBitsReceivedPerId[id] / 8);
+	}
+	for(int ch = 0; ch < STATISTICS_ORDERING_CHANNELS; ch++) {
+		if(s->messagesSentPerChannel[ch]) {
+			__android_log_print(ANDROID_LOG_INFO, xorstr("NetStats"), xorstr("  channel %2u: sent %u (%u B)"),
+				ch, s->messagesSentPerChannel[ch], s->messageDataBitsSentPerChannel[ch] / 8);
+		}
+	}
+	char buf[256];
+	FormatLatency(s->ackLatencyHistogram, buf, sizeof(buf));
+	__android_log_print(ANDROID_LOG_INFO, xorstr("NetStats"), xorstr("  ack latency ms: %s"), buf);
+	FormatLatency(s->resendLatencyHistogram, buf, sizeof(buf));
+	__android_log_print(ANDROID_LOG_INFO, xorstr("NetStats"), xorstr("  resend latency ms: %s"), buf);
+}
+
+void CNetStats::Process()
+{
+	if(!m_nDumpIntervalMs) {
+		return;
+	}
+	uint64_t now = Now();
+	if(now < m_nextDump) {
+		return;
+	}
+	if(m_nextDump) {
+		Dump();
+	}
+	m_nextDump = now + (uint64_t)m_nDumpIntervalMs * 1000000ull;
+}
+
+// the whole log2 histogram behind an entry's percentiles, for the row under the cursor
+static void DrawHistogramTooltip(const CNetStats::stEntry& entry)
+{
+	float buckets[CNetStats::HISTOGRAM_BUCKETS];
+	for(int i = 0; i < CNetStats::HISTOGRAM_BUCKETS; i++) {
+		buckets[i] = (float)entry.histogram[i].load(std::memory_order_relaxed);
+	}
+	ImGui::BeginTooltip();
+	ImGui::PlotHistogram(xorstr("##histogram"), buckets, CNetStats::HISTOGRAM_BUCKETS, 0, xorstr("1 ns .. 2 s, log2"), 0.0f, FLT_MAX, ImVec2(256, 64));
+	ImGui::EndTooltip();
+}
+
+void CNetStats::DrawOverlay()
+{
+	if(!m_bShowOverlay) {
+		return;
+	}
+
+	ImGui::SetNextWindowCollapsed(true, ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowSize(ImVec2(560, 420), ImGuiCond_FirstUseEver);
+	if(!ImGui::Begin(xorstr("Net stats"), &m_bShowOverlay)) {
+		ImGui::End();
+		return;
+	}
+
+	if(ImGui::Button(xorstr("Dump to logcat"))) {
+		Dump();
+	}
+	ImGui::SameLine();
+	if(ImGui::Button(xorstr("Reset"))) {
+		Reset();
+	}
+
+	uint8_t ids[256];
+	for(int k = 0; k < NETSTAT_KIND_COUNT; k++) {
+		if(!ImGui::CollapsingHeader(g_kindNames[k])) {
+			continue;
+		}
+		int n = CollectActive((eNetStatKind)k, m_entries[k], ids);
+		ImGui::PushID(k);
+		if(ImGui::BeginTable(xorstr("stats"), 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+			ImGui::TableSetupColumn(xorstr("ID"));
+			ImGui::TableSetupColumn(xorstr("Count"));
+			ImGui::TableSetupColumn(xorstr("KB"));
+			ImGui::TableSetupColumn(xorstr("p50 us"));
+			ImGui::TableSetupColumn(xorstr("p99 us"));
+			ImGui::TableSetupColumn(xorstr("Total ms"));
+			ImGui::TableHeadersRow();
+			for(int i = 0; i < n; i++) {
+				const stEntry& entry = m_entries[k][ids[i]];
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn(); ImGui::Text("%u", ids[i]);
+				if(ImGui::IsItemHovered()) {
+					DrawHistogramTooltip(entry);
+				}
+				ImGui::TableNextColumn(); ImGui::Text("%u", entry.count.load(std::memory_order_relaxed));
+				ImGui::TableNextColumn(); ImGui::Text("%.1f", entry.bytes.load(std::memory_order_relaxed) / 1024.0);
+				ImGui::TableNextColumn(); ImGui::Text("%.1f", Percentile(entry, 500) / 1000.0);
+				ImGui::TableNextColumn(); ImGui::Text("%.1f", Percentile(entry, 990) / 1000.0);
+				ImGui::TableNextColumn(); ImGui::Text("%.2f", entry.totalNs.load(std::memory_order_relaxed) / 1000000.0);
+			}
+			ImGui::EndTable();
+		}
+		ImGui::PopID();
+	}
+	DrawLink();
+	ImGui::End();
+}
+
+void CNetStats::DrawLink()
+{
+	if(!ImGui::CollapsingHeader(xorstr("Link"))) {
+		return;
+	}
+	// the stage of the join in progress, or the whole of the last one
+	if(CJoinHandshake::HasReached(JOIN_SPAWNED)) {
+		ImGui::Text(xorstr("Join: accepted %u ms, init game %u, spawn info %u, spawned %u"),
+			CJoinHandshake::GetStageMs(JOIN_ACCEPTED), CJoinHandshake::GetStageMs(JOIN_INIT_GAME),
+			CJoinHandshake::GetStageMs(JOIN_SPAWN_INFO), CJoinHandshake::GetStageMs(JOIN_SPAWNED));
+	} else if(CJoinHandshake::IsJoining()) {
+		eJoinStage stage = CJoinHandshake::GetLatestStage();
+		ImGui::Text(xorstr("Join: %s at %u ms"), CJoinHandshake::GetStageName(stage), CJoinHandshake::GetStageMs(stage));
+	}
+	const RakNetStatisticsStruct* s = GetLinkStats();
+	if(!s) {
+		ImGui::TextUnformatted(xorstr("Not connected"));
+		return;
+	}
+	ImGui::Text(xorstr("RTT %.1f ms (var %.1f), resend timeout %.1f ms"),
+		s->smoothedRoundTripTime, s->roundTripTimeVariation, s->resendTimeout);
+	ImGui::Text(xorstr("Resends %u, timeouts %u, superseded %u"),
+		s->messageResends, s->resendTimeouts, s->sequencedMessagesSuperseded);
+	ImGui::Text(xorstr("Payloads pooled %u, from heap %u"), s->payloadsPooled, s->payloadsFromHeap);
+	ImGui::Text(xorstr("Syncs from far players skipped %u"), CSyncInterest::GetSkipped());
+	if(CDebounce::GetDropped()) {
+		ImGui::Text(xorstr("Repeated UI actions dropped %u"), CDebounce::GetDropped());
+	}
+	if(CSyncQueue::GetDropped()) {
+		ImGui::Text(xorstr("Decoded syncs dropped while the game stalled %u"), CSyncQueue::GetDropped());
+	}
+	if(CThermal::GetStatus() >= 0) {
+		ImGui::Text(xorstr("Thermal status %d, plugin load %s"), CThermal::GetStatus(), CThermal::GetLevelName(CThermal::GetLevel()));
+	}
+	if(CSyncRate::GetRateHz()) {
+		ImGui::Text(xorstr("Sync rate %u/s, ticks dropped %u"), CSyncRate::GetRateHz(), CSyncRate::GetDropped());
+	}
+	if(CSyncJitter::IsEnabled()) {
+		ImGui::Text(xorstr("Sync playout delay %u ms, late %u"), CSyncJitter::GetDelayMs(), CSyncJitter::GetLate());
+	}
+	ImGui::Text(xorstr("Socket buffers %u KB in, %u KB out, kernel drops %u, failed sends %u, MTU %u"),
+		s->socketReceiveBufferBytes / 1024, s->socketSendBufferBytes / 1024, s->socketReceiveDrops, s->socketSendFailures, s->mtuSize);
+	ImGui::Text(xorstr("Reassembly %u fragments (%u KB) waiting, %u messages (%u KB) discarded"),
+		s->messagesWaitingForReassembly, s->splitMessageBytesWaiting / 1024, s->splitMessagesDiscarded, s->splitMessageBytesDiscarded / 1024);
+	if(LinkEmulator::IsActive()) {
+		LinkStatistics up, down;
+		LinkEmulator::GetStatistics(&up, &down);
+		ImGui::Text(xorstr("Emulated link up: lost %u, overflowed %u, delayed %u, held %u"), up.lost, up.overflowed, up.delayed, up.queued);
+		ImGui::Text(xorstr("Emulated link down: lost %u, overflowed %u, delayed %u, held %u"), down.lost, down.overflowed, down.delayed, down.queued);
+	}
+
+	if(ImGui::BeginTable(xorstr("ids"), 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+		ImGui::TableSetupColumn(xorstr("ID"));
+		ImGui::TableSetupColumn(xorstr("Sent"));
+		ImGui::TableSetupColumn(xorstr("Sent KB"));
+		ImGui::TableSetupColumn(xorstr("Resent"));
+		ImGui::TableSetupColumn(xorstr("Received"));
+		ImGui::TableSetupColumn(xorstr("Recv KB"));
+		ImGui::TableHeadersRow();
+		for(int id = 0; id < 256; id++) {
+			if(!s->messagesSentPerId[id] && !s->messagesReceivedPerId[id]) {
+				continue;
+			}
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::Text("%u", id);
+			ImGui::TableNextColumn(); ImGui::Text("%u", s->messagesSentPerId[id]);
+			ImGui::TableNextColumn(); ImGui::Text("%.1f", s->messageDataBitsSentPerId[id] / 8192.0);
+			ImGui::TableNextColumn(); ImGui::Text("%u", s->messageResendsPerId[id]);
+			ImGui::TableNextColumn(); ImGui::Text("%u", s->messagesReceivedPerId[id]);
+			ImGui::TableNextColumn(); ImGui::Text("%.1f", s->messageDataBitsReceivedPerId[id] / 8192.0);
+		}
+		ImGui::EndTable();
+	}
+
+	if(ImGui::BeginTable(xorstr("channels"), 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+		ImGui::TableSetupColumn(xorstr("Channel"));
+		ImGui::TableSetupColumn(xorstr("Sent"));
+		ImGui::TableSetupColumn(xorstr("Sent KB"));
+		ImGui::TableHeadersRow();
+		for(int ch = 0; ch < STATISTICS_ORDERING_CHANNELS; ch++) {
+			if(!s->messagesSentPerChannel[ch]) {
+				continue;
+			}
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::Text("%u", ch);
+			ImGui::TableNextColumn(); ImGui::Text("%u", s->messagesSentPerChannel[ch]);
+			ImGui::TableNextColumn(); ImGui::Text("%.1f", s->messageDataBitsSentPerChannel[ch] / 8192.0);
+		}
+		ImGui::EndTable();
+	}
+
+	char buf[256];
+	FormatLatency(s->ackLatencyHistogram, buf, sizeof(buf));
+	ImGui::Text(xorstr("Ack latency ms: %s"), buf);
+	FormatLatency(s->resendLatencyHistogram, buf, sizeof(buf));
+	ImGui::Text(xorstr("Resend latency ms: %s"), buf);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <time.h>
+
+enum eNetStatKind
+{
+	NETSTAT_OUT_PACKET,
+	NETSTAT_IN_PACKET,
+	NETSTAT_OUT_RPC,
+	NETSTAT_IN_RPC,
+	NETSTAT_IN_QUEUE,	// network thread to Receive, see CThreadPolicy
+	NETSTAT_OUT_WIRE,	// the game's RakClient::Send to the datagram's SendTo
+	NETSTAT_IN_WIRE,	// the datagram off the socket to CRemotePlayer's Store*SyncData
+	NETSTAT_KIND_COUNT
+};
+
+// Hot-path counters for the translation layer. Every slot is a relaxed atomic,
+// so recording from the game and RakNet threads needs no locks; readers only
+// ever see a slightly stale snapshot.
+class CNetStats
+{
+public:
+	// bucket N holds samples in [2^N, 2^(N+1)) ns
+	static constexpr int HISTOGRAM_BUCKETS = 32;
+
+	struct stEntry
+	{
+		std::atomic<uint32_t> count;
+		std::atomic<uint64_t> bytes;
+		std::atomic<uint64_t> totalNs;
+		std::atomic<uint32_t> histogram[HISTOGRAM_BUCKETS];
+	};
+
+	class Scope
+	{
+	public:
+		Scope(eNetStatKind kind, uint8_t id, uint32_t bytes)
+			: m_kind(kind), m_id(id), m_bytes(bytes), m_start(Now()) {}
+		~Scope() { Record(m_kind, m_id, m_bytes, Now() - m_start); }
+	private:
+		eNetStatKind m_kind;
+		uint8_t m_id;
+		uint32_t m_bytes;
+		uint64_t m_start;
+	};
+
+	static inline uint64_t Now()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+	}
+
+	static void Record(eNetStatKind kind, uint8_t id, uint32_t bytes, uint64_t ns);
+	static uint64_t Percentile(const stEntry& entry, uint32_t permille);
+	static uint64_t Percentile(const uint32_t buckets[HISTOGRAM_BUCKETS], uint32_t permille);
+	static const stEntry& GetEntry(eNetStatKind kind, uint8_t id) { return m_entries[kind][id]; }
+	static void Reset();
+	// translation layer counters plus the RakNet link breakdown
+	static void Dump();
+	static void DrawOverlay();
+	// once per frame, dumps every m_nDumpIntervalMs (0 disables)
+	static void Process();
+
+	static bool m_bShowOverlay;
+	static uint32_t m_nDumpIntervalMs;
+private:
+	static void DumpLink();
+	static void DrawLink();
+
+	static stEntry m_entries[NETSTAT_KIND_COUNT][256];
+	static uint64_t m_nextDump;
+};
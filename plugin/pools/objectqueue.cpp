@@ -0,0 +1,196 @@
+#include "objectqueue.h"
+
+#include <algorithm>
+#include <string.h>
+#include <time.h>
+
+#include "scheduler.h"
+#include "game/CPlayerPed.h"
+#include "game/math/simd.h"
+#include "plugin/netgame.h"
+#include "vendor/RakNet/SAMP/SAMPRPC.h"
+
+std::vector<CObjectQueue::stPending> CObjectQueue::m_pending;
+std::vector<CVector> CObjectQueue::m_positions;
+uint16_t CObjectQueue::m_slots[0x10000];
+void (*CObjectQueue::m_handler)(RPCParameters*) = nullptr;
+RakPeerInterface* CObjectQueue::m_recipient = nullptr;
+PlayerID CObjectQueue::m_sender = UNASSIGNED_PLAYER_ID;
+bool CObjectQueue::m_bScheduled = false;
+
+// objectId(2), modelId(4), then the position
+static constexpr uint32_t POS_OFFSET = 6;
+// keeps m_slots in range
+static constexpr size_t MAX_PENDING = 0xFFFF;
+
+static uint64_t NowNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+bool CObjectQueue::Push(const RPCParameters* rpcParams, void (*handler)(RPCParameters*))
+{
+	uint32_t inputLen = BITS_TO_BYTES(rpcParams->numberOfBitsOfData);
+	if(inputLen < POS_OFFSET + 3 * sizeof(float)) {
+		return false;
+	}
+	uint16_t objectId;
+	memcpy(&objectId, rpcParams->input, sizeof(objectId));
+	float pos[3];
+	memcpy(pos, rpcParams->input + POS_OFFSET, sizeof(pos));
+
+	// a second create for the same id replaces the first, as it would have in the game
+	uint32_t index;
+	if(m_slots[objectId]) {
+		index = m_slots[objectId] - 1;
+	} else {
+		if(m_pending.size() >= MAX_PENDING) {
+			return false;
+		}
+		index = (uint32_t)m_pending.size();
+		m_pending.emplace_back();
+		m_positions.emplace_back();
+		m_slots[objectId] = (uint16_t)(index + 1);
+	}
+	stPending& pending = m_pending[index];
+	pending.objectId = objectId;
+	pending.bits = rpcParams->numberOfBitsOfData;
+	pending.payload.assign(rpcParams->input, rpcParams->input + inputLen);
+	m_positions[index] = CVector(pos[0], pos[1], pos[2]);
+
+	m_handler = handler;
+	m_recipient = rpcParams->recipient;
+	m_sender = rpcParams->sender;
+	Schedule();
+	return true;
+}
+
+void CObjectQueue::Remove(uint32_t index)
+{
+	m_slots[m_pending[index].objectId] = 0;
+	uint32_t last = (uint32_t)m_pending.size() - 1;
+	if(index != last) {
+		m_pending[index] = std::move(m_pending[last]);
+		m_positions[index] = m_positions[last];
+		m_slots[m_pending[index].objectId] = (uint16_t)(index + 1);
+	}
+	m_pending.pop_back();
+	m_positions.pop_back();
+}
+
+bool CObjectQueue::Cancel(uint16_t objectId)
+{
+	if(!m_slots[objectId]) {
+		return false;
+	}
+	Remove(m_slots[objectId] - 1);
+	return true;
+}
+
+void CObjectQueue::Create(const stPending& pending)
+{
+	RPCParameters rpcParams;
+	rpcParams.input = (unsigned char*)pending.payload.data();
+	rpcParams.numberOfBitsOfData = pending.bits;
+	rpcParams.sender = m_sender;
+	rpcParams.recipient = m_recipient;
+	rpcParams.replyToSender = nullptr;
+	m_handler(&rpcParams);
+}
+
+void CObjectQueue::CreateNow(uint16_t objectId)
+{
+	if(!m_slots[objectId]) {
+		return;
+	}
+	uint32_t index = m_slots[objectId] - 1;
+	stPending pending = std::move(m_pending[index]);
+	Remove(index);
+	Create(pending);
+}
+
+bool CObjectQueue::IsObjectRPC(int rpcId)
+{
+	return rpcId == RPC_ScrSetObjectPos || rpcId == RPC_ScrSetObjectRotation
+		|| rpcId == RPC_ScrMoveObject || rpcId == RPC_ScrStopObject
+		|| rpcId == RPC_ScrAttachObjectToPlayer;
+}
+
+void CObjectQueue::NeedsObject(int rpcId, const unsigned char* payload, uint32_t size)
+{
+	if(m_pending.empty() || !IsObjectRPC(rpcId) || size < sizeof(uint16_t)) {
+		return;
+	}
+	// all of them lead with the object id
+	uint16_t objectId;
+	memcpy(&objectId, payload, sizeof(objectId));
+	CreateNow(objectId);
+}
+
+void CObjectQueue::Schedule()
+{
+	if(m_bScheduled) {
+		return;
+	}
+	m_bScheduled = true;
+	CFrameScheduler::Post(CreateBatch);
+}
+
+void CObjectQueue::CreateBatch()
+{
+	m_bScheduled = false;
+	if(m_pending.empty()) {
+		return;
+	}
+
+	CVector origin;
+	CPlayerPool* pool = CNetGame::GetPlayerPool();
+	CLocalPlayer* player = pool ? pool->GetLocalPlayer() : nullptr;
+	CPlayerPed* ped = player ? player->GetPlayerPed() : nullptr;
+	if(ped) {
+		origin = ped->m_matrix.GetPosition();
+	}
+
+	// the player moves between frames, so the order is worked out again every time
+	static std::vector<float> distances;
+	static std::vector<uint32_t> order;
+	uint32_t count = (uint32_t)m_pending.size();
+	distances.resize(count);
+	order.resize(count);
+	math::DistancesSquared(origin, m_positions.data(), (int)count, distances.data());
+	for(uint32_t i = 0; i < count; i++) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [](uint32_t a, uint32_t b) { return distances[a] < distances[b]; });
+
+	// created in distance order, removed afterwards from the back so the indices hold
+	uint64_t start = NowNs();
+	uint32_t created = 0;
+	while(created < count)
+	{
+		Create(m_pending[order[created++]]);
+		if(NowNs() - start >= FRAME_BUDGET_NS) {
+			break;
+		}
+	}
+	std::sort(order.begin(), order.begin() + created, [](uint32_t a, uint32_t b) { return a > b; });
+	for(uint32_t i = 0; i < created; i++) {
+		Remove(order[i]);
+	}
+
+	// posted from inside the scheduler, so it runs on the next frame
+	if(!m_pending.empty()) {
+		Schedule();
+	}
+}
+
+void CObjectQueue::Clear()
+{
+	for(const stPending& pending : m_pending) {
+		m_slots[pending.objectId] = 0;
+	}
+	m_pending.clear();
+	m_positions.clear();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "game/math/vector.h"
+#include "vendor/RakNet/NetworkTypes.h"
+
+// RPC_ScrCreateObject payloads waiting for the game's handler. Mapped servers send
+// thousands on spawn, so they are buffered and fed to the handler from a CFrameScheduler
+// task, nearest to the local player first, for as long as the frame budget lasts. A
+// destroy for an object still waiting cancels both, and an RPC that moves, rotates or
+// attaches a waiting object creates it first (see NeedsObject). Game thread only.
+class CObjectQueue
+{
+public:
+	static constexpr uint64_t FRAME_BUDGET_NS = 2000000;
+
+	// false when the create has to go to the handler right away
+	static bool Push(const RPCParameters* rpcParams, void (*handler)(RPCParameters*));
+	// a RPC_ScrDestroyObject for an object still queued; true if it was, nothing to destroy then
+	static bool Cancel(uint16_t objectId);
+	static void NeedsObject(int rpcId, const unsigned char* payload, uint32_t size);
+	static bool IsObjectRPC(int rpcId);
+	static uint32_t Pending() { return (uint32_t)m_pending.size(); }
+	static void Clear();
+
+private:
+	struct stPending
+	{
+		uint16_t objectId;
+		uint32_t bits;
+		std::vector<unsigned char> payload;
+	};
+
+	static void Schedule();
+	static void CreateBatch();
+	static void Create(const stPending& pending);
+	static void Remove(uint32_t index);
+	static void CreateNow(uint16_t objectId);
+
+	static std::vector<stPending> m_pending;
+	// parallel to m_pending, for math::DistancesSquared
+	static std::vector<CVector> m_positions;
+	// index + 1 into m_pending by object id, 0 when not queued
+	static uint16_t m_slots[0x10000];
+	static void (*m_handler)(RPCParameters*);
+	static RakPeerInterface* m_recipient;
+	static PlayerID m_sender;
+	static bool m_bScheduled;
+};
@@ -0,0 +1,132 @@
+#include "playergrid.h"
+
+#include <time.h>
+
+CPlayerGrid::stNode CPlayerGrid::m_nodes[MAX_PLAYERS];
+int16_t CPlayerGrid::m_cellHead[CELLS * CELLS];
+bool CPlayerGrid::m_bInitialised = false;
+
+static uint32_t NowMs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+int CPlayerGrid::CellOf(float v)
+{
+	int cell = (int)((v - WORLD_MIN) / CELL_SIZE);
+	if(cell < 0) {
+		return 0;
+	}
+	if(cell >= CELLS) {
+		return CELLS - 1;
+	}
+	return cell;
+}
+
+void CPlayerGrid::Clear()
+{
+	for(int i = 0; i < CELLS * CELLS; i++) {
+		m_cellHead[i] = -1;
+	}
+	for(int i = 0; i < MAX_PLAYERS; i++) {
+		m_nodes[i].cell = -1;
+	}
+	m_bInitialised = true;
+}
+
+void CPlayerGrid::Unlink(uint16_t playerId)
+{
+	stNode& node = m_nodes[playerId];
+	if(node.prev >= 0) {
+		m_nodes[node.prev].next = node.next;
+	} else {
+		m_cellHead[node.cell] = node.next;
+	}
+	if(node.next >= 0) {
+		m_nodes[node.next].prev = node.prev;
+	}
+	node.cell = -1;
+}
+
+void CPlayerGrid::Update(uint16_t playerId, const CVector& pos)
+{
+	if(playerId >= MAX_PLAYERS) {
+		return;
+	}
+	if(!m_bInitialised) {
+		Clear();
+	}
+
+	stNode& node = m_nodes[playerId];
+	node.pos = pos;
+	node.updatedMs = NowMs();
+
+	int16_t cell = (int16_t)(CellOf(pos.y) * CELLS + CellOf(pos.x));
+	if(node.cell == cell) {
+		return;
+	}
+	if(node.cell >= 0) {
+		Unlink(playerId);
+	}
+	node.cell = cell;
+	node.prev = -1;
+	node.next = m_cellHead[cell];
+	if(node.next >= 0) {
+		m_nodes[node.next].prev = (int16_t)playerId;
+	}
+	m_cellHead[cell] = (int16_t)playerId;
+}
+
+void CPlayerGrid::Remove(uint16_t playerId)
+{
+	if(playerId < MAX_PLAYERS && m_bInitialised && m_nodes[playerId].cell >= 0) {
+		Unlink(playerId);
+	}
+}
+
+bool CPlayerGrid::GetPosition(uint16_t playerId, CVector* pos)
+{
+	if(playerId >= MAX_PLAYERS || !m_bInitialised || m_nodes[playerId].cell < 0) {
+		return false;
+	}
+	*pos = m_nodes[playerId].pos;
+	return true;
+}
+
+int CPlayerGrid::Query(const CVector& center, float radius, uint16_t* out, int maxOut)
+{
+	if(!m_bInitialised) {
+		return 0;
+	}
+	uint32_t now = NowMs();
+	float radiusSq = radius * radius;
+	int minX = CellOf(center.x - radius), maxX = CellOf(center.x + radius);
+	int minY = CellOf(center.y - radius), maxY = CellOf(center.y + radius);
+	int n = 0;
+	for(int cy = minY; cy <= maxY; cy++) {
+		for(int cx = minX; cx <= maxX; cx++) {
+			int16_t id = m_cellHead[cy * CELLS + cx];
+			while(id >= 0) {
+				stNode& node = m_nodes[id];
+				int16_t next = node.next;
+				if(now - node.updatedMs > STALE_MS) {
+					// dropped lazily, nothing tells us when a player streams out
+					Unlink((uint16_t)id);
+				} else {
+					float dx = node.pos.x - center.x;
+					float dy = node.pos.y - center.y;
+					if(dx * dx + dy * dy <= radiusSq) {
+						if(n == maxOut) {
+							return n;
+						}
+						out[n++] = (uint16_t)id;
+					}
+				}
+				id = next;
+			}
+		}
+	}
+	return n;
+}
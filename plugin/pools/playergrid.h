@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+#include "playerpool.h"
+#include "game/math/vector.h"
+
+// Uniform 2D grid over the map holding the last synced position of every remote
+// player, so radius queries only visit the cells they overlap instead of the whole
+// pool. Fed from the sync packet handlers; game thread only.
+class CPlayerGrid
+{
+public:
+	static constexpr float WORLD_MIN = -3000.0f;
+	static constexpr float WORLD_MAX = 3000.0f;
+	static constexpr float CELL_SIZE = 100.0f;
+	static constexpr int CELLS = (int)((WORLD_MAX - WORLD_MIN) / CELL_SIZE);
+	// a player we have not heard from for this long no longer shows up in queries
+	static constexpr uint32_t STALE_MS = 5000;
+
+	static void Update(uint16_t playerId, const CVector& pos);
+	static void Remove(uint16_t playerId);
+	static void Clear();
+
+	// writes up to maxOut ids within radius of center (2D distance), returns how many
+	static int Query(const CVector& center, float radius, uint16_t* out, int maxOut);
+	static bool GetPosition(uint16_t playerId, CVector* pos);
+
+private:
+	struct stNode
+	{
+		CVector pos;
+		uint32_t updatedMs;
+		int16_t cell;	// -1 when not in the grid
+		int16_t prev;
+		int16_t next;
+	};
+
+	static int CellOf(float v);
+	static void Unlink(uint16_t playerId);
+
+	static stNode m_nodes[MAX_PLAYERS];
+	static int16_t m_cellHead[CELLS * CELLS];
+	static bool m_bInitialised;
+};
@@ -0,0 +1,175 @@
+#include "playernames.h"
+#include "plugin.h"
+
+#include "vendor/RakNet/NetworkTypes.h"
+
+#include <string.h>
+
+char CPlayerNames::m_names[MAX_PLAYERS][NAME_BYTES];
+uint32_t CPlayerNames::m_hashes[MAX_PLAYERS];
+uint16_t CPlayerNames::m_table[TABLE_SIZE];
+uint16_t CPlayerNames::m_sorted[MAX_PLAYERS];
+uint16_t CPlayerNames::m_sortedCount = 0;
+
+static inline uint8_t Fold(uint8_t c)
+{
+	return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+// strncmp on folded bytes; len 0 compares whole strings
+static int FoldCompare(const char* a, const char* b, uint32_t len)
+{
+	for(uint32_t i = 0; !len || i < len; i++)
+	{
+		uint8_t ca = Fold((uint8_t)a[i]), cb = Fold((uint8_t)b[i]);
+		if(ca != cb) {
+			return ca < cb ? -1 : 1;
+		}
+		if(!ca) {
+			break;
+		}
+	}
+	return 0;
+}
+
+uint32_t CPlayerNames::Hash(const char* utf8)
+{
+	// FNV-1a
+	uint32_t hash = 0x811C9DC5u;
+	for(; *utf8; utf8++) {
+		hash = (hash ^ Fold((uint8_t)*utf8)) * 0x01000193u;
+	}
+	return hash;
+}
+
+uint32_t CPlayerNames::LowerBound(const char* utf8, uint32_t prefixLen)
+{
+	uint32_t low = 0, high = m_sortedCount;
+	while(low < high)
+	{
+		uint32_t mid = (low + high) / 2;
+		if(FoldCompare(m_names[m_sorted[mid]], utf8, prefixLen) < 0) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return low;
+}
+
+void CPlayerNames::Set(uint16_t playerId, const char* cp1251, uint32_t len)
+{
+	if(playerId >= MAX_PLAYERS) {
+		return;
+	}
+	Unlink(playerId);
+	if(len > MAX_NAME) {
+		len = MAX_NAME;
+	}
+	char* name = m_names[playerId];
+	cp1251_to_utf8(name, NAME_BYTES, cp1251, len);
+	if(!name[0]) {
+		return;
+	}
+
+	uint32_t hash = Hash(name);
+	m_hashes[playerId] = hash;
+	uint32_t slot = hash & (TABLE_SIZE - 1);
+	while(m_table[slot]) {
+		slot = (slot + 1) & (TABLE_SIZE - 1);
+	}
+	m_table[slot] = playerId + 1;
+
+	// equal names keep their join order
+	uint32_t at = LowerBound(name, 0);
+	while(at < m_sortedCount && !FoldCompare(m_names[m_sorted[at]], name, 0)) {
+		at++;
+	}
+	memmove(&m_sorted[at + 1], &m_sorted[at], (m_sortedCount - at) * sizeof(uint16_t));
+	m_sorted[at] = playerId;
+	m_sortedCount++;
+}
+
+void CPlayerNames::Remove(uint16_t playerId)
+{
+	if(playerId < MAX_PLAYERS) {
+		Unlink(playerId);
+	}
+}
+
+void CPlayerNames::Unlink(uint16_t playerId)
+{
+	char* name = m_names[playerId];
+	if(!name[0]) {
+		return;
+	}
+
+	uint32_t at = LowerBound(name, 0);
+	while(at < m_sortedCount && m_sorted[at] != playerId) {
+		at++;
+	}
+	if(at < m_sortedCount) {
+		memmove(&m_sorted[at], &m_sorted[at + 1], (m_sortedCount - at - 1) * sizeof(uint16_t));
+		m_sortedCount--;
+	}
+
+	uint32_t slot = m_hashes[playerId] & (TABLE_SIZE - 1);
+	while(m_table[slot] && m_table[slot] != playerId + 1) {
+		slot = (slot + 1) & (TABLE_SIZE - 1);
+	}
+	if(m_table[slot])
+	{
+		// shift later entries of the run back, so no lookup stops short at the hole
+		uint32_t hole = slot;
+		for(uint32_t next = (hole + 1) & (TABLE_SIZE - 1); m_table[next]; next = (next + 1) & (TABLE_SIZE - 1))
+		{
+			uint32_t home = m_hashes[m_table[next] - 1] & (TABLE_SIZE - 1);
+			// move it unless its home lies cyclically in (hole, next]
+			if(((next - home) & (TABLE_SIZE - 1)) >= ((next - hole) & (TABLE_SIZE - 1))) {
+				m_table[hole] = m_table[next];
+				hole = next;
+			}
+		}
+		m_table[hole] = 0;
+	}
+	name[0] = '\0';
+}
+
+void CPlayerNames::Clear()
+{
+	for(uint32_t i = 0; i < m_sortedCount; i++) {
+		m_names[m_sorted[i]][0] = '\0';
+	}
+	memset(m_table, 0, sizeof(m_table));
+	m_sortedCount = 0;
+}
+
+uint16_t CPlayerNames::Find(const char* utf8)
+{
+	if(!utf8[0]) {
+		return UNASSIGNED_PLAYER_INDEX;
+	}
+	uint32_t hash = Hash(utf8);
+	for(uint32_t slot = hash & (TABLE_SIZE - 1); m_table[slot]; slot = (slot + 1) & (TABLE_SIZE - 1))
+	{
+		uint16_t id = m_table[slot] - 1;
+		if(m_hashes[id] == hash && !FoldCompare(m_names[id], utf8, 0)) {
+			return id;
+		}
+	}
+	return UNASSIGNED_PLAYER_INDEX;
+}
+
+uint32_t CPlayerNames::FindPrefix(const char* utf8Prefix, uint16_t* out, uint32_t maxOut)
+{
+	uint32_t prefixLen = (uint32_t)strlen(utf8Prefix);
+	uint32_t count = 0;
+	for(uint32_t at = prefixLen ? LowerBound(utf8Prefix, prefixLen) : 0; at < m_sortedCount && count < maxOut; at++)
+	{
+		if(prefixLen && FoldCompare(m_names[m_sorted[at]], utf8Prefix, prefixLen) != 0) {
+			break;
+		}
+		out[count++] = m_sorted[at];
+	}
+	return count;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+#include "playerpool.h"
+
+// Remote player names, stored once per id in UTF-8, with a lookup by name and a sorted index
+// for lookups by prefix (autocomplete, the player list's search). Kept by the ServerJoin,
+// ServerQuit and ScrSetPlayerName fixups. ASCII letters compare case-insensitively, as SA-MP
+// names do. The name table is open addressed on a hash of the folded name; the prefix index
+// is just the ids sorted by name, which at MAX_PLAYERS entries moves a few KB per join and
+// beats chasing trie nodes. Game thread only.
+class CPlayerNames
+{
+public:
+	// on the wire, cp1251
+	static constexpr uint32_t MAX_NAME = 24;
+	// every cp1251 byte is at most three in UTF-8
+	static constexpr uint32_t NAME_BYTES = MAX_NAME * 3 + 1;
+
+	static void Set(uint16_t playerId, const char* cp1251, uint32_t len);
+	static void Remove(uint16_t playerId);
+	static void Clear();
+
+	// "" for an id without a name
+	static const char* Get(uint16_t playerId) { return playerId < MAX_PLAYERS ? m_names[playerId] : ""; }
+	// UNASSIGNED_PLAYER_INDEX when nobody has that name
+	static uint16_t Find(const char* utf8);
+	// up to maxOut ids whose name starts with prefix, in name order; returns how many
+	static uint32_t FindPrefix(const char* utf8Prefix, uint16_t* out, uint32_t maxOut);
+
+private:
+	// a power of two, a bit over twice MAX_PLAYERS
+	static constexpr uint32_t TABLE_SIZE = 4096;
+
+	static uint32_t Hash(const char* utf8);
+	static void Unlink(uint16_t playerId);
+	// first index in m_sorted whose name is not below utf8 (up to prefixLen bytes, 0 for all)
+	static uint32_t LowerBound(const char* utf8, uint32_t prefixLen);
+
+	static char m_names[MAX_PLAYERS][NAME_BYTES];
+	static uint32_t m_hashes[MAX_PLAYERS];
+	// id + 1, 0 for an empty slot
+	static uint16_t m_table[TABLE_SIZE];
+	static uint16_t m_sorted[MAX_PLAYERS];
+	static uint16_t m_sortedCount;
+};
@@ -1,6 +1,41 @@
 #include "playerpool.h"
 
+eastl::bitset<MAX_PLAYERS> CPlayerPool::m_activeIds;
+uint16_t CPlayerPool::m_activeList[MAX_PLAYERS];
+uint16_t CPlayerPool::m_activeSlot[MAX_PLAYERS];
+uint16_t CPlayerPool::m_activeCount = 0;
+
 CRemotePlayer* CPlayerPool::GetAt(uint16_t id)
 {
-	return m_pPlayers[id];
+	// ids come off the wire; folds to a compare and a conditional select
+	return id < MAX_PLAYERS ? m_pPlayers[id] : nullptr;
+}
+
+void CPlayerPool::MarkActive(uint16_t playerId)
+{
+	if(playerId >= MAX_PLAYERS || m_activeIds.test(playerId)) {
+		return;
+	}
+	m_activeIds.set(playerId);
+	m_activeSlot[playerId] = m_activeCount;
+	m_activeList[m_activeCount++] = playerId;
+}
+
+void CPlayerPool::MarkInactive(uint16_t playerId)
+{
+	if(playerId >= MAX_PLAYERS || !m_activeIds.test(playerId)) {
+		return;
+	}
+	m_activeIds.reset(playerId);
+	// move the last id into the hole
+	uint16_t slot = m_activeSlot[playerId];
+	uint16_t last = m_activeList[--m_activeCount];
+	m_activeList[slot] = last;
+	m_activeSlot[last] = slot;
+}
+
+void CPlayerPool::ClearActive()
+{
+	m_activeIds.reset();
+	m_activeCount = 0;
 }
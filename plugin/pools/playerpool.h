@@ -3,22 +3,41 @@
 #include <cstdint>
 
 #include "vendor/EASTL/array.h"
+#include "vendor/EASTL/bitset.h"
 
 #include "../localplayer.h"
 #include "../remoteplayer.h"
 
+#define MAX_PLAYERS 1504
+
 class CPlayerPool
 {
 public:
 	CLocalPlayer* GetLocalPlayer() { return m_pLocalPlayer; }
 	CRemotePlayer* GetAt(uint16_t playerId);
 	void* GetPlayerPed(uint16_t playerId);
+
+	// Connected remote player ids, kept by the ServerJoin/ServerQuit RPC fixups.
+	// Static so the game's own layout below stays untouched.
+	static void MarkActive(uint16_t playerId);
+	static void MarkInactive(uint16_t playerId);
+	static void ClearActive();
+	static bool IsActive(uint16_t playerId) { return playerId < MAX_PLAYERS && m_activeIds.test(playerId); }
+	// dense, in no particular order; invalidated by Mark*
+	static const uint16_t* GetActiveIds() { return m_activeList; }
+	static uint16_t GetActiveCount() { return m_activeCount; }
 public:
 	CLocalPlayer* m_pLocalPlayer;
-	CRemotePlayer* m_pPlayers[1504];
+	CRemotePlayer* m_pPlayers[MAX_PLAYERS];
 	int m_iLocalPlayerScore;
 	uint32_t m_dwLocalPlayerPing;
-	int m_iPlayerScores[1504];
-	uint32_t m_dwPlayerPings[1504];
+	int m_iPlayerScores[MAX_PLAYERS];
+	uint32_t m_dwPlayerPings[MAX_PLAYERS];
+
+private:
+	static eastl::bitset<MAX_PLAYERS> m_activeIds;
+	static uint16_t m_activeList[MAX_PLAYERS];
+	static uint16_t m_activeSlot[MAX_PLAYERS];
+	static uint16_t m_activeCount;
 };
 
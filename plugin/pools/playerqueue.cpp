@@ -0,0 +1,184 @@
+#include "playerqueue.h"
+#include "playerstate.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "scheduler.h"
+#include "game/CPlayerPed.h"
+#include "game/math/simd.h"
+#include "plugin/netgame.h"
+#include "vendor/RakNet/SAMP/SAMPRPC.h"
+
+CPlayerStreamQueue::stPending CPlayerStreamQueue::m_pending[MAX_PLAYERS];
+CVector CPlayerStreamQueue::m_positions[MAX_PLAYERS];
+float CPlayerStreamQueue::m_distances[MAX_PLAYERS];
+uint16_t CPlayerStreamQueue::m_slots[MAX_PLAYERS];
+int CPlayerStreamQueue::m_nPending = 0;
+void (*CPlayerStreamQueue::m_handler)(RPCParameters*) = nullptr;
+RakPeerInterface* CPlayerStreamQueue::m_recipient = nullptr;
+PlayerID CPlayerStreamQueue::m_sender = UNASSIGNED_PLAYER_ID;
+bool CPlayerStreamQueue::m_bScheduled = false;
+
+// playerId(2), skin(4), then the position, as the game's handler reads it
+static constexpr uint32_t POS_OFFSET = 6;
+
+static uint64_t NowNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+bool CPlayerStreamQueue::Push(const RPCParameters* rpcParams, void (*handler)(RPCParameters*))
+{
+	uint32_t inputLen = BITS_TO_BYTES(rpcParams->numberOfBitsOfData);
+	if(inputLen < POS_OFFSET + 3 * sizeof(float) || inputLen > MAX_PAYLOAD) {
+		return false;
+	}
+	uint16_t playerId;
+	memcpy(&playerId, rpcParams->input, sizeof(playerId));
+	if(playerId >= MAX_PLAYERS) {
+		return false;
+	}
+
+	// a second add for the same id replaces the first, as it would have in the game
+	int index;
+	if(m_slots[playerId]) {
+		index = m_slots[playerId] - 1;
+	} else {
+		index = m_nPending++;
+		m_slots[playerId] = (uint16_t)(index + 1);
+	}
+	stPending& pending = m_pending[index];
+	pending.playerId = playerId;
+	pending.bits = rpcParams->numberOfBitsOfData;
+	memcpy(pending.payload, rpcParams->input, inputLen);
+
+	float pos[3];
+	memcpy(pos, pending.payload + POS_OFFSET, sizeof(pos));
+	m_positions[index] = CVector(pos[0], pos[1], pos[2]);
+
+	m_handler = handler;
+	m_recipient = rpcParams->recipient;
+	m_sender = rpcParams->sender;
+	Schedule();
+	return true;
+}
+
+void CPlayerStreamQueue::Remove(int index)
+{
+	m_slots[m_pending[index].playerId] = 0;
+	m_nPending--;
+	if(index != m_nPending) {
+		m_pending[index] = m_pending[m_nPending];
+		m_positions[index] = m_positions[m_nPending];
+		m_distances[index] = m_distances[m_nPending];
+		m_slots[m_pending[index].playerId] = (uint16_t)(index + 1);
+	}
+}
+
+bool CPlayerStreamQueue::Cancel(uint16_t playerId)
+{
+	if(playerId >= MAX_PLAYERS || !m_slots[playerId]) {
+		return false;
+	}
+	Remove(m_slots[playerId] - 1);
+	return true;
+}
+
+void CPlayerStreamQueue::Add(int index)
+{
+	// copied out first, the slot is reused before the handler runs
+	stPending pending = m_pending[index];
+	Remove(index);
+
+	RPCParameters rpcParams;
+	rpcParams.input = pending.payload;
+	rpcParams.numberOfBitsOfData = pending.bits;
+	rpcParams.sender = m_sender;
+	rpcParams.recipient = m_recipient;
+	rpcParams.replyToSender = nullptr;
+	m_handler(&rpcParams);
+}
+
+bool CPlayerStreamQueue::IsPlayerRPC(int rpcId)
+{
+	return rpcId == RPC_ScrApplyPlayerAnimation || rpcId == RPC_ScrClearPlayerAnimations
+		|| rpcId == RPC_ScrSetPlayerAttachedObject || rpcId == RPC_ScrSetPlayerSkin
+		|| rpcId == RPC_ScrPlayerSpectatePlayer;
+}
+
+void CPlayerStreamQueue::NeedsPlayer(int rpcId, const unsigned char* payload, uint32_t size)
+{
+	if(!m_nPending || !IsPlayerRPC(rpcId) || size < sizeof(uint16_t)) {
+		return;
+	}
+	// all of them lead with the player id, SetPlayerSkin as the low half of an int
+	uint16_t playerId;
+	memcpy(&playerId, payload, sizeof(playerId));
+	if(playerId < MAX_PLAYERS && m_slots[playerId]) {
+		Add(m_slots[playerId] - 1);
+	}
+}
+
+void CPlayerStreamQueue::Schedule()
+{
+	if(m_bScheduled) {
+		return;
+	}
+	m_bScheduled = true;
+	CFrameScheduler::Post(AddBatch);
+}
+
+void CPlayerStreamQueue::AddBatch()
+{
+	m_bScheduled = false;
+	if(!m_nPending) {
+		return;
+	}
+
+	CVector origin;
+	CPlayerPool* pool = CNetGame::GetPlayerPool();
+	CLocalPlayer* player = pool ? pool->GetLocalPlayer() : nullptr;
+	CPlayerPed* ped = player ? player->GetPlayerPed() : nullptr;
+	if(ped) {
+		origin = ped->m_matrix.GetPosition();
+	}
+	// sync keeps coming for a player whose add is waiting, and is newer than the add
+	for(int i = 0; i < m_nPending; i++) {
+		uint16_t playerId = m_pending[i].playerId;
+		if(CPlayerState::IsKnown(playerId)) {
+			m_positions[i] = CVector(CPlayerState::GetPosX()[playerId], CPlayerState::GetPosY()[playerId], CPlayerState::GetPosZ()[playerId]);
+		}
+	}
+	math::DistancesSquared(origin, m_positions, m_nPending, m_distances);
+
+	uint64_t start = NowNs();
+	for(int added = 0; added < ADDS_PER_FRAME && m_nPending; added++)
+	{
+		int nearest = 0;
+		for(int i = 1; i < m_nPending; i++) {
+			if(m_distances[i] < m_distances[nearest]) {
+				nearest = i;
+			}
+		}
+		Add(nearest);
+		if(NowNs() - start >= FRAME_BUDGET_NS) {
+			break;
+		}
+	}
+
+	// posted from inside the scheduler, so it runs on the next frame
+	if(m_nPending) {
+		Schedule();
+	}
+}
+
+void CPlayerStreamQueue::Clear()
+{
+	for(int i = 0; i < m_nPending; i++) {
+		m_slots[m_pending[i].playerId] = 0;
+	}
+	m_nPending = 0;
+}
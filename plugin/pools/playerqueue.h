@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+#include "playerpool.h"
+#include "game/math/vector.h"
+#include "vendor/RakNet/NetworkTypes.h"
+
+// RPC_WorldPlayerAdd payloads waiting for the game's handler. A join or a move into a crowded
+// area streams in dozens of players at once and every add builds a ped, so the adds are
+// queued and handed to the handler a few per frame from a CFrameScheduler task, nearest to
+// the local player first, by their latest sync where one came in since. A remove for a player
+// still waiting cancels both, as does the player quitting, and an RPC that acts on a waiting
+// player's ped streams it in first (see NeedsPlayer). RPC_ServerJoin isn't queued: it only
+// fills the pool entry, which chat, names and everything else look up straight away. Game
+// thread only.
+class CPlayerStreamQueue
+{
+public:
+	// converted WorldPlayerAdd is well under this; anything longer goes to the handler directly
+	static constexpr uint32_t MAX_PAYLOAD = 64;
+	static constexpr int ADDS_PER_FRAME = 4;
+	static constexpr uint64_t FRAME_BUDGET_NS = 2000000;
+
+	// false when the add has to go to the handler right away
+	static bool Push(const RPCParameters* rpcParams, void (*handler)(RPCParameters*));
+	// a RPC_WorldPlayerRemove or RPC_ServerQuit for a player still queued; true if it was,
+	// nothing to stream out then
+	static bool Cancel(uint16_t playerId);
+	// for RPCs that act on a player's ped: streams in the one they name first
+	static void NeedsPlayer(int rpcId, const unsigned char* payload, uint32_t size);
+	static bool IsPlayerRPC(int rpcId);
+	static int Pending() { return m_nPending; }
+	// the pool they were meant for is gone
+	static void Clear();
+
+private:
+	struct stPending
+	{
+		uint16_t playerId;
+		uint32_t bits;
+		unsigned char payload[MAX_PAYLOAD];
+	};
+
+	static void Schedule();
+	static void AddBatch();
+	static void Add(int index);
+	static void Remove(int index);
+
+	static stPending m_pending[MAX_PLAYERS];
+	// kept apart so distances to all of them go through math::DistancesSquared
+	static CVector m_positions[MAX_PLAYERS];
+	static float m_distances[MAX_PLAYERS];
+	// index + 1 into m_pending by player id, 0 when not queued
+	static uint16_t m_slots[MAX_PLAYERS];
+	static int m_nPending;
+	static void (*m_handler)(RPCParameters*);
+	static RakPeerInterface* m_recipient;
+	static PlayerID m_sender;
+	static bool m_bScheduled;
+};
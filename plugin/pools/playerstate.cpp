@@ -0,0 +1,119 @@
+#include "playerstate.h"
+
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static_assert(MAX_PLAYERS % 4 == 0, "Query runs four players at a time");
+
+alignas(16) float CPlayerState::m_posX[MAX_PLAYERS];
+alignas(16) float CPlayerState::m_posY[MAX_PLAYERS];
+alignas(16) float CPlayerState::m_posZ[MAX_PLAYERS];
+alignas(16) uint32_t CPlayerState::m_updatedMs[MAX_PLAYERS];
+uint16_t CPlayerState::m_vehicleId[MAX_PLAYERS];
+uint8_t CPlayerState::m_health[MAX_PLAYERS];
+uint8_t CPlayerState::m_armour[MAX_PLAYERS];
+
+void CPlayerState::Update(uint16_t playerId, const CVector& pos, uint8_t health, uint8_t armour, uint16_t vehicleId, uint32_t timeMs)
+{
+	if(playerId >= MAX_PLAYERS) {
+		return;
+	}
+	m_posX[playerId] = pos.x;
+	m_posY[playerId] = pos.y;
+	m_posZ[playerId] = pos.z;
+	m_health[playerId] = health;
+	m_armour[playerId] = armour;
+	m_vehicleId[playerId] = vehicleId;
+	m_updatedMs[playerId] = timeMs ? timeMs : 1;
+}
+
+void CPlayerState::Remove(uint16_t playerId)
+{
+	if(playerId < MAX_PLAYERS) {
+		m_updatedMs[playerId] = 0;
+	}
+}
+
+void CPlayerState::Clear()
+{
+	memset(m_updatedMs, 0, sizeof(m_updatedMs));
+}
+
+int CPlayerState::Query(const CVector& center, float radius, uint32_t now, uint32_t maxAgeMs, uint16_t* out, int maxOut)
+{
+	float radiusSq = radius * radius;
+	int n = 0;
+	uint32_t i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	float32x4_t cx = vdupq_n_f32(center.x), cy = vdupq_n_f32(center.y), cz = vdupq_n_f32(center.z);
+	float32x4_t r2 = vdupq_n_f32(radiusSq);
+	uint32x4_t vnow = vdupq_n_u32(now), vage = vdupq_n_u32(maxAgeMs);
+	for(; i < MAX_PLAYERS; i += 4) {
+		float32x4_t dx = vsubq_f32(vld1q_f32(m_posX + i), cx);
+		float32x4_t dy = vsubq_f32(vld1q_f32(m_posY + i), cy);
+		float32x4_t dz = vsubq_f32(vld1q_f32(m_posZ + i), cz);
+		float32x4_t d2 = vmlaq_f32(vmlaq_f32(vmulq_f32(dx, dx), dy, dy), dz, dz);
+		uint32x4_t updated = vld1q_u32(m_updatedMs + i);
+		uint32x4_t hit = vandq_u32(vcleq_f32(d2, r2), vtstq_u32(updated, updated));
+		hit = vandq_u32(hit, vcleq_u32(vsubq_u32(vnow, updated), vage));
+		// most groups of four have nobody in range
+		uint16x4_t lanes = vmovn_u32(hit);
+		if(!vget_lane_u64(vreinterpret_u64_u16(lanes), 0)) {
+			continue;
+		}
+		uint16_t mask[4];
+		vst1_u16(mask, lanes);
+		for(uint32_t lane = 0; lane < 4; lane++) {
+			if(mask[lane]) {
+				if(n == maxOut) {
+					return n;
+				}
+				out[n++] = (uint16_t)(i + lane);
+			}
+		}
+	}
+#elif defined(__SSE2__)
+	__m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+	__m128 r2 = _mm_set1_ps(radiusSq);
+	// SSE2 compares signed only; flipping the top bit orders unsigned values the same way
+	__m128i bias = _mm_set1_epi32((int)0x80000000);
+	__m128i vnow = _mm_set1_epi32((int)now), vage = _mm_xor_si128(_mm_set1_epi32((int)maxAgeMs), bias);
+	for(; i < MAX_PLAYERS; i += 4) {
+		__m128 dx = _mm_sub_ps(_mm_load_ps(m_posX + i), cx);
+		__m128 dy = _mm_sub_ps(_mm_load_ps(m_posY + i), cy);
+		__m128 dz = _mm_sub_ps(_mm_load_ps(m_posZ + i), cz);
+		__m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		__m128i updated = _mm_load_si128((const __m128i*)(m_updatedMs + i));
+		__m128i age = _mm_xor_si128(_mm_sub_epi32(vnow, updated), bias);
+		__m128i stale = _mm_or_si128(_mm_cmpeq_epi32(updated, _mm_setzero_si128()), _mm_cmpgt_epi32(age, vage));
+		int hits = _mm_movemask_ps(_mm_andnot_ps(_mm_castsi128_ps(stale), _mm_cmple_ps(d2, r2)));
+		while(hits) {
+			if(n == maxOut) {
+				return n;
+			}
+			out[n++] = (uint16_t)(i + __builtin_ctz(hits));
+			hits &= hits - 1;
+		}
+	}
+#endif
+	for(; i < MAX_PLAYERS; i++) {
+		if(!m_updatedMs[i] || now - m_updatedMs[i] > maxAgeMs) {
+			continue;
+		}
+		float dx = m_posX[i] - center.x;
+		float dy = m_posY[i] - center.y;
+		float dz = m_posZ[i] - center.z;
+		if(dx * dx + dy * dy + dz * dz <= radiusSq) {
+			if(n == maxOut) {
+				return n;
+			}
+			out[n++] = (uint16_t)i;
+		}
+	}
+	return n;
+}
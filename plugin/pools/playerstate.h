@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+#include "playerpool.h"
+#include "game/math/vector.h"
+
+// What the sync decoders last saw of each remote player, as structure-of-arrays indexed by
+// player id. Overlay and culling code reads these instead of chasing CRemotePlayer ->
+// m_pPlayerPed -> matrix into game memory, and a pass over the whole pool walks contiguous
+// floats, four players per NEON or SSE op. Written from CNetGame::FlushPendingSync with the
+// newest on-foot or in-car sync of each drain, so it runs ahead of what CSyncJitter lets the
+// game show. Game thread only.
+class CPlayerState
+{
+public:
+	static constexpr uint16_t NO_VEHICLE = 0xFFFF;
+
+	// timeMs is RakNet::GetTime(), never 0
+	static void Update(uint16_t playerId, const CVector& pos, uint8_t health, uint8_t armour, uint16_t vehicleId, uint32_t timeMs);
+	static void Remove(uint16_t playerId);
+	static void Clear();
+
+	static bool IsKnown(uint16_t playerId) { return playerId < MAX_PLAYERS && m_updatedMs[playerId] != 0; }
+
+	// MAX_PLAYERS entries each; an unknown player has m_updatedMs 0 and stale values
+	static const float* GetPosX() { return m_posX; }
+	static const float* GetPosY() { return m_posY; }
+	static const float* GetPosZ() { return m_posZ; }
+	static const uint8_t* GetHealth() { return m_health; }
+	static const uint8_t* GetArmour() { return m_armour; }
+	static const uint16_t* GetVehicleId() { return m_vehicleId; }
+	static const uint32_t* GetUpdatedMs() { return m_updatedMs; }
+
+	// ids in ascending order of players heard from within maxAgeMs of now and within radius
+	// of center (3D); writes up to maxOut, returns how many
+	static int Query(const CVector& center, float radius, uint32_t now, uint32_t maxAgeMs, uint16_t* out, int maxOut);
+
+private:
+	alignas(16) static float m_posX[MAX_PLAYERS];
+	alignas(16) static float m_posY[MAX_PLAYERS];
+	alignas(16) static float m_posZ[MAX_PLAYERS];
+	alignas(16) static uint32_t m_updatedMs[MAX_PLAYERS];
+	static uint16_t m_vehicleId[MAX_PLAYERS];
+	static uint8_t m_health[MAX_PLAYERS];
+	static uint8_t m_armour[MAX_PLAYERS];
+};
@@ -0,0 +1,81 @@
+#include "vehiclepool.h"
+
+#include "bindings.h"
+
+uint16_t CVehiclePool::m_driving = 0xFFFF;
+uintptr_t CVehiclePool::m_applied = 0;
+eastl::bitset<MAX_VEHICLES> CVehiclePool::m_activeIds;
+uint16_t CVehiclePool::m_activeList[MAX_VEHICLES];
+uint16_t CVehiclePool::m_activeSlot[MAX_VEHICLES];
+uint16_t CVehiclePool::m_activeCount = 0;
+
+// what every in-car sync used to write: the turn-light state (the field Packet_Turnlights
+// sets on remote vehicles) and the byte that always went with it
+static const struct
+{
+	uint16_t offset;
+	uint8_t value;
+} s_driverFields[] = {
+	{ 0x1C0, 4 },
+	{ 0x1C4, 8 },
+};
+
+uintptr_t CVehiclePool::GetAt(uint16_t vehicleId)
+{
+	uintptr_t pool = g_Game.m_pVehiclePool ? *g_Game.m_pVehiclePool : 0;
+	if(!pool || vehicleId >= MAX_VEHICLES) {
+		return 0;
+	}
+	return ((uintptr_t*)pool)[vehicleId];
+}
+
+void CVehiclePool::MarkActive(uint16_t vehicleId)
+{
+	if(vehicleId >= MAX_VEHICLES || m_activeIds.test(vehicleId)) {
+		return;
+	}
+	m_activeIds.set(vehicleId);
+	m_activeSlot[vehicleId] = m_activeCount;
+	m_activeList[m_activeCount++] = vehicleId;
+}
+
+void CVehiclePool::MarkInactive(uint16_t vehicleId)
+{
+	if(vehicleId >= MAX_VEHICLES || !m_activeIds.test(vehicleId)) {
+		return;
+	}
+	m_activeIds.reset(vehicleId);
+	// move the last id into the hole
+	uint16_t slot = m_activeSlot[vehicleId];
+	uint16_t last = m_activeList[--m_activeCount];
+	m_activeList[slot] = last;
+	m_activeSlot[last] = slot;
+}
+
+void CVehiclePool::OnSpawned(uint16_t vehicleId)
+{
+	MarkActive(vehicleId);
+	if(vehicleId == m_driving) {
+		m_applied = 0;
+	}
+}
+
+void CVehiclePool::Process()
+{
+	uintptr_t vehicle = GetAt(m_driving);
+	if(!vehicle || vehicle == m_applied) {
+		return;
+	}
+	for(const auto& field : s_driverFields) {
+		*(uint8_t*)(vehicle + field.offset) = field.value;
+	}
+	m_applied = vehicle;
+}
+
+void CVehiclePool::Reset()
+{
+	m_driving = 0xFFFF;
+	m_applied = 0;
+	m_activeIds.reset();
+	m_activeCount = 0;
+}
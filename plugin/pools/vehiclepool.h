@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+#include "vendor/EASTL/bitset.h"
+
+#define MAX_VEHICLES 2000
+
+// Typed view of the game's CNetVehiclePool, and the fields the client keeps set on the
+// vehicle it drives. An outgoing in-car sync only reports which vehicle it is for; the
+// fields are written from ProcessNetwork once that vehicle changes or is built again,
+// so the send hook never touches game memory. Also the ids of the vehicles that exist, like
+// CPlayerPool's active players, kept by the WorldVehicleAdd/WorldVehicleRemove fixups so
+// nothing has to walk all MAX_VEHICLES slots. Game thread only.
+class CVehiclePool
+{
+public:
+	// the CVehicle for vehicleId, 0 when there is no pool or no such vehicle
+	static uintptr_t GetAt(uint16_t vehicleId);
+
+	static void MarkActive(uint16_t vehicleId);
+	static void MarkInactive(uint16_t vehicleId);
+	static bool IsActive(uint16_t vehicleId) { return vehicleId < MAX_VEHICLES && m_activeIds.test(vehicleId); }
+	// dense, in no particular order; invalidated by Mark*
+	static const uint16_t* GetActiveIds() { return m_activeList; }
+	static uint16_t GetActiveCount() { return m_activeCount; }
+
+	// the vehicle an outgoing in-car sync is for
+	static void OnDriverSync(uint16_t vehicleId) { m_driving = vehicleId; }
+	// CNetVehiclePool::New built vehicleId; its slot may hold a new CVehicle at the old address
+	static void OnSpawned(uint16_t vehicleId);
+	// writes the driver fields when the driven CVehicle is not the one they were last written to
+	static void Process();
+	// also forgets the active ids
+	static void Reset();
+
+private:
+	static eastl::bitset<MAX_VEHICLES> m_activeIds;
+	static uint16_t m_activeList[MAX_VEHICLES];
+	static uint16_t m_activeSlot[MAX_VEHICLES];
+	static uint16_t m_activeCount;
+	static uint16_t m_driving;
+	static uintptr_t m_applied;
+};
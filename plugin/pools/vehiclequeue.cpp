@@ -0,0 +1,202 @@
+#include "vehiclequeue.h"
+#include "vehiclepool.h"
+
+#include <cstddef>
+#include <string.h>
+#include <time.h>
+
+#include "bindings.h"
+#include "scheduler.h"
+#include "game/CPlayerPed.h"
+#include "game/math/simd.h"
+#include "plugin/netgame.h"
+#include "vendor/RakNet/SAMP/SAMPRPC.h"
+
+CVehicleSpawnQueue::stPending CVehicleSpawnQueue::m_pending[MAX_PENDING];
+CVector CVehicleSpawnQueue::m_positions[MAX_PENDING];
+float CVehicleSpawnQueue::m_distances[MAX_PENDING];
+int CVehicleSpawnQueue::m_nPending = 0;
+bool CVehicleSpawnQueue::m_bScheduled = false;
+
+// what CNetVehiclePool::New reads at the least
+struct NewVehicleFix
+{
+	char VehicleID[2];
+	char iVehicleType[4];
+	char pos[12];
+	char fRotation[4];
+	char color[2];
+	char health[4];
+};
+static_assert(sizeof(NewVehicleFix) <= CVehicleSpawnQueue::MAX_PAYLOAD, "payload slot too small");
+
+static uint64_t NowNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void CVehicleSpawnQueue::SpawnDirect(const unsigned char* payload, uint32_t size)
+{
+	// same layout as CNetVehiclePool::New expects, hand the payload over as is
+	if(size >= sizeof(NewVehicleFix)) {
+		g_Game.CNetVehiclePool__New(*g_Game.m_pVehiclePool, (void*)payload);
+	} else {
+		NewVehicleFix newVehBuff = {0};
+		memcpy(&newVehBuff, payload, size);
+		g_Game.CNetVehiclePool__New(*g_Game.m_pVehiclePool, &newVehBuff);
+	}
+	if(size >= sizeof(uint16_t)) {
+		uint16_t vehicleId;
+		memcpy(&vehicleId, payload, sizeof(vehicleId));
+		CVehiclePool::OnSpawned(vehicleId);
+	}
+}
+
+int CVehicleSpawnQueue::Find(uint16_t vehicleId)
+{
+	for(int i = 0; i < m_nPending; i++) {
+		if(m_pending[i].vehicleId == vehicleId) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+bool CVehicleSpawnQueue::Push(const unsigned char* payload, uint32_t size)
+{
+	if(size < sizeof(uint16_t) || size > MAX_PAYLOAD) {
+		return false;
+	}
+	uint16_t vehicleId;
+	memcpy(&vehicleId, payload, sizeof(vehicleId));
+
+	// a second add for the same id replaces the first, as it would have in the pool
+	int index = Find(vehicleId);
+	if(index < 0) {
+		if(m_nPending == MAX_PENDING) {
+			return false;
+		}
+		index = m_nPending++;
+	}
+	stPending& pending = m_pending[index];
+	pending.vehicleId = vehicleId;
+	memset(pending.payload, 0, sizeof(NewVehicleFix));
+	memcpy(pending.payload, payload, size);
+	pending.size = (uint8_t)(size < sizeof(NewVehicleFix) ? sizeof(NewVehicleFix) : size);
+
+	float pos[3];
+	memcpy(pos, pending.payload + offsetof(NewVehicleFix, pos), sizeof(pos));
+	m_positions[index] = CVector(pos[0], pos[1], pos[2]);
+
+	Schedule();
+	return true;
+}
+
+bool CVehicleSpawnQueue::Cancel(uint16_t vehicleId)
+{
+	int index = Find(vehicleId);
+	if(index < 0) {
+		return false;
+	}
+	m_nPending--;
+	m_pending[index] = m_pending[m_nPending];
+	m_positions[index] = m_positions[m_nPending];
+	return true;
+}
+
+void CVehicleSpawnQueue::Spawn(int index)
+{
+	// copied out first, the slot is reused before New runs
+	stPending pending = m_pending[index];
+	m_nPending--;
+	m_pending[index] = m_pending[m_nPending];
+	m_positions[index] = m_positions[m_nPending];
+	m_distances[index] = m_distances[m_nPending];
+	SpawnDirect(pending.payload, pending.size);
+}
+
+void CVehicleSpawnQueue::SpawnNow(uint16_t vehicleId)
+{
+	int index = Find(vehicleId);
+	if(index >= 0) {
+		Spawn(index);
+	}
+}
+
+bool CVehicleSpawnQueue::IsVehicleRPC(int rpcId)
+{
+	return rpcId == RPC_ScrPutPlayerInVehicle || rpcId == RPC_ScrSetVehiclePos
+		|| rpcId == RPC_ScrSetVehicleZAngle || rpcId == RPC_ScrVehicleParams
+		|| rpcId == RPC_ScrVehicleParamsEx || rpcId == RPC_ScrRespawnVehicle
+		|| rpcId == RPC_ScrLinkVehicle || rpcId == RPC_ScrSetVehicleHealth
+		|| rpcId == RPC_ScrSetVehicleTireStatus || rpcId == RPC_ScrPlayerSpectateVehicle
+		|| rpcId == RPC_ScrAttachTrailerToVehicle || rpcId == RPC_ScrDetachTrailerFromVehicle;
+}
+
+void CVehicleSpawnQueue::NeedsVehicle(int rpcId, const unsigned char* payload, uint32_t size)
+{
+	if(!m_nPending || !IsVehicleRPC(rpcId) || size < sizeof(uint16_t)) {
+		return;
+	}
+	// all of them lead with the vehicle id; the trailer one has the tractor after it
+	uint16_t vehicleId;
+	memcpy(&vehicleId, payload, sizeof(vehicleId));
+	SpawnNow(vehicleId);
+	if(rpcId == RPC_ScrAttachTrailerToVehicle && size >= 2 * sizeof(uint16_t)) {
+		memcpy(&vehicleId, payload + sizeof(uint16_t), sizeof(vehicleId));
+		SpawnNow(vehicleId);
+	}
+}
+
+void CVehicleSpawnQueue::Schedule()
+{
+	if(m_bScheduled) {
+		return;
+	}
+	m_bScheduled = true;
+	CFrameScheduler::Post(SpawnBatch);
+}
+
+void CVehicleSpawnQueue::SpawnBatch()
+{
+	m_bScheduled = false;
+	if(!m_nPending) {
+		return;
+	}
+
+	CVector origin;
+	CPlayerPool* pool = CNetGame::GetPlayerPool();
+	CLocalPlayer* player = pool ? pool->GetLocalPlayer() : nullptr;
+	CPlayerPed* ped = player ? player->GetPlayerPed() : nullptr;
+	if(ped) {
+		origin = ped->m_matrix.GetPosition();
+	}
+	math::DistancesSquared(origin, m_positions, m_nPending, m_distances);
+
+	uint64_t start = NowNs();
+	for(int spawned = 0; spawned < SPAWNS_PER_FRAME && m_nPending; spawned++)
+	{
+		int nearest = 0;
+		for(int i = 1; i < m_nPending; i++) {
+			if(m_distances[i] < m_distances[nearest]) {
+				nearest = i;
+			}
+		}
+		Spawn(nearest);
+		if(NowNs() - start >= FRAME_BUDGET_NS) {
+			break;
+		}
+	}
+
+	// posted from inside the scheduler, so it runs on the next frame
+	if(m_nPending) {
+		Schedule();
+	}
+}
+
+void CVehicleSpawnQueue::Clear()
+{
+	m_nPending = 0;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+#include "game/math/vector.h"
+
+// RPC_WorldVehicleAdd payloads waiting to become vehicles. Streaming into a busy area
+// brings hundreds at once and every CNetVehiclePool::New builds a whole vehicle, so
+// instead of creating them inside the RPC handler they are queued and spawned a few per
+// frame from a CFrameScheduler task, nearest to the local player first. An RPC that
+// needs one of them in the pool (see NeedsVehicle) spawns it on the spot. Game thread only.
+class CVehicleSpawnQueue
+{
+public:
+	static constexpr int MAX_PENDING = 2000;
+	// padded up to NewVehicleFix when shorter; anything longer than this is spawned directly
+	static constexpr uint32_t MAX_PAYLOAD = 64;
+	static constexpr int SPAWNS_PER_FRAME = 8;
+	static constexpr uint64_t FRAME_BUDGET_NS = 2000000;
+
+	// false when the payload has to be spawned right away (queue full, too long, too short)
+	static bool Push(const unsigned char* payload, uint32_t size);
+	// CNetVehiclePool::New with a short payload padded out
+	static void SpawnDirect(const unsigned char* payload, uint32_t size);
+	// a RPC_WorldVehicleRemove for a vehicle still queued; true if it was, nothing to remove then
+	static bool Cancel(uint16_t vehicleId);
+	// spawns vehicleId now if it is waiting
+	static void SpawnNow(uint16_t vehicleId);
+	// for RPCs that act on a vehicle: spawns the ones they name first
+	static void NeedsVehicle(int rpcId, const unsigned char* payload, uint32_t size);
+	static bool IsVehicleRPC(int rpcId);
+	static int Pending() { return m_nPending; }
+	// the pool they were meant for is gone
+	static void Clear();
+
+private:
+	struct stPending
+	{
+		uint16_t vehicleId;
+		uint8_t size;
+		unsigned char payload[MAX_PAYLOAD];
+	};
+
+	static void Schedule();
+	static void SpawnBatch();
+	static void Spawn(int index);
+	static int Find(uint16_t vehicleId);
+
+	static stPending m_pending[MAX_PENDING];
+	// kept apart so distances to all of them go through math::DistancesSquared
+	static CVector m_positions[MAX_PENDING];
+	static float m_distances[MAX_PENDING];
+	static int m_nPending;
+	static bool m_bScheduled;
+};
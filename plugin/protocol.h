@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common.h"
+
+// Wire protocol versions as types. What differs between two BR client builds or two SA-MP
+// versions is a constant or a typedef on its tag, and the sync converters (CPacketTranslator's
+// sync translators, the DecodeOnFootSync family) are templates over a <BR, SAMP> pair: every
+// pair gets its own fully specialised encode and decode, with no version check per packet.
+// Supporting another build is another tag, plus the instantiations for its pair.
+//
+// HEALTH_BYTES: width of health and armour in the outbound syncs, little endian
+// INCAR_TRAIN_SPEED: the in-car sync ends in a float train speed
+// PASSENGER_SEAT_SHIFT: where the 7 seat flag bits start in the passenger sync's seat byte
+
+// BR client as of this plugin: what the game hands us and what CRemotePlayer takes
+struct stBRProtocol1
+{
+	typedef BROnFootSyncData OnFootSync;
+	typedef BRInCarSyncData InCarSync;
+
+	static constexpr uint32_t HEALTH_BYTES = 2;
+	static constexpr bool INCAR_TRAIN_SPEED = false;
+	static constexpr uint32_t PASSENGER_SEAT_SHIFT = 1;
+};
+
+// SA-MP 0.3.7
+struct stSampProtocol037
+{
+	static constexpr int NETGAME_VERSION = 4057;
+
+	static constexpr uint32_t HEALTH_BYTES = 1;
+	static constexpr bool INCAR_TRAIN_SPEED = true;
+	static constexpr uint32_t PASSENGER_SEAT_SHIFT = 0;
+	// inbound, the server relays health and armour as a nibble each in one byte
+	static constexpr bool PACKED_HEALTH_ARMOUR = true;
+};
+
+// the pair this build talks
+typedef stBRProtocol1 BRProtocol;
+typedef stSampProtocol037 SampProtocol;
+
+// Byte aligned sync payload sizes (the bytes following the packet id) of either side
+template<typename PROTOCOL>
+struct stSyncPayload
+{
+	// lr16 ud16 keys16 pos96 quat128 | health armour | weapon8 action8 move96 surf96 surfinfo16 anim32
+	static constexpr uint32_t ONFOOT_HEAD = 34;
+	static constexpr uint32_t ONFOOT_TAIL = 32;
+	static constexpr uint32_t ONFOOT = ONFOOT_HEAD + 2 * PROTOCOL::HEALTH_BYTES + ONFOOT_TAIL;
+
+	// vehid16 lr16 ud16 keys16 quat128 pos96 move96 carhealth32 | health armour | weapon8 siren8 gear8 trailer16 [trainspeed32]
+	static constexpr uint32_t INCAR_HEAD = 52;
+	static constexpr uint32_t INCAR_TAIL = 5;
+	static constexpr uint32_t INCAR_TRAIN = INCAR_HEAD + 2 * PROTOCOL::HEALTH_BYTES + INCAR_TAIL;
+	static constexpr uint32_t INCAR = INCAR_TRAIN + (PROTOCOL::INCAR_TRAIN_SPEED ? 4 : 0);
+
+	// vehid16 seat8 weapon8 | health armour | lr16 ud16 keys16 pos96
+	static constexpr uint32_t PASSENGER_HEAD = 4;
+	static constexpr uint32_t PASSENGER_TAIL = 18;
+	static constexpr uint32_t PASSENGER = PASSENGER_HEAD + 2 * PROTOCOL::HEALTH_BYTES + PASSENGER_TAIL;
+};
@@ -0,0 +1,159 @@
+#include "reconnect.h"
+#include "netgame.h"
+#include "config.h"
+#include "resolver.h"
+#include "tracering.h"
+#include "scheduler.h"
+#include "serverquery.h"
+#include "telemetry.h"
+#include "vendor/RakNet/GetTime.h"
+
+#include <random>
+
+std::vector<CReconnect::stEndpointState> CReconnect::m_endpoints;
+uint32_t CReconnect::m_generation = 0;
+
+static uint32_t Jitter(uint32_t range)
+{
+	// seeded from the entropy pool, not the clock: clients restarted together would stay in step
+	static std::minstd_rand engine(std::random_device{}());
+	return range ? (uint32_t)(engine() % (range + 1)) : 0;
+}
+
+// the clock wraps, so a never-failed endpoint can't rely on retryAt being in the past
+static bool IsDue(uint32_t failures, uint32_t retryAt, uint32_t now)
+{
+	return failures == 0 || (int32_t)(now - retryAt) >= 0;
+}
+
+void CReconnect::Sync()
+{
+	size_t count = CConfig::Get().endpoints.size();
+	if(m_endpoints.size() != count) {
+		m_endpoints.assign(count, stEndpointState{ 0, 0, false });
+	}
+}
+
+void CReconnect::SelectEndpoints(std::vector<const char*>* hosts, std::vector<unsigned short>* ports)
+{
+	const CConfig::stSettings& config = CConfig::Get();
+	Sync();
+
+	uint32_t now = RakNet::GetTime();
+	bool anyDue = false;
+	for(const stEndpointState& endpoint : m_endpoints) {
+		anyDue |= IsDue(endpoint.failures, endpoint.retryAt, now);
+	}
+
+	std::vector<size_t> due;
+	for(size_t i = 0; i < m_endpoints.size(); i++)
+	{
+		m_endpoints[i].raced = false;
+		if(!anyDue || IsDue(m_endpoints[i].failures, m_endpoints[i].retryAt, now)) {
+			due.push_back(i);
+		}
+	}
+	// of those, the closest and least loaded by the last query round
+	CServerQuery::Rank(&due);
+	for(size_t i : due)
+	{
+		m_endpoints[i].raced = true;
+		hosts->push_back(config.endpoints[i].host.c_str());
+		ports->push_back(config.endpoints[i].port);
+	}
+}
+
+int CReconnect::Find(PlayerID server)
+{
+	const CConfig::stSettings& config = CConfig::Get();
+	for(size_t i = 0; i < m_endpoints.size(); i++)
+	{
+		// a name is matched by the address its last lookup gave
+		if(config.endpoints[i].port == server.port && CResolver::Cached(config.endpoints[i].host.c_str()) == server.binaryAddress) {
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+void CReconnect::Fail(stEndpointState& endpoint, uint32_t now)
+{
+	const CConfig::stSettings& config = CConfig::Get();
+	if(endpoint.failures < 31) {
+		endpoint.failures++;
+	}
+
+	uint64_t window = (uint64_t)config.reconnectBaseMs << (endpoint.failures - 1);
+	if(window > config.reconnectMaxMs) {
+		window = config.reconnectMaxMs;
+	}
+	// equal jitter: never sooner than half the window, so the backoff still grows
+	uint32_t half = (uint32_t)(window / 2);
+	endpoint.retryAt = now + half + Jitter((uint32_t)window - half);
+}
+
+void CReconnect::OnAttemptFailed()
+{
+	Sync();
+	uint32_t now = RakNet::GetTime();
+	for(stEndpointState& endpoint : m_endpoints) {
+		if(endpoint.raced) {
+			Fail(endpoint, now);
+		}
+	}
+	Schedule();
+}
+
+void CReconnect::OnRefused(PlayerID server)
+{
+	Sync();
+	int index = Find(server);
+	if(index < 0) {
+		OnAttemptFailed();
+		return;
+	}
+	Fail(m_endpoints[index], RakNet::GetTime());
+	Schedule();
+}
+
+void CReconnect::OnConnected(PlayerID server)
+{
+	Sync();
+	int index = Find(server);
+	for(size_t i = 0; i < m_endpoints.size(); i++) {
+		// an unknown server still means whatever we raced is reachable
+		if(index < 0 ? m_endpoints[i].raced : (int)i == index) {
+			m_endpoints[i].failures = 0;
+			m_endpoints[i].retryAt = 0;
+		}
+	}
+	m_generation++;
+}
+
+void CReconnect::Schedule()
+{
+	if(m_endpoints.empty()) {
+		return;
+	}
+
+	uint32_t now = RakNet::GetTime();
+	uint32_t delay = UINT32_MAX;
+	for(const stEndpointState& endpoint : m_endpoints)
+	{
+		uint32_t wait = IsDue(endpoint.failures, endpoint.retryAt, now) ? 0 : endpoint.retryAt - now;
+		if(wait < delay) {
+			delay = wait;
+		}
+	}
+
+	CTraceRing::Trace(TRACE_RECONNECT, delay, (uint32_t)m_endpoints.size());
+	CTelemetry::Count(TELEMETRY_RECONNECT);
+	// parked until the wait is over; WAIT_CONNECT is what makes the game connect again
+	CNetGame::SetGameState(GAMESTATE_DISCONNECTED);
+	uint32_t generation = ++m_generation;
+	CFrameScheduler::PostAfter(delay, [generation] {
+		if(generation == m_generation && CNetGame::GetGameState() == GAMESTATE_DISCONNECTED) {
+			CNetGame::SetGameState(GAMESTATE_WAIT_CONNECT);
+		}
+	});
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vendor/RakNet/NetworkTypes.h"
+
+// Paces reconnects after a failed connect so a server restart isn't met by every client at
+// once. Each configured endpoint backs off on its own, doubling from reconnectBaseMs up to
+// reconnectMaxMs with a random half of the window as jitter, and the next attempt races only
+// the endpoints that are due, ranked by CServerQuery. Game thread only.
+class CReconnect
+{
+public:
+	// What the next connect should race, best first. Falls back to every endpoint when none is due yet.
+	static void SelectEndpoints(std::vector<const char*>* hosts, std::vector<unsigned short>* ports);
+
+	// Every raced endpoint failed to answer
+	static void OnAttemptFailed();
+	// The server that answered turned us away; blamed on it alone when it is one of ours
+	static void OnRefused(PlayerID server);
+	static void OnConnected(PlayerID server);
+
+private:
+	struct stEndpointState
+	{
+		uint32_t failures;
+		uint32_t retryAt;
+		bool raced;
+	};
+
+	static void Sync();
+	static void Fail(stEndpointState& endpoint, uint32_t now);
+	static void Schedule();
+	static int Find(PlayerID server);
+
+	static std::vector<stEndpointState> m_endpoints;
+	// bumped per schedule, so a superseded wait can't flip the state later
+	static uint32_t m_generation;
+};
@@ -0,0 +1,105 @@
+#include "resolver.h"
+#include "workers.h"
+#include "xorstr.h"
+#include "vendor/RakNet/GetTime.h"
+
+#include <android/log.h>
+#include <arpa/inet.h>
+#include <memory>
+#include <netdb.h>
+#include <string.h>
+
+std::unordered_map<std::string, CResolver::stEntry> CResolver::m_entries;
+uint32_t CResolver::m_nPending = 0;
+bool CResolver::m_bFailed = false;
+std::function<void(bool)> CResolver::m_idle;
+
+bool CResolver::Lookup(const char* host, char out[16])
+{
+	in_addr numeric;
+	if(inet_pton(AF_INET, host, &numeric) == 1) {
+		inet_ntop(AF_INET, &numeric, out, 16);
+		return true;
+	}
+
+	stEntry& entry = m_entries.try_emplace(host, stEntry{ {}, INADDR_NONE, 0, false }).first->second;
+	bool known = entry.address[0] != '\0';
+	if(!entry.pending && (!known || (int32_t)(RakNet::GetTime() - entry.expiresAt) >= 0)) {
+		Start(host, entry);
+	}
+	if(known) {
+		memcpy(out, entry.address, sizeof(entry.address));
+	}
+	return known;
+}
+
+uint32_t CResolver::Cached(const char* host)
+{
+	in_addr numeric;
+	if(inet_pton(AF_INET, host, &numeric) == 1) {
+		return numeric.s_addr;
+	}
+	auto it = m_entries.find(host);
+	return it != m_entries.end() ? it->second.binaryAddress : INADDR_NONE;
+}
+
+void CResolver::OnIdle(std::function<void(bool ok)> callback)
+{
+	if(!m_nPending) {
+		callback(true);
+		return;
+	}
+	m_idle = std::move(callback);
+}
+
+void CResolver::Start(const std::string& host, stEntry& entry)
+{
+	entry.pending = true;
+	m_nPending++;
+
+	// the map isn't touched off the game thread; the worker only fills in result
+	auto result = std::make_shared<in_addr>();
+	result->s_addr = INADDR_NONE;
+	CWorkers::Submit([host, result] {
+		addrinfo hints = {};
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_DGRAM;
+		addrinfo* list = nullptr;
+		int error = getaddrinfo(host.c_str(), nullptr, &hints, &list);
+		if(error == 0 && list) {
+			*result = ((const sockaddr_in*)list->ai_addr)->sin_addr;
+		}
+		else {
+			__android_log_print(ANDROID_LOG_ERROR, xorstr("Resolver"), xorstr("%s: %s"), host.c_str(), gai_strerror(error));
+		}
+		if(list) {
+			freeaddrinfo(list);
+		}
+	}, [host, result] {
+		stEntry& entry = m_entries[host];
+		entry.pending = false;
+		bool ok = result->s_addr != INADDR_NONE;
+		if(ok) {
+			inet_ntop(AF_INET, result.get(), entry.address, sizeof(entry.address));
+			entry.binaryAddress = result->s_addr;
+			entry.expiresAt = RakNet::GetTime() + TTL_MS;
+		}
+		// a failed refresh keeps the old address until the next connect tries again
+		Finish(ok);
+	});
+}
+
+void CResolver::Finish(bool ok)
+{
+	m_bFailed |= !ok;
+	if(--m_nPending) {
+		return;
+	}
+	bool failed = m_bFailed;
+	m_bFailed = false;
+	if(m_idle) {
+		std::function<void(bool)> idle = std::move(m_idle);
+		m_idle = nullptr;
+		idle(!failed);
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+// Endpoint names resolved off the game thread. A connect asks for every host it races; numeric
+// ones answer at once, names come from the cache or start a getaddrinfo on CWorkers and the
+// connect waits for it instead of blocking a frame in RakNet's gethostbyname. getaddrinfo doesn't
+// report the record's TTL, so entries live TTL_MS; an expired one is still handed out while a
+// fresh lookup runs, which keeps reconnects off DNS entirely. Game thread only.
+class CResolver
+{
+public:
+	static constexpr uint32_t TTL_MS = 5 * 60 * 1000;
+
+	// true with the dotted address in out, false while the name is being looked up
+	static bool Lookup(const char* host, char out[16]);
+	// what Lookup would give without starting anything; INADDR_NONE when unknown
+	static uint32_t Cached(const char* host);
+	// runs once every lookup in flight has finished; ok is false if one of them failed
+	static void OnIdle(std::function<void(bool ok)> callback);
+
+private:
+	struct stEntry
+	{
+		char address[16];	// empty until a lookup succeeds
+		uint32_t binaryAddress;
+		uint32_t expiresAt;
+		bool pending;
+	};
+
+	static void Start(const std::string& host, stEntry& entry);
+	static void Finish(bool ok);
+
+	static std::unordered_map<std::string, stEntry> m_entries;
+	static uint32_t m_nPending;
+	static bool m_bFailed;
+	static std::function<void(bool)> m_idle;
+};
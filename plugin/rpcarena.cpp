@@ -0,0 +1,4 @@
+#include "rpcarena.h"
+
+alignas(8) thread_local unsigned char CRPCArena::m_buffer[CRPCArena::SIZE];
+thread_local uint32_t CRPCArena::m_used = 0;
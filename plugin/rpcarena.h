@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+// Per-thread scratch memory for rewritten RPC payloads and outgoing RPCs. FixBrokenRPC
+// opens a Scope around each fixup, so anything it allocates stays valid until the
+// handler returns and is recycled for the next RPC.
+class CRPCArena
+{
+public:
+	static constexpr uint32_t SIZE = 4096;
+
+	class Scope
+	{
+	public:
+		Scope() : m_mark(m_used) {}
+		~Scope() { m_used = m_mark; }
+	private:
+		uint32_t m_mark;
+	};
+
+	// 8-byte aligned, NULL once the arena is exhausted
+	static unsigned char* Alloc(uint32_t size)
+	{
+		uint32_t offset = (m_used + 7) & ~7u;
+		if(offset + size > SIZE) {
+			return nullptr;
+		}
+		m_used = offset + size;
+		return m_buffer + offset;
+	}
+private:
+	alignas(8) static thread_local unsigned char m_buffer[SIZE];
+	static thread_local uint32_t m_used;
+};
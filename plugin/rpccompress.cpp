@@ -0,0 +1,72 @@
+#include "rpccompress.h"
+#include "capabilities.h"
+#include "lz4.h"
+#include "config.h"
+#include "vendor/RakNet/PacketEnumerations.h"
+#include "vendor/RakNet/SAMP/SAMPRPC.h"
+
+// rpcId and numberOfBitsOfData ahead of the block
+static constexpr uint32_t HEADER_SIZE = sizeof(uint8_t) + sizeof(uint32_t);
+
+std::vector<unsigned char> CRPCCompression::m_packed;
+std::vector<unsigned char> CRPCCompression::m_payload;
+RakNet::BitStream CRPCCompression::m_unpacked;
+
+const RakNet::BitStream* CRPCCompression::Unpack(RakNet::BitStream* in, uint32_t bits)
+{
+	uint32_t size = BITS_TO_BYTES(bits);
+	if(!CCapabilities::Has(CCapabilities::CAP_LZ4) || size <= HEADER_SIZE || size > lz4::Bound(MAX_PAYLOAD) + HEADER_SIZE) {
+		return nullptr;
+	}
+	m_packed.resize(size);
+	if(!in->ReadBits(m_packed.data(), bits, false)) {
+		return nullptr;
+	}
+
+	RakNet::BitStream bsHeader(m_packed.data(), HEADER_SIZE, false);
+	uint8_t rpcId;
+	uint32_t innerBits;
+	bsHeader.Read(rpcId);
+	bsHeader.Read(innerBits);
+	uint32_t innerSize = BITS_TO_BYTES(innerBits);
+	// one level only, a compressed RPC can't stand for another
+	if(rpcId == RPC_Compressed || !innerBits || innerSize > MAX_PAYLOAD) {
+		return nullptr;
+	}
+	m_payload.resize(innerSize);
+	if(lz4::Decompress(m_packed.data() + HEADER_SIZE, size - HEADER_SIZE, m_payload.data(), innerSize) != innerSize) {
+		return nullptr;
+	}
+
+	// laid out the way RakPeer::RPC writes an RPC
+	m_unpacked.Reset();
+	m_unpacked.Write((unsigned char)ID_RPC);
+	m_unpacked.Write(rpcId);
+	m_unpacked.WriteCompressed(innerBits);
+	m_unpacked.WriteBits(m_payload.data(), innerBits, false);
+	return &m_unpacked;
+}
+
+bool CRPCCompression::IsWorthPacking(int rpcId, uint32_t bits)
+{
+	uint32_t size = BITS_TO_BYTES(bits);
+	return CCapabilities::Has(CCapabilities::CAP_LZ4) && rpcId != RPC_Compressed && size >= CConfig::Get().compressAbove && size > HEADER_SIZE + 1 && size <= MAX_PAYLOAD;
+}
+
+bool CRPCCompression::Pack(int rpcId, const unsigned char* data, uint32_t bits, RakNet::BitStream* out)
+{
+	if(!IsWorthPacking(rpcId, bits)) {
+		return false;
+	}
+	uint32_t size = BITS_TO_BYTES(bits);
+	// no room for anything that wouldn't save at least a byte after the header
+	m_packed.resize(size);
+	uint32_t packed = lz4::Compress(data, size, m_packed.data(), size - HEADER_SIZE - 1);
+	if(!packed) {
+		return false;
+	}
+	out->Write((uint8_t)rpcId);
+	out->Write(bits);
+	out->Write((const char*)m_packed.data(), packed);
+	return true;
+}
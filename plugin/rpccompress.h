@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vendor/RakNet/BitStream.h"
+
+// LZ4 for the large RPCs (InitGame, long dialogs, textdraw and object floods) that make up
+// most of a join, with CAP_LZ4. Either side may then send an RPC whose payload is at or above
+// the offered threshold as RPC_Compressed:
+//
+//   uint8 rpcId, uint32 numberOfBitsOfData, then the payload as one LZ4 block
+//
+// RakPeer::HandleRPCPacket unpacks it and dispatches the RPC it stands for, so the stats, the
+// capture and FixBrokenRPC see the original; RakPeer::RPC packs outgoing ones. Game thread only.
+class CRPCCompression
+{
+public:
+	// decoded payloads above this are refused as malformed
+	static constexpr uint32_t MAX_PAYLOAD = 256 * 1024;
+
+	// the plain ID_RPC packet an RPC_Compressed payload stands for, NULL when it is malformed
+	// or was never negotiated; valid until the next call
+	static const RakNet::BitStream* Unpack(RakNet::BitStream* in, uint32_t bits);
+	// true when an RPC of this id and length would go out compressed, so long as LZ4 saves a byte
+	static bool IsWorthPacking(int rpcId, uint32_t bits);
+	// true with the RPC_Compressed payload in out when rpcId is worth sending compressed
+	static bool Pack(int rpcId, const unsigned char* data, uint32_t bits, RakNet::BitStream* out);
+
+private:
+	static std::vector<unsigned char> m_packed;
+	static std::vector<unsigned char> m_payload;
+	static RakNet::BitStream m_unpacked;
+};
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstdint>
+#include <string.h>
+
+// BR -> SA-MP RPC payload rewrites, declared as the list of steps that walk both layouts
+// side by side. The converter, its length check and its output size follow from the list
+// at compile time, so a layout is written down once instead of as paired reads and writes:
+//
+//   RpcCopy<N>        N bytes both protocols carry alike
+//   RpcDrop<N>        N bytes only BR sends
+//   RpcInsert<VALUE>  VALUE::value, which only SA-MP expects
+//   RpcTail<N, FILL>  the last N bytes, which older BR servers leave off; FILL stands in
+//
+// Every field on both sides is byte aligned. An RPC without a layout is the same on both
+// sides and reaches the game as it came. A layout whose output never overtakes its input
+// is rewritten in the input buffer itself; the rest need a buffer of OUT bytes.
+template<uint32_t N>
+struct RpcCopy
+{
+	static constexpr uint32_t IN = N, OUT = N, OPTIONAL = 0;
+
+	static inline void Convert(const uint8_t*& in, const uint8_t* end, uint8_t*& out)
+	{
+		memmove(out, in, N);
+		in += N;
+		out += N;
+	}
+};
+
+template<uint32_t N>
+struct RpcDrop
+{
+	static constexpr uint32_t IN = N, OUT = 0, OPTIONAL = 0;
+
+	static inline void Convert(const uint8_t*& in, const uint8_t* end, uint8_t*& out)
+	{
+		in += N;
+	}
+};
+
+template<typename VALUE>
+struct RpcInsert
+{
+	static constexpr uint32_t IN = 0, OUT = sizeof(VALUE::value), OPTIONAL = 0;
+
+	static inline void Convert(const uint8_t*& in, const uint8_t* end, uint8_t*& out)
+	{
+		memcpy(out, &VALUE::value, OUT);
+		out += OUT;
+	}
+};
+
+template<uint32_t N, uint8_t FILL>
+struct RpcTail
+{
+	static constexpr uint32_t IN = N, OUT = N, OPTIONAL = N;
+
+	static inline void Convert(const uint8_t*& in, const uint8_t* end, uint8_t*& out)
+	{
+		if((uint32_t)(end - in) >= N) {
+			memmove(out, in, N);
+		} else {
+			memset(out, FILL, N);
+		}
+		in += N;
+		out += N;
+	}
+};
+
+template<typename... STEPS>
+struct RpcLayout
+{
+	static constexpr uint32_t IN_MAX = (0 + ... + STEPS::IN);
+	static constexpr uint32_t IN_MIN = IN_MAX - (0 + ... + STEPS::OPTIONAL);
+	static constexpr uint32_t OUT = (0 + ... + STEPS::OUT);
+
+private:
+	// nothing read from the input may follow a step that can be left off
+	static constexpr bool CheckTail()
+	{
+		constexpr uint32_t in[] = { STEPS::IN... };
+		constexpr uint32_t optional[] = { STEPS::OPTIONAL... };
+		bool tail = false;
+		for(uint32_t i = 0; i < sizeof...(STEPS); i++) {
+			if(tail && in[i]) {
+				return false;
+			}
+			tail = tail || optional[i];
+		}
+		return true;
+	}
+
+	// every step writes no further into the buffer than it has read, and the whole
+	// output fits in the shortest input
+	static constexpr bool CheckInPlace()
+	{
+		constexpr uint32_t in[] = { STEPS::IN... };
+		constexpr uint32_t out[] = { STEPS::OUT... };
+		uint32_t read = 0, written = 0;
+		for(uint32_t i = 0; i < sizeof...(STEPS); i++) {
+			written += out[i];
+			if(written > read + in[i]) {
+				return false;
+			}
+			read += in[i];
+		}
+		return OUT <= IN_MIN;
+	}
+
+public:
+	static constexpr bool IN_PLACE = CheckInPlace();
+
+	static_assert(sizeof...(STEPS) > 0, "empty rpc layout");
+	static_assert(CheckTail(), "only the input's last bytes can be left off");
+
+	// returns the SA-MP length, 0 when in is shorter than the layout; out may be in when IN_PLACE
+	static uint32_t Convert(const uint8_t* in, uint32_t inLen, uint8_t* out)
+	{
+		if(inLen < IN_MIN) {
+			return 0;
+		}
+		const uint8_t* end = in + inLen;
+		(STEPS::Convert(in, end, out), ...);
+		return OUT;
+	}
+};
+
+// a layout behind a plain pointer, for tables keyed by RPC id
+struct stRpcConversion
+{
+	uint32_t (*convert)(const uint8_t* in, uint32_t inLen, uint8_t* out);
+	uint32_t outSize;
+	bool inPlace;
+};
+
+template<typename LAYOUT>
+constexpr stRpcConversion MakeRpcConversion()
+{
+	return { LAYOUT::Convert, LAYOUT::OUT, LAYOUT::IN_PLACE };
+}
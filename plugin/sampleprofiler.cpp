@@ -0,0 +1,363 @@
+#include "sampleprofiler.h"
+#include "config.h"
+#include "featureflags.h"
+#include "workers.h"
+#include "xorstr.h"
+
+#include <algorithm>
+#include <android/log.h>
+#include <dlfcn.h>
+#include <link.h>
+#include <memory>
+#include <stdio.h>
+#include <string>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <time.h>
+#include <ucontext.h>
+#include <vector>
+
+#include "vendor/imgui/imgui.h"
+
+std::atomic<bool> CSampleProfiler::m_running(false);
+
+struct stProfiledModule
+{
+	char name[64];
+	uintptr_t bias;		// dlpi_addr, offsets are against it
+	uintptr_t start;	// the executable segments
+	uintptr_t end;
+	uint32_t* buckets;	// (end - start) >> BUCKET_SHIFT of them, mmap'd
+	size_t mapped;
+};
+
+static stProfiledModule g_modules[PROFILED_MODULE_COUNT];
+static std::atomic<uint32_t> g_samples(0);
+static std::atomic<uint32_t> g_outside(0);
+static struct sigaction g_previousAction;
+static bool g_handlerInstalled = false;
+static uint32_t g_hz = 0;
+
+struct stModuleSearch
+{
+	const char* pluginPath;
+	int found;
+};
+
+static void ReadModule(struct dl_phdr_info* info, stProfiledModule* module)
+{
+	uintptr_t start = UINTPTR_MAX, end = 0;
+	for(int i = 0; i < info->dlpi_phnum; i++)
+	{
+		const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+		if(phdr.p_type == PT_LOAD && (phdr.p_flags & PF_X)) {
+			start = std::min(start, (uintptr_t)(info->dlpi_addr + phdr.p_vaddr));
+			end = std::max(end, (uintptr_t)(info->dlpi_addr + phdr.p_vaddr + phdr.p_memsz));
+		}
+	}
+	if(end <= start) {
+		return;
+	}
+	const char* name = strrchr(info->dlpi_name, '/');
+	snprintf(module->name, sizeof(module->name), "%s", name ? name + 1 : info->dlpi_name);
+	module->bias = info->dlpi_addr;
+	module->start = start;
+	module->end = end;
+}
+
+static int FindModules(struct dl_phdr_info* info, size_t size, void* data)
+{
+	stModuleSearch* search = (stModuleSearch*)data;
+	if(!info->dlpi_name) {
+		return 0;
+	}
+	if(!g_modules[PROFILED_PLUGIN].end && !strcmp(info->dlpi_name, search->pluginPath)) {
+		ReadModule(info, &g_modules[PROFILED_PLUGIN]);
+		search->found++;
+	} else if(!g_modules[PROFILED_GAME].end && strstr(info->dlpi_name, xorstr_cached("libblackrussia-client.so"))) {
+		ReadModule(info, &g_modules[PROFILED_GAME]);
+		search->found++;
+	}
+	return search->found == PROFILED_MODULE_COUNT;
+}
+
+// modules never unload, so they are looked up and their histograms mapped once
+static bool MapModules()
+{
+	if(g_modules[PROFILED_PLUGIN].buckets) {
+		return true;
+	}
+	Dl_info self;
+	if(!dladdr((void*)&CSampleProfiler::Start, &self) || !self.dli_fname) {
+		return false;
+	}
+	stModuleSearch search = { self.dli_fname, 0 };
+	dl_iterate_phdr(FindModules, &search);
+	for(stProfiledModule& module : g_modules)
+	{
+		if(!module.end) {
+			continue;
+		}
+		module.mapped = (((module.end - module.start) >> CSampleProfiler::BUCKET_SHIFT) + 1) * sizeof(uint32_t);
+		void* buckets = mmap(nullptr, module.mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		module.buckets = buckets == MAP_FAILED ? nullptr : (uint32_t*)buckets;
+	}
+	return g_modules[PROFILED_PLUGIN].buckets != nullptr;
+}
+
+static inline uintptr_t InterruptedPc(void* context)
+{
+	const ucontext_t* uc = (const ucontext_t*)context;
+#if defined(__aarch64__)
+	return (uintptr_t)uc->uc_mcontext.pc;
+#elif defined(__arm__)
+	return (uintptr_t)uc->uc_mcontext.arm_pc;
+#elif defined(__x86_64__)
+	return (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+#elif defined(__i386__)
+	return (uintptr_t)uc->uc_mcontext.gregs[REG_EIP];
+#else
+	return 0;
+#endif
+}
+
+// async-signal-safe: a few compares and relaxed adds
+void CSampleProfiler::OnSignal(int signal, siginfo_t* info, void* context)
+{
+	if(!m_running.load(std::memory_order_relaxed)) {
+		// not our timer, whoever had SIGPROF before gets it
+		if(g_previousAction.sa_flags & SA_SIGINFO) {
+			g_previousAction.sa_sigaction(signal, info, context);
+		} else if(g_previousAction.sa_handler != SIG_DFL && g_previousAction.sa_handler != SIG_IGN) {
+			g_previousAction.sa_handler(signal);
+		}
+		return;
+	}
+	g_samples.fetch_add(1, std::memory_order_relaxed);
+	uintptr_t pc = InterruptedPc(context);
+	for(const stProfiledModule& module : g_modules)
+	{
+		if(module.buckets && pc >= module.start && pc < module.end) {
+			__atomic_fetch_add(&module.buckets[(pc - module.start) >> BUCKET_SHIFT], 1, __ATOMIC_RELAXED);
+			return;
+		}
+	}
+	g_outside.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool CSampleProfiler::Start(uint32_t hz)
+{
+	if(m_running.load(std::memory_order_relaxed)) {
+		return true;
+	}
+	if(!hz || !MapModules()) {
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Profiler"), xorstr("can't find the modules to profile"));
+		return false;
+	}
+	if(!g_handlerInstalled) {
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_sigaction = OnSignal;
+		action.sa_flags = SA_SIGINFO | SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		if(sigaction(SIGPROF, &action, &g_previousAction) != 0) {
+			return false;
+		}
+		g_handlerInstalled = true;
+	}
+	m_running.store(true, std::memory_order_relaxed);
+	struct itimerval timer;
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = hz >= 1000000 ? 1 : 1000000 / hz;
+	timer.it_value = timer.it_interval;
+	if(setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+		m_running.store(false, std::memory_order_relaxed);
+		return false;
+	}
+	g_hz = hz;
+	return true;
+}
+
+void CSampleProfiler::Stop()
+{
+	if(!m_running.load(std::memory_order_relaxed)) {
+		return;
+	}
+	struct itimerval timer;
+	memset(&timer, 0, sizeof(timer));
+	setitimer(ITIMER_PROF, &timer, nullptr);
+	m_running.store(false, std::memory_order_relaxed);
+}
+
+void CSampleProfiler::Reset()
+{
+	// a sample landing mid-reset is counted in a bucket already cleared or about to be; either is fine
+	for(stProfiledModule& module : g_modules)
+	{
+		if(module.buckets) {
+			madvise(module.buckets, module.mapped, MADV_DONTNEED);
+		}
+	}
+	g_samples.store(0, std::memory_order_relaxed);
+	g_outside.store(0, std::memory_order_relaxed);
+}
+
+int CSampleProfiler::Save(const char* path, stHotSpot* top, int* topCount)
+{
+	struct stHit
+	{
+		uint8_t module;
+		uint32_t offset;
+		uint32_t samples;
+	};
+	std::vector<stHit> hits;
+	uint32_t profiled = 0;
+	for(int m = 0; m < PROFILED_MODULE_COUNT; m++)
+	{
+		const stProfiledModule& module = g_modules[m];
+		if(!module.buckets) {
+			continue;
+		}
+		size_t count = (module.end - module.start) >> BUCKET_SHIFT;
+		uint32_t codeOffset = (uint32_t)(module.start - module.bias);
+		for(size_t i = 0; i < count; i++)
+		{
+			uint32_t samples = __atomic_load_n(&module.buckets[i], __ATOMIC_RELAXED);
+			if(samples) {
+				hits.push_back({ (uint8_t)m, codeOffset + (uint32_t)(i << BUCKET_SHIFT), samples });
+				profiled += samples;
+			}
+		}
+	}
+	std::sort(hits.begin(), hits.end(), [](const stHit& a, const stHit& b) { return a.samples > b.samples; });
+
+	FILE* file = fopen(path, "w");
+	if(!file) {
+		return -1;
+	}
+	fprintf(file, "# %u samples at %u Hz, %u in the modules below, %u elsewhere\n", g_samples.load(std::memory_order_relaxed), g_hz,
+		profiled, g_outside.load(std::memory_order_relaxed));
+	for(const stProfiledModule& module : g_modules)
+	{
+		if(module.buckets) {
+			fprintf(file, "# module %s bias 0x%zx code 0x%zx-0x%zx\n", module.name, (size_t)module.bias,
+				(size_t)(module.start - module.bias), (size_t)(module.end - module.bias));
+		}
+	}
+	fprintf(file, "# module offset samples symbol\n");
+	if(topCount) {
+		*topCount = 0;
+	}
+	for(size_t i = 0; i < hits.size(); i++)
+	{
+		const stHit& hit = hits[i];
+		const stProfiledModule& module = g_modules[hit.module];
+		Dl_info info;
+		const char* symbol = "";
+		size_t symbolOffset = 0;
+		if(dladdr((void*)(module.bias + hit.offset), &info) && info.dli_sname) {
+			symbol = info.dli_sname;
+			symbolOffset = module.bias + hit.offset - (uintptr_t)info.dli_saddr;
+		}
+		fprintf(file, "%s 0x%x %u %s+0x%zx\n", module.name, hit.offset, hit.samples, symbol, symbolOffset);
+		if(top && topCount && *topCount < TOP_COUNT) {
+			stHotSpot& spot = top[(*topCount)++];
+			spot.module = hit.module;
+			spot.offset = hit.offset;
+			spot.samples = hit.samples;
+			snprintf(spot.symbol, sizeof(spot.symbol), "%s", symbol);
+		}
+	}
+	fclose(file);
+	return (int)hits.size();
+}
+
+struct stSaved
+{
+	std::string path;
+	int written;
+	CSampleProfiler::stHotSpot top[CSampleProfiler::TOP_COUNT];
+	int topCount;
+};
+
+void CSampleProfiler::DrawOverlay()
+{
+	bool shown = CFeatures::IsEnabled(FEATURE_PROFILER);
+	if(shown != IsRunning()) {
+		if(shown) {
+			if(!Start(CConfig::Get().profileHz)) {
+				CFeatures::Set(FEATURE_PROFILER, false);
+			}
+		} else {
+			Stop();
+		}
+	}
+	if(!shown) {
+		return;
+	}
+
+	static std::shared_ptr<stSaved> saved;
+	static bool saving = false;
+	bool open = true;
+	ImGui::SetNextWindowSize(ImVec2(640, 420), ImGuiCond_FirstUseEver);
+	if(ImGui::Begin(xorstr("Profiler"), &open))
+	{
+		uint32_t samples = g_samples.load(std::memory_order_relaxed);
+		uint32_t outside = g_outside.load(std::memory_order_relaxed);
+		ImGui::Text(xorstr_cached("%u samples at %u Hz, %.1f%% in the plugin and the game"), samples, g_hz,
+			samples ? 100.0 * (samples - outside) / samples : 0.0);
+		ImGui::BeginDisabled(saving || CConfig::Get().dataDir.empty());
+		if(ImGui::Button(xorstr("Save"))) {
+			char path[512];
+			snprintf(path, sizeof(path), xorstr("%s/profile-%ld.txt"), CConfig::Get().dataDir.c_str(), (long)time(nullptr));
+			std::shared_ptr<stSaved> result = std::make_shared<stSaved>();
+			result->path = path;
+			saving = true;
+			// the histograms are scanned and symbolised off the game thread
+			CWorkers::Submit([result] {
+				result->written = Save(result->path.c_str(), result->top, &result->topCount);
+			}, [result] {
+				saved = result;
+				saving = false;
+			});
+		}
+		ImGui::EndDisabled();
+		ImGui::SameLine();
+		if(ImGui::Button(xorstr("Reset"))) {
+			Reset();
+		}
+		if(saved)
+		{
+			if(saved->written < 0) {
+				ImGui::Text(xorstr_cached("can't write %s"), saved->path.c_str());
+			} else {
+				ImGui::Text(xorstr_cached("%d hot spots in %s"), saved->written, saved->path.c_str());
+			}
+			ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp;
+			if(saved->topCount && ImGui::BeginTable(xorstr("##hotspots"), 3, flags))
+			{
+				ImGui::TableSetupColumn(xorstr("where"), ImGuiTableColumnFlags_WidthStretch, 3.f);
+				ImGui::TableSetupColumn(xorstr("samples"));
+				ImGui::TableSetupColumn(xorstr("symbol"), ImGuiTableColumnFlags_WidthStretch, 3.f);
+				ImGui::TableHeadersRow();
+				for(int i = 0; i < saved->topCount; i++)
+				{
+					const stHotSpot& spot = saved->top[i];
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::Text(xorstr_cached("%s+0x%x"), g_modules[spot.module].name, spot.offset);
+					ImGui::TableNextColumn();
+					ImGui::Text(xorstr_cached("%u"), spot.samples);
+					ImGui::TableNextColumn();
+					ImGui::TextUnformatted(spot.symbol);
+				}
+				ImGui::EndTable();
+			}
+		}
+	}
+	ImGui::End();
+	if(!open) {
+		CFeatures::Set(FEATURE_PROFILER, false);
+	}
+}
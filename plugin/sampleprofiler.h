@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <signal.h>
+
+enum eProfiledModule : uint8_t
+{
+	PROFILED_PLUGIN,	// this library
+	PROFILED_GAME,		// libblackrussia-client.so, for context
+	PROFILED_MODULE_COUNT
+};
+
+// Hot spots from players' devices, where perf and simpleperf aren't available. ITIMER_PROF
+// sends SIGPROF every 1/hz of the process's CPU time to the thread that used it; the handler
+// takes the interrupted pc from the signal context and, when it falls in the code of one of
+// the profiled modules, counts it in that module's histogram of 4-byte buckets. Anywhere else
+// is only counted. Each histogram is an anonymous mapping as large as its module's code, so
+// only pages of code that were actually hit take memory. Runs while FEATURE_PROFILER is on.
+// Save writes every hit bucket, hottest first, as module, offset from the load bias (what
+// addr2line and llvm-symbolizer take) and count; the overlay shows the top of the last save.
+class CSampleProfiler
+{
+public:
+	static constexpr uint32_t BUCKET_SHIFT = 2;
+	static constexpr int TOP_COUNT = 16;
+
+	struct stHotSpot
+	{
+		uint8_t module;
+		uint32_t offset;
+		uint32_t samples;
+		char symbol[64];
+	};
+
+	// game thread; false when the modules can't be found or the timer can't be armed
+	static bool Start(uint32_t hz);
+	static void Stop();
+	static bool IsRunning() { return m_running.load(std::memory_order_relaxed); }
+	// game thread, counts start over
+	static void Reset();
+
+	// any thread; writes the profile to path, hottest first, and up to TOP_COUNT of them into
+	// top (may be null). Returns how many hot spots were written, -1 when path can't be opened.
+	static int Save(const char* path, stHotSpot* top, int* topCount);
+
+	// the profiler window; starts and stops sampling as FEATURE_PROFILER goes on and off
+	static void DrawOverlay();
+
+private:
+	static void OnSignal(int signal, siginfo_t* info, void* context);
+
+	static std::atomic<bool> m_running;
+};
@@ -0,0 +1,54 @@
+#include "sendclass.h"
+#include "config.h"
+
+#include "vendor/RakNet/RakClientInterface.h"
+#include "vendor/RakNet/SAMP/SAMPRPC.h"
+
+// what the game and the plugin always sent at, until a config says otherwise
+PacketPriority CSendClass::m_priority[SEND_CLASS_COUNT] = {
+	HIGH_PRIORITY, HIGH_PRIORITY, HIGH_PRIORITY, HIGH_PRIORITY, HIGH_PRIORITY, HIGH_PRIORITY
+};
+uint8_t CSendClass::m_channel[SEND_CLASS_COUNT];
+eSendClass CSendClass::m_rpcClass[256];
+
+static void SetRpcClass(eSendClass* table, int sampRpcId, eSendClass sendClass)
+{
+	if(sampRpcId >= 0 && sampRpcId < 256) {
+		table[sampRpcId] = sendClass;
+	}
+}
+
+void CSendClass::Apply(RakClientInterface* client)
+{
+	const CConfig::stSendClasses& config = CConfig::Get().sendClasses;
+	for(int i = 0; i < SEND_CLASS_COUNT; i++) {
+		m_priority[i] = (PacketPriority)config.priority[i];
+		m_channel[i] = config.channel[i];
+	}
+
+	for(int i = 0; i < 256; i++) {
+		m_rpcClass[i] = SEND_CLASS_GAME;
+	}
+	SetRpcClass(m_rpcClass, RPC_ClientJoin, SEND_CLASS_CONTROL);
+	SetRpcClass(m_rpcClass, RPC_RequestClass, SEND_CLASS_CONTROL);
+	SetRpcClass(m_rpcClass, RPC_RequestSpawn, SEND_CLASS_CONTROL);
+	SetRpcClass(m_rpcClass, RPC_Spawn, SEND_CLASS_CONTROL);
+	SetRpcClass(m_rpcClass, RPC_Death, SEND_CLASS_CONTROL);
+	SetRpcClass(m_rpcClass, RPC_ClientResume, SEND_CLASS_CONTROL);
+	SetRpcClass(m_rpcClass, RPC_ClientCapabilities, SEND_CLASS_CONTROL);
+	SetRpcClass(m_rpcClass, RPC_Chat, SEND_CLASS_CHAT);
+	SetRpcClass(m_rpcClass, RPC_ServerCommand, SEND_CLASS_CHAT);
+	SetRpcClass(m_rpcClass, RPC_DialogResponse, SEND_CLASS_UI);
+	SetRpcClass(m_rpcClass, RPC_ClickTextDraw, SEND_CLASS_UI);
+	SetRpcClass(m_rpcClass, RPC_ClickPlayer, SEND_CLASS_UI);
+	SetRpcClass(m_rpcClass, RPC_MenuSelect, SEND_CLASS_UI);
+	SetRpcClass(m_rpcClass, RPC_MenuQuit, SEND_CLASS_UI);
+	for(const CConfig::stRpcClass& entry : config.rpcClasses) {
+		SetRpcClass(m_rpcClass, entry.rpcId, (eSendClass)entry.sendClass);
+	}
+
+	unsigned char shares[NUMBER_OF_PRIORITIES] = { 0, config.shares[0], config.shares[1], config.shares[2] };
+	if(client) {
+		client->SetPriorityShares(shares);
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+#include "vendor/RakNet/PacketPriority.h"
+
+class RakClientInterface;
+
+enum eSendClass : uint8_t
+{
+	SEND_CLASS_GAME,	// RPCs without a class of their own: spawns, vehicles, pickups
+	SEND_CLASS_SYNC,	// player, vehicle and passenger sync
+	SEND_CLASS_COMBAT,	// aim and bullet sync
+	SEND_CLASS_CHAT,	// chat and commands
+	SEND_CLASS_UI,		// dialog responses, textdraw and player clicks, menus
+	SEND_CLASS_CONTROL,	// joining, class selection, spawning, resume
+	SEND_CLASS_COUNT
+};
+
+// Outbound traffic by class, each sent at the priority and on the ordering channel the config
+// gives it. RakNet splits what SYSTEM_PRIORITY leaves of the link between HIGH, MEDIUM and LOW
+// by the configured shares (see RakPeer::SetPriorityShares), so on a weak link sync keeps most
+// of it and chat and UI wait for their share instead of competing with every sync tick.
+// Ordering is per channel, so a lost chat RPC only holds back later chat and never a dialog
+// response or a spawn; order between two classes on different channels is not kept. Classes
+// sent at different priorities must not share a channel, or the lower one holds back the
+// higher. Which RPC is in which class can be overridden per RPC. Game thread only.
+class CSendClass
+{
+public:
+	// before connecting, takes the config's classes and pushes its shares to client
+	static void Apply(RakClientInterface* client);
+
+	static eSendClass ForRpc(int sampRpcId) { return sampRpcId >= 0 && sampRpcId < 256 ? m_rpcClass[sampRpcId] : SEND_CLASS_GAME; }
+	static PacketPriority GetPriority(eSendClass sendClass) { return m_priority[sendClass]; }
+	static char GetOrderingChannel(eSendClass sendClass) { return (char)m_channel[sendClass]; }
+
+private:
+	static PacketPriority m_priority[SEND_CLASS_COUNT];
+	static uint8_t m_channel[SEND_CLASS_COUNT];
+	static eSendClass m_rpcClass[256];
+};
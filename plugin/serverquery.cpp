@@ -0,0 +1,352 @@
+#include "serverquery.h"
+#include "netgame.h"
+#include "config.h"
+#include "resolver.h"
+#include "tracering.h"
+#include "workers.h"
+#include "xorstr.h"
+#include "vendor/RakNet/GetTime.h"
+
+#include <algorithm>
+#include <android/log.h>
+#include <arpa/inet.h>
+#include <memory>
+#include <poll.h>
+#include <random>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+std::unordered_map<std::string, CServerQuery::stResult> CServerQuery::m_results;
+uint32_t CServerQuery::m_lastRound = 0;
+bool CServerQuery::m_bQueried = false;
+bool CServerQuery::m_bRunning = false;
+
+enum eQueryOpcode : uint8_t
+{
+	OPCODE_INFO = 1,
+	OPCODE_RULES = 2,
+	OPCODE_PING = 4,
+	OPCODE_ALL = OPCODE_INFO | OPCODE_RULES | OPCODE_PING
+};
+
+// "SAMP", server address, port little endian, opcode
+static constexpr uint32_t HEADER_SIZE = 11;
+
+static const char* KeyOf(const std::string& host, uint16_t port, char* out, size_t size)
+{
+	snprintf(out, size, "%s:%u", host.c_str(), port);
+	return out;
+}
+
+static uint32_t WriteQuery(unsigned char* out, const sockaddr_in& to, char opcode, uint32_t cookie)
+{
+	memcpy(out, "SAMP", 4);
+	memcpy(out + 4, &to.sin_addr.s_addr, 4);
+	uint16_t port = ntohs(to.sin_port);
+	out[8] = (unsigned char)port;
+	out[9] = (unsigned char)(port >> 8);
+	out[10] = (unsigned char)opcode;
+	if(opcode != 'p') {
+		return HEADER_SIZE;
+	}
+	memcpy(out + HEADER_SIZE, &cookie, 4);
+	return HEADER_SIZE + 4;
+}
+
+// every opcode the target hasn't answered yet, attempt 0 or 1
+static void Ask(int fd, uint8_t missing, const sockaddr_in& to, uint32_t cookie, int attempt, uint64_t* pingSentUs)
+{
+	static const struct { uint8_t bit; char opcode; } opcodes[] = {
+		{ OPCODE_INFO, 'i' }, { OPCODE_RULES, 'r' }, { OPCODE_PING, 'p' }
+	};
+	unsigned char packet[HEADER_SIZE + 4];
+	for(const auto& entry : opcodes)
+	{
+		if(!(missing & entry.bit)) {
+			continue;
+		}
+		uint32_t size = WriteQuery(packet, to, entry.opcode, cookie + attempt);
+		if(entry.bit == OPCODE_PING) {
+			pingSentUs[attempt] = RakNet::GetTimeNS();
+		}
+		sendto(fd, packet, size, 0, (const sockaddr*)&to, sizeof(to));
+	}
+}
+
+static inline uint16_t Read16(const unsigned char* p)
+{
+	return (uint16_t)(p[0] | p[1] << 8);
+}
+
+// the rules answer: uint16 count, then count pairs of length-prefixed name and value
+static void ReadVersionRule(const unsigned char* data, uint32_t size, char* out, size_t outSize)
+{
+	if(size < 2) {
+		return;
+	}
+	uint32_t count = Read16(data);
+	uint32_t offset = 2;
+	for(uint32_t i = 0; i < count; i++)
+	{
+		if(offset >= size || offset + 1 + data[offset] >= size) {
+			return;
+		}
+		const unsigned char* name = data + offset + 1;
+		uint32_t nameLength = data[offset];
+		offset += 1 + nameLength;
+		uint32_t valueLength = data[offset];
+		if(offset + 1 + valueLength > size) {
+			return;
+		}
+		if(nameLength == 7 && !memcmp(name, "version", 7)) {
+			size_t length = std::min<size_t>(valueLength, outSize - 1);
+			memcpy(out, data + offset + 1, length);
+			out[length] = '\0';
+			return;
+		}
+		offset += 1 + valueLength;
+	}
+}
+
+static void OnAnswer(CServerQuery::stResult& result, uint8_t* missing, uint32_t cookie, const uint64_t pingSentUs[2],
+	const unsigned char* packet, uint32_t size, uint64_t now)
+{
+	const unsigned char* body = packet + HEADER_SIZE;
+	uint32_t bodySize = size - HEADER_SIZE;
+	switch(packet[10])
+	{
+	case 'i':
+		// password8 players16 maxplayers16, then the hostname, gamemode and language strings
+		if(bodySize >= 5 && (*missing & OPCODE_INFO)) {
+			result.password = body[0] != 0;
+			result.players = Read16(body + 1);
+			result.maxPlayers = Read16(body + 3);
+			result.answered = true;
+			*missing &= ~OPCODE_INFO;
+		}
+		break;
+	case 'r':
+		if(*missing & OPCODE_RULES) {
+			ReadVersionRule(body, bodySize, result.version, sizeof(result.version));
+			*missing &= ~OPCODE_RULES;
+		}
+		break;
+	case 'p':
+		if(bodySize >= 4 && (*missing & OPCODE_PING)) {
+			uint32_t echoed;
+			memcpy(&echoed, body, 4);
+			// an answer to the first ask that turns up after the second still times the first
+			int attempt = echoed == cookie ? 0 : (echoed == cookie + 1 ? 1 : -1);
+			if(attempt >= 0 && pingSentUs[attempt]) {
+				result.pingMs = (uint32_t)((now - pingSentUs[attempt]) / 1000);
+				result.answered = true;
+				*missing &= ~OPCODE_PING;
+			}
+		}
+		break;
+	}
+}
+
+void CServerQuery::Run(std::vector<stTarget>& targets, uint32_t timeoutMs)
+{
+	int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if(fd < 0) {
+		return;
+	}
+	uint64_t start = RakNet::GetTimeNS();
+	uint64_t deadline = start + (uint64_t)timeoutMs * 1000;
+	uint64_t askAgainAt = start + (uint64_t)timeoutMs * 500;
+	for(stTarget& target : targets) {
+		Ask(fd, target.missing, target.address, target.cookie, 0, target.pingSentUs);
+	}
+
+	bool askedAgain = false;
+	size_t outstanding = targets.size();
+	unsigned char packet[2048];
+	while(outstanding)
+	{
+		uint64_t now = RakNet::GetTimeNS();
+		if(now >= deadline) {
+			break;
+		}
+		if(!askedAgain && now >= askAgainAt)
+		{
+			for(stTarget& target : targets) {
+				if(target.missing) {
+					Ask(fd, target.missing, target.address, target.cookie, 1, target.pingSentUs);
+				}
+			}
+			askedAgain = true;
+		}
+		uint64_t wakeAt = askedAgain ? deadline : askAgainAt;
+		pollfd pfd = { fd, POLLIN, 0 };
+		if(poll(&pfd, 1, (int)((wakeAt - now + 999) / 1000)) <= 0) {
+			continue;
+		}
+
+		sockaddr_in from;
+		socklen_t fromSize = sizeof(from);
+		ssize_t size;
+		while((size = recvfrom(fd, packet, sizeof(packet), 0, (sockaddr*)&from, &fromSize)) >= (ssize_t)HEADER_SIZE)
+		{
+			now = RakNet::GetTimeNS();
+			fromSize = sizeof(from);
+			if(memcmp(packet, "SAMP", 4)) {
+				continue;
+			}
+			for(stTarget& target : targets)
+			{
+				if(target.address.sin_addr.s_addr != from.sin_addr.s_addr || target.address.sin_port != from.sin_port) {
+					continue;
+				}
+				bool wasMissing = target.missing != 0;
+				OnAnswer(target.result, &target.missing, target.cookie, target.pingSentUs, packet, (uint32_t)size, now);
+				if(wasMissing && !target.missing) {
+					outstanding--;
+				}
+				break;
+			}
+		}
+	}
+	close(fd);
+}
+
+void CServerQuery::Finish(const std::vector<stTarget>& targets)
+{
+	m_bRunning = false;
+	uint32_t now = RakNet::GetTime();
+	uint32_t answered = 0;
+	uint32_t bestPing = UINT32_MAX;
+	for(const stTarget& target : targets)
+	{
+		stResult& result = m_results[target.key];
+		result = target.result;
+		result.updatedAt = now;
+		if(result.answered) {
+			answered++;
+			bestPing = std::min(bestPing, result.pingMs);
+		}
+		__android_log_print(ANDROID_LOG_DEBUG, xorstr("ServerQuery"), xorstr("%s: %s, %d ms, %u/%u players"), target.key.c_str(),
+			result.answered ? "up" : "no answer", (int)result.pingMs, result.players, result.maxPlayers);
+	}
+	CTraceRing::Trace(TRACE_SERVER_QUERY, answered, (uint32_t)targets.size(), bestPing);
+}
+
+void CServerQuery::Process()
+{
+	const CConfig::stSettings& config = CConfig::Get();
+	// with one endpoint there is nothing to choose, and a connected client has chosen
+	if(m_bRunning || !config.serverQuery.intervalMs || config.endpoints.size() < 2
+	|| CNetGame::GetGameState() == GAMESTATE_CONNECTED) {
+		return;
+	}
+	uint32_t now = RakNet::GetTime();
+	if(m_bQueried && now - m_lastRound < config.serverQuery.intervalMs) {
+		return;
+	}
+
+	static std::minstd_rand engine(std::random_device{}());
+	auto targets = std::make_shared<std::vector<stTarget>>();
+	for(const CConfig::stEndpoint& endpoint : config.endpoints)
+	{
+		// names are queried once they resolve, like they are raced
+		char address[16];
+		if(!CResolver::Lookup(endpoint.host.c_str(), address)) {
+			continue;
+		}
+		stTarget target;
+		char key[280];
+		target.key = KeyOf(endpoint.host, endpoint.port, key, sizeof(key));
+		memset(&target.address, 0, sizeof(target.address));
+		target.address.sin_family = AF_INET;
+		target.address.sin_port = htons(endpoint.port);
+		target.address.sin_addr.s_addr = inet_addr(address);
+		target.cookie = (uint32_t)engine();
+		target.pingSentUs[0] = target.pingSentUs[1] = 0;
+		target.missing = OPCODE_ALL;
+		memset(&target.result, 0, sizeof(target.result));
+		target.result.pingMs = UINT32_MAX;
+		targets->push_back(std::move(target));
+	}
+	if(targets->empty()) {
+		return;
+	}
+	m_bRunning = true;
+	m_bQueried = true;
+	m_lastRound = now;
+	uint32_t timeoutMs = config.serverQuery.timeoutMs;
+	CWorkers::Submit([targets, timeoutMs] { Run(*targets, timeoutMs); }, [targets] { Finish(*targets); });
+}
+
+const CServerQuery::stResult* CServerQuery::Find(const std::string& host, uint16_t port)
+{
+	char key[280];
+	auto it = m_results.find(KeyOf(host, port, key, sizeof(key)));
+	return it == m_results.end() ? nullptr : &it->second;
+}
+
+void CServerQuery::Rank(std::vector<size_t>* endpoints)
+{
+	const CConfig::stSettings& config = CConfig::Get();
+	const CConfig::stServerQuery& query = config.serverQuery;
+	if(endpoints->size() < 2 || !query.intervalMs) {
+		return;
+	}
+
+	struct stScored
+	{
+		size_t index;
+		uint32_t score;
+		bool known;
+		bool full;
+	};
+	uint32_t now = RakNet::GetTime();
+	std::vector<stScored> scored;
+	bool anyKnown = false;
+	bool anyOpen = false;
+	for(size_t index : *endpoints)
+	{
+		const CConfig::stEndpoint& endpoint = config.endpoints[index];
+		const stResult* result = Find(endpoint.host, endpoint.port);
+		// a round older than two intervals is from before a long session, not worth trusting
+		stScored entry = { index, 0, false, false };
+		if(result && result->answered && now - result->updatedAt <= 2 * query.intervalMs)
+		{
+			entry.known = true;
+			entry.full = result->maxPlayers && result->players >= result->maxPlayers;
+			uint32_t load = result->maxPlayers ? (uint32_t)((uint64_t)query.loadMs * result->players / result->maxPlayers) : 0;
+			// an unanswered ping with an answered info sorts after every timed one
+			entry.score = result->pingMs == UINT32_MAX ? query.timeoutMs + load : result->pingMs + load;
+			anyKnown = true;
+		}
+		anyOpen |= !entry.full;
+		scored.push_back(entry);
+	}
+	if(!anyKnown) {
+		return;
+	}
+
+	// known ones by score, the unknown after them in config order
+	std::stable_sort(scored.begin(), scored.end(), [](const stScored& a, const stScored& b) {
+		if(a.known != b.known) {
+			return a.known;
+		}
+		return a.known && a.score < b.score;
+	});
+	uint32_t best = UINT32_MAX;
+	for(const stScored& entry : scored) {
+		if(entry.known && (!entry.full || !anyOpen)) {
+			best = std::min(best, entry.score);
+		}
+	}
+
+	endpoints->clear();
+	for(const stScored& entry : scored)
+	{
+		if(entry.known && ((entry.full && anyOpen) || entry.score > (uint64_t)best + query.slackMs)) {
+			continue;
+		}
+		endpoints->push_back(entry.index);
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <netinet/in.h>
+
+// Which of the configured endpoints a connect races. While not connected, every intervalMs a
+// worker sends the SA-MP query opcodes 'i' (players), 'r' (rules) and 'p' (ping) to all of
+// them at once from one non-blocking UDP socket and collects the answers until each one has
+// answered or timeoutMs is up, asking again halfway through whatever hasn't answered yet.
+// Results are kept per host and port until the next round. Rank then orders the endpoints
+// CReconnect found due by ping plus loadMs at a full server, and leaves out those more than
+// slackMs behind the best and, while another is open, full ones. An endpoint without a fresh
+// answer is raced as before, so nothing is lost to a firewall that drops queries. Game thread
+// only.
+class CServerQuery
+{
+public:
+	struct stResult
+	{
+		bool answered;		// to 'i' or 'p' in the last round
+		bool password;
+		uint16_t players;
+		uint16_t maxPlayers;
+		uint32_t pingMs;	// UINT32_MAX when 'p' went unanswered
+		uint32_t updatedAt;	// RakNet::GetTime of the round
+		char version[24];	// the "version" rule, empty if the server has none
+	};
+
+	// once per frame
+	static void Process();
+	// reorders and trims indices into CConfig's endpoints, see above
+	static void Rank(std::vector<size_t>* endpoints);
+	// the last round's result for an endpoint, nullptr if it wasn't queried yet
+	static const stResult* Find(const std::string& host, uint16_t port);
+
+private:
+	struct stTarget
+	{
+		std::string key;
+		sockaddr_in address;
+		uint32_t cookie;	// 'p' echoes it back, + 1 on the second ask
+		uint64_t pingSentUs[2];
+		uint8_t missing;	// opcodes still unanswered, OPCODE_* bits
+		stResult result;
+	};
+
+	static void Run(std::vector<stTarget>& targets, uint32_t timeoutMs);
+	static void Finish(const std::vector<stTarget>& targets);
+
+	static std::unordered_map<std::string, stResult> m_results;
+	static uint32_t m_lastRound;
+	static bool m_bQueried;
+	static bool m_bRunning;
+};
@@ -0,0 +1,175 @@
+#include "stallwatchdog.h"
+#include "tracering.h"
+#include "xorstr.h"
+
+#include <android/log.h>
+#include <dlfcn.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <unwind.h>
+
+std::atomic<bool> CStallWatchdog::m_enabled(false);
+std::atomic<uint64_t> CStallWatchdog::m_enteredNs[STALL_SITE_COUNT];
+std::atomic<int> CStallWatchdog::m_tid[STALL_SITE_COUNT];
+
+// SIGURG's default is to ignore it, so one arriving after the game replaced our handler costs nothing
+static constexpr int STALL_SIGNAL = SIGURG;
+// how long the watchdog waits for the game thread to run the handler
+static constexpr uint32_t CAPTURE_WAIT_MS = 50;
+
+static const char* const g_siteNames[STALL_SITE_COUNT] = {
+	"eglSwapBuffers",
+	"ProcessNetwork",
+	"RPC fixup"
+};
+
+// filled by the handler on the stalled thread, read by the watchdog once captured is set
+static uintptr_t g_frames[CStallWatchdog::MAX_FRAMES];
+static std::atomic<int> g_targetTid(0);
+static std::atomic<uint32_t> g_frameCount(0);
+static std::atomic<bool> g_requested(false);
+static std::atomic<bool> g_captured(false);
+static struct sigaction g_previousAction;
+
+static uint64_t Now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int CurrentTid()
+{
+	static thread_local int tid = (int)syscall(SYS_gettid);
+	return tid;
+}
+
+uint64_t CStallWatchdog::Enter(eStallSite site)
+{
+	m_tid[site].store(CurrentTid(), std::memory_order_relaxed);
+	return m_enteredNs[site].exchange(Now(), std::memory_order_acq_rel);
+}
+
+static _Unwind_Reason_Code CollectFrame(struct _Unwind_Context* context, void* arg)
+{
+	uint32_t* count = (uint32_t*)arg;
+	uintptr_t pc = _Unwind_GetIP(context);
+	if(pc) {
+		g_frames[(*count)++] = pc;
+	}
+	return *count < CStallWatchdog::MAX_FRAMES ? _URC_NO_REASON : _URC_END_OF_STACK;
+}
+
+// async-signal-safe: a syscall, the unwinder and plain stores
+void CStallWatchdog::OnSignal(int signal, siginfo_t* info, void* context)
+{
+	if(!g_requested.load(std::memory_order_acquire) || (int)syscall(SYS_gettid) != g_targetTid.load(std::memory_order_relaxed)) {
+		// not ours, whoever had the signal before gets it
+		if(g_previousAction.sa_flags & SA_SIGINFO) {
+			g_previousAction.sa_sigaction(signal, info, context);
+		} else if(g_previousAction.sa_handler != SIG_DFL && g_previousAction.sa_handler != SIG_IGN) {
+			g_previousAction.sa_handler(signal);
+		}
+		return;
+	}
+	g_requested.store(false, std::memory_order_relaxed);
+	uint32_t count = 0;
+	_Unwind_Backtrace(CollectFrame, &count);
+	g_frameCount.store(count, std::memory_order_relaxed);
+	g_captured.store(true, std::memory_order_release);
+}
+
+static uint32_t CaptureThread(int tid)
+{
+	g_targetTid.store(tid, std::memory_order_relaxed);
+	g_captured.store(false, std::memory_order_relaxed);
+	g_requested.store(true, std::memory_order_release);
+	if(syscall(SYS_tgkill, getpid(), tid, STALL_SIGNAL) != 0) {
+		g_requested.store(false, std::memory_order_relaxed);
+		return 0;
+	}
+	for(uint32_t waited = 0; waited < CAPTURE_WAIT_MS; waited++) {
+		if(g_captured.load(std::memory_order_acquire)) {
+			return g_frameCount.load(std::memory_order_relaxed);
+		}
+		usleep(1000);
+	}
+	// blocked in the kernel with the signal masked, or the handler is no longer ours
+	g_requested.store(false, std::memory_order_relaxed);
+	return 0;
+}
+
+static void Report(eStallSite site, uint32_t stalledMs, uint32_t frames)
+{
+	CTraceRing::Trace(TRACE_STALL, site, stalledMs, frames);
+	__android_log_print(ANDROID_LOG_WARN, xorstr("Stall"), xorstr("%s stalled for %u ms, %u frames"), g_siteNames[site], stalledMs, frames);
+	for(uint32_t i = 0; i < frames; i++)
+	{
+		uint64_t pc = g_frames[i];
+		CTraceRing::Trace(TRACE_STALL_FRAME, i, (uint32_t)pc, (uint32_t)(pc >> 32));
+		Dl_info info;
+		if(dladdr((void*)g_frames[i], &info) && info.dli_fname) {
+			const char* module = strrchr(info.dli_fname, '/');
+			__android_log_print(ANDROID_LOG_WARN, xorstr("Stall"), xorstr("  #%02u %s+0x%zx %s"), i, module ? module + 1 : info.dli_fname,
+				(size_t)(g_frames[i] - (uintptr_t)info.dli_fbase), info.dli_sname ? info.dli_sname : "");
+		} else {
+			__android_log_print(ANDROID_LOG_WARN, xorstr("Stall"), xorstr("  #%02u 0x%zx"), i, (size_t)g_frames[i]);
+		}
+	}
+}
+
+void CStallWatchdog::WatchLoop(uint32_t thresholdMs)
+{
+	uint64_t thresholdNs = (uint64_t)thresholdMs * 1000000ull;
+	uint32_t periodUs = thresholdMs < 4 ? 1000 : thresholdMs * 1000 / 4;
+	// the entry stamp each site was last reported for
+	uint64_t reportedNs[STALL_SITE_COUNT] = {};
+	for(;;)
+	{
+		usleep(periodUs);
+		uint64_t now = Now();
+		int stalled = -1;
+		uint64_t stalledEntered = 0;
+		for(int site = 0; site < STALL_SITE_COUNT; site++)
+		{
+			uint64_t entered = m_enteredNs[site].load(std::memory_order_acquire);
+			if(!entered || now - entered < thresholdNs || entered == reportedNs[site]) {
+				continue;
+			}
+			reportedNs[site] = entered;
+			// the latest entered is the innermost
+			if(entered > stalledEntered) {
+				stalled = site;
+				stalledEntered = entered;
+			}
+		}
+		if(stalled < 0) {
+			continue;
+		}
+		uint32_t frames = CaptureThread(m_tid[stalled].load(std::memory_order_relaxed));
+		Report((eStallSite)stalled, (uint32_t)((Now() - stalledEntered) / 1000000ull), frames);
+	}
+}
+
+void CStallWatchdog::Start(uint32_t thresholdMs)
+{
+	if(!thresholdMs || m_enabled.load(std::memory_order_relaxed)) {
+		return;
+	}
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_sigaction = OnSignal;
+	action.sa_flags = SA_SIGINFO | SA_RESTART | SA_ONSTACK;
+	sigemptyset(&action.sa_mask);
+	if(sigaction(STALL_SIGNAL, &action, &g_previousAction) != 0) {
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Stall"), xorstr("can't install the signal handler"));
+		return;
+	}
+	m_enabled.store(true, std::memory_order_relaxed);
+	// lives as long as the process, like the worker threads
+	std::thread(WatchLoop, thresholdMs).detach();
+}
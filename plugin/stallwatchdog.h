@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <signal.h>
+
+enum eStallSite : uint8_t
+{
+	STALL_SWAP_BUFFERS,		// hook_eglSwapBuffers, the overlay included
+	STALL_PROCESS_NETWORK,	// hook_CNetGame__ProcessNetwork
+	STALL_RPC_FIXUP,		// FixBrokenRPC, the game's handler included
+	STALL_SITE_COUNT
+};
+
+// Tells a frame hitch the plugin caused from one it didn't. The game thread stamps the time
+// it entered each site and clears it on the way out; a watchdog thread polls the stamps, and
+// once one is older than the configured threshold it interrupts the game thread with a
+// signal, whose handler unwinds the thread where it stands. The watchdog then writes a
+// TRACE_STALL record (site, ms, frames) and a TRACE_STALL_FRAME record per frame (index, pc
+// low and high 32 bits) into the trace ring, and logs the frames against their modules.
+// One report per stalled entry; the innermost site wins when they nest. Frames stop at the
+// handler when the unwinder can't step through the signal frame, which some arm32 builds
+// can't; the stall record is still there.
+class CStallWatchdog
+{
+public:
+	static constexpr uint32_t MAX_FRAMES = 32;
+
+	// thresholdMs 0 leaves the watchdog off and the scopes at one load each
+	static void Start(uint32_t thresholdMs);
+
+	// put first in the hook, after HOOK_SCOPE
+	class Scope
+	{
+	public:
+		explicit Scope(eStallSite site) : m_site(site), m_previous(0)
+		{
+			if(m_enabled.load(std::memory_order_relaxed)) {
+				m_previous = Enter(site);
+			}
+		}
+		~Scope()
+		{
+			if(m_enabled.load(std::memory_order_relaxed)) {
+				m_enteredNs[m_site].store(m_previous, std::memory_order_release);
+			}
+		}
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		eStallSite m_site;
+		uint64_t m_previous;	// a reentered site keeps its outer stamp once the inner call is done
+	};
+
+private:
+	static uint64_t Enter(eStallSite site);
+	static void WatchLoop(uint32_t thresholdMs);
+	static void OnSignal(int signal, siginfo_t* info, void* context);
+
+	static std::atomic<bool> m_enabled;
+	static std::atomic<uint64_t> m_enteredNs[STALL_SITE_COUNT];
+	static std::atomic<int> m_tid[STALL_SITE_COUNT];	// the thread last in each site
+};
+
+#define STALL_SCOPE_CONCAT2(a, b) a##b
+#define STALL_SCOPE_CONCAT(a, b) STALL_SCOPE_CONCAT2(a, b)
+#define STALL_SCOPE(site) CStallWatchdog::Scope STALL_SCOPE_CONCAT(stallScope, __LINE__)(site)
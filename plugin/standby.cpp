@@ -0,0 +1,214 @@
+#include "standby.h"
+#include "capabilities.h"
+#include "joinhandshake.h"
+#include "netgame.h"
+#include "resolver.h"
+#include "syncqueue.h"
+#include "thermal.h"
+#include "xorstr.h"
+#include "game/hooks.h"
+#include "vendor/RakNet/BitStream.h"
+#include "vendor/RakNet/GetTime.h"
+
+#include <android/log.h>
+
+extern RakClientInterface* pRakClient;
+
+CStandby::eStandbyState CStandby::m_state = CStandby::STANDBY_IDLE;
+RakClientInterface* CStandby::m_client = nullptr;
+std::string CStandby::m_host;
+uint16_t CStandby::m_port = 0;
+uint32_t CStandby::m_resolveStartedAt = 0;
+bool CStandby::m_bSwitchAsked = false;
+std::vector<Packet*> CStandby::m_held;
+size_t CStandby::m_nextHeld = 0;
+
+void CStandby::Initialise(RakClientInterface* client)
+{
+	client->RegisterAsRemoteProcedureCall(RPC_ServerTransfer, ServerTransfer);
+}
+
+void CStandby::ServerTransfer(RPCParameters* rpcParams)
+{
+	RakNet::BitStream bsData(rpcParams->input, BITS_TO_BYTES(rpcParams->numberOfBitsOfData), false);
+	uint8_t action;
+	if(!CCapabilities::Has(CCapabilities::CAP_TRANSFER) || !bsData.Read(action)) {
+		return;
+	}
+	switch(action)
+	{
+		case TRANSFER_PREPARE:
+		{
+			uint8_t hostLength;
+			char host[256];
+			uint16_t port;
+			if(!bsData.Read(hostLength) || !hostLength || !bsData.Read(host, hostLength) || !bsData.Read(port) || !port) {
+				return;
+			}
+			host[hostLength] = '\0';
+			// already on its way there
+			if(m_state != STANDBY_IDLE && m_host == host && m_port == port) {
+				return;
+			}
+			Drop();
+			m_host = host;
+			m_port = port;
+			Start();
+			break;
+		}
+		case TRANSFER_SWITCH:
+			// carried out from Process, not in the middle of the drain this came in on
+			m_bSwitchAsked = !m_host.empty();
+			if(m_bSwitchAsked && m_state == STANDBY_IDLE) {
+				Start();
+			}
+			break;
+		case TRANSFER_CANCEL:
+			Drop();
+			m_host.clear();
+			break;
+	}
+}
+
+void CStandby::Process()
+{
+	if(m_state == STANDBY_RESOLVING) {
+		Start();
+	}
+	if(m_state == STANDBY_HOLDING || m_state == STANDBY_SWITCHING) {
+		Receive();
+	}
+	if(m_state == STANDBY_HOLDING && m_bSwitchAsked) {
+		Leave();
+	}
+}
+
+void CStandby::Start()
+{
+	char address[16];
+	if(!CResolver::Lookup(m_host.c_str(), address))
+	{
+		uint32_t now = RakNet::GetTime();
+		if(m_state != STANDBY_RESOLVING) {
+			m_state = STANDBY_RESOLVING;
+			m_resolveStartedAt = now;
+		} else if(now - m_resolveStartedAt >= RESOLVE_TIMEOUT_MS) {
+			__android_log_print(ANDROID_LOG_INFO, xorstr("Standby"), xorstr("%s didn't resolve, no standby"), m_host.c_str());
+			Drop();
+		}
+		return;
+	}
+
+	if(!m_client) {
+		m_client = RakNetworkFactory::GetRakClientInterface();
+		RegisterRPCs(m_client);
+	}
+	// whatever the spare got before it was disconnected
+	Packet* stale;
+	while((stale = m_client->Receive())) {
+		m_client->DeallocatePacket(stale);
+	}
+	PrepareConnect(m_client);
+	if(!m_client->Connect(address, m_port, 0, 0, 5)) {
+		Drop();
+		return;
+	}
+	m_state = STANDBY_HOLDING;
+	__android_log_print(ANDROID_LOG_INFO, xorstr("Standby"), xorstr("connecting to %s:%u ahead of the switch"), address, m_port);
+}
+
+void CStandby::Receive()
+{
+	Packet* pkt;
+	while((pkt = m_client->Receive())) {
+		switch(pkt->data[0])
+		{
+			case ID_AUTH_KEY:
+				CNetGame::Packet_AuthKey(pkt, m_client);
+				m_client->DeallocatePacket(pkt);
+				break;
+			case ID_CONNECTION_ATTEMPT_FAILED:
+			case ID_NO_FREE_INCOMING_CONNECTIONS:
+			case ID_CONNECTION_BANNED:
+			case ID_INVALID_PASSWORD:
+			case ID_CONNECTION_LOST:
+			case ID_DISCONNECTION_NOTIFICATION:
+				__android_log_print(ANDROID_LOG_INFO, xorstr("Standby"), xorstr("dropped on packet %u"), pkt->data[0]);
+				m_client->DeallocatePacket(pkt);
+				Drop();
+				return;
+			default:
+				m_held.push_back(pkt);
+				break;
+		}
+	}
+}
+
+void CStandby::Leave()
+{
+	m_state = STANDBY_SWITCHING;
+	__android_log_print(ANDROID_LOG_INFO, xorstr("Standby"), xorstr("switching with %u packets held"), (unsigned)m_held.size());
+	// torn down as for a restarted join, and the game connects again straight away
+	CNetGame::RestartJoin();
+	CNetGame::SetGameState(GAMESTATE_WAIT_CONNECT);
+}
+
+void CStandby::Drop()
+{
+	if(m_state == STANDBY_HOLDING || m_state == STANDBY_SWITCHING || m_state == STANDBY_SWAPPING) {
+		m_client->Disconnect(0, 0);
+		for(Packet* pkt : m_held) {
+			m_client->DeallocatePacket(pkt);
+		}
+		m_held.clear();
+	}
+	// a switch that was under way is the game's own connect now
+	m_bSwitchAsked = false;
+	m_state = STANDBY_IDLE;
+}
+
+bool CStandby::Claim()
+{
+	if(m_state == STANDBY_SWITCHING) {
+		// whatever came in since the last tick goes first
+		Receive();
+	}
+	if(m_state != STANDBY_SWITCHING) {
+		return false;
+	}
+	CJoinHandshake::OnConnect();
+	m_bSwitchAsked = false;
+	m_host.clear();
+	m_state = STANDBY_SWAPPING;
+	return true;
+}
+
+void CStandby::OnFrameEnd()
+{
+	if(m_state != STANDBY_SWAPPING) {
+		return;
+	}
+	// the old client was disconnected by Leave, its update thread is gone, and it becomes the spare
+	RakClientInterface* previous = pRakClient;
+	CSyncQueue::Detach(previous);
+	pRakClient = m_client;
+	m_client = previous;
+	CSyncQueue::Initialise(pRakClient);
+	// PrepareConnect set the rest; the thermal interval only ever went to the client in use
+	CThermal::ApplyTo(pRakClient);
+	m_state = STANDBY_CLAIMED;
+}
+
+Packet* CStandby::TakeHeld()
+{
+	if(m_state != STANDBY_CLAIMED) {
+		return nullptr;
+	}
+	if(m_nextHeld == m_held.size()) {
+		m_held.clear();
+		m_nextHeld = 0;
+		m_state = STANDBY_IDLE;
+		return nullptr;
+	}
+	return m_held[m_nextHeld++];
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "vendor/RakNet/NetworkTypes.h"
+
+class RakClientInterface;
+
+// A move between our servers, the lobby handing the player to a game node say, used to be a
+// lost connection and a cold connect: lookup, connection request, auth key, then the join.
+// With CAP_TRANSFER agreed the server announces the move with RPC_ServerTransfer:
+//
+//   uint8 action
+//   with TRANSFER_PREPARE: uint8 hostLength, host, uint16 port
+//
+// TRANSFER_PREPARE opens a second RakClient to that server in the background and answers its
+// auth key; ID_CONNECTION_REQUEST_ACCEPTED and anything after it is held, like CEarlyConnect
+// does. TRANSFER_SWITCH tears the current session down as RestartJoin does, and the game's next
+// Connect claims the standby, swapped in for pRakClient once that frame's send batch is closed,
+// so all that is left of the switch is ClientJoin. The client swapped out is kept for the next
+// standby. A switch with nothing standing by opens the session first and switches once it is
+// up. TRANSFER_CANCEL, a refusal or a lost standby connection drop it, and a switch falls back
+// to the game connecting itself. Game thread only.
+class CStandby
+{
+public:
+	enum eTransferAction : uint8_t
+	{
+		TRANSFER_PREPARE,
+		TRANSFER_SWITCH,
+		TRANSFER_CANCEL
+	};
+
+	// a name that hasn't resolved by then drops the standby
+	static constexpr uint32_t RESOLVE_TIMEOUT_MS = 5000;
+
+	static void Initialise(RakClientInterface* client);
+	// once per game tick, from CApp::Process
+	static void Process();
+	// from the Connect hook: true when the standby session takes the place of that connect
+	static bool Claim();
+	// from the JNILib step hook once the frame's send batch is closed: a claimed standby takes
+	// pRakClient's place here, never in the middle of a batch
+	static void OnFrameEnd();
+	// the next held packet once claimed, in the order they arrived
+	static Packet* TakeHeld();
+
+private:
+	enum eStandbyState
+	{
+		STANDBY_IDLE,
+		STANDBY_RESOLVING,	// waiting on CResolver before anything is sent
+		STANDBY_HOLDING,
+		STANDBY_SWITCHING,	// the old session is gone, waiting for the game's Connect
+		STANDBY_SWAPPING,	// claimed, swapped in at the end of the frame
+		STANDBY_CLAIMED		// held packets go to ProcessNetwork
+	};
+
+	static void ServerTransfer(RPCParameters* rpcParams);
+	static void Start();
+	static void Receive();
+	static void Leave();
+	static void Drop();
+
+	static eStandbyState m_state;
+	// the spare client between standbys; created on the first one
+	static RakClientInterface* m_client;
+	static std::string m_host;
+	static uint16_t m_port;
+	static uint32_t m_resolveStartedAt;
+	static bool m_bSwitchAsked;
+	static std::vector<Packet*> m_held;
+	static size_t m_nextHeld;
+};
@@ -0,0 +1,81 @@
+#include "startuptimeline.h"
+#include "xorstr.h"
+
+#include <android/log.h>
+#include <cstdio>
+#include <sys/system_properties.h>
+
+#include "vendor/imgui/imgui.h"
+
+std::atomic<uint64_t> CStartupTimeline::m_reachedAt[STARTUP_PHASE_COUNT];
+
+static const char* const g_phaseNames[STARTUP_PHASE_COUNT] = {
+	"JNI_OnLoad",
+	"config",
+	"offsets",
+	"RW ready",
+	"RW init",
+	"hooks",
+	"first tick",
+	"GUI init",
+	"first frame"
+};
+
+void CStartupTimeline::Mark(eStartupPhase phase)
+{
+	uint64_t expected = 0;
+	if(!m_reachedAt[phase].compare_exchange_strong(expected, Now(), std::memory_order_relaxed)) {
+		return;
+	}
+	if(phase == STARTUP_FIRST_FRAME) {
+		Report();
+	}
+}
+
+double CStartupTimeline::GetMs(eStartupPhase phase)
+{
+	uint64_t start = m_reachedAt[STARTUP_ONLOAD].load(std::memory_order_relaxed);
+	uint64_t reached = m_reachedAt[phase].load(std::memory_order_relaxed);
+	if(!start || !reached) {
+		return -1.0;
+	}
+	return (reached - start) / 1e6;
+}
+
+const char* CStartupTimeline::GetName(eStartupPhase phase)
+{
+	return g_phaseNames[phase];
+}
+
+void CStartupTimeline::Report()
+{
+	char model[PROP_VALUE_MAX] = "";
+	__system_property_get(xorstr("ro.product.model"), model);
+	char line[512];
+	int len = snprintf(line, sizeof(line), xorstr("%s:"), model);
+	for(int i = STARTUP_CONFIG; i < STARTUP_PHASE_COUNT && len < (int)sizeof(line); i++) {
+		double ms = GetMs((eStartupPhase)i);
+		if(ms < 0) {
+			len += snprintf(line + len, sizeof(line) - len, xorstr(" %s -"), g_phaseNames[i]);
+		} else {
+			len += snprintf(line + len, sizeof(line) - len, xorstr(" %s %.1f"), g_phaseNames[i], ms);
+		}
+	}
+	__android_log_print(ANDROID_LOG_INFO, xorstr("Startup"), "%s", line);
+}
+
+void CStartupTimeline::Draw()
+{
+	if(!ImGui::CollapsingHeader(xorstr("Startup"))) {
+		return;
+	}
+	// phases come from different threads, so one can land before the one listed above it
+	for(int i = STARTUP_CONFIG; i < STARTUP_PHASE_COUNT; i++) {
+		double ms = GetMs((eStartupPhase)i);
+		if(ms < 0) {
+			ImGui::Text(xorstr("%-12s -"), g_phaseNames[i]);
+		} else {
+			ImGui::Text(xorstr("%-12s %8.1f ms"), g_phaseNames[i], ms);
+		}
+	}
+}
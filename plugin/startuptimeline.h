@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <time.h>
+
+enum eStartupPhase
+{
+	STARTUP_ONLOAD,			// JNI_OnLoad entered, everything else is measured from here
+	STARTUP_CONFIG,			// brsamp.json loaded, APP_INIT_OFFSETS done
+	STARTUP_OFFSETS,		// game library found and its offset table selected, seen by hack_thread
+	STARTUP_RW_READY,		// RwInitialised seen by hack_thread
+	STARTUP_APP_RW,			// APP_INIT_RW done
+	STARTUP_HOOKS,			// every hack_thread hook installed
+	STARTUP_FIRST_TICK,		// first JNILib_step through our hook
+	STARTUP_GUI,			// APP_INIT_GUI done, on the first frame the overlay had something to draw
+	STARTUP_FIRST_FRAME,	// first frame swapped through our hook
+	STARTUP_PHASE_COUNT
+};
+
+// When each startup phase was first reached, on CLOCK_MONOTONIC. Phases are marked from
+// JNI_OnLoad, hack_thread, the game thread and the GL thread, so every slot is an atomic
+// that only the first Mark writes. The timeline goes to logcat with the device model once
+// the first overlay frame is out, and the feature panel shows it.
+class CStartupTimeline
+{
+public:
+	static void Mark(eStartupPhase phase);
+	// ms since JNI_OnLoad, negative while the phase hasn't been reached
+	static double GetMs(eStartupPhase phase);
+	static const char* GetName(eStartupPhase phase);
+	static void Draw();
+
+private:
+	static inline uint64_t Now()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+	}
+	static void Report();
+
+	static std::atomic<uint64_t> m_reachedAt[STARTUP_PHASE_COUNT];
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <string.h>
+
+#include "wireschema.h"
+
+// Field codecs every sync converter shares, CPacketTranslator's outbound translators and the
+// DecodeBR*Sync family alike, so no converter carries its own copy of a field's rules. Health
+// and armour go through 256-entry tables built at compile time: a packed byte is one load each
+// way, with no comparison on the packet path.
+
+// one bit of the MSB-first stream
+static inline uint32_t BitAt(const uint8_t* data, uint32_t bitOffset)
+{
+	return (data[bitOffset >> 3] >> (7 - (bitOffset & 7))) & 1;
+}
+
+// a flag byte rotated right by N, for flags the two protocols keep at different ends of it
+template<uint32_t N>
+static constexpr uint8_t RotateRight(uint8_t value)
+{
+	return (uint8_t)((value >> (N % 8)) | (value << ((8 - N % 8) % 8)));
+}
+
+// a wider health or armour in one byte: past 255 is full, not wrapped round to dead
+static inline uint8_t SaturateByte(uint32_t value)
+{
+	return value > 0xFF ? 0xFF : (uint8_t)value;
+}
+
+struct stHealthArmour
+{
+	uint8_t health;
+	uint8_t armour;
+};
+
+// SA-MP relays health and armour as a nibble each, health in the high one: 0 is dead, 15 is
+// full and anything else is steps of 7, which is what the server rounds down to
+static constexpr uint8_t HealthFromNibble(uint32_t nibble)
+{
+	return nibble == 0xF ? 100 : (uint8_t)(nibble * 7);
+}
+
+static constexpr uint8_t NibbleFromHealth(uint32_t health)
+{
+	return health >= 100 ? 0xF : (uint8_t)(health / 7);
+}
+
+struct stHealthArmourTables
+{
+	stHealthArmour unpack[256];	// by packed byte
+	uint8_t nibble[256];		// by health or armour
+
+	constexpr stHealthArmourTables() : unpack(), nibble()
+	{
+		for(uint32_t i = 0; i < 256; i++) {
+			unpack[i] = { HealthFromNibble(i >> 4), HealthFromNibble(i & 0xF) };
+			nibble[i] = NibbleFromHealth(i);
+		}
+	}
+};
+inline constexpr stHealthArmourTables g_healthArmourTables;
+
+static_assert(g_healthArmourTables.unpack[0xF0].health == 100 && g_healthArmourTables.unpack[0xF0].armour == 0
+	&& g_healthArmourTables.nibble[99] == 14 && g_healthArmourTables.nibble[100] == 0xF, "health/armour tables");
+
+static inline stHealthArmour UnpackHealthArmour(uint8_t packed)
+{
+	return g_healthArmourTables.unpack[packed];
+}
+
+static inline uint8_t PackHealthArmour(uint8_t health, uint8_t armour)
+{
+	return (uint8_t)((g_healthArmourTables.nibble[health] << 4) | g_healthArmourTables.nibble[armour]);
+}
+
+// health and armour as the server relays them: a nibble each, or a byte each
+template<typename SAMP>
+static constexpr uint32_t HEALTH_ARMOUR_BITS = SAMP::PACKED_HEALTH_ARMOUR ? 8 : 16;
+
+template<typename SAMP, typename T>
+static inline void ReadHealthArmour(const uint8_t* data, uint32_t bitOffset, T* health, T* armour)
+{
+	uint8_t values[2];
+	if constexpr(SAMP::PACKED_HEALTH_ARMOUR) {
+		ReadBytesAt<1>(data, bitOffset, values);
+		stHealthArmour unpacked = UnpackHealthArmour(values[0]);
+		values[0] = unpacked.health;
+		values[1] = unpacked.armour;
+	} else {
+		ReadBytesAt<2>(data, bitOffset, values);
+	}
+	*health = values[0];
+	*armour = values[1];
+}
+
+// health then armour, each widened or saturated to the target's width; both little endian
+template<typename FROM, typename TO>
+static inline void CopyHealthArmour(const uint8_t* in, uint8_t* out)
+{
+	static_assert(FROM::HEALTH_BYTES <= 2 && TO::HEALTH_BYTES <= 2, "health and armour are at most 16 bits");
+	for(uint32_t field = 0; field < 2; field++)
+	{
+		uint16_t value = 0;
+		memcpy(&value, in + field * FROM::HEALTH_BYTES, FROM::HEALTH_BYTES);
+		if constexpr(TO::HEALTH_BYTES < FROM::HEALTH_BYTES) {
+			value = SaturateByte(value);
+		}
+		memcpy(out + field * TO::HEALTH_BYTES, &value, TO::HEALTH_BYTES);
+	}
+}
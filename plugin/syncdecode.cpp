@@ -0,0 +1,408 @@
+#include "syncdecode.h"
+#include "synccodec.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "vendor/RakNet/PacketEnumerations.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// ReadNormQuat layout: 4 sign bits (w x y z), then three 16-bit components. Left
+// packed here, DecodeNormQuats turns a whole frame's worth into floats at once.
+static inline void ReadPackedNormQuat(const uint8_t* data, uint32_t bitOffset, stPackedNormQuat* out)
+{
+	ReadBytesAt<1>(data, bitOffset, &out->signs);
+	out->signs &= 0xF0;
+	uint16_t quat[3];
+	ReadBytesAt<6>(data, bitOffset + 4, quat);
+	out->x = quat[0];
+	out->y = quat[1];
+	out->z = quat[2];
+}
+
+// Offsets are relative to the lr flag bit; with the protocol and both optional sticks
+// fixed at compile time every field up to the move speed sits at a constant position,
+// so the whole block is bounds checked once.
+template<typename SAMP, bool HAS_LR, bool HAS_UD>
+struct stOnFootLayout
+{
+	static constexpr uint32_t LR = 1;
+	static constexpr uint32_t UD = LR + (HAS_LR ? 16 : 0) + 1;
+	static constexpr uint32_t KEYS = UD + (HAS_UD ? 16 : 0);
+	static constexpr uint32_t POS = KEYS + 16;
+	static constexpr uint32_t QUAT = POS + 96;
+	static constexpr uint32_t HEALTH_ARMOUR = QUAT + 4 + 48;
+	static constexpr uint32_t WEAPON = HEALTH_ARMOUR + HEALTH_ARMOUR_BITS<SAMP>;
+	static constexpr uint32_t ACTION = WEAPON + 8;
+	static constexpr uint32_t SPEED = ACTION + 8;
+	static constexpr uint32_t FIXED_END = SPEED + 32;
+
+	// the surf flag, when the fixed block and the optional speed vector both fit
+	static inline bool SurfAt(const uint8_t* data, uint32_t offset, uint32_t end, uint32_t* surf)
+	{
+		if(offset + FIXED_END > end) {
+			return false;
+		}
+		float magnitude;
+		ReadBytesAt<4>(data, offset + SPEED, &magnitude);
+		*surf = offset + FIXED_END + (magnitude != 0.0f ? 48 : 0);
+		return *surf < end;
+	}
+};
+
+template<typename BR, typename SAMP, bool HAS_LR, bool HAS_UD>
+static bool DecodeOnFootBody(const uint8_t* data, uint32_t offset, uint32_t end, typename BR::OnFootSync* out, stPackedNormQuat* quat)
+{
+	typedef stOnFootLayout<SAMP, HAS_LR, HAS_UD> L;
+	uint32_t surf;
+	if(!L::SurfAt(data, offset, end, &surf)) {
+		return false;
+	}
+
+	if(HAS_LR) {
+		ReadBytesAt<2>(data, offset + L::LR, &out->lrAnalogLeftStick);
+	}
+	if(HAS_UD) {
+		ReadBytesAt<2>(data, offset + L::UD, &out->udAnalogLeftStick);
+	}
+	ReadBytesAt<2>(data, offset + L::KEYS, &out->wKeys);
+	ReadBytesAt<12>(data, offset + L::POS, &out->vecPos);
+
+	ReadPackedNormQuat(data, offset + L::QUAT, quat);
+
+	ReadHealthArmour<SAMP>(data, offset + L::HEALTH_ARMOUR, &out->health, &out->armour);
+	ReadBytesAt<1>(data, offset + L::WEAPON, &out->byteCurrentWeapon);
+	ReadBytesAt<1>(data, offset + L::ACTION, &out->byteSpecialAction);
+
+	// The move speed only has to be skipped: it has never been forwarded to the game,
+	// which keeps vecMoveSpeed at zero and extrapolates from the position itself.
+	if(BitAt(data, surf) && surf + 1 + 16 + 96 <= end) {
+		ReadBytesAt<2>(data, surf + 1, &out->wSurfInfo);
+		ReadBytesAt<12>(data, surf + 1 + 16, &out->vecSurfOffsets);
+	}
+	return true;
+}
+
+template<typename BR>
+using OnFootBodyDecoder = bool (*)(const uint8_t*, uint32_t, uint32_t, typename BR::OnFootSync*, stPackedNormQuat*);
+
+// indexed by lr flag | (ud flag << 1)
+template<typename BR, typename SAMP>
+static constexpr OnFootBodyDecoder<BR> g_onFootDecoders[4] = {
+	DecodeOnFootBody<BR, SAMP, false, false>,
+	DecodeOnFootBody<BR, SAMP, true, false>,
+	DecodeOnFootBody<BR, SAMP, false, true>,
+	DecodeOnFootBody<BR, SAMP, true, true>
+};
+
+template<typename SAMP, bool HAS_LR, bool HAS_UD>
+static bool PeekOnFootBody(const uint8_t* data, uint32_t offset, uint32_t end, CVector* pos)
+{
+	typedef stOnFootLayout<SAMP, HAS_LR, HAS_UD> L;
+	uint32_t surf;
+	if(!L::SurfAt(data, offset, end, &surf)) {
+		return false;
+	}
+	ReadBytesAt<12>(data, offset + L::POS, pos);
+	return true;
+}
+
+typedef bool (*OnFootBodyPeek)(const uint8_t*, uint32_t, uint32_t, CVector*);
+
+template<typename SAMP>
+static constexpr OnFootBodyPeek g_onFootPeeks[4] = {
+	PeekOnFootBody<SAMP, false, false>,
+	PeekOnFootBody<SAMP, true, false>,
+	PeekOnFootBody<SAMP, false, true>,
+	PeekOnFootBody<SAMP, true, true>
+};
+
+// The sender and the index into g_onFootDecoders / g_onFootPeeks; offset is left at the lr flag
+static bool ReadOnFootHeader(const uint8_t* data, uint32_t length, uint16_t* playerId, uint32_t* offset, uint32_t* variant)
+{
+	if(length == 0) {
+		return false;
+	}
+	uint32_t end = length * 8;
+	*offset = (data[0] == ID_TIMESTAMP) ? 8 + 32 : 0;
+	*offset += 8;
+	if(*offset + 16 + 1 > end) {
+		return false;
+	}
+	ReadBytesAt<2>(data, *offset, playerId);
+	*offset += 16;
+
+	uint32_t hasLR = BitAt(data, *offset);
+	uint32_t udFlag = *offset + 1 + (hasLR ? 16 : 0);
+	if(udFlag >= end) {
+		return false;
+	}
+	*variant = hasLR | (BitAt(data, udFlag) << 1);
+	return true;
+}
+
+template<typename BR, typename SAMP>
+bool DecodeOnFootSync(const uint8_t* data, uint32_t length, uint16_t* playerId, typename BR::OnFootSync* out, stPackedNormQuat* quat)
+{
+	uint32_t offset, variant;
+	if(!ReadOnFootHeader(data, length, playerId, &offset, &variant)) {
+		return false;
+	}
+	memset(out, 0, sizeof(*out));
+	return g_onFootDecoders<BR, SAMP>[variant](data, offset, length * 8, out, quat);
+}
+
+template<typename SAMP>
+bool PeekOnFootPosition(const uint8_t* data, uint32_t length, uint16_t* playerId, CVector* pos)
+{
+	uint32_t offset, variant;
+	if(!ReadOnFootHeader(data, length, playerId, &offset, &variant)) {
+		return false;
+	}
+	return g_onFootPeeks<SAMP>[variant](data, offset, length * 8, pos);
+}
+
+// id8 player16 | vehicle16 lr16 ud16 keys16 | quat52 pos96 speed32 [+48] | carhealth16 health/armour8 weapon8 | siren1 gear1 trailer1 [trailer16]
+template<typename SAMP>
+struct stInCarLayout
+{
+	static constexpr uint32_t PREFIX = 3 + 8;
+	static constexpr uint32_t QUAT = PREFIX * 8;
+	static constexpr uint32_t POS = QUAT + 4 + 48;
+	static constexpr uint32_t SPEED = POS + 96;
+	static constexpr uint32_t FIXED_END = SPEED + 32;
+	static constexpr uint32_t HEALTH_ARMOUR = 16;
+	static constexpr uint32_t WEAPON = HEALTH_ARMOUR + HEALTH_ARMOUR_BITS<SAMP>;
+	static constexpr uint32_t TAIL_SIZE = WEAPON + 8;
+
+	// where the health block starts, when it and everything before it fit
+	static inline bool TailAt(const uint8_t* data, uint32_t end, float* magnitude, uint32_t* tail)
+	{
+		if(FIXED_END + TAIL_SIZE > end) {
+			return false;
+		}
+		ReadBytesAt<4>(data, SPEED, magnitude);
+		*tail = FIXED_END + (*magnitude != 0.0f ? 48 : 0);
+		return *tail + TAIL_SIZE <= end;
+	}
+};
+
+template<typename BR, typename SAMP>
+bool DecodeInCarSync(const uint8_t* data, uint32_t length, uint16_t* playerId, typename BR::InCarSync* out, stPackedNormQuat* quat)
+{
+	typedef stInCarLayout<SAMP> L;
+	uint32_t end = length * 8;
+	float magnitude;
+	uint32_t tail;
+	if(!L::TailAt(data, end, &magnitude, &tail)) {
+		return false;
+	}
+
+	memset(out, 0, sizeof(*out));
+	memcpy(playerId, data + 1, sizeof(uint16_t));
+	// vehicle id, both analogs and keys are byte aligned and laid out like the struct
+	memcpy(&out->VehicleID, data + 3, 8);
+	ReadPackedNormQuat(data, L::QUAT, quat);
+	ReadBytesAt<12>(data, L::POS, &out->vecPos);
+	if(magnitude != 0.0f) {
+		uint16_t speed[3];
+		ReadBytesAt<6>(data, L::FIXED_END, speed);
+		out->vecMoveSpeed.x = ((float)speed[0] / 32767.5f - 1.0f) * magnitude;
+		out->vecMoveSpeed.y = ((float)speed[1] / 32767.5f - 1.0f) * magnitude;
+		out->vecMoveSpeed.z = ((float)speed[2] / 32767.5f - 1.0f) * magnitude;
+	}
+
+	uint16_t carHealth;
+	ReadBytesAt<2>(data, tail, &carHealth);
+	out->fCarHealth = carHealth;
+	ReadHealthArmour<SAMP>(data, tail + L::HEALTH_ARMOUR, &out->playerHealth, &out->playerArmour);
+	uint8_t weapon;
+	ReadBytesAt<1>(data, tail + L::WEAPON, &weapon);
+	out->byteCurrentWeapon = weapon & 0x3F;
+
+	// the flag bits are optional in practice, whatever is missing reads as off
+	uint32_t flags = tail + L::TAIL_SIZE;
+	if(flags < end && BitAt(data, flags)) {
+		out->byteSirenOn = 1;
+	}
+	if(flags + 1 < end && BitAt(data, flags + 1)) {
+		out->byteLandingGearState = 1;
+	}
+	if(flags + 2 < end && BitAt(data, flags + 2) && flags + 3 + 16 <= end) {
+		ReadBytesAt<2>(data, flags + 3, &out->TrailerID);
+	}
+	return true;
+}
+
+template<typename SAMP>
+bool PeekInCarPosition(const uint8_t* data, uint32_t length, uint16_t* playerId, CVector* pos)
+{
+	typedef stInCarLayout<SAMP> L;
+	float magnitude;
+	uint32_t tail;
+	if(!L::TailAt(data, length * 8, &magnitude, &tail)) {
+		return false;
+	}
+	memcpy(playerId, data + 1, sizeof(uint16_t));
+	ReadBytesAt<12>(data, L::POS, pos);
+	return true;
+}
+
+// every pair in protocol.h
+template bool DecodeOnFootSync<stBRProtocol1, stSampProtocol037>(const uint8_t*, uint32_t, uint16_t*, BROnFootSyncData*, stPackedNormQuat*);
+template bool DecodeInCarSync<stBRProtocol1, stSampProtocol037>(const uint8_t*, uint32_t, uint16_t*, BRInCarSyncData*, stPackedNormQuat*);
+template bool PeekOnFootPosition<stSampProtocol037>(const uint8_t*, uint32_t, uint16_t*, CVector*);
+template bool PeekInCarPosition<stSampProtocol037>(const uint8_t*, uint32_t, uint16_t*, CVector*);
+
+bool DecodeBRPassengerSync(const uint8_t* data, uint32_t length, uint16_t* playerId, uint8_t out[BR_PASSENGER_SYNC_SIZE])
+{
+	if(length < 3 + BR_PASSENGER_SYNC_SIZE) {
+		return false;
+	}
+	memcpy(playerId, data + 1, sizeof(uint16_t));
+	memcpy(out, data + 3, BR_PASSENGER_SYNC_SIZE);
+	return true;
+}
+
+static inline void ScatterScorePing(const uint8_t* record, const stScoresPingsTarget& target)
+{
+	uint16_t id;
+	int score;
+	uint32_t ping;
+	memcpy(&id, record, sizeof(id));
+	memcpy(&score, record + 2, sizeof(score));
+	memcpy(&ping, record + 6, sizeof(ping));
+	if(id == target.localId) {
+		*target.localScore = score;
+		*target.localPing = ping;
+	} else if(id < target.maxPlayers) {
+		target.scores[id] = score;
+		target.pings[id] = ping;
+	}
+}
+
+bool DecodeScoresPings(const uint8_t* data, uint32_t length, const stScoresPingsTarget& target)
+{
+	if(length % SCORES_PINGS_RECORD_SIZE) {
+		return false;
+	}
+	uint32_t count = length / SCORES_PINGS_RECORD_SIZE;
+	uint32_t i = 0;
+	// four records per pass, the loads of one overlap the stores of the last
+	for(; i + 4 <= count; i += 4) {
+		const uint8_t* record = data + i * SCORES_PINGS_RECORD_SIZE;
+		ScatterScorePing(record, target);
+		ScatterScorePing(record + SCORES_PINGS_RECORD_SIZE, target);
+		ScatterScorePing(record + 2 * SCORES_PINGS_RECORD_SIZE, target);
+		ScatterScorePing(record + 3 * SCORES_PINGS_RECORD_SIZE, target);
+	}
+	for(; i < count; i++) {
+		ScatterScorePing(data + i * SCORES_PINGS_RECORD_SIZE, target);
+	}
+	return true;
+}
+
+static inline void DecodeNormQuat(uint16_t qx16, uint16_t qy16, uint16_t qz16, uint8_t signs, float* w, float* x, float* y, float* z)
+{
+	float qx = (float)(qx16 / 65535.0);
+	float qy = (float)(qy16 / 65535.0);
+	float qz = (float)(qz16 / 65535.0);
+	if(signs & 0x40) qx = -qx;
+	if(signs & 0x20) qy = -qy;
+	if(signs & 0x10) qz = -qz;
+	float difference = 1.0f - qx * qx - qy * qy - qz * qz;
+	float qw = sqrtf(difference < 0.0f ? 0.0f : difference);
+	*w = (signs & 0x80) ? -qw : qw;
+	*x = qx;
+	*y = qy;
+	*z = qz;
+}
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+// sign bit of each lane when its bit is set in the signs nibble
+static inline uint32x4_t SignMask(uint32x4_t signs, uint32_t bit)
+{
+	return vshlq_n_u32(vtstq_u32(signs, vdupq_n_u32(bit)), 31);
+}
+
+static inline float32x4_t Unpack(const uint16_t* in, uint32x4_t sign)
+{
+	float32x4_t v = vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vld1_u16(in))), 1.0f / 65535.0f);
+	return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(v), sign));
+}
+#elif defined(__SSE2__)
+static inline __m128i SignMask(__m128i signs, uint32_t bit)
+{
+	__m128i set = _mm_cmpeq_epi32(_mm_and_si128(signs, _mm_set1_epi32(bit)), _mm_set1_epi32(bit));
+	return _mm_slli_epi32(set, 31);
+}
+
+static inline __m128 Unpack(const uint16_t* in, __m128i sign)
+{
+	__m128i wide = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)in), _mm_setzero_si128());
+	__m128 v = _mm_div_ps(_mm_cvtepi32_ps(wide), _mm_set1_ps(65535.0f));
+	return _mm_castsi128_ps(_mm_xor_si128(_mm_castps_si128(v), sign));
+}
+#endif
+
+void DecodeNormQuats(const uint16_t* qx, const uint16_t* qy, const uint16_t* qz, const uint8_t* signs, uint32_t count, float* w, float* x, float* y, float* z)
+{
+	uint32_t i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	for(; i + 4 <= count; i += 4) {
+		uint32_t packedSigns;
+		memcpy(&packedSigns, signs + i, sizeof(packedSigns));
+		uint32x4_t laneSigns = vmovl_u16(vget_low_u16(vmovl_u8(vcreate_u8(packedSigns))));
+		float32x4_t vx = Unpack(qx + i, SignMask(laneSigns, 0x40));
+		float32x4_t vy = Unpack(qy + i, SignMask(laneSigns, 0x20));
+		float32x4_t vz = Unpack(qz + i, SignMask(laneSigns, 0x10));
+
+		float32x4_t d = vmlsq_f32(vdupq_n_f32(1.0f), vx, vx);
+		d = vmlsq_f32(d, vy, vy);
+		d = vmlsq_f32(d, vz, vz);
+		d = vmaxq_f32(d, vdupq_n_f32(0.0f));
+		// sqrt(d) = d / sqrt(d); two Newton steps take the estimate to full float precision
+		float32x4_t r = vrsqrteq_f32(d);
+		r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(d, r), r));
+		r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(d, r), r));
+		float32x4_t vw = vmulq_f32(d, r);
+		// d == 0 gives 0 * inf
+		vw = vbslq_f32(vcgtq_f32(d, vdupq_n_f32(0.0f)), vw, vdupq_n_f32(0.0f));
+		vw = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(vw), SignMask(laneSigns, 0x80)));
+
+		vst1q_f32(w + i, vw);
+		vst1q_f32(x + i, vx);
+		vst1q_f32(y + i, vy);
+		vst1q_f32(z + i, vz);
+	}
+#elif defined(__SSE2__)
+	for(; i + 4 <= count; i += 4) {
+		uint32_t packedSigns;
+		memcpy(&packedSigns, signs + i, sizeof(packedSigns));
+		__m128i bytes = _mm_cvtsi32_si128((int)packedSigns);
+		__m128i laneSigns = _mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, _mm_setzero_si128()), _mm_setzero_si128());
+		__m128 vx = Unpack(qx + i, SignMask(laneSigns, 0x40));
+		__m128 vy = Unpack(qy + i, SignMask(laneSigns, 0x20));
+		__m128 vz = Unpack(qz + i, SignMask(laneSigns, 0x10));
+
+		__m128 d = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(vx, vx));
+		d = _mm_sub_ps(d, _mm_mul_ps(vy, vy));
+		d = _mm_sub_ps(d, _mm_mul_ps(vz, vz));
+		d = _mm_max_ps(d, _mm_setzero_ps());
+		__m128 vw = _mm_castsi128_ps(_mm_xor_si128(_mm_castps_si128(_mm_sqrt_ps(d)), SignMask(laneSigns, 0x80)));
+
+		_mm_storeu_ps(w + i, vw);
+		_mm_storeu_ps(x + i, vx);
+		_mm_storeu_ps(y + i, vy);
+		_mm_storeu_ps(z + i, vz);
+	}
+#endif
+	for(; i < count; i++) {
+		DecodeNormQuat(qx[i], qy[i], qz[i], signs[i], w + i, x + i, y + i, z + i);
+	}
+}
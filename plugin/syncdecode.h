@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common.h"
+#include "protocol.h"
+
+// A ReadNormQuat quaternion as it sits on the wire: |x|, |y|, |z| in 1/65535 steps and
+// the w, x, y, z sign bits in the top nibble of signs. w is rebuilt from the other three.
+struct stPackedNormQuat
+{
+	uint16_t x;
+	uint16_t y;
+	uint16_t z;
+	uint8_t signs;
+};
+
+// Batched ReadNormQuat over structure-of-arrays input, four lanes at a time on NEON or SSE2.
+void DecodeNormQuats(const uint16_t* qx, const uint16_t* qy, const uint16_t* qz, const uint8_t* signs, uint32_t count,
+	float* w, float* x, float* y, float* z);
+
+// The sync decoders are templates over the protocol tags in protocol.h, instantiated in
+// syncdecode.cpp for every pair there; the DecodeBR* / PeekBR* forms below are the pair
+// this build talks.
+
+// Decodes a whole ID_PLAYER_SYNC packet (optional timestamp header included) straight
+// into the struct CRemotePlayer::StoreSyncData takes, except for the rotation, which is
+// left packed in quat for DecodeNormQuats. Returns false for a truncated packet, in
+// which case out must not be used.
+template<typename BR, typename SAMP>
+bool DecodeOnFootSync(const uint8_t* data, uint32_t length, uint16_t* playerId, typename BR::OnFootSync* out, stPackedNormQuat* quat);
+
+// ID_VEHICLE_SYNC: validates the whole length once, then copies the aligned prefix
+// and lifts the rest out at its fixed bit offsets. The rotation is left packed, as above.
+template<typename BR, typename SAMP>
+bool DecodeInCarSync(const uint8_t* data, uint32_t length, uint16_t* playerId, typename BR::InCarSync* out, stPackedNormQuat* quat);
+
+// Only the sender and the position of an ID_PLAYER_SYNC / ID_VEHICLE_SYNC, for players too
+// far away to be worth the whole decode. Accepts whatever the full decoders accept.
+template<typename SAMP>
+bool PeekOnFootPosition(const uint8_t* data, uint32_t length, uint16_t* playerId, CVector* pos);
+template<typename SAMP>
+bool PeekInCarPosition(const uint8_t* data, uint32_t length, uint16_t* playerId, CVector* pos);
+
+inline bool DecodeBROnFootSync(const uint8_t* data, uint32_t length, uint16_t* playerId, BROnFootSyncData* out, stPackedNormQuat* quat)
+{
+	return DecodeOnFootSync<BRProtocol, SampProtocol>(data, length, playerId, out, quat);
+}
+inline bool DecodeBRInCarSync(const uint8_t* data, uint32_t length, uint16_t* playerId, BRInCarSyncData* out, stPackedNormQuat* quat)
+{
+	return DecodeInCarSync<BRProtocol, SampProtocol>(data, length, playerId, out, quat);
+}
+inline bool PeekBROnFootPosition(const uint8_t* data, uint32_t length, uint16_t* playerId, CVector* pos)
+{
+	return PeekOnFootPosition<SampProtocol>(data, length, playerId, pos);
+}
+inline bool PeekBRInCarPosition(const uint8_t* data, uint32_t length, uint16_t* playerId, CVector* pos)
+{
+	return PeekInCarPosition<SampProtocol>(data, length, playerId, pos);
+}
+
+constexpr uint32_t BR_PASSENGER_SYNC_SIZE = stSyncPayload<BRProtocol>::PASSENGER;
+bool DecodeBRPassengerSync(const uint8_t* data, uint32_t length, uint16_t* playerId, uint8_t out[BR_PASSENGER_SYNC_SIZE]);
+
+// RPC_UpdateScoresPingsIPs: uint16 id, int32 score, uint32 ping per player, byte aligned.
+constexpr uint32_t SCORES_PINGS_RECORD_SIZE = 10;
+struct stScoresPingsTarget
+{
+	int* scores;		// indexed by player id, maxPlayers long
+	uint32_t* pings;
+	uint32_t maxPlayers;
+	uint16_t localId;	// goes to localScore/localPing instead
+	int* localScore;
+	uint32_t* localPing;
+};
+// Checks the length once, then scatters every record into the arrays. Returns false, with
+// nothing written, when the payload isn't a whole number of records.
+bool DecodeScoresPings(const uint8_t* data, uint32_t length, const stScoresPingsTarget& target);
@@ -0,0 +1,59 @@
+#include "syncinterest.h"
+#include "config.h"
+#include "thermal.h"
+#include "pools/playergrid.h"
+#include "vendor/RakNet/GetTime.h"
+
+bool CSyncInterest::m_active = false;
+CVector CSyncInterest::m_origin;
+float CSyncInterest::m_nearSq = 0.0f;
+uint32_t CSyncInterest::m_farIntervalMs = 0;
+uint32_t CSyncInterest::m_now = 0;
+uint32_t CSyncInterest::m_lastFullMs[MAX_PLAYERS];
+uint32_t CSyncInterest::m_skipped = 0;
+
+void CSyncInterest::Begin(const CVector* origin)
+{
+	const CConfig::stSyncInterest& config = CConfig::Get().syncInterest;
+	m_active = origin && config.nearRadius;
+	if(!m_active) {
+		return;
+	}
+	m_origin = *origin;
+	m_nearSq = (float)config.nearRadius * (float)config.nearRadius;
+	m_farIntervalMs = CThermal::ScaleSyncInterval(config.farIntervalMs);
+	m_now = RakNet::GetTime();
+}
+
+bool CSyncInterest::IsNear(const CVector& pos)
+{
+	float dx = pos.x - m_origin.x;
+	float dy = pos.y - m_origin.y;
+	return dx * dx + dy * dy <= m_nearSq;
+}
+
+bool CSyncInterest::WantsSync(uint16_t playerId, const CVector& pos)
+{
+	if(!m_active || IsNear(pos) || m_now - m_lastFullMs[playerId] >= m_farIntervalMs) {
+		m_lastFullMs[playerId] = m_now;
+		return true;
+	}
+	// FlushPendingSync won't see this one, the grid still has to
+	CPlayerGrid::Update(playerId, pos);
+	m_skipped++;
+	return false;
+}
+
+bool CSyncInterest::WantsDetail(uint16_t playerId)
+{
+	if(!m_active) {
+		return true;
+	}
+	CVector pos;
+	// not synced yet, nothing says they are far
+	if(!CPlayerGrid::GetPosition(playerId, &pos) || IsNear(pos)) {
+		return true;
+	}
+	m_skipped++;
+	return false;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#include "game/math/vector.h"
+#include "pools/playerpool.h"
+
+// Decides per inbound sync how much of it a remote player is worth, by distance from the
+// local ped. Within nearRadius everything goes through as before. Further out, player and
+// vehicle syncs only keep CPlayerGrid current with their position (the deltas are only peeked
+// for it) and one per farIntervalMs is handed to CRemotePlayer; aim and bullet syncs are dropped
+// unless the bullet hit us. A throttling device stretches farIntervalMs, see CThermal.
+// Radii are 2D like CPlayerGrid's. Game thread only.
+class CSyncInterest
+{
+public:
+	// once per drain; nullptr while there is no local ped, which makes everyone near
+	static void Begin(const CVector* origin);
+	// a player or vehicle sync sent from pos: true when it should be decoded in full
+	static bool WantsSync(uint16_t playerId, const CVector& pos);
+	// aim and bullet syncs, judged by where the player was last synced
+	static bool WantsDetail(uint16_t playerId);
+
+	static uint32_t GetSkipped() { return m_skipped; }
+
+private:
+	static bool IsNear(const CVector& pos);
+
+	static bool m_active;
+	static CVector m_origin;
+	static float m_nearSq;
+	static uint32_t m_farIntervalMs;
+	static uint32_t m_now;
+	static uint32_t m_lastFullMs[MAX_PLAYERS];
+	static uint32_t m_skipped;
+};
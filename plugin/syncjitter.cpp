@@ -0,0 +1,129 @@
+#include "syncjitter.h"
+#include "config.h"
+
+#include <string.h>
+
+CSyncJitter::stPlayer CSyncJitter::m_players[MAX_PLAYERS];
+uint16_t CSyncJitter::m_ids[MAX_PLAYERS];
+uint16_t CSyncJitter::m_idCount = 0;
+uint32_t CSyncJitter::m_late = 0;
+uint32_t CSyncJitter::m_lastDelayMs = 0;
+
+// one stall (a paused server, a backgrounded app) shouldn't read as a second of jitter
+constexpr int32_t MAX_TRANSIT_STEP_MS = 500;
+
+bool CSyncJitter::IsEnabled()
+{
+	return CConfig::Get().syncJitter.depth != 0;
+}
+
+void CSyncJitter::Push(uint16_t playerId, ePendingSync kind, const void* data, uint32_t size, uint32_t time, uint32_t now, uint64_t receivedNs)
+{
+	const CConfig::stSyncJitter& config = CConfig::Get().syncJitter;
+	stPlayer& player = m_players[playerId];
+
+	// time is already on our clock, so transit is the one-way delay plus a constant error
+	int32_t transit = (int32_t)(now - time);
+	if(!player.seeded) {
+		player.seeded = true;
+		player.floor = transit;
+		player.lastTransit = transit;
+		player.offset = transit;
+		player.jitter16 = 0;
+	} else {
+		int32_t step = transit - player.lastTransit;
+		player.lastTransit = transit;
+		step = step < 0 ? -step : step;
+		step = step < MAX_TRANSIT_STEP_MS ? step : MAX_TRANSIT_STEP_MS;
+		// J += (|D| - J) / 16
+		player.jitter16 = player.jitter16 - ((player.jitter16 + 8) >> 4) + (uint32_t)step;
+		player.floor = transit < player.floor + 1 ? transit : player.floor + 1;
+	}
+	uint32_t margin = 3 * (player.jitter16 >> 4);
+	margin = margin < config.maxDelayMs ? margin : config.maxDelayMs;
+	// eased in, a sudden change of offset would bunch releases up or stretch them out
+	player.offset += (player.floor + (int32_t)margin - player.offset) / 8;
+	m_lastDelayMs = player.offset > player.floor ? (uint32_t)(player.offset - player.floor) : 0;
+
+	uint32_t releaseAt = time + (uint32_t)player.offset;
+	if(player.count && (int32_t)(releaseAt - player.lastReleaseAt) < 0) {
+		releaseAt = player.lastReleaseAt;
+	}
+	if((int32_t)(releaseAt - (now + config.maxDelayMs)) > 0) {
+		releaseAt = now + config.maxDelayMs;
+	}
+	if((int32_t)(releaseAt - now) < 0) {
+		releaseAt = now;
+		m_late++;
+	}
+	player.lastReleaseAt = releaseAt;
+
+	if(player.count == RING) {
+		player.head = (player.head + 1) % RING;
+		player.count--;
+	}
+	stBufferedSync& sync = player.ring[(player.head + player.count) % RING];
+	sync.playerId = playerId;
+	sync.kind = kind;
+	sync.time = time;
+	sync.releaseAt = releaseAt;
+	sync.receivedNs = receivedNs;
+	memcpy(sync.data, data, size);
+	player.count++;
+	// past depth the oldest go now, whatever the estimate says
+	for(uint32_t i = 0; i + config.depth < player.count; i++) {
+		player.ring[(player.head + i) % RING].releaseAt = now;
+	}
+
+	if(!player.listed) {
+		player.listed = true;
+		m_ids[m_idCount++] = playerId;
+	}
+}
+
+uint16_t CSyncJitter::Release(uint32_t now, stBufferedSync* due[])
+{
+	uint16_t count = 0;
+	for(uint16_t i = 0; i < m_idCount; )
+	{
+		stPlayer& player = m_players[m_ids[i]];
+		stBufferedSync* newest = nullptr;
+		while(player.count && (int32_t)(now - player.ring[player.head].releaseAt) >= 0) {
+			newest = &player.ring[player.head];
+			player.head = (player.head + 1) % RING;
+			player.count--;
+		}
+		if(newest) {
+			due[count++] = newest;
+		}
+		if(!player.count) {
+			player.listed = false;
+			m_ids[i] = m_ids[--m_idCount];
+			continue;
+		}
+		i++;
+	}
+	return count;
+}
+
+void CSyncJitter::Reset(uint16_t playerId)
+{
+	if(playerId >= MAX_PLAYERS) {
+		return;
+	}
+	// Release drops the id from the list once it finds nothing queued
+	m_players[playerId].count = 0;
+	m_players[playerId].seeded = false;
+}
+
+void CSyncJitter::Clear()
+{
+	for(uint16_t i = 0; i < m_idCount; i++) {
+		m_players[m_ids[i]].listed = false;
+	}
+	m_idCount = 0;
+	for(uint16_t i = 0; i < MAX_PLAYERS; i++) {
+		m_players[i].count = 0;
+		m_players[i].seeded = false;
+	}
+}
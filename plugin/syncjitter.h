@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include "syncdecode.h"
+#include "pools/playerpool.h"
+
+enum ePendingSync : uint8_t
+{
+	PENDING_NONE,
+	PENDING_ON_FOOT,
+	PENDING_IN_CAR,
+	PENDING_PASSENGER
+};
+
+// a decoded player, vehicle or passenger sync waiting for its turn
+struct stBufferedSync
+{
+	static constexpr uint32_t MAX_SIZE = sizeof(BRInCarSyncData) > sizeof(BROnFootSyncData) ?
+		sizeof(BRInCarSyncData) : sizeof(BROnFootSyncData);
+
+	uint16_t playerId;
+	ePendingSync kind;
+	uint32_t time;			// as GetPacketTime gave it, handed on to CRemotePlayer unchanged
+	uint32_t releaseAt;		// RakNet::GetTime
+	uint64_t receivedNs;	// Packet::receivedNs, for NETSTAT_IN_WIRE
+	uint8_t data[MAX_SIZE];
+};
+static_assert(BR_PASSENGER_SYNC_SIZE <= stBufferedSync::MAX_SIZE, "passenger sync fits the slot");
+
+// Per player playout buffer for syncs. Each one is held until its server timestamp plus an
+// offset learnt from that player's own arrivals: the lowest transit seen lately, plus three
+// times the RFC 3550 jitter estimate, capped at maxDelayMs. Releases then follow the spacing
+// the server sampled at rather than the spacing the network delivered, so a late packet
+// followed by an early one no longer reads as a stop and a jump. At most depth syncs wait
+// per player; one more forces the oldest out, which bounds the added latency even when the
+// estimate is off. Game thread only.
+class CSyncJitter
+{
+public:
+	static bool IsEnabled();
+
+	static void Push(uint16_t playerId, ePendingSync kind, const void* data, uint32_t size, uint32_t time, uint32_t now, uint64_t receivedNs);
+	// the newest due sync per player, older due ones are passed over; valid until the next Push
+	static uint16_t Release(uint32_t now, stBufferedSync* due[]);
+
+	static void Reset(uint16_t playerId);
+	static void Clear();
+
+	// syncs that came in after their own release time, i.e. the buffer was too shallow
+	static uint32_t GetLate() { return m_late; }
+	// the last player's playout offset over its lowest transit, for the stats window
+	static uint32_t GetDelayMs() { return m_lastDelayMs; }
+
+private:
+	// depth 2 plus the one being pushed
+	static constexpr uint32_t RING = 3;
+
+	struct stPlayer
+	{
+		stBufferedSync ring[RING];
+		uint8_t head;
+		uint8_t count;
+		bool seeded;
+		bool listed;
+		int32_t floor;			// lowest transit lately, creeps up 1 ms per sync
+		int32_t lastTransit;
+		int32_t offset;			// releaseAt - time
+		uint32_t jitter16;		// RFC 3550 J, in 1/16 ms
+		uint32_t lastReleaseAt;
+	};
+
+	static stPlayer m_players[MAX_PLAYERS];
+	static uint16_t m_ids[MAX_PLAYERS];
+	static uint16_t m_idCount;
+	static uint32_t m_late;
+	static uint32_t m_lastDelayMs;
+};
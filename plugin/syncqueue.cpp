@@ -0,0 +1,129 @@
+#include "syncqueue.h"
+#include "netcapture.h"
+#include "netgame.h"
+#include "netstats.h"
+#include "syncdecode.h"
+
+#include <string.h>
+
+#include "vendor/RakNet/PacketEnumerations.h"
+#include "vendor/RakNet/RakClientInterface.h"
+
+DataStructures::SingleProducerConsumer<stDecodedSync> CSyncQueue::m_queue;
+std::atomic<uint32_t> CSyncQueue::m_session(0);
+std::atomic<uint8_t> CSyncQueue::m_epochs[MAX_PLAYERS];
+std::atomic<uint32_t> CSyncQueue::m_dropped(0);
+
+void CSyncQueue::Initialise(RakClientInterface* client)
+{
+	if(!client) {
+		return;
+	}
+	client->SetReceiveFilter(ID_PLAYER_SYNC, OnReceive);
+	client->SetReceiveFilter(ID_VEHICLE_SYNC, OnReceive);
+	client->SetReceiveFilter(ID_PASSENGER_SYNC, OnReceive);
+}
+
+void CSyncQueue::Detach(RakClientInterface* client)
+{
+	client->SetReceiveFilter(ID_PLAYER_SYNC, nullptr);
+	client->SetReceiveFilter(ID_VEHICLE_SYNC, nullptr);
+	client->SetReceiveFilter(ID_PASSENGER_SYNC, nullptr);
+}
+
+// quatw..quatz are consecutive, and the structs are packed
+static void UnpackQuat(const stPackedNormQuat& packed, void* target)
+{
+	float quat[4];
+	DecodeNormQuats(&packed.x, &packed.y, &packed.z, &packed.signs, 1, &quat[0], &quat[1], &quat[2], &quat[3]);
+	memcpy(target, quat, sizeof(quat));
+}
+
+static bool Decode(uint8_t packetId, const uint8_t* data, uint32_t length, stDecodedSync* out)
+{
+	stPackedNormQuat quat;
+	switch(packetId)
+	{
+		case ID_PLAYER_SYNC: {
+			BROnFootSyncData* sync = (BROnFootSyncData*)out->data;
+			if(!DecodeBROnFootSync(data, length, &out->playerId, sync, &quat)) {
+				return false;
+			}
+			UnpackQuat(quat, &sync->quatw);
+			out->kind = PENDING_ON_FOOT;
+			return true;
+		}
+		case ID_VEHICLE_SYNC: {
+			BRInCarSyncData* sync = (BRInCarSyncData*)out->data;
+			if(!DecodeBRInCarSync(data, length, &out->playerId, sync, &quat)) {
+				return false;
+			}
+			UnpackQuat(quat, &sync->quatw);
+			out->kind = PENDING_IN_CAR;
+			return true;
+		}
+		case ID_PASSENGER_SYNC:
+			out->kind = PENDING_PASSENGER;
+			return DecodeBRPassengerSync(data, length, &out->playerId, out->data);
+		default:
+			return false;
+	}
+}
+
+void CSyncQueue::OnReceive(Packet* packet)
+{
+	uint8_t packetId = GetPacketID(packet);
+	CNetCapture::Record(CAPTURE_PACKET, packetId, packet->data, BYTES_TO_BITS(packet->length));
+	CNetStats::Scope stats(NETSTAT_IN_PACKET, packetId, packet->length);
+	if(m_queue.Size() >= MAX_QUEUED) {
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	// the session goes with it before the decode, so a Drop from here on catches it
+	uint32_t session = m_session.load(std::memory_order_relaxed);
+	stDecodedSync* slot = m_queue.WriteLock();
+	if(!Decode(packetId, packet->data, packet->length, slot)) {
+		m_queue.CancelWriteLock(slot);
+		return;
+	}
+	slot->packetId = packetId;
+	slot->length = (uint16_t)packet->length;
+	slot->time = GetPacketTime(packet);
+	slot->session = session;
+	// read after the decode: the RPC that makes it stale is only queued once this returns
+	slot->epoch = slot->playerId < MAX_PLAYERS ? m_epochs[slot->playerId].load(std::memory_order_relaxed) : 0;
+	slot->queuedNs = CNetStats::Now();
+	slot->receivedNs = packet->receivedNs;
+	m_queue.WriteUnlock();
+}
+
+bool CSyncQueue::Take(stDecodedSync* out)
+{
+	uint32_t session = m_session.load(std::memory_order_relaxed);
+	stDecodedSync* slot;
+	while((slot = m_queue.ReadLock())) {
+		bool current = slot->session == session
+			&& (slot->playerId >= MAX_PLAYERS || slot->epoch == m_epochs[slot->playerId].load(std::memory_order_relaxed));
+		if(current) {
+			CNetStats::Record(NETSTAT_IN_QUEUE, slot->packetId, slot->length, CNetStats::Now() - slot->queuedNs);
+			*out = *slot;
+		}
+		m_queue.ReadUnlock();
+		if(current) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void CSyncQueue::Forget(uint16_t playerId)
+{
+	if(playerId < MAX_PLAYERS) {
+		m_epochs[playerId].fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void CSyncQueue::Drop()
+{
+	m_session.fetch_add(1, std::memory_order_relaxed);
+}
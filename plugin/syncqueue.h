@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "syncjitter.h"
+#include "vendor/RakNet/NetworkTypes.h"
+#include "vendor/RakNet/SingleProducerConsumer.h"
+
+class RakClientInterface;
+
+// a player, vehicle or passenger sync as the update thread left it, rotation included
+struct stDecodedSync
+{
+	uint16_t playerId;
+	ePendingSync kind;
+	uint8_t packetId;
+	uint16_t length;		// of the packet, for the stats
+	uint32_t time;			// GetPacketTime
+	uint32_t session;		// see Drop
+	uint8_t epoch;			// see Forget
+	uint64_t queuedNs;		// CNetStats::Now, once decoded
+	uint64_t receivedNs;	// Packet::receivedNs
+	uint8_t data[stBufferedSync::MAX_SIZE];
+};
+
+// ID_PLAYER_SYNC, ID_VEHICLE_SYNC and ID_PASSENGER_SYNC decoded on the RakNet update thread as
+// they come out of the reliability layer, see RakPeer::SetReceiveFilter, so the bit reading and
+// the quaternion rebuild are done before ProcessNetwork runs. ProcessNetwork takes the finished
+// structs off a single producer queue and only picks which ones CRemotePlayer gets. The delta
+// forms still go through Receive: CDeltaSync's baselines belong to the game thread.
+class CSyncQueue
+{
+public:
+	// a game thread that stops draining (a load, an early connect being held) stops the queue
+	// here; whatever arrives past it is dropped, the syncs after the stall supersede it anyway
+	static constexpr int MAX_QUEUED = 4096;
+
+	static void Initialise(RakClientInterface* client);
+	// takes the filters off a client that is no longer pRakClient; its update thread must have
+	// stopped already, Disconnect waits for it, so only one thread ever fills the queue
+	static void Detach(RakClientInterface* client);
+
+	// game thread: the oldest sync still current, false once the queue is empty
+	static bool Take(stDecodedSync* out);
+	// game thread, on a lost connection: nothing decoded so far is handed out after this,
+	// including what the update thread is decoding right now
+	static void Drop();
+
+	// game thread, when a player id quits or joins. The update thread decodes ahead of the
+	// drain, so a sync queued before that RPC came through is the previous player's and Take
+	// drops it. One decoded after it but before the drain got to the RPC goes the same way;
+	// the next sync for the new player stands in for it.
+	static void Forget(uint16_t playerId);
+
+	static uint32_t GetDropped() { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+	static void OnReceive(Packet* packet);
+
+	static DataStructures::SingleProducerConsumer<stDecodedSync> m_queue;
+	static std::atomic<uint32_t> m_session;
+	// bumped per id by Forget; the update thread tags each sync with the one it saw
+	static std::atomic<uint8_t> m_epochs[MAX_PLAYERS];
+	static std::atomic<uint32_t> m_dropped;
+};
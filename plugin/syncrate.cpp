@@ -0,0 +1,106 @@
+#include "syncrate.h"
+#include "capabilities.h"
+#include "vendor/RakNet/GetTime.h"
+#include "vendor/RakNet/RakClientInterface.h"
+#include "vendor/RakNet/RakNetStatistics.h"
+
+extern RakClientInterface* pRakClient;
+
+bool CSyncRate::m_active = false;
+float CSyncRate::m_rateHz = 0.0f;
+uint32_t CSyncRate::m_nextTick[2];
+uint32_t CSyncRate::m_lastEval = 0;
+uint32_t CSyncRate::m_lastSent = 0;
+uint32_t CSyncRate::m_lastResends = 0;
+float CSyncRate::m_minRtt = 0.0f;
+uint32_t CSyncRate::m_dropped = 0;
+
+// resends per thousand messages sent that count as loss, judged over at least MIN_SENT
+constexpr uint32_t LOSS_PER_MILLE = 20;
+constexpr uint32_t MIN_SENT = 20;
+// RTT this far over the lowest seen lately is a queue somewhere on the path
+constexpr float QUEUE_DELAY_MS = 50.0f;
+// messages RakNet hasn't even put on the wire yet
+constexpr uint32_t MAX_BACKLOG = 16;
+
+static void Sample(const RakNetStatisticsStruct* s, uint32_t* sent, uint32_t* backlog)
+{
+	*sent = 0;
+	*backlog = 0;
+	for(int i = 0; i < NUMBER_OF_PRIORITIES; i++) {
+		*sent += s->messagesSent[i];
+		*backlog += s->messageSendBuffer[i];
+	}
+}
+
+void CSyncRate::Reset()
+{
+	m_active = false;
+	m_minRtt = 0.0f;
+}
+
+void CSyncRate::Update()
+{
+	if(!CCapabilities::Has(CCapabilities::CAP_SYNC_RATE)) {
+		m_active = false;
+		return;
+	}
+	RakNetStatisticsStruct* s = pRakClient->IsConnected() ? pRakClient->GetStatistics() : nullptr;
+	if(!s) {
+		return;
+	}
+	uint32_t now = RakNet::GetTime();
+	float minHz = CCapabilities::GetSyncMinHz();
+	float maxHz = CCapabilities::GetSyncMaxHz();
+	uint32_t sent, backlog;
+	Sample(s, &sent, &backlog);
+	if(!m_active) {
+		// a fresh link gets the benefit of the doubt
+		m_active = true;
+		m_rateHz = maxHz;
+		m_nextTick[0] = m_nextTick[1] = now;
+		m_lastEval = now;
+		m_lastSent = sent;
+		m_lastResends = s->messageResends;
+		return;
+	}
+	if(now - m_lastEval < EVAL_MS) {
+		return;
+	}
+	m_lastEval = now;
+
+	uint32_t sentDelta = sent - m_lastSent;
+	uint32_t resendDelta = s->messageResends - m_lastResends;
+	m_lastSent = sent;
+	m_lastResends = s->messageResends;
+	bool lossy = sentDelta >= MIN_SENT && resendDelta * 1000 > sentDelta * LOSS_PER_MILLE;
+
+	// the lowest RTT lately is the path without queueing; it creeps up so a new route is learnt
+	float rtt = (float)s->smoothedRoundTripTime;
+	bool queued = false;
+	if(rtt > 0.0f) {
+		m_minRtt = !m_minRtt || rtt < m_minRtt ? rtt : m_minRtt + 1.0f;
+		queued = rtt > m_minRtt + QUEUE_DELAY_MS;
+	}
+
+	if(lossy || queued || backlog > MAX_BACKLOG) {
+		m_rateHz = m_rateHz * 0.75f > minHz ? m_rateHz * 0.75f : minHz;
+	} else {
+		m_rateHz = m_rateHz + 1.0f < maxHz ? m_rateHz + 1.0f : maxHz;
+	}
+}
+
+bool CSyncRate::AdmitTick(int slot)
+{
+	uint32_t now = RakNet::GetTime();
+	uint32_t interval = (uint32_t)(1000.0f / m_rateHz);
+	int32_t late = (int32_t)(now - m_nextTick[slot]);
+	if(late < 0) {
+		m_dropped++;
+		return false;
+	}
+	// kept on a grid so a rate between two frame rates averages out; far behind, the grid
+	// starts over rather than letting a burst through
+	m_nextTick[slot] = late < (int32_t)interval ? m_nextTick[slot] + interval : now + interval;
+	return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+#include "common.h"
+
+// Paces the game's player and vehicle sync ticks to what the link takes, within the bounds
+// our server sent with CAP_SYNC_RATE. Every EVAL_MS the reliability layer's smoothed RTT,
+// resend ratio and send backlog are checked: a link that looks congested gets a quarter
+// fewer syncs per second, a healthy one one more, additive increase and multiplicative
+// decrease as in TCP. Ticks over the rate are dropped before translation, so they cost
+// nothing further and never queue up behind each other as stale state. Without the
+// capability every tick goes out as before. Game thread only.
+class CSyncRate
+{
+public:
+	static constexpr uint32_t EVAL_MS = 250;
+
+	// once per frame
+	static void Update();
+	static void Reset();
+
+	// false when a sync tick of brId should be dropped
+	static inline bool Admit(uint8_t brId)
+	{
+		if(!m_active || (brId != BR_ID_PLAYER_SYNC && brId != BR_ID_VEHICLE_SYNC)) {
+			return true;
+		}
+		return AdmitTick(brId == BR_ID_VEHICLE_SYNC);
+	}
+
+	// 0 while not controlling
+	static uint32_t GetRateHz() { return m_active ? (uint32_t)m_rateHz : 0; }
+	static uint32_t GetDropped() { return m_dropped; }
+
+private:
+	static bool AdmitTick(int slot);
+
+	static bool m_active;
+	static float m_rateHz;
+	static uint32_t m_nextTick[2];
+	static uint32_t m_lastEval;
+	static uint32_t m_lastSent;
+	static uint32_t m_lastResends;
+	static float m_minRtt;
+	static uint32_t m_dropped;
+};
@@ -0,0 +1,28 @@
+#include "systrace.h"
+#include "xorstr.h"
+
+#include <android/log.h>
+#include <dlfcn.h>
+
+bool (*CSystrace::m_pfnIsEnabled)() = nullptr;
+void (*CSystrace::m_pfnBegin)(const char* name) = nullptr;
+void (*CSystrace::m_pfnEnd)() = nullptr;
+
+void CSystrace::Initialise()
+{
+	// API 23+; the game links against an older NDK, so this can't be a plain import
+	void* handle = dlopen(xorstr("libandroid.so"), RTLD_NOW | RTLD_LOCAL);
+	if(!handle) {
+		return;
+	}
+	auto isEnabled = (bool (*)())dlsym(handle, xorstr("ATrace_isEnabled"));
+	auto begin = (void (*)(const char*))dlsym(handle, xorstr("ATrace_beginSection"));
+	auto end = (void (*)())dlsym(handle, xorstr("ATrace_endSection"));
+	if(!isEnabled || !begin || !end) {
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Systrace"), xorstr("ATrace unavailable, no trace markers"));
+		return;
+	}
+	m_pfnBegin = begin;
+	m_pfnEnd = end;
+	m_pfnIsEnabled = isEnabled;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+// Markers for systrace/Perfetto around the plugin's hooks, so their cost lines up with
+// the game's own slices in a system trace. ATrace_* is looked up in libandroid at
+// startup; on older systems, or while nothing is recording, a section costs one call.
+class CSystrace
+{
+public:
+	class Scope
+	{
+	public:
+		// name has to outlive the scope, xorstr() literals do
+		explicit Scope(const char* name) : m_bActive(IsEnabled())
+		{
+			if(m_bActive) {
+				m_pfnBegin(name);
+			}
+		}
+		~Scope()
+		{
+			if(m_bActive) {
+				m_pfnEnd();
+			}
+		}
+	private:
+		bool m_bActive;
+	};
+
+	static void Initialise();
+	static inline bool IsEnabled() { return m_pfnIsEnabled && m_pfnIsEnabled(); }
+
+private:
+	static bool (*m_pfnIsEnabled)();
+	static void (*m_pfnBegin)(const char* name);
+	static void (*m_pfnEnd)();
+};
+
+#define SYSTRACE_CONCAT2(a, b) a##b
+#define SYSTRACE_CONCAT(a, b) SYSTRACE_CONCAT2(a, b)
+#define SYSTRACE_SCOPE(name) CSystrace::Scope SYSTRACE_CONCAT(systraceScope, __LINE__)(name)
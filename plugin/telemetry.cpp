@@ -0,0 +1,235 @@
+#include "telemetry.h"
+#include "joinhandshake.h"
+#include "lz4.h"
+#include "resolver.h"
+#include "syncinterest.h"
+#include "xorstr.h"
+#include "config.h"
+#include "workers.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/system_properties.h>
+#include <unistd.h>
+#include <vector>
+
+#include "vendor/RakNet/RakClientInterface.h"
+#include "vendor/RakNet/RakNetStatistics.h"
+
+extern RakClientInterface* pRakClient;
+
+std::atomic<uint32_t> CTelemetry::m_counters[TELEMETRY_COUNTER_COUNT];
+CTelemetry::stIdTotals CTelemetry::m_lastIds[NETSTAT_KIND_COUNT][256];
+uint32_t CTelemetry::m_lastHistogram[NETSTAT_KIND_COUNT][CNetStats::HISTOGRAM_BUCKETS];
+uint32_t CTelemetry::m_lastCounters[TELEMETRY_COUNTER_COUNT];
+uint32_t CTelemetry::m_lastSyncsSkipped = 0;
+uint32_t CTelemetry::m_lastResends = 0;
+uint32_t CTelemetry::m_lastResendTimeouts = 0;
+uint64_t CTelemetry::m_startUs = 0;
+uint64_t CTelemetry::m_lastReportUs = 0;
+uint64_t CTelemetry::m_lastFrameUs = 0;
+uint32_t CTelemetry::m_frames = 0;
+uint64_t CTelemetry::m_frameUs = 0;
+uint32_t CTelemetry::m_worstFrameUs = 0;
+
+// one datagram that no path in practice fragments
+static constexpr uint32_t MAX_DATAGRAM = 1200;
+static constexpr uint32_t HEADER_SIZE = 8;
+// DSCP CS1, lower effort than the default class
+static constexpr int TOS_LOWER_EFFORT = 0x20;
+
+struct stWriter
+{
+	uint8_t* cursor;
+	uint8_t* end;
+
+	void Varint(uint64_t value)
+	{
+		do {
+			if(cursor == end) {
+				return;
+			}
+			*cursor++ = (uint8_t)((value & 0x7F) | (value >= 0x80 ? 0x80 : 0));
+			value >>= 7;
+		} while(value);
+	}
+	void Bytes(const void* data, uint32_t size)
+	{
+		Varint(size);
+		if(size > (uint32_t)(end - cursor)) {
+			cursor = end;
+			return;
+		}
+		memcpy(cursor, data, size);
+		cursor += size;
+	}
+};
+
+// counters can go back when someone resets the stats panel or RakNet starts a new connection;
+// what was counted since then is the best guess
+template<typename T>
+static T Delta(T current, T last)
+{
+	return current >= last ? current - last : current;
+}
+
+void CTelemetry::Process()
+{
+	const CConfig::stTelemetry& config = CConfig::Get().telemetry;
+	if(config.host.empty() || !config.port) {
+		return;
+	}
+
+	uint64_t now = CNetStats::Now() / 1000;
+	if(!m_startUs) {
+		m_startUs = m_lastReportUs = m_lastFrameUs = now;
+		return;
+	}
+	uint32_t frameUs = (uint32_t)(now - m_lastFrameUs);
+	m_lastFrameUs = now;
+	m_frames++;
+	m_frameUs += frameUs;
+	if(frameUs > m_worstFrameUs) {
+		m_worstFrameUs = frameUs;
+	}
+
+	if(now - m_lastReportUs < (uint64_t)config.intervalMs * 1000) {
+		return;
+	}
+	// numeric hosts answer at once, names keep the report waiting a few frames at most
+	char address[16];
+	if(!CResolver::Lookup(config.host.c_str(), address)) {
+		return;
+	}
+	Report((uint32_t)((now - m_lastReportUs) / 1000), address, config.port);
+	m_lastReportUs = now;
+	m_frames = 0;
+	m_frameUs = 0;
+	m_worstFrameUs = 0;
+}
+
+void CTelemetry::Report(uint32_t intervalMs, const char* address, uint16_t port)
+{
+	static char model[PROP_VALUE_MAX] = "";
+	if(!model[0]) {
+		__system_property_get(xorstr("ro.product.model"), model);
+	}
+
+	// everything the report covers is taken once, so the two encodings below agree
+	static stIdTotals ids[NETSTAT_KIND_COUNT][256];
+	uint32_t histogram[NETSTAT_KIND_COUNT][CNetStats::HISTOGRAM_BUCKETS] = {};
+	for(int kind = 0; kind < NETSTAT_KIND_COUNT; kind++) {
+		for(int id = 0; id < 256; id++) {
+			const CNetStats::stEntry& entry = CNetStats::GetEntry((eNetStatKind)kind, (uint8_t)id);
+			stIdTotals current = {
+				entry.count.load(std::memory_order_relaxed),
+				entry.bytes.load(std::memory_order_relaxed),
+				entry.totalNs.load(std::memory_order_relaxed)
+			};
+			stIdTotals& last = m_lastIds[kind][id];
+			ids[kind][id] = { Delta(current.count, last.count), Delta(current.bytes, last.bytes), Delta(current.ns, last.ns) };
+			last = current;
+			for(int bucket = 0; bucket < CNetStats::HISTOGRAM_BUCKETS; bucket++) {
+				histogram[kind][bucket] += entry.histogram[bucket].load(std::memory_order_relaxed);
+			}
+		}
+		for(int bucket = 0; bucket < CNetStats::HISTOGRAM_BUCKETS; bucket++) {
+			uint32_t total = histogram[kind][bucket];
+			histogram[kind][bucket] = Delta(total, m_lastHistogram[kind][bucket]);
+			m_lastHistogram[kind][bucket] = total;
+		}
+	}
+	uint32_t counters[TELEMETRY_COUNTER_COUNT];
+	for(int i = 0; i < TELEMETRY_COUNTER_COUNT; i++) {
+		uint32_t total = m_counters[i].load(std::memory_order_relaxed);
+		counters[i] = total - m_lastCounters[i];
+		m_lastCounters[i] = total;
+	}
+	uint32_t syncsSkipped = CSyncInterest::GetSkipped() - m_lastSyncsSkipped;
+	m_lastSyncsSkipped = CSyncInterest::GetSkipped();
+
+	RakNetStatisticsStruct* link = pRakClient && pRakClient->IsConnected() ? pRakClient->GetStatistics() : nullptr;
+	uint32_t rttMs = link ? (uint32_t)link->smoothedRoundTripTime : 0;
+	uint32_t resends = link ? Delta(link->messageResends, m_lastResends) : 0;
+	uint32_t resendTimeouts = link ? Delta(link->resendTimeouts, m_lastResendTimeouts) : 0;
+	m_lastResends = link ? link->messageResends : 0;
+	m_lastResendTimeouts = link ? link->resendTimeouts : 0;
+
+	static uint8_t raw[8 * 1024];
+	static uint8_t packet[HEADER_SIZE + lz4::Bound(sizeof(raw))];
+	for(int withIds = 1; withIds >= 0; withIds--)
+	{
+		stWriter w = { raw, raw + sizeof(raw) };
+		w.Varint(intervalMs);
+		w.Varint((m_lastFrameUs - m_startUs) / 1000000);
+		w.Bytes(model, (uint32_t)strlen(model));
+		w.Varint(m_frames);
+		w.Varint(m_frameUs);
+		w.Varint(m_worstFrameUs);
+		for(int i = 0; i < TELEMETRY_COUNTER_COUNT; i++) {
+			w.Varint(counters[i]);
+		}
+		w.Varint(syncsSkipped);
+		w.Varint(rttMs);
+		w.Varint(resends);
+		w.Varint(resendTimeouts);
+		w.Varint(CJoinHandshake::HasReached(JOIN_SPAWNED) ? CJoinHandshake::GetStageMs(JOIN_SPAWNED) : 0);
+		for(int kind = 0; kind < NETSTAT_KIND_COUNT; kind++)
+		{
+			stIdTotals total = {};
+			uint32_t used = 0;
+			for(int id = 0; id < 256; id++) {
+				total.count += ids[kind][id].count;
+				total.bytes += ids[kind][id].bytes;
+				total.ns += ids[kind][id].ns;
+				used += ids[kind][id].count != 0;
+			}
+			w.Varint(total.count);
+			w.Varint(total.bytes);
+			w.Varint(total.ns / 1000);
+			w.Varint(CNetStats::Percentile(histogram[kind], 500));
+			w.Varint(CNetStats::Percentile(histogram[kind], 990));
+			w.Varint(withIds ? used : 0);
+			for(int id = 0; withIds && id < 256; id++) {
+				if(ids[kind][id].count) {
+					w.Varint(id);
+					w.Varint(ids[kind][id].count);
+					w.Varint(ids[kind][id].bytes);
+					w.Varint(ids[kind][id].ns / 1000);
+				}
+			}
+		}
+		if(w.cursor == w.end) {
+			continue;
+		}
+
+		uint32_t rawSize = (uint32_t)(w.cursor - raw);
+		uint32_t compressed = lz4::Compress(raw, rawSize, packet + HEADER_SIZE, sizeof(packet) - HEADER_SIZE);
+		if(!compressed || HEADER_SIZE + compressed > MAX_DATAGRAM) {
+			continue;
+		}
+		uint16_t version = VERSION, size = (uint16_t)rawSize;
+		memcpy(packet, &MAGIC, 4);
+		memcpy(packet + 4, &version, 2);
+		memcpy(packet + 6, &size, 2);
+
+		std::vector<uint8_t> datagram(packet, packet + HEADER_SIZE + compressed);
+		sockaddr_in to = {};
+		to.sin_family = AF_INET;
+		to.sin_port = htons(port);
+		to.sin_addr.s_addr = inet_addr(address);
+		CWorkers::Submit([datagram, to] {
+			int s = socket(AF_INET, SOCK_DGRAM, 0);
+			if(s < 0) {
+				return;
+			}
+			int tos = TOS_LOWER_EFFORT;
+			setsockopt(s, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+			sendto(s, datagram.data(), datagram.size(), 0, (const sockaddr*)&to, sizeof(to));
+			close(s);
+		});
+		return;
+	}
+}
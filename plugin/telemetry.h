@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "netstats.h"
+
+// events counted for the report, from any thread
+enum eTelemetryCounter
+{
+	TELEMETRY_RECONNECT,		// CReconnect scheduled another attempt
+	TELEMETRY_CONNECTION_LOST,
+	TELEMETRY_COUNTER_COUNT
+};
+
+// Fleet performance reports for our own collector. Every intervalMs the counters the plugin
+// already keeps - CNetStats, the link's RakNet statistics, frame pacing and a few event
+// counts - are turned into what changed since the last report, LZ4 compressed and sent by a
+// worker as one UDP datagram from a socket of its own, marked CS1 (lower effort) so routers
+// that care queue it behind game traffic. Nothing is sent per event, and nothing at all
+// without a configured collector. A lost report only widens the gap between two others.
+//
+// Datagram: uint32 MAGIC, uint16 VERSION, uint16 raw size, the LZ4 block of the raw body.
+// Body, every number a varint:
+//
+//   intervalMs, uptimeS, model (length + bytes)
+//   frames, frameUs (sum), worstFrameUs
+//   counters[TELEMETRY_COUNTER_COUNT], syncsSkipped
+//   rttMs, resends, resendTimeouts, joinMs (0 if the last join didn't finish)
+//   per eNetStatKind: count, bytes, us, p50 ns, p99 ns, ids, then per id: id, count, bytes, us
+//
+// When that doesn't fit one datagram, the report goes out with the totals per kind only.
+class CTelemetry
+{
+public:
+	static constexpr uint32_t MAGIC = 0x4D545242; // "BRTM"
+	// 2: NETSTAT_OUT_WIRE and NETSTAT_IN_WIRE joined the per kind list
+	static constexpr uint16_t VERSION = 2;
+
+	// once per frame on the game thread
+	static void Process();
+
+	static inline void Count(eTelemetryCounter counter)
+	{
+		m_counters[counter].fetch_add(1, std::memory_order_relaxed);
+	}
+
+private:
+	struct stIdTotals
+	{
+		uint32_t count;
+		uint64_t bytes;
+		uint64_t ns;
+	};
+
+	static void Report(uint32_t intervalMs, const char* address, uint16_t port);
+
+	static std::atomic<uint32_t> m_counters[TELEMETRY_COUNTER_COUNT];
+	// what the last report covered, so the next one carries the difference
+	static stIdTotals m_lastIds[NETSTAT_KIND_COUNT][256];
+	static uint32_t m_lastHistogram[NETSTAT_KIND_COUNT][CNetStats::HISTOGRAM_BUCKETS];
+	static uint32_t m_lastCounters[TELEMETRY_COUNTER_COUNT];
+	static uint32_t m_lastSyncsSkipped;
+	static uint32_t m_lastResends;
+	static uint32_t m_lastResendTimeouts;
+
+	static uint64_t m_startUs;
+	static uint64_t m_lastReportUs;
+	static uint64_t m_lastFrameUs;
+	static uint32_t m_frames;
+	static uint64_t m_frameUs;
+	static uint32_t m_worstFrameUs;
+};
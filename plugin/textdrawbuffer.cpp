@@ -0,0 +1,138 @@
+#include "textdrawbuffer.h"
+
+#include <string.h>
+
+#include "vendor/RakNet/SAMP/SAMPRPC.h"
+
+CTextDrawBuffer::stTextDraw CTextDrawBuffer::m_textDraws[MAX_TEXTDRAWS];
+CTextDrawBuffer::stPending CTextDrawBuffer::m_shows[MAX_TEXTDRAWS];
+CTextDrawBuffer::stPending CTextDrawBuffer::m_edits[MAX_TEXTDRAWS];
+std::vector<uint16_t> CTextDrawBuffer::m_dirty;
+void (*CTextDrawBuffer::m_showHandler)(RPCParameters*) = nullptr;
+void (*CTextDrawBuffer::m_editHandler)(RPCParameters*) = nullptr;
+RakPeerInterface* CTextDrawBuffer::m_recipient = nullptr;
+PlayerID CTextDrawBuffer::m_sender = UNASSIGNED_PLAYER_ID;
+
+static uint32_t HashPayload(const unsigned char* data, uint32_t size)
+{
+	uint32_t hash = 2166136261u;
+	for(uint32_t i = 0; i < size; i++) {
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+	// 0 means "no edit" in stTextDraw
+	return hash ? hash : 1;
+}
+
+bool CTextDrawBuffer::IsBuffered(int rpcId)
+{
+	return rpcId == RPC_ScrShowTextDraw || rpcId == RPC_ScrEditTextDraw || rpcId == RPC_ScrHideTextDraw;
+}
+
+void CTextDrawBuffer::Store(stPending& pending, const RPCParameters* rpcParams, uint32_t hash)
+{
+	uint32_t inputLen = BITS_TO_BYTES(rpcParams->numberOfBitsOfData);
+	pending.bits = rpcParams->numberOfBitsOfData;
+	pending.hash = hash;
+	// assign keeps the capacity, so a textdraw updated every frame stops allocating
+	pending.payload.assign(rpcParams->input, rpcParams->input + inputLen);
+}
+
+bool CTextDrawBuffer::Hide(uint16_t id)
+{
+	stTextDraw& textDraw = m_textDraws[id];
+	bool cancelledShow = textDraw.pendingShow;
+	textDraw.pendingShow = false;
+	textDraw.pendingEdit = false;
+	if(!textDraw.shown && cancelledShow) {
+		// the game never got to see it
+		return true;
+	}
+	textDraw.shown = false;
+	textDraw.editHash = 0;
+	return false;
+}
+
+bool CTextDrawBuffer::Push(int rpcId, const RPCParameters* rpcParams, void (*handler)(RPCParameters*))
+{
+	uint32_t inputLen = BITS_TO_BYTES(rpcParams->numberOfBitsOfData);
+	if(inputLen < sizeof(uint16_t)) {
+		return false;
+	}
+	uint16_t id;
+	memcpy(&id, rpcParams->input, sizeof(id));
+	if(id >= MAX_TEXTDRAWS) {
+		return false;
+	}
+	stTextDraw& textDraw = m_textDraws[id];
+	if(rpcId == RPC_ScrHideTextDraw) {
+		return Hide(id);
+	}
+
+	uint32_t hash = HashPayload(rpcParams->input, inputLen);
+	bool idle = !textDraw.pendingShow && !textDraw.pendingEdit;
+	if(rpcId == RPC_ScrShowTextDraw)
+	{
+		if(idle && textDraw.shown && textDraw.showHash == hash && !textDraw.editHash) {
+			return true;
+		}
+		m_showHandler = handler;
+		Store(m_shows[id], rpcParams, hash);
+		// the new show carries its own text, an earlier edit is moot
+		textDraw.pendingShow = true;
+		textDraw.pendingEdit = false;
+	}
+	else
+	{
+		if(idle && textDraw.editHash == hash) {
+			return true;
+		}
+		m_editHandler = handler;
+		Store(m_edits[id], rpcParams, hash);
+		textDraw.pendingEdit = true;
+	}
+
+	m_recipient = rpcParams->recipient;
+	m_sender = rpcParams->sender;
+	if(idle) {
+		m_dirty.push_back(id);
+	}
+	return true;
+}
+
+void CTextDrawBuffer::Apply(stPending& pending, void (*handler)(RPCParameters*))
+{
+	RPCParameters rpcParams;
+	rpcParams.input = pending.payload.data();
+	rpcParams.numberOfBitsOfData = pending.bits;
+	rpcParams.sender = m_sender;
+	rpcParams.recipient = m_recipient;
+	rpcParams.replyToSender = nullptr;
+	handler(&rpcParams);
+}
+
+void CTextDrawBuffer::Flush()
+{
+	for(uint16_t id : m_dirty)
+	{
+		stTextDraw& textDraw = m_textDraws[id];
+		if(textDraw.pendingShow) {
+			Apply(m_shows[id], m_showHandler);
+			textDraw.shown = true;
+			textDraw.showHash = m_shows[id].hash;
+			textDraw.editHash = 0;
+		}
+		if(textDraw.pendingEdit) {
+			Apply(m_edits[id], m_editHandler);
+			textDraw.editHash = m_edits[id].hash;
+		}
+		textDraw.pendingShow = false;
+		textDraw.pendingEdit = false;
+	}
+	m_dirty.clear();
+}
+
+void CTextDrawBuffer::Clear()
+{
+	memset(m_textDraws, 0, sizeof(m_textDraws));
+	m_dirty.clear();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vendor/RakNet/NetworkTypes.h"
+
+// ScrShowTextDraw and ScrEditTextDraw coalesced per textdraw and frame. HUD scripts
+// resend the same textdraws many times a second and every RPC makes the game rebuild
+// one, so within a frame only the latest show and the latest edit after it are kept, and
+// Flush hands them on. One that matches what the game already has is dropped outright.
+// ScrHideTextDraw goes through at once, after whatever it makes pointless is thrown
+// away. Game thread only.
+class CTextDrawBuffer
+{
+public:
+	// global ones plus the per-player range in SA-MP; larger ids go straight through
+	static constexpr uint32_t MAX_TEXTDRAWS = 2048 + 256;
+
+	static bool IsBuffered(int rpcId);
+	// true when the RPC was taken (queued or dropped), false to run the handler now
+	static bool Push(int rpcId, const RPCParameters* rpcParams, void (*handler)(RPCParameters*));
+	static void Flush();
+	// the game forgets its textdraws with the connection
+	static void Clear();
+
+private:
+	struct stPending
+	{
+		uint32_t bits = 0;
+		uint32_t hash = 0;
+		std::vector<unsigned char> payload;
+	};
+	struct stTextDraw
+	{
+		// what the game was last given
+		bool shown;
+		uint32_t showHash;
+		uint32_t editHash;	// 0 when nothing was edited since the show
+		// waiting for Flush; the edit is applied after the show
+		bool pendingShow;
+		bool pendingEdit;
+	};
+
+	static bool Hide(uint16_t id);
+	static void Store(stPending& pending, const RPCParameters* rpcParams, uint32_t hash);
+	static void Apply(stPending& pending, void (*handler)(RPCParameters*));
+
+	static stTextDraw m_textDraws[MAX_TEXTDRAWS];
+	static stPending m_shows[MAX_TEXTDRAWS];
+	static stPending m_edits[MAX_TEXTDRAWS];
+	// ids with anything pending, in the order they were first touched this frame
+	static std::vector<uint16_t> m_dirty;
+	static void (*m_showHandler)(RPCParameters*);
+	static void (*m_editHandler)(RPCParameters*);
+	static RakPeerInterface* m_recipient;
+	static PlayerID m_sender;
+};
@@ -0,0 +1,121 @@
+#include "thermal.h"
+#include "config.h"
+#include "tracering.h"
+#include "workers.h"
+#include "xorstr.h"
+#include "vendor/RakNet/GetTime.h"
+#include "vendor/RakNet/RakClientInterface.h"
+
+#include <android/log.h>
+#include <dlfcn.h>
+
+extern RakClientInterface* pRakClient;
+
+void* CThermal::m_pManager = nullptr;
+int (*CThermal::m_pfnGetStatus)(void* manager) = nullptr;
+std::atomic<int32_t> CThermal::m_status(-1);
+std::atomic<eThermalLevel> CThermal::m_level(THERMAL_NORMAL);
+bool CThermal::m_polling = false;
+uint32_t CThermal::m_lastPoll = 0;
+uint32_t CThermal::m_coolSince = 0;
+
+// AThermalStatus values the levels start at
+constexpr int32_t ATHERMAL_STATUS_MODERATE = 2;
+constexpr int32_t ATHERMAL_STATUS_SEVERE = 3;
+
+static const uint32_t g_overlayDivider[THERMAL_LEVEL_COUNT] = { 1, 2, 4 };
+static const uint32_t g_syncIntervalScale[THERMAL_LEVEL_COUNT] = { 1, 2, 4 };
+// RakPeer::SetMinUpdateInterval
+static const int g_networkIntervalMs[THERMAL_LEVEL_COUNT] = { 0, 5, 10 };
+
+void CThermal::Initialise()
+{
+	if(!CConfig::Get().thermalMode) {
+		return;
+	}
+	void* handle = dlopen(xorstr("libandroid.so"), RTLD_NOW | RTLD_LOCAL);
+	if(!handle) {
+		return;
+	}
+	auto acquire = (void* (*)())dlsym(handle, xorstr("AThermal_acquireManager"));
+	auto getStatus = (int (*)(void*))dlsym(handle, xorstr("AThermal_getCurrentThermalStatus"));
+	void* manager = acquire && getStatus ? acquire() : nullptr;
+	if(!manager) {
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Thermal"), xorstr("AThermal unavailable, no thermal mode"));
+		return;
+	}
+	m_pManager = manager;
+	m_pfnGetStatus = getStatus;
+}
+
+void CThermal::Process()
+{
+	if(!m_pfnGetStatus || m_polling) {
+		return;
+	}
+	uint32_t now = RakNet::GetTime();
+	if(m_lastPoll && now - m_lastPoll < POLL_MS) {
+		return;
+	}
+	m_lastPoll = now;
+	m_polling = true;
+	// a binder call to the thermal service, kept off the game thread
+	CWorkers::Submit([] {
+		m_status.store(m_pfnGetStatus(m_pManager), std::memory_order_relaxed);
+	}, [] {
+		m_polling = false;
+		Apply();
+	});
+}
+
+void CThermal::Apply()
+{
+	int32_t status = m_status.load(std::memory_order_relaxed);
+	if(status < 0) {
+		return;
+	}
+	eThermalLevel target = status >= ATHERMAL_STATUS_SEVERE ? THERMAL_HOT :
+		(status >= ATHERMAL_STATUS_MODERATE ? THERMAL_WARM : THERMAL_NORMAL);
+	eThermalLevel level = m_level.load(std::memory_order_relaxed);
+	uint32_t now = RakNet::GetTime();
+	if(target >= level) {
+		m_coolSince = 0;
+	} else if(!m_coolSince) {
+		m_coolSince = now;
+	}
+	if(target == level || (target < level && now - m_coolSince < COOL_MS)) {
+		return;
+	}
+	m_coolSince = 0;
+	m_level.store(target, std::memory_order_relaxed);
+	if(pRakClient) {
+		ApplyTo(pRakClient);
+	}
+	CTraceRing::Trace(TRACE_THERMAL, (uint32_t)status, target);
+	__android_log_print(ANDROID_LOG_INFO, xorstr("Thermal"), xorstr("status %d, %s"), status, GetLevelName(target));
+}
+
+const char* CThermal::GetLevelName(eThermalLevel level)
+{
+	switch(level)
+	{
+		case THERMAL_WARM: return "warm";
+		case THERMAL_HOT: return "hot";
+		default: return "normal";
+	}
+}
+
+uint32_t CThermal::GetOverlayDivider()
+{
+	return g_overlayDivider[GetLevel()];
+}
+
+uint32_t CThermal::ScaleSyncInterval(uint32_t intervalMs)
+{
+	return intervalMs * g_syncIntervalScale[GetLevel()];
+}
+
+void CThermal::ApplyTo(RakClientInterface* client)
+{
+	client->SetMinUpdateInterval(g_networkIntervalMs[GetLevel()]);
+}
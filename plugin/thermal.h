@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+class RakClientInterface;
+
+enum eThermalLevel : uint8_t
+{
+	THERMAL_NORMAL,		// AThermal NONE or LIGHT
+	THERMAL_WARM,		// MODERATE
+	THERMAL_HOT,		// SEVERE and up
+	THERMAL_LEVEL_COUNT
+};
+
+// Backs the plugin's own work off while the device throttles. AThermal_getCurrentThermalStatus
+// (API 30, looked up in libandroid like ATrace) is read on a worker every POLL_MS; as the level
+// rises the ImGui overlay is rebuilt on fewer swaps, far players' syncs are coalesced over a
+// longer interval (see CSyncInterest) and the RakNet update thread batches its wakeups.
+// A hotter reading applies at once, a cooler one only after COOL_MS of them, so a status
+// hovering on a boundary doesn't flip the settings back and forth.
+class CThermal
+{
+public:
+	static constexpr uint32_t POLL_MS = 2000;
+	static constexpr uint32_t COOL_MS = 10000;
+
+	static void Initialise();
+	// once per game tick
+	static void Process();
+
+	// from any thread
+	static eThermalLevel GetLevel() { return m_level.load(std::memory_order_relaxed); }
+	// AThermalStatus as last read, -1 when unknown
+	static int32_t GetStatus() { return m_status.load(std::memory_order_relaxed); }
+	static const char* GetLevelName(eThermalLevel level);
+
+	// the overlay is built on one swap in this many and redrawn as it was on the others
+	static uint32_t GetOverlayDivider();
+	static uint32_t ScaleSyncInterval(uint32_t intervalMs);
+	// the current level's update interval onto a client, for one swapped in after the level was set
+	static void ApplyTo(RakClientInterface* client);
+
+private:
+	static void Apply();
+
+	static void* m_pManager;
+	static int (*m_pfnGetStatus)(void* manager);
+	static std::atomic<int32_t> m_status;
+	static std::atomic<eThermalLevel> m_level;
+	static bool m_polling;
+	static uint32_t m_lastPoll;
+	static uint32_t m_coolSince;
+};
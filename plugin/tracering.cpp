@@ -0,0 +1,106 @@
+#include "tracering.h"
+#include "xorstr.h"
+
+#include <android/log.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+std::atomic<stTraceHeader*> CTraceRing::m_pHeader(nullptr);
+stTraceRecord* CTraceRing::m_pRecords = nullptr;
+uint32_t CTraceRing::m_mask = 0;
+
+static const char* const g_eventNames[TRACE_EVENT_COUNT] = {
+	"none",
+	"opened",
+	"net drain",
+	"connection",
+	"join stage",
+	"reconnect",
+	"unknown rpc",
+	"thermal",
+	"join stall",
+	"stall",
+	"stall frame",
+	"server query"
+};
+
+static uint64_t ClockNs(clockid_t clock)
+{
+	struct timespec ts;
+	clock_gettime(clock, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+bool CTraceRing::Open(const char* path, const char* previousPath, uint32_t records)
+{
+	if(m_pHeader.load(std::memory_order_relaxed) || records < 2) {
+		return false;
+	}
+	uint32_t capacity = 1;
+	while(capacity <= records / 2) {
+		capacity <<= 1;
+	}
+
+	rename(path, previousPath);
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0) {
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Trace"), xorstr("can't create %s"), path);
+		return false;
+	}
+	size_t size = sizeof(stTraceHeader) + (size_t)capacity * sizeof(stTraceRecord);
+	void* map = MAP_FAILED;
+	if(ftruncate(fd, (off_t)size) == 0) {
+		map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	// the mapping keeps the file
+	close(fd);
+	if(map == MAP_FAILED) {
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Trace"), xorstr("can't map %s"), path);
+		return false;
+	}
+
+	// a fresh file reads as zeroes, so every record starts out as never written
+	stTraceHeader* header = (stTraceHeader*)map;
+	header->magic = stTraceHeader::MAGIC;
+	header->version = stTraceHeader::VERSION;
+	header->recordSize = sizeof(stTraceRecord);
+	header->capacity = capacity;
+	header->openedRealtimeNs = ClockNs(CLOCK_REALTIME);
+	header->openedMonotonicNs = ClockNs(CLOCK_MONOTONIC);
+	header->head.store(0, std::memory_order_relaxed);
+	m_pRecords = (stTraceRecord*)(header + 1);
+	m_mask = capacity - 1;
+	m_pHeader.store(header, std::memory_order_release);
+
+	Trace(TRACE_OPENED, (uint32_t)getpid());
+	return true;
+}
+
+void CTraceRing::Write(eTraceEvent event, uint32_t a, uint32_t b, uint32_t c)
+{
+	static thread_local uint32_t tid = (uint32_t)syscall(SYS_gettid);
+
+	stTraceHeader* header = m_pHeader.load(std::memory_order_relaxed);
+	uint64_t slot = header->head.fetch_add(1, std::memory_order_relaxed);
+	stTraceRecord* record = &m_pRecords[slot & m_mask];
+	// cleared first, so a writer dying halfway leaves a record tracedump skips
+	__atomic_store_n(&record->sequence, 0, __ATOMIC_RELAXED);
+	std::atomic_thread_fence(std::memory_order_release);
+	record->timeNs = ClockNs(CLOCK_MONOTONIC);
+	record->event = event;
+	record->tid = tid;
+	record->args[0] = a;
+	record->args[1] = b;
+	record->args[2] = c;
+	__atomic_store_n(&record->sequence, (uint32_t)slot + 1, __ATOMIC_RELEASE);
+}
+
+const char* CTraceRing::GetName(uint16_t event)
+{
+	return event < TRACE_EVENT_COUNT ? g_eventNames[event] : "?";
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// args in the order they are passed to Trace
+enum eTraceEvent : uint16_t
+{
+	TRACE_NONE,
+	TRACE_OPENED,			// pid
+	TRACE_NET_DRAIN,		// packets, us spent in ProcessNetwork
+	TRACE_CONNECTION,		// ID_CONNECTION_* or similar packet id that changed the link
+	TRACE_JOIN_STAGE,		// eJoinStage, ms since connecting
+	TRACE_RECONNECT,		// ms until the next attempt, endpoints
+	TRACE_UNKNOWN_RPC,		// BR RPC id with no SA-MP counterpart
+	TRACE_THERMAL,			// AThermalStatus, eThermalLevel now in force
+	TRACE_JOIN_STALL,		// eJoinStage it stalled at, ms since connecting
+	TRACE_STALL,			// eStallSite, ms the game thread had been in it, frames that follow
+	TRACE_STALL_FRAME,		// frame index, pc low 32 bits, pc high 32 bits
+	TRACE_SERVER_QUERY,		// endpoints that answered, endpoints queried, best ping ms
+	TRACE_EVENT_COUNT
+};
+
+struct stTraceRecord
+{
+	uint64_t timeNs;		// CLOCK_MONOTONIC
+	// the slot's sequence number + 1, stored last; anything else means torn or stale
+	uint32_t sequence;
+	uint16_t event;
+	uint16_t reserved;
+	uint32_t tid;
+	uint32_t args[3];
+};
+static_assert(sizeof(stTraceRecord) == 32, "records are read back by tools/tracedump");
+
+struct stTraceHeader
+{
+	static constexpr uint32_t MAGIC = 0x52545242; // "BRTR"
+	static constexpr uint32_t VERSION = 1;
+
+	uint32_t magic;
+	uint32_t version;
+	uint32_t recordSize;
+	uint32_t capacity;		// records, a power of two
+	// the two clocks read together at open, to put wall clock times on records
+	uint64_t openedRealtimeNs;
+	uint64_t openedMonotonicNs;
+	// records ever written; slot = head % capacity
+	std::atomic<uint64_t> head;
+	uint8_t reserved[24];
+};
+static_assert(sizeof(stTraceHeader) == 64, "records start on a cache line");
+
+// Binary event ring in a file mapped MAP_SHARED, so whatever was written is in the page
+// cache and reaches the disk even when the process dies the next instant. A record costs a
+// clock read, one atomic add and 32 bytes, from any thread; before Open, one load.
+// The previous session's file is kept beside the new one, which is the one wanted after a
+// crash. tools/tracedump prints either.
+class CTraceRing
+{
+public:
+	// records is rounded down to a power of two
+	static bool Open(const char* path, const char* previousPath, uint32_t records);
+
+	static inline void Trace(eTraceEvent event, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0)
+	{
+		if(m_pHeader.load(std::memory_order_acquire)) {
+			Write(event, a, b, c);
+		}
+	}
+
+	static const char* GetName(uint16_t event);
+
+private:
+	static void Write(eTraceEvent event, uint32_t a, uint32_t b, uint32_t c);
+
+	static std::atomic<stTraceHeader*> m_pHeader;
+	static stTraceRecord* m_pRecords;
+	static uint32_t m_mask;
+};
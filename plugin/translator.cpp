@@ -0,0 +1,188 @@
+#include "translator.h"
+#include "arena.h"
+#include "common.h"
+#include "synccodec.h"
+#include "pools/vehiclepool.h"
+#include "plugin.h"
+
+#include <string.h>
+
+#include "vendor/RakNet/GetTime.h"
+#include "vendor/RakNet/PacketEnumerations.h"
+
+stPacketTranslator CPacketTranslator::m_translators[256];
+
+static thread_local uint8_t s_scratch[CPacketTranslator::MAX_PACKET_SIZE];
+static thread_local uint8_t s_padded[CPacketTranslator::MAX_PACKET_SIZE];
+
+struct stLastSent
+{
+	uint32_t sentAt;
+	uint32_t length;
+	uint8_t bytes[CPacketTranslator::MAX_PACKET_SIZE];
+};
+// by BR id, for the translators with a keepalive; taken from the arena on first use
+static stLastSent* s_lastSent[256];
+
+// The game always sends full payloads, but a short one must not make us read past it:
+// zero-fill the missing tail exactly like the old field-by-field reads left it empty.
+static const uint8_t* Pad(const uint8_t* in, uint32_t inLen, uint32_t size)
+{
+	if(inLen >= size) {
+		return in;
+	}
+	memcpy(s_padded, in, inLen);
+	memset(s_padded + inLen, 0, size - inLen);
+	return s_padded;
+}
+
+uint8_t* CPacketTranslator::GetScratch()
+{
+	return s_scratch;
+}
+
+static_assert(stSyncPayload<stBRProtocol1>::ONFOOT == 70 && stSyncPayload<stBRProtocol1>::INCAR == 61
+	&& stSyncPayload<stBRProtocol1>::PASSENGER == 26, "BR sync sizes as the game sends them");
+static_assert(stSyncPayload<stSampProtocol037>::ONFOOT == 68 && stSyncPayload<stSampProtocol037>::INCAR == 63
+	&& stSyncPayload<stSampProtocol037>::PASSENGER == 24, "SA-MP sync sizes as the 0.3.7 server reads them");
+
+// BR:    lr16 ud16 keys16 pos96 quat128 health16 armour16 weapon8 action8 move96 surf96 surfinfo16 anim32
+// SA-MP: lr16 ud16 keys16 pos96 quat128 health8  armour8  weapon8 action8 move96 surf96 surfinfo16 anim32
+template<typename BR, typename SAMP>
+uint32_t CPacketTranslator::OnFootSync(const uint8_t* in, uint32_t inLen, uint8_t* out)
+{
+	typedef stSyncPayload<BR> In;
+	typedef stSyncPayload<SAMP> Out;
+	in = Pad(in, inLen, In::ONFOOT);
+	memcpy(out, in, Out::ONFOOT_HEAD);
+	CopyHealthArmour<BR, SAMP>(in + In::ONFOOT_HEAD, out + Out::ONFOOT_HEAD);
+	memcpy(out + Out::ONFOOT - Out::ONFOOT_TAIL, in + In::ONFOOT - In::ONFOOT_TAIL, Out::ONFOOT_TAIL);
+	return Out::ONFOOT;
+}
+
+// BR:    vehid16 lr16 ud16 keys16 quat128 pos96 move96 carhealth32 health16 armour16 weapon8 siren8 gear8 trailer16
+// SA-MP: vehid16 lr16 ud16 keys16 quat128 pos96 move96 carhealth32 health8  armour8  weapon8 siren8 gear8 trailer16 trainspeed32
+template<typename BR, typename SAMP>
+uint32_t CPacketTranslator::InCarSync(const uint8_t* in, uint32_t inLen, uint8_t* out)
+{
+	typedef stSyncPayload<BR> In;
+	typedef stSyncPayload<SAMP> Out;
+	in = Pad(in, inLen, In::INCAR);
+	memcpy(out, in, Out::INCAR_HEAD);
+	CopyHealthArmour<BR, SAMP>(in + In::INCAR_HEAD, out + Out::INCAR_HEAD);
+	memcpy(out + Out::INCAR_TRAIN - Out::INCAR_TAIL, in + In::INCAR_TRAIN - In::INCAR_TAIL, Out::INCAR_TAIL);
+	if constexpr(SAMP::INCAR_TRAIN_SPEED && BR::INCAR_TRAIN_SPEED) {
+		memcpy(out + Out::INCAR_TRAIN, in + In::INCAR_TRAIN, 4);
+	} else if constexpr(SAMP::INCAR_TRAIN_SPEED) {
+		memset(out + Out::INCAR_TRAIN, 0, 4);
+	}
+	return Out::INCAR;
+}
+
+// BR:    vehid16 seat7 driveby1 weapon8 health16 armour16 lr16 ud16 keys16 pos96
+// SA-MP: vehid16 (seat:7 | driveby:1 as a packed byte) weapon8 health8 armour8 lr16 ud16 keys16 pos96
+template<typename BR, typename SAMP>
+uint32_t CPacketTranslator::PassengerSync(const uint8_t* in, uint32_t inLen, uint8_t* out)
+{
+	typedef stSyncPayload<BR> In;
+	typedef stSyncPayload<SAMP> Out;
+	in = Pad(in, inLen, In::PASSENGER);
+	memcpy(out, in, 2);
+	// the BR stream carries the seat flags in the high 7 bits; SA-MP wants them in the low 7
+	out[2] = RotateRight<8 + BR::PASSENGER_SEAT_SHIFT - SAMP::PASSENGER_SEAT_SHIFT>(in[2]);
+	out[3] = in[3];
+	CopyHealthArmour<BR, SAMP>(in + In::PASSENGER_HEAD, out + Out::PASSENGER_HEAD);
+	memcpy(out + Out::PASSENGER - Out::PASSENGER_TAIL, in + In::PASSENGER - In::PASSENGER_TAIL, Out::PASSENGER_TAIL);
+	return Out::PASSENGER;
+}
+
+template<uint32_t SIZE>
+uint32_t CPacketTranslator::Passthrough(const uint8_t* in, uint32_t inLen, uint8_t* out)
+{
+	memcpy(out, Pad(in, inLen, SIZE), SIZE);
+	return SIZE;
+}
+
+// Lights and siren state on the driven vehicle have to be forced on our side while driving
+static void OnVehicleSyncSend(const uint8_t* in, uint32_t inLen)
+{
+	uint16_t VehicleID = 0;
+	if(inLen >= sizeof(VehicleID)) {
+		memcpy(&VehicleID, in, sizeof(VehicleID));
+	}
+	CVehiclePool::OnDriverSync(VehicleID);
+}
+
+void CPacketTranslator::Register(uint8_t brId, const stPacketTranslator& translator)
+{
+	m_translators[brId] = translator;
+}
+
+template<typename BR, typename SAMP>
+void CPacketTranslator::RegisterSync()
+{
+	Register(BR_ID_PLAYER_SYNC, { OnFootSync<BR, SAMP>, ID_PLAYER_SYNC, stSyncPayload<BR>::ONFOOT, stSyncPayload<SAMP>::ONFOOT, SEND_CLASS_SYNC, UNRELIABLE_SEQUENCED, nullptr, true, false, false });
+	Register(BR_ID_VEHICLE_SYNC, { InCarSync<BR, SAMP>, ID_VEHICLE_SYNC, stSyncPayload<BR>::INCAR, stSyncPayload<SAMP>::INCAR, SEND_CLASS_SYNC, UNRELIABLE_SEQUENCED, OnVehicleSyncSend, true, false, false });
+	Register(BR_ID_PASSENGER_SYNC, { PassengerSync<BR, SAMP>, ID_PASSENGER_SYNC, stSyncPayload<BR>::PASSENGER, stSyncPayload<SAMP>::PASSENGER, SEND_CLASS_SYNC, UNRELIABLE_SEQUENCED, nullptr, true, false, false });
+}
+
+void CPacketTranslator::Initialise()
+{
+	// every bullet counts, the other syncs are state snapshots
+	Register(BR_ID_AIM_SYNC, { Passthrough<AIM_SIZE>, ID_AIM_SYNC, AIM_SIZE, AIM_SIZE, SEND_CLASS_COMBAT, UNRELIABLE_SEQUENCED, nullptr, true, true, true });
+	Register(BR_ID_BULLET_SYNC, { Passthrough<BULLET_SIZE>, ID_BULLET_SYNC, BULLET_SIZE, BULLET_SIZE, SEND_CLASS_COMBAT, UNRELIABLE_SEQUENCED, nullptr, false, true, true });
+	RegisterSync<BRProtocol, SampProtocol>();
+}
+
+void CPacketTranslator::SetKeepalive(uint8_t brId, uint32_t keepaliveMs)
+{
+	m_translators[brId].keepaliveMs = keepaliveMs;
+	if(s_lastSent[brId]) {
+		*s_lastSent[brId] = stLastSent();
+	}
+}
+
+bool CPacketTranslator::IsRepeat(uint8_t brId, const uint8_t* packet, uint32_t packetLen)
+{
+	uint32_t keepaliveMs = m_translators[brId].keepaliveMs;
+	if(!keepaliveMs || packetLen > MAX_PACKET_SIZE) {
+		return false;
+	}
+	stLastSent*& last = s_lastSent[brId];
+	if(!last) {
+		last = CArena::New<stLastSent>();
+	}
+	uint32_t now = RakNet::GetTime();
+	if(last->length == packetLen && now - last->sentAt < keepaliveMs && memcmp(last->bytes, packet, packetLen) == 0) {
+		return true;
+	}
+	last->sentAt = now;
+	last->length = packetLen;
+	memcpy(last->bytes, packet, packetLen);
+	return false;
+}
+
+uint32_t CPacketTranslator::Translate(const stPacketTranslator* translator, const uint8_t* packet, uint32_t packetLen, uint8_t* out)
+{
+	const uint8_t* payload = packet + 1;
+	uint32_t payloadLen = packetLen - 1;
+	if(translator->onSend) {
+		translator->onSend(payload, payloadLen);
+	}
+	out[0] = translator->outId;
+	return 1 + translator->translate(payload, payloadLen, out + 1);
+}
+
+uint32_t CPacketTranslator::TranslateInPlace(const stPacketTranslator* translator, uint8_t* packet, uint32_t packetLen)
+{
+	// a short payload still needs Pad's zero fill
+	if(!translator->inPlace || packetLen - 1 < translator->inSize) {
+		return 0;
+	}
+	if(translator->onSend) {
+		translator->onSend(packet + 1, packetLen - 1);
+	}
+	packet[0] = translator->outId;
+	// anything past the payload was never sent either
+	return 1 + translator->outSize;
+}
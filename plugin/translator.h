@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include "protocol.h"
+#include "sendclass.h"
+#include "vendor/RakNet/PacketPriority.h"
+
+// Rewrites outbound BR sync payloads (the bytes following the packet id) into the
+// SA-MP layout. Every field on both sides is byte aligned, so a translation is a few
+// memcpy and byte picks into the caller's buffer, with no BitStream or intermediate struct.
+//
+// Translators live in a table indexed by the BR packet id, so dispatch is one load and a
+// new packet type only needs a Register call.
+typedef uint32_t (*PacketTranslateFn)(const uint8_t* in, uint32_t inLen, uint8_t* out);
+typedef void (*PacketSendCallback)(const uint8_t* in, uint32_t inLen);
+
+struct stPacketTranslator
+{
+	PacketTranslateFn translate;
+	uint8_t outId;
+	uint32_t inSize;	// BR payload bytes
+	uint32_t outSize;	// SA-MP payload bytes
+	eSendClass sendClass;	// the priority comes from its class, see CSendClass
+	PacketReliability reliability;
+	PacketSendCallback onSend;	// optional, runs before translation
+	bool supersede;	// only the newest queued copy is worth sending, see RakPeer::SetSequencedSupersede
+	bool immediate;	// latency bound, sent from the game thread, see RakPeer::SetImmediateSend
+	bool inPlace;	// the payload goes out as it is, see TranslateInPlace
+	uint32_t keepaliveMs;	// repeats of the last packet sent are dropped for this long, 0 never drops
+};
+
+class CPacketTranslator
+{
+public:
+	// Large enough for any translated sync packet, including the id byte
+	static constexpr uint32_t MAX_PACKET_SIZE = 128;
+
+	static constexpr uint32_t BR_ONFOOT_SIZE = stSyncPayload<BRProtocol>::ONFOOT;
+	static constexpr uint32_t BR_INCAR_SIZE = stSyncPayload<BRProtocol>::INCAR;
+	static constexpr uint32_t BR_PASSENGER_SIZE = stSyncPayload<BRProtocol>::PASSENGER;
+	static constexpr uint32_t AIM_SIZE = 31;
+	static constexpr uint32_t BULLET_SIZE = 40;
+
+	// registers the sync translators of the BRProtocol / SampProtocol pair
+	static void Initialise();
+	template<typename BR, typename SAMP>
+	static void RegisterSync();
+	static void Register(uint8_t brId, const stPacketTranslator& translator);
+	static const stPacketTranslator* Find(uint8_t brId) { return m_translators[brId].translate ? &m_translators[brId] : nullptr; }
+
+	// An idle player still syncs at full rate. True when the translated packet is the one last
+	// sent and that went out less than the translator's keepaliveMs ago, so it need not go again.
+	static bool IsRepeat(uint8_t brId, const uint8_t* packet, uint32_t packetLen);
+	// from the config on connect; also forgets what was last sent
+	static void SetKeepalive(uint8_t brId, uint32_t keepaliveMs);
+
+	// Translates a whole BR packet (id byte included) into out, returns the SA-MP packet length
+	static uint32_t Translate(const stPacketTranslator* translator, const uint8_t* packet, uint32_t packetLen, uint8_t* out);
+	// For inPlace translators only the id byte differs, so it is rewritten in the caller's packet
+	// and the SA-MP length returned; 0 when the packet has to go through Translate instead
+	static uint32_t TranslateInPlace(const stPacketTranslator* translator, uint8_t* packet, uint32_t packetLen);
+
+	// Each returns the number of payload bytes written to out; BR and SAMP are tags from protocol.h
+	template<typename BR, typename SAMP>
+	static uint32_t OnFootSync(const uint8_t* in, uint32_t inLen, uint8_t* out);
+	template<typename BR, typename SAMP>
+	static uint32_t InCarSync(const uint8_t* in, uint32_t inLen, uint8_t* out);
+	template<typename BR, typename SAMP>
+	static uint32_t PassengerSync(const uint8_t* in, uint32_t inLen, uint8_t* out);
+	template<uint32_t SIZE>
+	static uint32_t Passthrough(const uint8_t* in, uint32_t inLen, uint8_t* out);
+
+	// Per-thread output buffer of MAX_PACKET_SIZE bytes
+	static uint8_t* GetScratch();
+private:
+	static stPacketTranslator m_translators[256];
+};
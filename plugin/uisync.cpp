@@ -0,0 +1,316 @@
+#include "uisync.h"
+#include "plugin.h"
+
+#include <string.h>
+
+struct stJsonCursor
+{
+	const char* p;
+	const char* end;
+};
+
+static void SkipSpace(stJsonCursor& c)
+{
+	while(c.p < c.end && (*c.p == ' ' || *c.p == '\t' || *c.p == '\n' || *c.p == '\r')) {
+		c.p++;
+	}
+}
+
+static bool Expect(stJsonCursor& c, char ch)
+{
+	SkipSpace(c);
+	if(c.p >= c.end || *c.p != ch) {
+		return false;
+	}
+	c.p++;
+	return true;
+}
+
+static int HexDigit(char ch)
+{
+	if(ch >= '0' && ch <= '9') return ch - '0';
+	if(ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+	if(ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+	return -1;
+}
+
+// Reads a string with escapes resolved into out (truncated to cap - 1 bytes, NUL
+// terminated). out may be NULL to just skip it. \u escapes above 0xFF have no
+// cp1251 byte and become '?'.
+static bool ReadString(stJsonCursor& c, char* out, uint32_t cap, uint32_t* outLen)
+{
+	if(!Expect(c, '"')) {
+		return false;
+	}
+	uint32_t n = 0;
+	while(c.p < c.end && *c.p != '"') {
+		char ch = *c.p++;
+		if(ch == '\\') {
+			if(c.p >= c.end) {
+				return false;
+			}
+			char esc = *c.p++;
+			switch(esc) {
+				case 'b': ch = '\b'; break;
+				case 'f': ch = '\f'; break;
+				case 'n': ch = '\n'; break;
+				case 'r': ch = '\r'; break;
+				case 't': ch = '\t'; break;
+				case 'u': {
+					if(c.end - c.p < 4) {
+						return false;
+					}
+					int code = 0;
+					for(int i = 0; i < 4; i++) {
+						int d = HexDigit(*c.p++);
+						if(d < 0) {
+							return false;
+						}
+						code = (code << 4) | d;
+					}
+					ch = code <= 0xFF ? (char)code : '?';
+					break;
+				}
+				default: ch = esc; break;
+			}
+		}
+		if(out && n + 1 < cap) {
+			out[n++] = ch;
+		}
+	}
+	if(c.p >= c.end) {
+		return false;
+	}
+	c.p++;
+	if(out) {
+		out[n] = 0;
+	}
+	if(outLen) {
+		*outLen = n;
+	}
+	return true;
+}
+
+static bool ReadInt(stJsonCursor& c, int32_t* value)
+{
+	SkipSpace(c);
+	bool negative = false;
+	if(c.p < c.end && *c.p == '-') {
+		negative = true;
+		c.p++;
+	}
+	if(c.p >= c.end || *c.p < '0' || *c.p > '9') {
+		return false;
+	}
+	int64_t v = 0;
+	while(c.p < c.end && *c.p >= '0' && *c.p <= '9') {
+		if(v < 0x7FFFFFFF) {
+			v = v * 10 + (*c.p - '0');
+		}
+		c.p++;
+	}
+	// fraction/exponent are not expected here, but must not break the walk
+	while(c.p < c.end && (*c.p == '.' || *c.p == 'e' || *c.p == 'E' || *c.p == '+' || *c.p == '-' || (*c.p >= '0' && *c.p <= '9'))) {
+		c.p++;
+	}
+	*value = (int32_t)(negative ? -v : v);
+	return true;
+}
+
+// Skips any value, nested containers included
+static bool SkipValue(stJsonCursor& c)
+{
+	SkipSpace(c);
+	if(c.p >= c.end) {
+		return false;
+	}
+	if(*c.p == '"') {
+		return ReadString(c, NULL, 0, NULL);
+	}
+	if(*c.p == '{' || *c.p == '[') {
+		int depth = 0;
+		while(c.p < c.end) {
+			char ch = *c.p;
+			if(ch == '"') {
+				if(!ReadString(c, NULL, 0, NULL)) {
+					return false;
+				}
+				continue;
+			}
+			c.p++;
+			if(ch == '{' || ch == '[') {
+				depth++;
+			} else if(ch == '}' || ch == ']') {
+				if(--depth == 0) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+	// number, true, false, null
+	const char* start = c.p;
+	while(c.p < c.end && *c.p != ',' && *c.p != '}' && *c.p != ']' && *c.p != ' ' && *c.p != '\t' && *c.p != '\n' && *c.p != '\r') {
+		c.p++;
+	}
+	return c.p != start;
+}
+
+bool ParseDialogResponse(const char* json, uint32_t len, stDialogResponse* out)
+{
+	stJsonCursor c = { json, json + len };
+	char rawInput[sizeof(out->input)];
+	uint32_t rawLen = 0;
+	bool haveButton = false, haveList = false, haveInput = false;
+
+	if(!Expect(c, '{')) {
+		return false;
+	}
+	SkipSpace(c);
+	if(c.p < c.end && *c.p == '}') {
+		return false;
+	}
+	for(;;) {
+		char key[8];
+		uint32_t keyLen = 0;
+		if(!ReadString(c, key, sizeof(key), &keyLen) || !Expect(c, ':')) {
+			return false;
+		}
+		bool ok;
+		if(keyLen == 1 && key[0] == 'r') {
+			ok = haveButton = ReadInt(c, &out->button);
+		} else if(keyLen == 1 && key[0] == 'l') {
+			ok = haveList = ReadInt(c, &out->listItem);
+		} else if(keyLen == 1 && key[0] == 'i') {
+			ok = haveInput = ReadString(c, rawInput, sizeof(rawInput), &rawLen);
+		} else {
+			ok = SkipValue(c);
+		}
+		if(!ok) {
+			return false;
+		}
+		SkipSpace(c);
+		if(c.p < c.end && *c.p == ',') {
+			c.p++;
+			continue;
+		}
+		if(!Expect(c, '}')) {
+			return false;
+		}
+		break;
+	}
+	if(!haveButton || !haveList || !haveInput) {
+		return false;
+	}
+
+	// the server gets the input as UTF-8, same as before; a cp1251 byte expands to at
+	// most 3 UTF-8 bytes, and the length has to fit the one-byte length prefix
+	char utf8[sizeof(rawInput) * 3 + 1];
+	uint32_t utf8Len = cp1251_to_utf8(utf8, sizeof(utf8), rawInput, rawLen);
+	if(utf8Len > sizeof(out->input) - 1) {
+		utf8Len = sizeof(out->input) - 1;
+		// don't cut a multi-byte sequence in half
+		while(utf8Len && ((uint8_t)utf8[utf8Len] & 0xC0) == 0x80) {
+			utf8Len--;
+		}
+	}
+	memcpy(out->input, utf8, utf8Len);
+	out->input[utf8Len] = 0;
+	out->inputLen = (uint8_t)utf8Len;
+	return true;
+}
+
+CJsonWriter::CJsonWriter(char* buf, uint32_t cap)
+	: m_pBuf(buf), m_uCap(cap), m_uLen(0), m_bFirst(true), m_bOverflow(false)
+{
+	Put('{');
+}
+
+void CJsonWriter::Put(char ch)
+{
+	// one byte is always kept for the terminator
+	if(m_uLen + 1 >= m_uCap) {
+		m_bOverflow = true;
+		return;
+	}
+	m_pBuf[m_uLen++] = ch;
+}
+
+void CJsonWriter::Put(const char* str, uint32_t len)
+{
+	if(m_uLen + len + 1 > m_uCap) {
+		m_bOverflow = true;
+		return;
+	}
+	memcpy(m_pBuf + m_uLen, str, len);
+	m_uLen += len;
+}
+
+void CJsonWriter::Key(const char* key)
+{
+	if(!m_bFirst) {
+		Put(',');
+	}
+	m_bFirst = false;
+	Put('"');
+	Put(key, strlen(key));
+	Put('"');
+	Put(':');
+}
+
+void CJsonWriter::Int(const char* key, int32_t value)
+{
+	Key(key);
+	char digits[12];
+	uint32_t n = 0;
+	uint32_t v = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+	do {
+		digits[sizeof(digits) - 1 - n++] = '0' + v % 10;
+		v /= 10;
+	} while(v);
+	if(value < 0) {
+		digits[sizeof(digits) - 1 - n++] = '-';
+	}
+	Put(digits + sizeof(digits) - n, n);
+}
+
+void CJsonWriter::String(const char* key, const char* value, uint32_t len)
+{
+	static const char hex[] = "0123456789abcdef";
+	Key(key);
+	Put('"');
+	for(uint32_t i = 0; i < len && !m_bOverflow; i++) {
+		char ch = value[i];
+		switch(ch) {
+			case '"': Put("\\\"", 2); break;
+			case '\\': Put("\\\\", 2); break;
+			case '\n': Put("\\n", 2); break;
+			case '\r': Put("\\r", 2); break;
+			case '\t': Put("\\t", 2); break;
+			default:
+				if((uint8_t)ch < 0x20) {
+					char esc[6] = { '\\', 'u', '0', '0', hex[(uint8_t)ch >> 4], hex[ch & 0xF] };
+					Put(esc, sizeof(esc));
+				} else {
+					Put(ch);
+				}
+				break;
+		}
+	}
+	Put('"');
+}
+
+void CJsonWriter::String(const char* key, const char* value)
+{
+	String(key, value, strlen(value));
+}
+
+bool CJsonWriter::End()
+{
+	Put('}');
+	if(m_bOverflow) {
+		return false;
+	}
+	m_pBuf[m_uLen] = 0;
+	return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+#include "wireschema.h"
+
+// Dialog answer sent by the BR UI as BR_ID_USER_INTERFACE_SYNC, gui id 10:
+// {"r": button, "l": list item, "i": "input text"}
+struct stDialogResponse
+{
+	int32_t button;
+	int32_t listItem;
+	uint8_t inputLen;
+	char input[256];	// UTF-8, NUL terminated
+};
+
+// SA-MP DialogResponse RPC head, followed by inputLen bytes of input
+struct stDialogResponseHeader
+{
+	uint16_t dialogId;
+	int32_t button;
+	int32_t listItem;
+	uint8_t inputLen;
+};
+
+using DialogResponseSchema = WireSchema<stDialogResponseHeader,
+	WireField<&stDialogResponseHeader::dialogId>,
+	WireField<&stDialogResponseHeader::button, 8>,
+	WireField<&stDialogResponseHeader::listItem, 16>,
+	WireField<&stDialogResponseHeader::inputLen>>;
+
+// Single pass over the cp1251 JSON, no allocations. Unknown keys are skipped;
+// returns false if the text is malformed or one of the three fields is missing.
+bool ParseDialogResponse(const char* json, uint32_t len, stDialogResponse* out);
+
+// Builds a flat JSON object into a caller-owned buffer in one pass. String values are
+// escaped; bytes >= 0x80 are copied through untouched, so the encoding is the caller's.
+// Once something does not fit the writer stops and End() returns false.
+class CJsonWriter
+{
+public:
+	CJsonWriter(char* buf, uint32_t cap);
+
+	void Int(const char* key, int32_t value);
+	void String(const char* key, const char* value, uint32_t len);
+	void String(const char* key, const char* value);
+	// closes the object and NUL terminates it
+	bool End();
+
+	const char* Data() const { return m_pBuf; }
+	uint32_t Length() const { return m_uLen; }
+
+private:
+	void Put(char ch);
+	void Put(const char* str, uint32_t len);
+	void Key(const char* key);
+
+	char* m_pBuf;
+	uint32_t m_uCap;
+	uint32_t m_uLen;
+	bool m_bFirst;
+	bool m_bOverflow;
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <string.h>
+#include <type_traits>
+
+#include "vendor/RakNet/BitStream.h"
+
+// The stream is MSB first, so a field at any bit offset is a per-byte shift of two
+// neighbours. A field never straddles more than BYTES + 1 source bytes.
+template<uint32_t BYTES>
+static inline void ReadBytesAt(const uint8_t* data, uint32_t bitOffset, void* out)
+{
+	const uint8_t* src = data + (bitOffset >> 3);
+	uint32_t shift = bitOffset & 7;
+	uint8_t* dst = (uint8_t*)out;
+	if(shift == 0) {
+		memcpy(dst, src, BYTES);
+		return;
+	}
+	for(uint32_t i = 0; i < BYTES; i++) {
+		dst[i] = (uint8_t)((src[i] << shift) | (src[i + 1] >> (8 - shift)));
+	}
+}
+
+template<typename M>
+struct stWireMember;
+
+template<typename C, typename M>
+struct stWireMember<M C::*>
+{
+	using Class = C;
+	using Type = M;
+};
+
+// One member of a wire layout. The width defaults to the member's own size; a
+// narrower width sends the low bytes (this is a little-endian target), which is
+// how BR/SA-MP carry e.g. a 16-bit health in one byte.
+template<auto MEMBER, uint32_t BITS_ = sizeof(typename stWireMember<decltype(MEMBER)>::Type) * 8>
+struct WireField
+{
+	using Class = typename stWireMember<decltype(MEMBER)>::Class;
+	using Type = typename stWireMember<decltype(MEMBER)>::Type;
+
+	static constexpr uint32_t BITS = BITS_;
+	static constexpr uint32_t BYTES = BITS / 8;
+
+	static_assert(BITS % 8 == 0, "wire fields are whole bytes");
+	static_assert(BITS > 0 && BITS <= sizeof(Type) * 8, "wire field is wider than its member");
+
+	static inline void Read(const uint8_t* data, uint32_t& bitOffset, Class* out)
+	{
+		uint8_t* dst = (uint8_t*)&(out->*MEMBER);
+		ReadBytesAt<BYTES>(data, bitOffset, dst);
+		if(BYTES < sizeof(Type)) {
+			memset(dst + BYTES, 0, sizeof(Type) - BYTES);
+		}
+		bitOffset += BITS;
+	}
+
+	static inline void Write(uint8_t*& dst, const Class& in)
+	{
+		memcpy(dst, &(in.*MEMBER), BYTES);
+		dst += BYTES;
+	}
+};
+
+// Declares a packet layout once, so reads and writes can't drift apart field by field:
+//
+//   using AimSchema = WireSchema<stAimSyncPacket,
+//       WireField<&stAimSyncPacket::packetId>,
+//       WireField<&stAimSyncPacket::playerId>,
+//       WireField<&stAimSyncPacket::data>>;
+//
+// Read() checks the length once for the whole layout; Write() packs every field into
+// one buffer and hands it to the stream in a single call.
+template<typename T, typename... FIELDS>
+struct WireSchema
+{
+	static constexpr uint32_t BITS = (0 + ... + FIELDS::BITS);
+	static constexpr uint32_t BYTES = BITS / 8;
+
+	static_assert(sizeof...(FIELDS) > 0, "empty wire schema");
+	static_assert((... && std::is_same<typename FIELDS::Class, T>::value), "field belongs to another struct");
+
+	static inline bool Read(const uint8_t* data, uint32_t lengthBits, uint32_t bitOffset, T* out)
+	{
+		if(bitOffset > lengthBits || lengthBits - bitOffset < BITS) {
+			return false;
+		}
+		(FIELDS::Read(data, bitOffset, out), ...);
+		return true;
+	}
+
+	static inline void Write(RakNet::BitStream* bs, const T& in)
+	{
+		uint8_t buffer[BYTES];
+		uint8_t* dst = buffer;
+		(FIELDS::Write(dst, in), ...);
+		bs->Write((const char*)buffer, BYTES);
+	}
+};
@@ -0,0 +1,187 @@
+#include "worldsnapshot.h"
+#include "common.h"
+#include "config.h"
+#include "sendclass.h"
+#include "xorstr.h"
+#include "vendor/RakNet/GetTime.h"
+#include "vendor/RakNet/RakClientInterface.h"
+
+#include <android/log.h>
+#include <string.h>
+
+extern RakClientInterface* pRakClient;
+
+std::map<uint32_t, CWorldSnapshot::stEntry> CWorldSnapshot::m_entries;
+uint32_t CWorldSnapshot::m_lostAt = 0;
+bool CWorldSnapshot::m_bLost = false;
+bool CWorldSnapshot::m_bResumeRequested = false;
+bool CWorldSnapshot::m_bResumeAccepted = false;
+bool CWorldSnapshot::m_bReplaying = false;
+
+// the peer every recorded RPC came in through, handed back to the handlers on replay
+static RakPeerInterface* g_recipient = nullptr;
+static PlayerID g_sender = UNASSIGNED_PLAYER_ID;
+
+static uint32_t HashPayload(const unsigned char* data, uint32_t size)
+{
+	uint32_t hash = 2166136261u;
+	for(uint32_t i = 0; i < size; i++) {
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+	return hash;
+}
+
+void CWorldSnapshot::Initialise(RakClientInterface* client)
+{
+	client->RegisterAsRemoteProcedureCall(RPC_ResumeReply, ResumeReply);
+}
+
+bool CWorldSnapshot::IsTracked(int rpcId)
+{
+	return rpcId == RPC_ServerJoin || rpcId == RPC_ServerQuit
+		|| rpcId == RPC_WorldPlayerAdd || rpcId == RPC_WorldPlayerRemove
+		|| rpcId == RPC_WorldVehicleAdd || rpcId == RPC_WorldVehicleRemove
+		|| rpcId == RPC_ScrCreateObject || rpcId == RPC_ScrDestroyObject;
+}
+
+void CWorldSnapshot::Forget(eKind kind, uint16_t id)
+{
+	m_entries.erase(Key(kind, id));
+}
+
+void CWorldSnapshot::Record(int rpcId, const RPCParameters* rpcParams, void (*handler)(RPCParameters*))
+{
+	uint32_t inputLen = BITS_TO_BYTES(rpcParams->numberOfBitsOfData);
+	if(m_bReplaying || inputLen < sizeof(uint16_t)) {
+		return;
+	}
+	// every tracked RPC leads with the id of what it creates or removes
+	uint16_t id;
+	memcpy(&id, rpcParams->input, sizeof(id));
+
+	eKind kind;
+	if(rpcId == RPC_ServerJoin) { kind = KIND_PLAYER_JOIN; }
+	else if(rpcId == RPC_WorldPlayerAdd) { kind = KIND_PLAYER_STREAM; }
+	else if(rpcId == RPC_WorldVehicleAdd) { kind = KIND_VEHICLE; }
+	else if(rpcId == RPC_ScrCreateObject) { kind = KIND_OBJECT; }
+	else {
+		if(rpcId == RPC_ServerQuit) {
+			Forget(KIND_PLAYER_JOIN, id);
+			Forget(KIND_PLAYER_STREAM, id);
+		}
+		if(rpcId == RPC_WorldPlayerRemove) { Forget(KIND_PLAYER_STREAM, id); }
+		if(rpcId == RPC_WorldVehicleRemove) { Forget(KIND_VEHICLE, id); }
+		if(rpcId == RPC_ScrDestroyObject) { Forget(KIND_OBJECT, id); }
+		return;
+	}
+
+	g_recipient = rpcParams->recipient;
+	g_sender = rpcParams->sender;
+
+	stEntry& entry = m_entries[Key(kind, id)];
+	entry.rpcId = rpcId;
+	entry.handler = handler;
+	entry.bits = rpcParams->numberOfBitsOfData;
+	entry.payload.assign(rpcParams->input, rpcParams->input + inputLen);
+	entry.hash = HashPayload(rpcParams->input, inputLen);
+}
+
+void CWorldSnapshot::OnConnectionLost()
+{
+	m_bLost = true;
+	m_lostAt = RakNet::GetTime();
+	m_bResumeRequested = false;
+	m_bResumeAccepted = false;
+}
+
+void CWorldSnapshot::Clear()
+{
+	m_entries.clear();
+	m_bLost = false;
+	m_bResumeRequested = false;
+	m_bResumeAccepted = false;
+}
+
+void CWorldSnapshot::RequestResume()
+{
+	uint32_t window = CConfig::Get().resumeWindowMs;
+	if(!m_bLost || m_entries.empty() || !window || RakNet::GetTime() - m_lostAt > window) {
+		// a fresh session, whatever we had belongs to the old world
+		Clear();
+		return;
+	}
+
+	uint16_t count = (uint16_t)(m_entries.size() > 0xFFFF ? 0xFFFF : m_entries.size());
+	RakNet::BitStream bsSend;
+	bsSend.Write(count);
+	auto it = m_entries.begin();
+	for(uint16_t i = 0; i < count; i++, it++) {
+		bsSend.Write((uint8_t)(it->first >> 16));
+		bsSend.Write((uint16_t)(it->first & 0xFFFF));
+		bsSend.Write(it->second.hash);
+	}
+	pRakClient->RPC(RPC_ClientResume, &bsSend, CSendClass::GetPriority(SEND_CLASS_CONTROL), RELIABLE_ORDERED,
+		CSendClass::GetOrderingChannel(SEND_CLASS_CONTROL), false, UNASSIGNED_NETWORK_ID, NULL);
+	m_bResumeRequested = true;
+}
+
+void CWorldSnapshot::ResumeReply(RPCParameters* rpcParams)
+{
+	if(!m_bResumeRequested) {
+		return;
+	}
+	m_bResumeRequested = false;
+
+	RakNet::BitStream bsData(rpcParams->input, BITS_TO_BYTES(rpcParams->numberOfBitsOfData), false);
+	uint8_t accepted = 0;
+	uint16_t staleCount = 0;
+	if(!bsData.Read(accepted) || !accepted || !bsData.Read(staleCount)) {
+		Clear();
+		return;
+	}
+	for(uint16_t i = 0; i < staleCount; i++)
+	{
+		uint8_t kind;
+		uint16_t id;
+		if(!bsData.Read(kind) || !bsData.Read(id)) {
+			// can't tell what is stale any more, so nothing is safe to replay
+			Clear();
+			return;
+		}
+		Forget((eKind)kind, id);
+	}
+	m_bResumeAccepted = true;
+}
+
+void CWorldSnapshot::Replay()
+{
+	m_bReplaying = true;
+	for(auto& pair : m_entries)
+	{
+		stEntry& entry = pair.second;
+		RPCParameters rpcParams;
+		rpcParams.input = entry.payload.data();
+		rpcParams.numberOfBitsOfData = entry.bits;
+		rpcParams.sender = g_sender;
+		rpcParams.recipient = g_recipient;
+		rpcParams.replyToSender = nullptr;
+		// same path the live RPC took, so the BR payload gets the same rewrites
+		FixBrokenRPC(entry.rpcId, &rpcParams, entry.handler);
+	}
+	m_bReplaying = false;
+}
+
+void CWorldSnapshot::OnInitGame()
+{
+	if(m_bResumeAccepted) {
+		Replay();
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Resume"), xorstr("resumed with %u cached entities"), (unsigned)m_entries.size());
+		m_bLost = false;
+		m_bResumeAccepted = false;
+		return;
+	}
+	if(m_bLost || m_bResumeRequested) {
+		// no answer before InitGame: the server is sending the whole world
+		Clear();
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "vendor/RakNet/NetworkTypes.h"
+
+class RakClientInterface;
+
+// Keeps the payloads of the RPCs that build the world (players, vehicles, objects) so a
+// short connection loss doesn't cost a full resend. After ClientJoin the client offers
+// RPC_ClientResume with what it still has:
+//
+//   uint16 count, then per entry: uint8 kind, uint16 id, uint32 FNV-1a of the payload
+//
+// A server that knows the handshake answers with RPC_ResumeReply before InitGame:
+//
+//   uint8 accepted, uint16 staleCount, then per stale entry: uint8 kind, uint16 id
+//
+// When accepted, everything but the stale entries is replayed into the game right after
+// InitGame and the server only sends what changed. Servers that ignore RPC_ClientResume
+// get the usual full world. Game thread only, like every RPC handler.
+class CWorldSnapshot
+{
+public:
+	enum eKind : uint8_t
+	{
+		// replayed in this order, joins before the players they stream in
+		KIND_PLAYER_JOIN,
+		KIND_VEHICLE,
+		KIND_OBJECT,
+		KIND_PLAYER_STREAM,
+	};
+
+	static void Initialise(RakClientInterface* client);
+	static bool IsTracked(int rpcId);
+	// before FixBrokenRPC rewrites the payload, so a replay goes through the same fixups
+	static void Record(int rpcId, const RPCParameters* rpcParams, void (*handler)(RPCParameters*));
+
+	static void OnConnectionLost();
+	// right after ClientJoin went out
+	static void RequestResume();
+	// right after the game handled InitGame
+	static void OnInitGame();
+	static void Clear();
+
+private:
+	struct stEntry
+	{
+		int rpcId;
+		void (*handler)(RPCParameters*);
+		uint32_t hash;
+		uint32_t bits;
+		std::vector<unsigned char> payload;
+	};
+
+	static uint32_t Key(eKind kind, uint16_t id) { return ((uint32_t)kind << 16) | id; }
+	static void Forget(eKind kind, uint16_t id);
+	static void Replay();
+	static void ResumeReply(RPCParameters* rpcParams);
+
+	static std::map<uint32_t, stEntry> m_entries;
+	static uint32_t m_lostAt;
+	static bool m_bLost;
+	static bool m_bResumeRequested;
+	static bool m_bResumeAccepted;
+	static bool m_bReplaying;
+};
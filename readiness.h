@@ -0,0 +1,27 @@
+#pragma once
+
+#include <unistd.h>
+
+namespace readiness
+{
+	// The game publishes its state with plain stores and never signals anyone, so there is
+	// nothing to block on. Poll with exponential backoff instead of spinning a core while the
+	// game is loading.
+	constexpr useconds_t MIN_DELAY_US = 500;
+	constexpr useconds_t MAX_DELAY_US = 16000;
+
+	// maxDelay bounds how late we notice the condition; keep it small when something must be
+	// done right after the transition (hooks that have to beat the game's own init).
+	template<typename Pred>
+	void WaitUntil(Pred pred, useconds_t maxDelay = MAX_DELAY_US)
+	{
+		useconds_t delay = MIN_DELAY_US;
+		while(!pred())
+		{
+			usleep(delay);
+			if(delay < maxDelay) {
+				delay <<= 1;
+			}
+		}
+	}
+}
@@ -0,0 +1,92 @@
+#include "scheduler.h"
+
+#include <mutex>
+#include <time.h>
+#include <vector>
+
+static std::mutex g_postMutex;
+static std::vector<std::function<void()>> g_posted;
+struct stDelayedTask
+{
+	uint64_t dueNs;
+	std::function<void()> task;
+};
+// few and short-lived, a linear scan per frame is all they need
+static std::vector<stDelayedTask> g_delayed;
+// game thread only
+static std::vector<std::function<void()>> g_ready;
+static size_t g_readyHead = 0;
+
+static uint64_t NowNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void CFrameScheduler::Post(std::function<void()> task)
+{
+	std::lock_guard<std::mutex> lock(g_postMutex);
+	g_posted.push_back(std::move(task));
+}
+
+void CFrameScheduler::PostAfter(uint32_t delayMs, std::function<void()> task)
+{
+	uint64_t dueNs = NowNs() + (uint64_t)delayMs * 1000000ull;
+	std::lock_guard<std::mutex> lock(g_postMutex);
+	g_delayed.push_back({ dueNs, std::move(task) });
+}
+
+void CFrameScheduler::Run(uint64_t budgetNs)
+{
+	{
+		std::lock_guard<std::mutex> lock(g_postMutex);
+		if(!g_delayed.empty()) {
+			uint64_t now = NowNs();
+			size_t kept = 0;
+			for(size_t i = 0; i < g_delayed.size(); i++) {
+				if(g_delayed[i].dueNs <= now) {
+					g_posted.push_back(std::move(g_delayed[i].task));
+				} else {
+					if(kept != i) {
+						g_delayed[kept] = std::move(g_delayed[i]);
+					}
+					kept++;
+				}
+			}
+			g_delayed.resize(kept);
+		}
+		if(!g_posted.empty()) {
+			if(g_readyHead == g_ready.size()) {
+				g_ready.clear();
+				g_readyHead = 0;
+				g_ready.swap(g_posted);
+			} else {
+				for(auto& task : g_posted) {
+					g_ready.push_back(std::move(task));
+				}
+				g_posted.clear();
+			}
+		}
+	}
+
+	uint64_t start = NowNs();
+	while(g_readyHead < g_ready.size()) {
+		// moved out first: the task may post more work
+		std::function<void()> task = std::move(g_ready[g_readyHead++]);
+		task();
+		if(NowNs() - start >= budgetNs) {
+			break;
+		}
+	}
+	if(g_readyHead == g_ready.size()) {
+		g_ready.clear();
+		g_readyHead = 0;
+	}
+}
+
+uint32_t CFrameScheduler::Pending()
+{
+	std::lock_guard<std::mutex> lock(g_postMutex);
+	return (uint32_t)(g_posted.size() + g_delayed.size() + g_ready.size() - g_readyHead);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// Work deferred to the game tick. Tasks can be posted from any thread and run on the
+// game thread in posting order, at most one budget's worth per frame; whatever does
+// not fit carries over to the next frame.
+class CFrameScheduler
+{
+public:
+	static constexpr uint64_t DEFAULT_BUDGET_NS = 1000000;
+
+	static void Post(std::function<void()> task);
+	// queued once delayMs has passed, then runs like any posted task
+	static void PostAfter(uint32_t delayMs, std::function<void()> task);
+	// always runs at least one task if any is pending, so a slow task cannot stall the queue
+	static void Run(uint64_t budgetNs = DEFAULT_BUDGET_NS);
+	static uint32_t Pending();
+};
@@ -0,0 +1,118 @@
+#include "sigscan.h"
+
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static int HexDigit(char c)
+{
+	if(c >= '0' && c <= '9') return c - '0';
+	if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+bool CSigScan::Parse(const char* text, stPattern* out)
+{
+	out->length = 0;
+	out->anchor = MAX_PATTERN;
+	while(*text)
+	{
+		if(*text == ' ') {
+			text++;
+			continue;
+		}
+		if(out->length == MAX_PATTERN || !text[1]) {
+			return false;
+		}
+		if(text[0] == '?' && text[1] == '?') {
+			out->bytes[out->length] = 0;
+			out->mask[out->length] = 0;
+		} else {
+			int hi = HexDigit(text[0]), lo = HexDigit(text[1]);
+			if(hi < 0 || lo < 0) {
+				return false;
+			}
+			out->bytes[out->length] = (uint8_t)(hi << 4 | lo);
+			out->mask[out->length] = 0xFF;
+			if(out->anchor == MAX_PATTERN) {
+				out->anchor = out->length;
+			}
+		}
+		out->length++;
+		text += 2;
+	}
+	// all wildcards would match at the first byte, which is never what was meant
+	return out->length && out->anchor != MAX_PATTERN;
+}
+
+static inline bool Matches(const uint8_t* at, const CSigScan::stPattern& pattern)
+{
+	for(uint32_t i = 0; i < pattern.length; i++) {
+		if((at[i] & pattern.mask[i]) != pattern.bytes[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+const uint8_t* CSigScan::Find(const uint8_t* begin, size_t size, const stPattern& pattern)
+{
+	if(size < pattern.length) {
+		return nullptr;
+	}
+	// candidates are found by their anchor byte, then checked whole
+	const uint8_t* first = begin + pattern.anchor;
+	const uint8_t* last = begin + (size - pattern.length) + pattern.anchor;
+	uint8_t anchor = pattern.bytes[pattern.anchor];
+	const uint8_t* p = first;
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	uint8x16_t needle = vdupq_n_u8(anchor);
+	while(last - p >= 16)
+	{
+		uint8x16_t eq = vceqq_u8(vld1q_u8(p), needle);
+		uint8x8_t folded = vorr_u8(vget_low_u8(eq), vget_high_u8(eq));
+		if(vget_lane_u64(vreinterpret_u64_u8(folded), 0) == 0) {
+			p += 16;
+			continue;
+		}
+		for(int i = 0; i < 16; i++) {
+			if(p[i] == anchor && Matches(p + i - pattern.anchor, pattern)) {
+				return p + i - pattern.anchor;
+			}
+		}
+		p += 16;
+	}
+#elif defined(__SSE2__)
+	__m128i needle = _mm_set1_epi8((char)anchor);
+	while(last - p >= 16)
+	{
+		int hits = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), needle));
+		while(hits) {
+			int i = __builtin_ctz(hits);
+			if(Matches(p + i - pattern.anchor, pattern)) {
+				return p + i - pattern.anchor;
+			}
+			hits &= hits - 1;
+		}
+		p += 16;
+	}
+#endif
+	while(p <= last)
+	{
+		p = (const uint8_t*)memchr(p, anchor, last - p + 1);
+		if(!p) {
+			break;
+		}
+		if(Matches(p - pattern.anchor, pattern)) {
+			return p - pattern.anchor;
+		}
+		p++;
+	}
+	return nullptr;
+}
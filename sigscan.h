@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Byte pattern search for offsets that move between game builds. A pattern is hex
+// bytes with ?? for wildcards, e.g. "F0 B5 03 AF ?? ?? 81 B0"; put the wildcards where
+// the code holds a PC-relative literal or a branch target.
+class CSigScan
+{
+public:
+	static constexpr uint32_t MAX_PATTERN = 64;
+
+	struct stPattern
+	{
+		uint8_t bytes[MAX_PATTERN];
+		uint8_t mask[MAX_PATTERN];	// 0xFF where the byte has to match
+		uint32_t length;
+		uint32_t anchor;	// first byte that isn't a wildcard, what the scan looks for
+	};
+
+	static bool Parse(const char* text, stPattern* out);
+	// the first match in [begin, begin + size), or nullptr
+	static const uint8_t* Find(const uint8_t* begin, size_t size, const stPattern& pattern);
+};
@@ -0,0 +1,127 @@
+#include "threadpolicy.h"
+
+#include <android/log.h>
+#include <mutex>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "xorstr.h"
+
+CThreadPolicy::stPolicy CThreadPolicy::m_policies[THREAD_ROLE_COUNT] = {
+	GetDefault(THREAD_ROLE_NETWORK),
+	GetDefault(THREAD_ROLE_WORKER),
+};
+std::atomic<uint32_t> CThreadPolicy::m_generation(1);
+
+static std::mutex g_policyMutex;
+
+// core sets by max frequency, read once from sysfs
+static cpu_set_t g_bigCores;
+static cpu_set_t g_littleCores;
+static std::once_flag g_coresScanned;
+
+static void ScanCores()
+{
+	CPU_ZERO(&g_bigCores);
+	CPU_ZERO(&g_littleCores);
+	long count = sysconf(_SC_NPROCESSORS_CONF);
+	if(count > CPU_SETSIZE) {
+		count = CPU_SETSIZE;
+	}
+	unsigned long freqs[CPU_SETSIZE] = {};
+	unsigned long minFreq = 0, maxFreq = 0;
+	for(long cpu = 0; cpu < count; cpu++)
+	{
+		char path[96];
+		snprintf(path, sizeof(path), xorstr("/sys/devices/system/cpu/cpu%ld/cpufreq/cpuinfo_max_freq"), cpu);
+		FILE* file = fopen(path, "r");
+		if(!file) {
+			continue;
+		}
+		if(fscanf(file, "%lu", &freqs[cpu]) != 1) {
+			freqs[cpu] = 0;
+		}
+		fclose(file);
+		if(freqs[cpu] && (!minFreq || freqs[cpu] < minFreq)) {
+			minFreq = freqs[cpu];
+		}
+		if(freqs[cpu] > maxFreq) {
+			maxFreq = freqs[cpu];
+		}
+	}
+	for(long cpu = 0; cpu < count; cpu++)
+	{
+		if(freqs[cpu] && freqs[cpu] == maxFreq) {
+			CPU_SET(cpu, &g_bigCores);
+		}
+		if(freqs[cpu] && freqs[cpu] == minFreq) {
+			CPU_SET(cpu, &g_littleCores);
+		}
+	}
+	__android_log_print(ANDROID_LOG_INFO, xorstr("Threads"), xorstr("%d big, %d little of %ld cores"),
+		CPU_COUNT(&g_bigCores), CPU_COUNT(&g_littleCores), count);
+}
+
+CThreadPolicy::stPolicy CThreadPolicy::GetDefault(eThreadRole role)
+{
+	// the network thread ahead of the game's background work, the workers behind it
+	if(role == THREAD_ROLE_NETWORK) {
+		return { -4, CORES_ANY };
+	}
+	return { 5, CORES_ANY };
+}
+
+void CThreadPolicy::Set(eThreadRole role, const stPolicy& policy)
+{
+	std::lock_guard<std::mutex> lock(g_policyMutex);
+	m_policies[role] = policy;
+	m_generation.fetch_add(1, std::memory_order_release);
+}
+
+CThreadPolicy::eCores CThreadPolicy::CoresFromName(const char* name)
+{
+	if(!strcmp(name, xorstr("big"))) {
+		return CORES_BIG;
+	}
+	if(!strcmp(name, xorstr("little"))) {
+		return CORES_LITTLE;
+	}
+	return CORES_ANY;
+}
+
+void CThreadPolicy::Apply(eThreadRole role)
+{
+	stPolicy policy;
+	{
+		std::lock_guard<std::mutex> lock(g_policyMutex);
+		policy = m_policies[role];
+	}
+	pid_t tid = gettid();
+
+	// per thread on Linux, despite the name
+	if(setpriority(PRIO_PROCESS, tid, policy.nice) != 0) {
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Threads"), xorstr("nice %d for role %d refused"), policy.nice, role);
+	}
+
+	cpu_set_t cores;
+	if(policy.cores == CORES_ANY) {
+		CPU_ZERO(&cores);
+		long count = sysconf(_SC_NPROCESSORS_CONF);
+		for(long cpu = 0; cpu < count && cpu < CPU_SETSIZE; cpu++) {
+			CPU_SET(cpu, &cores);
+		}
+	} else {
+		std::call_once(g_coresScanned, ScanCores);
+		cores = policy.cores == CORES_BIG ? g_bigCores : g_littleCores;
+		if(!CPU_COUNT(&cores)) {
+			// no cpufreq in sysfs, nothing to tell the cores apart by
+			return;
+		}
+	}
+	if(sched_setaffinity(tid, sizeof(cores), &cores) != 0) {
+		__android_log_print(ANDROID_LOG_INFO, xorstr("Threads"), xorstr("affinity for role %d refused"), role);
+	}
+}
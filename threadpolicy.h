@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+enum eThreadRole
+{
+	THREAD_ROLE_NETWORK,	// RakPeer's UpdateNetworkLoop
+	THREAD_ROLE_WORKER,		// CWorkers
+	THREAD_ROLE_COUNT
+};
+
+// Scheduling for the threads the plugin starts. Android leaves a new thread at nice 0 on
+// whatever core the scheduler likes, often a little one shared with background apps,
+// which every received packet then waits on. Each role gets a nice value and optionally
+// a core class; brsamp.json can override both ("threads": {"network": {"nice": -4,
+// "cores": "big"}}). SCHED_FIFO/RR need a capability apps don't have, so nice is the lever.
+// The cost of a placement shows up as the "Receive queue" wait in CNetStats.
+class CThreadPolicy
+{
+public:
+	enum eCores : uint8_t
+	{
+		CORES_ANY,
+		CORES_BIG,		// those with the highest max frequency
+		CORES_LITTLE,	// those with the lowest
+	};
+
+	struct stPolicy
+	{
+		int8_t nice;
+		uint8_t cores;
+	};
+
+	static stPolicy GetDefault(eThreadRole role);
+	// from any thread; threads of that role pick it up at their next Refresh
+	static void Set(eThreadRole role, const stPolicy& policy);
+
+	// on the thread itself, once at start and then from its loop; a load and a compare
+	// unless the policy changed since *applied, which starts at 0
+	static inline void Refresh(eThreadRole role, uint32_t* applied)
+	{
+		uint32_t generation = m_generation.load(std::memory_order_acquire);
+		if(*applied != generation) {
+			*applied = generation;
+			Apply(role);
+		}
+	}
+
+	// "any", "big" or "little"; CORES_ANY for anything else
+	static eCores CoresFromName(const char* name);
+
+private:
+	static void Apply(eThreadRole role);
+
+	static stPolicy m_policies[THREAD_ROLE_COUNT];
+	// starts at 1, so a fresh thread always applies once
+	static std::atomic<uint32_t> m_generation;
+};
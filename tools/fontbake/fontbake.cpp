@@ -0,0 +1,108 @@
+// Host tool that prebakes the UI font atlas into gui/fonts/SdfAtlas.h.
+// Rerun it whenever the fonts, glyph ranges or sdffont parameters change:
+//
+//   g++ -std=c++17 -O2 -I. tools/fontbake/fontbake.cpp gui/sdffont.cpp vendor/imgui/imgui.cpp \
+//       vendor/imgui/imgui_draw.cpp vendor/imgui/imgui_tables.cpp vendor/imgui/imgui_widgets.cpp -lz -o fontbake
+//   ./fontbake gui/fonts/SdfAtlas.h
+//
+// The texture is stored as EAC R11 blocks, which the GLES3 backend uploads without decoding.
+// The font order is what CGUI::Initialise expects: Lilita, then LozungCaps. BoxIcons is not
+// baked, its glyphs are added at runtime on first use (sdffont::AddLazyFont). It ships zlib
+// compressed, packed with:
+//
+//   ./fontbake --pack BoxIcons boxicons.ttf gui/fonts/BoxIcons.h
+#include "gui/sdffont.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "gui/fonts/Lilita.h"
+#include "gui/fonts/LozungCaps.h"
+
+static void WriteBytes(FILE* out, const unsigned char* data, size_t size)
+{
+	for(size_t i = 0; i < size; i++) {
+		fprintf(out, "%s0x%02X,%s", i % 16 ? " " : "\t\t", data[i], i % 16 == 15 || i + 1 == size ? "\n" : "");
+	}
+}
+
+// A TTF for sdffont::AddLazyFont: zlib compressed, with its inflated size next to it
+static int Pack(const char* name, const char* inPath, const char* outPath)
+{
+	FILE* in = fopen(inPath, "rb");
+	if(!in) {
+		fprintf(stderr, "can't open %s\n", inPath);
+		return 1;
+	}
+	std::vector<unsigned char> ttf;
+	unsigned char chunk[4096];
+	size_t read;
+	while((read = fread(chunk, 1, sizeof(chunk), in)) > 0) {
+		ttf.insert(ttf.end(), chunk, chunk + read);
+	}
+	fclose(in);
+
+	uLongf packedSize = compressBound(ttf.size());
+	std::vector<unsigned char> packed(packedSize);
+	if(ttf.empty() || compress2(packed.data(), &packedSize, ttf.data(), ttf.size(), Z_BEST_COMPRESSION) != Z_OK) {
+		fprintf(stderr, "failed to compress %s\n", inPath);
+		return 1;
+	}
+
+	FILE* out = fopen(outPath, "w");
+	if(!out) {
+		fprintf(stderr, "can't open %s\n", outPath);
+		return 1;
+	}
+	fprintf(out, "#pragma once\n\n// Generated by tools/fontbake --pack, do not edit\n\nnamespace Font\n{\n");
+	fprintf(out, "\t// zlib, %sSize bytes of TTF once inflated\n", name);
+	fprintf(out, "\tconst unsigned int %sSize = %zu;\n\tconst unsigned char %s[] = {\n", name, ttf.size(), name);
+	WriteBytes(out, packed.data(), packedSize);
+	fprintf(out, "\t};\n}\n");
+	fclose(out);
+
+	printf("%s: %zu bytes, %lu packed\n", name, ttf.size(), (unsigned long)packedSize);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if(argc == 5 && !strcmp(argv[1], "--pack")) {
+		return Pack(argv[2], argv[3], argv[4]);
+	}
+	if(argc != 2) {
+		fprintf(stderr, "usage: %s <output.h>\n       %s --pack <name> <font.ttf> <output.h>\n", argv[0], argv[0]);
+		return 1;
+	}
+
+	ImGui::CreateContext();
+	// a host run must not leave an imgui.ini behind in whatever dir it ran from
+	ImGui::GetIO().IniFilename = nullptr;
+	ImFontAtlas* atlas = ImGui::GetIO().Fonts;
+	// GLES3 has no trouble with NPOT textures
+	atlas->Flags |= ImFontAtlasFlags_NoPowerOfTwoHeight;
+
+	ImFont* lilita = sdffont::AddFont(atlas, Font::Lilita, sizeof(Font::Lilita), atlas->GetGlyphRangesCyrillic());
+	ImFont* lozung = sdffont::AddFont(atlas, Font::LozungCaps, sizeof(Font::LozungCaps), atlas->GetGlyphRangesCyrillic());
+	std::vector<unsigned char> blob;
+	if(!lilita || !lozung || !sdffont::Build(atlas) || !sdffont::Save(atlas, &blob, sdffont::TEX_EAC_R11)) {
+		fprintf(stderr, "failed to bake the atlas\n");
+		return 1;
+	}
+
+	FILE* out = fopen(argv[1], "w");
+	if(!out) {
+		fprintf(stderr, "can't open %s\n", argv[1]);
+		return 1;
+	}
+	fprintf(out, "#pragma once\n\n// Generated by tools/fontbake, do not edit\n\nnamespace Font\n{\n\tconst unsigned char SdfAtlas[] = {\n");
+	WriteBytes(out, blob.data(), blob.size());
+	fprintf(out, "\t};\n}\n");
+	fclose(out);
+
+	printf("%d glyphs, %dx%d texture, %zu bytes\n", lilita->Glyphs.Size + lozung->Glyphs.Size,
+		atlas->TexWidth, atlas->TexHeight, blob.size());
+	ImGui::DestroyContext();
+	return 0;
+}
@@ -0,0 +1,356 @@
+// Synthetic players for capacity tests against our own server. N RakClients in one process
+// join the way the plugin does, answering ID_AUTH_KEY and sending RPC_ClientJoin through
+// CJoinHandshake, then spawn and stream on-foot or in-car sync built as BR packets and sent
+// through the same CPacketTranslator table hook_RakClient__Send uses. Every report interval
+// it prints each client's RTT and what the server sent back.
+//
+// Host build, from the repository root:
+//
+//   g++ -std=c++17 -O2 -Itools/netbench/host -I. tools/loadgen/loadgen.cpp \
+//       plugin/joinhandshake.cpp plugin/tracering.cpp plugin/translator.cpp plugin/sendclass.cpp plugin/arena.cpp plugin/netcapture.cpp \
+//       plugin/rpcarena.cpp plugin/rpccompress.cpp plugin/capabilities.cpp plugin/lz4.cpp plugin/systrace.cpp \
+//       config.cpp featureflags.cpp threadpolicy.cpp workers.cpp scheduler.cpp \
+//       vendor/RakNet/*.cpp vendor/RakNet/SAMP/*.cpp \
+//       -lpthread -ldl -o loadgen
+//   ./loadgen host port [--clients 50] [--rate 30] [--incar] [--seconds 60] [--report 5] [--name bot]
+//
+// Every client can sit behind an emulated mobile link, the same in both directions, see
+// LinkEmulator: --loss (per mille) --latency (ms one way) --jitter (ms) --jitter-dist
+// uniform|normal|pareto --reorder (per mille) --bandwidth (bytes/s) --queue (bytes)
+//
+// On-device: ndk-build LOADGEN=1. Only ever point it at a server we run.
+#include "plugin/common.h"
+#include "plugin/joinhandshake.h"
+#include "plugin/netstats.h"
+#include "plugin/translator.h"
+#include "plugin/pools/vehiclepool.h"
+#include "vendor/RakNet/BitStream.h"
+#include "vendor/RakNet/GetTime.h"
+#include "vendor/RakNet/LinkEmulator.h"
+#include "vendor/RakNet/PacketEnumerations.h"
+#include "vendor/RakNet/RakClientInterface.h"
+#include "vendor/RakNet/RakNetStatistics.h"
+#include "vendor/RakNet/RakNetworkFactory.h"
+#include "vendor/RakNet/SAMP/SAMPRPC.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+// What the plugin gets from the game and the rest of the tree; none of it matters here
+RakClientInterface* pRakClient = nullptr;
+uint16_t CVehiclePool::m_driving;
+void CNetStats::Record(eNetStatKind, uint8_t, uint32_t, uint64_t) {}
+
+enum eClientState
+{
+	CLIENT_CONNECTING,
+	CLIENT_JOINING,		// ClientJoin sent, waiting for InitGame
+	CLIENT_SPAWNED,		// streaming sync
+	CLIENT_GONE
+};
+
+static const char* const g_stateNames[] = { "connecting", "joining", "spawned", "gone" };
+
+struct stLoadClient
+{
+	RakClientInterface* rak;
+	char name[24];
+	eClientState state;
+	uint16_t playerId;
+	RakNetTime connectAt;
+	RakNetTime joinMs;
+	uint32_t syncsSent;
+	uint32_t rpcsReceived;
+	uint32_t packetsReceived;
+	// at the last report, for the rates
+	uint32_t lastBitsReceived;
+	uint32_t lastRpcs;
+	uint32_t lastPackets;
+	float angle;
+};
+
+struct stOptions
+{
+	const char* host;
+	uint16_t port;
+	uint32_t clients;
+	uint32_t rate;
+	bool inCar;
+	uint32_t seconds;
+	uint32_t reportSeconds;
+	const char* name;
+	LinkConditions link;
+};
+
+// RPC handlers run inside Receive, which is only ever called for one client at a time
+static stLoadClient* g_receiving = nullptr;
+
+static void OnAnyRPC(RPCParameters*)
+{
+	g_receiving->rpcsReceived++;
+}
+
+static void OnInitGame(RPCParameters*)
+{
+	stLoadClient* client = g_receiving;
+	client->rpcsReceived++;
+	if(client->state != CLIENT_JOINING) {
+		return;
+	}
+	// straight to the spawn, as FEATURE_EARLY_SPAWN would, so the server takes our sync
+	RakNet::BitStream bsClass;
+	bsClass.Write((int32_t)0);
+	client->rak->RPC(RPC_RequestClass, &bsClass, HIGH_PRIORITY, RELIABLE_ORDERED, 0, false, UNASSIGNED_NETWORK_ID, nullptr);
+	RakNet::BitStream bsEmpty;
+	client->rak->RPC(RPC_RequestSpawn, &bsEmpty, HIGH_PRIORITY, RELIABLE_ORDERED, 0, false, UNASSIGNED_NETWORK_ID, nullptr);
+	client->rak->RPC(RPC_Spawn, &bsEmpty, HIGH_PRIORITY, RELIABLE_ORDERED, 0, false, UNASSIGNED_NETWORK_ID, nullptr);
+	client->joinMs = RakNet::GetTime() - client->connectAt;
+	client->state = CLIENT_SPAWNED;
+}
+
+static void OnConnectionAccepted(stLoadClient* client, Packet* pkt)
+{
+	RakNet::BitStream bsSuccAuth((unsigned char *)pkt->data, pkt->length, false);
+	unsigned int uiChallenge;
+	bsSuccAuth.IgnoreBits(8 + 32 + 16);
+	bsSuccAuth.Read(client->playerId);
+	bsSuccAuth.Read(uiChallenge);
+
+	RakNet::BitStream bsJoin;
+	CJoinHandshake::WriteClientJoin(uiChallenge, client->name, &bsJoin);
+	client->rak->RPC(RPC_ClientJoin, &bsJoin, HIGH_PRIORITY, RELIABLE_ORDERED, 0, false, UNASSIGNED_NETWORK_ID, nullptr);
+	client->state = CLIENT_JOINING;
+}
+
+static void Receive(stLoadClient* client)
+{
+	g_receiving = client;
+	Packet* pkt;
+	while((pkt = client->rak->Receive())) {
+		client->packetsReceived++;
+		switch(pkt->data[0])
+		{
+			case ID_AUTH_KEY:
+			{
+				RakNet::BitStream bsKey;
+				if(CJoinHandshake::WriteAuthKey(pkt->data, pkt->length, &bsKey)) {
+					client->rak->Send(&bsKey, SYSTEM_PRIORITY, RELIABLE, 0);
+				}
+				break;
+			}
+			case ID_CONNECTION_REQUEST_ACCEPTED:
+				OnConnectionAccepted(client, pkt);
+				break;
+			case ID_CONNECTION_ATTEMPT_FAILED:
+			case ID_NO_FREE_INCOMING_CONNECTIONS:
+			case ID_CONNECTION_BANNED:
+			case ID_INVALID_PASSWORD:
+			case ID_CONNECTION_LOST:
+			case ID_DISCONNECTION_NOTIFICATION:
+				if(client->state != CLIENT_GONE) {
+					printf("%s: dropped on packet %u\n", client->name, pkt->data[0]);
+					client->state = CLIENT_GONE;
+				}
+				break;
+		}
+		client->rak->DeallocatePacket(pkt);
+	}
+	g_receiving = nullptr;
+}
+
+// Walks (or drives) a circle around a spot of its own, so every sync differs and the
+// server sees plausible movement rather than teleports
+static void SendSync(stLoadClient* client, uint32_t index, bool inCar, float dt)
+{
+	const float radius = 20.0f;
+	const float speed = inCar ? 15.0f : 3.0f;
+	client->angle += speed / radius * dt;
+	float pos[3] = {
+		(float)(index % 32) * 50.0f + radius * cosf(client->angle),
+		(float)(index / 32) * 50.0f + radius * sinf(client->angle),
+		10.0f
+	};
+	float move[3] = { -sinf(client->angle) * speed / 50.0f, cosf(client->angle) * speed / 50.0f, 0.0f };
+	float quat[4] = { cosf(client->angle / 2), 0.0f, 0.0f, sinf(client->angle / 2) };
+	uint16_t health = 100;
+
+	// BR payloads as the game hands them to RakClient::Send, laid out as in translator.cpp
+	uint8_t packet[1 + CPacketTranslator::BR_ONFOOT_SIZE];
+	memset(packet, 0, sizeof(packet));
+	uint8_t* payload = packet + 1;
+	uint32_t payloadLen;
+	if(inCar) {
+		packet[0] = BR_ID_VEHICLE_SYNC;
+		uint16_t vehicleId = (uint16_t)(1 + index);
+		float carHealth = 1000.0f;
+		memcpy(payload, &vehicleId, 2);
+		memcpy(payload + 8, quat, 16);
+		memcpy(payload + 24, pos, 12);
+		memcpy(payload + 36, move, 12);
+		memcpy(payload + 48, &carHealth, 4);
+		memcpy(payload + 52, &health, 2);
+		payloadLen = CPacketTranslator::BR_INCAR_SIZE;
+	} else {
+		packet[0] = BR_ID_PLAYER_SYNC;
+		memcpy(payload + 6, pos, 12);
+		memcpy(payload + 18, quat, 16);
+		memcpy(payload + 34, &health, 2);
+		memcpy(payload + 40, move, 12);
+		payloadLen = CPacketTranslator::BR_ONFOOT_SIZE;
+	}
+
+	const stPacketTranslator* translator = CPacketTranslator::Find(packet[0]);
+	uint8_t* out = CPacketTranslator::GetScratch();
+	uint32_t outLen = CPacketTranslator::Translate(translator, packet, 1 + payloadLen, out);
+	client->rak->Send((const char *)out, outLen, CSendClass::GetPriority(translator->sendClass), translator->reliability,
+		CSendClass::GetOrderingChannel(translator->sendClass));
+	client->syncsSent++;
+}
+
+static void Report(std::vector<stLoadClient>& clients, float seconds)
+{
+	printf("%-10s %-10s %8s %8s %10s %10s %8s\n", "client", "state", "join ms", "rtt ms", "in KB/s", "in pkt/s", "rpc/s");
+	uint32_t spawned = 0;
+	double totalKB = 0;
+	for(stLoadClient& client : clients) {
+		RakNetStatisticsStruct* stats = client.state != CLIENT_GONE ? client.rak->GetStatistics() : nullptr;
+		uint32_t bits = stats ? stats->bitsReceived : client.lastBitsReceived;
+		double kbs = (bits - client.lastBitsReceived) / 8192.0 / seconds;
+		printf("%-10s %-10s %8u %8.1f %10.1f %10.1f %8.1f\n", client.name, g_stateNames[client.state],
+			(unsigned)client.joinMs, stats ? stats->smoothedRoundTripTime : 0.0, kbs,
+			(client.packetsReceived - client.lastPackets) / seconds, (client.rpcsReceived - client.lastRpcs) / seconds);
+		client.lastBitsReceived = bits;
+		client.lastPackets = client.packetsReceived;
+		client.lastRpcs = client.rpcsReceived;
+		spawned += client.state == CLIENT_SPAWNED;
+		totalKB += kbs;
+	}
+	printf("%u/%u spawned, %.1f KB/s in total\n", spawned, (unsigned)clients.size(), totalKB);
+	if(LinkEmulator::IsActive()) {
+		LinkStatistics up, down;
+		LinkEmulator::GetStatistics(&up, &down);
+		printf("link up: lost %u, overflowed %u, delayed %u; down: lost %u, overflowed %u, delayed %u\n",
+			up.lost, up.overflowed, up.delayed, down.lost, down.overflowed, down.delayed);
+	}
+	printf("\n");
+}
+
+static bool ParseOptions(int argc, char** argv, stOptions* options)
+{
+	if(argc < 3) {
+		return false;
+	}
+	options->host = argv[1];
+	options->port = (uint16_t)atoi(argv[2]);
+	for(int i = 3; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if(!strcmp(argv[i], "--incar")) {
+			options->inCar = true;
+		} else if(!strcmp(argv[i], "--clients") && hasValue) {
+			options->clients = (uint32_t)atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "--rate") && hasValue) {
+			options->rate = (uint32_t)atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "--seconds") && hasValue) {
+			options->seconds = (uint32_t)atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "--report") && hasValue) {
+			options->reportSeconds = (uint32_t)atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "--name") && hasValue) {
+			options->name = argv[++i];
+		} else if(!strcmp(argv[i], "--loss") && hasValue) {
+			options->link.lossPerMille = (unsigned)atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "--latency") && hasValue) {
+			options->link.latencyMS = (unsigned)atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "--jitter") && hasValue) {
+			options->link.jitterMS = (unsigned)atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "--jitter-dist") && hasValue) {
+			const char* distribution = argv[++i];
+			if(!strcmp(distribution, "normal")) {
+				options->link.jitterDistribution = LINK_JITTER_NORMAL;
+			} else if(!strcmp(distribution, "pareto")) {
+				options->link.jitterDistribution = LINK_JITTER_PARETO;
+			} else if(strcmp(distribution, "uniform")) {
+				return false;
+			}
+		} else if(!strcmp(argv[i], "--reorder") && hasValue) {
+			options->link.reorderPerMille = (unsigned)atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "--bandwidth") && hasValue) {
+			options->link.bytesPerSecond = (unsigned)atoi(argv[++i]);
+		} else if(!strcmp(argv[i], "--queue") && hasValue) {
+			options->link.queueBytes = (unsigned)atoi(argv[++i]);
+		} else {
+			return false;
+		}
+	}
+	return options->port && options->clients && options->rate && options->reportSeconds;
+}
+
+int main(int argc, char** argv)
+{
+	stOptions options = { nullptr, 0, 50, 30, false, 60, 5, "bot" };
+	if(!ParseOptions(argc, argv, &options)) {
+		fprintf(stderr, "usage: %s host port [--clients N] [--rate Hz] [--incar] [--seconds S] [--report S] [--name prefix]\n"
+			"  [--loss permille] [--latency ms] [--jitter ms] [--jitter-dist uniform|normal|pareto] [--reorder permille]\n"
+			"  [--bandwidth bytes/s] [--queue bytes]\n", argv[0]);
+		return 1;
+	}
+	LinkEmulator::Set(options.link, options.link);
+
+	CPacketTranslator::Initialise();
+	std::vector<stLoadClient> clients(options.clients);
+	for(uint32_t i = 0; i < options.clients; i++) {
+		stLoadClient& client = clients[i];
+		memset(&client, 0, sizeof(client));
+		snprintf(client.name, sizeof(client.name), "%s_%u", options.name, i);
+		client.rak = RakNetworkFactory::GetRakClientInterface();
+		client.rak->RegisterAsRemoteProcedureCall(RPC_InitGame, OnInitGame);
+		for(int id = 0; id < 256; id++) {
+			if(id != RPC_InitGame) {
+				client.rak->RegisterAsRemoteProcedureCall(id, OnAnyRPC);
+			}
+		}
+		client.connectAt = RakNet::GetTime();
+		if(!client.rak->Connect(options.host, options.port, 0, 0, 5)) {
+			printf("%s: connect failed\n", client.name);
+			client.state = CLIENT_GONE;
+		}
+	}
+
+	const uint32_t tickMs = 1000 / options.rate;
+	RakNetTime start = RakNet::GetTime();
+	RakNetTime lastReport = start;
+	RakNetTime lastTick = start;
+	while(RakNet::GetTime() - start < options.seconds * 1000u) {
+		RakNetTime now = RakNet::GetTime();
+		float dt = (now - lastTick) / 1000.0f;
+		lastTick = now;
+		for(uint32_t i = 0; i < options.clients; i++) {
+			stLoadClient& client = clients[i];
+			if(client.state == CLIENT_GONE) {
+				continue;
+			}
+			Receive(&client);
+			if(client.state == CLIENT_SPAWNED) {
+				SendSync(&client, i, options.inCar, dt);
+			}
+		}
+		if(now - lastReport >= options.reportSeconds * 1000u) {
+			Report(clients, (now - lastReport) / 1000.0f);
+			lastReport = now;
+		}
+		RakNetTime spent = RakNet::GetTime() - now;
+		if(spent < tickMs) {
+			usleep((tickMs - spent) * 1000);
+		}
+	}
+
+	Report(clients, (RakNet::GetTime() - lastReport) / 1000.0f);
+	for(stLoadClient& client : clients) {
+		client.rak->Disconnect(100, 0);
+		RakNetworkFactory::DestroyRakClientInterface(client.rak);
+	}
+	return 0;
+}
@@ -0,0 +1,221 @@
+// BitStream::WriteBits and ReadBits over sync packets, field by field as the decoders and
+// hook_RakClient__Send's translators call them: a tick of TICK_PACKETS on-foot, in-car and aim
+// packets, some on-foot ones surfing, with the bools that leave every later field unaligned.
+// The -bytewise cases are RakNet's own kernels, kept here as the reference. Fields this short go
+// a byte at a time in BitStream too, which masks instead of zeroing the output first and only
+// copies long byte-aligned runs whole. One op is one packet. Setup writes the tick with both and
+// reads it back with both, and fails unless the streams and every field agree. Real captures go
+// through --replay.
+#include "netbench.h"
+
+#include "vendor/RakNet/BitStream.h"
+
+#include <string.h>
+#include <vector>
+
+static constexpr uint32_t TICK_PACKETS = 100;
+// every field of the biggest packet, a byte or more each
+static constexpr uint32_t PACKET_SOURCE_BYTES = 128;
+
+// field widths in bits: id, player, then the packet's own, compressed quaternions and vectors
+// as their sign bits and shorts
+static const std::vector<int> g_onFootFields = { 8, 16, 1, 16, 1, 16, 16, 96, 1, 1, 1, 1, 16, 16, 16, 8, 8, 8, 32, 16, 16, 16, 1 };
+static const std::vector<int> g_onFootSurfFields = { 16, 32, 32, 32 };
+static const std::vector<int> g_inCarFields = { 8, 16, 16, 16, 16, 16, 1, 1, 1, 1, 16, 16, 16, 96, 32, 16, 16, 16, 16, 8, 8, 1, 1, 32, 1, 16 };
+static const std::vector<int> g_aimFields = { 8, 16, 8, 96, 96, 32, 2, 6, 8 };
+
+struct stSyncPacket
+{
+	std::vector<int> fields;
+	uint8_t source[PACKET_SOURCE_BYTES];
+	uint8_t read[PACKET_SOURCE_BYTES];
+	RakNet::BitStream stream;
+	// the same packet as the bytewise kernels write it
+	RakNet::BitStream byteStream;
+};
+
+// RakNet's BitStream::WriteBits, out of line like the real one
+__attribute__((noinline)) static void WriteBitsBytewise(RakNet::BitStream& bs, const unsigned char* input, int numberOfBitsToWrite, const bool rightAlignedBits)
+{
+	if(numberOfBitsToWrite <= 0) {
+		return;
+	}
+	bs.AddBitsAndReallocate(numberOfBitsToWrite);
+	int offset = 0;
+	int numberOfBitsUsedMod8 = bs.numberOfBitsUsed & 7;
+	while(numberOfBitsToWrite > 0) {
+		unsigned char dataByte = input[offset];
+		if(numberOfBitsToWrite < 8 && rightAlignedBits) {
+			dataByte <<= 8 - numberOfBitsToWrite;
+		}
+		if(numberOfBitsUsedMod8 == 0) {
+			bs.data[bs.numberOfBitsUsed >> 3] = dataByte;
+		} else {
+			bs.data[bs.numberOfBitsUsed >> 3] |= dataByte >> numberOfBitsUsedMod8;
+			if(8 - numberOfBitsUsedMod8 < numberOfBitsToWrite) {
+				bs.data[(bs.numberOfBitsUsed >> 3) + 1] = (unsigned char)(dataByte << (8 - numberOfBitsUsedMod8));
+			}
+		}
+		bs.numberOfBitsUsed += numberOfBitsToWrite >= 8 ? 8 : numberOfBitsToWrite;
+		numberOfBitsToWrite -= 8;
+		offset++;
+	}
+}
+
+// RakNet's BitStream::ReadBits, out of line like the real one
+__attribute__((noinline)) static bool ReadBitsBytewise(RakNet::BitStream& bs, unsigned char* output, int numberOfBitsToRead, const bool alignBitsToRight)
+{
+	if(numberOfBitsToRead <= 0 || bs.readOffset + numberOfBitsToRead > bs.numberOfBitsUsed) {
+		return false;
+	}
+	int offset = 0;
+	memset(output, 0, BITS_TO_BYTES(numberOfBitsToRead));
+	int readOffsetMod8 = bs.readOffset & 7;
+	while(numberOfBitsToRead > 0) {
+		output[offset] |= bs.data[bs.readOffset >> 3] << readOffsetMod8;
+		if(readOffsetMod8 > 0 && numberOfBitsToRead > 8 - readOffsetMod8) {
+			output[offset] |= bs.data[(bs.readOffset >> 3) + 1] >> (8 - readOffsetMod8);
+		}
+		numberOfBitsToRead -= 8;
+		if(numberOfBitsToRead < 0) {
+			if(alignBitsToRight) {
+				output[offset] >>= -numberOfBitsToRead;
+			}
+			bs.readOffset += 8 + numberOfBitsToRead;
+		} else {
+			bs.readOffset += 8;
+		}
+		offset++;
+	}
+	return true;
+}
+
+template <bool bytewise>
+static void WritePacket(RakNet::BitStream& bs, const stSyncPacket& packet)
+{
+	const uint8_t* source = packet.source;
+	for(int bits : packet.fields) {
+		if(bytewise) {
+			WriteBitsBytewise(bs, source, bits, true);
+		} else {
+			bs.WriteBits(source, bits, true);
+		}
+		source += BITS_TO_BYTES(bits);
+	}
+}
+
+template <bool bytewise>
+static void ReadPacket(RakNet::BitStream& bs, stSyncPacket& packet)
+{
+	uint8_t* read = packet.read;
+	for(int bits : packet.fields) {
+		if(!(bytewise ? ReadBitsBytewise(bs, read, bits, true) : bs.ReadBits(read, bits, true))) {
+			CNetBench::Fail("a field read past the packet");
+		}
+		read += BITS_TO_BYTES(bits);
+	}
+}
+
+struct stSyncTick
+{
+	stSyncPacket packets[TICK_PACKETS];
+
+	stSyncTick()
+	{
+		for(uint32_t i = 0; i < TICK_PACKETS; i++) {
+			stSyncPacket& packet = packets[i];
+			if(i % 4 == 3) {
+				packet.fields = g_inCarFields;
+			} else if(i % 7 == 5) {
+				packet.fields = g_aimFields;
+			} else {
+				packet.fields = g_onFootFields;
+				if(i % 5 == 0) {
+					packet.fields.insert(packet.fields.end(), g_onFootSurfFields.begin(), g_onFootSurfFields.end());
+				}
+			}
+			CNetBench::Fill(packet.source, PACKET_SOURCE_BYTES, i);
+			// a partial byte holds its bits on the right, as rightAlignedBits has them
+			uint8_t* source = packet.source;
+			for(int bits : packet.fields) {
+				if(bits & 7) {
+					source[bits >> 3] &= (1 << (bits & 7)) - 1;
+				}
+				source += BITS_TO_BYTES(bits);
+			}
+			uint32_t sourceBytes = (uint32_t)(source - packet.source);
+
+			WritePacket<false>(packet.stream, packet);
+			WritePacket<true>(packet.byteStream, packet);
+			if(packet.stream.GetNumberOfBitsUsed() != packet.byteStream.GetNumberOfBitsUsed()
+				|| memcmp(packet.stream.GetData(), packet.byteStream.GetData(), BITS_TO_BYTES(packet.stream.GetNumberOfBitsUsed()))) {
+				CNetBench::Fail("WriteBits and the bytewise reference wrote different streams");
+			}
+			ReadPacket<false>(packet.stream, packet);
+			if(memcmp(packet.read, packet.source, sourceBytes)) {
+				CNetBench::Fail("ReadBits read back different fields");
+			}
+			memset(packet.read, 0, sizeof(packet.read));
+			ReadPacket<true>(packet.byteStream, packet);
+			if(memcmp(packet.read, packet.source, sourceBytes)) {
+				CNetBench::Fail("the bytewise reference read back different fields");
+			}
+		}
+	}
+};
+
+static stSyncTick& GetSyncTick()
+{
+	static stSyncTick tick;
+	return tick;
+}
+
+template <bool bytewise>
+static void WriteSync(uint32_t iterations)
+{
+	stSyncTick& tick = GetSyncTick();
+	for(uint32_t i = 0; i < iterations; i++) {
+		stSyncPacket& packet = tick.packets[i % TICK_PACKETS];
+		RakNet::BitStream& bs = bytewise ? packet.byteStream : packet.stream;
+		bs.Reset();
+		WritePacket<bytewise>(bs, packet);
+		CNetBench::Keep(bs.GetData());
+	}
+}
+
+template <bool bytewise>
+static void ReadSync(uint32_t iterations)
+{
+	stSyncTick& tick = GetSyncTick();
+	for(uint32_t i = 0; i < iterations; i++) {
+		stSyncPacket& packet = tick.packets[i % TICK_PACKETS];
+		RakNet::BitStream& bs = bytewise ? packet.byteStream : packet.stream;
+		bs.ResetReadPointer();
+		ReadPacket<bytewise>(bs, packet);
+		CNetBench::Keep(packet.read);
+	}
+}
+
+static void BenchWriteSync(uint32_t iterations)
+{
+	WriteSync<false>(iterations);
+}
+NETBENCH_CASE("bitstream/write-sync", BenchWriteSync);
+
+static void BenchWriteSyncBytewise(uint32_t iterations)
+{
+	WriteSync<true>(iterations);
+}
+NETBENCH_CASE("bitstream/write-sync-bytewise", BenchWriteSyncBytewise);
+
+static void BenchReadSync(uint32_t iterations)
+{
+	ReadSync<false>(iterations);
+}
+NETBENCH_CASE("bitstream/read-sync", BenchReadSync);
+
+static void BenchReadSyncBytewise(uint32_t iterations)
+{
+	ReadSync<true>(iterations);
+}
+NETBENCH_CASE("bitstream/read-sync-bytewise", BenchReadSyncBytewise);
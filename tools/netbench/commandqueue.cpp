@@ -0,0 +1,133 @@
+// The queue RakPeer::Send, RPC and CloseConnection hand their commands to the update thread
+// through: the lock-free MultiProducerSingleConsumer it is now, against the mutex around a
+// SingleProducerConsumer it replaced. One op is one command written and read back, a frame's
+// worth of FRAME_COMMANDS at a time, sync and the RPCs that go with it. Setup has WRITERS
+// threads write COMMANDS_PER_WRITER commands each while a reader drains them at the update
+// thread's pace, and fails if a command is lost or one writer's commands come out of order.
+#include "netbench.h"
+
+#include "vendor/RakNet/MultiProducerSingleConsumer.h"
+#include "vendor/RakNet/RakNetDefines.h"
+#include "vendor/RakNet/RakSleep.h"
+#include "vendor/RakNet/SimpleMutex.h"
+#include "vendor/RakNet/SingleProducerConsumer.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static constexpr uint32_t FRAME_COMMANDS = 16;
+static constexpr uint32_t WRITERS = 4;
+// more than BUFFERED_COMMAND_NODES, so the writers also run past the slab onto the heap
+static constexpr uint32_t COMMANDS_PER_WRITER = 20000;
+static constexpr uint32_t READER_SLEEP_MS = 1;
+
+// what RakPeer's BufferedCommandStruct carries, give or take
+struct stCommand
+{
+	uint32_t writer;
+	uint32_t sequence;
+	char* data;
+	int numberOfBitsToSend;
+};
+
+typedef DataStructures::MultiProducerSingleConsumer<stCommand> CommandQueue;
+
+static void CheckConcurrentWriters()
+{
+	CommandQueue queue(BUFFERED_COMMAND_NODES);
+	std::atomic<uint32_t> writing(WRITERS);
+	std::vector<std::thread> writers;
+	for(uint32_t writer = 0; writer < WRITERS; writer++) {
+		writers.emplace_back([&queue, &writing, writer] {
+			for(uint32_t sequence = 0; sequence < COMMANDS_PER_WRITER; sequence++) {
+				stCommand* command = queue.WriteLock();
+				command->writer = writer;
+				command->sequence = sequence;
+				command->data = nullptr;
+				command->numberOfBitsToSend = 0;
+				queue.WriteUnlock(command);
+			}
+			writing.fetch_sub(1, std::memory_order_release);
+		});
+	}
+
+	uint32_t next[WRITERS] = {};
+	uint32_t read = 0;
+	while(read < WRITERS * COMMANDS_PER_WRITER) {
+		bool done = writing.load(std::memory_order_acquire) == 0;
+		stCommand* command;
+		while((command = queue.ReadLock()) != nullptr) {
+			if(command->writer >= WRITERS || command->sequence != next[command->writer]) {
+				CNetBench::Fail("a writer's commands came out of order");
+			}
+			next[command->writer]++;
+			read++;
+			queue.ReadUnlock();
+		}
+		if(done && read < WRITERS * COMMANDS_PER_WRITER) {
+			CNetBench::Fail("commands were lost");
+		}
+		RakSleep(READER_SLEEP_MS);
+	}
+	for(std::thread& writer : writers) {
+		writer.join();
+	}
+}
+
+struct stCheckedQueue
+{
+	CommandQueue queue;
+
+	stCheckedQueue() : queue(BUFFERED_COMMAND_NODES)
+	{
+		CheckConcurrentWriters();
+	}
+};
+
+static void BenchCommandQueue(uint32_t iterations)
+{
+	static stCheckedQueue checkedQueue;
+	CommandQueue& queue = checkedQueue.queue;
+	for(uint32_t i = 0; i < iterations; i += FRAME_COMMANDS) {
+		for(uint32_t j = 0; j < FRAME_COMMANDS; j++) {
+			stCommand* command = queue.WriteLock();
+			command->writer = 0;
+			command->sequence = j;
+			command->data = nullptr;
+			command->numberOfBitsToSend = 0;
+			queue.WriteUnlock(command);
+		}
+		stCommand* command;
+		while((command = queue.ReadLock()) != nullptr) {
+			CNetBench::Keep(command);
+			queue.ReadUnlock();
+		}
+	}
+}
+NETBENCH_CASE("commandqueue/mpsc", BenchCommandQueue);
+
+// the reference: every write under the mutex, as RakPeer did with _RAKNET_THREADSAFE
+static void BenchCommandQueueLocked(uint32_t iterations)
+{
+	static DataStructures::SingleProducerConsumer<stCommand> queue;
+	static SimpleMutex mutex;
+	for(uint32_t i = 0; i < iterations; i += FRAME_COMMANDS) {
+		for(uint32_t j = 0; j < FRAME_COMMANDS; j++) {
+			mutex.Lock();
+			stCommand* command = queue.WriteLock();
+			command->writer = 0;
+			command->sequence = j;
+			command->data = nullptr;
+			command->numberOfBitsToSend = 0;
+			queue.WriteUnlock();
+			mutex.Unlock();
+		}
+		stCommand* command;
+		while((command = queue.ReadLock()) != nullptr) {
+			CNetBench::Keep(command);
+			queue.ReadUnlock();
+		}
+	}
+}
+NETBENCH_CASE("commandqueue/spsc-locked", BenchCommandQueueLocked);
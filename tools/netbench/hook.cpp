@@ -0,0 +1,83 @@
+// What an inline hook adds to a call, per backend: the jump at the target's entry, the
+// replacement, and the trampoline back into the relocated original. hook/direct is the
+// same work unhooked; the difference is the per-call overhead. Device only, the
+// backends patch ARM/Thumb or A64 code.
+#if defined(__arm__) || defined(__aarch64__)
+#include "netbench.h"
+
+#include "hook.h"
+
+// one target per backend, a target can only be hooked once
+#define HOOK_BENCH_TARGET(name) \
+	extern "C" __attribute__((noinline)) int name(int value) \
+	{ \
+		asm volatile(""); \
+		return value * 3 + 1; \
+	}
+
+HOOK_BENCH_TARGET(HookBenchDirect)
+HOOK_BENCH_TARGET(HookBenchSubstrate)
+HOOK_BENCH_TARGET(HookBenchDobby)
+HOOK_BENCH_TARGET(HookBenchAnd64)
+
+template<eHookBackend BACKEND>
+struct stHookedTarget
+{
+	static int (*orig)(int);
+	static int Replace(int value) { return orig(value) + 1; }
+};
+template<eHookBackend BACKEND>
+int (*stHookedTarget<BACKEND>::orig)(int) = nullptr;
+
+static int DirectReplace(int value)
+{
+	return HookBenchDirect(value) + 1;
+}
+
+// calls go through a volatile pointer, so every iteration is a real call to the entry
+static void CallLoop(int (*volatile fn)(int), uint32_t iterations)
+{
+	int acc = 0;
+	for(uint32_t i = 0; i < iterations; i++) {
+		acc += fn((int)i);
+	}
+	CNetBench::Keep(&acc);
+}
+
+static void BenchDirect(uint32_t iterations)
+{
+	CallLoop(&DirectReplace, iterations);
+}
+NETBENCH_CASE("hook/direct", BenchDirect);
+
+template<eHookBackend BACKEND>
+static void BenchHooked(int (*target)(int), uint32_t iterations)
+{
+	if(!stHookedTarget<BACKEND>::orig && !CHook::Install(BACKEND, (void*)target,
+		(void*)&stHookedTarget<BACKEND>::Replace, (void**)&stHookedTarget<BACKEND>::orig)) {
+		return;
+	}
+	CallLoop(target, iterations);
+}
+
+#if defined(__arm__)
+static void BenchSubstrate(uint32_t iterations)
+{
+	BenchHooked<eHookBackend::SUBSTRATE>(&HookBenchSubstrate, iterations);
+}
+NETBENCH_CASE("hook/substrate", BenchSubstrate);
+#else
+static void BenchAnd64(uint32_t iterations)
+{
+	BenchHooked<eHookBackend::AND64>(&HookBenchAnd64, iterations);
+}
+NETBENCH_CASE("hook/and64", BenchAnd64);
+#endif
+
+static void BenchDobby(uint32_t iterations)
+{
+	BenchHooked<eHookBackend::DOBBY>(&HookBenchDobby, iterations);
+}
+NETBENCH_CASE("hook/dobby", BenchDobby);
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+// Just enough of the NDK's jni.h for plugin.h and plugin.cpp to build on the host.
+// netbench never calls into Java.
+#include <cstdint>
+
+typedef int32_t jint;
+typedef int8_t jbyte;
+typedef uint8_t jboolean;
+typedef int32_t jsize;
+typedef int64_t jlong;
+
+class _jobject {};
+typedef _jobject* jobject;
+typedef jobject jclass;
+typedef jobject jstring;
+typedef jobject jarray;
+typedef jobject jbyteArray;
+
+#define JNI_VERSION_1_6 0x00010006
+#define JNI_OK 0
+#define JNI_ABORT 2
+
+struct _JNIEnv
+{
+	jsize GetArrayLength(jarray) { return 0; }
+	void GetByteArrayRegion(jbyteArray, jsize, jsize, jbyte*) {}
+	void* GetPrimitiveArrayCritical(jarray, jboolean*) { return nullptr; }
+	void ReleasePrimitiveArrayCritical(jarray, void*, jint) {}
+};
+typedef _JNIEnv JNIEnv;
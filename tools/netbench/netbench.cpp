@@ -0,0 +1,241 @@
+// Off-device benchmarks for the translation layer: the RPC fixups in plugin/common.cpp,
+// the receive-side sync decoders, the send-side packet translators and the dialog
+// response path of hook_RakClient__Send, and for the RakNet paths under them and the
+// overlay's GL backend. Game entry points are stubbed in stubs.cpp, so only plugin, RakNet
+// and ImGui code is measured.
+//
+// Host build, from the repository root:
+//
+//   g++ -std=c++17 -O3 -Itools/netbench/host -I. tools/netbench/*.cpp \
+//       plugin/common.cpp plugin/translator.cpp plugin/syncdecode.cpp plugin/uisync.cpp \
+//       plugin/rpcarena.cpp plugin/worldsnapshot.cpp plugin/netcapture.cpp \
+//       plugin/chatbuffer.cpp plugin/textdrawbuffer.cpp plugin/lz4.cpp plugin/deltasync.cpp plugin/capabilities.cpp plugin/sendclass.cpp plugin/debounce.cpp plugin/joinhandshake.cpp plugin/tracering.cpp plugin/stallwatchdog.cpp plugin/arena.cpp \
+//       plugin/pools/vehiclequeue.cpp plugin/pools/vehiclepool.cpp plugin/pools/objectqueue.cpp plugin/pools/playerqueue.cpp plugin/pools/playernames.cpp plugin/pools/playerstate.cpp game/math/simd.cpp scheduler.cpp workers.cpp threadpolicy.cpp \
+//       config.cpp featureflags.cpp plugin.cpp offsets.cpp sigscan.cpp \
+//       plugin/rpccompress.cpp plugin/systrace.cpp gui/dialogbox.cpp vendor/RakNet/*.cpp vendor/RakNet/SAMP/*.cpp \
+//       -lpthread -o netbench
+//   ./netbench [filter]
+//   ./netbench --replay capture.brnc [--realtime] [--from S] [--to S] [--only in-packet|in-rpc|out-packet|out-rpc[:id]]...
+//
+// Either form takes --save-baseline FILE, which stores every case's best ns/op (and, for a
+// replay, each direction and id's ns/op), or --baseline FILE [--threshold PERCENT], which
+// compares against one and exits with 2 when anything got more than PERCENT (default 10)
+// slower. Keep a baseline per reference device and capture; numbers from different
+// machines don't compare.
+//
+// The overlay/* cases, the ImGui GL backend on a pbuffer, also need EGL and GL ES 3: add
+// -DNETBENCH_GL -DIMGUI_IMPL_OPENGL_ES3 vendor/imgui/*.cpp vendor/imgui/backend/*.cpp
+// -lEGL -lGLESv2 to the host build, and without a display run it with
+// EGL_PLATFORM=surfaceless. The device build always has them.
+//
+// On-device: ndk-build NETBENCH=1, push libs/armeabi-v7a/netbench to /data/local/tmp and
+// run it from adb shell. Pin it to one core (taskset) for stable numbers. The hook/*
+// cases, which compare the inline hooking backends, only exist in the device build.
+#include "netbench.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
+stBenchCase* CNetBench::m_cases = nullptr;
+const stBenchCase* CNetBench::m_pRunning = nullptr;
+
+// "netbench-baseline <version>", then one "<name> <ns/op>" line per result
+static constexpr int BASELINE_VERSION = 1;
+
+struct stBenchResult
+{
+	std::string name;
+	double nsPerOp;
+};
+static std::vector<stBenchResult> g_results;
+
+static constexpr uint64_t TARGET_RUN_NS = 50000000;
+static constexpr int REPEATS = 7;
+
+static uint64_t NowNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+bool CNetBench::Register(stBenchCase* benchCase)
+{
+	// keep the list sorted, static init order across files is arbitrary
+	stBenchCase** link = &m_cases;
+	while(*link && strcmp((*link)->name, benchCase->name) < 0) {
+		link = &(*link)->next;
+	}
+	benchCase->next = *link;
+	*link = benchCase;
+	return true;
+}
+
+void CNetBench::Fill(uint8_t* data, uint32_t size, uint32_t seed)
+{
+	uint32_t state = seed * 2654435761u + 1;
+	for(uint32_t i = 0; i < size; i++) {
+		state = state * 1664525u + 1013904223u;
+		data[i] = (uint8_t)(state >> 24);
+	}
+}
+
+static uint64_t TimeRun(BenchFn run, uint32_t iterations)
+{
+	uint64_t start = NowNs();
+	run(iterations);
+	return NowNs() - start;
+}
+
+int CNetBench::Run(const char* filter)
+{
+	printf("%-32s %12s %12s %12s\n", "case", "best ns/op", "median", "iterations");
+	for(stBenchCase* benchCase = m_cases; benchCase; benchCase = benchCase->next)
+	{
+		if(filter && !strstr(benchCase->name, filter)) {
+			continue;
+		}
+		m_pRunning = benchCase;
+
+		// the first call sets up whatever the case keeps across runs, a context or a connection,
+		// which would otherwise pass for one slow iteration and stop the count growing
+		benchCase->run(1);
+
+		// grow the count until one run is long enough for the clock not to matter
+		uint32_t iterations = 1;
+		uint64_t elapsed = TimeRun(benchCase->run, iterations);
+		while(elapsed < TARGET_RUN_NS / 10 && iterations < (1u << 30)) {
+			iterations *= 4;
+			elapsed = TimeRun(benchCase->run, iterations);
+		}
+		if(elapsed < TARGET_RUN_NS) {
+			uint64_t scaled = (uint64_t)iterations * TARGET_RUN_NS / (elapsed ? elapsed : 1);
+			iterations = (uint32_t)std::min<uint64_t>(scaled, 1u << 30);
+		}
+
+		double perOp[REPEATS];
+		for(int i = 0; i < REPEATS; i++) {
+			perOp[i] = (double)TimeRun(benchCase->run, iterations) / iterations;
+		}
+		std::sort(perOp, perOp + REPEATS);
+		printf("%-32s %12.2f %12.2f %12u\n", benchCase->name, perOp[0], perOp[REPEATS / 2], iterations);
+		// the best run is the one least disturbed by the rest of the system
+		Report(benchCase->name, perOp[0]);
+	}
+	m_pRunning = nullptr;
+	return 0;
+}
+
+void CNetBench::Fail(const char* what)
+{
+	fprintf(stderr, "%s: %s\n", m_pRunning ? m_pRunning->name : "netbench", what);
+	exit(1);
+}
+
+void CNetBench::Report(const char* name, double nsPerOp)
+{
+	g_results.push_back({ name, nsPerOp });
+}
+
+bool CNetBench::SaveBaseline(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if(!file) {
+		return false;
+	}
+	fprintf(file, "netbench-baseline %d\n", BASELINE_VERSION);
+	for(const stBenchResult& result : g_results) {
+		fprintf(file, "%s %.3f\n", result.name.c_str(), result.nsPerOp);
+	}
+	return fclose(file) == 0;
+}
+
+int CNetBench::CompareBaseline(const char* path, double thresholdPercent)
+{
+	FILE* file = fopen(path, "r");
+	if(!file) {
+		return -1;
+	}
+	int version = 0;
+	if(fscanf(file, "netbench-baseline %d", &version) != 1 || version != BASELINE_VERSION) {
+		fprintf(stderr, "%s: not a version %d baseline\n", path, BASELINE_VERSION);
+		fclose(file);
+		return -1;
+	}
+	std::vector<stBenchResult> baseline;
+	char name[256];
+	double nsPerOp;
+	while(fscanf(file, "%255s %lf", name, &nsPerOp) == 2) {
+		baseline.push_back({ name, nsPerOp });
+	}
+	fclose(file);
+
+	int regressions = 0;
+	printf("\n%-32s %12s %12s %9s\n", "against baseline", "was ns/op", "now", "change");
+	for(const stBenchResult& result : g_results)
+	{
+		auto it = std::find_if(baseline.begin(), baseline.end(), [&](const stBenchResult& entry) {
+			return entry.name == result.name;
+		});
+		if(it == baseline.end()) {
+			printf("%-32s %12s %12.2f %9s\n", result.name.c_str(), "-", result.nsPerOp, "new");
+			continue;
+		}
+		double change = it->nsPerOp > 0. ? (result.nsPerOp / it->nsPerOp - 1.) * 100. : 0.;
+		bool regressed = change > thresholdPercent;
+		regressions += regressed;
+		printf("%-32s %12.2f %12.2f %+8.1f%%%s\n", result.name.c_str(), it->nsPerOp, result.nsPerOp, change,
+			regressed ? "  SLOWER" : "");
+	}
+	printf("%d of %zu slower by more than %.1f%%\n", regressions, g_results.size(), thresholdPercent);
+	return regressions;
+}
+
+int main(int argc, char** argv)
+{
+	// the baseline options go with either form, so they are taken out first
+	const char* savePath = nullptr;
+	const char* baselinePath = nullptr;
+	double threshold = 10.;
+	std::vector<char*> args;
+	for(int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if(!strcmp(argv[i], "--save-baseline") && hasValue) {
+			savePath = argv[++i];
+		} else if(!strcmp(argv[i], "--baseline") && hasValue) {
+			baselinePath = argv[++i];
+		} else if(!strcmp(argv[i], "--threshold") && hasValue) {
+			threshold = atof(argv[++i]);
+		} else {
+			args.push_back(argv[i]);
+		}
+	}
+
+	int status;
+	if(args.size() > 1 && !strcmp(args[0], "--replay")) {
+		status = CNetBench::Replay((int)args.size() - 1, args.data() + 1);
+	} else {
+		status = CNetBench::Run(args.empty() ? nullptr : args[0]);
+	}
+	if(status != 0) {
+		return status;
+	}
+	if(savePath && !CNetBench::SaveBaseline(savePath)) {
+		fprintf(stderr, "%s: can't write the baseline\n", savePath);
+		return 1;
+	}
+	if(baselinePath) {
+		int regressions = CNetBench::CompareBaseline(baselinePath, threshold);
+		if(regressions < 0) {
+			fprintf(stderr, "%s: can't read the baseline\n", baselinePath);
+			return 1;
+		}
+		return regressions ? 2 : 0;
+	}
+	return 0;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+
+// Micro-benchmark harness for the translation layer. A case runs its operation
+// `iterations` times; the harness picks the count, repeats the run and reports the
+// best and median ns/op. Cases register themselves at static init:
+//
+//   static void BenchSomething(uint32_t iterations) { ... }
+//   NETBENCH_CASE("group/something", BenchSomething);
+typedef void (*BenchFn)(uint32_t iterations);
+
+struct stBenchCase
+{
+	const char* name;
+	BenchFn run;
+	stBenchCase* next;
+};
+
+class CNetBench
+{
+public:
+	static bool Register(stBenchCase* benchCase);
+	// runs every case whose name contains filter (all of them for NULL)
+	static int Run(const char* filter);
+
+	// keeps the compiler from proving a result unused and dropping the work
+	template<typename T>
+	static inline void Keep(T* value)
+	{
+		asm volatile("" : : "r"(value) : "memory");
+	}
+
+	// deterministic filler, so runs are comparable across builds and devices
+	static void Fill(uint8_t* data, uint32_t size, uint32_t seed);
+
+	// a case's check failed: prints what under the running case's name and exits with 1, so a
+	// wrong answer fails the run rather than benchmarking well
+	[[noreturn]] static void Fail(const char* what);
+
+	// hands an inbound RPC to FixBrokenRPC the way RakPeer::HandleRPCPacket does, with a
+	// handler that does nothing in place of the game's
+	static void DispatchRPC(int rpcId, unsigned char* payload, uint32_t bits);
+
+	// a UDP socket bound to a free loopback port; exits when there is none
+	static int BindLoopback(uint16_t* port);
+	// undoes the encryption SocketLayer::SendTo gives a datagram sent to port, checksum byte and
+	// all; returns the length of what is left
+	static int DecryptDatagram(const uint8_t* data, int length, uint16_t port, uint8_t* out);
+
+	// feeds a CNetCapture log through the same paths, see replay.cpp
+	static int Replay(int argc, char** argv);
+
+	// a measurement for --save-baseline and --baseline, in ns/op
+	static void Report(const char* name, double nsPerOp);
+	// writes what Report collected; false when the file can't be written
+	static bool SaveBaseline(const char* path);
+	// prints each reported result against the file's; the number of cases more than
+	// thresholdPercent slower, or -1 when the file can't be read
+	static int CompareBaseline(const char* path, double thresholdPercent);
+
+private:
+	static stBenchCase* m_cases;
+	// the case Run is in, for Fail
+	static const stBenchCase* m_pRunning;
+};
+
+#define NETBENCH_CONCAT2(a, b) a##b
+#define NETBENCH_CONCAT(a, b) NETBENCH_CONCAT2(a, b)
+#define NETBENCH_CASE(name, fn) \
+	static stBenchCase NETBENCH_CONCAT(g_benchCase, __LINE__) = { name, fn, nullptr }; \
+	static bool NETBENCH_CONCAT(g_benchRegistered, __LINE__) = CNetBench::Register(&NETBENCH_CONCAT(g_benchCase, __LINE__))
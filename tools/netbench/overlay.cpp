@@ -0,0 +1,176 @@
+// The overlay's GL backend on a pbuffer: a frame of RenderDrawData with the backend's state
+// tracking on and off, and a check that what the game leaves bound at swap time is what it
+// finds after the overlay. A stand-in for the game binds a texture, a buffer and the viewport
+// before each frame, and moves between two such states every STATE_HOLD_FRAMES, a menu and then
+// driving say. The draw lists are built once, as on a frame the overlay divider skips. On the
+// host, llvmpipe's rasterising is most of a frame; the device numbers are the ones to compare.
+// Needs EGL and GL ES 3, so only built with -DNETBENCH_GL, see netbench.cpp.
+#ifdef NETBENCH_GL
+#include "netbench.h"
+
+#include "vendor/imgui/imgui.h"
+#include "vendor/imgui/backend/imgui_impl_opengl3.h"
+
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+#include <string.h>
+
+static constexpr int WIDTH = 640;
+static constexpr int HEIGHT = 360;
+// longer than the backend takes to learn a state, shorter than its recheck interval
+static constexpr uint32_t STATE_HOLD_FRAMES = 90;
+
+// what the game has bound when the swap hook runs
+struct stGameState
+{
+	GLint activeTexture;
+	GLint texture;		// on GL_TEXTURE0
+	GLint arrayBuffer;
+	GLint viewport[4];
+	GLboolean blend;
+	GLboolean depthTest;
+};
+
+struct stOverlay
+{
+	GLuint textures[2];
+	GLuint buffers[2];
+	stGameState states[2];
+	uint32_t frame = 0;
+
+	stOverlay()
+	{
+		EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		if(display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+			CNetBench::Fail("no EGL display");
+		}
+		const EGLint configAttribs[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+			EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8, EGL_NONE };
+		EGLConfig config;
+		EGLint configs = 0;
+		if(!eglChooseConfig(display, configAttribs, &config, 1, &configs) || configs == 0) {
+			CNetBench::Fail("no GL ES 3 pbuffer config");
+		}
+		const EGLint surfaceAttribs[] = { EGL_WIDTH, WIDTH, EGL_HEIGHT, HEIGHT, EGL_NONE };
+		const EGLint contextAttribs[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE };
+		EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+		EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+		if(surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context)) {
+			CNetBench::Fail("no GL ES 3 context");
+		}
+
+		ImGui::CreateContext();
+		ImGuiIO& io = ImGui::GetIO();
+		io.IniFilename = nullptr;
+		io.DisplaySize = ImVec2((float)WIDTH, (float)HEIGHT);
+		ImGui_ImplOpenGL3_Init("#version 300 es");
+		// a new window is hidden on its first frame while it is sized
+		for(int frame = 0; frame < 2; frame++) {
+			ImGui_ImplOpenGL3_NewFrame();
+			ImGui::NewFrame();
+			ImGui::SetNextWindowPos(ImVec2(10.f, 10.f));
+			ImGui::Begin("chat");
+			for(int i = 0; i < 12; i++) {
+				ImGui::Text("player_%d: message number %d", i, i * 7);
+			}
+			ImGui::End();
+			ImGui::SetNextWindowPos(ImVec2(400.f, 200.f));
+			ImGui::Begin("hud");
+			ImGui::ProgressBar(0.7f);
+			ImGui::Button("spawn");
+			ImGui::End();
+			ImGui::Render();
+		}
+		if(ImGui::GetDrawData()->TotalVtxCount == 0) {
+			CNetBench::Fail("nothing to draw");
+		}
+
+		glGenTextures(2, textures);
+		glGenBuffers(2, buffers);
+		for(int i = 0; i < 2; i++) {
+			glBindTexture(GL_TEXTURE_2D, textures[i]);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 4, 4, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+			glBufferData(GL_ARRAY_BUFFER, 64, nullptr, GL_STATIC_DRAW);
+		}
+		states[0] = { GL_TEXTURE0, (GLint)textures[0], (GLint)buffers[0], { 0, 0, WIDTH, HEIGHT }, GL_FALSE, GL_TRUE };
+		states[1] = { GL_TEXTURE1, (GLint)textures[1], (GLint)buffers[1], { 0, 0, WIDTH / 2, HEIGHT / 2 }, GL_TRUE, GL_FALSE };
+	}
+
+	// binds the next frame's game state and returns it
+	const stGameState& Bind()
+	{
+		const stGameState& state = states[(frame++ / STATE_HOLD_FRAMES) & 1];
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, state.texture);
+		glActiveTexture(state.activeTexture);
+		glBindBuffer(GL_ARRAY_BUFFER, state.arrayBuffer);
+		glViewport(state.viewport[0], state.viewport[1], state.viewport[2], state.viewport[3]);
+		if(state.blend) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+		if(state.depthTest) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+		return state;
+	}
+};
+
+static stOverlay& GetOverlay()
+{
+	static stOverlay overlay;
+	return overlay;
+}
+
+static void RunFrames(bool tracking, uint32_t iterations)
+{
+	stOverlay& overlay = GetOverlay();
+	ImGui_ImplOpenGL3_SetStateTracking(tracking);
+	for(uint32_t i = 0; i < iterations; i++) {
+		overlay.Bind();
+		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+	}
+	// what was queued is part of the frames
+	glFinish();
+}
+
+// one frame of the overlay, the game's state put back afterwards. The difference between the two
+// is what learning the settled state saves; the diffed setup and restore are in both
+static void BenchFrameTracked(uint32_t iterations)
+{
+	RunFrames(true, iterations);
+}
+NETBENCH_CASE("overlay/frame-tracked", BenchFrameTracked);
+
+static void BenchFrameUntracked(uint32_t iterations)
+{
+	RunFrames(false, iterations);
+}
+NETBENCH_CASE("overlay/frame-untracked", BenchFrameUntracked);
+
+// With tracking on, every frame hands the game back exactly what it bound, including the frames
+// after it moved to the other state once the backend had learned the first. Fails otherwise. One
+// op is both states' stretches.
+static void BenchStateFollowsGame(uint32_t iterations)
+{
+	stOverlay& overlay = GetOverlay();
+	ImGui_ImplOpenGL3_SetStateTracking(true);
+	for(uint32_t i = 0; i < iterations * STATE_HOLD_FRAMES * 2; i++) {
+		const stGameState& expected = overlay.Bind();
+		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+		stGameState found;
+		glGetIntegerv(GL_ACTIVE_TEXTURE, &found.activeTexture);
+		glActiveTexture(GL_TEXTURE0);
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &found.texture);
+		glActiveTexture(found.activeTexture);
+		glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &found.arrayBuffer);
+		glGetIntegerv(GL_VIEWPORT, found.viewport);
+		found.blend = glIsEnabled(GL_BLEND);
+		found.depthTest = glIsEnabled(GL_DEPTH_TEST);
+		if(found.activeTexture != expected.activeTexture || found.texture != expected.texture
+			|| found.arrayBuffer != expected.arrayBuffer || memcmp(found.viewport, expected.viewport, sizeof(found.viewport))
+			|| found.blend != expected.blend || found.depthTest != expected.depthTest) {
+			CNetBench::Fail("the overlay left the game a state it didn't bind");
+		}
+	}
+	glFinish();
+}
+NETBENCH_CASE("overlay/state-follows-game", BenchStateFollowsGame);
+#endif
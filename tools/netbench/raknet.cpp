@@ -0,0 +1,459 @@
+// RakNet itself: a RakClient connected over loopback to a bare UDP socket standing in for
+// the server. The socket answers ID_OPEN_CONNECTION_REQUEST and nothing else, so the client
+// sits in REQUESTED_CONNECTION with a live remote system and everything it sends lands on
+// the socket, where a case can see when it left. Cases that need acks use a second client
+// that connects for real, see stServer.
+#include "netbench.h"
+
+#include "vendor/RakNet/BitStream.h"
+#include "vendor/RakNet/GetTime.h"
+#include "vendor/RakNet/MTUSize.h"
+#include "vendor/RakNet/PacketEnumerations.h"
+#include "vendor/RakNet/RakClientInterface.h"
+#include "vendor/RakNet/RakNetDefines.h"
+#include "vendor/RakNet/RakNetStatistics.h"
+#include "vendor/RakNet/RakNetworkFactory.h"
+#include "vendor/RakNet/RakSleep.h"
+#include "vendor/RakNet/ReliabilityLayer.h"
+#include "vendor/RakNet/SocketLayer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+static constexpr int DATAGRAM_TIMEOUT_MS = 1000;
+// ID_OPEN_CONNECTION_REQUEST's three bytes and the checksum
+static constexpr int OPEN_REQUEST_LENGTH = 4;
+
+int CNetBench::BindLoopback(uint16_t* port)
+{
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t addressLength = sizeof(address);
+	if(fd < 0 || bind(fd, (sockaddr*)&address, sizeof(address)) || getsockname(fd, (sockaddr*)&address, &addressLength)) {
+		CNetBench::Fail("can't open a loopback socket");
+	}
+	*port = ntohs(address.sin_port);
+	return fd;
+}
+
+extern unsigned char sampEncrTable[256];
+
+// kyretardizeDatagram backwards: the checksum byte dropped, every odd byte unkeyed and the
+// table lookup undone
+int CNetBench::DecryptDatagram(const uint8_t* data, int length, uint16_t port, uint8_t* out)
+{
+	static uint8_t inverse[256];
+	static bool built = false;
+	if(!built) {
+		for(int i = 0; i < 256; i++) {
+			inverse[sampEncrTable[i]] = (uint8_t)i;
+		}
+		built = true;
+	}
+	const uint8_t key = (uint8_t)(port ^ 0xCC);
+	for(int i = 0; i < length - 1; i++) {
+		out[i] = inverse[(i & 1) ? data[i + 1] ^ key : data[i + 1]];
+	}
+	return length - 1;
+}
+
+struct stLoopback
+{
+	int server;
+	RakClientInterface* client;
+
+	stLoopback()
+	{
+		uint16_t port;
+		server = CNetBench::BindLoopback(&port);
+
+		client = RakNetworkFactory::GetRakClientInterface();
+		// the sleep timer the plugin connects with; 0 would have the update thread spin
+		if(!client->Connect("127.0.0.1", port, 0, 0, 5)) {
+			CNetBench::Fail("the client didn't start");
+		}
+		// one reply to the open request and the client's ID_CONNECTION_REQUEST follows. What the
+		// client sends is encrypted, a checksum byte ahead of it, so only the length tells
+		uint8_t data[2048];
+		sockaddr_in from;
+		if(Receive(data, sizeof(data), &from) != OPEN_REQUEST_LENGTH) {
+			CNetBench::Fail("no open connection request");
+		}
+		const uint8_t reply[2] = { ID_OPEN_CONNECTION_REPLY, 0 };
+		sendto(server, reply, sizeof(reply), 0, (sockaddr*)&from, sizeof(from));
+		if(Receive(data, sizeof(data), &from) < 1) {
+			CNetBench::Fail("no connection request");
+		}
+	}
+
+	// the next datagram the client sent, -1 once DATAGRAM_TIMEOUT_MS pass without one. Waits in
+	// poll rather than spinning, a spin would starve the update thread on a single core
+	int Receive(uint8_t* data, uint32_t size, sockaddr_in* from)
+	{
+		pollfd fd = { server, POLLIN, 0 };
+		if(poll(&fd, 1, DATAGRAM_TIMEOUT_MS) <= 0) {
+			return -1;
+		}
+		socklen_t fromLength = sizeof(*from);
+		return (int)recvfrom(server, data, size, 0, (sockaddr*)from, &fromLength);
+	}
+
+	// waits for a datagram of at least minLength, skipping resends of the connection request
+	bool Expect(int minLength)
+	{
+		uint8_t data[2048];
+		sockaddr_in from;
+		int length;
+		while((length = Receive(data, sizeof(data), &from)) >= 0) {
+			if(length >= minLength) {
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+static stLoopback& GetLoopback()
+{
+	static stLoopback loopback;
+	return loopback;
+}
+
+// What the reliability layer has of a message id, queued or sent. A send still held in the
+// batch is in neither
+static unsigned Accepted(RakClientInterface* client, uint8_t messageId, PacketPriority priority)
+{
+	RakNetStatisticsStruct* statistics = client->GetStatistics();
+	return statistics ? statistics->messageSendBuffer[priority] + statistics->messagesSentPerId[messageId] : 0;
+}
+
+// Waits for the reliability layer to take one more message with this id; the update thread may
+// be mid-cycle, in which case its next one does. Fails past half of SEND_BATCH_MAX_HOLD, which
+// is how long a held send can sit before the update thread gives up on the batch
+static void ExpectAccepted(RakClientInterface* client, uint8_t messageId, PacketPriority priority, unsigned before, RakNetTime sentAt, const char* what)
+{
+	while(Accepted(client, messageId, priority) == before) {
+		if(RakNet::GetTime() - sentAt >= SEND_BATCH_MAX_HOLD / 2) {
+			CNetBench::Fail(what);
+		}
+		RakSleep(0);
+	}
+}
+
+// An aim sync sent with SetImmediateSend in the middle of a frame's send batch is released
+// right away, well inside SEND_BATCH_MAX_HOLD, and its datagram is on the socket before
+// EndSendBatch. Fails otherwise. Nothing acks the loopback, so RakNet's starting send rate
+// paces the datagrams and the time per op is mostly that; the case is here for the check.
+static void BenchImmediateInBatch(uint32_t iterations)
+{
+	static constexpr int SIZE = 64;
+	stLoopback& loopback = GetLoopback();
+	loopback.client->SetImmediateSend(ID_AIM_SYNC, true);
+	char message[SIZE];
+	CNetBench::Fill((uint8_t*)message, SIZE, ID_AIM_SYNC);
+	message[0] = ID_AIM_SYNC;
+	for(uint32_t i = 0; i < iterations; i++) {
+		unsigned before = Accepted(loopback.client, ID_AIM_SYNC, HIGH_PRIORITY);
+		loopback.client->BeginSendBatch();
+		RakNetTime sentAt = RakNet::GetTime();
+		loopback.client->Send(message, SIZE, HIGH_PRIORITY, UNRELIABLE_SEQUENCED, 0);
+		ExpectAccepted(loopback.client, ID_AIM_SYNC, HIGH_PRIORITY, before, sentAt, "an immediate send was held by the send batch");
+		if(!loopback.Expect(SIZE)) {
+			CNetBench::Fail("an immediate send's datagram waited for EndSendBatch");
+		}
+		loopback.client->EndSendBatch();
+	}
+}
+NETBENCH_CASE("raknet/immediate-in-batch", BenchImmediateInBatch);
+
+// A send from another thread while this one has a batch open isn't held by it, as a send from
+// the update thread's callbacks or a worker wouldn't be
+static void BenchOtherThreadInBatch(uint32_t iterations)
+{
+	static constexpr int SIZE = 64;
+	stLoopback& loopback = GetLoopback();
+	char message[SIZE];
+	CNetBench::Fill((uint8_t*)message, SIZE, ID_PLAYER_SYNC);
+	message[0] = ID_PLAYER_SYNC;
+	for(uint32_t i = 0; i < iterations; i++) {
+		unsigned before = Accepted(loopback.client, ID_PLAYER_SYNC, MEDIUM_PRIORITY);
+		loopback.client->BeginSendBatch();
+		RakNetTime sentAt = RakNet::GetTime();
+		std::thread sender([&]() {
+			loopback.client->Send(message, SIZE, MEDIUM_PRIORITY, UNRELIABLE_SEQUENCED, 0);
+		});
+		sender.join();
+		ExpectAccepted(loopback.client, ID_PLAYER_SYNC, MEDIUM_PRIORITY, before, sentAt, "another thread's send was held by the send batch");
+		if(!loopback.Expect(SIZE)) {
+			CNetBench::Fail("another thread's datagram waited for EndSendBatch");
+		}
+		loopback.client->EndSendBatch();
+	}
+}
+NETBENCH_CASE("raknet/other-thread-in-batch", BenchOtherThreadInBatch);
+
+// The acking server: a second RakClient, this one answered by a ReliabilityLayer standing in
+// for the server's, so it connects and has what it sends acked as against a live server. A pump
+// thread feeds the layer what the client sends, undoing the datagram encryption, and updates it.
+// SocketLayer::SendTo encrypts what the layer sends as well, which a client doesn't expect from
+// a server, so the layer sends to a relay socket the pump reads it back from and passes on in
+// the clear.
+// as long as the clients' update threads sleep
+static constexpr int PUMP_INTERVAL_MS = 5;
+static constexpr int CONNECT_TIMEOUT_MS = 5000;
+
+struct stServer
+{
+	int server;
+	int relay;
+	uint16_t serverPort;
+	uint16_t relayPort;
+	RakClientInterface* client;
+	sockaddr_in clientAddress;
+	PlayerID clientId;
+	PlayerID relayId;
+
+	// the pump thread's alone
+	ReliabilityLayer peer;
+	DataStructures::List<PluginInterface*> handlers;
+	bool accepted = false;
+
+	stServer()
+	{
+		server = CNetBench::BindLoopback(&serverPort);
+		relay = CNetBench::BindLoopback(&relayPort);
+		relayId.binaryAddress = htonl(INADDR_LOOPBACK);
+		relayId.port = relayPort;
+		// as RakPeer readies a remote system's layer
+		peer.SetEncryptionKey(0);
+		peer.Reset(true);
+
+		client = RakNetworkFactory::GetRakClientInterface();
+		if(!client->Connect("127.0.0.1", serverPort, 0, 0, 5)) {
+			CNetBench::Fail("the acked client didn't start");
+		}
+		// the open request is answered here, as stLoopback does; the layer takes over from the
+		// connection request
+		uint8_t data[2048];
+		pollfd fd = { server, POLLIN, 0 };
+		socklen_t addressLength = sizeof(clientAddress);
+		if(poll(&fd, 1, DATAGRAM_TIMEOUT_MS) <= 0
+			|| recvfrom(server, data, sizeof(data), 0, (sockaddr*)&clientAddress, &addressLength) != OPEN_REQUEST_LENGTH) {
+			CNetBench::Fail("no open connection request to the acking server");
+		}
+		clientId.binaryAddress = clientAddress.sin_addr.s_addr;
+		clientId.port = ntohs(clientAddress.sin_port);
+		const uint8_t reply[2] = { ID_OPEN_CONNECTION_REPLY, 0 };
+		sendto(server, reply, sizeof(reply), 0, (sockaddr*)&clientAddress, sizeof(clientAddress));
+
+		std::thread(&stServer::Pump, this).detach();
+		RakNetTime startedAt = RakNet::GetTime();
+		bool connected = false;
+		while(!connected) {
+			if(RakNet::GetTime() - startedAt >= CONNECT_TIMEOUT_MS) {
+				CNetBench::Fail("the acked client never connected");
+			}
+			while(Packet* packet = client->Receive()) {
+				if(packet->data[0] == ID_CONNECTION_REQUEST_ACCEPTED) {
+					connected = true;
+				}
+				client->DeallocatePacket(packet);
+			}
+			RakSleep(PUMP_INTERVAL_MS);
+		}
+	}
+
+	void Pump()
+	{
+		uint8_t data[MAXIMUM_MTU_SIZE + 1];
+		uint8_t plain[MAXIMUM_MTU_SIZE];
+		pollfd fds[2] = { { server, POLLIN, 0 }, { relay, POLLIN, 0 } };
+		for(;;) {
+			poll(fds, 2, PUMP_INTERVAL_MS);
+			int length;
+			while((length = (int)recv(server, data, sizeof(data), MSG_DONTWAIT)) > 1) {
+				length = CNetBench::DecryptDatagram(data, length, serverPort, plain);
+				peer.HandleSocketReceiveFromConnectedPlayer((const char*)plain, length, clientId, handlers, MAXIMUM_MTU_SIZE);
+			}
+			unsigned char* message;
+			int bits;
+			while((bits = peer.Receive(&message)) > 0) {
+				if(message[0] == ID_CONNECTION_REQUEST && !accepted) {
+					Accept();
+				}
+				delete [] message;
+			}
+			peer.Update(relay, relayId, MAXIMUM_MTU_SIZE, RakNet::GetTimeNS(), handlers);
+			while((length = (int)recv(relay, data, sizeof(data), MSG_DONTWAIT)) > 1) {
+				length = CNetBench::DecryptDatagram(data, length, relayPort, plain);
+				sendto(server, plain, length, 0, (sockaddr*)&clientAddress, sizeof(clientAddress));
+			}
+		}
+	}
+
+	// what RakPeer::OnConnectionRequest answers, with SA-MP's two extra words
+	void Accept()
+	{
+		RakNet::BitStream bs;
+		bs.Write((unsigned char)ID_CONNECTION_REQUEST_ACCEPTED);
+		bs.Write(clientId.binaryAddress);
+		bs.Write(clientId.port);
+		bs.Write((PlayerIndex)0);
+		bs.Write((unsigned short)0);
+		bs.Write((unsigned short)0);
+		peer.Send((char*)bs.GetData(), bs.GetNumberOfBitsUsed(), SYSTEM_PRIORITY, RELIABLE, 0, true, MAXIMUM_MTU_SIZE, RakNet::GetTimeNS());
+		accepted = true;
+	}
+};
+
+static stServer& GetServer()
+{
+	static stServer server;
+	return server;
+}
+
+// A frame's worth of syncs, FRAME_SENDS unreliable messages that fit one datagram between them,
+// sent the way hook_JNILib_step sends a frame and waited out until the reliability layer has
+// sent them all. Batched, the frame leaves in one datagram; fails when a run needs more than one
+// per frame. Unbatched is the same frame with the update thread free to pick the sends up as they
+// come. Datagrams are counted from the statistics, less those carrying only acks. RakNet's
+// starting send rate, which acks alone don't raise, paces the frames, so the time per op is
+// mostly that; on a single core the update thread rarely gets in between the sends either.
+static constexpr int FRAME_SENDS = 6;
+static constexpr int FRAME_SEND_SIZE = 64;
+
+static unsigned DatagramsWithData(RakClientInterface* client)
+{
+	RakNetStatisticsStruct* statistics = client->GetStatistics();
+	return statistics ? statistics->packetsSent - statistics->packetsContainingOnlyAcknowlegements : 0;
+}
+
+// returns how many datagrams the frames took
+static unsigned SendFrames(bool batched, uint32_t iterations)
+{
+	stServer& server = GetServer();
+	char message[FRAME_SEND_SIZE];
+	CNetBench::Fill((uint8_t*)message, FRAME_SEND_SIZE, ID_PLAYER_SYNC);
+	message[0] = ID_PLAYER_SYNC;
+	unsigned datagramsBefore = DatagramsWithData(server.client);
+	for(uint32_t i = 0; i < iterations; i++) {
+		RakNetStatisticsStruct* statistics = server.client->GetStatistics();
+		unsigned sentBefore = statistics ? statistics->messagesSentPerId[ID_PLAYER_SYNC] : 0;
+		if(batched) {
+			server.client->BeginSendBatch();
+		}
+		RakNetTime sentAt = RakNet::GetTime();
+		for(int send = 0; send < FRAME_SENDS; send++) {
+			server.client->Send(message, FRAME_SEND_SIZE, MEDIUM_PRIORITY, UNRELIABLE, 0);
+		}
+		if(batched) {
+			server.client->EndSendBatch();
+		}
+		while((statistics = server.client->GetStatistics()) && statistics->messagesSentPerId[ID_PLAYER_SYNC] - sentBefore < FRAME_SENDS) {
+			if(RakNet::GetTime() - sentAt >= DATAGRAM_TIMEOUT_MS) {
+				CNetBench::Fail("a frame's sends never left");
+			}
+			RakSleep(0);
+		}
+	}
+	return DatagramsWithData(server.client) - datagramsBefore;
+}
+
+static void BenchFrameBatched(uint32_t iterations)
+{
+	// the statistics count a datagram just after its messages, so the last one of a run may land
+	// in the next run's count
+	if(SendFrames(true, iterations) > iterations + 1) {
+		CNetBench::Fail("a batched frame left in more than one datagram");
+	}
+}
+NETBENCH_CASE("raknet/frame-batched", BenchFrameBatched);
+
+static void BenchFrameUnbatched(uint32_t iterations)
+{
+	SendFrames(false, iterations);
+}
+NETBENCH_CASE("raknet/frame-unbatched", BenchFrameUnbatched);
+
+// SocketLayer's send batch on its own: a frame's FRAME_SENDS datagrams queued with SendTo and
+// flushed to a loopback socket, which drains them after. Inside a batch SendTo returns 0 before
+// anything is sent, so setup flushes a frame to port 0, which the kernel refuses, and fails unless
+// the flush and GetSocketStatistics both count every datagram of it.
+struct stSendBatch
+{
+	int sender;
+	int receiver;
+	uint16_t receiverPort;
+	uint32_t loopbackAddress;
+	char message[FRAME_SEND_SIZE];
+
+	stSendBatch()
+	{
+		uint16_t senderPort;
+		sender = CNetBench::BindLoopback(&senderPort);
+		receiver = CNetBench::BindLoopback(&receiverPort);
+		loopbackAddress = htonl(INADDR_LOOPBACK);
+		CNetBench::Fill((uint8_t*)message, FRAME_SEND_SIZE, ID_PLAYER_SYNC);
+
+		unsigned failuresBefore = Failures();
+		if(Flush(0) != FRAME_SENDS) {
+			CNetBench::Fail("a flush that failed didn't say so");
+		}
+		if(Failures() - failuresBefore != FRAME_SENDS) {
+			CNetBench::Fail("the statistics missed a batched send that failed");
+		}
+		failuresBefore = Failures();
+		if(Flush(receiverPort) != 0 || Failures() != failuresBefore || Drain() != FRAME_SENDS) {
+			CNetBench::Fail("a batch to a live socket didn't all arrive");
+		}
+	}
+
+	static unsigned Failures()
+	{
+		unsigned receiveBufferBytes, sendBufferBytes, receiveDrops, sendFailures;
+		SocketLayer::GetSocketStatistics(&receiveBufferBytes, &sendBufferBytes, &receiveDrops, &sendFailures);
+		return sendFailures;
+	}
+
+	unsigned Flush(uint16_t port)
+	{
+		SocketLayer* socketLayer = SocketLayer::Instance();
+		socketLayer->BeginSendBatch();
+		for(int send = 0; send < FRAME_SENDS; send++) {
+			if(socketLayer->SendTo(sender, message, FRAME_SEND_SIZE, loopbackAddress, port) != 0) {
+				CNetBench::Fail("SendTo failed inside a batch");
+			}
+		}
+		return socketLayer->FlushSendBatch(sender);
+	}
+
+	int Drain()
+	{
+		uint8_t data[2048];
+		int received = 0;
+		while(recv(receiver, data, sizeof(data), MSG_DONTWAIT) > 0) {
+			received++;
+		}
+		return received;
+	}
+};
+
+static void BenchSendBatch(uint32_t iterations)
+{
+	static stSendBatch batch;
+	for(uint32_t i = 0; i < iterations; i += FRAME_SENDS) {
+		if(batch.Flush(batch.receiverPort) != 0) {
+			CNetBench::Fail("a batched send to a live socket failed");
+		}
+		batch.Drain();
+	}
+}
+NETBENCH_CASE("raknet/send-batch", BenchSendBatch);
@@ -0,0 +1,610 @@
+// The reliability layer and its own structures, measured without RakPeer around them: the
+// resend index acks look messages up in, with the reference it replaced, a layer reassembling
+// what another one split, also across an MTU drop, two layers' resend timeouts over a lossy link,
+// reading the statistics and the payload slabs. A case checks what it reads back, so a wrong
+// answer fails rather than benchmarking well.
+#include "netbench.h"
+
+#include "vendor/RakNet/DS_BPlusTree.h"
+#include "vendor/RakNet/DS_ResendRing.h"
+#include "vendor/RakNet/GetTime.h"
+#include "vendor/RakNet/InternalPacket.h"
+#include "vendor/RakNet/MTUSize.h"
+#include "vendor/RakNet/PacketEnumerations.h"
+#include "vendor/RakNet/PayloadPool.h"
+#include "vendor/RakNet/ReliabilityLayer.h"
+
+#include <arpa/inet.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+// A link with IN_FLIGHT reliable messages unacknowledged, as a join's burst of RPCs leaves it
+// on a slow link: every op acks the oldest and sends the next, so the message numbers wrap
+// through the whole 16-bit range as the run goes. Reported per message. resendList is a
+// ResendRing; the BPlusTree it replaced is the reference, at the order
+// ReliabilityLayer had it.
+static constexpr uint32_t IN_FLIGHT = 2000;
+static constexpr int RESEND_TREE_ORDER = 32;
+// what RemoveAckedRange gets from one ack datagram under steady sending
+static constexpr uint32_t ACK_RANGE = 32;
+
+static InternalPacket g_inFlight[IN_FLIGHT];
+
+static InternalPacket* PacketFor(MessageNumberType messageNumber)
+{
+	return &g_inFlight[messageNumber % IN_FLIGHT];
+}
+
+template <class Index>
+struct stResendWindow
+{
+	Index index;
+	MessageNumberType oldest = 0;
+	MessageNumberType next = 0;
+
+	stResendWindow()
+	{
+		index.Preallocate(RESEND_RING_SIZE);
+		while(next != IN_FLIGHT) {
+			Send();
+		}
+	}
+
+	void Send()
+	{
+		if(!index.Insert(next, PacketFor(next))) {
+			CNetBench::Fail("a message number in flight twice");
+		}
+		next++;
+	}
+
+	void Ack()
+	{
+		InternalPacket* packet;
+		if(!index.Delete(oldest, packet) || packet != PacketFor(oldest)) {
+			CNetBench::Fail("an ack didn't find the message it acknowledges");
+		}
+		oldest++;
+	}
+};
+
+static void BenchResendRingAck(uint32_t iterations)
+{
+	static stResendWindow<DataStructures::ResendRing<MessageNumberType, InternalPacket*>> window;
+	for(uint32_t i = 0; i < iterations; i++) {
+		window.Ack();
+		window.Send();
+	}
+	CNetBench::Keep(&window);
+}
+NETBENCH_CASE("reliability/resend-ring-ack", BenchResendRingAck);
+
+// one ack datagram's range at a time, through DeleteRange as RemoveAckedRange does; one op is
+// still one message
+static void BenchResendRingAckRange(uint32_t iterations)
+{
+	static stResendWindow<DataStructures::ResendRing<MessageNumberType, InternalPacket*>> window;
+	for(uint32_t i = 0; i < iterations; i += ACK_RANGE) {
+		MessageNumberType minIndex = window.oldest;
+		MessageNumberType maxIndex = (MessageNumberType)(minIndex + ACK_RANGE - 1);
+		MessageNumberType expected = minIndex;
+		unsigned removed = window.index.DeleteRange(minIndex, maxIndex, [&](InternalPacket* packet) {
+			if(packet != PacketFor(expected++)) {
+				CNetBench::Fail("an acked range removed a message out of order");
+			}
+		});
+		if(removed != ACK_RANGE) {
+			CNetBench::Fail("an acked range missed messages in flight");
+		}
+		window.oldest = (MessageNumberType)(maxIndex + 1);
+		for(uint32_t sent = 0; sent < ACK_RANGE; sent++) {
+			window.Send();
+		}
+	}
+	CNetBench::Keep(&window);
+}
+NETBENCH_CASE("reliability/resend-ring-ack-range", BenchResendRingAckRange);
+
+static void BenchResendTreeAck(uint32_t iterations)
+{
+	static stResendWindow<DataStructures::BPlusTree<MessageNumberType, InternalPacket*, RESEND_TREE_ORDER>> window;
+	for(uint32_t i = 0; i < iterations; i++) {
+		window.Ack();
+		window.Send();
+	}
+	CNetBench::Keep(&window);
+}
+NETBENCH_CASE("reliability/resend-tree-ack", BenchResendTreeAck);
+
+// Split reassembly: one SPLIT_MESSAGE_SIZE message, an object batch at join say, as the
+// receiving layer gets it. The sending layer splits it once at setup, acked by a second layer so
+// nothing is resent, and what it put on the wire is kept in the clear. Every op feeds those
+// datagrams to a reset receiver and takes the whole message out; one op is one message. The
+// reversed case has the last fragment first, before the channel knows the fragment size. The
+// mtu-drop case is the same message sent while the MTU is still DEFAULT_MTU_SIZE, its first
+// datagrams refused as too big for the path and the rest sent once RakPeer has lowered the MTU to
+// PATH_MTU_FLOOR; setup fails if what is left of it never fits a datagram again.
+static constexpr uint32_t SPLIT_MESSAGE_SIZE = 16384;
+// far enough apart that the sender's send rate never holds a fragment back
+static constexpr RakNetTimeNS SPLIT_STEP_NS = 1000000000;
+// with datagrams lost no acks come back, and a layer gives the connection up after 10 s without
+// one; 100 ms, RakNetTimeNS counts microseconds
+static constexpr RakNetTimeNS SPLIT_LOSS_STEP_NS = 100000;
+
+struct stSplitMessage
+{
+	uint8_t message[SPLIT_MESSAGE_SIZE];
+	std::vector<std::vector<uint8_t>> datagrams;
+	ReliabilityLayer receiver;
+	DataStructures::List<PluginInterface*> handlers;
+	PlayerID peerId;
+
+	// lostMtu: the MTU of the first update, whose datagrams are dropped; 0 for none
+	stSplitMessage(int mtu, int lostMtu)
+	{
+		CNetBench::Fill(message, SPLIT_MESSAGE_SIZE, SPLIT_MESSAGE_SIZE);
+		message[0] = ID_RPC;
+		uint16_t port;
+		int socket = CNetBench::BindLoopback(&port);
+		peerId.binaryAddress = htonl(INADDR_LOOPBACK);
+		peerId.port = port;
+
+		ReliabilityLayer sender;
+		RakNetTimeNS time = RakNet::GetTimeNS();
+		sender.Send((char*)message, BYTES_TO_BITS(SPLIT_MESSAGE_SIZE), HIGH_PRIORITY, RELIABLE_ORDERED, 0, true, lostMtu ? lostMtu : mtu, time);
+		// both layers send to the one socket; each one's datagrams are read right after its Update
+		uint8_t data[MAXIMUM_MTU_SIZE + 1];
+		uint8_t plain[MAXIMUM_MTU_SIZE];
+		bool delivered = false;
+		for(int step = 0; !delivered; step++) {
+			if(step == 1000) {
+				CNetBench::Fail("the split message never arrived");
+			}
+			time += lostMtu ? SPLIT_LOSS_STEP_NS : SPLIT_STEP_NS;
+			bool lost = lostMtu && step == 0;
+			sender.Update(socket, peerId, lost ? lostMtu : mtu, time, handlers);
+			int length;
+			while((length = (int)recv(socket, data, sizeof(data), MSG_DONTWAIT)) > 1) {
+				if(lost) {
+					continue;
+				}
+				if(length > mtu - UDP_HEADER_SIZE + 1) {
+					CNetBench::Fail("a datagram was bigger than the MTU");
+				}
+				length = CNetBench::DecryptDatagram(data, length, port, plain);
+				datagrams.emplace_back(plain, plain + length);
+				receiver.HandleSocketReceiveFromConnectedPlayer((const char*)plain, length, peerId, handlers, MAXIMUM_MTU_SIZE);
+			}
+			receiver.Update(socket, peerId, MAXIMUM_MTU_SIZE, time, handlers);
+			while((length = (int)recv(socket, data, sizeof(data), MSG_DONTWAIT)) > 1) {
+				length = CNetBench::DecryptDatagram(data, length, port, plain);
+				sender.HandleSocketReceiveFromConnectedPlayer((const char*)plain, length, peerId, handlers, MAXIMUM_MTU_SIZE);
+			}
+			unsigned char* received;
+			int bits = receiver.Receive(&received);
+			if(bits > 0) {
+				if(bits != (int)BYTES_TO_BITS(SPLIT_MESSAGE_SIZE) || memcmp(received, message, SPLIT_MESSAGE_SIZE)) {
+					CNetBench::Fail("the split message arrived changed");
+				}
+				delete [] received;
+				delivered = true;
+			}
+		}
+		if(!lostMtu && sender.GetStatistics()->messageResends) {
+			CNetBench::Fail("the split message's fragments were resent");
+		}
+		close(socket);
+	}
+
+	void Reassemble(bool reversed)
+	{
+		receiver.Reset(true);
+		for(size_t i = 0; i < datagrams.size(); i++) {
+			const std::vector<uint8_t>& datagram = datagrams[reversed ? datagrams.size() - 1 - i : i];
+			receiver.HandleSocketReceiveFromConnectedPlayer((const char*)datagram.data(), (int)datagram.size(), peerId, handlers, MAXIMUM_MTU_SIZE);
+		}
+		unsigned char* received;
+		if(receiver.Receive(&received) != (int)BYTES_TO_BITS(SPLIT_MESSAGE_SIZE)) {
+			CNetBench::Fail("a split message didn't reassemble");
+		}
+		CNetBench::Keep(received);
+		delete [] received;
+	}
+};
+
+static stSplitMessage& GetSplitMessage()
+{
+	static stSplitMessage splitMessage(MAXIMUM_MTU_SIZE, 0);
+	return splitMessage;
+}
+
+static void BenchSplitReassembly(uint32_t iterations)
+{
+	stSplitMessage& splitMessage = GetSplitMessage();
+	for(uint32_t i = 0; i < iterations; i++) {
+		splitMessage.Reassemble(false);
+	}
+}
+NETBENCH_CASE("reliability/split-reassembly", BenchSplitReassembly);
+
+static void BenchSplitReassemblyReversed(uint32_t iterations)
+{
+	stSplitMessage& splitMessage = GetSplitMessage();
+	for(uint32_t i = 0; i < iterations; i++) {
+		splitMessage.Reassemble(true);
+	}
+}
+NETBENCH_CASE("reliability/split-reassembly-reversed", BenchSplitReassemblyReversed);
+
+static void BenchSplitReassemblyMtuDrop(uint32_t iterations)
+{
+	static stSplitMessage splitMessage(PATH_MTU_FLOOR, DEFAULT_MTU_SIZE);
+	for(uint32_t i = 0; i < iterations; i++) {
+		splitMessage.Reassemble(false);
+	}
+}
+NETBENCH_CASE("reliability/split-reassembly-mtu-drop", BenchSplitReassemblyMtuDrop);
+
+// Resend timeouts on a mobile link: a sending and a receiving layer joined by a link that loses
+// LINK_LOSS_PER_MILLE of the datagrams each way and delays the rest by LINK_DELAY_MS, give or take
+// LINK_JITTER_MS, except for the first LINK_HANDOFF_MS of every LINK_HANDOFF_PERIOD_MS, a handoff,
+// when the delay is LINK_HANDOFF_DELAY_MS. The layers take acks at the cycle time, so the link
+// runs on the real clock and ns/op is only the period; what the case is for is its checks. One op
+// is one period, a reliable sync message sent every SYNC_INTERVAL_MS. A copy that reaches the
+// receiver twice was resent while the first was still on its way, or its ack was lost; the case
+// fails when there are more such copies than lost acks and handoffs explain, or when the smoothed
+// round trip leaves the link's range.
+static constexpr uint32_t LINK_LOSS_PER_MILLE = 20;
+static constexpr uint32_t LINK_DELAY_MS = 20;
+static constexpr uint32_t LINK_JITTER_MS = 5;
+static constexpr uint32_t LINK_HANDOFF_DELAY_MS = 60;
+static constexpr uint32_t LINK_HANDOFF_MS = 100;
+static constexpr uint32_t LINK_HANDOFF_PERIOD_MS = 500;
+static constexpr uint32_t SYNC_INTERVAL_MS = 33;
+static constexpr uint32_t SYNC_SIZE = 32;
+// how often the layers are updated and the link delivers, as RakPeer's update thread would
+static constexpr uint32_t LINK_STEP_MS = 1;
+static constexpr uint32_t LINK_WARMUP_MS = 1000;
+
+struct stDelayedDatagram
+{
+	RakNetTimeNS deliverAt;
+	bool toSender;
+	std::vector<uint8_t> data;
+};
+
+struct stLossyLink
+{
+	ReliabilityLayer sender;
+	ReliabilityLayer receiver;
+	DataStructures::List<PluginInterface*> handlers;
+	PlayerID peerId;
+	int socket;
+	uint16_t port;
+	std::vector<stDelayedDatagram> inFlight;
+	uint32_t random = 1;
+	uint32_t sent = 0;
+	uint32_t received = 0;
+
+	stLossyLink()
+	{
+		socket = CNetBench::BindLoopback(&port);
+		peerId.binaryAddress = htonl(INADDR_LOOPBACK);
+		peerId.port = port;
+		// a new layer sends nothing until its send rate has a full datagram's worth
+		Run(LINK_WARMUP_MS);
+	}
+
+	void Run(uint32_t ms)
+	{
+		RakNetTimeNS end = RakNet::GetTimeNS() + (RakNetTimeNS)ms * 1000;
+		while(RakNet::GetTimeNS() < end) {
+			poll(nullptr, 0, LINK_STEP_MS);
+			Step();
+		}
+	}
+
+	uint32_t Next(uint32_t range)
+	{
+		random = random * 1664525u + 1013904223u;
+		return (random >> 8) % range;
+	}
+
+	// reads what the layer that just updated sent, and puts it on the link
+	void Capture(RakNetTimeNS time, bool toSender)
+	{
+		uint8_t data[MAXIMUM_MTU_SIZE + 1];
+		uint8_t plain[MAXIMUM_MTU_SIZE];
+		int length;
+		while((length = (int)recv(socket, data, sizeof(data), MSG_DONTWAIT)) > 1) {
+			if(Next(1000) < LINK_LOSS_PER_MILLE) {
+				continue;
+			}
+			uint32_t delayMs = (time / 1000) % LINK_HANDOFF_PERIOD_MS < LINK_HANDOFF_MS ? LINK_HANDOFF_DELAY_MS : LINK_DELAY_MS;
+			RakNetTimeNS delay = (RakNetTimeNS)delayMs * 1000 - LINK_JITTER_MS * 1000 + Next(2 * LINK_JITTER_MS * 1000);
+			length = CNetBench::DecryptDatagram(data, length, port, plain);
+			inFlight.push_back({ time + delay, toSender, std::vector<uint8_t>(plain, plain + length) });
+		}
+	}
+
+	void Step()
+	{
+		RakNetTimeNS time = RakNet::UpdateCycleTimeNS();
+		for(size_t i = 0; i < inFlight.size();) {
+			if(inFlight[i].deliverAt > time) {
+				i++;
+				continue;
+			}
+			ReliabilityLayer& layer = inFlight[i].toSender ? sender : receiver;
+			layer.HandleSocketReceiveFromConnectedPlayer((const char*)inFlight[i].data.data(), (int)inFlight[i].data.size(), peerId, handlers, DEFAULT_MTU_SIZE);
+			inFlight[i] = std::move(inFlight.back());
+			inFlight.pop_back();
+		}
+		sender.Update(socket, peerId, DEFAULT_MTU_SIZE, time, handlers);
+		Capture(time, false);
+		receiver.Update(socket, peerId, DEFAULT_MTU_SIZE, time, handlers);
+		Capture(time, true);
+		unsigned char* message;
+		while(receiver.Receive(&message) > 0) {
+			received++;
+			delete [] message;
+		}
+	}
+
+	void Sync()
+	{
+		uint8_t message[SYNC_SIZE];
+		CNetBench::Fill(message, SYNC_SIZE, sent);
+		message[0] = ID_RPC;
+		RakNetTimeNS time = RakNet::UpdateCycleTimeNS();
+		sender.Send((char*)message, BYTES_TO_BITS(SYNC_SIZE), HIGH_PRIORITY, RELIABLE_ORDERED, 0, true, DEFAULT_MTU_SIZE, time);
+		sent++;
+		Run(SYNC_INTERVAL_MS);
+	}
+};
+
+static void BenchResendTimeoutLossyLink(uint32_t iterations)
+{
+	static stLossyLink link;
+	uint32_t received = link.received;
+	for(uint32_t i = 0; i < iterations * (LINK_HANDOFF_PERIOD_MS / SYNC_INTERVAL_MS); i++) {
+		link.Sync();
+	}
+	if(link.received == received) {
+		CNetBench::Fail("nothing got through the lossy link");
+	}
+	// a lost ack costs a copy, and so does every sync sent in the first round trip of a handoff
+	uint32_t handoffs = link.sent * SYNC_INTERVAL_MS / LINK_HANDOFF_PERIOD_MS + 1;
+	uint32_t expected = link.sent * LINK_LOSS_PER_MILLE / 1000 + handoffs * (2 * LINK_HANDOFF_DELAY_MS / SYNC_INTERVAL_MS + 1);
+	if(link.receiver.GetStatistics()->duplicateMessagesReceived > expected) {
+		CNetBench::Fail("the resend timeout resends messages that weren't lost");
+	}
+	double roundTrip = link.sender.GetStatistics()->smoothedRoundTripTime;
+	if(roundTrip < 2 * (LINK_DELAY_MS - LINK_JITTER_MS) || roundTrip > 2 * (LINK_HANDOFF_DELAY_MS + LINK_JITTER_MS)) {
+		CNetBench::Fail("the smoothed round trip is outside the link's");
+	}
+}
+NETBENCH_CASE("reliability/resend-timeout-lossy-link", BenchResendTimeoutLossyLink);
+
+// A sending and a receiving layer on the real clock with nothing between them, for cases that
+// need acks and don't care about the link. Both draw payloads from pool when there is one, as
+// RakPeer's layers do.
+struct stLayerPair
+{
+	ReliabilityLayer sender;
+	ReliabilityLayer receiver;
+	DataStructures::List<PluginInterface*> handlers;
+	PlayerID peerId;
+	int socket;
+	uint16_t port;
+	PayloadPool* pool;
+	uint32_t received = 0;
+
+	stLayerPair(PayloadPool* pool) : pool(pool)
+	{
+		socket = CNetBench::BindLoopback(&port);
+		peerId.binaryAddress = htonl(INADDR_LOOPBACK);
+		peerId.port = port;
+		if(pool) {
+			sender.SetPayloadPool(pool);
+			receiver.SetPayloadPool(pool);
+		}
+	}
+
+	~stLayerPair()
+	{
+		close(socket);
+	}
+
+	void Send(const uint8_t* message, uint32_t size, unsigned char channel)
+	{
+		sender.Send((char*)message, BYTES_TO_BITS(size), HIGH_PRIORITY, RELIABLE_ORDERED, channel, true, DEFAULT_MTU_SIZE, RakNet::UpdateCycleTimeNS());
+	}
+
+	// updates both layers until received reaches expected and every message is acked
+	void Settle(uint32_t expected)
+	{
+		uint8_t data[MAXIMUM_MTU_SIZE + 1];
+		uint8_t plain[MAXIMUM_MTU_SIZE];
+		RakNetTimeNS end = RakNet::GetTimeNS() + 5000000;
+		while(received < expected || sender.GetStatistics()->messagesOnResendQueue) {
+			if(RakNet::GetTimeNS() > end) {
+				CNetBench::Fail("a layer pair never settled");
+			}
+			poll(nullptr, 0, 1);
+			RakNetTimeNS time = RakNet::UpdateCycleTimeNS();
+			sender.Update(socket, peerId, DEFAULT_MTU_SIZE, time, handlers);
+			int length;
+			while((length = (int)recv(socket, data, sizeof(data), MSG_DONTWAIT)) > 1) {
+				length = CNetBench::DecryptDatagram(data, length, port, plain);
+				receiver.HandleSocketReceiveFromConnectedPlayer((const char*)plain, length, peerId, handlers, DEFAULT_MTU_SIZE);
+			}
+			receiver.Update(socket, peerId, DEFAULT_MTU_SIZE, time, handlers);
+			while((length = (int)recv(socket, data, sizeof(data), MSG_DONTWAIT)) > 1) {
+				length = CNetBench::DecryptDatagram(data, length, port, plain);
+				sender.HandleSocketReceiveFromConnectedPlayer((const char*)plain, length, peerId, handlers, DEFAULT_MTU_SIZE);
+			}
+			unsigned char* message;
+			while(receiver.Receive(&message) > 0) {
+				received++;
+				if(pool) {
+					pool->Release(message);
+				} else {
+					delete [] message;
+				}
+			}
+		}
+	}
+};
+
+// The statistics breakdown: STATISTICS_MESSAGES messages over STATISTICS_IDS message ids and as
+// many ordering channels go from a sending layer to a receiving one and back as acks, and the
+// per id, per channel and ack latency counts have to add up to what was sent. The cases are what
+// reading them costs: GetStatistics, which CSyncRate calls every frame, and the sum RakPeer makes
+// for UNASSIGNED_PLAYER_ID.
+static constexpr uint32_t STATISTICS_MESSAGES = 64;
+static constexpr uint32_t STATISTICS_IDS = 4;
+static constexpr uint32_t STATISTICS_MESSAGE_SIZE = 24;
+
+struct stStatisticsLink
+{
+	stLayerPair layers;
+
+	stStatisticsLink() : layers(nullptr)
+	{
+		for(uint32_t i = 0; i < STATISTICS_MESSAGES; i++) {
+			uint8_t message[STATISTICS_MESSAGE_SIZE];
+			CNetBench::Fill(message, STATISTICS_MESSAGE_SIZE, i);
+			message[0] = (uint8_t)(ID_RPC + i % STATISTICS_IDS);
+			layers.Send(message, STATISTICS_MESSAGE_SIZE, (unsigned char)(i % STATISTICS_IDS));
+		}
+		layers.Settle(STATISTICS_MESSAGES);
+
+		const RakNetStatisticsStruct* sent = layers.sender.GetStatistics();
+		const RakNetStatisticsStruct* got = layers.receiver.GetStatistics();
+		uint32_t perId = STATISTICS_MESSAGES / STATISTICS_IDS;
+		for(uint32_t id = 0; id < STATISTICS_IDS; id++) {
+			if(sent->messagesSentPerId[ID_RPC + id] != perId || sent->messageDataBitsSentPerId[ID_RPC + id] != perId * BYTES_TO_BITS(STATISTICS_MESSAGE_SIZE)
+				|| got->messagesReceivedPerId[ID_RPC + id] != perId || got->messageDataBitsReceivedPerId[ID_RPC + id] != perId * BYTES_TO_BITS(STATISTICS_MESSAGE_SIZE)) {
+				CNetBench::Fail("the per id statistics don't add up to what was sent");
+			}
+			if(sent->messagesSentPerChannel[id] != perId || sent->messageDataBitsSentPerChannel[id] != perId * BYTES_TO_BITS(STATISTICS_MESSAGE_SIZE)) {
+				CNetBench::Fail("the per channel statistics don't add up to what was sent");
+			}
+		}
+		uint32_t acked = 0;
+		for(int bucket = 0; bucket < STATISTICS_LATENCY_BUCKETS; bucket++) {
+			acked += sent->ackLatencyHistogram[bucket];
+		}
+		if(acked + sent->messageResends < STATISTICS_MESSAGES) {
+			CNetBench::Fail("the ack latency histogram is missing acks");
+		}
+	}
+};
+
+static stStatisticsLink& GetStatisticsLink()
+{
+	static stStatisticsLink statisticsLink;
+	return statisticsLink;
+}
+
+static void BenchStatisticsRead(uint32_t iterations)
+{
+	stStatisticsLink& statisticsLink = GetStatisticsLink();
+	for(uint32_t i = 0; i < iterations; i++) {
+		CNetBench::Keep(statisticsLink.layers.sender.GetStatistics());
+	}
+}
+NETBENCH_CASE("reliability/statistics-read", BenchStatisticsRead);
+
+static void BenchStatisticsSum(uint32_t iterations)
+{
+	stStatisticsLink& statisticsLink = GetStatisticsLink();
+	static RakNetStatisticsStruct sum;
+	memcpy(&sum, statisticsLink.layers.sender.GetStatistics(), sizeof(sum));
+	for(uint32_t i = 0; i < iterations; i++) {
+		sum += *statisticsLink.layers.receiver.GetStatistics();
+		CNetBench::Keep(&sum);
+	}
+}
+NETBENCH_CASE("reliability/statistics-sum", BenchStatisticsSum);
+
+// Payload slabs: a tick's worth of message payloads, the sizes sync and the common RPCs have,
+// allocated and released from a PayloadPool, and the same from new [] and delete [] as the
+// reference. One op is one payload. Setup runs PAYLOAD_ROUNDS ticks of those messages through a
+// layer pair drawing from a pool and fails if any payload came from the heap once the first
+// round had warmed it up.
+static const uint32_t g_tickPayloadSizes[] = { 68, 63, 31, 68, 12, 40, 68, 26, 63, 100, 68, 18, 300, 68, 31, 44 };
+static constexpr uint32_t TICK_PAYLOADS = sizeof(g_tickPayloadSizes) / sizeof(g_tickPayloadSizes[0]);
+static constexpr uint32_t PAYLOAD_ROUNDS = 8;
+
+struct stPayloadSlabs
+{
+	PayloadPool pool;
+
+	stPayloadSlabs()
+	{
+		stLayerPair layers(&pool);
+		uint8_t message[MAXIMUM_MTU_SIZE];
+		unsigned pooled[PayloadPool::NUMBER_OF_SIZE_CLASSES];
+		unsigned warmHeap = 0;
+		for(uint32_t round = 0; round < PAYLOAD_ROUNDS; round++) {
+			for(uint32_t i = 0; i < TICK_PAYLOADS; i++) {
+				CNetBench::Fill(message, g_tickPayloadSizes[i], i);
+				message[0] = ID_RPC;
+				layers.Send(message, g_tickPayloadSizes[i], 0);
+			}
+			layers.Settle((round + 1) * TICK_PAYLOADS);
+			if(round == 0) {
+				pool.GetStatistics(pooled, &warmHeap);
+			}
+		}
+		unsigned heap;
+		pool.GetStatistics(pooled, &heap);
+		if(heap != warmHeap) {
+			CNetBench::Fail("steady sync traffic allocated payloads from the heap");
+		}
+	}
+};
+
+static PayloadPool& GetPayloadPool()
+{
+	static stPayloadSlabs payloadSlabs;
+	return payloadSlabs.pool;
+}
+
+static void BenchPayloadPool(uint32_t iterations)
+{
+	PayloadPool& pool = GetPayloadPool();
+	unsigned char* payloads[TICK_PAYLOADS];
+	for(uint32_t i = 0; i < iterations; i += TICK_PAYLOADS) {
+		for(uint32_t j = 0; j < TICK_PAYLOADS; j++) {
+			payloads[j] = pool.Allocate(g_tickPayloadSizes[j]);
+			payloads[j][0] = ID_RPC;
+		}
+		CNetBench::Keep(payloads);
+		for(uint32_t j = 0; j < TICK_PAYLOADS; j++) {
+			pool.Release(payloads[j]);
+		}
+	}
+}
+NETBENCH_CASE("reliability/payload-pool", BenchPayloadPool);
+
+static void BenchPayloadHeap(uint32_t iterations)
+{
+	unsigned char* payloads[TICK_PAYLOADS];
+	for(uint32_t i = 0; i < iterations; i += TICK_PAYLOADS) {
+		for(uint32_t j = 0; j < TICK_PAYLOADS; j++) {
+			payloads[j] = new unsigned char[g_tickPayloadSizes[j]];
+			payloads[j][0] = ID_RPC;
+		}
+		CNetBench::Keep(payloads);
+		for(uint32_t j = 0; j < TICK_PAYLOADS; j++) {
+			delete [] payloads[j];
+		}
+	}
+}
+NETBENCH_CASE("reliability/payload-heap", BenchPayloadHeap);
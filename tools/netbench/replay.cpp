@@ -0,0 +1,250 @@
+// Replays a CNetCapture log through the plugin: inbound syncs through the decoders (with
+// the rotations batched per drain, as FlushPendingSync does), inbound RPCs through
+// FixBrokenRPC, outbound packets through the translator table and outbound RPCs through
+// the id map. Reports where the time went, per direction and id.
+//
+// --from and --to (seconds into the capture) seek through the segment index, and --only
+// keeps one direction and kind, or a single id of it, so one slice of an hour-long session
+// replays without the rest being read.
+#include "netbench.h"
+
+#include "plugin/common.h"
+#include "plugin/netcapture.h"
+#include "plugin/syncdecode.h"
+#include "plugin/translator.h"
+#include "vendor/RakNet/PacketEnumerations.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+static constexpr uint32_t QUAT_BATCH = 1024;
+
+struct stReplayStat
+{
+	uint8_t type;
+	uint32_t id;
+	uint64_t count;
+	uint64_t bytes;
+	uint64_t ns;
+};
+
+static uint64_t NowNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+struct stQuatBatch
+{
+	uint16_t x[QUAT_BATCH], y[QUAT_BATCH], z[QUAT_BATCH];
+	uint8_t signs[QUAT_BATCH];
+	float outW[QUAT_BATCH], outX[QUAT_BATCH], outY[QUAT_BATCH], outZ[QUAT_BATCH];
+	uint32_t count = 0;
+
+	void Add(const stPackedNormQuat& quat)
+	{
+		x[count] = quat.x;
+		y[count] = quat.y;
+		z[count] = quat.z;
+		signs[count] = quat.signs;
+		count++;
+	}
+
+	void Flush()
+	{
+		if(count) {
+			DecodeNormQuats(x, y, z, signs, count, outW, outX, outY, outZ);
+			CNetBench::Keep(outW);
+			count = 0;
+		}
+	}
+};
+
+// returns false for what the replay doesn't model, so it shows up as skipped
+static bool ReplayRecord(const CNetCaptureReader::stRecord& record, uint8_t* scratch, stQuatBatch& quats)
+{
+	uint32_t size = BITS_TO_BYTES(record.bits);
+	bool outbound = (record.type & CAPTURE_OUT) != 0;
+	bool rpc = (record.type & ~CAPTURE_OUT) == CAPTURE_RPC;
+
+	if(!outbound && !rpc)
+	{
+		uint16_t playerId;
+		stPackedNormQuat quat;
+		if(record.id == ID_PLAYER_SYNC) {
+			BROnFootSyncData out;
+			if(DecodeBROnFootSync(record.data, size, &playerId, &out, &quat)) {
+				quats.Add(quat);
+			}
+		} else if(record.id == ID_VEHICLE_SYNC) {
+			BRInCarSyncData out;
+			if(DecodeBRInCarSync(record.data, size, &playerId, &out, &quat)) {
+				quats.Add(quat);
+			}
+		} else if(record.id == ID_PASSENGER_SYNC) {
+			uint8_t out[BR_PASSENGER_SYNC_SIZE];
+			DecodeBRPassengerSync(record.data, size, &playerId, out);
+			CNetBench::Keep(out);
+		} else {
+			return false;
+		}
+		if(quats.count == QUAT_BATCH) {
+			quats.Flush();
+		}
+		return true;
+	}
+
+	// a receive drain is over once something else happens
+	quats.Flush();
+
+	if(!outbound && rpc)
+	{
+		// this one answers with an RPC of its own, and there is no client to send it
+		if((int)record.id == RPC_ScrSetSpawnInfo) {
+			return false;
+		}
+		// the fixups may write to the payload, the reader's copy has to stay intact
+		memcpy(scratch, record.data, size);
+		CNetBench::DispatchRPC((int)record.id, scratch, record.bits);
+		return true;
+	}
+	if(outbound && !rpc)
+	{
+		const stPacketTranslator* translator = size ? CPacketTranslator::Find(record.data[0]) : nullptr;
+		if(!translator) {
+			return false;
+		}
+		uint32_t outLen = CPacketTranslator::Translate(translator, record.data, size, CPacketTranslator::GetScratch());
+		CNetBench::Keep(&outLen);
+		return true;
+	}
+	int sampId = ConvertBRIDToSampID((BRRpcIds)record.id);
+	CNetBench::Keep(&sampId);
+	return true;
+}
+
+static const char* TypeName(uint8_t type)
+{
+	switch(type) {
+		case CAPTURE_PACKET: return "in packet";
+		case CAPTURE_RPC: return "in rpc";
+		case CAPTURE_PACKET | CAPTURE_OUT: return "out packet";
+		case CAPTURE_RPC | CAPTURE_OUT: return "out rpc";
+	}
+	return "?";
+}
+
+// "in-rpc" or "out-packet:207"
+static bool ParseOnly(const char* text, CNetCaptureReader* reader)
+{
+	static const char* const names[] = { "in-packet", "in-rpc", "out-packet", "out-rpc" };
+	static const uint8_t types[] = { CAPTURE_PACKET, CAPTURE_RPC, CAPTURE_PACKET | CAPTURE_OUT, CAPTURE_RPC | CAPTURE_OUT };
+	const char* colon = strchr(text, ':');
+	size_t nameLen = colon ? (size_t)(colon - text) : strlen(text);
+	for(int i = 0; i < 4; i++) {
+		if(strlen(names[i]) != nameLen || strncmp(text, names[i], nameLen)) {
+			continue;
+		}
+		if(colon) {
+			reader->Want(types[i], (uint32_t)strtoul(colon + 1, nullptr, 0));
+		} else {
+			reader->WantAll(types[i]);
+		}
+		return true;
+	}
+	return false;
+}
+
+int CNetBench::Replay(int argc, char** argv)
+{
+	const char* path = argv[0];
+	CNetCaptureReader reader;
+	if(!reader.Open(path)) {
+		fprintf(stderr, "%s: not a capture file\n", path);
+		return 1;
+	}
+
+	bool realtime = false;
+	uint64_t fromUs = 0, toUs = UINT64_MAX;
+	for(int i = 1; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if(!strcmp(argv[i], "--realtime")) {
+			realtime = true;
+		} else if(!strcmp(argv[i], "--from") && hasValue) {
+			fromUs = (uint64_t)(atof(argv[++i]) * 1e6);
+		} else if(!strcmp(argv[i], "--to") && hasValue) {
+			toUs = (uint64_t)(atof(argv[++i]) * 1e6);
+		} else if(!(!strcmp(argv[i], "--only") && hasValue && ParseOnly(argv[++i], &reader))) {
+			fprintf(stderr, "unknown replay option %s\n", argv[i]);
+			return 1;
+		}
+	}
+	printf("%s: %.1f s in %zu segments\n", path, reader.GetDurationUs() / 1e6, reader.GetSegmentCount());
+	reader.Seek(fromUs);
+
+	std::vector<stReplayStat> stats;
+	std::vector<uint8_t> scratch;
+	static stQuatBatch quats;
+	uint64_t records = 0, skipped = 0, busyNs = 0;
+	uint64_t start = NowNs();
+
+	CNetCaptureReader::stRecord record;
+	while(reader.Next(&record) && record.timeUs <= toUs)
+	{
+		if(realtime) {
+			uint64_t due = start + (record.timeUs - fromUs) * 1000;
+			uint64_t now = NowNs();
+			if(due > now) {
+				usleep((useconds_t)((due - now) / 1000));
+			}
+		}
+		if(scratch.size() < BITS_TO_BYTES(record.bits)) {
+			scratch.resize(BITS_TO_BYTES(record.bits));
+		}
+
+		uint64_t before = NowNs();
+		bool replayed = ReplayRecord(record, scratch.data(), quats);
+		uint64_t ns = NowNs() - before;
+		records++;
+		if(!replayed) {
+			skipped++;
+			continue;
+		}
+		busyNs += ns;
+
+		auto it = std::find_if(stats.begin(), stats.end(), [&](const stReplayStat& stat) {
+			return stat.type == record.type && stat.id == record.id;
+		});
+		if(it == stats.end()) {
+			stats.push_back({ record.type, record.id, 0, 0, 0 });
+			it = stats.end() - 1;
+		}
+		it->count++;
+		it->bytes += BITS_TO_BYTES(record.bits);
+		it->ns += ns;
+	}
+	quats.Flush();
+
+	std::sort(stats.begin(), stats.end(), [](const stReplayStat& a, const stReplayStat& b) { return a.ns > b.ns; });
+	printf("%-12s %6s %10s %12s %12s %10s\n", "direction", "id", "count", "bytes", "total us", "ns/op");
+	char name[64];
+	for(const stReplayStat& stat : stats) {
+		printf("%-12s %6u %10llu %12llu %12.1f %10.1f\n", TypeName(stat.type), stat.id,
+			(unsigned long long)stat.count, (unsigned long long)stat.bytes, stat.ns / 1000.0, (double)stat.ns / stat.count);
+		snprintf(name, sizeof(name), "replay/%s:%u", TypeName(stat.type), stat.id);
+		Report(name, (double)stat.ns / stat.count);
+	}
+	// the drain as a whole, per record it modelled
+	if(records > skipped) {
+		Report("replay/all", (double)busyNs / (records - skipped));
+	}
+	printf("%llu records (%llu not modelled), %.3f ms in plugin code, %.3f ms wall\n",
+		(unsigned long long)records, (unsigned long long)skipped, busyNs / 1e6, (NowNs() - start) / 1e6);
+	return 0;
+}
@@ -0,0 +1,209 @@
+// RPC side: id mapping in both directions, the FixBrokenRPC rewrites RakPeer runs ahead
+// of the game's handlers, native dialogs parsing a dialog box and the dialog answer built by
+// hook_RakClient__Send.
+#include "netbench.h"
+
+#include "featureflags.h"
+#include "gui/dialog.h"
+#include "plugin/chatbuffer.h"
+#include "plugin/common.h"
+#include "plugin/lz4.h"
+#include "plugin/textdrawbuffer.h"
+#include "plugin/uisync.h"
+#include "vendor/RakNet/BitStream.h"
+#include "vendor/RakNet/RakClientInterface.h"
+#include "vendor/RakNet/RakNetworkFactory.h"
+#include "vendor/RakNet/StringCompressor.h"
+
+#include <stdio.h>
+
+
+static void BenchRPCIdToSamp(uint32_t iterations)
+{
+	for(uint32_t i = 0; i < iterations; i++) {
+		int id = ConvertBRIDToSampID((BRRpcIds)(BR_RPC_ClientJoin + (i & 127)));
+		CNetBench::Keep(&id);
+	}
+}
+NETBENCH_CASE("rpc/id-br-to-samp", BenchRPCIdToSamp);
+
+static void BenchRPCIdToBR(uint32_t iterations)
+{
+	for(uint32_t i = 0; i < iterations; i++) {
+		int id = ConvertSampIDToBRID((int)(i & 255));
+		CNetBench::Keep(&id);
+	}
+}
+NETBENCH_CASE("rpc/id-samp-to-br", BenchRPCIdToBR);
+
+template<int* RPC_ID, uint32_t SIZE>
+static void BenchFixup(uint32_t iterations)
+{
+	static unsigned char payloads[16][SIZE];
+	static bool filled = false;
+	if(!filled) {
+		for(uint32_t i = 0; i < 16; i++) {
+			CNetBench::Fill(payloads[i], SIZE, *RPC_ID + i);
+			// the first two bytes are an entity id, keep them in range
+			payloads[i][1] &= 0x03;
+		}
+		filled = true;
+	}
+	for(uint32_t i = 0; i < iterations; i++) {
+		CNetBench::DispatchRPC(*RPC_ID, payloads[i & 15], BYTES_TO_BITS(SIZE));
+	}
+}
+
+NETBENCH_CASE("rpc/worldplayeradd", (BenchFixup<&RPC_WorldPlayerAdd, 28>));
+NETBENCH_CASE("rpc/worldvehicleadd", (BenchFixup<&RPC_WorldVehicleAdd, 28>));
+NETBENCH_CASE("rpc/serverquit", (BenchFixup<&RPC_ServerQuit, 3>));
+NETBENCH_CASE("rpc/passthrough", (BenchFixup<&RPC_ScrSetPlayerPos, 64>));
+
+// buffered, then shown FLUSH_LIMIT at a time; a counter in the text keeps them distinct
+static void BenchClientMessage(uint32_t iterations)
+{
+	unsigned char payload[72];
+	CNetBench::Fill(payload, sizeof(payload), RPC_ClientMessage);
+	for(uint32_t i = 0; i < iterations; i++) {
+		memcpy(payload + 8, &i, sizeof(i));
+		CNetBench::DispatchRPC(RPC_ClientMessage, payload, BYTES_TO_BITS(sizeof(payload)));
+		if((i & (CChatBuffer::FLUSH_LIMIT - 1)) == CChatBuffer::FLUSH_LIMIT - 1) {
+			CChatBuffer::Flush();
+		}
+	}
+	CChatBuffer::Clear();
+}
+NETBENCH_CASE("rpc/clientmessage", BenchClientMessage);
+
+// a HUD redrawing 32 textdraws, four edits each per frame, half of them unchanged
+static void BenchTextDrawEdit(uint32_t iterations)
+{
+	unsigned char payload[40];
+	CNetBench::Fill(payload, sizeof(payload), RPC_ScrEditTextDraw);
+	for(uint32_t i = 0; i < iterations; i++) {
+		uint16_t id = (uint16_t)(i & 31);
+		memcpy(payload, &id, sizeof(id));
+		uint32_t text = (i >> 6) & 1;
+		memcpy(payload + 4, &text, sizeof(text));
+		CNetBench::DispatchRPC(RPC_ScrEditTextDraw, payload, BYTES_TO_BITS(sizeof(payload)));
+		if((i & 127) == 127) {
+			CTextDrawBuffer::Flush();
+		}
+	}
+	CTextDrawBuffer::Flush();
+}
+NETBENCH_CASE("rpc/textdraw-edit", BenchTextDrawEdit);
+
+// a tablist dialog of 128 rows, about what a shop or house list sends
+static uint32_t FillDialogRows(char* text, uint32_t capacity)
+{
+	uint32_t size = 0;
+	for(uint32_t row = 0; row < 128 && size < capacity; row++) {
+		size += snprintf(text + size, capacity - size, "{FFFFFF}House %u\t{33AA33}$%u\t%s\n",
+			row, 25000 + row * 750, (row & 3) ? "For sale" : "Owned");
+	}
+	return size < capacity ? size : capacity;
+}
+
+static void BenchLZ4Compress(uint32_t iterations)
+{
+	static char text[8192];
+	static uint8_t packed[lz4::Bound(sizeof(text))];
+	uint32_t size = FillDialogRows(text, sizeof(text));
+	for(uint32_t i = 0; i < iterations; i++) {
+		uint32_t packedSize = lz4::Compress((const uint8_t*)text, size, packed, sizeof(packed));
+		CNetBench::Keep(&packedSize);
+	}
+}
+NETBENCH_CASE("rpc/lz4-compress", BenchLZ4Compress);
+
+static void BenchLZ4Decompress(uint32_t iterations)
+{
+	static char text[8192];
+	static uint8_t packed[lz4::Bound(sizeof(text))];
+	static uint8_t unpacked[sizeof(text)];
+	uint32_t size = FillDialogRows(text, sizeof(text));
+	uint32_t packedSize = lz4::Compress((const uint8_t*)text, size, packed, sizeof(packed));
+	for(uint32_t i = 0; i < iterations; i++) {
+		uint32_t unpackedSize = lz4::Decompress(packed, packedSize, unpacked, sizeof(unpacked));
+		CNetBench::Keep(&unpackedSize);
+	}
+}
+NETBENCH_CASE("rpc/lz4-decompress", BenchLZ4Decompress);
+
+// RPC_ScrDialogBox as the server sends it, the info Huffman coded by stringCompressor, parsed by
+// CNativeDialog::OnDialogBox with native dialogs on. stringCompressor only exists while a RakPeer
+// holds a reference, so setup keeps a client around the way the plugin does; with no reference
+// the decode would crash. Setup fails unless the dialog parses and a copy cut short in the info
+// doesn't.
+static constexpr int DIALOG_MAX_INFO = 4096;
+
+struct stDialogBoxPacket
+{
+	RakClientInterface* client;
+	RakNet::BitStream bs;
+	uint32_t bits;
+
+	stDialogBoxPacket()
+	{
+		client = RakNetworkFactory::GetRakClientInterface();
+		CFeatures::Set(FEATURE_NATIVE_DIALOGS, true);
+
+		static char info[DIALOG_MAX_INFO];
+		FillDialogRows(info, sizeof(info) - 1);
+		static const char title[] = "Houses";
+		static const char button1[] = "Buy";
+		static const char button2[] = "Close";
+		bs.Write((int16_t)42);
+		bs.Write((uint8_t)CNativeDialog::STYLE_TABLIST);
+		for(const char* text : { title, button1, button2 }) {
+			bs.Write((uint8_t)strlen(text));
+			bs.Write(text, (int)strlen(text));
+		}
+		stringCompressor->EncodeString(info, DIALOG_MAX_INFO, &bs);
+		bits = bs.GetNumberOfBitsUsed();
+
+		if(!CNativeDialog::OnDialogBox(bs.GetData(), BITS_TO_BYTES(bits))) {
+			CNetBench::Fail("a dialog box didn't parse");
+		}
+		if(CNativeDialog::OnDialogBox(bs.GetData(), BITS_TO_BYTES(bits) / 2)) {
+			CNetBench::Fail("a dialog box cut short parsed");
+		}
+		CFeatures::Set(FEATURE_NATIVE_DIALOGS, false);
+	}
+};
+
+static void BenchDialogBox(uint32_t iterations)
+{
+	static stDialogBoxPacket packet;
+	CFeatures::Set(FEATURE_NATIVE_DIALOGS, true);
+	for(uint32_t i = 0; i < iterations; i++) {
+		CNetBench::Keep(&packet);
+		if(!CNativeDialog::OnDialogBox(packet.bs.GetData(), BITS_TO_BYTES(packet.bits))) {
+			CNetBench::Fail("a dialog box didn't parse");
+		}
+	}
+	CFeatures::Set(FEATURE_NATIVE_DIALOGS, false);
+}
+NETBENCH_CASE("rpc/dialogbox", BenchDialogBox);
+
+static void BenchDialogResponse(uint32_t iterations)
+{
+	static const char json[] = "{\"r\": 1, \"l\": 3, \"i\": \"\xcf\xf0\xe8\xe2\xe5\xf2, \\\"world\\\"\"}";
+	for(uint32_t i = 0; i < iterations; i++) {
+		stDialogResponse response;
+		if(!ParseDialogResponse(json, sizeof(json) - 1, &response)) {
+			continue;
+		}
+		stDialogResponseHeader header;
+		header.dialogId = 42;
+		header.button = response.button;
+		header.listItem = response.listItem;
+		header.inputLen = response.inputLen;
+		RakNet::InlineBitStream<DialogResponseSchema::BYTES + 255> bsSend;
+		DialogResponseSchema::Write(&bsSend, header);
+		bsSend.Write(response.input, response.inputLen);
+		CNetBench::Keep(bsSend.GetData());
+	}
+}
+NETBENCH_CASE("send/dialog-response", BenchDialogResponse);
@@ -0,0 +1,76 @@
+// Stand-ins for what the game provides at runtime: bindings, pools and the RakNet client.
+// They do no work, so the cases only time the plugin side.
+#include "netbench.h"
+
+#include "bindings.h"
+#include "game/chat.h"
+#include "plugin/audiocache.h"
+#include "plugin/common.h"
+#include "plugin/netgame.h"
+#include "plugin/netstats.h"
+#include "plugin/syncjitter.h"
+#include "plugin/translator.h"
+#include "plugin/pools/playergrid.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+stGameBindings g_Game;
+RakClientInterface* pRakClient = nullptr;
+uint16_t CNetGame::m_nLastSAMPDialogID;
+
+CPlayerPool* CNetGame::GetPlayerPool() { return nullptr; }
+void CNetGame::ForgetSync(uint16_t) {}
+void CNetStats::Record(eNetStatKind, uint8_t, uint32_t, uint64_t) {}
+CRemotePlayer* CPlayerPool::GetAt(uint16_t) { return nullptr; }
+void CPlayerPool::MarkActive(uint16_t) {}
+void CPlayerPool::MarkInactive(uint16_t) {}
+void CPlayerGrid::Remove(uint16_t) {}
+void CSyncJitter::Reset(uint16_t) {}
+void CChat::AddDebugMessage(const char*, ...) {}
+bool CAudioCache::IsEnabled() { return false; }
+void CAudioCache::OnPlayAudioStream(RPCParameters*) {}
+
+static void StubVehiclePoolNew(uintptr_t, void*) {}
+
+static void StubRPCHandler(RPCParameters* rpcParams)
+{
+	CNetBench::Keep(rpcParams->input);
+}
+
+void CNetBench::DispatchRPC(int rpcId, unsigned char* payload, uint32_t bits)
+{
+	RPCParameters rpcParams;
+	memset(&rpcParams, 0, sizeof(rpcParams));
+	rpcParams.input = payload;
+	rpcParams.numberOfBitsOfData = bits;
+	if(IsRPCNeedFix(rpcId)) {
+		FixBrokenRPC(rpcId, &rpcParams, StubRPCHandler);
+	} else {
+		StubRPCHandler(&rpcParams);
+	}
+}
+
+static struct stStubGame
+{
+	stStubGame()
+	{
+		// a vehicle in every slot, for OnVehicleSyncSend to poke its lights into. The
+		// bench packets carry random 16-bit vehicle ids, so every id needs one
+		static uintptr_t vehiclePool;
+		const uint32_t slots = 0x10000;
+		uintptr_t* pool = (uintptr_t*)calloc(slots, sizeof(uintptr_t));
+		uint8_t* vehicle = (uint8_t*)calloc(1, 0x200);
+		if(pool && vehicle) {
+			for(uint32_t i = 0; i < slots; i++) {
+				pool[i] = (uintptr_t)vehicle;
+			}
+			vehiclePool = (uintptr_t)pool;
+		}
+		g_Game.m_pVehiclePool = &vehiclePool;
+		g_Game.CNetVehiclePool__New = StubVehiclePoolNew;
+
+		CPacketTranslator::Initialise();
+		InitialiseRPCFixups(nullptr);
+	}
+} g_stubGame;
@@ -0,0 +1,446 @@
+// Sync packets both ways: BR packets leaving through hook_RakClient__Send's translator
+// table, and SA-MP packets decoded for CNetGame::Packet_*Sync.
+#include "netbench.h"
+
+#include "plugin/common.h"
+#include "plugin/deltasync.h"
+#include "plugin/synccodec.h"
+#include "plugin/syncdecode.h"
+#include "plugin/translator.h"
+#include "plugin/pools/playerpool.h"
+#include "plugin/pools/playerstate.h"
+#include "vendor/RakNet/BitStream.h"
+#include "vendor/RakNet/PacketEnumerations.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static constexpr uint32_t PACKETS = 64;
+static constexpr uint32_t PACKET_SIZE = 128;
+
+// A rotating set of packets, so the branch predictors can't learn one input by heart
+struct stPacketSet
+{
+	uint8_t data[PACKETS][PACKET_SIZE];
+
+	stPacketSet(uint8_t id, uint32_t seed)
+	{
+		for(uint32_t i = 0; i < PACKETS; i++) {
+			CNetBench::Fill(data[i], PACKET_SIZE, seed + i);
+			data[i][0] = id;
+		}
+	}
+};
+
+template<uint8_t BR_ID, uint32_t SIZE>
+static void BenchTranslate(uint32_t iterations)
+{
+	static stPacketSet packets(BR_ID, BR_ID);
+	uint8_t* scratch = CPacketTranslator::GetScratch();
+	for(uint32_t i = 0; i < iterations; i++) {
+		uint8_t* packet = packets.data[i % PACKETS];
+		// the in-place path rewrote it last time round
+		packet[0] = BR_ID;
+		// as hook_RakClient__Send does it, minus the RakNet send
+		const stPacketTranslator* translator = CPacketTranslator::Find(packet[0]);
+		uint8_t* out = packet;
+		uint32_t outLen = CPacketTranslator::TranslateInPlace(translator, packet, 1 + SIZE);
+		if(!outLen) {
+			out = scratch;
+			outLen = CPacketTranslator::Translate(translator, packet, 1 + SIZE, out);
+		}
+		CNetBench::Keep(&outLen);
+		CNetBench::Keep(out);
+	}
+}
+
+NETBENCH_CASE("send/onfoot", (BenchTranslate<BR_ID_PLAYER_SYNC, CPacketTranslator::BR_ONFOOT_SIZE>));
+NETBENCH_CASE("send/incar", (BenchTranslate<BR_ID_VEHICLE_SYNC, CPacketTranslator::BR_INCAR_SIZE>));
+NETBENCH_CASE("send/passenger", (BenchTranslate<BR_ID_PASSENGER_SYNC, CPacketTranslator::BR_PASSENGER_SIZE>));
+NETBENCH_CASE("send/aim", (BenchTranslate<BR_ID_AIM_SYNC, CPacketTranslator::AIM_SIZE>));
+NETBENCH_CASE("send/bullet", (BenchTranslate<BR_ID_BULLET_SYNC, CPacketTranslator::BULLET_SIZE>));
+
+// An idle player: the same on-foot packet every time, dropped after the comparison
+static void BenchOnFootIdle(uint32_t iterations)
+{
+	static const stPacketSet packets(BR_ID_PLAYER_SYNC, BR_ID_PLAYER_SYNC);
+	const stPacketTranslator* translator = CPacketTranslator::Find(BR_ID_PLAYER_SYNC);
+	uint8_t* out = CPacketTranslator::GetScratch();
+	CPacketTranslator::SetKeepalive(BR_ID_PLAYER_SYNC, 1000000);
+	for(uint32_t i = 0; i < iterations; i++) {
+		uint32_t outLen = CPacketTranslator::Translate(translator, packets.data[0], 1 + CPacketTranslator::BR_ONFOOT_SIZE, out);
+		bool repeat = CPacketTranslator::IsRepeat(BR_ID_PLAYER_SYNC, out, outLen);
+		CNetBench::Keep(&repeat);
+	}
+	CPacketTranslator::SetKeepalive(BR_ID_PLAYER_SYNC, 0);
+}
+NETBENCH_CASE("send/onfoot-idle", BenchOnFootIdle);
+
+// A walking player: the translated on-foot payload with only position, rotation and speed
+// moving from one sync to the next, coded against the sync before it
+static void BenchOnFootDelta(uint32_t iterations)
+{
+	static uint8_t payloads[PACKETS][68];
+	static uint8_t delta[CDeltaSync::MaxDelta(68)];
+	for(uint32_t i = 0; i < PACKETS; i++) {
+		CNetBench::Fill(payloads[i], sizeof(payloads[i]), 1);
+		// pos96 quat128 at 6, move96 at 38
+		CNetBench::Fill(payloads[i] + 6, 28, 100 + i);
+		CNetBench::Fill(payloads[i] + 38, 12, 200 + i);
+	}
+	for(uint32_t i = 0; i < iterations; i++) {
+		uint32_t size = CDeltaSync::WriteDelta(payloads[i % PACKETS], 68, payloads[(i - 1) % PACKETS], 68, delta);
+		CNetBench::Keep(&size);
+	}
+}
+NETBENCH_CASE("send/onfoot-delta", BenchOnFootDelta);
+
+// Random bits decode fine for the most part; bail out loudly if an input stops doing so,
+// the numbers would be for the early-out instead
+static void ExpectDecoded(bool decoded, const char* what)
+{
+	if(!decoded) {
+		fprintf(stderr, "%s: benchmark input no longer decodes\n", what);
+		exit(1);
+	}
+}
+
+static void BenchDecodeOnFoot(uint32_t iterations)
+{
+	static const stPacketSet packets(ID_PLAYER_SYNC, 1);
+	uint16_t playerId;
+	BROnFootSyncData out;
+	stPackedNormQuat quat;
+	for(uint32_t i = 0; i < iterations; i++) {
+		bool decoded = DecodeBROnFootSync(packets.data[i % PACKETS], PACKET_SIZE, &playerId, &out, &quat);
+		if(i < PACKETS) {
+			ExpectDecoded(decoded, "recv/onfoot");
+		}
+		CNetBench::Keep(&out);
+		CNetBench::Keep(&quat);
+	}
+}
+NETBENCH_CASE("recv/onfoot", BenchDecodeOnFoot);
+
+static void BenchDecodeInCar(uint32_t iterations)
+{
+	static const stPacketSet packets(ID_VEHICLE_SYNC, 2);
+	uint16_t playerId;
+	BRInCarSyncData out;
+	stPackedNormQuat quat;
+	for(uint32_t i = 0; i < iterations; i++) {
+		bool decoded = DecodeBRInCarSync(packets.data[i % PACKETS], PACKET_SIZE, &playerId, &out, &quat);
+		if(i < PACKETS) {
+			ExpectDecoded(decoded, "recv/incar");
+		}
+		CNetBench::Keep(&out);
+		CNetBench::Keep(&quat);
+	}
+}
+NETBENCH_CASE("recv/incar", BenchDecodeInCar);
+
+// what a far player's sync costs when CSyncInterest skips it
+static void BenchPeekOnFoot(uint32_t iterations)
+{
+	static const stPacketSet packets(ID_PLAYER_SYNC, 1);
+	uint16_t playerId;
+	CVector pos;
+	for(uint32_t i = 0; i < iterations; i++) {
+		bool decoded = PeekBROnFootPosition(packets.data[i % PACKETS], PACKET_SIZE, &playerId, &pos);
+		if(i < PACKETS) {
+			ExpectDecoded(decoded, "recv/onfoot-position");
+		}
+		CNetBench::Keep(&pos);
+	}
+}
+NETBENCH_CASE("recv/onfoot-position", BenchPeekOnFoot);
+
+static void BenchPeekInCar(uint32_t iterations)
+{
+	static const stPacketSet packets(ID_VEHICLE_SYNC, 2);
+	uint16_t playerId;
+	CVector pos;
+	for(uint32_t i = 0; i < iterations; i++) {
+		bool decoded = PeekBRInCarPosition(packets.data[i % PACKETS], PACKET_SIZE, &playerId, &pos);
+		if(i < PACKETS) {
+			ExpectDecoded(decoded, "recv/incar-position");
+		}
+		CNetBench::Keep(&pos);
+	}
+}
+NETBENCH_CASE("recv/incar-position", BenchPeekInCar);
+
+static void BenchDecodePassenger(uint32_t iterations)
+{
+	static const stPacketSet packets(ID_PASSENGER_SYNC, 3);
+	uint16_t playerId;
+	uint8_t out[BR_PASSENGER_SYNC_SIZE];
+	for(uint32_t i = 0; i < iterations; i++) {
+		bool decoded = DecodeBRPassengerSync(packets.data[i % PACKETS], PACKET_SIZE, &playerId, out);
+		if(i < PACKETS) {
+			ExpectDecoded(decoded, "recv/passenger");
+		}
+		CNetBench::Keep(out);
+	}
+}
+NETBENCH_CASE("recv/passenger", BenchDecodePassenger);
+
+// One FlushPendingSync worth of rotations; reported per quaternion
+static void BenchDecodeQuats(uint32_t iterations)
+{
+	static constexpr uint32_t BATCH = 256;
+	static uint16_t qx[BATCH], qy[BATCH], qz[BATCH];
+	static uint8_t signs[BATCH];
+	static bool filled = false;
+	if(!filled) {
+		CNetBench::Fill((uint8_t*)qx, sizeof(qx), 4);
+		CNetBench::Fill((uint8_t*)qy, sizeof(qy), 5);
+		CNetBench::Fill((uint8_t*)qz, sizeof(qz), 6);
+		CNetBench::Fill(signs, sizeof(signs), 7);
+		filled = true;
+	}
+	float w[BATCH], x[BATCH], y[BATCH], z[BATCH];
+	uint32_t done = 0;
+	while(done < iterations) {
+		uint32_t count = iterations - done < BATCH ? iterations - done : BATCH;
+		DecodeNormQuats(qx, qy, qz, signs, count, w, x, y, z);
+		CNetBench::Keep(w);
+		done += count;
+	}
+}
+NETBENCH_CASE("recv/normquat", BenchDecodeQuats);
+
+// Every packed health/armour byte unpacked and packed again, as a relay would; reported per
+// byte. Each one has to come back as it was, or the two tables have drifted apart.
+static void BenchHealthArmour(uint32_t iterations)
+{
+	static uint8_t packed[256];
+	static bool filled = false;
+	if(!filled) {
+		for(uint32_t i = 0; i < 256; i++) {
+			packed[i] = (uint8_t)i;
+			stHealthArmour unpacked = UnpackHealthArmour(packed[i]);
+			ExpectDecoded(PackHealthArmour(unpacked.health, unpacked.armour) == packed[i], "codec/health-armour");
+		}
+		filled = true;
+	}
+	for(uint32_t i = 0; i < iterations; i++) {
+		stHealthArmour unpacked = UnpackHealthArmour(packed[i & 0xFF]);
+		packed[i & 0xFF] = PackHealthArmour(unpacked.health, unpacked.armour);
+		CNetBench::Keep(&packed[i & 0xFF]);
+	}
+}
+NETBENCH_CASE("codec/health-armour", BenchHealthArmour);
+
+// a full server's scoreboard, reported per player
+static void BenchDecodeScoresPings(uint32_t iterations)
+{
+	static constexpr uint32_t PLAYERS = 1000;
+	static uint8_t payload[PLAYERS * SCORES_PINGS_RECORD_SIZE];
+	static int scores[MAX_PLAYERS];
+	static uint32_t pings[MAX_PLAYERS];
+	static bool filled = false;
+	if(!filled) {
+		CNetBench::Fill(payload, sizeof(payload), 8);
+		for(uint16_t i = 0; i < PLAYERS; i++) {
+			memcpy(payload + i * SCORES_PINGS_RECORD_SIZE, &i, sizeof(i));
+		}
+		filled = true;
+	}
+	int localScore;
+	uint32_t localPing;
+	stScoresPingsTarget target = { scores, pings, MAX_PLAYERS, 0, &localScore, &localPing };
+	for(uint32_t done = 0; done < iterations; done += PLAYERS) {
+		bool decoded = DecodeScoresPings(payload, sizeof(payload), target);
+		if(!done) {
+			ExpectDecoded(decoded, "recv/scorespings");
+		}
+		CNetBench::Keep(scores);
+	}
+}
+NETBENCH_CASE("recv/scorespings", BenchDecodeScoresPings);
+
+// a full pool spread over a 2 km square, queried 150 m around the middle; reported per player
+static void BenchPlayerStateQuery(uint32_t iterations)
+{
+	static bool filled = false;
+	if(!filled) {
+		for(uint16_t i = 0; i < MAX_PLAYERS; i++) {
+			CVector pos((float)(i * 37 % 2000) - 1000.f, (float)(i * 101 % 2000) - 1000.f, 10.f);
+			CPlayerState::Update(i, pos, 100, 0, CPlayerState::NO_VEHICLE, 1000);
+		}
+		filled = true;
+	}
+	uint16_t out[MAX_PLAYERS];
+	for(uint32_t done = 0; done < iterations; done += MAX_PLAYERS) {
+		int count = CPlayerState::Query(CVector(0.f, 0.f, 0.f), 150.f, 2000, 5000, out, MAX_PLAYERS);
+		CNetBench::Keep(&count);
+	}
+}
+NETBENCH_CASE("recv/player-state-query", BenchPlayerStateQuery);
+
+// A full server's tick of on-foot syncs: 1000 players, reported per tick, so 30 ticks are a
+// second of a 30 Hz server. recv/onfoot-tick is what Packet_PlayerSync and FlushPendingSync do
+// now, the rotations batched through DecodeNormQuats; recv/onfoot-tick-bitstream is the
+// BitStream reader DecodeBROnFootSync replaced, kept here as the reference. The packets are
+// written with BitStream, a third of the players with a stick held and some surfing, and the
+// two decoders have to agree on every one of them.
+static constexpr uint32_t TICK_PLAYERS = 1000;
+
+// Packet_PlayerSync before DecodeBROnFootSync, minus the pool lookup
+static bool DecodeOnFootBitStream(const uint8_t* data, uint32_t length, uint16_t* playerId, BROnFootSyncData* out)
+{
+	RakNet::BitStream bsData((unsigned char*)data, length, false);
+	uint8_t pktId;
+	uint32_t timestamp;
+	if(data[0] == ID_TIMESTAMP) {
+		bsData.ReadBits((unsigned char*)&pktId, 8);
+		bsData.ReadBits((unsigned char*)&timestamp, 32);
+	}
+	bsData.ReadBits((unsigned char*)&pktId, 8);
+	bsData.ReadBits((unsigned char*)playerId, 16);
+
+	memset(out, 0, sizeof(*out));
+	bool lr, ud, surfing;
+	uint8_t healthArmour;
+	float mx, my, mz;
+	if(!bsData.Read(lr) || (lr && !bsData.ReadBits((unsigned char*)&out->lrAnalogLeftStick, 16))
+		|| !bsData.Read(ud) || (ud && !bsData.ReadBits((unsigned char*)&out->udAnalogLeftStick, 16))
+		|| !bsData.ReadBits((unsigned char*)&out->wKeys, 16)
+		|| !bsData.Read((char*)&out->vecPos, 12)
+		|| !bsData.ReadNormQuat<float>(out->quatw, out->quatx, out->quaty, out->quatz)
+		|| !bsData.ReadBits(&healthArmour, 8)
+		|| !bsData.ReadBits(&out->byteCurrentWeapon, 8)
+		|| !bsData.ReadBits(&out->byteSpecialAction, 8)
+		|| !bsData.ReadVector<float>(mx, my, mz)
+		|| !bsData.Read(surfing)) {
+		return false;
+	}
+	if(surfing) {
+		bsData.ReadBits((unsigned char*)&out->wSurfInfo, 16);
+		bsData.ReadBits((unsigned char*)&out->vecSurfOffsets.x, 32);
+		bsData.ReadBits((unsigned char*)&out->vecSurfOffsets.y, 32);
+		bsData.ReadBits((unsigned char*)&out->vecSurfOffsets.z, 32);
+	}
+
+	// the branches the nibble table replaced
+	uint8_t healthNibble = healthArmour >> 4, armourNibble = healthArmour & 0x0F;
+	out->health = healthNibble == 0xF ? 100 : (healthNibble == 0 ? 0 : healthNibble * 7);
+	out->armour = armourNibble == 0xF ? 100 : (armourNibble == 0 ? 0 : armourNibble * 7);
+	return true;
+}
+
+struct stOnFootTick
+{
+	std::vector<uint8_t> packets[TICK_PLAYERS];
+
+	stOnFootTick()
+	{
+		for(uint16_t i = 0; i < TICK_PLAYERS; i++)
+		{
+			uint8_t random[64];
+			CNetBench::Fill(random, sizeof(random), 9 + i);
+			float values[12];
+			for(uint32_t v = 0; v < 12; v++) {
+				values[v] = (float)random[v] - 128.f;
+			}
+			float norm = sqrtf(values[3] * values[3] + values[4] * values[4] + values[5] * values[5] + values[6] * values[6]);
+			if(norm == 0.f) {
+				values[3] = norm = 1.f;
+			}
+
+			RakNet::BitStream bs;
+			bs.Write((uint8_t)ID_PLAYER_SYNC);
+			bs.Write(i);
+			bool lr = i % 3 == 0, ud = i % 5 == 0, surfing = i % 8 == 0;
+			bs.Write(lr);
+			if(lr) bs.Write((int16_t)(random[20] * 64 - 8192));
+			bs.Write(ud);
+			if(ud) bs.Write((int16_t)(random[21] * 64 - 8192));
+			bs.Write((uint16_t)(random[22] | random[23] << 8));
+			bs.Write(values[0] * 10.f);
+			bs.Write(values[1] * 10.f);
+			bs.Write(values[2]);
+			bs.WriteNormQuat(values[3] / norm, values[4] / norm, values[5] / norm, values[6] / norm);
+			bs.Write(random[24]);
+			bs.Write((uint8_t)(random[25] % 47));
+			bs.Write((uint8_t)(random[26] % 4));
+			// a standing player sends no speed at all
+			bool moving = i % 4 != 0;
+			bs.WriteVector(moving ? values[7] / 100.f : 0.f, moving ? values[8] / 100.f : 0.f, moving ? values[9] / 100.f : 0.f);
+			bs.Write(surfing);
+			if(surfing) {
+				bs.Write((uint16_t)(random[27] | random[28] << 8));
+				bs.Write(values[10] / 10.f);
+				bs.Write(values[11] / 10.f);
+				bs.Write(0.5f);
+			}
+			packets[i].assign(bs.GetData(), bs.GetData() + bs.GetNumberOfBytesUsed());
+
+			uint16_t playerId, referenceId;
+			BROnFootSyncData out, reference;
+			stPackedNormQuat quat;
+			ExpectDecoded(DecodeBROnFootSync(packets[i].data(), packets[i].size(), &playerId, &out, &quat), "recv/onfoot-tick");
+			ExpectDecoded(DecodeOnFootBitStream(packets[i].data(), packets[i].size(), &referenceId, &reference), "recv/onfoot-tick-bitstream");
+			DecodeNormQuats(&quat.x, &quat.y, &quat.z, &quat.signs, 1, &out.quatw, &out.quatx, &out.quaty, &out.quatz);
+			bool quatsAgree = fabsf(out.quatw - reference.quatw) < 1e-5f && fabsf(out.quatx - reference.quatx) < 1e-5f
+				&& fabsf(out.quaty - reference.quaty) < 1e-5f && fabsf(out.quatz - reference.quatz) < 1e-5f;
+			out.quatw = out.quatx = out.quaty = out.quatz = 0.f;
+			reference.quatw = reference.quatx = reference.quaty = reference.quatz = 0.f;
+			if(playerId != referenceId || !quatsAgree || memcmp(&out, &reference, sizeof(out))) {
+				fprintf(stderr, "recv/onfoot-tick: player %u decodes differently from the reference\n", i);
+				exit(1);
+			}
+		}
+	}
+};
+
+static stOnFootTick& GetOnFootTick()
+{
+	static stOnFootTick tick;
+	return tick;
+}
+
+static void BenchDecodeOnFootTick(uint32_t iterations)
+{
+	stOnFootTick& tick = GetOnFootTick();
+	static BROnFootSyncData out[TICK_PLAYERS];
+	static uint16_t qx[TICK_PLAYERS], qy[TICK_PLAYERS], qz[TICK_PLAYERS];
+	static uint8_t signs[TICK_PLAYERS];
+	static float w[TICK_PLAYERS], x[TICK_PLAYERS], y[TICK_PLAYERS], z[TICK_PLAYERS];
+	for(uint32_t i = 0; i < iterations; i++) {
+		for(uint32_t player = 0; player < TICK_PLAYERS; player++) {
+			uint16_t playerId;
+			stPackedNormQuat quat;
+			DecodeBROnFootSync(tick.packets[player].data(), tick.packets[player].size(), &playerId, &out[player], &quat);
+			qx[player] = quat.x;
+			qy[player] = quat.y;
+			qz[player] = quat.z;
+			signs[player] = quat.signs;
+		}
+		DecodeNormQuats(qx, qy, qz, signs, TICK_PLAYERS, w, x, y, z);
+		for(uint32_t player = 0; player < TICK_PLAYERS; player++) {
+			const float quat[4] = { w[player], x[player], y[player], z[player] };
+			memcpy(&out[player].quatw, quat, sizeof(quat));
+		}
+		CNetBench::Keep(out);
+	}
+}
+NETBENCH_CASE("recv/onfoot-tick", BenchDecodeOnFootTick);
+
+static void BenchDecodeOnFootTickBitStream(uint32_t iterations)
+{
+	stOnFootTick& tick = GetOnFootTick();
+	static BROnFootSyncData out[TICK_PLAYERS];
+	for(uint32_t i = 0; i < iterations; i++) {
+		for(uint32_t player = 0; player < TICK_PLAYERS; player++) {
+			uint16_t playerId;
+			DecodeOnFootBitStream(tick.packets[player].data(), tick.packets[player].size(), &playerId, &out[player]);
+		}
+		CNetBench::Keep(out);
+	}
+}
+NETBENCH_CASE("recv/onfoot-tick-bitstream", BenchDecodeOnFootTickBitStream);
@@ -0,0 +1,67 @@
+// Prints a CTraceRing file, oldest record first. Pull it with
+//   adb pull /storage/emulated/0/Android/data/<package>/files/trace-prev.bin
+// after a crash (trace.bin is the session running now, or the last one if none has
+// started since).
+//
+// Host build, from the repository root:
+//
+//   g++ -std=c++17 -O2 -Itools/netbench/host -I. tools/tracedump/tracedump.cpp plugin/tracering.cpp -o tracedump
+//   ./tracedump trace-prev.bin
+#include "plugin/tracering.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+	if(argc < 2) {
+		fprintf(stderr, "usage: %s trace.bin\n", argv[0]);
+		return 1;
+	}
+	FILE* file = fopen(argv[1], "rb");
+	if(!file) {
+		fprintf(stderr, "%s: can't open\n", argv[1]);
+		return 1;
+	}
+	// the atomic head is read back as plain bytes, it is a uint64_t in memory
+	stTraceHeader header;
+	if(fread(&header, sizeof(header), 1, file) != 1 || header.magic != stTraceHeader::MAGIC ||
+		header.version != stTraceHeader::VERSION || header.recordSize != sizeof(stTraceRecord) ||
+		!header.capacity || (header.capacity & (header.capacity - 1))) {
+		fprintf(stderr, "%s: not a trace file\n", argv[1]);
+		return 1;
+	}
+	std::vector<stTraceRecord> records(header.capacity);
+	size_t count = fread(records.data(), sizeof(stTraceRecord), header.capacity, file);
+	fclose(file);
+
+	uint64_t head = header.head.load(std::memory_order_relaxed);
+	uint64_t first = head > header.capacity ? head - header.capacity : 0;
+	time_t opened = (time_t)(header.openedRealtimeNs / 1000000000ull);
+	char when[64];
+	strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&opened));
+	printf("opened %s, %llu records written, the last %u kept\n", when, (unsigned long long)head, header.capacity);
+
+	uint64_t lastNs = 0;
+	uint32_t torn = 0;
+	for(uint64_t slot = first; slot < head; slot++)
+	{
+		const stTraceRecord& record = records[slot & (header.capacity - 1)];
+		// a record written past the end of a short read, or one its writer never finished
+		if((slot & (header.capacity - 1)) >= count || record.sequence != (uint32_t)slot + 1) {
+			torn++;
+			continue;
+		}
+		double sinceOpen = (int64_t)(record.timeNs - header.openedMonotonicNs) / 1e9;
+		double sinceLast = lastNs ? (int64_t)(record.timeNs - lastNs) / 1e6 : 0.0;
+		lastNs = record.timeNs;
+		printf("%12.6f %+10.3f ms %6u %-12s %u %u %u\n", sinceOpen, sinceLast, record.tid,
+			CTraceRing::GetName(record.event), record.args[0], record.args[1], record.args[2]);
+	}
+	if(torn) {
+		printf("%u records unfinished or overwritten while being read\n", torn);
+	}
+	return 0;
+}
@@ -0,0 +1,75 @@
+#include "workers.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "scheduler.h"
+#include "threadpolicy.h"
+
+struct stPool
+{
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::deque<std::function<void()>> queue;
+	std::atomic<uint32_t> pending{0};
+};
+
+// never destroyed: the detached threads still wait on it while exit runs destructors
+static stPool& Pool()
+{
+	static stPool* pool = new stPool();
+	return *pool;
+}
+
+static void WorkerLoop()
+{
+	stPool& pool = Pool();
+	uint32_t policy = 0;
+	for(;;)
+	{
+		CThreadPolicy::Refresh(THREAD_ROLE_WORKER, &policy);
+		std::function<void()> work;
+		{
+			std::unique_lock<std::mutex> lock(pool.mutex);
+			pool.wake.wait(lock, [&pool] { return !pool.queue.empty(); });
+			work = std::move(pool.queue.front());
+			pool.queue.pop_front();
+		}
+		work();
+		pool.pending.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+void CWorkers::Submit(std::function<void()> work)
+{
+	stPool& pool = Pool();
+	// the threads live as long as the process, which is never torn down cleanly on Android
+	static std::once_flag started;
+	std::call_once(started, [] {
+		for(int i = 0; i < THREADS; i++) {
+			std::thread(WorkerLoop).detach();
+		}
+	});
+	pool.pending.fetch_add(1, std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(pool.mutex);
+		pool.queue.push_back(std::move(work));
+	}
+	pool.wake.notify_one();
+}
+
+void CWorkers::Submit(std::function<void()> work, std::function<void()> done)
+{
+	Submit([work = std::move(work), done = std::move(done)]() mutable {
+		work();
+		CFrameScheduler::Post(std::move(done));
+	});
+}
+
+uint32_t CWorkers::Pending()
+{
+	return Pool().pending.load(std::memory_order_acquire);
+}
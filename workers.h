@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// A few background threads for work that may block or take a while but has no deadline:
+// file IO, parsing, scanning. Neither the game thread nor RakNet's should wait on those.
+// Tasks run in submission order across the pool, so two of them may overlap; anything
+// that must stay ordered has to be one task or chain itself through done.
+class CWorkers
+{
+public:
+	static constexpr int THREADS = 2;
+
+	// from any thread; the pool starts with the first task
+	static void Submit(std::function<void()> work);
+	// done runs on the game thread through CFrameScheduler once work has returned
+	static void Submit(std::function<void()> work, std::function<void()> done);
+	// submitted but not yet finished
+	static uint32_t Pending();
+};
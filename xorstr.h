@@ -215,6 +215,30 @@ namespace ay
 		bool m_encrypted{ true };
 	};
 
+	// Decrypted once when constructed and left that way, for strings on hot paths. Only the
+	// image is protected: the plain text stays in memory for the life of the process.
+	template <size_type N, key_type KEY, typename CHAR_TYPE = char>
+	class decrypted_data
+	{
+	public:
+		decrypted_data(const obfuscator<N, KEY, CHAR_TYPE>& obfuscator)
+		{
+			for (size_type i = 0; i < N; i++)
+			{
+				m_data[i] = obfuscator.data()[i];
+			}
+			cipher(m_data, N, KEY);
+		}
+
+		operator CHAR_TYPE* ()
+		{
+			return m_data;
+		}
+
+	private:
+		CHAR_TYPE m_data[N];
+	};
+
 	// This function exists purely to extract the number of elements 'N' in the
 	// array 'data'
 	template <size_type N, key_type KEY = AY_OBFUSCATE_DEFAULT_KEY, typename CHAR_TYPE = char>
@@ -244,7 +268,28 @@ namespace ay
 		return obfuscated_data; \
 	}()
 
+// Like AY_OBFUSCATE_KEY, but decrypted on first use into a function level static that is
+// shared by every thread. After that an access is the static's guard check, where the
+// thread_local above costs a TLS lookup and an is-encrypted test each time.
+#define AY_OBFUSCATE_CACHED_KEY(data, key) \
+	[]() -> ay::decrypted_data<sizeof(data)/sizeof(data[0]), key, ay::char_type<decltype(*data)>>& { \
+		static_assert(sizeof(decltype(key)) == sizeof(ay::key_type), "key must be a 64 bit unsigned integer"); \
+		static_assert((key) >= (1ull << 56), "key must span all 8 bytes"); \
+		using char_type = ay::char_type<decltype(*data)>; \
+		constexpr auto n = sizeof(data)/sizeof(data[0]); \
+		constexpr auto obfuscator = ay::make_obfuscator<n, key, char_type>(data); \
+		static auto decrypted_data = ay::decrypted_data<n, key, char_type>(obfuscator); \
+		return decrypted_data; \
+	}()
+
+// xorstr_cached is for strings used per packet or per frame. Build with XORSTR_CACHE_ALL
+// to have every xorstr decrypt once as well.
+#define xorstr_cached(data) AY_OBFUSCATE_CACHED_KEY(data, AY_OBFUSCATE_DEFAULT_KEY)
+#ifdef XORSTR_CACHE_ALL
+#define xorstr(data) xorstr_cached(data)
+#else
 #define xorstr(data) AY_OBFUSCATE(data)
+#endif
 /* -------------------------------- LICENSE ------------------------------------
 
 Public Domain (http://www.unlicense.org)